@@ -0,0 +1,378 @@
+// Microbenchmarks of the CPU-side hot paths of the search, the verifiers and
+// the transpiler, run on the muGraphs saved in benchmark/saved_mugraphs.
+//
+// Usage:
+//   mirage-microbench [--iters N] [--filter SUBSTR] [--output FILE]
+//                     [mugraph.json ...]
+//
+// Each sample of a benchmark is the total time of running it once on every
+// muGraph of a file. The first graph of a file serves as the reference
+// program for pattern checks, range checks and verification. Results are
+// written as JSON with sorted keys, so that outputs of different commits can
+// be diffed directly.
+
+#include "mirage/kernel/customized.h"
+#include "mirage/kernel/graph.h"
+#include "mirage/search/abstract_expr/abstract_expr_eval.h"
+#include "mirage/search/range_propagation/irange.h"
+#include "mirage/search/search_context.h"
+#include "mirage/search/search_metrics.h"
+#include "mirage/search/verification/formal_verifier.h"
+#include "mirage/transpiler/transpile.h"
+#include "mirage/transpiler/transpiler.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace mirage;
+namespace kn = mirage::kernel;
+namespace tb = mirage::threadblock;
+namespace fs = std::filesystem;
+
+using mirage::search::get_elapsed_ns;
+using Clock = std::chrono::steady_clock;
+
+static constexpr int SCHEMA_VERSION = 1;
+
+namespace mirage {
+namespace transpiler {
+
+// Runs the passes of a Transpiler up to the one being measured
+class TranspilerBenchmark {
+public:
+  TranspilerBenchmark(kn::Graph const *g,
+                      TranspilerConfig const &config,
+                      std::vector<std::vector<size_t>> const &input_strides)
+      : transpiler(g, config, input_strides) {
+    transpiler.resolve_distributed_config();
+    transpiler.resolve_dtensor_meta();
+    transpiler.resolve_tb_fusion();
+  }
+
+  int64_t time_resolve_tensor_layout() {
+    auto start = Clock::now();
+    transpiler.resolve_tensor_layout();
+    return get_elapsed_ns(start);
+  }
+
+  // Requires resolve_tensor_layout, and times the memory planning of all
+  // customized operators
+  int64_t time_plan_stensor_memory() {
+    bool hopper_arch = transpiler.config.target_cc == GPU_CC::H100;
+    int64_t ns = 0;
+    for (kn::KNOperator *op : transpiler.g->operators) {
+      if (op->op_type != type::KN_CUSTOMIZED_OP) {
+        continue;
+      }
+      tb::Graph const &bgraph = static_cast<kn::KNCustomizedOp *>(op)->bgraph;
+      TBSched sched = transpiler.get_threadblock_schedule(bgraph);
+      if (hopper_arch) {
+        transpiler.get_threadblock_swizzle_plan_hopper(bgraph, sched);
+      } else {
+        transpiler.get_threadblock_swizzle_plan(bgraph, sched);
+      }
+      auto start = Clock::now();
+      transpiler.get_threadblock_memory_plan(bgraph, sched, hopper_arch);
+      ns += get_elapsed_ns(start);
+    }
+    return ns;
+  }
+
+private:
+  Transpiler transpiler;
+};
+
+} // namespace transpiler
+} // namespace mirage
+
+namespace {
+
+struct MuGraphSet {
+  std::string name;
+  std::vector<std::unique_ptr<kn::Graph>> graphs;
+};
+
+// Each benchmark adds the time of one run over all graphs to ns[name]
+using Benchmark =
+    std::function<void(MuGraphSet const &, std::map<std::string, int64_t> &)>;
+
+std::vector<kn::DTensor> get_output_dtensors(kn::Graph const &g) {
+  std::vector<kn::DTensor> outputs;
+  for (kn::KNOperator *op : g.operators) {
+    if (op->op_type == type::KN_OUTPUT_OP) {
+      outputs.push_back(op->input_tensors[0]);
+    }
+  }
+  return outputs;
+}
+
+std::vector<std::vector<size_t>> get_input_strides(kn::Graph const &g) {
+  std::vector<std::vector<size_t>> input_strides;
+  for (kn::KNOperator *op : g.operators) {
+    if (op->op_type == type::KN_INPUT_OP) {
+      input_strides.push_back(static_cast<kn::KNInputOp *>(op)->input_strides);
+    }
+  }
+  return input_strides;
+}
+
+transpiler::TranspilerConfig get_transpiler_config() {
+  transpiler::TranspilerConfig config;
+  config.target_cc = transpiler::GPU_CC::A100;
+  config.profiling = false;
+  config.num_consumer_wgs = 1;
+  config.num_producer_wgs = 1;
+  config.pipeline_stages = 2;
+  return config;
+}
+
+void bench_abstract_expr_eval(MuGraphSet const &set,
+                              std::map<std::string, int64_t> &ns) {
+  for (auto const &g : set.graphs) {
+    search::PatternMap patterns;
+    auto start = Clock::now();
+    search::abstract_expr_eval(*g, patterns);
+    ns["abstract_expr_eval"] += get_elapsed_ns(start);
+  }
+}
+
+void bench_subpattern_to(MuGraphSet const &set,
+                         std::map<std::string, int64_t> &ns) {
+  search::PatternMap ref_patterns;
+  search::abstract_expr_eval(*set.graphs[0], ref_patterns);
+  std::vector<kn::DTensor> ref_outputs = get_output_dtensors(*set.graphs[0]);
+  for (auto const &g : set.graphs) {
+    search::PatternMap patterns;
+    search::abstract_expr_eval(*g, patterns);
+    std::vector<kn::DTensor> outputs = get_output_dtensors(*g);
+    for (size_t i = 0; i < std::min(outputs.size(), ref_outputs.size()); ++i) {
+      if (!patterns.contains(outputs[i].guid) ||
+          !ref_patterns.contains(ref_outputs[i].guid)) {
+        continue;
+      }
+      auto const &pattern = patterns.at(outputs[i].guid);
+      auto const &ref_pattern = ref_patterns.at(ref_outputs[i].guid);
+      if (!pattern || !ref_pattern) {
+        continue;
+      }
+      auto start = Clock::now();
+      pattern->subpattern_to(*ref_pattern);
+      ns["subpattern_to"] += get_elapsed_ns(start);
+    }
+  }
+}
+
+void bench_check_range(MuGraphSet const &set,
+                       std::map<std::string, int64_t> &ns) {
+  auto init_ranges = search::get_init_ranges(*set.graphs[0]);
+  auto target_ranges = search::get_interact_ranges(init_ranges, *set.graphs[0]);
+  for (auto const &g : set.graphs) {
+    auto start = Clock::now();
+    search::check_range(init_ranges, target_ranges, *g);
+    ns["check_range"] += get_elapsed_ns(start);
+  }
+}
+
+// Round-trips a kernel-level context per graph and a threadblock-level
+// context per customized operator
+void bench_search_context(MuGraphSet const &set,
+                          std::map<std::string, int64_t> &ns) {
+  for (auto const &g : set.graphs) {
+    // The contexts only borrow the graphs
+    std::shared_ptr<kn::Graph> kn_graph(g.get(), [](kn::Graph *) {});
+    std::vector<search::SearchContext> contexts;
+    contexts.push_back({kn_graph, nullptr, search::SearchLevel::LV_KERNEL});
+    for (kn::KNOperator *op : g->operators) {
+      if (op->op_type == type::KN_CUSTOMIZED_OP) {
+        std::shared_ptr<tb::Graph> tb_graph(
+            kn_graph, &static_cast<kn::KNCustomizedOp *>(op)->bgraph);
+        contexts.push_back(
+            {kn_graph, tb_graph, search::SearchLevel::LV_THREADBLOCK});
+      }
+    }
+    for (search::SearchContext const &c : contexts) {
+      auto start = Clock::now();
+      search::SerializedSearchContext(c).deserialize();
+      ns["search_context_roundtrip"] += get_elapsed_ns(start);
+    }
+  }
+}
+
+void bench_formal_verify(MuGraphSet const &set,
+                         std::map<std::string, int64_t> &ns) {
+  search::FormalVerifier verifier(*set.graphs[0]);
+  for (auto const &g : set.graphs) {
+    auto start = Clock::now();
+    verifier.verify(*g);
+    ns["formal_verify"] += get_elapsed_ns(start);
+  }
+}
+
+void bench_transpiler_passes(MuGraphSet const &set,
+                             std::map<std::string, int64_t> &ns) {
+  transpiler::TranspilerConfig config = get_transpiler_config();
+  for (auto const &g : set.graphs) {
+    transpiler::TranspilerBenchmark bench(
+        g.get(), config, get_input_strides(*g));
+    ns["resolve_tensor_layout"] += bench.time_resolve_tensor_layout();
+    ns["plan_stensor_memory"] += bench.time_plan_stensor_memory();
+  }
+}
+
+void bench_transpile(MuGraphSet const &set,
+                     std::map<std::string, int64_t> &ns) {
+  transpiler::TranspilerConfig config = get_transpiler_config();
+  for (auto const &g : set.graphs) {
+    std::vector<std::vector<size_t>> input_strides = get_input_strides(*g);
+    auto start = Clock::now();
+    transpiler::transpile(g.get(), config, input_strides);
+    ns["transpile"] += get_elapsed_ns(start);
+  }
+}
+
+// Benchmark names are the keys each benchmark records under
+std::vector<std::pair<std::vector<std::string>, Benchmark>> get_benchmarks() {
+  return {
+      {{"abstract_expr_eval"}, bench_abstract_expr_eval},
+      {{"subpattern_to"}, bench_subpattern_to},
+      {{"check_range"}, bench_check_range},
+      {{"search_context_roundtrip"}, bench_search_context},
+      {{"formal_verify"}, bench_formal_verify},
+      {{"resolve_tensor_layout", "plan_stensor_memory"},
+       bench_transpiler_passes},
+      {{"transpile"}, bench_transpile},
+  };
+}
+
+json summarize(std::vector<int64_t> samples) {
+  std::sort(samples.begin(), samples.end());
+  int64_t sum = 0;
+  for (int64_t ns : samples) {
+    sum += ns;
+  }
+  return {{"samples", samples.size()},
+          {"min_ns", samples.front()},
+          {"median_ns", samples[samples.size() / 2]},
+          {"max_ns", samples.back()},
+          {"mean_ns", sum / static_cast<int64_t>(samples.size())}};
+}
+
+json run_benchmarks(MuGraphSet const &set,
+                    int num_iterations,
+                    std::string const &filter) {
+  json results = json::object();
+  for (auto const &[names, bench] : get_benchmarks()) {
+    bool selected = false;
+    for (std::string const &name : names) {
+      selected |= name.find(filter) != std::string::npos;
+    }
+    if (!selected) {
+      continue;
+    }
+    std::map<std::string, std::vector<int64_t>> samples;
+    try {
+      // The first run warms up caches and is not recorded
+      for (int i = 0; i <= num_iterations; ++i) {
+        std::map<std::string, int64_t> ns;
+        bench(set, ns);
+        for (std::string const &name : names) {
+          if (i > 0) {
+            samples[name].push_back(ns[name]);
+          }
+        }
+      }
+    } catch (std::exception const &e) {
+      for (std::string const &name : names) {
+        results[name] = {{"error", e.what()}};
+      }
+      continue;
+    }
+    for (std::string const &name : names) {
+      if (name.find(filter) != std::string::npos) {
+        results[name] = summarize(samples[name]);
+      }
+    }
+  }
+  return results;
+}
+
+bool load_mugraphs(fs::path const &path, MuGraphSet &set) {
+  std::ifstream ifs(path);
+  json j;
+  try {
+    ifs >> j;
+  } catch (json::exception const &e) {
+    std::cerr << "Failed to parse " << path << ": " << e.what() << std::endl;
+    return false;
+  }
+  set.name = path.stem().string();
+  for (json const &graph : j) {
+    set.graphs.push_back(std::make_unique<kn::Graph>());
+    from_json(graph, *set.graphs.back());
+  }
+  return !set.graphs.empty();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int num_iterations = 5;
+  std::string filter, output_file;
+  std::vector<fs::path> mugraph_files;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--iters" && i + 1 < argc) {
+      num_iterations = std::max(1, std::stoi(argv[++i]));
+    } else if (arg == "--filter" && i + 1 < argc) {
+      filter = argv[++i];
+    } else if (arg == "--output" && i + 1 < argc) {
+      output_file = argv[++i];
+    } else if (!arg.empty() && arg[0] == '-') {
+      std::cerr << "Usage: " << argv[0]
+                << " [--iters N] [--filter SUBSTR] [--output FILE]"
+                << " [mugraph.json ...]" << std::endl;
+      return 1;
+    } else {
+      mugraph_files.push_back(arg);
+    }
+  }
+  if (mugraph_files.empty()) {
+    for (auto const &entry :
+         fs::directory_iterator(MIRAGE_SAVED_MUGRAPHS_DIR)) {
+      if (entry.path().extension() == ".json") {
+        mugraph_files.push_back(entry.path());
+      }
+    }
+  }
+  std::sort(mugraph_files.begin(), mugraph_files.end());
+
+  json results = json::object();
+  for (fs::path const &path : mugraph_files) {
+    MuGraphSet set;
+    if (!load_mugraphs(path, set)) {
+      continue;
+    }
+    std::cerr << "Benchmarking " << set.name << " (" << set.graphs.size()
+              << " muGraphs)" << std::endl;
+    results[set.name] = {
+        {"num_mugraphs", set.graphs.size()},
+        {"benchmarks", run_benchmarks(set, num_iterations, filter)}};
+  }
+
+  json report = {{"schema_version", SCHEMA_VERSION},
+                 {"iterations", num_iterations},
+                 {"mugraphs", results}};
+  if (output_file.empty()) {
+    std::cout << report.dump(2) << std::endl;
+  } else {
+    std::ofstream(output_file) << report.dump(2) << std::endl;
+  }
+  return 0;
+}
@@ -19,6 +19,7 @@
 #include "mirage/config.h"
 #include "mirage/layout.h"
 #include "mirage/type.h"
+#include "mirage/utils/hash_utils.h"
 #include <cstddef>
 
 namespace mirage {
@@ -78,6 +79,46 @@ struct CTensor {
     }
   }
 
+  // Hash of the fingerprints of all GPUs, equal for tensors with the same
+  // fingerprint
+  size_t fingerprint_digest() const {
+    size_t seed = 0;
+    for (int gpu_id = 0;
+         gpu_id < mirage::config::MAX_NUM_GPUS && fp_ptr[gpu_id] != nullptr;
+         gpu_id++) {
+      for (size_t i = 0; i < num_elements(); i++) {
+        hash_combine(seed, fp_ptr[gpu_id][i]);
+      }
+    }
+    return seed;
+  }
+
+  bool has_same_fingerprint(CTensor const &ref) const {
+    if (data_type != ref.data_type || layout != ref.layout ||
+        num_dims != ref.num_dims) {
+      return false;
+    }
+    for (int i = 0; i < num_dims; i++) {
+      if (dim[i] != ref.dim[i]) {
+        return false;
+      }
+    }
+    for (int gpu_id = 0; gpu_id < mirage::config::MAX_NUM_GPUS; gpu_id++) {
+      if ((fp_ptr[gpu_id] == nullptr) != (ref.fp_ptr[gpu_id] == nullptr)) {
+        return false;
+      }
+      if (fp_ptr[gpu_id] == nullptr) {
+        break;
+      }
+      for (size_t i = 0; i < num_elements(); i++) {
+        if (fp_ptr[gpu_id][i] != ref.fp_ptr[gpu_id][i]) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
   mirage::type::DataType data_type;
   mirage::layout::CmemLayout layout;
   int num_dims;
@@ -0,0 +1,90 @@
+/* Copyright 2023-2024 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "mirage/kernel/customized.h"
+#include "mirage/kernel/graph.h"
+#include "mirage/threadblock/graph.h"
+#include "mirage/type.h"
+#include <cstdint>
+#include <vector>
+
+namespace mirage {
+namespace cpu {
+
+// A dense row-major tensor living in host memory. Values are stored as fp32
+// and rounded to the precision of data_type after every operator, so that
+// fp16/bf16 graphs observe the same rounding points as the CUDA kernels
+struct HostTensor {
+  HostTensor(void);
+  HostTensor(std::vector<int> const &dims, mirage::type::DataType data_type);
+  size_t num_elements() const;
+  void round_to_data_type();
+
+  std::vector<int> dims;
+  mirage::type::DataType data_type;
+  std::vector<float> data;
+};
+
+uint16_t float_to_half(float x);
+float half_to_float(uint16_t x);
+uint16_t float_to_bfloat16(float x);
+float bfloat16_to_float(uint16_t x);
+float round_to_data_type(float x, mirage::type::DataType data_type);
+
+// Convert between HostTensor and densely packed host buffers whose element
+// type is given by data_type (DT_FLOAT32, DT_FLOAT16 or DT_BFLOAT16)
+HostTensor load_host_tensor(void const *ptr,
+                            std::vector<int> const &dims,
+                            mirage::type::DataType data_type);
+void store_host_tensor(HostTensor const &tensor, void *ptr);
+
+// Returns true if |a - b| <= atol + rtol * |b| holds for every element
+bool allclose(HostTensor const &a,
+              HostTensor const &b,
+              float rtol = 1e-2f,
+              float atol = 1e-2f);
+
+// A reference interpreter that executes a muGraph on the host. Kernel-level
+// operators are parallelized across elements; customized operators run one
+// host thread per thread block and follow the same imap/omap/forloop
+// semantics as the generated CUDA kernels
+class Interpreter {
+public:
+  // num_threads <= 0 uses the OpenMP default
+  Interpreter(int num_threads = 0);
+  // Inputs are matched with KN_INPUT_OPs and outputs are returned for
+  // KN_OUTPUT_OPs, both in the order the operators appear in the graph
+  std::vector<HostTensor> run(mirage::kernel::Graph const &graph,
+                              std::vector<HostTensor> const &inputs);
+  void run_customized_op(mirage::kernel::KNCustomizedOp const *op,
+                         std::vector<HostTensor const *> const &inputs,
+                         std::vector<HostTensor *> const &outputs);
+
+public:
+  // Tile size of the cache-blocked matmul kernel
+  static constexpr int MATMUL_TILE = 64;
+
+private:
+  void run_threadblock(mirage::threadblock::Graph const &bgraph,
+                       int3 block_idx,
+                       std::vector<HostTensor const *> const &inputs,
+                       std::vector<HostTensor *> const &outputs);
+  int num_threads;
+};
+
+} // namespace cpu
+} // namespace mirage
@@ -20,6 +20,7 @@
 #include "mirage/kernel/operator.h"
 #include "mirage/kernel/runtime.h"
 #include "mirage/threadblock/graph.h"
+#include "mirage/utils/use_def_index.h"
 #include <vector>
 
 namespace mirage {
@@ -36,6 +37,11 @@ public:
   ~Graph();
   Graph(Graph const &) = delete;
   Graph &operator=(Graph const &) = delete;
+  // Operators must be added and removed through the following two functions
+  // so that use_def stays in sync with operators
+  void add_operator(KNOperator *op);
+  // Removes the last operator and returns it without deleting it
+  KNOperator *remove_last_operator();
   // input operator
   DTensor new_input(std::vector<int> const &dims,
                     std::vector<size_t> const &strides,
@@ -162,7 +168,13 @@ public:
                         int num_groups,
                         char const *name);
   void register_task(char const *task_type, std::vector<int> params);
-  runtime::TaskGraphResult generate_task_graph(int num_gpus, int my_gpu_id);
+  // use_cpu_backend generates code for the host runtime in
+  // cpu_persistent_kernel.h instead of the persistent CUDA kernel
+  // verbose prints a summary of the registered task variants
+  runtime::TaskGraphResult generate_task_graph(int num_gpus,
+                                               int my_gpu_id,
+                                               bool use_cpu_backend = false,
+                                               bool verbose = false);
 
   // helper functions
   int get_num_input_dtensors() const;
@@ -184,6 +196,7 @@ public:
 
 public:
   std::vector<mirage::kernel::KNOperator *> operators;
+  utils::UseDefIndex<KNOperator, DTensor> use_def;
   dim3 gpu_dim;
   // memory allocator
   // device memory offset manager
@@ -16,6 +16,7 @@
 #pragma once
 
 #include "mirage/config.h"
+#include "mirage/kernel/device_tensor.h"
 #include "mirage/persistent_kernel/runtime_header.h"
 
 namespace mirage {
@@ -45,7 +46,23 @@ struct IODesc {
 struct TaskGraphResult {
   std::string cuda_code;
   std::string json_file;
+  // json_file encoded as a task graph file, which the generated code loads
+  // (see persistent_kernel/task_graph_file.h)
+  std::string binary_file;
 };
 
+// Convert between the JSON and binary forms of a task graph. Both throw
+// std::runtime_error on malformed input
+std::string task_graph_json_to_binary(std::string const &json_task_graph);
+std::string task_graph_binary_to_json(std::string const &binary_task_graph);
+
+// The task ranges of a task graph and their tensors, as the binary form
+// stores them (see CompactTaskDesc). Consecutive tasks that only differ in
+// the offsets of their tensors share a task range. Throws
+// std::runtime_error on malformed input
+void get_task_ranges(std::string const &json_task_graph,
+                     std::vector<CompactTaskDesc> &task_ranges,
+                     std::vector<TensorRef> &tensor_refs);
+
 } // namespace runtime
 } // namespace mirage
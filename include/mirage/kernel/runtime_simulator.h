@@ -0,0 +1,130 @@
+/* Copyright 2025 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "mirage/persistent_kernel/runtime_header.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mirage {
+namespace runtime {
+
+struct SimulatorConfig {
+  int num_workers = 1;
+  int num_local_schedulers = 4;
+  unsigned long long int per_worker_queue_len = 1024;
+  unsigned long long int per_sched_queue_len = 1024;
+  // Number of task graph iterations before the schedulers terminate
+  int num_iterations = 1;
+  // Execution time of a task, indexed by TaskType, in microseconds. Task
+  // types missing from the table take default_task_latency_us
+  std::map<int, float> task_latency_us;
+  float default_task_latency_us = 10.0f;
+  // Time for a worker to fetch a task descriptor and check its dependency
+  float task_fetch_latency_us = 0.5f;
+  // Time between a worker activating an event and the event becoming
+  // visible in a scheduler queue
+  float event_latency_us = 0.5f;
+  // Time for a scheduler to dequeue an event, and to push one task into a
+  // worker queue
+  float sched_event_latency_us = 0.5f;
+  float sched_dispatch_latency_us = 0.1f;
+};
+
+// One task execution on the critical path
+struct SimulatedTask {
+  TaskId task_id; // iteration and position, as in worker queues
+  TaskType task_type;
+  int worker_id;
+  float start_us, end_us;
+};
+
+struct SimulationResult {
+  // False if the simulation ran out of work before the schedulers terminated
+  // (e.g., a task waits on an event that is never activated)
+  bool completed = false;
+  float makespan_us = 0.0f;
+  size_t num_executed_tasks = 0;
+  std::vector<float> worker_busy_us;
+  std::vector<float> worker_utilization;
+  // histogram[d] is the number of enqueues that observed depth d
+  std::vector<size_t> worker_queue_depth_histogram;
+  std::vector<size_t> sched_queue_depth_histogram;
+  // Enqueues that exceeded per_worker_queue_len / per_sched_queue_len; the
+  // persistent kernel asserts in this case
+  size_t worker_queue_overflows = 0;
+  size_t sched_queue_overflows = 0;
+  // The chain of executions that determined the makespan, following at each
+  // step whichever of (worker availability, task dispatch, dependent event)
+  // delayed the start of the task the most
+  std::vector<SimulatedTask> critical_path;
+  float critical_path_busy_us = 0.0f;
+
+  std::string to_string() const;
+};
+
+// A host-side discrete-event model of persistent_kernel: worker queues,
+// local schedulers with their shared broadcast queue, event counters and
+// get_rand_sched_id routing. Remote schedulers and NVSHMEM events are not
+// modeled
+class TaskGraphSimulator {
+public:
+  TaskGraphSimulator(std::vector<TaskDesc> const &all_tasks,
+                     std::vector<EventDesc> const &all_events,
+                     std::vector<TaskId> const &first_tasks);
+  // Parse the json_file of a TaskGraphResult
+  static TaskGraphSimulator from_json(std::string const &json_task_graph);
+  SimulationResult run(SimulatorConfig const &config) const;
+  std::vector<TaskDesc> const &get_tasks() const {
+    return all_tasks;
+  }
+  std::vector<EventDesc> const &get_events() const {
+    return all_events;
+  }
+
+private:
+  std::vector<TaskDesc> all_tasks;
+  std::vector<EventDesc> all_events;
+  std::vector<TaskId> first_tasks;
+};
+
+// Shorthand for TaskGraphSimulator::from_json(json_task_graph).run(config)
+SimulationResult simulate_task_graph(std::string const &json_task_graph,
+                                     SimulatorConfig const &config);
+
+// Upward rank of every task (in microseconds): its latency plus the
+// longest chain of task latencies from it to a sink, as in HEFT. Task
+// latencies follow config
+std::vector<float> get_upward_ranks(std::vector<TaskDesc> const &all_tasks,
+                                    size_t num_events,
+                                    SimulatorConfig const &config);
+
+// Reorder the prelaunched tasks of a task graph (the json_file of a
+// TaskGraphResult) for config.num_workers workers. A task's position decides
+// which worker runs it and when, so positions are assigned by list
+// scheduling on upward ranks. Returns the reordered json_file
+std::string order_task_graph(std::string const &json_task_graph,
+                             SimulatorConfig const &config);
+
+// Average task latency per TaskType (in microseconds) from a profiler buffer
+// written by the persistent kernel (see profiler.h)
+std::map<int, float> get_task_latencies_from_profiler(uint64_t const *buffer,
+                                                      size_t num_entries);
+
+} // namespace runtime
+} // namespace mirage
@@ -0,0 +1,75 @@
+/* Copyright 2025 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "mirage/persistent_kernel/runtime_header.h"
+#include <string>
+#include <vector>
+
+namespace mirage {
+namespace runtime {
+
+// Two tasks access overlapping bytes of a tensor, at least one of them
+// writes, and neither is ordered before the other by the event graph. For
+// a race across iterations, second_task is a pipelined task of the next
+// iteration that can start before first_task has run
+struct TaskGraphRace {
+  TaskId first_task, second_task;
+  std::string tensor;
+  bool first_writes, second_writes;
+  bool across_iterations;
+};
+
+struct TaskGraphVerification {
+  std::vector<TaskGraphRace> races;
+  // Events whose num_triggers differs from the number of tasks that trigger
+  // them in an iteration: they never fire, or fire before all their
+  // producers finish. This includes events triggered by both pipelined and
+  // other tasks
+  std::vector<size_t> miscounted_events;
+  // Prelaunched tasks that never run when each worker executes its queue in
+  // order, e.g. because a task waits on a producer queued behind it
+  std::vector<TaskId> deadlocked_tasks;
+
+  bool ok() const {
+    return races.empty() && miscounted_events.empty() &&
+           deadlocked_tasks.empty();
+  }
+  std::string to_string() const;
+};
+
+// Statically check a task graph (the json_file of a TaskGraphResult) for
+// data races and deadlocks. The bytes each task reads and writes are derived
+// from the offset, dims and strides of its TensorDescs, and checked for
+// happens-before over the event graph. Deadlocks are checked for
+// num_workers workers, with the k-th prelaunched task queued on worker
+// k % num_workers as the schedulers do. Memory is quadratic in the number
+// of tasks
+TaskGraphVerification verify_task_graph(std::string const &json_task_graph,
+                                        int num_workers);
+
+// Let the weight-only tasks of a task graph (the json_file of a
+// TaskGraphResult) overlap with the tail of the previous iteration. A
+// weight-only task without dependencies in its iteration becomes pipelined
+// when the tasks of an iteration that access the bytes it writes all run
+// before some event: its dependent event is set to the earliest such event,
+// which it waits on in the previous iteration. The tasks triggering an
+// event are pipelined together or not at all. Returns the updated
+// json_file
+std::string pipeline_task_graph(std::string const &json_task_graph);
+
+} // namespace runtime
+} // namespace mirage
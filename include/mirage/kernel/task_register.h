@@ -17,6 +17,39 @@
 
 #include "mirage/persistent_kernel/runtime_header.h"
 #include "mirage/threadblock/graph.h"
+#include <unordered_map>
+
+namespace mirage {
+namespace transpiler {
+class CodeKeeper;
+} // namespace transpiler
+
+namespace runtime {
+
+// The parameters that determine the code of a task variant: the template
+// parameters of its kernel and the constants it passes to the kernel at
+// runtime. Variants of a task type with the same template parameters share
+// a template instantiation in the persistent kernel
+class TaskVariantKey {
+public:
+  TaskVariantKey(TaskType task_type,
+                 std::vector<int> const &template_params,
+                 std::vector<int> const &runtime_params);
+  bool operator==(TaskVariantKey const &b) const;
+  TaskType task_type;
+  std::vector<int> template_params;
+  std::vector<int> runtime_params;
+};
+
+} // namespace runtime
+} // namespace mirage
+
+namespace std {
+template <>
+struct hash<mirage::runtime::TaskVariantKey> {
+  size_t operator()(mirage::runtime::TaskVariantKey const &) const;
+};
+} // namespace std
 
 namespace mirage {
 namespace runtime {
@@ -42,10 +75,22 @@ public:
                                    std::vector<int> const &params);
   int register_argmax_reduce_task(threadblock::Graph const &bgraph,
                                   std::vector<int> const &params);
-  int register_task_variant(TaskType type, std::string const &code);
+  // Returns the variant id of `key`, adding a variant with `code` if the
+  // task type has none with the same key
+  int register_task_variant(TaskVariantKey const &key, std::string const &code);
+  // Emit the body of _execute_task: a switch on the task type and then on
+  // the variant id, which compilers lower to jump tables
+  void generate_dispatch_code(mirage::transpiler::CodeKeeper &code) const;
+  // Print the variants, template instantiations and ops of each task type.
+  // Each template instantiation is compiled separately, so their number
+  // estimates the compile cost of the persistent kernel
+  void print_summary() const;
 
 public:
   std::map<TaskType, std::vector<std::string>> all_task_variants;
+  std::unordered_map<TaskVariantKey, int> variant_ids;
+  // The number of ops that registered each variant
+  std::map<TaskType, std::vector<int>> num_variant_uses;
 };
 
 } // namespace runtime
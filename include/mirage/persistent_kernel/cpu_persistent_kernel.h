@@ -0,0 +1,584 @@
+/* Copyright 2025 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Host counterpart of persistent_kernel.cuh. Workers and schedulers run as
+// threads pinned to cores; worker and scheduler queues, event counters and
+// their acquire/release protocol are the same as on the GPU, with GCC atomic
+// builtins in place of the PTX atomics. Only a single node is supported
+
+#include "cpu_tasks/kernel.h"
+#include "runtime_header.h"
+#include <cassert>
+#include <cstdlib>
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+#include <vector>
+
+using bfloat16 = type::bfloat16_t;
+using namespace mirage::runtime;
+
+static inline void _execute_task(TaskDesc const &task_desc,
+                                 RuntimeConfig const &runtime_config);
+
+static inline bool is_termination_event(size_t event_loc, EventDesc e) {
+  return (event_loc == 0);
+}
+
+static inline bool is_nvshmem_event(EventId event_id) {
+  return (event_id & EVENT_NVSHMEM_TAG) > 0;
+}
+
+static inline size_t get_event_gpu_id(EventId event_id) {
+  return ((event_id >> 32) & 0xffff);
+}
+
+static inline size_t get_event_position_index(EventId event_id) {
+  return (event_id & 0xffffffff);
+}
+
+static inline size_t get_task_iteration_num(TaskId task_id) {
+  return (task_id >> 32);
+}
+
+static inline size_t get_task_position_index(TaskId task_id) {
+  return (task_id & 0xffffffff);
+}
+
+static inline TaskId compute_task_id(size_t iteration_num,
+                                     size_t position_index) {
+  return ((iteration_num << 32) | position_index);
+}
+
+// The index in config.all_tasks of the task range holding the task at
+// position_index
+static inline size_t get_task_range_index(RuntimeConfig const &config,
+                                          size_t position_index) {
+  size_t lo = 0, hi = config.num_task_ranges;
+  while (hi - lo > 1) {
+    size_t mid = (lo + hi) / 2;
+    if (config.all_tasks[mid].first_task <= position_index) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static inline bool prepare_next_batch(RuntimeConfig const &config) {
+  int step = config.step[0];
+  config.step[0] = step + 1;
+  if ((step + 2 >= config.max_seq_length) || (config.profiling) ||
+      (config.tokens[step + 1] == config.eos_token_id)) {
+    return false;
+  } else {
+    return true;
+  }
+}
+
+static inline int get_rand_sched_id(size_t event_index,
+                                    int worker_id,
+                                    int num_workers,
+                                    int num_schedulers) {
+  size_t x = worker_id;
+  return x / ((num_workers + num_schedulers - 1) / num_schedulers);
+}
+
+// Unlike the GPU versions these are also acquires, so that the worker that
+// activates an event observes the writes of all earlier triggering tasks
+// before it hands the event to a scheduler
+static inline unsigned long long int
+    custom_atomic_add_u64(unsigned long long int *addr,
+                          unsigned long long int val) {
+  return __atomic_fetch_add(addr, val, __ATOMIC_ACQ_REL);
+}
+
+static inline unsigned long long int
+    custom_atomic_cas_u64(unsigned long long int *addr,
+                          unsigned long long int cmp,
+                          unsigned long long int val) {
+  __atomic_compare_exchange_n(
+      addr, &cmp, val, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+  // cmp holds the old value on failure and is unchanged on success
+  return cmp;
+}
+
+static inline unsigned long long int
+    custom_load_acquire_u64(unsigned long long int const *addr) {
+  return __atomic_load_n(addr, __ATOMIC_ACQUIRE);
+}
+
+static inline void get_first_last_ids(unsigned long long int num_elements,
+                                      unsigned long long int num_workers,
+                                      unsigned long long int my_id,
+                                      unsigned long long int *my_first_element,
+                                      unsigned long long int *my_last_element) {
+  unsigned long long int num_elements_per_worker = num_elements / num_workers;
+  unsigned long long int reminder = num_elements % num_workers;
+  if (my_id < reminder) {
+    *my_first_element = (num_elements_per_worker + 1) * my_id;
+    *my_last_element = *my_first_element + num_elements_per_worker + 1;
+  } else {
+    *my_first_element = num_elements_per_worker * my_id + reminder;
+    *my_last_element = *my_first_element + num_elements_per_worker;
+  }
+}
+
+// Append an entry to a multi-producer queue and publish it once all earlier
+// entries have been published
+static inline void enqueue(unsigned long long int *queue,
+                           unsigned long long int *next_free_pos,
+                           unsigned long long int *last_ready_pos,
+                           unsigned long long int queue_len,
+                           unsigned long long int value) {
+  size_t last_pos = custom_atomic_add_u64(next_free_pos, 1);
+  queue[last_pos % queue_len] = value;
+  size_t old;
+  do {
+    old = custom_atomic_cas_u64(last_ready_pos, last_pos, last_pos + 1);
+  } while (old != last_pos);
+}
+
+static void terminate_schedulers(RuntimeConfig const &config) {
+  // Event ID 0 is the termination event
+  int num_schedulers =
+      config.num_local_schedulers + config.num_remote_schedulers;
+  for (int i = 0; i < num_schedulers; i++) {
+    enqueue(config.sched_queues[i],
+            &config.sched_queue_next_free_event_id[i],
+            &config.sched_queue_last_ready_event_id[i],
+            config.per_sched_queue_len,
+            0);
+  }
+}
+
+static void pin_current_thread(int cpu_id) {
+#ifdef __linux__
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpu_id % std::thread::hardware_concurrency(), &cpuset);
+  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+#endif
+}
+
+static void worker_loop(RuntimeConfig const &config, int worker_id) {
+  TaskId *worker_queue = config.worker_queues[worker_id];
+  size_t cur_task_pos = 0, last_task_pos = 0;
+  while (true) {
+    // fetch next task from the task queue
+    while (cur_task_pos == last_task_pos) {
+      last_task_pos = custom_load_acquire_u64(
+          &config.worker_queue_last_ready_task_id[worker_id]);
+      if (cur_task_pos < last_task_pos) {
+        break;
+      }
+      std::this_thread::yield();
+    }
+    assert(cur_task_pos + config.per_worker_queue_len > last_task_pos);
+    TaskId cur_task_id =
+        worker_queue[cur_task_pos % config.per_worker_queue_len];
+    // Expand the task's range against the TensorDesc table
+    size_t position_index = get_task_position_index(cur_task_id);
+    CompactTaskDesc const &compact_desc =
+        config.all_tasks[get_task_range_index(config, position_index)];
+    size_t index = position_index - compact_desc.first_task;
+    long long bid[3] = {(long long)(index / (compact_desc.grid_dim[1] *
+                                             compact_desc.grid_dim[2])),
+                        (long long)(index / compact_desc.grid_dim[2] %
+                                    compact_desc.grid_dim[1]),
+                        (long long)(index % compact_desc.grid_dim[2])};
+    TaskDesc task_desc(compact_desc.task_type, compact_desc.variant_id);
+    task_desc.num_inputs = compact_desc.num_inputs;
+    task_desc.num_outputs = compact_desc.num_outputs;
+    task_desc.trigger_event = compact_desc.trigger_event;
+    task_desc.dependent_event = compact_desc.dependent_event;
+    for (int i = 0; i < task_desc.num_inputs + task_desc.num_outputs; i++) {
+      TensorRef ref = config.all_tensor_refs[compact_desc.first_tensor_ref + i];
+      TensorDesc tensor = config.all_tensor_descs[ref.desc_id];
+      tensor.base_ptr = static_cast<char *>(tensor.base_ptr) + ref.offset +
+                        ref.offset_strides[0] * bid[0] +
+                        ref.offset_strides[1] * bid[1] +
+                        ref.offset_strides[2] * bid[2];
+      if (i < task_desc.num_inputs) {
+        task_desc.inputs[i] = tensor;
+      } else {
+        task_desc.outputs[i - task_desc.num_inputs] = tensor;
+      }
+    }
+    if (config.verbose) {
+      printf("[FTCH] worker_id(%d) cur_task_pos(%zu) last_task_pos(%zu) "
+             "task_id(%zu) task_type(%d) event_id(%llx)\n",
+             worker_id,
+             cur_task_pos,
+             last_task_pos,
+             get_task_position_index(cur_task_id),
+             task_desc.task_type,
+             task_desc.trigger_event);
+    }
+    // Make sure task is ready before start execution
+    if (task_desc.dependent_event != EVENT_INVALID_ID) {
+      // Wait until the event has been triggered enough times
+      EventId event_id = task_desc.dependent_event;
+      assert(!is_nvshmem_event(event_id));
+      size_t event_index = get_event_position_index(event_id);
+      EventCounter needed_counts =
+          static_cast<EventCounter>(
+              config.all_event_num_triggers[event_index]) *
+          get_task_iteration_num(cur_task_id);
+      while (custom_load_acquire_u64(&config.all_event_counters[event_index]) <
+             needed_counts) {
+        std::this_thread::yield();
+      }
+    }
+
+    if (task_desc.task_type == TASK_TERMINATE) {
+      return;
+    } else if (task_desc.task_type == TASK_BEGIN_TASK_GRAPH ||
+               task_desc.task_type == TASK_RELAY_EVENT) {
+      // Do nothing
+    } else if (task_desc.task_type == TASK_REDUCE) {
+      assert(task_desc.inputs[0].num_dims == 2);
+      assert(task_desc.inputs[1].num_dims == 3);
+      kernel::reduction_kernel<bfloat16>(task_desc.inputs[0].base_ptr,
+                                         task_desc.inputs[1].base_ptr,
+                                         task_desc.outputs[0].base_ptr,
+                                         config.num_gpus,
+                                         config.my_gpu_id,
+                                         task_desc.inputs[0].dim[0],
+                                         task_desc.inputs[0].dim[1],
+                                         task_desc.inputs[0].stride[0]);
+    } else {
+      assert(task_desc.task_type != TASK_NVSHMEM_COPY);
+      _execute_task(task_desc, config);
+    }
+
+    // Trigger event
+    EventId event_id = task_desc.trigger_event;
+    size_t event_index = get_event_position_index(event_id);
+    assert(!is_nvshmem_event(event_id));
+    EventCounter count =
+        custom_atomic_add_u64(&config.all_event_counters[event_index], 1);
+    int num_triggers = config.all_event_num_triggers[event_index];
+    if ((count + 1) == static_cast<EventCounter>(num_triggers) *
+                           get_task_iteration_num(cur_task_id)) {
+      EventDesc event_desc = config.all_events[event_index];
+      if (event_desc.event_type != EVENT_EMPTY) {
+        // Events launching massive or dependent tasks go to the broadcast
+        // queue shared by all local schedulers
+        int sched_id =
+            (event_desc.event_type == EVENT_LAUNCH_MASSIVE_TASKS ||
+             event_desc.event_type == EVENT_LAUNCH_DEPENDENT_TASKS)
+                ? config.num_local_schedulers + config.num_remote_schedulers
+                : get_rand_sched_id(event_index,
+                                    worker_id,
+                                    config.num_workers,
+                                    config.num_local_schedulers);
+        enqueue(config.sched_queues[sched_id],
+                &config.sched_queue_next_free_event_id[sched_id],
+                &config.sched_queue_last_ready_event_id[sched_id],
+                config.per_sched_queue_len,
+                event_index);
+      }
+    }
+    cur_task_pos += 1;
+  }
+}
+
+static void scheduler_loop(RuntimeConfig const &config, int sched_id) {
+  int num_schedulers =
+      config.num_local_schedulers + config.num_remote_schedulers;
+  size_t iteration_num = 0;
+  // Local schedulers also (collectively) process events from the broadcast
+  // queue
+  int sched_queue_ids[2] = {sched_id, num_schedulers};
+  int num_sched_queues = 2;
+  unsigned long long int my_first_worker, my_last_worker;
+  get_first_last_ids(config.num_workers,
+                     config.num_local_schedulers,
+                     sched_id,
+                     &my_first_worker,
+                     &my_last_worker);
+  size_t cur_event_pos[2] = {0, 0}, last_event_pos[2] = {0, 0};
+  std::vector<size_t> worker_queue_next_free_task_pos(config.num_workers, 0);
+  worker_queue_next_free_task_pos[0] = 1;
+  int next_worker = my_first_worker;
+  int queue_idx = 0;
+
+  auto launch_task = [&](TaskId task_id) {
+    size_t last_task_pos = worker_queue_next_free_task_pos[next_worker]++;
+    config.worker_queues[next_worker]
+                        [last_task_pos % config.per_worker_queue_len] = task_id;
+    // Make sure writes to worker_queues are visible to the worker before we
+    // increase its last_ready_task_id
+    custom_atomic_add_u64(&config.worker_queue_last_ready_task_id[next_worker],
+                          1);
+    if (config.verbose) {
+      printf("[SCHD] schd_id(%d) iter_num(%zu) task_idx(%zu) worker_id(%d) "
+             "worker_last_ready_pos(%zu)\n",
+             sched_id,
+             get_task_iteration_num(task_id),
+             get_task_position_index(task_id),
+             next_worker,
+             last_task_pos + 1);
+    }
+    next_worker =
+        (next_worker == my_last_worker - 1) ? my_first_worker : next_worker + 1;
+  };
+
+  while (true) {
+    while (cur_event_pos[queue_idx] == last_event_pos[queue_idx]) {
+      last_event_pos[queue_idx] = custom_load_acquire_u64(
+          &config.sched_queue_last_ready_event_id[sched_queue_ids[queue_idx]]);
+      if (cur_event_pos[queue_idx] < last_event_pos[queue_idx]) {
+        break;
+      } else {
+        queue_idx = (queue_idx == num_sched_queues - 1) ? 0 : queue_idx + 1;
+      }
+      std::this_thread::yield();
+    }
+    // Make sure the schedule queue is not overflow
+    assert(cur_event_pos[queue_idx] + config.per_sched_queue_len >
+           last_event_pos[queue_idx]);
+    EventId event_id = config.sched_queues[sched_queue_ids[queue_idx]]
+                                          [cur_event_pos[queue_idx] %
+                                           config.per_sched_queue_len];
+    EventDesc e = config.all_events[event_id];
+    if (is_termination_event(event_id, e)) {
+      // terminate all workers
+      for (size_t i = my_first_worker; i < my_last_worker; i++) {
+        size_t last_task_pos = worker_queue_next_free_task_pos[i]++;
+        config.worker_queues[i][last_task_pos % config.per_worker_queue_len] =
+            0;
+        custom_atomic_add_u64(&config.worker_queue_last_ready_task_id[i], 1);
+      }
+      return;
+    }
+    if (e.event_type == EVENT_END_OF_TASK_GRAPH) {
+      // Check if we want to continue
+      if (!prepare_next_batch(config)) {
+        terminate_schedulers(config);
+      } else {
+        // Launch task 1 (begin_task_graph) for the next iteration
+        launch_task(compute_task_id(iteration_num + 1, 1));
+      }
+    } else if (e.event_type == EVENT_LAUNCH_DEPENDENT_TASKS) {
+      iteration_num = iteration_num + 1;
+      // Pipelined tasks run one iteration ahead, as in persistent_kernel
+      for (int pass = (iteration_num == 1) ? 0 : 1; pass < 3; pass++) {
+        size_t task_iteration_num = (pass == 0) ? 0 : iteration_num;
+        // Positions increase, so the task range only moves forward
+        size_t range_index = get_task_range_index(config, e.first_task_id);
+        for (size_t i = 0;
+             i < (e.last_task_id - e.first_task_id + config.num_workers - 1) /
+                     config.num_workers;
+             i++) {
+          for (size_t j = my_first_worker; j < my_last_worker; j++) {
+            size_t position_index =
+                e.first_task_id + i * config.num_workers + j;
+            while (range_index + 1 < (size_t)config.num_task_ranges &&
+                   config.all_tasks[range_index + 1].first_task <=
+                       position_index) {
+              range_index++;
+            }
+            if (position_index < e.last_task_id &&
+                config.all_tasks[range_index].pipelined == (pass != 1)) {
+              launch_task(compute_task_id(task_iteration_num, position_index));
+            }
+          }
+        }
+      }
+    } else {
+      unsigned long long int my_first_task = e.first_task_id,
+                             my_last_task = e.last_task_id;
+      if (e.event_type == EVENT_LAUNCH_MASSIVE_TASKS) {
+        // Split event across local schedulers
+        get_first_last_ids(e.last_task_id - e.first_task_id,
+                           config.num_local_schedulers,
+                           sched_id,
+                           &my_first_task,
+                           &my_last_task);
+        my_first_task += e.first_task_id;
+        my_last_task += e.first_task_id;
+      }
+      for (size_t i = my_first_task; i < my_last_task; i++) {
+        launch_task(compute_task_id(iteration_num, i));
+      }
+    }
+    cur_event_pos[queue_idx] += 1;
+  }
+}
+
+template <typename DT>
+DT *cpu_malloc(size_t size) {
+  return static_cast<DT *>(std::calloc(size, 1));
+}
+
+void cpu_free(void *ptr) {
+  std::free(ptr);
+}
+
+// The following function will be generated by the transpiler
+static void _init_persistent_kernel(std::vector<CompactTaskDesc> &all_tasks,
+                                    std::vector<TensorRef> &all_tensor_refs,
+                                    std::vector<TensorDesc> &all_tensor_descs,
+                                    std::vector<EventDesc> &all_events,
+                                    std::vector<TaskId> &first_tasks,
+                                    int num_gpus,
+                                    int my_gpu_id);
+
+static RuntimeConfig global_runtime_config;
+
+extern "C" void init_persistent_kernel(std::vector<void *> meta_tensors,
+                                       void *profiler_buffer,
+                                       int my_rank,
+                                       int num_workers,
+                                       int num_local_schedulers,
+                                       int num_remote_schedulers,
+                                       int max_seq_length,
+                                       long long eos_token_id) {
+  assert(meta_tensors.size() == 2);
+  assert(my_rank == 0);
+  assert(num_remote_schedulers == 0);
+  assert(num_local_schedulers > 0 && num_local_schedulers <= num_workers);
+  assert(num_workers <= MAX_NUM_WORKERS);
+  global_runtime_config.step = static_cast<int *>(meta_tensors[0]);
+  global_runtime_config.tokens = static_cast<long long *>(meta_tensors[1]);
+  global_runtime_config.num_workers = num_workers;
+  global_runtime_config.num_local_schedulers = num_local_schedulers;
+  global_runtime_config.num_remote_schedulers = num_remote_schedulers;
+  global_runtime_config.max_seq_length = max_seq_length;
+  global_runtime_config.eos_token_id = eos_token_id;
+  // The CPU runtime does not record profiler events
+  global_runtime_config.profiler_buffer = nullptr;
+  global_runtime_config.per_worker_queue_len = 1024;
+  global_runtime_config.per_sched_queue_len = 1024;
+  global_runtime_config.num_gpus = 1;
+  global_runtime_config.my_gpu_id = 0;
+  global_runtime_config.num_graphs = 1;
+  global_runtime_config.verbose = false;
+  global_runtime_config.profiling = false;
+  int num_schedulers = num_local_schedulers;
+
+  std::vector<CompactTaskDesc> all_tasks;
+  std::vector<TensorRef> all_tensor_refs;
+  std::vector<TensorDesc> all_tensor_descs;
+  std::vector<EventDesc> all_events;
+  std::vector<TaskId> first_tasks;
+  _init_persistent_kernel(all_tasks,
+                          all_tensor_refs,
+                          all_tensor_descs,
+                          all_events,
+                          first_tasks,
+                          1,
+                          0);
+
+  global_runtime_config.worker_queue_last_ready_task_id =
+      cpu_malloc<unsigned long long int>(num_workers *
+                                         sizeof(unsigned long long int));
+  // We maintain one extra scheduler queue for the broadcast events
+  global_runtime_config.sched_queue_last_ready_event_id =
+      cpu_malloc<unsigned long long int>((num_schedulers + 1) *
+                                         sizeof(unsigned long long int));
+  global_runtime_config.sched_queue_next_free_event_id =
+      cpu_malloc<unsigned long long int>((num_schedulers + 1) *
+                                         sizeof(unsigned long long int));
+  global_runtime_config.all_event_counters =
+      cpu_malloc<EventCounter>(all_events.size() * sizeof(EventCounter));
+  global_runtime_config.all_event_num_triggers =
+      cpu_malloc<int>(all_events.size() * sizeof(int));
+  for (size_t i = 0; i < all_events.size(); i++) {
+    global_runtime_config.all_event_num_triggers[i] =
+        all_events.at(i).num_triggers;
+  }
+  global_runtime_config.num_task_ranges = all_tasks.size();
+  global_runtime_config.all_tasks = new CompactTaskDesc[all_tasks.size()];
+  std::copy(
+      all_tasks.begin(), all_tasks.end(), global_runtime_config.all_tasks);
+  global_runtime_config.all_tensor_refs = new TensorRef[all_tensor_refs.size()];
+  std::copy(all_tensor_refs.begin(),
+            all_tensor_refs.end(),
+            global_runtime_config.all_tensor_refs);
+  global_runtime_config.all_tensor_descs =
+      new TensorDesc[all_tensor_descs.size()];
+  std::copy(all_tensor_descs.begin(),
+            all_tensor_descs.end(),
+            global_runtime_config.all_tensor_descs);
+  global_runtime_config.all_events = new EventDesc[all_events.size()];
+  std::copy(
+      all_events.begin(), all_events.end(), global_runtime_config.all_events);
+  global_runtime_config.worker_queues =
+      cpu_malloc<TaskId *>(num_workers * sizeof(TaskId *));
+  for (int i = 0; i < num_workers; i++) {
+    global_runtime_config.worker_queues[i] = cpu_malloc<TaskId>(
+        global_runtime_config.per_worker_queue_len * sizeof(TaskId));
+  }
+  global_runtime_config.sched_queues =
+      cpu_malloc<EventId *>((num_schedulers + 1) * sizeof(EventId *));
+  for (int i = 0; i < num_schedulers + 1; i++) {
+    global_runtime_config.sched_queues[i] = cpu_malloc<EventId>(
+        global_runtime_config.per_sched_queue_len * sizeof(EventId));
+  }
+  global_runtime_config.first_tasks = new TaskId[first_tasks.size()];
+  std::copy(first_tasks.begin(),
+            first_tasks.end(),
+            global_runtime_config.first_tasks);
+
+  // Send task 1 (begin_task_graph) to worker[0], as init_kernel does
+  global_runtime_config.worker_queues[0][0] =
+      compute_task_id(1 /*iteration_num*/, 1 /*task_begin_task_graph*/);
+  global_runtime_config.worker_queue_last_ready_task_id[0] = 1;
+}
+
+extern "C" void launch_persistent_kernel() {
+  RuntimeConfig const &config = global_runtime_config;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < config.num_workers; i++) {
+    threads.emplace_back([&config, i]() {
+      pin_current_thread(i);
+      worker_loop(config, i);
+    });
+  }
+  for (int i = 0; i < config.num_local_schedulers; i++) {
+    threads.emplace_back([&config, i]() {
+      pin_current_thread(config.num_workers + i);
+      scheduler_loop(config, i);
+    });
+  }
+  for (std::thread &t : threads) {
+    t.join();
+  }
+}
+
+extern "C" void finalize_persistent_kernel() {
+  cpu_free(global_runtime_config.worker_queue_last_ready_task_id);
+  cpu_free(global_runtime_config.sched_queue_last_ready_event_id);
+  cpu_free(global_runtime_config.sched_queue_next_free_event_id);
+  cpu_free(global_runtime_config.all_event_counters);
+  cpu_free(global_runtime_config.all_event_num_triggers);
+  delete[] global_runtime_config.all_tasks;
+  delete[] global_runtime_config.all_tensor_refs;
+  delete[] global_runtime_config.all_tensor_descs;
+  delete[] global_runtime_config.all_events;
+  for (int i = 0; i < global_runtime_config.num_workers; i++) {
+    cpu_free(global_runtime_config.worker_queues[i]);
+  }
+  cpu_free(global_runtime_config.worker_queues);
+  for (int i = 0; i < global_runtime_config.num_local_schedulers + 1; i++) {
+    cpu_free(global_runtime_config.sched_queues[i]);
+  }
+  cpu_free(global_runtime_config.sched_queues);
+  delete[] global_runtime_config.first_tasks;
+}
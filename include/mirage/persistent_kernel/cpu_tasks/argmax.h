@@ -0,0 +1,65 @@
+/* Copyright 2025 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include "common.h"
+namespace kernel {
+
+template <typename T, int CHUNK_SIZE>
+inline void argmax_partial_kernel(void const *__restrict__ input_ptr,
+                                  void *__restrict__ output_val_ptr,
+                                  void *__restrict__ output_idx_ptr) {
+  T const *__restrict__ input = static_cast<T const *>(input_ptr);
+  T *__restrict__ output_val = static_cast<T *>(output_val_ptr);
+  long long *__restrict__ output_idx = static_cast<long long *>(output_idx_ptr);
+
+  float local_max = -inf;
+  long long local_idx = -1;
+  for (int i = 0; i < CHUNK_SIZE; i++) {
+    float val = float(input[i]);
+    if (val > local_max) {
+      local_max = val;
+      local_idx = i;
+    }
+  }
+  output_val[0] = T(local_max);
+  output_idx[0] = local_idx;
+}
+
+template <typename T, int CHUNK_SIZE, int NUM_PARTIAL_TASKS>
+inline void argmax_reduce_kernel(void const *__restrict__ input_val_ptr,
+                                 void const *__restrict__ input_idx_ptr,
+                                 void *__restrict__ final_output_ptr,
+                                 int step,
+                                 long long *tokens) {
+  T const *__restrict__ partial_vals = static_cast<T const *>(input_val_ptr);
+  long long const *__restrict__ partial_idxs =
+      static_cast<long long const *>(input_idx_ptr);
+  long long *__restrict__ final_output =
+      static_cast<long long *>(final_output_ptr);
+
+  float local_max = -inf;
+  long long result = -1;
+  for (int i = 0; i < NUM_PARTIAL_TASKS; i++) {
+    float val = float(partial_vals[i]);
+    if (val > local_max) {
+      local_max = val;
+      result = i * (long long)CHUNK_SIZE + partial_idxs[i];
+    }
+  }
+  final_output[0] = result;
+  tokens[step + 1] = result;
+}
+
+} // namespace kernel
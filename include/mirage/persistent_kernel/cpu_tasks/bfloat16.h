@@ -0,0 +1,54 @@
+/* Copyright 2025 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+namespace type {
+
+// Host-only counterpart of tasks/bfloat16.h, which depends on cuda_bf16.h.
+// Arithmetic is carried out in float
+struct alignas(2) bfloat16_t {
+  uint16_t storage;
+
+  bfloat16_t() = default;
+
+  // Round toward nearest even
+  explicit bfloat16_t(float x) {
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    if ((bits & 0x7f800000) != 0x7f800000) {
+      bits += 0x7fff + ((bits >> 16) & 1);
+    } else if ((bits & 0x007fffff) != 0) {
+      // NaN
+      bits |= 0x00400000;
+    }
+    storage = static_cast<uint16_t>(bits >> 16);
+  }
+
+  operator float() const {
+    uint32_t bits = static_cast<uint32_t>(storage) << 16;
+    float x;
+    std::memcpy(&x, &bits, sizeof(x));
+    return x;
+  }
+
+  bfloat16_t &operator+=(float x) {
+    *this = bfloat16_t(float(*this) + x);
+    return *this;
+  }
+};
+
+} // namespace type
@@ -0,0 +1,25 @@
+/* Copyright 2025 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+// Host implementations of the tasks in tasks/kernel.h, with the same names
+// and signatures so that registered task variants compile unchanged for the
+// CPU runtime
+#include "argmax.h"
+#include "embedding.h"
+#include "linear.h"
+#include "norm_linear.h"
+#include "reduction.h"
+#include "silu_mul_linear.h"
+#include "single_batch_decoding.h"
@@ -0,0 +1,56 @@
+/* Copyright 2025 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include "common.h"
+namespace kernel {
+
+// output[b, n] = sum_k input[b, k] * norm_weight[k] * weight[n, k] /
+//                sqrt(mean_k(input[b, k]^2) + eps)
+template <typename T,
+          int BATCH_SIZE,
+          int OUTPUT_SIZE,
+          int REDUCTION_SIZE,
+          int O_STRIDE = OUTPUT_SIZE>
+inline void norm_linear_task_impl(void const *input_ptr,
+                                  void const *norm_weight_ptr,
+                                  void const *weight_ptr,
+                                  float eps,
+                                  void *output_ptr) {
+  T const *__restrict__ d_input = static_cast<T const *>(input_ptr);
+  T const *__restrict__ d_norm_weight = static_cast<T const *>(norm_weight_ptr);
+  T const *__restrict__ d_weight = static_cast<T const *>(weight_ptr);
+  T *__restrict__ d_output = static_cast<T *>(output_ptr);
+
+  float input[REDUCTION_SIZE];
+  for (int b = 0; b < BATCH_SIZE; b++) {
+    float sum = 0.0f;
+    for (int k = 0; k < REDUCTION_SIZE; k++) {
+      float val = float(d_input[b * REDUCTION_SIZE + k]);
+      sum += val * val;
+      input[k] = val * float(d_norm_weight[k]);
+    }
+    float rms_rcp = 1.0f / std::sqrt(sum / float(REDUCTION_SIZE) + eps);
+    for (int n = 0; n < OUTPUT_SIZE; n++) {
+      T const *w = d_weight + n * REDUCTION_SIZE;
+      float accum = 0.0f;
+      for (int k = 0; k < REDUCTION_SIZE; k++) {
+        accum += input[k] * float(w[k]);
+      }
+      d_output[b * O_STRIDE + n] = T(accum * rms_rcp);
+    }
+  }
+}
+
+} // namespace kernel
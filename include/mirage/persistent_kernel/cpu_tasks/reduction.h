@@ -0,0 +1,47 @@
+/* Copyright 2025 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include "common.h"
+namespace kernel {
+
+template <typename T>
+inline void reduction_kernel(void const *input_ptr,
+                             void const *buf_ptr,
+                             void *output_ptr,
+                             int num_gpus,
+                             int my_gpu_id,
+                             int batch_size,
+                             int output_size,
+                             int stride) {
+  T const *__restrict__ d_input = static_cast<T const *>(input_ptr);
+  T const *__restrict__ d_buffer = static_cast<T const *>(buf_ptr);
+  T *__restrict__ d_output = static_cast<T *>(output_ptr);
+  for (int batch = 0; batch < batch_size; batch++) {
+    for (int offset = 0; offset < output_size; offset++) {
+      float accum = 0.0f;
+      for (int i = 0; i < num_gpus; i++) {
+        if (i == my_gpu_id) {
+          accum += float(d_input[batch * stride + offset]);
+        } else {
+          accum += float(
+              d_buffer[i * batch_size * stride + batch * stride + offset]);
+        }
+      }
+      d_output[batch * stride + offset] = T(accum);
+    }
+  }
+}
+
+} // namespace kernel
@@ -0,0 +1,60 @@
+/* Copyright 2025 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include "common.h"
+namespace kernel {
+
+// Each input row holds [gate | up] of REDUCTION_SIZE elements each;
+// output[b, n] = sum_k silu(gate[b, k]) * up[b, k] * weight[n, k]
+//                (+ residual[b, n])
+template <typename T,
+          int BATCH_SIZE,
+          int OUTPUT_SIZE,
+          int REDUCTION_SIZE,
+          int O_STRIDE = OUTPUT_SIZE>
+inline void silu_mul_linear_task_impl(void const *input_ptr,
+                                      void const *weight_ptr,
+                                      void const *residual_ptr,
+                                      void *output_ptr,
+                                      bool residual = true) {
+  T const *__restrict__ d_input = static_cast<T const *>(input_ptr);
+  T const *__restrict__ d_weight = static_cast<T const *>(weight_ptr);
+  T const *__restrict__ d_residual =
+      residual ? static_cast<T const *>(residual_ptr) : nullptr;
+  T *__restrict__ d_output = static_cast<T *>(output_ptr);
+
+  float input[REDUCTION_SIZE];
+  for (int b = 0; b < BATCH_SIZE; b++) {
+    T const *gate = d_input + b * REDUCTION_SIZE * 2;
+    T const *up = gate + REDUCTION_SIZE;
+    for (int k = 0; k < REDUCTION_SIZE; k++) {
+      float val = float(gate[k]);
+      input[k] = val * (1.0f / (1.0f + std::exp(-val))) * float(up[k]);
+    }
+    for (int n = 0; n < OUTPUT_SIZE; n++) {
+      T const *w = d_weight + n * REDUCTION_SIZE;
+      float accum = 0.0f;
+      for (int k = 0; k < REDUCTION_SIZE; k++) {
+        accum += input[k] * float(w[k]);
+      }
+      if (residual) {
+        accum += float(d_residual[b * O_STRIDE + n]);
+      }
+      d_output[b * O_STRIDE + n] = T(accum);
+    }
+  }
+}
+
+} // namespace kernel
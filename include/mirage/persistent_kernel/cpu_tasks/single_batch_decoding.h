@@ -0,0 +1,163 @@
+/* Copyright 2025 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include "common.h"
+#include <algorithm>
+#include <vector>
+namespace kernel {
+
+// RMS-normalize one head in place and optionally apply the rotary embedding,
+// as rms_norm in tasks/norm.cuh
+inline void rms_norm_head(float *head,
+                          int head_dim,
+                          float const *weight,
+                          float eps,
+                          bool rotary_emd,
+                          float const *cos,
+                          float const *sin) {
+  float sum = 0.0f;
+  for (int i = 0; i < head_dim; i++) {
+    sum += head[i] * head[i];
+  }
+  float rms_rcp = 1.0f / std::sqrt(sum / float(head_dim) + eps);
+  for (int i = 0; i < head_dim; i++) {
+    head[i] *= rms_rcp * weight[i];
+  }
+  if (rotary_emd) {
+    std::vector<float> rotated(head_dim);
+    for (int i = 0; i < head_dim; i++) {
+      if (i < head_dim / 2) {
+        rotated[i] = head[i] * cos[i] - head[i + head_dim / 2] * sin[i];
+      } else {
+        rotated[i] = head[i] * cos[i] + head[i - head_dim / 2] * sin[i];
+      }
+    }
+    std::copy(rotated.begin(), rotated.end(), head);
+  }
+}
+
+// Decoding attention for one request. qkv holds NUM_Q_HEADS query heads
+// followed by NUM_KV_HEADS key and value heads for the new token, which is
+// at position seq_len - 1. Rows of the KV cache are WEIGHT_STRIDE elements
+// apart; the new key/value are written back to row seq_len - 1
+template <typename T,
+          int NUM_Q_HEADS,
+          int NUM_KV_HEADS,
+          int HEAD_DIM,
+          int WEIGHT_STRIDE>
+inline void single_batch_decoding_kernel(void const *qkv_ptr,
+                                         void *k_cache_ptr,
+                                         void *v_cache_ptr,
+                                         void *output_ptr,
+                                         size_t seq_len,
+                                         bool qk_norm,
+                                         bool rotary_emd,
+                                         void const *qnorm_weight_ptr,
+                                         void const *knorm_weight_ptr,
+                                         void const *cos_ptr,
+                                         void const *sin_ptr,
+                                         float q_eps,
+                                         float k_eps) {
+  float const sm_scale = (1.f / std::sqrt((float)HEAD_DIM));
+  T const *d_qkv = static_cast<T const *>(qkv_ptr);
+  T *d_k_cache = static_cast<T *>(k_cache_ptr);
+  T *d_v_cache = static_cast<T *>(v_cache_ptr);
+  T *d_output = static_cast<T *>(output_ptr);
+
+  auto to_float = [](T const *src, int n) {
+    std::vector<float> dst(n);
+    for (int i = 0; i < n; i++) {
+      dst[i] = float(src[i]);
+    }
+    return dst;
+  };
+  std::vector<float> q = to_float(d_qkv, NUM_Q_HEADS * HEAD_DIM);
+  std::vector<float> k_new =
+      to_float(d_qkv + NUM_Q_HEADS * HEAD_DIM, NUM_KV_HEADS * HEAD_DIM);
+  std::vector<float> v_new = to_float(
+      d_qkv + (NUM_Q_HEADS + NUM_KV_HEADS) * HEAD_DIM, NUM_KV_HEADS * HEAD_DIM);
+  // As in the GPU kernel, the rotary embedding is only applied together with
+  // the qk norm
+  if (qk_norm) {
+    std::vector<float> qnorm_weight =
+        to_float(static_cast<T const *>(qnorm_weight_ptr), HEAD_DIM);
+    std::vector<float> knorm_weight =
+        to_float(static_cast<T const *>(knorm_weight_ptr), HEAD_DIM);
+    std::vector<float> cos, sin;
+    if (rotary_emd) {
+      cos = to_float(static_cast<T const *>(cos_ptr) + seq_len * HEAD_DIM,
+                     HEAD_DIM);
+      sin = to_float(static_cast<T const *>(sin_ptr) + seq_len * HEAD_DIM,
+                     HEAD_DIM);
+    }
+    for (int h = 0; h < NUM_Q_HEADS; h++) {
+      rms_norm_head(q.data() + h * HEAD_DIM,
+                    HEAD_DIM,
+                    qnorm_weight.data(),
+                    q_eps,
+                    rotary_emd,
+                    cos.data(),
+                    sin.data());
+    }
+    for (int h = 0; h < NUM_KV_HEADS; h++) {
+      rms_norm_head(k_new.data() + h * HEAD_DIM,
+                    HEAD_DIM,
+                    knorm_weight.data(),
+                    k_eps,
+                    rotary_emd,
+                    cos.data(),
+                    sin.data());
+    }
+  }
+  // Append the new key and value to the cache
+  for (int h = 0; h < NUM_KV_HEADS; h++) {
+    for (int i = 0; i < HEAD_DIM; i++) {
+      size_t offset = (seq_len - 1) * WEIGHT_STRIDE + h * HEAD_DIM + i;
+      d_k_cache[offset] = T(k_new[h * HEAD_DIM + i]);
+      d_v_cache[offset] = T(v_new[h * HEAD_DIM + i]);
+    }
+  }
+
+  std::vector<float> scores(seq_len), o(HEAD_DIM);
+  for (int h = 0; h < NUM_Q_HEADS; h++) {
+    int kv_head = h / (NUM_Q_HEADS / NUM_KV_HEADS);
+    float const *q_head = q.data() + h * HEAD_DIM;
+    float m = -INFINITY;
+    for (size_t r = 0; r < seq_len; r++) {
+      T const *k_row = d_k_cache + r * WEIGHT_STRIDE + kv_head * HEAD_DIM;
+      float s = 0.0f;
+      for (int i = 0; i < HEAD_DIM; i++) {
+        s += q_head[i] * float(k_row[i]);
+      }
+      scores[r] = s * sm_scale;
+      m = std::max(m, scores[r]);
+    }
+    float d_sum = 0.0f;
+    std::fill(o.begin(), o.end(), 0.0f);
+    for (size_t r = 0; r < seq_len; r++) {
+      float p = std::exp(scores[r] - m);
+      d_sum += p;
+      T const *v_row = d_v_cache + r * WEIGHT_STRIDE + kv_head * HEAD_DIM;
+      for (int i = 0; i < HEAD_DIM; i++) {
+        o[i] += p * float(v_row[i]);
+      }
+    }
+    for (int i = 0; i < HEAD_DIM; i++) {
+      d_output[h * HEAD_DIM + i] = T(o[i] / d_sum);
+    }
+  }
+}
+
+} // namespace kernel
@@ -62,6 +62,22 @@ __device__ __forceinline__ TaskId compute_task_id(size_t iteration_num,
   return ((iteration_num << 32) | position_index);
 }
 
+// The index in config.all_tasks of the task range holding the task at
+// position_index
+__device__ __forceinline__ size_t
+    get_task_range_index(RuntimeConfig const &config, size_t position_index) {
+  size_t lo = 0, hi = config.num_task_ranges;
+  while (hi - lo > 1) {
+    size_t mid = (lo + hi) / 2;
+    if (config.all_tasks[mid].first_task <= position_index) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
 __global__ void init_kernel(RuntimeConfig config) {
   assert(gridDim.x == 1);
   assert(gridDim.y == 1);
@@ -177,6 +193,7 @@ __device__ void terminate_schedulers(RuntimeConfig config) {
 
 __global__ void persistent_kernel(RuntimeConfig config) {
   __shared__ TaskId cur_task_id;
+  __shared__ size_t cur_task_range;
   __shared__ TaskDesc task_desc;
   assert(gridDim.y == 1);
   assert(gridDim.z == 1);
@@ -187,9 +204,6 @@ __global__ void persistent_kernel(RuntimeConfig config) {
   assert(num_schedulers % 4 == 0);
   assert(gridDim.x == config.num_workers + num_schedulers / 4);
   assert(config.num_workers <= MAX_NUM_WORKERS);
-  // We will reinterpret TaskDesc as an array of integers to
-  // collectively load it from device to shared memory
-  assert(sizeof(TaskDesc) % sizeof(int) == 0);
   PROFILER_CLOSURE_PARAMS_DECL;
   if (config.profiling) {
     PROFILER_INIT(static_cast<uint64_t *>(config.profiler_buffer),
@@ -246,6 +260,8 @@ __global__ void persistent_kernel(RuntimeConfig config) {
         __threadfence();
         cur_task_id = worker_queues[queue_idx][cur_task_pos[queue_idx] %
                                                config.per_worker_queue_len];
+        cur_task_range = get_task_range_index(
+            config, get_task_position_index(cur_task_id));
         if (config.verbose) {
           printf(
               "[%d][FTCH] worker_id(%d) queue_idx(%d) cur_task_pos(%llu, "
@@ -259,18 +275,47 @@ __global__ void persistent_kernel(RuntimeConfig config) {
               last_task_pos[0],
               last_task_pos[1],
               get_task_position_index(cur_task_id),
-              config.all_tasks[get_task_position_index(cur_task_id)].task_type,
-              config.all_tasks[get_task_position_index(cur_task_id)]
-                  .trigger_event);
+              config.all_tasks[cur_task_range].task_type,
+              config.all_tasks[cur_task_range].trigger_event);
         }
       }
       __syncthreads();
-      int *smem_as_int = reinterpret_cast<int *>(&task_desc);
-      int const *dmem_as_int = reinterpret_cast<int *>(
-          config.all_tasks + get_task_position_index(cur_task_id));
-      for (int i = threadIdx.x; i * sizeof(int) < sizeof(TaskDesc);
-           i += blockDim.x) {
-        smem_as_int[i] = dmem_as_int[i];
+      {
+        // Expand the task's range into shared memory: each thread resolves
+        // one tensor against the TensorDesc table
+        CompactTaskDesc const &compact_desc = config.all_tasks[cur_task_range];
+        size_t index =
+            get_task_position_index(cur_task_id) - compact_desc.first_task;
+        long long bid[3] = {
+            (long long)(index /
+                        (compact_desc.grid_dim[1] * compact_desc.grid_dim[2])),
+            (long long)(index / compact_desc.grid_dim[2] %
+                        compact_desc.grid_dim[1]),
+            (long long)(index % compact_desc.grid_dim[2])};
+        int num_inputs = compact_desc.num_inputs;
+        int num_tensors = num_inputs + compact_desc.num_outputs;
+        if (threadIdx.x == 0) {
+          task_desc.task_type = compact_desc.task_type;
+          task_desc.variant_id = compact_desc.variant_id;
+          task_desc.num_inputs = num_inputs;
+          task_desc.num_outputs = compact_desc.num_outputs;
+          task_desc.trigger_event = compact_desc.trigger_event;
+          task_desc.dependent_event = compact_desc.dependent_event;
+        }
+        for (int i = threadIdx.x; i < num_tensors; i += blockDim.x) {
+          TensorRef ref =
+              config.all_tensor_refs[compact_desc.first_tensor_ref + i];
+          TensorDesc tensor = config.all_tensor_descs[ref.desc_id];
+          tensor.base_ptr = static_cast<char *>(tensor.base_ptr) + ref.offset +
+                            ref.offset_strides[0] * bid[0] +
+                            ref.offset_strides[1] * bid[1] +
+                            ref.offset_strides[2] * bid[2];
+          if (i < num_inputs) {
+            task_desc.inputs[i] = tensor;
+          } else {
+            task_desc.outputs[i - num_inputs] = tensor;
+          }
+        }
       }
       __syncthreads();
       // Make sure task is ready before start execution
@@ -303,7 +348,8 @@ __global__ void persistent_kernel(RuntimeConfig config) {
       if (task_desc.task_type == TASK_TERMINATE) {
         // Terminate
         return;
-      } else if (task_desc.task_type == TASK_BEGIN_TASK_GRAPH) {
+      } else if (task_desc.task_type == TASK_BEGIN_TASK_GRAPH ||
+                 task_desc.task_type == TASK_RELAY_EVENT) {
         // Do nothing
       } else if (task_desc.task_type == TASK_NVSHMEM_COPY) {
 #ifdef USE_NVSHMEM
@@ -616,38 +662,57 @@ __global__ void persistent_kernel(RuntimeConfig config) {
           // assign event in a round-robin fashion
           // Split event across local schedulers
           assert(sched_id < config.num_local_schedulers);
-          for (size_t i = 0;
-               i < (e.last_task_id - e.first_task_id + config.num_workers - 1) /
-                       config.num_workers;
-               i++) {
-            for (size_t j = my_first_worker; j < my_last_worker; j++) {
-              size_t position_index =
-                  e.first_task_id + i * config.num_workers + j;
-              if (position_index < e.last_task_id) {
-                size_t last_task_id =
-                    worker_queue_next_free_task_pos[next_worker]++;
-                config.worker_queues[next_worker][last_task_id %
-                                                  config.per_worker_queue_len] =
-                    compute_task_id(iteration_num, position_index);
-                // Make sure writes to worker_queues is visible to worker CTAs
-                // before we increase its last_ready_task_id
-                __threadfence();
-                custom_atomic_add_u64(
-                    &config.worker_queue_last_ready_task_id[next_worker], 1);
-                if (config.verbose) {
-                  printf("[%d][SCHD] schd_id(%d) iter_num(%llu) task_idx(%llu) "
-                         "worker_id(%d) "
-                         "worker_last_ready_pos(%llu)\n",
-                         config.my_gpu_id,
-                         sched_id,
-                         iteration_num,
-                         position_index,
-                         next_worker,
-                         last_task_id + 1);
+          // Pipelined tasks run one iteration ahead: the first iteration
+          // launches its pipelined tasks before its other tasks, and each
+          // iteration launches the pipelined tasks of the next one after
+          // its own. Those are tagged with the current iteration, so that
+          // they wait on their dependent event in the current iteration
+          for (int pass = (iteration_num == 1) ? 0 : 1; pass < 3; pass++) {
+            size_t task_iteration_num = (pass == 0) ? 0 : iteration_num;
+            // Positions increase, so the task range only moves forward
+            size_t range_index = get_task_range_index(config, e.first_task_id);
+            for (size_t i = 0;
+                 i <
+                 (e.last_task_id - e.first_task_id + config.num_workers - 1) /
+                     config.num_workers;
+                 i++) {
+              for (size_t j = my_first_worker; j < my_last_worker; j++) {
+                size_t position_index =
+                    e.first_task_id + i * config.num_workers + j;
+                while (range_index + 1 < (size_t)config.num_task_ranges &&
+                       config.all_tasks[range_index + 1].first_task <=
+                           position_index) {
+                  range_index++;
+                }
+                if (position_index < e.last_task_id &&
+                    config.all_tasks[range_index].pipelined == (pass != 1)) {
+                  size_t last_task_id =
+                      worker_queue_next_free_task_pos[next_worker]++;
+                  config.worker_queues[next_worker]
+                                      [last_task_id %
+                                       config.per_worker_queue_len] =
+                      compute_task_id(task_iteration_num, position_index);
+                  // Make sure writes to worker_queues is visible to worker
+                  // CTAs before we increase its last_ready_task_id
+                  __threadfence();
+                  custom_atomic_add_u64(
+                      &config.worker_queue_last_ready_task_id[next_worker], 1);
+                  if (config.verbose) {
+                    printf("[%d][SCHD] schd_id(%d) iter_num(%llu) "
+                           "task_idx(%llu) "
+                           "worker_id(%d) "
+                           "worker_last_ready_pos(%llu)\n",
+                           config.my_gpu_id,
+                           sched_id,
+                           task_iteration_num,
+                           position_index,
+                           next_worker,
+                           last_task_id + 1);
+                  }
+                  next_worker = (next_worker == my_last_worker - 1)
+                                    ? my_first_worker
+                                    : next_worker + 1;
                 }
-                next_worker = (next_worker == my_last_worker - 1)
-                                  ? my_first_worker
-                                  : next_worker + 1;
               }
             }
           }
@@ -726,7 +791,9 @@ void gpu_free(void *ptr) {
 }
 
 // The following function will be generated by the transpiler
-static void _init_persistent_kernel(std::vector<TaskDesc> &all_tasks,
+static void _init_persistent_kernel(std::vector<CompactTaskDesc> &all_tasks,
+                                    std::vector<TensorRef> &all_tensor_refs,
+                                    std::vector<TensorDesc> &all_tensor_descs,
                                     std::vector<EventDesc> &all_events,
                                     std::vector<TaskId> &first_tasks,
                                     int num_gpus,
@@ -777,10 +844,18 @@ extern "C" void init_persistent_kernel(std::vector<void *> meta_tensors,
   global_runtime_config.verbose = false;
   global_runtime_config.profiling = profiler_buffer != nullptr;
 
-  std::vector<TaskDesc> all_tasks;
+  std::vector<CompactTaskDesc> all_tasks;
+  std::vector<TensorRef> all_tensor_refs;
+  std::vector<TensorDesc> all_tensor_descs;
   std::vector<EventDesc> all_events;
   std::vector<TaskId> first_tasks;
-  _init_persistent_kernel(all_tasks, all_events, first_tasks, npes, mype);
+  _init_persistent_kernel(all_tasks,
+                          all_tensor_refs,
+                          all_tensor_descs,
+                          all_events,
+                          first_tasks,
+                          npes,
+                          mype);
   // for (size_t i = 0; i < all_tasks.size(); i++) {
   //   printf(
   //       "task[%zu]: task_type(%d) trigger_event(%llx)
@@ -839,12 +914,26 @@ extern "C" void init_persistent_kernel(std::vector<void *> meta_tensors,
   cudaMemset(global_runtime_config.all_event_counters,
              0,
              all_events.size() * sizeof(EventCounter));
-  // Initialize all tasks
+  // Initialize all task ranges
+  global_runtime_config.num_task_ranges = all_tasks.size();
   global_runtime_config.all_tasks =
-      gpu_malloc<TaskDesc>(all_tasks.size() * sizeof(TaskDesc));
+      gpu_malloc<CompactTaskDesc>(all_tasks.size() * sizeof(CompactTaskDesc));
   cudaMemcpy(global_runtime_config.all_tasks,
              all_tasks.data(),
-             all_tasks.size() * sizeof(TaskDesc),
+             all_tasks.size() * sizeof(CompactTaskDesc),
+             cudaMemcpyHostToDevice);
+  // Initialize the tensors of all tasks
+  global_runtime_config.all_tensor_refs = gpu_malloc<TensorRef>(
+      std::max(all_tensor_refs.size(), (size_t)1) * sizeof(TensorRef));
+  cudaMemcpy(global_runtime_config.all_tensor_refs,
+             all_tensor_refs.data(),
+             all_tensor_refs.size() * sizeof(TensorRef),
+             cudaMemcpyHostToDevice);
+  global_runtime_config.all_tensor_descs = gpu_malloc<TensorDesc>(
+      std::max(all_tensor_descs.size(), (size_t)1) * sizeof(TensorDesc));
+  cudaMemcpy(global_runtime_config.all_tensor_descs,
+             all_tensor_descs.data(),
+             all_tensor_descs.size() * sizeof(TensorDesc),
              cudaMemcpyHostToDevice);
   // Initialize all events
   global_runtime_config.all_events =
@@ -937,6 +1026,8 @@ extern "C" void finalize_persistent_kernel() {
   gpu_free(global_runtime_config.all_event_counters);
   gpu_free(global_runtime_config.all_event_num_triggers);
   gpu_free(global_runtime_config.all_tasks);
+  gpu_free(global_runtime_config.all_tensor_refs);
+  gpu_free(global_runtime_config.all_tensor_descs);
   gpu_free(global_runtime_config.all_events);
   int num_workers = global_runtime_config.num_workers;
   std::vector<TaskId *> host_worker_queues(num_workers * 2);
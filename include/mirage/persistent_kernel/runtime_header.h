@@ -34,10 +34,13 @@ typedef unsigned long long int EventCounter;
 int const MAX_INPUTS_PER_TASK = 7;
 int const MAX_OUTPUTS_PER_TASK = 2;
 int const MAX_NUM_WORKERS = 128;
+int const MAX_TENSOR_DESCS = 1 << 16;
 
 enum TaskType {
   TASK_TERMINATE = 0,
   TASK_BEGIN_TASK_GRAPH = 10,
+  // Waits on one event and triggers another
+  TASK_RELAY_EVENT = 11,
   // compute task starts from 100
   TASK_EMBEDDING = 101,
   TASK_RMS_NORM_LINEAR = 102,
@@ -89,17 +92,57 @@ struct EventDesc {
 struct TaskDesc {
   TaskDesc(TaskType t, int _variant_id)
       : task_type(t), variant_id(_variant_id), num_inputs(0), num_outputs(0),
-        trigger_event(EVENT_INVALID_ID), dependent_event(EVENT_INVALID_ID) {}
+        trigger_event(EVENT_INVALID_ID), dependent_event(EVENT_INVALID_ID),
+        weight_only(false), pipelined(false) {}
   TaskDesc() {}
   TaskType task_type;
   unsigned variant_id;
   int num_inputs, num_outputs;
   EventId trigger_event;
   EventId dependent_event;
+  // The task only reads tensors that no task writes (e.g., weights), and
+  // neither the decoding step nor the tokens
+  bool weight_only;
+  // A weight-only task that runs one iteration ahead: the tasks of
+  // iteration i launch the pipelined tasks of iteration i + 1 (see
+  // pipeline_task_graph), whose dependent event is then triggered by the
+  // tasks of iteration i
+  bool pipelined;
   TensorDesc inputs[MAX_INPUTS_PER_TASK];
   TensorDesc outputs[MAX_OUTPUTS_PER_TASK];
 };
 
+// A tensor of a task range: an entry of the task graph's TensorDesc table,
+// with base_ptr advanced by offset bytes for the first task of the range.
+// The offset of a later task advances by offset_strides[d] bytes per step
+// along dimension d of the range's grid. The tasks of an op share table
+// entries and only differ in their offsets
+struct TensorRef {
+  unsigned long long int offset : 48;
+  unsigned long long int desc_id : 16;
+  long long int offset_strides[3];
+};
+
+// The encoding of a range of TaskDescs in the task graph: the tasks at
+// positions [first_task, first_task + grid_dim[0] * grid_dim[1] *
+// grid_dim[2]), which only differ in the offsets of their tensors. The
+// task at index i of the range is at (i / (grid_dim[1] * grid_dim[2]),
+// i / grid_dim[2] % grid_dim[1], i % grid_dim[2]) in the grid. The tensors
+// of the tasks are num_inputs + num_outputs consecutive TensorRefs starting
+// at first_tensor_ref, inputs first. Task ranges are sorted by first_task
+// and cover all tasks
+struct CompactTaskDesc {
+  TaskType task_type;
+  unsigned variant_id;
+  EventId trigger_event;
+  EventId dependent_event;
+  unsigned first_tensor_ref;
+  unsigned char num_inputs, num_outputs;
+  bool weight_only, pipelined;
+  unsigned first_task;
+  unsigned short grid_dim[3];
+};
+
 struct RuntimeConfig {
   int num_workers, num_local_schedulers, num_remote_schedulers, num_graphs;
   int num_gpus, my_gpu_id;
@@ -109,7 +152,10 @@ struct RuntimeConfig {
   unsigned long long int *sched_queue_next_free_event_id;
   EventCounter *all_event_counters;
   int *all_event_num_triggers;
-  TaskDesc *all_tasks;
+  CompactTaskDesc *all_tasks;
+  int num_task_ranges;
+  TensorRef *all_tensor_refs;
+  TensorDesc *all_tensor_descs;
   EventDesc *all_events;
   TaskId **worker_queues;
   EventId **sched_queues;
@@ -0,0 +1,248 @@
+/* Copyright 2025 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "runtime_header.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+namespace mirage {
+namespace runtime {
+
+// A task graph file is a TaskGraphFileHeader followed by flat arrays of the
+// structs the runtime loads (CompactTaskDesc, TensorRef, TensorDesc,
+// EventDesc and TaskId), a relocation array and a string table of tensor
+// names. Each array starts at an 8-byte aligned offset. The base_ptr of
+// every stored TensorDesc is null; the relocations name the tensor it
+// points into. num_tasks counts task ranges, not tasks
+uint32_t const TASK_GRAPH_FILE_VERSION = 3;
+char const TASK_GRAPH_FILE_MAGIC[8] = {'M', 'P', 'K', 'T', 'G', 'R', 'P', 'H'};
+
+struct TaskGraphFileHeader {
+  char magic[8];
+  uint32_t version;
+  // Struct sizes of the writer, so that a file written with a different
+  // layout is rejected instead of misread
+  uint32_t task_size, tensor_ref_size, tensor_desc_size, event_size;
+  uint32_t num_tasks, num_tensor_refs, num_tensor_descs, num_events;
+  uint32_t num_first_tasks, num_relocations, string_table_size;
+  uint64_t tasks_offset, tensor_refs_offset, tensor_descs_offset;
+  uint64_t events_offset, first_tasks_offset, relocations_offset;
+  uint64_t string_table_offset, file_size;
+};
+
+// tensor_descs[tensor_desc_id].base_ptr is set to the tensor whose name
+// starts at string_table[name_offset]
+struct TaskGraphRelocation {
+  uint32_t tensor_desc_id;
+  uint32_t name_offset;
+};
+
+// Returns nullptr if `data` is a well-formed task graph file, and a
+// description of the first problem otherwise
+inline char const *validate_task_graph_file(void const *data, size_t size) {
+  if (size < sizeof(TaskGraphFileHeader)) {
+    return "file is smaller than the header";
+  }
+  TaskGraphFileHeader header;
+  memcpy(&header, data, sizeof(header));
+  if (memcmp(header.magic, TASK_GRAPH_FILE_MAGIC, sizeof(header.magic)) != 0) {
+    return "bad magic number";
+  }
+  if (header.version != TASK_GRAPH_FILE_VERSION) {
+    return "unsupported version";
+  }
+  if (header.task_size != sizeof(CompactTaskDesc) ||
+      header.tensor_ref_size != sizeof(TensorRef) ||
+      header.tensor_desc_size != sizeof(TensorDesc) ||
+      header.event_size != sizeof(EventDesc)) {
+    return "struct layout does not match the runtime";
+  }
+  if (header.file_size != size) {
+    return "file size does not match the header";
+  }
+  auto in_bounds = [&](uint64_t offset, uint64_t count, uint64_t elem_size) {
+    return offset % 8 == 0 && offset <= size &&
+           count <= (size - offset) / elem_size;
+  };
+  if (!in_bounds(header.tasks_offset, header.num_tasks, header.task_size) ||
+      !in_bounds(header.tensor_refs_offset,
+                 header.num_tensor_refs,
+                 header.tensor_ref_size) ||
+      !in_bounds(header.tensor_descs_offset,
+                 header.num_tensor_descs,
+                 header.tensor_desc_size) ||
+      !in_bounds(header.events_offset, header.num_events, header.event_size) ||
+      !in_bounds(
+          header.first_tasks_offset, header.num_first_tasks, sizeof(TaskId)) ||
+      !in_bounds(header.relocations_offset,
+                 header.num_relocations,
+                 sizeof(TaskGraphRelocation)) ||
+      !in_bounds(header.string_table_offset, header.string_table_size, 1)) {
+    return "section out of bounds";
+  }
+  if (header.num_tensor_descs > (uint32_t)MAX_TENSOR_DESCS) {
+    return "too many tensor descs";
+  }
+  char const *base = static_cast<char const *>(data);
+  char const *strings = base + header.string_table_offset;
+  if (header.string_table_size > 0 &&
+      strings[header.string_table_size - 1] != '\0') {
+    return "string table is not null-terminated";
+  }
+  std::vector<bool> relocated(header.num_tensor_descs, false);
+  for (uint32_t i = 0; i < header.num_relocations; i++) {
+    TaskGraphRelocation r;
+    memcpy(&r, base + header.relocations_offset + i * sizeof(r), sizeof(r));
+    if (r.tensor_desc_id >= header.num_tensor_descs ||
+        r.name_offset >= header.string_table_size) {
+      return "relocation out of range";
+    }
+    relocated[r.tensor_desc_id] = true;
+  }
+  for (uint32_t i = 0; i < header.num_tensor_descs; i++) {
+    TensorDesc desc;
+    memcpy(&desc,
+           base + header.tensor_descs_offset + i * sizeof(desc),
+           sizeof(desc));
+    if (!relocated[i] || desc.num_dims < 0 ||
+        desc.num_dims > mirage::config::MAX_TENSOR_DIMS) {
+      return "invalid tensor desc";
+    }
+  }
+  for (uint32_t i = 0; i < header.num_tensor_refs; i++) {
+    TensorRef ref;
+    memcpy(
+        &ref, base + header.tensor_refs_offset + i * sizeof(ref), sizeof(ref));
+    if (ref.desc_id >= header.num_tensor_descs) {
+      return "tensor ref out of range";
+    }
+  }
+  // The number of tasks covered by the task ranges
+  uint64_t num_tasks = 0;
+  for (uint32_t i = 0; i < header.num_tasks; i++) {
+    CompactTaskDesc task;
+    memcpy(&task, base + header.tasks_offset + i * sizeof(task), sizeof(task));
+    if (task.num_inputs > MAX_INPUTS_PER_TASK ||
+        task.num_outputs > MAX_OUTPUTS_PER_TASK ||
+        (uint64_t)task.first_tensor_ref + task.num_inputs + task.num_outputs >
+            header.num_tensor_refs) {
+      return "task tensors out of range";
+    }
+    if (task.first_task != num_tasks || task.grid_dim[0] == 0 ||
+        task.grid_dim[1] == 0 || task.grid_dim[2] == 0) {
+      return "task ranges are not contiguous";
+    }
+    num_tasks +=
+        (uint64_t)task.grid_dim[0] * task.grid_dim[1] * task.grid_dim[2];
+  }
+  if (num_tasks > 0xffffffff) {
+    return "too many tasks";
+  }
+  for (uint32_t i = 0; i < header.num_events; i++) {
+    EventDesc event;
+    memcpy(
+        &event, base + header.events_offset + i * sizeof(event), sizeof(event));
+    if (event.first_task_id > event.last_task_id ||
+        event.last_task_id > num_tasks) {
+      return "event tasks out of range";
+    }
+  }
+  for (uint32_t i = 0; i < header.num_first_tasks; i++) {
+    TaskId task_id;
+    memcpy(&task_id,
+           base + header.first_tasks_offset + i * sizeof(task_id),
+           sizeof(task_id));
+    if (task_id >= num_tasks) {
+      return "first task out of range";
+    }
+  }
+  return nullptr;
+}
+
+// Map a task graph file, validate it and relocate the base_ptr of its
+// tensor descs against all_tensors, in a single pass over the relocations.
+// Aborts if the file is missing, malformed or names an unknown tensor
+inline void
+    load_task_graph_file(char const *path,
+                         std::map<std::string, void *> const &all_tensors,
+                         std::vector<CompactTaskDesc> &all_tasks,
+                         std::vector<TensorRef> &all_tensor_refs,
+                         std::vector<TensorDesc> &all_tensor_descs,
+                         std::vector<EventDesc> &all_events,
+                         std::vector<TaskId> &first_tasks) {
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    fprintf(stderr, "Cannot open task graph file %s\n", path);
+    abort();
+  }
+  size_t size = st.st_size;
+  void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    fprintf(stderr, "Cannot map task graph file %s\n", path);
+    abort();
+  }
+  char const *error = validate_task_graph_file(data, size);
+  if (error != nullptr) {
+    fprintf(stderr, "Invalid task graph file %s: %s\n", path, error);
+    abort();
+  }
+  TaskGraphFileHeader const *header =
+      static_cast<TaskGraphFileHeader const *>(data);
+  char const *base = static_cast<char const *>(data);
+  auto load = [&](auto &vec, uint64_t offset, uint32_t count) {
+    using T = typename std::remove_reference_t<decltype(vec)>::value_type;
+    T const *begin = reinterpret_cast<T const *>(base + offset);
+    vec.assign(begin, begin + count);
+  };
+  load(all_tasks, header->tasks_offset, header->num_tasks);
+  load(all_tensor_refs, header->tensor_refs_offset, header->num_tensor_refs);
+  load(all_tensor_descs, header->tensor_descs_offset, header->num_tensor_descs);
+  load(all_events, header->events_offset, header->num_events);
+  load(first_tasks, header->first_tasks_offset, header->num_first_tasks);
+  TaskGraphRelocation const *relocations =
+      reinterpret_cast<TaskGraphRelocation const *>(base +
+                                                    header->relocations_offset);
+  char const *strings = base + header->string_table_offset;
+  for (uint32_t i = 0; i < header->num_relocations; i++) {
+    std::string name(strings + relocations[i].name_offset);
+    auto it = all_tensors.find(name);
+    if (it == all_tensors.end()) {
+      fprintf(stderr,
+              "Task graph file %s uses unknown tensor %s\n",
+              path,
+              name.c_str());
+      abort();
+    }
+    all_tensor_descs[relocations[i].tensor_desc_id].base_ptr = it->second;
+  }
+  munmap(data, size);
+}
+
+} // namespace runtime
+} // namespace mirage
@@ -7,13 +7,32 @@
 namespace mirage {
 namespace search {
 
-void abstract_expr_eval(
-    threadblock::Graph const &g,
-    std::unordered_map<int64_t, std::shared_ptr<AbstractExpr>> &patterns);
+// Algebraic patterns of tensors keyed by guid. Insertions are logged so that
+// the search can extend the map with the patterns of newly added operators
+// and roll it back to a checkpoint when those operators are removed
+class PatternMap {
+public:
+  bool contains(int64_t guid) const;
+  std::shared_ptr<AbstractExpr> const &at(int64_t guid) const;
+  // Keeps the existing pattern if guid is already present
+  void insert(int64_t guid, std::shared_ptr<AbstractExpr> const &pattern);
+  size_t checkpoint() const;
+  void rollback(size_t checkpoint);
 
-void abstract_expr_eval(
-    kernel::Graph const &g,
-    std::unordered_map<int64_t, std::shared_ptr<AbstractExpr>> &patterns);
+private:
+  std::unordered_map<int64_t, std::shared_ptr<AbstractExpr>> patterns;
+  std::vector<int64_t> inserted_guids;
+};
+
+// Evaluate the patterns of g.operators[first_op:], assuming the patterns of
+// all earlier operators are already in patterns
+void abstract_expr_eval(threadblock::Graph const &g,
+                        PatternMap &patterns,
+                        size_t first_op = 0);
+
+void abstract_expr_eval(kernel::Graph const &g,
+                        PatternMap &patterns,
+                        size_t first_op = 0);
 
 } // namespace search
 } // namespace mirage
\ No newline at end of file
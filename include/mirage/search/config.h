@@ -45,6 +45,12 @@ struct GeneratorConfig {
       randomized_branches; // Only for developers to tune the search performance
   bool _enable_attention_specific_optimization;
   bool _enable_concat_matmul_transformation;
+  // Rejects candidates whose sampled output elements, fingerprinted on the
+  // host, differ from the input graph's before fingerprinting on the GPU
+  bool enable_sampled_fingerprint;
+  // Replays threadblock-level searches identical to completed ones instead
+  // of enumerating them again
+  bool enable_tb_graph_memo;
 
   void show() const;
   void enable_attention_specific_optimization();
@@ -71,7 +77,9 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(GeneratorConfig,
                                    frange_to_explore,
                                    reduction_dimx,
                                    _enable_attention_specific_optimization,
-                                   _enable_concat_matmul_transformation);
+                                   _enable_concat_matmul_transformation,
+                                   enable_sampled_fingerprint,
+                                   enable_tb_graph_memo);
 
 struct TBGraphConfig {
   dim3 grid_dim, block_dim;
@@ -27,15 +27,7 @@ size_t get_operator_hash(Op i, Op j, OpType op) {
 template <typename GraphType>
 int get_num_consumers(GraphType const &g,
                       typename GraphType::TensorType const &tensor) {
-  int num_consumers = 0;
-  for (auto const &op : g.operators) {
-    for (auto const &t : op->input_tensors) {
-      if (t.guid == tensor.guid) {
-        num_consumers++;
-      }
-    }
-  }
-  return num_consumers;
+  return g.use_def.get_num_consumers(tensor.guid);
 }
 
 bool is_binary(type::TBOperatorType op);
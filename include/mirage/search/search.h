@@ -1,7 +1,9 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <mutex>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -10,6 +12,9 @@
 #include "mirage/search/order.h"
 #include "mirage/search/range_propagation/irange.h"
 #include "mirage/search/search_context.h"
+#include "mirage/search/search_estimate.h"
+#include "mirage/search/search_metrics.h"
+#include "mirage/search/search_result_queue.h"
 #include "mirage/search/search_state_manager.h"
 #include "mirage/search/verification/verifier.h"
 #include "mirage/utils/json_utils.h"
@@ -25,6 +30,29 @@ public:
                        bool verbose = false);
 
   void generate_kernel_graphs();
+  // Multi-process search through a spool directory shared with workers
+  // started by run_search_worker. The coordinator splits the search tree
+  // at split_depth into work units, re-queues units whose worker stopped
+  // heartbeating for heartbeat_timeout_sec, and merges the workers' muGraphs
+  // and pattern caches
+  void generate_kernel_graphs_distributed(char const *spool_dir,
+                                          size_t split_depth = 1,
+                                          int heartbeat_timeout_sec = 30);
+  // Claims and searches work units from spool_dir until the coordinator
+  // marks the spool as finished, and returns the number of units searched
+  size_t process_work_units(char const *spool_dir);
+  // Makes a running search return as soon as possible. The muGraphs found
+  // so far stay in generated_graphs, but the checkpoint file is not written
+  void request_stop();
+  // Blocks new verifications until resume() and waits for those in
+  // progress, so that the search stays off the GPU in between, e.g. while
+  // a streamed muGraph is profiled. Does not pause distributed workers
+  void pause();
+  void resume();
+  // Dry run: estimates the size and cost of the search tree from num_probes
+  // random root-to-leaf walks, without saving any muGraph. Meant for a
+  // generator that is not used to search afterwards
+  SearchEstimate estimate_search(size_t num_probes, unsigned int seed = 0);
 
   GeneratorConfig config;
   DimStrategy dim_strategy;
@@ -33,6 +61,15 @@ public:
   std::vector<json> generated_graphs;
   int num_thread;
   bool verbose;
+  // Per-stage timers and counters of the search. When metrics_prefix is
+  // set, they are exported to <metrics_prefix>.json and .prom every
+  // metrics_interval_sec and when the search finishes
+  SearchMetrics metrics;
+  std::string metrics_prefix;
+  double metrics_interval_sec;
+  // When set, every muGraph is also pushed here as soon as it is verified
+  // (or merged from a worker); the queue is not closed by the generator
+  std::shared_ptr<SearchResultQueue> result_queue;
 
 private:
   // Computation graph-related fields
@@ -47,6 +84,12 @@ private:
   std::atomic<int> num_total_random_tests;
   std::atomic<int> num_valid_kernel_graphs;
   std::atomic<int> num_total_states;
+  std::atomic<bool> stop_requested;
+  // Guard paused and num_verifying
+  std::mutex pause_mutex;
+  std::condition_variable pause_cv;
+  bool paused;
+  int num_verifying;
 
   // Time
   std::chrono::time_point<std::chrono::steady_clock> start_time;
@@ -57,6 +100,8 @@ private:
 
   //
   std::unordered_map<std::string, bool> seen_patterns;
+  // Threadblock graphs completed by the threadblock-level searches so far
+  TBGraphMemo tb_graph_memo;
 
   // Ranges-related fields
   std::vector<std::pair<size_t, IKNRange>> init_ranges;
@@ -65,20 +110,59 @@ private:
   // Verifier
   std::shared_ptr<Verifier> verifier;
 
+  SearchContext get_initial_context() const;
+  void search_from(SearchContext &c);
+  SearchContext clone_context(SearchContext const &c);
+  bool check_kernel_ranges(kernel::Graph const &g);
+  template <typename GraphType>
+  void eval_new_patterns(GraphType const &g,
+                         PatternMap &patterns,
+                         size_t first_op);
+  void export_metrics(bool force);
   void generate_next_operator(
       SearchContext &c,
       std::function<bool(SearchContext const &)> const &verify,
       std::vector<SerializedSearchContext> &verified,
       size_t depth);
+  // Case B1 for one output map: adds output operators to c.tb_graph and
+  // continues the kernel-level search with it as a customized operator
+  void finish_threadblock_graph(
+      SearchContext &c,
+      int3 output_map,
+      std::function<bool(SearchContext const &)> const &verify,
+      std::vector<SerializedSearchContext> &verified,
+      size_t depth);
+  // Rebuilds a memoized threadblock graph on c.tb_graph, which holds only
+  // its input operators, and finishes it
+  void replay_threadblock_graph(
+      SearchContext &c,
+      TBGraphRecipe const &recipe,
+      std::function<bool(SearchContext const &)> const &verify,
+      std::vector<SerializedSearchContext> &verified,
+      size_t depth);
+
+  // Set while the coordinator enumerates work units: contexts reaching
+  // split_depth are collected instead of searched
+  std::vector<SerializedSearchContext> *work_units;
+  size_t split_depth;
+  json computation_graph_json;
+
+  std::mutex metrics_export_mutex;
+  std::chrono::steady_clock::time_point last_metrics_export;
 
   void preprocess(kernel::Graph const &computation_graph);
   bool check_pattern(std::shared_ptr<AbstractExpr> pattern);
-  bool verify(kernel::Graph &g);
+  // Saves g with its outputs marked if it is valid and save is set
+  bool verify(kernel::Graph &g, bool save = true);
 
   void save_results() const;
   double get_elapsed_time_in_sec() const;
   void show_statistics() const;
 };
 
+// Worker side of generate_kernel_graphs_distributed: waits for the
+// coordinator's job in spool_dir and processes its work units
+size_t run_search_worker(char const *spool_dir);
+
 } // namespace search
 } // namespace mirage
\ No newline at end of file
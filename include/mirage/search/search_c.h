@@ -24,7 +24,65 @@ int cython_search(mirage::kernel::Graph const *input_graph,
                   std::vector<int> frange_to_explore,
                   char const *filename,
                   bool verbose,
-                  char const *default_config);
+                  char const *default_config,
+                  char const *spool_dir = nullptr,
+                  char const *metrics_prefix = nullptr);
+
+// A search running on a background thread; its muGraphs are retrieved one by
+// one while the search goes on
+struct StreamingSearch;
+
+// Same arguments as cython_search. When filename is an existing checkpoint,
+// its muGraphs are streamed and no search is started
+StreamingSearch *cython_start_search(mirage::kernel::Graph const *input_graph,
+                                     std::vector<MInt3> imap_to_explore,
+                                     std::vector<MInt3> omap_to_explore,
+                                     std::vector<MDim3> grid_dim_to_explore,
+                                     std::vector<MDim3> block_dim_to_explore,
+                                     std::vector<int> fmap_to_explore,
+                                     std::vector<int> frange_to_explore,
+                                     char const *filename,
+                                     bool verbose,
+                                     char const *default_config,
+                                     char const *spool_dir = nullptr,
+                                     char const *metrics_prefix = nullptr);
+// Waits up to timeout_ms for the next muGraph. Returns 1 and sets new_graph
+// if there is one, 0 on timeout, and -1 once the search has finished and all
+// of its muGraphs have been returned
+int cython_next_searched_graph(StreamingSearch *s,
+                               int timeout_ms,
+                               mirage::kernel::Graph **new_graph);
+// Stops the search early; muGraphs already found can still be retrieved
+void cython_stop_search(StreamingSearch *s);
+// Keeps the search off the GPU until cython_resume_search, once the
+// verifications in progress have finished
+void cython_pause_search(StreamingSearch *s);
+void cython_resume_search(StreamingSearch *s);
+// Waits for the search thread and frees s
+void cython_finish_search(StreamingSearch *s);
+
+// Dry run of the search cython_search would start with the same arguments
+// (except block dims, which search() does not customize either):
+// estimates its number of states and verifications from num_probes random
+// probes and predicts its wall time with search_thread threads (0 for the
+// config's default). Returns a SearchEstimate as JSON, along with
+// "num_thread" and "predicted_sec"
+std::string cython_estimate_search(mirage::kernel::Graph const *input_graph,
+                                   std::vector<MInt3> imap_to_explore,
+                                   std::vector<MInt3> omap_to_explore,
+                                   std::vector<MDim3> grid_dim_to_explore,
+                                   std::vector<int> fmap_to_explore,
+                                   std::vector<int> frange_to_explore,
+                                   char const *default_config,
+                                   int num_probes,
+                                   unsigned int seed,
+                                   int search_thread);
+
+// Metrics of the most recent cython_search or cython_finish_search as JSON,
+// or "{}"
+std::string cython_get_search_metrics();
+
+void cython_search_worker(char const *spool_dir);
 
 void cython_to_json(mirage::kernel::Graph const *input_graph,
                     char const *filename);
@@ -5,6 +5,8 @@
 #include <atomic>
 
 #include "mirage/kernel/graph.h"
+#include "mirage/search/abstract_expr/abstract_expr_eval.h"
+#include "mirage/search/tb_graph_memo.h"
 #include "mirage/threadblock/graph.h"
 
 namespace mirage {
@@ -19,6 +21,14 @@ struct SearchContext {
   std::shared_ptr<kernel::Graph> kn_graph;
   std::shared_ptr<threadblock::Graph> tb_graph;
   SearchLevel level;
+  // Algebraic patterns of all tensors in kn_graph and tb_graph, extended as
+  // operators are added and rolled back when they are removed
+  PatternMap patterns;
+  // Set during a threadblock-level search whose results are memoized,
+  // along with the operators the search added to tb_graph so far. Neither
+  // is serialized
+  std::shared_ptr<TBGraphRecorder> tb_graph_recorder;
+  std::vector<TBGraphRecipe::Op> tb_graph_ops;
 };
 
 void from_json(json const &j, SearchContext &c);
@@ -27,8 +37,11 @@ void to_json(json &j, SearchContext const &c);
 class SerializedSearchContext {
 public:
   SerializedSearchContext(SearchContext const &c);
+  explicit SerializedSearchContext(json const &data);
   SearchContext deserialize() const;
 
+  operator json() const;
+
 private:
   json data;
 };
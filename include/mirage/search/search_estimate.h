@@ -0,0 +1,32 @@
+#pragma once
+
+#include "mirage/utils/json_utils.h"
+
+namespace mirage {
+namespace search {
+
+// Result of KernelGraphGenerator::estimate_search. All totals are over the
+// whole search tree, averaged over the random probes
+struct SearchEstimate {
+  size_t num_probes = 0;
+  size_t max_probe_depth = 0;
+  double num_states = 0;
+  // Standard error of num_states over the probes
+  double num_states_stderr = 0;
+  // States whose kernel graph reaches the verifier
+  double num_verifications = 0;
+  // Seconds spent expanding states and verifying them, on a single thread
+  double expansion_sec = 0;
+  double verification_sec = 0;
+  // Whether verifications are serialized across search threads
+  bool serialized_verification = false;
+
+  // Wall time of the search with num_thread search threads, assuming the
+  // expansion of states scales perfectly
+  double get_predicted_sec(int num_thread) const;
+};
+
+void to_json(json &j, SearchEstimate const &e);
+
+} // namespace search
+} // namespace mirage
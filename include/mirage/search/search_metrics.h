@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "mirage/utils/json_utils.h"
+
+namespace mirage {
+namespace search {
+
+enum class SearchStage {
+  CHECK_PATTERN,
+  CHECK_RANGE,
+  CREATE_OP,
+  PATTERN_EVAL,
+  CLONE_CONTEXT,
+  VERIFY,
+  NUM_STAGES,
+};
+
+enum class SearchCache {
+  SEEN_PATTERNS,
+  TB_GRAPHS,
+  NUM_CACHES,
+};
+
+// Latency histogram with power-of-two buckets: bucket i counts samples in
+// [2^i, 2^(i+1)) nanoseconds, and the last bucket is unbounded
+struct LatencyHistogram {
+  static constexpr int NUM_BUCKETS = 40;
+  size_t count = 0;
+  double sum_sec = 0;
+  std::array<size_t, NUM_BUCKETS> buckets{};
+
+  void record(int64_t ns);
+  void merge(LatencyHistogram const &other);
+};
+
+// Totals of all threads of one search
+struct SearchMetricsSnapshot {
+  std::array<LatencyHistogram, static_cast<int>(SearchStage::NUM_STAGES)>
+      stages;
+  // op type -> latency of creating operators of that type
+  std::map<int, LatencyHistogram> create_op;
+  // op type -> number of create_op calls that returned nullptr
+  std::map<int, size_t> create_op_failures;
+  // search depth -> number of states visited at that depth
+  std::map<size_t, size_t> states_per_depth;
+  std::array<std::pair<size_t, size_t>,
+             static_cast<int>(SearchCache::NUM_CACHES)>
+      cache_hits_misses{};
+
+  void merge(SearchMetricsSnapshot const &other);
+  std::string to_openmetrics() const;
+};
+
+void to_json(json &j, SearchMetricsSnapshot const &m);
+void from_json(json const &j, SearchMetricsSnapshot &m);
+
+int64_t get_elapsed_ns(std::chrono::steady_clock::time_point start);
+
+// Each thread records into its own slot, whose mutex is only contended
+// while a snapshot is taken, so recording stays cheap under OpenMP
+class SearchMetrics {
+public:
+  SearchMetrics();
+
+  void record_stage(SearchStage stage, int64_t ns);
+  // Also records ns as a sample of SearchStage::CREATE_OP
+  void record_create_op(int op_type, int64_t ns, bool success);
+  void record_state(size_t depth);
+  void record_cache(SearchCache cache, bool hit);
+  // Sets the latest cumulative metrics reported by another process, e.g.
+  // a search worker; snapshots include the latest report of every source
+  void set_remote(std::string const &source, SearchMetricsSnapshot const &m);
+
+  SearchMetricsSnapshot snapshot() const;
+  // Writes <prefix>.json and <prefix>.prom (OpenMetrics text)
+  void export_to(std::string const &prefix) const;
+
+  // Measures the lifetime of the object as one sample of stage
+  class StageTimer {
+  public:
+    StageTimer(SearchMetrics &metrics, SearchStage stage);
+    ~StageTimer();
+    int64_t elapsed_ns() const;
+
+  private:
+    SearchMetrics &metrics;
+    SearchStage stage;
+    std::chrono::steady_clock::time_point start;
+  };
+
+private:
+  struct Slot {
+    std::mutex mutex;
+    SearchMetricsSnapshot data;
+  };
+  Slot &local();
+
+  size_t const id;
+  mutable std::mutex mutex;
+  std::vector<std::unique_ptr<Slot>> slots;
+  std::map<std::string, SearchMetricsSnapshot> remote;
+};
+
+} // namespace search
+} // namespace mirage
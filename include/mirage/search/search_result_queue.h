@@ -0,0 +1,37 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#include "mirage/utils/json_utils.h"
+
+namespace mirage {
+namespace search {
+
+// Hands the muGraphs verified by a running search to a consumer on another
+// thread, e.g. one compiling and profiling them while the search goes on
+class SearchResultQueue {
+public:
+  enum class Status {
+    GRAPH,
+    TIMEOUT,
+    CLOSED,
+  };
+
+  void push(json const &graph);
+  // Waits up to timeout_ms for a muGraph. Returns CLOSED once the queue is
+  // closed and all of its muGraphs have been popped
+  Status pop(json &graph, int timeout_ms);
+  // Called by the producer after its last push
+  void close();
+
+private:
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<json> graphs;
+  bool closed = false;
+};
+
+} // namespace search
+} // namespace mirage
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mirage/type.h"
+#include <vector_types.h>
+
+namespace mirage {
+namespace search {
+
+// A threadblock graph completed by Case B1, relative to its input operators:
+// the operators Case B2 added after them, each with the positions of its
+// inputs among the tensors produced before it, and the output map
+struct TBGraphRecipe {
+  using Op = std::pair<type::TBOperatorType, std::vector<int>>;
+  std::vector<Op> ops;
+  int3 output_map;
+};
+
+// Threadblock-level searches depend only on the inputs' shapes and
+// patterns and on the threadblock graph configuration, not on the kernel
+// graph they were started from. The memo maps such a configuration to the
+// threadblock graphs its search completed, so that later identical
+// searches are replayed instead of enumerated again
+class TBGraphMemo {
+public:
+  using Recipes = std::vector<TBGraphRecipe>;
+
+  // Returns nullptr if the search of key has not completed yet
+  std::shared_ptr<Recipes const> find(std::string const &key) const;
+  void insert(std::string const &key, Recipes recipes);
+
+private:
+  mutable std::mutex mutex;
+  std::unordered_map<std::string, std::shared_ptr<Recipes const>> entries;
+};
+
+// Collects the recipes of one threadblock-level search. It is shared by all
+// search contexts of that search, including the ones of its OpenMP tasks,
+// so the search has completed when the last of them releases it
+class TBGraphRecorder {
+public:
+  // The recipes are dropped if aborted is set by then
+  TBGraphRecorder(TBGraphMemo &memo,
+                  std::string key,
+                  std::atomic<bool> const &aborted);
+  ~TBGraphRecorder();
+
+  void record(TBGraphRecipe const &recipe);
+
+private:
+  TBGraphMemo &memo;
+  std::string key;
+  std::atomic<bool> const &aborted;
+  std::mutex mutex;
+  TBGraphMemo::Recipes recipes;
+};
+
+} // namespace search
+} // namespace mirage
@@ -15,6 +15,8 @@ public:
 
 private:
   std::vector<z3::expr> input_exprs;
+  // Data type and dims of each output, in the order of input_exprs
+  std::vector<std::vector<int>> input_output_shapes;
   z3::context _ctx;
   std::unordered_set<std::string> all_dims;
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <functional>
 #include <vector>
 
 namespace mirage {
@@ -16,6 +17,12 @@ public:
 
   static OutputMatch invalid_match();
 
+  // Assigns each reference output i a distinct graph output j, chosen among
+  // candidates[i] (tried in order) and accepted if is_match(i, j), by
+  // bipartite matching. is_match is evaluated at most once per pair
+  static OutputMatch find_match(std::vector<std::vector<int>> const &candidates,
+                                std::function<bool(int, int)> const &is_match);
+
 private:
   OutputMatch(std::vector<int> match, bool _valid);
 
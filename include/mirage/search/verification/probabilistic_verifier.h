@@ -9,13 +9,23 @@ namespace search {
 
 class ProbabilisticVerifier : public Verifier {
 public:
-  ProbabilisticVerifier(kernel::Graph const &input_graph);
+  ProbabilisticVerifier(kernel::Graph const &input_graph,
+                        bool enable_sampled_fingerprint = true);
   virtual OutputMatch verify(kernel::Graph const &graph) override;
 
   static std::mutex fp_mutex;
 
 private:
+  // Rejects graphs whose outputs cannot match the input graph's on a few
+  // sampled elements, without computing their fingerprints on the GPU
+  bool may_match(kernel::Graph const &graph,
+                 std::vector<kernel::DTensor> const &outputs) const;
+
+  bool enable_sampled_fingerprint;
   std::vector<cpu::CTensor> input_graph_fingerprints;
+  std::vector<size_t> input_graph_fingerprint_keys;
+  // (element index, fingerprint) of the sampled elements of each output
+  std::vector<std::vector<std::pair<size_t, type::FPType>>> sampled_elements;
 };
 
 } // namespace search
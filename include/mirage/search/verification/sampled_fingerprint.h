@@ -0,0 +1,61 @@
+#pragma once
+
+#include "mirage/kernel/graph.h"
+#include "mirage/threadblock/graph.h"
+#include "mirage/utils/hash_utils.h"
+
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+
+namespace mirage {
+namespace search {
+
+// Computes the fingerprints of individual elements of a kernel graph on the
+// host, evaluating only the elements the requested ones depend on. The
+// results are those the GPU fingerprinters would produce on gpu 0; elements
+// that cannot be reproduced exactly (unsupported operators, elements a
+// customized operator leaves unwritten, or too much work) are unknown
+class SampledFingerprinter {
+public:
+  // Bounds the number of elements evaluated over the fingerprinter's lifetime
+  SampledFingerprinter(size_t max_num_evaluations);
+
+  std::optional<type::FPType> get_fingerprint(kernel::DTensor const &tensor,
+                                              size_t idx);
+
+private:
+  // (tensor guid, linearized block index, forloop iteration, element index);
+  // the block index and iteration are -1 for device tensors
+  using ElementKey = std::tuple<type::GuidType, int, int, size_t>;
+
+  type::FPType get_dtensor_fp(kernel::DTensor const &tensor, size_t idx);
+  type::FPType get_customized_op_fp(kernel::KNCustomizedOp const *op,
+                                    int output_idx,
+                                    size_t idx);
+  type::FPType get_stensor_fp(threadblock::Graph const &bgraph,
+                              threadblock::STensor const &tensor,
+                              dim3 block,
+                              int forloop_idx,
+                              size_t idx);
+  type::FPType get_input_loader_fp(threadblock::Graph const &bgraph,
+                                   threadblock::TBInputOp const *op,
+                                   dim3 block,
+                                   int forloop_idx,
+                                   size_t idx);
+  type::FPType get_forloop_accum_fp(threadblock::Graph const &bgraph,
+                                    threadblock::TBOperator const *op,
+                                    dim3 block,
+                                    size_t idx);
+  bool is_supported(threadblock::Graph const &bgraph);
+  // Marks the element being evaluated as unknown; returns a dummy value
+  type::FPType fail();
+
+  size_t max_num_evaluations, num_evaluations;
+  bool failed;
+  std::unordered_map<ElementKey, type::FPType> memo;
+  std::unordered_map<threadblock::Graph const *, bool> supported_bgraphs;
+};
+
+} // namespace search
+} // namespace mirage
@@ -20,6 +20,7 @@
 #include "mirage/threadblock/operator.h"
 #include "mirage/threadblock/serializer/kernel_params.h"
 #include "mirage/threadblock/smem_tensor.h"
+#include "mirage/utils/use_def_index.h"
 #include <vector>
 #include <vector_types.h>
 
@@ -38,6 +39,11 @@ public:
   ~Graph();
   Graph(Graph const &) = delete;
   Graph &operator=(Graph const &) = delete;
+  // Operators must be added and removed through the following two functions
+  // so that use_def stays in sync with operators
+  void add_operator(TBOperator *op);
+  // Removes the last operator and returns it without deleting it
+  TBOperator *remove_last_operator();
   // input operator
 
   STensor new_input(mirage::kernel::DTensor const &dtensor,
@@ -192,6 +198,7 @@ public:
   int forloop_range;
   int reduction_dimx;
   std::vector<mirage::threadblock::TBOperator *> operators;
+  utils::UseDefIndex<TBOperator, STensor> use_def;
   // memory allocator
   off_t smem_offset;
   std::vector<std::pair<off_t, size_t>> allocated_tensors;
@@ -0,0 +1,102 @@
+// autotune.h - Search TranspilerConfig knobs for a muGraph
+#pragma once
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "mirage/kernel/graph.h"
+#include "mirage/transpiler/structs.h"
+
+namespace mirage {
+namespace transpiler {
+
+// A config that passed pruning, together with its transpiled program
+struct AutotuneCandidate {
+  TranspilerConfig config;
+  TranspileResult result;
+  // Estimated by the cost model; lower is better
+  float predicted_cost;
+  // Measured by the executor in milliseconds, or -1 if not profiled
+  float measured_ms;
+};
+
+// Profiles a transpiled program. The autotuner only depends on this
+// interface, so tests can plug in a stub instead of compiling and running
+// CUDA code
+class AutotuneExecutor {
+public:
+  virtual ~AutotuneExecutor() = default;
+  // Returns the runtime in milliseconds, or a negative value if the
+  // program failed to compile or run
+  virtual float profile(AutotuneCandidate const &candidate) = 0;
+};
+
+// Records are keyed by (graph hash, target_cc, input strides), since the
+// input strides change the transpiled program
+using AutotuneKey = std::tuple<size_t, int, std::vector<std::vector<size_t>>>;
+
+// The best config found for an AutotuneKey
+struct AutotuneRecord {
+  int num_consumer_wgs;
+  int num_producer_wgs;
+  int pipeline_stages;
+  bool enable_online_softmax;
+  // Estimated by the cost model, in bytes of device memory traffic
+  float predicted_cost;
+  // Measured by the executor in milliseconds, or -1 if not profiled
+  float measured_ms;
+};
+
+class Autotuner {
+public:
+  // Records are loaded from and saved to table_path as JSON. An empty path
+  // keeps the table in memory only
+  Autotuner(std::string const &table_path = "");
+
+  // Return the best config for `g`, starting from base_config (whose
+  // target_cc, profiling and other non-tuned fields are kept). A cached
+  // record is returned directly. Otherwise every valid candidate is ranked
+  // by the cost model, the best `num_profiled` are profiled with `executor`
+  // if one is given, and the winner is recorded in the table
+  TranspilerConfig tune(kernel::Graph const *g,
+                        TranspilerConfig const &base_config,
+                        std::vector<std::vector<size_t>> const &input_strides,
+                        AutotuneExecutor *executor = nullptr,
+                        int num_profiled = 3);
+
+  // Enumerate the configs that are valid for `g` on base_config.target_cc
+  static std::vector<TranspilerConfig>
+      enumerate_configs(kernel::Graph const *g,
+                        TranspilerConfig const &base_config);
+
+  // Transpile every config from enumerate_configs and drop the ones that
+  // fail or exceed the shared memory capacity. The result is sorted by
+  // predicted cost
+  static std::vector<AutotuneCandidate>
+      get_candidates(kernel::Graph const *g,
+                     TranspilerConfig const &base_config,
+                     std::vector<std::vector<size_t>> const &input_strides);
+
+  static float estimate_cost(kernel::Graph const *g,
+                             TranspilerConfig const &config,
+                             TranspileResult const &result);
+
+  bool lookup(AutotuneKey const &key, AutotuneRecord &record) const;
+  void update(AutotuneKey const &key, AutotuneRecord const &record);
+
+private:
+  void load();
+  void save() const;
+
+  std::string table_path;
+  std::map<AutotuneKey, AutotuneRecord> table;
+};
+
+// Shared memory capacity per thread block, in bytes. Unknown architectures
+// get the 48 KB that every GPU supports without opting in
+size_t get_shared_memory_capacity(int target_cc);
+
+} // namespace transpiler
+} // namespace mirage
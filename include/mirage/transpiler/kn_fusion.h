@@ -0,0 +1,44 @@
+// kn_fusion.h - Kernel-level fusion of adjacent custom operators
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mirage/transpiler/common.h"
+#include "mirage/transpiler/structs.h"
+
+namespace mirage {
+namespace transpiler {
+
+// A producer/consumer pair of KNCustomizedOps merged into one threadblock
+// graph
+struct KNFusionRecord {
+  // Indices of the two operators in the graph the pass was applied on
+  int producer_idx, consumer_idx;
+  // Whether the consumer was folded into the producer's forloop as an
+  // epilogue (consumer forloop_range == 1), or the producer was folded into
+  // the consumer as a prologue (producer forloop_range == 1)
+  bool is_epilogue;
+  // Global memory traffic of the intermediate DTensor (one write and one
+  // read) minus the extra reads introduced by recomputing the prologue
+  size_t dmem_bytes_saved;
+};
+
+struct KNFusionReport {
+  std::vector<KNFusionRecord> records;
+
+  size_t total_dmem_bytes_saved() const;
+  std::string to_string() const;
+};
+
+// Merge producer/consumer KNCustomizedOps whose producer output map matches
+// the consumer input map, whose grid and block dims are identical, and whose
+// fused threadblock graph, as planned by the transpiler, fits in the shared
+// memory of config.target_cc. Returns the original graph if nothing can be
+// fused; otherwise the caller owns the returned graph
+kernel::Graph const *rewrite_graph_for_kn_fusion(kernel::Graph const *g,
+                                                 TranspilerConfig const &config,
+                                                 KNFusionReport &report);
+
+} // namespace transpiler
+} // namespace mirage
@@ -0,0 +1,87 @@
+// cuda_graph.h - Cache of instantiated CUDA graphs for a transpiled muGraph
+#pragma once
+
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <cuda_runtime.h>
+#include <cute/layout.hpp>
+
+#include "utils.h"
+
+namespace runtime {
+
+// Caches one instantiated CUDA graph per set of tensor pointers passed to
+// the muGraph. Capture always happens on a private non-blocking stream, since
+// the legacy default stream cannot be captured; the captured graph is then
+// launched on the caller's stream (which may be the legacy stream). The
+// cache keeps the `capacity` most recently used graphs and destroys the
+// rest, and all remaining graphs are destroyed when the module is unloaded
+class CudaGraphCache {
+public:
+  using Key = std::vector<void const *>;
+
+  explicit CudaGraphCache(size_t capacity) : capacity(capacity) {}
+
+  ~CudaGraphCache() {
+    // The CUDA runtime may already be shut down at process exit, so errors
+    // are ignored here
+    for (auto &entry : entries) {
+      cudaGraphExecDestroy(entry.second);
+    }
+    if (capture_stream != nullptr) {
+      cudaStreamDestroy(capture_stream);
+    }
+  }
+
+  CudaGraphCache(CudaGraphCache const &) = delete;
+  CudaGraphCache &operator=(CudaGraphCache const &) = delete;
+
+  // Launch the graph cached for `key` on `stream`, capturing it by calling
+  // `capture(capture_stream)` on a miss
+  template <typename Capture>
+  void launch(Key const &key, cudaStream_t stream, Capture &&capture) {
+    auto it = index.find(key);
+    if (it != index.end()) {
+      entries.splice(entries.begin(), entries, it->second);
+    } else {
+      if (capture_stream == nullptr) {
+        CHECK_CUDA(
+            cudaStreamCreateWithFlags(&capture_stream, cudaStreamNonBlocking));
+      }
+      cudaGraph_t graph;
+      cudaGraphExec_t graph_exec;
+      CHECK_CUDA(cudaStreamBeginCapture(capture_stream,
+                                        cudaStreamCaptureModeThreadLocal));
+      capture(capture_stream);
+      CHECK_CUDA(cudaStreamEndCapture(capture_stream, &graph));
+      CHECK_CUDA(cudaGraphInstantiateWithFlags(&graph_exec, graph, 0));
+      CHECK_CUDA(cudaGraphDestroy(graph));
+      entries.emplace_front(key, graph_exec);
+      index[key] = entries.begin();
+      if (entries.size() > capacity) {
+        // The evicted graph may still be running on some stream
+        CHECK_CUDA(cudaDeviceSynchronize());
+        CHECK_CUDA(cudaGraphExecDestroy(entries.back().second));
+        index.erase(entries.back().first);
+        entries.pop_back();
+      }
+    }
+    CHECK_CUDA(cudaGraphLaunch(entries.front().second, stream));
+  }
+
+  size_t size() const {
+    return entries.size();
+  }
+
+private:
+  size_t capacity;
+  cudaStream_t capture_stream = nullptr;
+  // Most recently used first
+  std::list<std::pair<Key, cudaGraphExec_t>> entries;
+  std::map<Key, std::list<std::pair<Key, cudaGraphExec_t>>::iterator> index;
+};
+
+} // namespace runtime
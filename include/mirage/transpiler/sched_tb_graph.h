@@ -1,5 +1,6 @@
 #pragma once
 
+#include <unordered_map>
 #include <vector>
 
 #include "mirage/transpiler/common.h"
@@ -50,5 +51,19 @@ public:
   std::vector<TBSchedNode> post_loop_nodes; // Nodes after the for loop
 };
 
+// Use a simple heuristic to decide whether or not to put the forloop
+// accumulators in register files. Every thread can have at most 255 32-bit
+// registers (according to
+// https://docs.nvidia.com/cuda/cuda-c-programming-guide/index.html#features-and-technical-specifications)
+// So we allow accumulators to take up to 192 registers
+size_t const MAX_PER_THREAD_ACCUM_NUMEL = 192;
+
+// Whether each forloop accumulator of tb_graph is kept in register files.
+// Accumulators are split evenly across the threads of a block and take
+// registers in operator order; once the budget is used up, the remaining
+// ones are placed in shared memory, as are all rescaling accumulators
+std::unordered_map<tb::TBOperator const *, bool>
+    get_accum_in_reg(tb::Graph const &tb_graph);
+
 } // namespace transpiler
 } // namespace mirage
@@ -42,6 +42,18 @@ struct TranspilerConfig {
 
   // Whether to enable graph rewriting
   bool enable_online_softmax = false;
+
+  // Whether the generated host code captures the whole muGraph into a CUDA
+  // graph (cached by tensor pointers) and replays it on later calls
+  bool enable_cuda_graph = false;
+
+  // Maximum number of instantiated CUDA graphs (one per set of tensor
+  // pointers) kept by the generated code; least recently used are destroyed
+  int cuda_graph_cache_size = 16;
+
+  // Whether to merge adjacent customized operators whose threadblock graphs
+  // are tile-compatible, so their intermediate never reaches device memory
+  bool enable_kn_fusion = false;
 };
 
 // Directive for an output tensor
@@ -78,6 +90,10 @@ struct TranspileResult {
 
   // Directives for output tensors
   std::vector<OutputTensorDirective> output_directives;
+
+  // Human-readable summary of the kernel-level fusions applied (empty if
+  // enable_kn_fusion is off)
+  std::string kn_fusion_report;
 };
 
 struct TMAParams {
@@ -30,5 +30,8 @@ TranspileResult
               TranspilerConfig const &config,
               std::vector<std::vector<size_t>> const &input_strides);
 
-}
+// Rewrite the graph for online softmax, return the original graph if no needed
+kernel::Graph const *rewrite_graph_for_online_softmax(kernel::Graph const *g);
+
+} // namespace transpiler
 } // namespace mirage
@@ -21,6 +21,7 @@
 
 #include "mirage/kernel/graph.h"
 #include "mirage/transpiler/common.h"
+#include "mirage/transpiler/kn_fusion.h"
 #include "mirage/transpiler/sched_tb_graph.h"
 #include "mirage/transpiler/structs.h"
 #include "mirage/transpiler/utils.h"
@@ -45,6 +46,9 @@ private:
   vector<vector<size_t>> output_strides;
   vector<kn::DTensor> mugraph_output_tensors;
 
+  // Fusions applied by rewrite_graph_for_kn_fusion
+  KNFusionReport kn_fusion_report;
+
   // Distributed configuration
   int num_gpus;
   bool use_nvshmem; // Whether to use NVSHMEM (<=> whether the kernel is
@@ -112,6 +116,9 @@ private:
   // Transpile the whole uGraph
   TranspileResult transpile_ugraph();
 
+  // The native microbenchmarks (benchmark/native) time individual passes
+  friend class TranspilerBenchmark;
+
 public:
   // Initialize the transpiler and resolve all configurations
   Transpiler(kernel::Graph const *g,
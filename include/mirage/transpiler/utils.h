@@ -16,10 +16,14 @@
 
 #include "mirage/type.h"
 #include <cassert>
+#include <charconv>
 #include <cute/layout.hpp>
 #include <functional>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 using namespace cute;
@@ -91,61 +95,165 @@ std::vector<std::string> map_to_cute_int(std::vector<T> const &vec) {
       vec, [](T const &x) { return "Int<" + my_to_string(x) + ">"; });
 }
 
+// Count the `$` markers in a template string. This is constexpr so that the
+// count is folded at compile time when the template is a string literal
+constexpr size_t count_fmt_markers(std::string_view fmt_str) {
+  size_t num_markers = 0;
+  for (char c : fmt_str) {
+    if (c == '$') {
+      num_markers++;
+    }
+  }
+  return num_markers;
+}
+
+// Append the textual form of `value` to `out` without building a temporary
+// string for integers and strings
+template <typename T>
+inline static void append_to_string(std::string &out, T const &value) {
+  if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool> &&
+                !std::is_same_v<T, char>) {
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, res.ptr);
+  } else if constexpr (std::is_convertible_v<T const &, std::string_view>) {
+    out.append(std::string_view(value));
+  } else {
+    out += my_to_string(value);
+  }
+}
+
+// A template string literal wrapped by FMT_STR. Its marker count is a
+// compile-time constant, so the functions below check it against the number
+// of arguments with a static_assert instead of at runtime
+template <typename Literal>
+struct FmtStr {
+  static constexpr std::string_view value = Literal::get();
+  static constexpr size_t num_markers = count_fmt_markers(value);
+
+  constexpr operator std::string_view() const {
+    return value;
+  }
+};
+
+template <typename T>
+struct is_fmt_str : std::false_type {};
+
+template <typename Literal>
+struct is_fmt_str<FmtStr<Literal>> : std::true_type {};
+
+// Wrap a string literal template, e.g. `code.e(FMT_STR("int $ = $;"), a, b)`.
+// The literal is carried in the type of a local class, which is the C++17
+// way to make a string usable as a constant expression at the call site
+#define FMT_STR(lit)                                                           \
+  ([] {                                                                        \
+    struct Literal {                                                           \
+      static constexpr std::string_view get() { return lit; }                  \
+    };                                                                         \
+    return ::mirage::transpiler::FmtStr<Literal>{};                            \
+  }())
+
+// Check that the number of arguments matches the number of markers in the
+// template string. This is a static_assert for FMT_STR templates, and a
+// runtime assertion otherwise
+template <typename Str, typename... Args>
+inline static void check_fmt_args(Str const &fmt_str, Args const &...args) {
+  if constexpr (is_fmt_str<Str>::value) {
+    static_assert(Str::num_markers == sizeof...(Args),
+                  "The number of arguments does not match the number of "
+                  "markers in the template string");
+  } else {
+    size_t num_args = sizeof...(args);
+    size_t num_markers = count_fmt_markers(fmt_str);
+    if (num_args != num_markers) {
+      std::cerr << "Error encountered during transpiling. ";
+      std::cerr
+          << "The number of arguments does not match the number of markers "
+             "in the template string.";
+      std::cerr << "fmt_str: " << std::string_view(fmt_str) << std::endl;
+      std::cerr << "args: ";
+      ((std::cerr << my_to_string(args) << " "), ...);
+      std::cerr << std::endl;
+      std::cerr << "num_args: " << num_args << std::endl;
+      std::cerr << "num_markers: " << num_markers << std::endl;
+      assert(num_args == num_markers);
+    }
+  }
+}
+
 // A function that takes a template string and a list of elements
 // It replaces each marker in the template string with the corresponding element
-// and returns the resulting string. We can use this to generate code elegantly
-template <typename... Args>
-inline static std::string fmt(std::string const &fmt_str, Args... args) {
-  std::string result = fmt_str;
-  int num_args = sizeof...(args);
-  int num_markers = std::count(result.begin(), result.end(), '$');
-  if (num_args != num_markers) {
-    std::cerr << "Error encountered during transpiling. ";
-    std::cerr << "The number of arguments does not match the number of markers "
-                 "in the template string.";
-    std::cerr << "fmt_str: " << fmt_str << std::endl;
-    std::cerr << "args: ";
-    ((std::cerr << my_to_string(args) << " "), ...);
-    std::cerr << std::endl;
-    std::cerr << "num_args: " << num_args << std::endl;
-    std::cerr << "num_markers: " << num_markers << std::endl;
-    assert(num_args == num_markers);
-  }
-  (result.replace(result.find("$"), 1, my_to_string(args)), ...);
+// and appends the result to `out`. The template is scanned once and the
+// elements are written in place
+template <typename Str, typename... Args>
+inline static void
+    fmt_to(std::string &out, Str const &fmt_template, Args... args) {
+  check_fmt_args(fmt_template, args...);
+  std::string_view fmt_str(fmt_template);
+  size_t pos = 0;
+  auto emit_arg = [&](auto const &arg) {
+    size_t marker = fmt_str.find('$', pos);
+    out.append(fmt_str.data() + pos, marker - pos);
+    append_to_string(out, arg);
+    pos = marker + 1;
+  };
+  (emit_arg(args), ...);
+  out.append(fmt_str.data() + pos, fmt_str.size() - pos);
+}
+
+// Same as `fmt_to`, but returns the result as a new string. We can use this to
+// generate code elegantly
+template <typename Str, typename... Args>
+inline static std::string fmt(Str const &fmt_str, Args... args) {
+  std::string result;
+  result.reserve(std::string_view(fmt_str).size() + 16 * sizeof...(args));
+  fmt_to(result, fmt_str, args...);
   return result;
 }
 
 // A helper class for keeping all generated code, and provide some utility
 // functions for emitting code
+// Lines emitted by `e` are formatted directly into a single buffer.
+// Lines emitted by `e_front` are kept in a separate segment so that
+// prepending is O(1)
 class CodeKeeper {
 private:
   static constexpr int NUM_INDENT_SPACES = 2;
   int cur_indent_level = 0;
-  std::vector<std::string> lines;
+  // Lines emitted by `e`, each terminated by '\n'
+  std::string body;
+  // The offset in `body` where each line starts
+  std::vector<size_t> line_starts;
+  // Lines emitted by `e_front`, in reverse order of appearance
+  std::vector<std::string> front_lines;
 
 public:
   // Emit a new line
   // Here we support "smart indenting". If the last character is "{", we
   // increase the indent level. If it is "}", we decrease the indent level.
-  template <typename... Args>
-  void e_front(std::string const &fmt_str, Args... args) {
-    std::string line = fmt(fmt_str, args...);
-    lines.emplace(lines.begin(), line);
+  template <typename Str, typename... Args>
+  void e_front(Str const &fmt_str, Args... args) {
+    front_lines.push_back(fmt(fmt_str, args...));
   }
 
-  template <typename... Args>
-  void e(std::string const &fmt_str, Args... args) {
-    std::string line = fmt(fmt_str, args...);
-    char last_char = line.empty() ? EOF : line.back();
+  template <typename Str, typename... Args>
+  void e(Str const &fmt_str, Args... args) {
+    size_t line_start = body.size();
+    line_starts.push_back(line_start);
+    body.append(cur_indent_level * NUM_INDENT_SPACES, ' ');
+    size_t content_start = body.size();
+    fmt_to(body, fmt_str, args...);
+    char last_char = body.size() == content_start ? EOF : body.back();
     if (last_char == '}') {
       cur_indent_level -= 1;
       if (cur_indent_level < 0) {
         printf("Warning: `cur_indent_level` goes below 0 when transpiling\n");
         cur_indent_level = 0;
+      } else {
+        body.erase(line_start, NUM_INDENT_SPACES);
       }
     }
-    line = std::string(cur_indent_level * NUM_INDENT_SPACES, ' ') + line;
-    lines.push_back(line);
+    body.push_back('\n');
 
     if (last_char == '{') {
       cur_indent_level += 1;
@@ -168,19 +276,50 @@ public:
 
   // Merge two CodeKeeper objects
   friend void operator<<(CodeKeeper &target, CodeKeeper const &source) {
-    for (auto const &line : source.lines) {
-      std::string new_line =
-          std::string(target.cur_indent_level * NUM_INDENT_SPACES, ' ') + line;
-      target.lines.push_back(new_line);
+    size_t indent = target.cur_indent_level * NUM_INDENT_SPACES;
+    target.body.reserve(
+        target.body.size() + source.size() +
+        indent * (source.front_lines.size() + source.line_starts.size()));
+    for (auto it = source.front_lines.rbegin(); it != source.front_lines.rend();
+         ++it) {
+      target.line_starts.push_back(target.body.size());
+      target.body.append(indent, ' ');
+      target.body.append(*it);
+      target.body.push_back('\n');
+    }
+    for (size_t i = 0; i < source.line_starts.size(); i++) {
+      size_t begin = source.line_starts[i];
+      size_t end = i + 1 < source.line_starts.size() ? source.line_starts[i + 1]
+                                                     : source.body.size();
+      target.line_starts.push_back(target.body.size());
+      target.body.append(indent, ' ');
+      target.body.append(source.body, begin, end - begin);
     }
   }
 
+  // The length of the generated code, in characters
+  size_t size() const {
+    size_t result = body.size();
+    for (auto const &line : front_lines) {
+      result += line.size() + 1;
+    }
+    return result;
+  }
+
+  // Append the generated code to `out`
+  void append_to(std::string &out) const {
+    for (auto it = front_lines.rbegin(); it != front_lines.rend(); ++it) {
+      out.append(*it);
+      out.push_back('\n');
+    }
+    out.append(body);
+  }
+
   // Return the generated code as a string
   std::string to_string() const {
     std::string result;
-    for (auto const &line : lines) {
-      result += line + "\n";
-    }
+    result.reserve(size());
+    append_to(result);
     return result;
   }
 };
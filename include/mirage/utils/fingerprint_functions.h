@@ -18,6 +18,11 @@
 #include "mirage/config.h"
 #include "mirage/type.h"
 #include <algorithm>
+#include <cuda_runtime.h>
+
+// Shared by the GPU fingerprinters and the host-side sampled fingerprints in
+// mirage/search/verification/sampled_fingerprint.h, which must agree bit for
+// bit
 
 namespace mirage {
 namespace utils {
@@ -25,13 +30,13 @@ namespace utils {
 using namespace mirage::type;
 using namespace mirage::config;
 
-inline __device__ FPType compute_add_fingerprint(FPType a, FPType b) {
+inline __host__ __device__ FPType compute_add_fingerprint(FPType a, FPType b) {
   uint32_t x = a;
   uint32_t y = b;
   return (x + y) % FP_PQ;
 }
 
-inline __device__ FPType compute_mul_fingerprint(FPType a, FPType b) {
+inline __host__ __device__ FPType compute_mul_fingerprint(FPType a, FPType b) {
   uint32_t x = a;
   uint32_t y = b;
   uint32_t p_residual = ((x % FP_P) * (y % FP_P)) % FP_P;
@@ -40,10 +45,11 @@ inline __device__ FPType compute_mul_fingerprint(FPType a, FPType b) {
   return (z % FP_PQ);
 }
 
-inline __device__ FPType compute_div_fingerprint(FPType a,
-                                                 FPType b,
-                                                 FPType *div_p_lookup_table,
-                                                 FPType *div_q_lookup_table) {
+inline __host__ __device__ FPType
+    compute_div_fingerprint(FPType a,
+                            FPType b,
+                            FPType const *div_p_lookup_table,
+                            FPType const *div_q_lookup_table) {
   uint32_t x = a;
   uint32_t y = b;
   uint32_t p_residual = ((x % FP_P) * div_p_lookup_table[y % FP_P]) % FP_P;
@@ -52,29 +58,30 @@ inline __device__ FPType compute_div_fingerprint(FPType a,
   return (z % FP_PQ);
 }
 
-inline __device__ FPType compute_exp_fingerprint(FPType input,
-                                                 FPType *exp_lookup_table) {
+inline __host__ __device__ FPType
+    compute_exp_fingerprint(FPType input, FPType const *exp_lookup_table) {
   FPType q_residual = input % FP_Q;
   uint32_t result = exp_lookup_table[q_residual];
   result = (result * FP_Q_MUL_P_MOD_1) % FP_PQ;
   return result;
 }
 
-inline __device__ FPType compute_sqrt_fingerprint(FPType input,
-                                                  FPType *sqrt_p_lookup_table,
-                                                  FPType *sqrt_q_lookup_table) {
+inline __host__ __device__ FPType
+    compute_sqrt_fingerprint(FPType input,
+                             FPType const *sqrt_p_lookup_table,
+                             FPType const *sqrt_q_lookup_table) {
   uint32_t x = input;
   x = sqrt_p_lookup_table[x % FP_P] * FP_Q_MUL_P_MOD_1 +
       sqrt_q_lookup_table[x % FP_Q] * FP_P_MUL_Q_MOD_1;
   return x % FP_PQ;
 }
 
-inline __device__ FPType compute_square_fingerprint(FPType input) {
+inline __host__ __device__ FPType compute_square_fingerprint(FPType input) {
   return compute_mul_fingerprint(input, input);
 }
 
-inline __device__ FPType compute_silu_fingerprint(FPType input,
-                                                  FPType *exp_lookup_table) {
+inline __host__ __device__ FPType
+    compute_silu_fingerprint(FPType input, FPType const *exp_lookup_table) {
   // Note that we use $x * e^x$ as the fingerprint for SILU
   // (i.e., $x / (1+e^{-x})$, since plus one can be easier
   // implemented at any level of the GPU compute hierarchy
@@ -85,8 +92,8 @@ inline __device__ FPType compute_silu_fingerprint(FPType input,
   return result;
 }
 
-inline __device__ FPType compute_gelu_fingerprint(FPType input,
-                                                  FPType *exp_lookup_table) {
+inline __host__ __device__ FPType
+    compute_gelu_fingerprint(FPType input, FPType const *exp_lookup_table) {
   // Approximating GeLU as x*sigmoid(1.702x)
   FPType q_residual = input % FP_Q;
   FPType scaling_factor = 2;
@@ -96,29 +103,37 @@ inline __device__ FPType compute_gelu_fingerprint(FPType input,
   return result;
 }
 
-inline __device__ FPType compute_clamp_fingerprint(FPType input) {
+// CUDA's min and max are not available to host compilers
+inline __host__ __device__ uint32_t clamp_residual(uint32_t x,
+                                                   uint32_t lo,
+                                                   uint32_t hi) {
+  return x < lo ? lo : (x > hi ? hi : x);
+}
+
+inline __host__ __device__ FPType compute_clamp_fingerprint(FPType input) {
   // We use min(max(FP_Q/3, input), FP_Q*2/3) to approximate clamp
   // Note that we ignore the input arguments to clamp
   // https://pytorch.org/docs/main/generated/torch.clamp.html
   uint32_t q_residual = input % FP_Q;
   uint32_t p_residual = input % FP_P;
-  q_residual = min(2 * FP_Q / 3, max(FP_Q / 3, (int)q_residual));
-  p_residual = min(2 * FP_P / 3, max(FP_P / 3, (int)p_residual));
+  q_residual = clamp_residual(q_residual, FP_Q / 3, 2 * FP_Q / 3);
+  p_residual = clamp_residual(p_residual, FP_P / 3, 2 * FP_P / 3);
   uint32_t z = p_residual * FP_Q_MUL_P_MOD_1 + q_residual * FP_P_MUL_Q_MOD_1;
   return z % FP_PQ;
 }
 
-inline __device__ FPType compute_relu_fingerprint(FPType input) {
+inline __host__ __device__ FPType compute_relu_fingerprint(FPType input) {
   // We use max(FP_Q/2, input) to approximate relu
   uint32_t q_residual = input % FP_Q;
   uint32_t p_residual = input % FP_P;
-  q_residual = max(FP_Q / 2, (int)q_residual);
-  p_residual = max(FP_P / 2, (int)p_residual);
+  q_residual = clamp_residual(q_residual, FP_Q / 2, FP_Q);
+  p_residual = clamp_residual(p_residual, FP_P / 2, FP_P);
   uint32_t z = p_residual * FP_Q_MUL_P_MOD_1 + q_residual * FP_P_MUL_Q_MOD_1;
   return z % FP_PQ;
 }
 
-inline __device__ FPType compute_pow_fingerprint(FPType base, FPType exponent) {
+inline __host__ __device__ FPType compute_pow_fingerprint(FPType base,
+                                                          FPType exponent) {
   uint32_t base_p = base % FP_P;
   uint32_t base_q = base % FP_Q;
   uint32_t exp = (uint32_t)exponent;
@@ -141,5 +156,37 @@ inline __device__ FPType compute_pow_fingerprint(FPType base, FPType exponent) {
   return z;
 }
 
+// Lookup tables used by the functions above, built on the host
+
+inline void init_exp_lookup_table(FPType *table) {
+  table[0] = 1;
+  for (int i = 1; i < FP_Q; i++) {
+    table[i] = (table[i - 1] * FP_EXP_BASE) % FP_P;
+  }
+}
+
+// Multiplicative inverses modulo `modulus`, and 1 for 0
+inline void init_div_lookup_table(FPType *table, uint32_t modulus) {
+  for (uint32_t i = 0; i < modulus; i++) {
+    table[i] = 1;
+    for (uint32_t j = 1; j < modulus; j++) {
+      if ((i * j) % modulus == 1) {
+        table[i] = j;
+      }
+    }
+  }
+}
+
+// Solving the congruence b=x^2 mod p using the following formulas:
+// if p == 3 mod 4, then x = b^{(p+1)/4} is a solution
+inline void init_sqrt_lookup_table(FPType *table, uint32_t modulus) {
+  for (uint32_t i = 0; i < modulus; i++) {
+    table[i] = 1;
+    for (uint32_t j = 0; j < (modulus + 1) / 4; j++) {
+      table[i] = (table[i] * i) % modulus;
+    }
+  }
+}
+
 } // namespace utils
 } // namespace mirage
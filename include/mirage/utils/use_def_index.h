@@ -0,0 +1,126 @@
+/* Copyright 2023-2025 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "mirage/type.h"
+#include <cassert>
+#include <unordered_map>
+#include <vector>
+
+namespace mirage {
+namespace utils {
+
+// Use-def information of a graph whose operators are appended and removed
+// in stack order, which is how both the frontend and the search build
+// kernel and threadblock graphs. Tensors are numbered by the order in which
+// they are produced, i.e., the order of walking all operators' outputs.
+template <typename OpType, typename TensorType>
+class UseDefIndex {
+public:
+  void add_operator(OpType *op) {
+    std::vector<int> indices;
+    for (TensorType const &tensor : op->input_tensors) {
+      indices.push_back(get_tensor_index(tensor.guid));
+      consumers[tensor.guid].push_back(op);
+    }
+    input_indices.push_back(indices);
+    for (size_t i = 0; i < op->output_tensors.size(); i++) {
+      definitions[op->output_tensors[i].guid].push_back(
+          Definition{op, static_cast<int>(i), num_tensors++});
+    }
+  }
+
+  // op must be the most recently added operator
+  void remove_operator(OpType *op) {
+    assert(!input_indices.empty());
+    for (int i = static_cast<int>(op->output_tensors.size()) - 1; i >= 0; i--) {
+      auto it = definitions.find(op->output_tensors[i].guid);
+      assert(it != definitions.end() && it->second.back().op == op);
+      it->second.pop_back();
+      if (it->second.empty()) {
+        definitions.erase(it);
+      }
+      num_tensors--;
+    }
+    for (int i = static_cast<int>(op->input_tensors.size()) - 1; i >= 0; i--) {
+      auto it = consumers.find(op->input_tensors[i].guid);
+      assert(it != consumers.end() && it->second.back() == op);
+      it->second.pop_back();
+      if (it->second.empty()) {
+        consumers.erase(it);
+      }
+    }
+    input_indices.pop_back();
+  }
+
+  int get_num_consumers(type::GuidType guid) const {
+    auto it = consumers.find(guid);
+    return it == consumers.end() ? 0 : static_cast<int>(it->second.size());
+  }
+
+  std::vector<OpType *> get_consumers(type::GuidType guid) const {
+    auto it = consumers.find(guid);
+    return it == consumers.end() ? std::vector<OpType *>() : it->second;
+  }
+
+  // Returns nullptr if the tensor is not produced in this graph. When a
+  // guid is produced more than once (in-place operators), the latest
+  // definition wins
+  OpType *get_producer(type::GuidType guid) const {
+    auto it = definitions.find(guid);
+    return it == definitions.end() ? nullptr : it->second.back().op;
+  }
+
+  TensorType const *get_tensor(type::GuidType guid) const {
+    auto it = definitions.find(guid);
+    if (it == definitions.end()) {
+      return nullptr;
+    }
+    Definition const &def = it->second.back();
+    return &def.op->output_tensors[def.output_idx];
+  }
+
+  // Position of the tensor among all produced tensors, -1 if not produced
+  int get_tensor_index(type::GuidType guid) const {
+    auto it = definitions.find(guid);
+    return it == definitions.end() ? -1 : it->second.back().tensor_idx;
+  }
+
+  // Positions of the op_idx-th operator's inputs, as computed when the
+  // operator was added
+  std::vector<int> const &get_input_indices(size_t op_idx) const {
+    assert(op_idx < input_indices.size());
+    return input_indices[op_idx];
+  }
+
+  int get_num_tensors() const {
+    return num_tensors;
+  }
+
+private:
+  struct Definition {
+    OpType *op;
+    int output_idx;
+    int tensor_idx;
+  };
+  std::unordered_map<type::GuidType, std::vector<Definition>> definitions;
+  std::unordered_map<type::GuidType, std::vector<OpType *>> consumers;
+  std::vector<std::vector<int>> input_indices;
+  int num_tensors = 0;
+};
+
+} // namespace utils
+} // namespace mirage
@@ -16,7 +16,9 @@
 from libcpp.memory cimport shared_ptr
 from libcpp.string cimport string
 from libcpp.vector cimport vector
+from libcpp.map cimport map
 from libcpp cimport bool
+from libc.stdint cimport uint64_t
 
 ctypedef unsigned long int size_t
 
@@ -181,6 +183,60 @@ cdef extern from "mirage/kernel/runtime.h" namespace "mirage::runtime":
     ctypedef struct TaskGraphResult:
         string cuda_code
         string json_file
+        string binary_file
+    cdef string task_graph_json_to_binary_str "mirage::runtime::task_graph_json_to_binary"(
+        const string &json_task_graph) except +
+    cdef string task_graph_binary_to_json_str "mirage::runtime::task_graph_binary_to_json"(
+        const string &binary_task_graph) except +
+
+cdef extern from "mirage/kernel/runtime_simulator.h" namespace "mirage::runtime":
+    cdef cppclass SimulatorConfig:
+        int num_workers
+        int num_local_schedulers
+        unsigned long long int per_worker_queue_len
+        unsigned long long int per_sched_queue_len
+        int num_iterations
+        map[int, float] task_latency_us
+        float default_task_latency_us
+        float task_fetch_latency_us
+        float event_latency_us
+        float sched_event_latency_us
+        float sched_dispatch_latency_us
+    cdef cppclass SimulationResult:
+        bool completed
+        float makespan_us
+        size_t num_executed_tasks
+        vector[float] worker_busy_us
+        vector[float] worker_utilization
+        vector[size_t] worker_queue_depth_histogram
+        vector[size_t] sched_queue_depth_histogram
+        size_t worker_queue_overflows
+        size_t sched_queue_overflows
+        float critical_path_busy_us
+        string to_string()
+    cdef SimulationResult simulate_task_graph_json "mirage::runtime::simulate_task_graph"(
+        const string &json_task_graph, const SimulatorConfig &config)
+    cdef string order_task_graph_json "mirage::runtime::order_task_graph"(
+        const string &json_task_graph, const SimulatorConfig &config) except +
+    cdef map[int, float] get_task_latencies_from_profiler_buffer "mirage::runtime::get_task_latencies_from_profiler"(
+        const uint64_t *buffer, size_t num_entries)
+
+cdef extern from "mirage/kernel/task_graph_verifier.h" namespace "mirage::runtime":
+    cdef cppclass TaskGraphRace:
+        unsigned long long first_task, second_task
+        string tensor
+        bool first_writes, second_writes
+        bool across_iterations
+    cdef cppclass TaskGraphVerification:
+        vector[TaskGraphRace] races
+        vector[size_t] miscounted_events
+        vector[unsigned long long] deadlocked_tasks
+        bool ok()
+        string to_string()
+    cdef TaskGraphVerification verify_task_graph_json "mirage::runtime::verify_task_graph"(
+        const string &json_task_graph, int num_workers) except +
+    cdef string pipeline_task_graph_json "mirage::runtime::pipeline_task_graph"(
+        const string &json_task_graph) except +
 
 cdef extern from "mirage/kernel/graph.h" namespace "mirage::kernel":
 
@@ -240,7 +296,7 @@ cdef extern from "mirage/kernel/graph.h" namespace "mirage::kernel":
                                  const char *name)
         void register_task(const char *task_type,
                            vector[int] params)
-        TaskGraphResult generate_task_graph(int num_gpus, int my_gpu_id)
+        TaskGraphResult generate_task_graph(int num_gpus, int my_gpu_id, bool use_cpu_backend, bool verbose)
 
         vector[CppKNOperator*] operators
 
@@ -313,6 +369,19 @@ cdef extern from "mirage/threadblock/graph.h" namespace "mirage::threadblock":
         int reduction_dimx
         vector[CppTBOperator*] operators
 
+cdef extern from "mirage/cpu/interpreter.h" namespace "mirage::cpu":
+    cdef cppclass HostTensor:
+        vector[int] dims
+        DataType data_type
+    cdef HostTensor load_host_tensor(const void *ptr,
+                                     const vector[int] &dims,
+                                     DataType data_type)
+    cdef void store_host_tensor(const HostTensor &tensor, void *ptr)
+    cdef cppclass CppInterpreter "mirage::cpu::Interpreter":
+        CppInterpreter(int num_threads)
+        vector[HostTensor] run(const CppKNGraph &graph,
+                               const vector[HostTensor] &inputs) nogil
+
 cdef extern from "mirage/search/search_c.h" namespace "mirage::search_c":
     ctypedef struct MInt3:
         int x
@@ -334,7 +403,47 @@ cdef extern from "mirage/search/search_c.h" namespace "mirage::search_c":
                            vector[int] franges,
                            const char * filename,
                            bool verbose,
-                           const char * default_config)
+                           const char * default_config,
+                           const char * spool_dir,
+                           const char * metrics_prefix)
+
+    cdef cppclass StreamingSearch:
+        pass
+
+    cdef StreamingSearch *cython_start_search(const CppKNGraph *input_graph,
+                                              vector[MInt3] imaps,
+                                              vector[MInt3] omaps,
+                                              vector[MDim3] griddims,
+                                              vector[MDim3] blockdims,
+                                              vector[int] fmaps,
+                                              vector[int] franges,
+                                              const char * filename,
+                                              bool verbose,
+                                              const char * default_config,
+                                              const char * spool_dir,
+                                              const char * metrics_prefix)
+    cdef int cython_next_searched_graph(StreamingSearch *s,
+                                        int timeout_ms,
+                                        CppKNGraph** new_graph) nogil
+    cdef void cython_stop_search(StreamingSearch *s)
+    cdef void cython_pause_search(StreamingSearch *s) nogil
+    cdef void cython_resume_search(StreamingSearch *s)
+    cdef void cython_finish_search(StreamingSearch *s) nogil
+
+    cdef string cython_estimate_search(const CppKNGraph *input_graph,
+                                       vector[MInt3] imaps,
+                                       vector[MInt3] omaps,
+                                       vector[MDim3] griddims,
+                                       vector[int] fmaps,
+                                       vector[int] franges,
+                                       const char * default_config,
+                                       int num_probes,
+                                       unsigned int seed,
+                                       int search_thread)
+
+    cdef string cython_get_search_metrics()
+
+    cdef void cython_search_worker(const char * spool_dir)
     
     cdef void cython_to_json(const CppKNGraph *input_graph,
                              const char *filename)
@@ -348,6 +457,8 @@ cdef extern from "mirage/transpiler/transpile.h" namespace "mirage::transpiler":
         int pipeline_stages;
         bool profiling;
         bool enable_online_softmax;
+        bool enable_cuda_graph;
+        bool enable_kn_fusion;
     ctypedef struct OutputTensorDirective:
         size_t alloc_size
         vector[int] shape
@@ -358,10 +469,19 @@ cdef extern from "mirage/transpiler/transpile.h" namespace "mirage::transpiler":
         size_t max_smem_size
         size_t profiler_buf_size
         vector[OutputTensorDirective] output_directives
+        string kn_fusion_report
     cdef TranspileResult transpile(const CppKNGraph *graph,
                        const TranspilerConfig config,
                        vector[vector[size_t]] input_strides)
 
+cdef extern from "mirage/transpiler/autotune.h" namespace "mirage::transpiler":
+    cdef cppclass Autotuner:
+        Autotuner(const string &table_path)
+        TranspilerConfig tune(const CppKNGraph *graph,
+                              const TranspilerConfig &base_config,
+                              vector[vector[size_t]] input_strides)
+    cdef size_t cpp_get_shared_memory_capacity "mirage::transpiler::get_shared_memory_capacity"(int target_cc)
+
 cdef extern from "mirage/nki_transpiler/transpile.h" namespace "mirage::nki_transpiler":
     ctypedef struct NKITranspilerConfig:
         int target_cc
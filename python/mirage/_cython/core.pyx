@@ -16,10 +16,12 @@
 from CCore cimport *
 from cpython cimport array
 import ctypes
+import json
 import array
 import numpy as np
 import torch
 from libcpp.string cimport string
+from cpython.exc cimport PyErr_CheckSignals
 
 # Code snippet from OpenAI Triton
 
@@ -932,11 +934,12 @@ cdef class CyKNGraph:
                 cparams[i] = params[i]
         self.p_kgraph.register_task(cname, cparams)
 
-    def generate_task_graph(self, int num_gpus, int my_gpu_id):
-        cdef TaskGraphResult result = self.p_kgraph.generate_task_graph(num_gpus, my_gpu_id)
+    def generate_task_graph(self, int num_gpus, int my_gpu_id, bool use_cpu_backend = False, bool verbose = False):
+        cdef TaskGraphResult result = self.p_kgraph.generate_task_graph(num_gpus, my_gpu_id, use_cpu_backend, verbose)
         return {
             "cuda_code": result.cuda_code.decode("UTF-8"),
             "json_file": result.json_file.decode("UTF-8"),
+            "binary_file": <bytes> result.binary_file,
         }
      
 
@@ -1085,58 +1088,107 @@ cdef class CyTBGraph:
                 operators.append(CyTBOperator(ptr))
             return operators
 
-def search(CyKNGraph input_graph, *, int max_num_new_graphs = 1024, list imaps = None, list omaps = None, list griddims = None, list blockdims = None, list fmaps = None, list franges = None, str previous_checkpoint = None, bool verbose, str default_config = None):
-    # set cimaps
-    cdef vector[MInt3] cimaps
-    cimaps.resize(0)
-    if imaps is not None:
-        cimaps.resize(len(imaps))
-        for i in range(len(imaps)):
-            assert type(imaps[i]) is tuple, "Each imap must be a tuple of 3 integers"
-            assert len(imaps[i]) == 3, "Each imap must be a tuple of 3 integers"
-            cimaps[i].x = imaps[i][0]
-            cimaps[i].y = imaps[i][1]
-            cimaps[i].z = imaps[i][2]
-    #set comaps
-    cdef vector[MInt3] comaps
-    comaps.resize(0)
-    if omaps is not None:
-        comaps.resize(len(omaps))
-        for i in range(len(omaps)):
-            assert type(omaps[i]) is tuple, "Each omap must be a tuple of 3 integers"
-            assert len(omaps[i]) == 3, "Each omap must be a tuple of 3 integers"
-            comaps[i].x = omaps[i][0]
-            comaps[i].y = omaps[i][1]
-            comaps[i].z = omaps[i][2]
-    # set griddims
-    cdef vector[MDim3] cgriddims
-    cgriddims.resize(0)
-    if griddims is not None:
-        cgriddims.resize(len(griddims))
-        for i in range(len(griddims)):
-            assert type(griddims[i]) is tuple, "Each griddim must be a tuple of 3 integers"
-            assert len(griddims[i]) == 3, "Each griddim must be a tuple of 3 integers"
-            cgriddims[i].x = griddims[i][0]
-            cgriddims[i].y = griddims[i][1]
-            cgriddims[i].z = griddims[i][2]
+cdef vector[MInt3] convert_int3_list(list maps, str name):
+    cdef vector[MInt3] cmaps
+    cmaps.resize(0)
+    if maps is not None:
+        cmaps.resize(len(maps))
+        for i in range(len(maps)):
+            assert type(maps[i]) is tuple, "Each {} must be a tuple of 3 integers".format(name)
+            assert len(maps[i]) == 3, "Each {} must be a tuple of 3 integers".format(name)
+            cmaps[i].x = maps[i][0]
+            cmaps[i].y = maps[i][1]
+            cmaps[i].z = maps[i][2]
+    return cmaps
+
+cdef vector[MDim3] convert_dim3_list(list dims, str name):
+    cdef vector[MDim3] cdims
+    cdims.resize(0)
+    if dims is not None:
+        cdims.resize(len(dims))
+        for i in range(len(dims)):
+            assert type(dims[i]) is tuple, "Each {} must be a tuple of 3 integers".format(name)
+            assert len(dims[i]) == 3, "Each {} must be a tuple of 3 integers".format(name)
+            cdims[i].x = dims[i][0]
+            cdims[i].y = dims[i][1]
+            cdims[i].z = dims[i][2]
+    return cdims
+
+cdef vector[int] convert_int_list(list values):
+    cdef vector[int] cvalues
+    cvalues.resize(0)
+    if values is not None:
+        cvalues.resize(len(values))
+        for i in range(len(values)):
+            cvalues[i] = values[i]
+    return cvalues
+
+# Iterates over the muGraphs of a search running on a background thread as
+# they are verified; returned by search(..., stream=True)
+cdef class SearchStream:
+    cdef StreamingSearch *p_search
+
+    def __cinit__(self):
+        self.p_search = NULL
+
+    def __iter__(self):
+        return self
+
+    def __next__(self):
+        cdef CppKNGraph* cnewgraph = NULL
+        cdef int status = 0
+        if self.p_search == NULL:
+            raise StopIteration
+        # Wait in short slices without the GIL, so that other Python threads
+        # keep running and KeyboardInterrupt is still delivered
+        while status == 0:
+            with nogil:
+                status = cython_next_searched_graph(self.p_search, 100, &cnewgraph)
+            if status == 0:
+                PyErr_CheckSignals()
+        if status < 0:
+            self.close()
+            raise StopIteration
+        ptr = ctypes.cast(<unsigned long long>cnewgraph, ctypes.c_void_p)
+        return CyKNGraph(ptr)
+
+    # Stops the search early; muGraphs already found are still returned
+    def stop(self):
+        if self.p_search != NULL:
+            cython_stop_search(self.p_search)
+
+    # Keeps the search off the GPU, e.g. while profiling a muGraph, until
+    # resume(); waits for the verifications in progress
+    def pause(self):
+        if self.p_search != NULL:
+            with nogil:
+                cython_pause_search(self.p_search)
+
+    def resume(self):
+        if self.p_search != NULL:
+            cython_resume_search(self.p_search)
+
+    # Stops the search and waits for it to finish
+    def close(self):
+        if self.p_search != NULL:
+            cython_stop_search(self.p_search)
+            with nogil:
+                cython_finish_search(self.p_search)
+            self.p_search = NULL
+
+    def __dealloc__(self):
+        self.close()
+
+def search(CyKNGraph input_graph, *, int max_num_new_graphs = 1024, list imaps = None, list omaps = None, list griddims = None, list blockdims = None, list fmaps = None, list franges = None, str previous_checkpoint = None, bool verbose, str default_config = None, str spool_dir = None, str metrics_prefix = None, bool stream = False):
+    cdef vector[MInt3] cimaps = convert_int3_list(imaps, "imap")
+    cdef vector[MInt3] comaps = convert_int3_list(omaps, "omap")
+    cdef vector[MDim3] cgriddims = convert_dim3_list(griddims, "griddim")
     # set blockdims
     assert blockdims is None, "TODO: support blockdims"
     cdef vector[MDim3] cblockdims
     cblockdims.resize(0)
-    # set fmaps
-    cdef vector[int] cfmaps
-    cfmaps.resize(0)
-    if fmaps is not None:
-        cfmaps.resize(len(fmaps))
-        for i in range(len(fmaps)):
-            cfmaps[i] = fmaps[i]
-    #set franges
-    cdef vector[int] cfranges
-    cfranges.resize(0)
-    if franges is not None:
-        cfranges.resize(len(franges))
-        for i in range(len(franges)):
-            cfranges[i] = franges[i]
+    cdef vector[int] cfmaps = convert_int_list(fmaps)
+    cdef vector[int] cfranges = convert_int_list(franges)
     # allocate new graphs
     # currently support up to 1024 new graphs
     assert max_num_new_graphs <= 1024
@@ -1153,7 +1205,22 @@ def search(CyKNGraph input_graph, *, int max_num_new_graphs = 1024, list imaps =
     if default_config is not None:
         py_byte_string = default_config.encode('UTF-8')
         cconfig = py_byte_string
-    num = cython_search(input_graph.p_kgraph, max_num_new_graphs, cnewgraphs, cimaps, comaps, cgriddims, cblockdims, cfmaps, cfranges, cprevious_checkpoint, cverbose, cconfig)
+    # set spool_dir for a distributed search
+    cdef char* cspool_dir = NULL
+    if spool_dir is not None:
+        py_spool_dir = spool_dir.encode('UTF-8')
+        cspool_dir = py_spool_dir
+    # set metrics_prefix to periodically export search metrics
+    cdef char* cmetrics_prefix = NULL
+    if metrics_prefix is not None:
+        py_metrics_prefix = metrics_prefix.encode('UTF-8')
+        cmetrics_prefix = py_metrics_prefix
+    cdef SearchStream search_stream
+    if stream:
+        search_stream = SearchStream()
+        search_stream.p_search = cython_start_search(input_graph.p_kgraph, cimaps, comaps, cgriddims, cblockdims, cfmaps, cfranges, cprevious_checkpoint, cverbose, cconfig, cspool_dir, cmetrics_prefix)
+        return search_stream
+    num = cython_search(input_graph.p_kgraph, max_num_new_graphs, cnewgraphs, cimaps, comaps, cgriddims, cblockdims, cfmaps, cfranges, cprevious_checkpoint, cverbose, cconfig, cspool_dir, cmetrics_prefix)
     new_graphs = list()
     for i in range(num):
         ptr = ctypes.cast(<unsigned long long>cnewgraphs[i], ctypes.c_void_p)
@@ -1161,14 +1228,68 @@ def search(CyKNGraph input_graph, *, int max_num_new_graphs = 1024, list imaps =
 
     return new_graphs
 
+# Run a muGraph on the host with the reference interpreter. inputs are torch
+# tensors matched with the graph's inputs in order; returns one CPU tensor per
+# output of the graph
+def interpret(CyKNGraph input_graph, list inputs, *, int num_threads = 0) -> list:
+    cdef vector[HostTensor] cinputs
+    cdef vector[int] cdims
+    cdef unsigned long long ptr
+    for x in inputs:
+        x = x.detach().cpu().contiguous()
+        cdims = list(x.shape)
+        ptr = x.data_ptr()
+        cinputs.push_back(load_host_tensor(<void*>ptr, cdims, convert_dtype_to_ctype(convert_torch_type_to_dtype(x.dtype))))
+    cdef CppInterpreter *interpreter = new CppInterpreter(num_threads)
+    cdef vector[HostTensor] coutputs
+    with nogil:
+        coutputs = interpreter.run(input_graph.p_kgraph[0], cinputs)
+    del interpreter
+    outputs = list()
+    for i in range(coutputs.size()):
+        y = torch.empty(list(coutputs[i].dims), dtype=convert_dtype_to_torch_type(convert_ctype_to_dtype(coutputs[i].data_type)))
+        ptr = y.data_ptr()
+        store_host_tensor(coutputs[i], <void*>ptr)
+        outputs.append(y)
+    return outputs
+
+# Dry run of search() with the same search space: estimates the number of
+# states and verifications of the search from num_probes random probes and
+# predicts its wall time with search_thread threads, as a dict
+def estimate_search(CyKNGraph input_graph, *, list imaps = None, list omaps = None, list griddims = None, list fmaps = None, list franges = None, str default_config = None, int num_probes = 256, unsigned int seed = 0, int search_thread = 0) -> dict:
+    cdef vector[MInt3] cimaps = convert_int3_list(imaps, "imap")
+    cdef vector[MInt3] comaps = convert_int3_list(omaps, "omap")
+    cdef vector[MDim3] cgriddims = convert_dim3_list(griddims, "griddim")
+    cdef vector[int] cfmaps = convert_int_list(fmaps)
+    cdef vector[int] cfranges = convert_int_list(franges)
+    cdef char* cconfig = NULL
+    if default_config is not None:
+        py_byte_string = default_config.encode('UTF-8')
+        cconfig = py_byte_string
+    estimate = cython_estimate_search(input_graph.p_kgraph, cimaps, comaps, cgriddims, cfmaps, cfranges, cconfig, num_probes, seed, search_thread)
+    return json.loads(estimate.decode('UTF-8'))
+
+# Per-stage timers, per-op and per-depth counters and cache hit rates of the
+# most recent search, as a dict
+def get_search_metrics() -> dict:
+    return json.loads(cython_get_search_metrics().decode('UTF-8'))
+
+# Process work units of a distributed search until its coordinator finishes
+def search_worker(str spool_dir):
+    py_spool_dir = spool_dir.encode('UTF-8')
+    cdef char* cspool_dir = py_spool_dir
+    cython_search_worker(cspool_dir)
+
 # Generate CUDA program for a uGraph
 # Return (CUDA code, buffer size in bytes)
-def generate_cuda_program(CyKNGraph input_graph, *, int target_cc, list input_strides, int num_warp_groups = -1, int pipeline_stages = -1, bool profiling = False, bool enable_online_softmax = False) -> dict:
+def generate_cuda_program(CyKNGraph input_graph, *, int target_cc, list input_strides, int num_warp_groups = -1, int pipeline_stages = -1, bool profiling = False, bool enable_online_softmax = False, bool enable_cuda_graph = False, bool enable_kn_fusion = False) -> dict:
     # Set transpiler_config
     cdef TranspilerConfig transpiler_config
     transpiler_config.target_cc = target_cc
     transpiler_config.profiling = profiling
     transpiler_config.enable_online_softmax = enable_online_softmax
+    transpiler_config.enable_cuda_graph = enable_cuda_graph
+    transpiler_config.enable_kn_fusion = enable_kn_fusion
 
     if num_warp_groups != -1 and pipeline_stages != -1:
         transpiler_config.num_producer_wgs = 1;
@@ -1208,9 +1329,142 @@ def generate_cuda_program(CyKNGraph input_graph, *, int target_cc, list input_st
         "buf_size": result.buf_size,
         "max_smem_size": result.max_smem_size,
         "profiler_buf_size": result.profiler_buf_size,
-        "output_directives": output_directives
+        "output_directives": output_directives,
+        "kn_fusion_report": result.kn_fusion_report.decode("UTF-8")
     }
 
+# Shared memory capacity per thread block, in bytes
+def get_shared_memory_capacity(int target_cc) -> int:
+    return cpp_get_shared_memory_capacity(target_cc)
+
+# Pick num_warp_groups, pipeline_stages and enable_online_softmax for a uGraph
+# The best config per (graph hash, target_cc, input strides) is cached in
+# table_path
+def autotune_cuda_program(CyKNGraph input_graph, *, int target_cc, list input_strides, str table_path = "") -> dict:
+    cdef TranspilerConfig transpiler_config
+    transpiler_config.target_cc = target_cc
+    transpiler_config.profiling = False
+    transpiler_config.enable_online_softmax = False
+    transpiler_config.enable_cuda_graph = False
+    transpiler_config.enable_kn_fusion = False
+    transpiler_config.num_producer_wgs = 1
+    transpiler_config.num_consumer_wgs = 1
+    transpiler_config.pipeline_stages = 2
+
+    cdef vector[vector[size_t]] cinput_strides
+    cinput_strides.resize(len(input_strides))
+    for i in range(len(input_strides)):
+        cinput_strides[i].resize(len(input_strides[i]))
+        for j in range(len(input_strides[i])):
+            cinput_strides[i][j] = input_strides[i][j]
+
+    cdef Autotuner *tuner = new Autotuner(table_path.encode("UTF-8"))
+    cdef TranspilerConfig best = tuner.tune(input_graph.p_kgraph, transpiler_config, cinput_strides)
+    del tuner
+    return {
+        "num_warp_groups": best.num_consumer_wgs + best.num_producer_wgs,
+        "pipeline_stages": best.pipeline_stages,
+        "enable_online_softmax": best.enable_online_softmax,
+    }
+
+# Replay a task graph (the json_file of generate_task_graph) through a
+# discrete-event model of the persistent kernel's workers and schedulers
+def simulate_task_graph(str json_file, *, int num_workers, int num_local_schedulers,
+                        int num_iterations = 1, dict task_latency_us = None,
+                        float default_task_latency_us = 10.0,
+                        float task_fetch_latency_us = 0.5,
+                        float event_latency_us = 0.5,
+                        float sched_event_latency_us = 0.5,
+                        float sched_dispatch_latency_us = 0.1,
+                        int per_worker_queue_len = 1024,
+                        int per_sched_queue_len = 1024) -> dict:
+    cdef SimulatorConfig config
+    config.num_workers = num_workers
+    config.num_local_schedulers = num_local_schedulers
+    config.num_iterations = num_iterations
+    config.default_task_latency_us = default_task_latency_us
+    config.task_fetch_latency_us = task_fetch_latency_us
+    config.event_latency_us = event_latency_us
+    config.sched_event_latency_us = sched_event_latency_us
+    config.sched_dispatch_latency_us = sched_dispatch_latency_us
+    config.per_worker_queue_len = per_worker_queue_len
+    config.per_sched_queue_len = per_sched_queue_len
+    if task_latency_us is not None:
+        for task_type, latency in task_latency_us.items():
+            config.task_latency_us[task_type] = latency
+
+    cdef SimulationResult result = simulate_task_graph_json(json_file.encode("UTF-8"), config)
+    return {
+        "completed": result.completed,
+        "makespan_us": result.makespan_us,
+        "num_executed_tasks": result.num_executed_tasks,
+        "worker_busy_us": result.worker_busy_us,
+        "worker_utilization": result.worker_utilization,
+        "worker_queue_depth_histogram": result.worker_queue_depth_histogram,
+        "sched_queue_depth_histogram": result.sched_queue_depth_histogram,
+        "worker_queue_overflows": result.worker_queue_overflows,
+        "sched_queue_overflows": result.sched_queue_overflows,
+        "critical_path_busy_us": result.critical_path_busy_us,
+        "report": result.to_string().decode("UTF-8"),
+    }
+
+# Reorder the prelaunched tasks of a task graph (the json_file of
+# generate_task_graph) by list scheduling on upward ranks for num_workers
+# workers, using the same latency model as simulate_task_graph
+def order_task_graph(str json_file, *, int num_workers, dict task_latency_us = None,
+                     float default_task_latency_us = 10.0) -> str:
+    cdef SimulatorConfig config
+    config.num_workers = num_workers
+    config.default_task_latency_us = default_task_latency_us
+    if task_latency_us is not None:
+        for task_type, latency in task_latency_us.items():
+            config.task_latency_us[task_type] = latency
+    return order_task_graph_json(json_file.encode("UTF-8"), config).decode("UTF-8")
+
+# Statically check a task graph (the json_file of generate_task_graph) for
+# unordered overlapping tensor accesses and for deadlocks on num_workers
+# workers
+def verify_task_graph(str json_file, *, int num_workers) -> dict:
+    cdef TaskGraphVerification result = verify_task_graph_json(json_file.encode("UTF-8"), num_workers)
+    races = []
+    for race in result.races:
+        races.append({
+            "first_task": race.first_task,
+            "second_task": race.second_task,
+            "tensor": race.tensor.decode("UTF-8"),
+            "first_writes": race.first_writes,
+            "second_writes": race.second_writes,
+            "across_iterations": race.across_iterations,
+        })
+    return {
+        "ok": result.ok(),
+        "races": races,
+        "miscounted_events": result.miscounted_events,
+        "deadlocked_tasks": result.deadlocked_tasks,
+        "report": result.to_string().decode("UTF-8"),
+    }
+
+# Let the weight-only tasks of a task graph (the json_file of
+# generate_task_graph) start during the previous iteration, once the tasks
+# accessing the tensors they write have run
+def pipeline_task_graph(str json_file) -> str:
+    return pipeline_task_graph_json(json_file.encode("UTF-8")).decode("UTF-8")
+
+# Convert a task graph between its JSON form (the json_file of
+# generate_task_graph) and the binary file loaded by the generated code
+def task_graph_json_to_binary(str json_file) -> bytes:
+    return task_graph_json_to_binary_str(json_file.encode("UTF-8"))
+
+def task_graph_binary_to_json(bytes binary_file) -> str:
+    return task_graph_binary_to_json_str(binary_file).decode("UTF-8")
+
+# Average latency per task type, in microseconds, from a persistent kernel
+# profiler buffer (a uint64 tensor)
+def get_task_latencies_from_profiler(profiler_tensor) -> dict:
+    buffer = profiler_tensor.cpu().contiguous()
+    cdef unsigned long long buffer_ptr = buffer.data_ptr()
+    return get_task_latencies_from_profiler_buffer(<const uint64_t *> buffer_ptr, buffer.numel())
+
 def generate_nki_program(CyKNGraph input_graph, *, int target_cc) -> dict:
     # Set transpiler_config
     cdef NKITranspilerConfig transpiler_config
@@ -1,4 +1,5 @@
 import torch
+import multiprocessing
 
 import os
 import tempfile
@@ -194,6 +195,9 @@ class Handle:
         if self.remain_op:
             self.remain_op()
 
+    def done(self):
+        return all(handle.poll() is not None for handle in self.handles)
+
 
 class KNGraph:
     def __init__(self, graph):
@@ -417,6 +421,21 @@ class KNGraph:
         # TODO, add profling for Ampere later to show gpu wave
         profiling = kwargs.get("profiling", False)
         enable_online_softmax = kwargs.get("enable_online_softmax", False)
+        if kwargs.get("autotune", False):
+            # Explicitly passed knobs take precedence over tuned ones
+            tuned = autotune_cuda_program(
+                self.cygraph,
+                target_cc=target_cc,
+                input_strides=input_strides,
+                table_path=kwargs.get("autotune_table", ""),
+            )
+            num_warp_groups = kwargs.get("num_warp_groups", tuned["num_warp_groups"])
+            pipeline_stages = kwargs.get("pipeline_stages", tuned["pipeline_stages"])
+            enable_online_softmax = kwargs.get(
+                "enable_online_softmax", tuned["enable_online_softmax"]
+            )
+        enable_cuda_graph = kwargs.get("enable_cuda_graph", False)
+        enable_kn_fusion = kwargs.get("enable_kn_fusion", False)
 
         result = generate_cuda_program(
             self.cygraph,
@@ -426,6 +445,8 @@ class KNGraph:
             pipeline_stages=pipeline_stages,
             profiling=profiling,
             enable_online_softmax=enable_online_softmax,
+            enable_cuda_graph=enable_cuda_graph,
+            enable_kn_fusion=enable_kn_fusion,
         )
         if result["max_smem_size"] > get_shared_memory_capacity(target_cc):
             # the transpiled kernel exceeds shared memory limit
@@ -530,6 +551,39 @@ class KNGraph:
 
         # so_path = './test.cpython-38-x86_64-linux-gnu.so'
 
+    # Runs the muGraph on the host with the reference interpreter, e.g. to
+    # check its results without a GPU. Returns CPU tensors
+    def interpret(self, inputs: list, num_threads: int = 0):
+        return interpret(self.cygraph, inputs, num_threads=num_threads)
+
+    # Dry run of superoptimize's search: estimates how many states and
+    # verifications it would take and how long it would run with
+    # search_thread threads, so that a config can be tuned beforehand
+    def estimate_search(
+        self,
+        imaps: list = None,
+        omaps: list = None,
+        griddims: list = None,
+        fmaps: list = None,
+        franges: list = None,
+        config: str = None,
+        num_probes: int = 256,
+        seed: int = 0,
+        search_thread: int = 0,
+    ):
+        return estimate_search(
+            self.cygraph,
+            imaps=imaps,
+            omaps=omaps,
+            griddims=griddims,
+            fmaps=fmaps,
+            franges=franges,
+            default_config=config,
+            num_probes=num_probes,
+            seed=seed,
+            search_thread=search_thread,
+        )
+
     def superoptimize(
         self,
         imaps: list = None,
@@ -546,6 +600,10 @@ class KNGraph:
         use_graph_dataset: bool = True,
         use_cached_graphs: bool = True,
         save_codes: bool = False,
+        num_search_workers: int = 0,
+        spool_dir: str = None,
+        metrics_prefix: str = None,
+        target_latency: float = None,
     ):
         if use_graph_dataset:
             cached_graph = graph_dataset.find(
@@ -566,7 +624,21 @@ class KNGraph:
             )
         else:
             previous_checkpoint = None
-        cygraphs = search(
+        # A distributed search runs its work units in separate worker
+        # processes; more workers can join from other hosts sharing
+        # spool_dir through mirage.core.search_worker(spool_dir)
+        workers = []
+        if num_search_workers > 0 and spool_dir is None:
+            spool_dir = tempfile.mkdtemp(prefix="mirage_search_")
+        if spool_dir is not None:
+            ctx = multiprocessing.get_context("spawn")
+            for _ in range(num_search_workers):
+                worker = ctx.Process(target=search_worker, args=(spool_dir,))
+                worker.start()
+                workers.append(worker)
+        # muGraphs are streamed from the search as they are verified, so
+        # that they are compiled and profiled while the search goes on
+        stream = search(
             self.cygraph,
             imaps=imaps,
             omaps=omaps,
@@ -577,14 +649,29 @@ class KNGraph:
             previous_checkpoint=previous_checkpoint,
             verbose=verbose,
             default_config=config,
+            spool_dir=spool_dir,
+            metrics_prefix=metrics_prefix,
+            stream=True,
         )
-        all_graphs = [KNGraph(g) for g in cygraphs]
-        print("Finished search, discovering {} mugraphs ...".format(len(all_graphs)))
+
+        def finish_search():
+            stream.close()
+            if spool_dir is not None:
+                # Also releases the workers when the search was served from
+                # previous_checkpoint and the coordinator never started
+                open(os.path.join(spool_dir, "finished"), "a").close()
+            for worker in workers:
+                worker.join()
+
         if backend == "cuda":
             # profile and use the best graph
             best_graph, best_perf = None, float("inf")
-            print("Transpiling {} muGraphs ...".format(len(all_graphs)))
+            all_graphs = list()
             handles = deque()
+            # muGraphs in discovery order, with their number of unfinished
+            # compilations
+            pending = deque()
+            num_unfinished = dict()
 
             target_cc = (
                 torch.cuda.get_device_properties(0).major * 10
@@ -593,61 +680,18 @@ class KNGraph:
             if target_cc >= 90:
                 pipeline_stages_list = [2, 3, 4]
                 num_warp_groups_list = [2, 3, 4]
-                for idx, g in enumerate(all_graphs):
-                    for pipeline_stages in pipeline_stages_list:
-                        for num_warp_groups in num_warp_groups_list:
-                            dtensors = g.cygraph.get_input_dtensors()
-                            input_tensors = list()
-                            for t in dtensors:
-                                dims, strides = (
-                                    g.cygraph.get_input_dtensor_shape_and_stride(t)
-                                )
-                                dtype = convert_dtype_to_torch_type(t.dtype)
-                                x = torch.randn(
-                                    dims,
-                                    dtype=dtype,
-                                    device="cuda:{}".format(
-                                        global_config.gpu_device_id
-                                    ),
-                                )
-                                x = torch.as_strided(x, size=dims, stride=strides)
-                                input_tensors.append(x)
-                            starter = torch.cuda.Event(enable_timing=True)
-                            ender = torch.cuda.Event(enable_timing=True)
-                            new_g = g
-                            if len(handles) == MAX_THREADS:
-                                handles.popleft().wait()
-                            handle = new_g.compile(
-                                async_=True,
-                                inputs=input_tensors,
-                                pipeline_stages=pipeline_stages,
-                                num_warp_groups=num_warp_groups,
-                            )
-                            handles.append(handle)
+                compile_options = [
+                    dict(
+                        pipeline_stages=pipeline_stages,
+                        num_warp_groups=num_warp_groups,
+                    )
+                    for pipeline_stages in pipeline_stages_list
+                    for num_warp_groups in num_warp_groups_list
+                ]
             else:
-                for idx, g in enumerate(all_graphs):
-                    dtensors = g.cygraph.get_input_dtensors()
-                    input_tensors = list()
-                    for t in dtensors:
-                        dims, strides = g.cygraph.get_input_dtensor_shape_and_stride(t)
-                        # dims = [t.dim(i) for i in range(t.num_dims)]
-                        dtype = convert_dtype_to_torch_type(t.dtype)
-                        x = torch.randn(
-                            dims,
-                            dtype=dtype,
-                            device="cuda:{}".format(global_config.gpu_device_id),
-                        )
-                        x = torch.as_strided(x, size=dims, stride=strides)
-                        input_tensors.append(x)
-                    starter = torch.cuda.Event(enable_timing=True)
-                    ender = torch.cuda.Event(enable_timing=True)
-                    if len(handles) == MAX_THREADS:
-                        handles.popleft().wait()
-                    handle = g.compile(async_=True, inputs=input_tensors)
-                    handles.append(handle)
-            while handles:
-                handles.popleft().wait()
-            for idx, g in enumerate(all_graphs):
+                compile_options = [dict()]
+
+            def get_input_tensors(g):
                 dtensors = g.cygraph.get_input_dtensors()
                 input_tensors = list()
                 for t in dtensors:
@@ -660,24 +704,80 @@ class KNGraph:
                     )
                     x = torch.as_strided(x, size=dims, stride=strides)
                     input_tensors.append(x)
-                starter = torch.cuda.Event(enable_timing=True)
-                ender = torch.cuda.Event(enable_timing=True)
+                return input_tensors
+
+            def profile(idx, g):
+                nonlocal best_graph, best_perf
                 if not g.valid_kernels():
                     print("muGraph {}: {}".format(idx, g.get_error_message()))
-                    continue
-                # Warmup runs
-                for _ in range(warmup_iters):
-                    g(inputs=input_tensors)
-                torch.cuda.synchronize()
-                starter.record()
-                for _ in range(profile_iters):
-                    g(inputs=input_tensors)
-                ender.record()
-                torch.cuda.synchronize()
+                    return
+                input_tensors = get_input_tensors(g)
+                starter = torch.cuda.Event(enable_timing=True)
+                ender = torch.cuda.Event(enable_timing=True)
+                # The search's GPU fingerprinting would skew the timings
+                stream.pause()
+                try:
+                    # Warmup runs
+                    for _ in range(warmup_iters):
+                        g(inputs=input_tensors)
+                    torch.cuda.synchronize()
+                    starter.record()
+                    for _ in range(profile_iters):
+                        g(inputs=input_tensors)
+                    ender.record()
+                    torch.cuda.synchronize()
+                finally:
+                    stream.resume()
                 perf = starter.elapsed_time(ender) / profile_iters
                 print("muGraph {}: profiled performance (ms) = {}".format(idx, perf))
                 if perf < best_perf:
                     best_graph, best_perf = g, perf
+
+            def wait_oldest_handle():
+                idx, handle = handles.popleft()
+                handle.wait()
+                num_unfinished[idx] -= 1
+
+            def profile_compiled_graphs():
+                # Compilations finish in any order; profile in discovery order
+                while handles and handles[0][1].done():
+                    wait_oldest_handle()
+                while pending and num_unfinished[pending[0]] == 0:
+                    idx = pending.popleft()
+                    profile(idx, all_graphs[idx])
+
+            def reached_target_latency():
+                return target_latency is not None and best_perf <= target_latency
+
+            print("Transpiling and profiling muGraphs while searching ...")
+            for cygraph in stream:
+                g = KNGraph(cygraph)
+                idx = len(all_graphs)
+                all_graphs.append(g)
+                pending.append(idx)
+                num_unfinished[idx] = len(compile_options)
+                input_tensors = get_input_tensors(g)
+                for options in compile_options:
+                    if len(handles) == MAX_THREADS:
+                        wait_oldest_handle()
+                        profile_compiled_graphs()
+                    handle = g.compile(async_=True, inputs=input_tensors, **options)
+                    handles.append((idx, handle))
+                profile_compiled_graphs()
+                if reached_target_latency():
+                    print(
+                        "Found a muGraph within the target latency ({} ms), "
+                        "stopping the search".format(target_latency)
+                    )
+                    stream.stop()
+                    break
+            finish_search()
+            while handles:
+                wait_oldest_handle()
+                profile_compiled_graphs()
+            print(
+                "Finished search, discovering {} mugraphs ...".format(len(all_graphs))
+            )
             best_graph.backend = "cuda"
             if use_graph_dataset:
                 graph_dataset.store(
@@ -692,7 +792,11 @@ class KNGraph:
                     backend=backend,
                 )
             return best_graph
-        elif backend == "nki":
+
+        all_graphs = [KNGraph(g) for g in stream]
+        finish_search()
+        print("Finished search, discovering {} mugraphs ...".format(len(all_graphs)))
+        if backend == "nki":
             return all_graphs
         elif backend == "triton":
             from .triton_profiler import profile_and_select_best_graph
@@ -778,5 +882,13 @@ class KNGraph:
     def register_task(self, bgraph: TBGraph, task_type: str, params: list[int] = None):
         return self.cygraph.register_task(bgraph.cygraph, task_type, params)
 
-    def generate_task_graph(self, num_gpus: int, my_gpu_id: int):
-        return self.cygraph.generate_task_graph(num_gpus, my_gpu_id)
+    def generate_task_graph(
+        self,
+        num_gpus: int,
+        my_gpu_id: int,
+        use_cpu_backend: bool = False,
+        verbose: bool = False,
+    ):
+        return self.cygraph.generate_task_graph(
+            num_gpus, my_gpu_id, use_cpu_backend, verbose
+        )
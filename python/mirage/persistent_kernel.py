@@ -11,7 +11,6 @@ from .kernel import get_key_paths, KNGraph, TBGraph
 
 HARD_CODE = """
 #include <Python.h>
-#include <cuda_runtime.h>
 
 static PyObject *init_func(PyObject *self, PyObject *args) {
   PyObject *meta_list, *py_profiler_buffer;
@@ -148,6 +147,32 @@ def get_compile_command(
     return common_cmd + specific_cmd + flags
 
 
+def get_cpu_compile_command(
+    cc,
+    file_name,
+    py_include_dir,
+    mirage_home_path,
+    mirage_inc_path,
+    py_so_path,
+):
+    return [
+        cc,
+        file_name,
+        "-O3",
+        "-march=native",
+        f"-I{py_include_dir}",
+        f"-I{mirage_inc_path}",
+        f"-I{os.path.join(mirage_inc_path, 'mirage/persistent_kernel')}",
+        f"-I{os.path.join(mirage_home_path, 'deps/json/include')}",
+        "-shared",
+        "-std=c++17",
+        "-fPIC",
+        "-pthread",
+        "-o",
+        py_so_path,
+    ]
+
+
 class PersistentKernel:
     def __init__(
         self,
@@ -160,7 +185,17 @@ class PersistentKernel:
         eos_token_id: int64,
         meta_tensors: list[torch.Tensor],
         profiler_tensor: torch.Tensor,
+        backend: str = "cuda",
+        order_tasks: bool = True,
+        pipeline_iterations: bool = True,
     ):
+        # backend="cpu" runs workers and schedulers as host threads, with
+        # meta_tensors and all attached tensors in host memory
+        # order_tasks reorders the prelaunched tasks by upward rank (see
+        # order_task_graph); otherwise they run in operator order
+        # pipeline_iterations lets weight-only tasks overlap with the tail of
+        # the previous iteration (see pipeline_task_graph)
+        assert backend in ["cuda", "cpu"]
         self.__finalized__ = False
         self._is_compiled = False
         self.world_size = world_size
@@ -174,6 +209,13 @@ class PersistentKernel:
         self.meta_tensors = meta_tensors
         self.profiler_tensor = profiler_tensor
         self.use_nvshmem = True if world_size > 1 else False
+        self.backend = backend
+        self.order_tasks = order_tasks
+        self.pipeline_iterations = pipeline_iterations
+        if backend == "cpu":
+            assert world_size == 1, "The CPU backend runs on a single node"
+            # The profiler relies on GPU clocks
+            self.profiler_tensor = None
 
     def attach_input(self, torch_tensor: torch.Tensor, name: str = None) -> DTensor:
         dims = tuple([d for d in torch_tensor.shape])
@@ -439,6 +481,47 @@ class PersistentKernel:
             tb_graph, "argmax_reduce", [self.argmax_partial_output_size]
         )
 
+    def simulate(self, num_iterations: int = 1, task_latency_us: dict = None, **kwargs):
+        # Estimate the makespan, worker utilization and critical path of the
+        # task graph without compiling or launching it. Task latencies
+        # default to the averages recorded in the profiler buffer, if any
+        if task_latency_us is None and self.profiler_tensor is not None:
+            task_latency_us = get_task_latencies_from_profiler(self.profiler_tensor)
+        results = self._generate_task_graph(task_latency_us)
+        return simulate_task_graph(
+            results["json_file"],
+            num_workers=self.num_workers,
+            num_local_schedulers=self.num_local_schedulers,
+            num_iterations=num_iterations,
+            task_latency_us=task_latency_us,
+            **kwargs,
+        )
+
+    def verify(self):
+        # Check the task graph for races between tasks that access
+        # overlapping tensor regions without being ordered by events, and
+        # for deadlocks in the prelaunched worker queues
+        results = self._generate_task_graph()
+        return verify_task_graph(results["json_file"], num_workers=self.num_workers)
+
+    def _generate_task_graph(self, task_latency_us: dict = None):
+        results = self.kn_graph.generate_task_graph(
+            num_gpus=self.world_size,
+            my_gpu_id=self.mpi_rank,
+            use_cpu_backend=(self.backend == "cpu"),
+        )
+        if self.order_tasks:
+            results["json_file"] = order_task_graph(
+                results["json_file"],
+                num_workers=self.num_workers,
+                task_latency_us=task_latency_us,
+            )
+        if self.pipeline_iterations:
+            results["json_file"] = pipeline_task_graph(results["json_file"])
+        if self.order_tasks or self.pipeline_iterations:
+            results["binary_file"] = task_graph_json_to_binary(results["json_file"])
+        return results
+
     def compile(
         self,
         **kwargs,
@@ -448,22 +531,30 @@ class PersistentKernel:
         MIRAGE_ROOT, INCLUDE_PATH, DEPS_PATH = get_key_paths()
         tempdir_obj = tempfile.TemporaryDirectory()
         tempdir = tempdir_obj.name
-        results = self.kn_graph.generate_task_graph(num_gpus=self.world_size, my_gpu_id=self.mpi_rank)
+        results = self._generate_task_graph()
 
-        cuda_code_path = os.path.join(tempdir, "test.cu")
+        cuda_code_path = os.path.join(tempdir, "test.cc" if self.backend == "cpu" else "test.cu")
         so_path = os.path.join(tempdir, "test.cpython-38-x86_64-linux-gnu.so")
         # check json file
         json_file_path = os.path.join(tempdir, "task_graph.json")
         with open(json_file_path, "w") as f:
             f.write(results["json_file"])
+        # the generated code maps the binary form at startup
+        with open(os.path.join(tempdir, "task_graph.bin"), "wb") as f:
+            f.write(results["binary_file"])
         with open(cuda_code_path, "w") as f:
             f.write(results["cuda_code"] + HARD_CODE)
 
-        cc = shutil.which("nvcc")
-        if cc is None:
-            raise RuntimeError(
-                "nvcc not found. Please make sure you have installed CUDA."
-            )
+        if self.backend == "cpu":
+            cc = shutil.which("g++") or shutil.which("c++")
+            if cc is None:
+                raise RuntimeError("No host C++ compiler found for the CPU backend.")
+        else:
+            cc = shutil.which("nvcc")
+            if cc is None:
+                raise RuntimeError(
+                    "nvcc not found. Please make sure you have installed CUDA."
+                )
         # This function was renamed and made public in Python 3.10
         if hasattr(sysconfig, "get_default_scheme"):
             scheme = sysconfig.get_default_scheme()
@@ -548,27 +639,36 @@ class PersistentKernel:
                     raise RuntimeError(
                         f"Cannot find libmpi.so, please set environment variable MPI_LIB_PATH"
                     )
-        target_cc = (
-            torch.cuda.get_device_properties(0).major * 10
-            + torch.cuda.get_device_properties(0).minor
-        )
-
-        cc_cmd = get_compile_command(
-            target_cc=target_cc,
-            cc=cc,
-            file_name=cuda_code_path,
-            py_include_dir=py_include_dir,
-            mirage_home_path=MIRAGE_HOME_PATH,
-            mirage_inc_path=INCLUDE_PATH,
-            mirage_deps_path=DEPS_PATH,
-            nvshmem_inc_path=NVSHMEM_INC_PATH,
-            nvshmem_lib_path=NVSHMEM_LIB_PATH,
-            mpi_inc_path=MPI_INC_PATH,
-            mpi_lib_path=MPI_LIB_PATH,
-            py_so_path=so_path,
-            profiling=True if self.profiler_tensor is not None else False,
-            use_nvshmem=self.use_nvshmem,
-        )
+        if self.backend == "cpu":
+            cc_cmd = get_cpu_compile_command(
+                cc=cc,
+                file_name=cuda_code_path,
+                py_include_dir=py_include_dir,
+                mirage_home_path=MIRAGE_HOME_PATH,
+                mirage_inc_path=INCLUDE_PATH,
+                py_so_path=so_path,
+            )
+        else:
+            target_cc = (
+                torch.cuda.get_device_properties(0).major * 10
+                + torch.cuda.get_device_properties(0).minor
+            )
+            cc_cmd = get_compile_command(
+                target_cc=target_cc,
+                cc=cc,
+                file_name=cuda_code_path,
+                py_include_dir=py_include_dir,
+                mirage_home_path=MIRAGE_HOME_PATH,
+                mirage_inc_path=INCLUDE_PATH,
+                mirage_deps_path=DEPS_PATH,
+                nvshmem_inc_path=NVSHMEM_INC_PATH,
+                nvshmem_lib_path=NVSHMEM_LIB_PATH,
+                mpi_inc_path=MPI_INC_PATH,
+                mpi_lib_path=MPI_LIB_PATH,
+                py_so_path=so_path,
+                profiling=True if self.profiler_tensor is not None else False,
+                use_nvshmem=self.use_nvshmem,
+            )
         print("Compiling megakernel using the following command line:")
         print(cc_cmd)
         subprocess.check_call(cc_cmd)
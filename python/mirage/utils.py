@@ -1,22 +1,18 @@
 import torch
 
+from .core import get_shared_memory_capacity as _get_shared_memory_capacity
+
+# Architectures with a known shared memory capacity. The C++ transpiler and
+# autotuner fall back to 48 KB for all others
+_SUPPORTED_TARGET_CCS = (80, 86, 89, 90)
+
 # This function returns the shared memory limit (in bytes)
 # for the given GPU hardware architecture
 def get_shared_memory_capacity(target_cc):
-    if target_cc == 80:
-        # A100 GPUs
-        return 163 * 1024
-    elif target_cc == 86:
-        # A5000 GPUs
-        return 99 * 1024
-    elif target_cc == 89:
-        # A6000 GPUs
-        return 99 * 1024
-    elif target_cc == 90:
-        # H100 GPUs
-        return 223 * 1024
-    else:
-        assert False, "Unsupported compute capacity: {}".format(target_cc)
+    assert (
+        target_cc in _SUPPORTED_TARGET_CCS
+    ), "Unsupported compute capacity: {}".format(target_cc)
+    return _get_shared_memory_capacity(target_cc)
 
 
 def get_scheduler(sm_cnt, worker):
@@ -0,0 +1,966 @@
+/* Copyright 2023-2024 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mirage/cpu/interpreter.h"
+#include "mirage/kernel/chunk.h"
+#include "mirage/kernel/element_unary.h"
+#include "mirage/kernel/reduction.h"
+#include "mirage/kernel/rms_norm.h"
+#include "mirage/threadblock/concat.h"
+#include "mirage/threadblock/element_unary.h"
+#include "mirage/threadblock/reduction.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace mirage {
+namespace cpu {
+
+using namespace mirage::type;
+
+HostTensor::HostTensor(void) : data_type(DT_UNKNOWN) {}
+
+HostTensor::HostTensor(std::vector<int> const &_dims, DataType _data_type)
+    : dims(_dims), data_type(_data_type) {
+  data.resize(num_elements(), 0.0f);
+}
+
+size_t HostTensor::num_elements() const {
+  size_t num = 1;
+  for (int d : dims) {
+    num *= d;
+  }
+  return num;
+}
+
+void HostTensor::round_to_data_type() {
+  if (data_type == DT_FLOAT32) {
+    return;
+  }
+  for (float &x : data) {
+    x = mirage::cpu::round_to_data_type(x, data_type);
+  }
+}
+
+uint16_t float_to_half(float x) {
+  uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  uint32_t sign = (bits >> 16) & 0x8000;
+  uint32_t exp = (bits >> 23) & 0xff;
+  uint32_t mant = bits & 0x7fffff;
+  if (exp == 0xff) {
+    // inf or nan
+    return sign | 0x7c00 | (mant ? 0x200 : 0);
+  }
+  int e = (int)exp - 127 + 15;
+  if (e >= 0x1f) {
+    return sign | 0x7c00;
+  }
+  if (e <= 0) {
+    // subnormal half
+    if (e < -10) {
+      return sign;
+    }
+    mant |= 0x800000;
+    int shift = 14 - e;
+    uint32_t h = mant >> shift;
+    uint32_t rem = mant & ((1u << shift) - 1);
+    uint32_t halfway = 1u << (shift - 1);
+    if (rem > halfway || (rem == halfway && (h & 1))) {
+      h++;
+    }
+    return sign | h;
+  }
+  uint32_t h = sign | ((uint32_t)e << 10) | (mant >> 13);
+  uint32_t rem = mant & 0x1fff;
+  // round to nearest even; a carry into the exponent is still correct
+  if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) {
+    h++;
+  }
+  return h;
+}
+
+float half_to_float(uint16_t x) {
+  uint32_t sign = ((uint32_t)x & 0x8000) << 16;
+  uint32_t exp = (x >> 10) & 0x1f;
+  uint32_t mant = x & 0x3ff;
+  uint32_t bits;
+  if (exp == 0) {
+    float f = std::ldexp((float)mant, -24);
+    return sign ? -f : f;
+  } else if (exp == 0x1f) {
+    bits = sign | 0x7f800000 | (mant << 13);
+  } else {
+    bits = sign | ((exp + 112) << 23) | (mant << 13);
+  }
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+uint16_t float_to_bfloat16(float x) {
+  uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  if (std::isnan(x)) {
+    return ((bits >> 16) & 0x8000) | 0x7fc0;
+  }
+  bits += 0x7fff + ((bits >> 16) & 1);
+  return (uint16_t)(bits >> 16);
+}
+
+float bfloat16_to_float(uint16_t x) {
+  uint32_t bits = (uint32_t)x << 16;
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+float round_to_data_type(float x, DataType data_type) {
+  switch (data_type) {
+    case DT_FLOAT16:
+      return half_to_float(float_to_half(x));
+    case DT_BFLOAT16:
+      return bfloat16_to_float(float_to_bfloat16(x));
+    default:
+      return x;
+  }
+}
+
+HostTensor load_host_tensor(void const *ptr,
+                            std::vector<int> const &dims,
+                            DataType data_type) {
+  HostTensor tensor(dims, data_type);
+  size_t num = tensor.num_elements();
+  switch (data_type) {
+    case DT_FLOAT32: {
+      std::memcpy(tensor.data.data(), ptr, num * sizeof(float));
+      break;
+    }
+    case DT_FLOAT16: {
+      uint16_t const *src = static_cast<uint16_t const *>(ptr);
+      for (size_t i = 0; i < num; i++) {
+        tensor.data[i] = half_to_float(src[i]);
+      }
+      break;
+    }
+    case DT_BFLOAT16: {
+      uint16_t const *src = static_cast<uint16_t const *>(ptr);
+      for (size_t i = 0; i < num; i++) {
+        tensor.data[i] = bfloat16_to_float(src[i]);
+      }
+      break;
+    }
+    default:
+      assert(false && "Unsupported data type");
+  }
+  return tensor;
+}
+
+void store_host_tensor(HostTensor const &tensor, void *ptr) {
+  size_t num = tensor.num_elements();
+  switch (tensor.data_type) {
+    case DT_FLOAT32: {
+      std::memcpy(ptr, tensor.data.data(), num * sizeof(float));
+      break;
+    }
+    case DT_FLOAT16: {
+      uint16_t *dst = static_cast<uint16_t *>(ptr);
+      for (size_t i = 0; i < num; i++) {
+        dst[i] = float_to_half(tensor.data[i]);
+      }
+      break;
+    }
+    case DT_BFLOAT16: {
+      uint16_t *dst = static_cast<uint16_t *>(ptr);
+      for (size_t i = 0; i < num; i++) {
+        dst[i] = float_to_bfloat16(tensor.data[i]);
+      }
+      break;
+    }
+    default:
+      assert(false && "Unsupported data type");
+  }
+}
+
+bool allclose(HostTensor const &a,
+              HostTensor const &b,
+              float rtol,
+              float atol) {
+  if (a.dims != b.dims) {
+    return false;
+  }
+  for (size_t i = 0; i < a.data.size(); i++) {
+    if (!(std::fabs(a.data[i] - b.data[i]) <=
+          atol + rtol * std::fabs(b.data[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+namespace {
+
+int const MAX_DIMS = mirage::config::MAX_TENSOR_DIMS;
+
+enum UnaryKind {
+  UNARY_EXP,
+  UNARY_SQUARE,
+  UNARY_SQRT,
+  UNARY_MUL_SCALAR,
+  UNARY_SILU,
+  UNARY_SIGMOID,
+  UNARY_GELU,
+  UNARY_RELU,
+  UNARY_CLAMP,
+  UNARY_LOG,
+};
+
+enum BinaryKind {
+  BINARY_ADD,
+  BINARY_MUL,
+  BINARY_DIV,
+  BINARY_SUB,
+  BINARY_POW,
+};
+
+std::vector<int> dims_of(int num_dims, int const *dim) {
+  return std::vector<int>(dim, dim + num_dims);
+}
+
+size_t product(std::vector<int> const &dims, int begin, int end) {
+  size_t num = 1;
+  for (int i = begin; i < end; i++) {
+    num *= dims[i];
+  }
+  return num;
+}
+
+void unravel(size_t idx, std::vector<int> const &dims, int *coord) {
+  for (int d = (int)dims.size() - 1; d >= 0; d--) {
+    coord[d] = idx % dims[d];
+    idx /= dims[d];
+  }
+}
+
+// Row-major offset of coord in a tensor of shape dims, where dimensions of
+// size 1 are broadcast
+size_t broadcast_offset(int const *coord, std::vector<int> const &dims) {
+  size_t offset = 0;
+  for (size_t d = 0; d < dims.size(); d++) {
+    offset = offset * dims[d] + (dims[d] == 1 ? 0 : coord[d]);
+  }
+  return offset;
+}
+
+float apply_unary(
+    UnaryKind kind, float x, float scalar, float min_val, float max_val) {
+  switch (kind) {
+    case UNARY_EXP:
+      return std::exp(x);
+    case UNARY_SQUARE:
+      return x * x;
+    case UNARY_SQRT:
+      return std::sqrt(x);
+    case UNARY_MUL_SCALAR:
+      return x * scalar;
+    case UNARY_SILU:
+      return x / (1.0f + std::exp(-x));
+    case UNARY_SIGMOID:
+      return 1.0f / (1.0f + std::exp(-x));
+    case UNARY_GELU:
+      return (x / 2.0f) * (1.0f + std::erf(x / std::sqrt(2.0f)));
+    case UNARY_RELU:
+      return std::max(0.0f, x);
+    case UNARY_CLAMP:
+      return std::min(std::max(x, min_val), max_val);
+    case UNARY_LOG:
+      return std::log(x);
+  }
+  assert(false && "Unsupported unary kind");
+  return 0.0f;
+}
+
+float apply_binary(BinaryKind kind, float a, float b) {
+  switch (kind) {
+    case BINARY_ADD:
+      return a + b;
+    case BINARY_MUL:
+      return a * b;
+    case BINARY_DIV:
+      return a / b;
+    case BINARY_SUB:
+      return a - b;
+    case BINARY_POW:
+      return std::pow(a, b);
+  }
+  assert(false && "Unsupported binary kind");
+  return 0.0f;
+}
+
+void unary_kernel(HostTensor const &input,
+                  HostTensor &output,
+                  UnaryKind kind,
+                  float scalar,
+                  float min_val,
+                  float max_val,
+                  int num_threads) {
+  int64_t num = (int64_t)output.num_elements();
+  assert(num == (int64_t)input.num_elements());
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1)
+  for (int64_t i = 0; i < num; i++) {
+    output.data[i] = round_to_data_type(
+        apply_unary(kind, input.data[i], scalar, min_val, max_val),
+        output.data_type);
+  }
+}
+
+void binary_kernel(HostTensor const &a,
+                   HostTensor const &b,
+                   HostTensor &output,
+                   BinaryKind kind,
+                   int num_threads) {
+  int64_t num = (int64_t)output.num_elements();
+  if (a.dims == output.dims && b.dims == output.dims) {
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1)
+    for (int64_t i = 0; i < num; i++) {
+      output.data[i] = round_to_data_type(
+          apply_binary(kind, a.data[i], b.data[i]), output.data_type);
+    }
+    return;
+  }
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1)
+  for (int64_t i = 0; i < num; i++) {
+    int coord[MAX_DIMS];
+    unravel(i, output.dims, coord);
+    float x = a.data[broadcast_offset(coord, a.dims)];
+    float y = b.data[broadcast_offset(coord, b.dims)];
+    output.data[i] =
+        round_to_data_type(apply_binary(kind, x, y), output.data_type);
+  }
+}
+
+// Cache-blocked batched matmul: the output is split into
+// MATMUL_TILE x MATMUL_TILE tiles that are computed independently, and
+// each tile walks K in MATMUL_TILE steps so that the A and B panels stay in
+// cache. Accumulation is in fp32 as in the tensor core kernels
+void matmul_kernel(HostTensor const &a,
+                   HostTensor const &b,
+                   HostTensor &output,
+                   int num_threads) {
+  constexpr int T = Interpreter::MATMUL_TILE;
+  int num_dims = output.dims.size();
+  assert(num_dims >= 2);
+  int M = output.dims[num_dims - 2];
+  int N = output.dims[num_dims - 1];
+  int K = a.dims[num_dims - 1];
+  assert(b.dims[num_dims - 2] == K);
+  std::vector<int> batch_dims(output.dims.begin(), output.dims.end() - 2);
+  std::vector<int> a_batch_dims(a.dims.begin(), a.dims.end() - 2);
+  std::vector<int> b_batch_dims(b.dims.begin(), b.dims.end() - 2);
+  int64_t num_batches = product(batch_dims, 0, batch_dims.size());
+  int64_t m_tiles = (M + T - 1) / T, n_tiles = (N + T - 1) / T;
+  int64_t num_tasks = num_batches * m_tiles * n_tiles;
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1)         \
+    schedule(dynamic)
+  for (int64_t task = 0; task < num_tasks; task++) {
+    int64_t batch = task / (m_tiles * n_tiles);
+    int m0 = (int)((task / n_tiles) % m_tiles) * T;
+    int n0 = (int)(task % n_tiles) * T;
+    int m1 = std::min(m0 + T, M), n1 = std::min(n0 + T, N);
+    int coord[MAX_DIMS];
+    unravel(batch, batch_dims, coord);
+    float const *A =
+        a.data.data() + broadcast_offset(coord, a_batch_dims) * M * K;
+    float const *B =
+        b.data.data() + broadcast_offset(coord, b_batch_dims) * K * N;
+    float *C = output.data.data() + batch * M * N;
+    float acc[T][T];
+    for (int i = 0; i < m1 - m0; i++) {
+      for (int j = 0; j < n1 - n0; j++) {
+        acc[i][j] = 0.0f;
+      }
+    }
+    for (int k0 = 0; k0 < K; k0 += T) {
+      int k1 = std::min(k0 + T, K);
+      for (int i = m0; i < m1; i++) {
+        for (int k = k0; k < k1; k++) {
+          float av = A[(size_t)i * K + k];
+          float const *brow = B + (size_t)k * N;
+          float *crow = acc[i - m0];
+          for (int j = n0; j < n1; j++) {
+            crow[j - n0] += av * brow[j];
+          }
+        }
+      }
+    }
+    for (int i = m0; i < m1; i++) {
+      for (int j = n0; j < n1; j++) {
+        C[(size_t)i * N + j] =
+            round_to_data_type(acc[i - m0][j - n0], output.data_type);
+      }
+    }
+  }
+}
+
+// Reduce dimension dim of input to output.dims[dim]. Following the
+// fingerprint kernels, output element m in a reduction group sums the
+// input elements m, m + output_stride, m + 2 * output_stride, ...
+void reduction_kernel(HostTensor const &input,
+                      HostTensor &output,
+                      int dim,
+                      int num_threads) {
+  int num_dims = output.dims.size();
+  size_t output_stride = product(output.dims, dim, num_dims);
+  size_t input_stride = product(input.dims, dim, num_dims);
+  int reduction_factor = input.dims[dim] / output.dims[dim];
+  assert(output_stride * reduction_factor == input_stride);
+  int64_t num = (int64_t)output.num_elements();
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1)
+  for (int64_t i = 0; i < num; i++) {
+    size_t n = i / output_stride, m = i % output_stride;
+    float result = 0.0f;
+    for (int k = 0; k < reduction_factor; k++) {
+      result += input.data[n * input_stride + m + k * output_stride];
+    }
+    output.data[i] = round_to_data_type(result, output.data_type);
+  }
+}
+
+// Running max along dim; diff records old_max - new_max for rescaling
+// the accumulators of online softmax
+void reduction_max_kernel(HostTensor const &input,
+                          HostTensor &updated_max,
+                          HostTensor &diff,
+                          int dim,
+                          bool reset) {
+  int num_dims = updated_max.dims.size();
+  size_t output_stride = product(updated_max.dims, dim, num_dims);
+  size_t input_stride = product(input.dims, dim, num_dims);
+  int reduction_factor = input.dims[dim];
+  size_t num = updated_max.num_elements();
+  for (size_t i = 0; i < num; i++) {
+    size_t n = i / output_stride, m = i % output_stride;
+    float old_max =
+        reset ? -std::numeric_limits<float>::infinity() : updated_max.data[i];
+    float max_val = old_max;
+    for (int k = 0; k < reduction_factor; k++) {
+      max_val = std::max(max_val,
+                         input.data[n * input_stride + m + k * output_stride]);
+    }
+    updated_max.data[i] = round_to_data_type(max_val, updated_max.data_type);
+    diff.data[i] = reset ? 0.0f
+                         : round_to_data_type(old_max - updated_max.data[i],
+                                              diff.data_type);
+  }
+}
+
+void rms_norm_kernel(HostTensor const &input,
+                     HostTensor &output,
+                     int norm_size,
+                     int num_threads) {
+  int64_t num_samples = (int64_t)(output.num_elements() / norm_size);
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1)
+  for (int64_t s = 0; s < num_samples; s++) {
+    float const *x = input.data.data() + s * norm_size;
+    float *y = output.data.data() + s * norm_size;
+    float square_sum = 0.0f;
+    for (int k = 0; k < norm_size; k++) {
+      square_sum += x[k] * x[k];
+    }
+    float rms = std::sqrt(square_sum / norm_size);
+    for (int k = 0; k < norm_size; k++) {
+      y[k] = round_to_data_type(x[k] / rms, output.data_type);
+    }
+  }
+}
+
+void concat_kernel(HostTensor const &a,
+                   HostTensor const &b,
+                   HostTensor &output,
+                   int dim) {
+  int num_dims = output.dims.size();
+  size_t outer = product(output.dims, 0, dim);
+  size_t a_inner = product(a.dims, dim, num_dims);
+  size_t b_inner = product(b.dims, dim, num_dims);
+  for (size_t o = 0; o < outer; o++) {
+    float *dst = output.data.data() + o * (a_inner + b_inner);
+    std::copy_n(a.data.data() + o * a_inner, a_inner, dst);
+    std::copy_n(b.data.data() + o * b_inner, b_inner, dst + a_inner);
+  }
+}
+
+// Copy the chunk_idx-th slice of input along dim into output
+void chunk_kernel(HostTensor const &input,
+                  HostTensor &output,
+                  int dim,
+                  int chunk_idx) {
+  int num_dims = input.dims.size();
+  size_t outer = product(input.dims, 0, dim);
+  size_t input_inner = product(input.dims, dim, num_dims);
+  size_t output_inner = product(output.dims, dim, num_dims);
+  for (size_t o = 0; o < outer; o++) {
+    std::copy_n(input.data.data() + o * input_inner + chunk_idx * output_inner,
+                output_inner,
+                output.data.data() + o * output_inner);
+  }
+}
+
+// Forloop accumulation. accum is kept in fp32 across iterations and
+// rounded to its data type after post processing on the last iteration
+void forloop_accum_kernel(TBOperatorType type,
+                          HostTensor const &input,
+                          HostTensor const *rescale,
+                          HostTensor &accum,
+                          bool reset_output,
+                          bool post_process,
+                          int forloop_range) {
+  int num_dims = accum.dims.size();
+  int inner_range = accum.dims[num_dims - 1];
+  int input_last_dim = input.dims[num_dims - 1];
+  int reduction_degree = input_last_dim / inner_range;
+  bool compute_square = (type == TB_FORLOOP_ACCUM_RED_LD_RMS_OP);
+  size_t num = accum.num_elements();
+  for (size_t idx = 0; idx < num; idx++) {
+    size_t pos = (idx / inner_range) * input_last_dim + idx % inner_range;
+    float result = 0.0f;
+    for (int k = 0; k < reduction_degree; k++) {
+      float x = input.data[pos + k * inner_range];
+      result += compute_square ? x * x : x;
+    }
+    float old_output = reset_output ? 0.0f : accum.data[idx];
+    if (rescale != nullptr) {
+      int coord[MAX_DIMS];
+      unravel(idx, accum.dims, coord);
+      old_output *= rescale->data[broadcast_offset(coord, rescale->dims)];
+    }
+    accum.data[idx] = old_output + result;
+    if (post_process) {
+      float n = (float)forloop_range * reduction_degree;
+      if (type == TB_FORLOOP_ACCUM_RED_LD_MEAN_OP) {
+        accum.data[idx] = accum.data[idx] / n;
+      } else if (type == TB_FORLOOP_ACCUM_RED_LD_RMS_OP) {
+        accum.data[idx] = std::sqrt(accum.data[idx] / n);
+      }
+      accum.data[idx] = round_to_data_type(accum.data[idx], accum.data_type);
+    }
+  }
+}
+
+// Offset of the tile owned by (block_idx, forloop_idx) in a device tensor
+// of shape dims, given the grid-to-dim map and the forloop dim
+void tile_offset(std::vector<int> const &dims,
+                 std::vector<int> const &tile,
+                 dim3 grid_dim,
+                 int3 dim_map,
+                 int3 block_idx,
+                 int forloop_dim,
+                 int forloop_idx,
+                 int *offset) {
+  for (size_t d = 0; d < dims.size(); d++) {
+    offset[d] = 0;
+  }
+  int grid[3] = {(int)grid_dim.x, (int)grid_dim.y, (int)grid_dim.z};
+  int map[3] = {dim_map.x, dim_map.y, dim_map.z};
+  int idx[3] = {block_idx.x, block_idx.y, block_idx.z};
+  for (int g = 0; g < 3; g++) {
+    if (grid[g] > 1 && map[g] >= 0) {
+      offset[map[g]] += idx[g] * (dims[map[g]] / grid[g]);
+    }
+  }
+  if (forloop_dim >= 0) {
+    offset[forloop_dim] += forloop_idx * tile[forloop_dim];
+  }
+}
+
+// Offset in a device tensor of the r-th row of a tile placed at offset;
+// the last dimension is contiguous in both, so rows are copied as a whole
+size_t tile_row_offset(std::vector<int> const &tile_dims,
+                       std::vector<int> const &dims,
+                       int const *offset,
+                       size_t r) {
+  int num_dims = tile_dims.size();
+  size_t global = 0;
+  for (int d = num_dims - 2; d >= 0; d--) {
+    global += (r % tile_dims[d] + offset[d]) * product(dims, d + 1, num_dims);
+    r /= tile_dims[d];
+  }
+  return global + offset[num_dims - 1];
+}
+
+void load_tile(HostTensor const &dtensor, HostTensor &tile, int const *offset) {
+  int row = tile.dims.back();
+  size_t num_rows = tile.num_elements() / row;
+  for (size_t r = 0; r < num_rows; r++) {
+    std::copy_n(dtensor.data.data() +
+                    tile_row_offset(tile.dims, dtensor.dims, offset, r),
+                row,
+                tile.data.data() + r * row);
+  }
+}
+
+void store_tile(HostTensor const &tile,
+                HostTensor &dtensor,
+                int const *offset) {
+  int row = tile.dims.back();
+  size_t num_rows = tile.num_elements() / row;
+  for (size_t r = 0; r < num_rows; r++) {
+    std::copy_n(tile.data.data() + r * row,
+                row,
+                dtensor.data.data() +
+                    tile_row_offset(tile.dims, dtensor.dims, offset, r));
+  }
+}
+
+bool get_unary_kind(int op_type, UnaryKind &kind) {
+  switch (op_type) {
+    case KN_EXP_OP:
+    case TB_EXP_OP:
+      kind = UNARY_EXP;
+      return true;
+    case KN_SQUARE_OP:
+    case TB_SQUARE_OP:
+      kind = UNARY_SQUARE;
+      return true;
+    case KN_SQRT_OP:
+    case TB_SQRT_OP:
+      kind = UNARY_SQRT;
+      return true;
+    case KN_MUL_SCALAR_OP:
+    case TB_MUL_SCALAR_OP:
+      kind = UNARY_MUL_SCALAR;
+      return true;
+    case KN_SILU_OP:
+    case TB_SILU_OP:
+      kind = UNARY_SILU;
+      return true;
+    case KN_SIGMOID_OP:
+    case TB_SIGMOID_OP:
+      kind = UNARY_SIGMOID;
+      return true;
+    case KN_GELU_OP:
+    case TB_GELU_OP:
+      kind = UNARY_GELU;
+      return true;
+    case KN_RELU_OP:
+    case TB_RELU_OP:
+      kind = UNARY_RELU;
+      return true;
+    case KN_CLAMP_OP:
+    case TB_CLAMP_OP:
+      kind = UNARY_CLAMP;
+      return true;
+    case KN_LOG_OP:
+    case TB_LOG_OP:
+      kind = UNARY_LOG;
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool get_binary_kind(int op_type, BinaryKind &kind) {
+  switch (op_type) {
+    case KN_ADD_OP:
+    case TB_ADD_OP:
+      kind = BINARY_ADD;
+      return true;
+    case KN_MUL_OP:
+    case TB_MUL_OP:
+      kind = BINARY_MUL;
+      return true;
+    case KN_DIV_OP:
+    case TB_DIV_OP:
+      kind = BINARY_DIV;
+      return true;
+    case TB_SUB_OP:
+      kind = BINARY_SUB;
+      return true;
+    case KN_POW_OP:
+    case TB_POW_OP:
+      kind = BINARY_POW;
+      return true;
+    default:
+      return false;
+  }
+}
+
+} // namespace
+
+Interpreter::Interpreter(int _num_threads) : num_threads(_num_threads) {
+  if (num_threads <= 0) {
+#ifdef _OPENMP
+    num_threads = omp_get_max_threads();
+#else
+    num_threads = 1;
+#endif
+  }
+}
+
+std::vector<HostTensor>
+    Interpreter::run(mirage::kernel::Graph const &graph,
+                     std::vector<HostTensor> const &inputs) {
+  using namespace mirage::kernel;
+  std::unordered_map<type::GuidType, HostTensor> tensors;
+  std::vector<HostTensor> outputs;
+  auto new_output = [&](KNOperator const *op, int idx) -> HostTensor & {
+    DTensor const &t = op->output_tensors[idx];
+    return tensors[t.guid] =
+               HostTensor(dims_of(t.num_dims, t.dim), t.data_type);
+  };
+  size_t input_idx = 0;
+  for (KNOperator const *op : graph.operators) {
+    std::vector<HostTensor const *> my_inputs;
+    for (DTensor const &t : op->input_tensors) {
+      assert(tensors.find(t.guid) != tensors.end());
+      my_inputs.push_back(&tensors.at(t.guid));
+    }
+    UnaryKind unary;
+    BinaryKind binary;
+    if (op->op_type == KN_INPUT_OP) {
+      assert(input_idx < inputs.size());
+      DTensor const &t = op->output_tensors[0];
+      assert(inputs[input_idx].dims == dims_of(t.num_dims, t.dim));
+      HostTensor &output = new_output(op, 0);
+      output.data = inputs[input_idx++].data;
+      output.round_to_data_type();
+    } else if (op->op_type == KN_OUTPUT_OP) {
+      outputs.push_back(*my_inputs[0]);
+    } else if (op->op_type == KN_MATMUL_OP) {
+      matmul_kernel(
+          *my_inputs[0], *my_inputs[1], new_output(op, 0), num_threads);
+    } else if (get_unary_kind(op->op_type, unary)) {
+      // The kernel graph does not record a scalar for KN_MUL_SCALAR_OP
+      assert(unary != UNARY_MUL_SCALAR && "Unsupported kernel operator");
+      float min_val = 0.0f, max_val = 0.0f;
+      if (unary == UNARY_CLAMP) {
+        KNClampUnaryOp const *clamp = static_cast<KNClampUnaryOp const *>(op);
+        min_val = clamp->min_val;
+        max_val = clamp->max_val;
+      }
+      unary_kernel(*my_inputs[0],
+                   new_output(op, 0),
+                   unary,
+                   0.0f,
+                   min_val,
+                   max_val,
+                   num_threads);
+    } else if (get_binary_kind(op->op_type, binary)) {
+      binary_kernel(
+          *my_inputs[0], *my_inputs[1], new_output(op, 0), binary, num_threads);
+    } else if (op->op_type >= KN_REDUCTION_0_OP &&
+               op->op_type <= KN_REDUCTION_2_OP) {
+      KNReductionOp const *reduction = static_cast<KNReductionOp const *>(op);
+      reduction_kernel(*my_inputs[0],
+                       new_output(op, 0),
+                       reduction->reduction_dim_idx,
+                       num_threads);
+    } else if (op->op_type == KN_RMS_NORM_OP) {
+      KNRMSNormOp const *rms_norm = static_cast<KNRMSNormOp const *>(op);
+      rms_norm_kernel(*my_inputs[0],
+                      new_output(op, 0),
+                      rms_norm->normalized_size,
+                      num_threads);
+    } else if (op->op_type >= KN_CHUNK_0_OP && op->op_type <= KN_CHUNK_2_OP) {
+      KNChunkOp const *chunk = static_cast<KNChunkOp const *>(op);
+      for (size_t i = 0; i < op->output_tensors.size(); i++) {
+        chunk_kernel(*my_inputs[0], new_output(op, i), chunk->chunk_dim, i);
+      }
+    } else if (op->op_type == KN_ALLREDUCE_OP) {
+      // The interpreter models a single device, so allreduce is an identity
+      new_output(op, 0).data = my_inputs[0]->data;
+    } else if (op->op_type == KN_CUSTOMIZED_OP) {
+      std::vector<HostTensor *> my_outputs;
+      for (size_t i = 0; i < op->output_tensors.size(); i++) {
+        my_outputs.push_back(&new_output(op, i));
+      }
+      run_customized_op(
+          static_cast<KNCustomizedOp const *>(op), my_inputs, my_outputs);
+    } else {
+      assert(false && "Unsupported kernel operator");
+    }
+  }
+  assert(input_idx == inputs.size());
+  return outputs;
+}
+
+void Interpreter::run_customized_op(
+    mirage::kernel::KNCustomizedOp const *op,
+    std::vector<HostTensor const *> const &inputs,
+    std::vector<HostTensor *> const &outputs) {
+  mirage::threadblock::Graph const &bgraph = op->bgraph;
+  dim3 grid_dim = bgraph.grid_dim;
+  int64_t num_blocks = (int64_t)grid_dim.x * grid_dim.y * grid_dim.z;
+  // Each thread block only writes its own output tiles, so blocks can be
+  // executed concurrently without synchronization
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1)         \
+    schedule(dynamic)
+  for (int64_t b = 0; b < num_blocks; b++) {
+    int3 block_idx;
+    block_idx.x = b % grid_dim.x;
+    block_idx.y = (b / grid_dim.x) % grid_dim.y;
+    block_idx.z = b / ((int64_t)grid_dim.x * grid_dim.y);
+    run_threadblock(bgraph, block_idx, inputs, outputs);
+  }
+}
+
+void Interpreter::run_threadblock(mirage::threadblock::Graph const &bgraph,
+                                  int3 block_idx,
+                                  std::vector<HostTensor const *> const &inputs,
+                                  std::vector<HostTensor *> const &outputs) {
+  using namespace mirage::threadblock;
+  std::unordered_map<type::GuidType, HostTensor> stensors;
+  auto get_output = [&](TBOperator const *op, int idx) -> HostTensor & {
+    STensor const &t = op->output_tensors[idx];
+    HostTensor &tensor = stensors[t.guid];
+    if (tensor.data.empty()) {
+      tensor = HostTensor(dims_of(t.num_dims, t.dim), t.data_type);
+    }
+    return tensor;
+  };
+  int forloop_range = bgraph.forloop_range;
+  for (int i = 0; i < forloop_range; i++) {
+    bool last_iteration = (i == forloop_range - 1);
+    size_t input_idx = 0, output_idx = 0;
+    for (TBOperator const *op : bgraph.operators) {
+      // Operators after the forloop accumulators only run once, on the
+      // last iteration
+      bool after_accum = false;
+      std::vector<HostTensor const *> my_inputs;
+      for (STensor const &t : op->input_tensors) {
+        after_accum = after_accum || t.after_accum;
+        my_inputs.push_back(&stensors.at(t.guid));
+      }
+      if (op->op_type == TB_INPUT_OP) {
+        input_idx++;
+      } else if (op->op_type == TB_OUTPUT_OP) {
+        output_idx++;
+      }
+      if (after_accum && !last_iteration) {
+        continue;
+      }
+      UnaryKind unary;
+      BinaryKind binary;
+      if (op->op_type == TB_INPUT_OP) {
+        TBInputOp const *input_op = static_cast<TBInputOp const *>(op);
+        HostTensor &tile = get_output(op, 0);
+        HostTensor const &dtensor = *inputs[input_idx - 1];
+        int offset[MAX_DIMS];
+        tile_offset(dtensor.dims,
+                    tile.dims,
+                    bgraph.grid_dim,
+                    input_op->input_map,
+                    block_idx,
+                    input_op->forloop_dim,
+                    i,
+                    offset);
+        load_tile(dtensor, tile, offset);
+      } else if (op->op_type == TB_OUTPUT_OP) {
+        TBOutputOp const *output_op = static_cast<TBOutputOp const *>(op);
+        // Blocks along grid dimensions that are not mapped to the output
+        // compute identical tiles; only the first of them writes back.
+        // Epilogues are communication only and are no-ops on one device
+        int3 omap = output_op->output_map;
+        if ((omap.x < 0 && block_idx.x > 0) ||
+            (omap.y < 0 && block_idx.y > 0) ||
+            (omap.z < 0 && block_idx.z > 0)) {
+          continue;
+        }
+        HostTensor tile = *my_inputs[0];
+        HostTensor &dtensor = *outputs[output_idx - 1];
+        tile.data_type = dtensor.data_type;
+        tile.round_to_data_type();
+        int offset[MAX_DIMS];
+        tile_offset(dtensor.dims,
+                    tile.dims,
+                    bgraph.grid_dim,
+                    omap,
+                    block_idx,
+                    output_op->forloop_dim,
+                    i,
+                    offset);
+        store_tile(tile, dtensor, offset);
+      } else if (op->op_type == TB_MATMUL_OP) {
+        matmul_kernel(*my_inputs[0], *my_inputs[1], get_output(op, 0), 1);
+      } else if (get_unary_kind(op->op_type, unary)) {
+        TBElementUnaryOp const *unary_op =
+            static_cast<TBElementUnaryOp const *>(op);
+        float min_val = 0.0f, max_val = 0.0f;
+        if (unary == UNARY_CLAMP) {
+          TBClampUnaryOp const *clamp = static_cast<TBClampUnaryOp const *>(op);
+          min_val = clamp->min_val;
+          max_val = clamp->max_val;
+        }
+        unary_kernel(*my_inputs[0],
+                     get_output(op, 0),
+                     unary,
+                     unary_op->scalar,
+                     min_val,
+                     max_val,
+                     1);
+      } else if (get_binary_kind(op->op_type, binary)) {
+        binary_kernel(
+            *my_inputs[0], *my_inputs[1], get_output(op, 0), binary, 1);
+      } else if (op->op_type >= TB_REDUCTION_0_OP &&
+                 op->op_type <= TB_REDUCTION_2_TO_DIMX_OP) {
+        TBReductionOp const *reduction = static_cast<TBReductionOp const *>(op);
+        reduction_kernel(
+            *my_inputs[0], get_output(op, 0), reduction->reduce_dim, 1);
+      } else if (op->op_type >= TB_REDUCTION_0_MAX_OP &&
+                 op->op_type <= TB_REDUCTION_2_MAX_OP) {
+        TBReductionOp const *reduction = static_cast<TBReductionOp const *>(op);
+        // The running max is reset at the start of the forloop unless it
+        // only runs once after accumulation
+        reduction_max_kernel(*my_inputs[0],
+                             get_output(op, 0),
+                             get_output(op, 1),
+                             reduction->reduce_dim,
+                             after_accum || i == 0);
+      } else if (op->op_type == TB_RMS_NORM_OP) {
+        HostTensor const &input = *my_inputs[0];
+        rms_norm_kernel(
+            input, get_output(op, 0), input.dims[input.dims.size() - 1], 1);
+      } else if (op->op_type >= TB_CONCAT_0_OP &&
+                 op->op_type <= TB_CONCAT_2_OP) {
+        TBConcatOp const *concat = static_cast<TBConcatOp const *>(op);
+        concat_kernel(*my_inputs[0],
+                      *my_inputs[1],
+                      get_output(op, 0),
+                      concat->concat_dim);
+      } else if (op->op_type >= TB_FORLOOP_ACCUM_FIRST_OP &&
+                 op->op_type < TB_FORLOOP_ACCUM_LAST_OP) {
+        HostTensor const *rescale =
+            my_inputs.size() > 1 ? my_inputs[1] : nullptr;
+        forloop_accum_kernel(op->op_type,
+                             *my_inputs[0],
+                             rescale,
+                             get_output(op, 0),
+                             i == 0 /*reset_output*/,
+                             last_iteration /*post_process*/,
+                             forloop_range);
+      } else {
+        assert(false && "Unsupported threadblock operator");
+      }
+    }
+  }
+}
+
+} // namespace cpu
+} // namespace mirage
@@ -27,7 +27,7 @@ namespace kernel {
 DTensor Graph::all_reduce(DTensor const &input, bool inplace) {
   KNOperator *op = create_all_reduce_op(input, inplace);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   DTensor output = op->output_tensors[0];
   return output;
 }
@@ -35,7 +35,7 @@ DTensor Graph::all_reduce(DTensor const &input, bool inplace) {
 DTensor *Graph::all_reduce(DTensor const *input, bool inplace) {
   KNOperator *op = create_all_reduce_op(*input, inplace);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return &op->output_tensors[0];
 }
 
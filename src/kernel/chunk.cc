@@ -26,7 +26,7 @@ std::vector<DTensor>
     Graph::chunk(DTensor const &input, int chunk_size, int dim) {
   KNOperator *op = create_chunk_op(input, chunk_size, dim);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   assert(op->output_tensors.size() > 0);
   return op->output_tensors;
 }
@@ -36,9 +36,7 @@ mirage::cpu::CTensor DTensor::copy_fingerprint_to_ctensor() const {
       mirage::kernel::DeviceMemoryManager::get_instance();
   // Set device id to dmm->gpu_id when retrieving fingerprints
   checkCUDA(cudaSetDevice(dmm->gpu_id));
-  // FIXME: memory leakage since we do not free this fingerprint buffer
-  // This is ok for now since we only copy the input mugraph's fingerprint
-  // to ctensor
+  // The caller owns the fingerprint buffers, which are allocated by malloc
   for (int gpu_id = 0; gpu_id < owner_op->kgraph->gpu_dim.x; gpu_id++) {
     ctensor.fp_ptr[gpu_id] = (mirage::type::FPType *)malloc(fingerprint_size());
     checkCUDA(cudaMemcpy(ctensor.fp_ptr[gpu_id],
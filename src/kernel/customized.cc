@@ -33,7 +33,7 @@ std::vector<DTensor> Graph::customized(std::vector<DTensor> const &inputs,
                                        threadblock::Graph const &bgraph) {
   KNOperator *op = create_customized_op(inputs, bgraph);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return op->output_tensors;
 }
 
@@ -46,7 +46,7 @@ int Graph::customized(std::vector<DTensor const *> _inputs,
   }
   KNOperator *op = create_customized_op(inputs, *bgraph);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   for (size_t i = 0; i < op->output_tensors.size(); i++) {
     outputs[i] = &op->output_tensors[i];
   }
@@ -15,6 +15,7 @@
 
 #include "mirage/kernel/device_memory_manager.h"
 #include "mirage/utils/cuda_helper.h"
+#include "mirage/utils/fingerprint_functions.h"
 
 namespace mirage {
 namespace kernel {
@@ -38,10 +39,7 @@ DeviceMemoryManager::DeviceMemoryManager(int _num_gpus, int _gpu_id)
   assert(FP_Q < FP_P);
   assert((FP_P - 1) % FP_Q == 0);
   FPType exp_table[FP_Q];
-  exp_table[0] = 1;
-  for (int i = 1; i < FP_Q; i++) {
-    exp_table[i] = (exp_table[i - 1] * FP_EXP_BASE) % FP_P;
-  }
+  mirage::utils::init_exp_lookup_table(exp_table);
   assert((exp_table[FP_Q - 1] * FP_EXP_BASE) % FP_P == 1);
   checkCUDA(cudaMemcpy(exp_lookup_table,
                        exp_table,
@@ -52,16 +50,9 @@ DeviceMemoryManager::DeviceMemoryManager(int _num_gpus, int _gpu_id)
   checkCUDA(
       cudaMalloc(&div_p_lookup_table, (sizeof(FPType) * FP_P + 15) / 16 * 16));
   FPType div_p_table[FP_P];
-  for (uint32_t i = 0; i < FP_P; i++) {
-    div_p_table[i] = 1;
-    for (uint32_t j = 1; j < FP_P; j++) {
-      if ((i * j) % FP_P == 1) {
-        div_p_table[i] = j;
-      }
-    }
-    if (i > 1) {
-      assert(div_p_table[i] != 1);
-    }
+  mirage::utils::init_div_lookup_table(div_p_table, FP_P);
+  for (uint32_t i = 2; i < FP_P; i++) {
+    assert(div_p_table[i] != 1);
   }
   checkCUDA(cudaMemcpy(div_p_lookup_table,
                        div_p_table,
@@ -72,16 +63,9 @@ DeviceMemoryManager::DeviceMemoryManager(int _num_gpus, int _gpu_id)
   checkCUDA(
       cudaMalloc(&div_q_lookup_table, (sizeof(FPType) * FP_Q + 15) / 16 * 16));
   FPType div_q_table[FP_Q];
-  for (uint32_t i = 0; i < FP_Q; i++) {
-    div_q_table[i] = 1;
-    for (uint32_t j = 1; j < FP_Q; j++) {
-      if ((i * j) % FP_Q == 1) {
-        div_q_table[i] = j;
-      }
-    }
-    if (i > 1) {
-      assert(div_q_table[i] != 1);
-    }
+  mirage::utils::init_div_lookup_table(div_q_table, FP_Q);
+  for (uint32_t i = 2; i < FP_Q; i++) {
+    assert(div_q_table[i] != 1);
   }
   checkCUDA(cudaMemcpy(div_q_lookup_table,
                        div_q_table,
@@ -91,17 +75,9 @@ DeviceMemoryManager::DeviceMemoryManager(int _num_gpus, int _gpu_id)
   // make future tensors 16 bytes aligned
   checkCUDA(
       cudaMalloc(&sqrt_p_lookup_table, (sizeof(FPType) * FP_P + 15) / 16 * 16));
-  // Solving the congruence b=x^2 mod p using the following formulas:
-  // if p == 3 mod 4, then x = b^{(p+1)/4} is a solution
   assert(FP_P % 4 == 3);
   FPType sqrt_p_table[FP_P];
-  for (uint32_t i = 0; i < FP_P; i++) {
-    sqrt_p_table[i] = 1;
-    for (uint32_t j = 0; j < (FP_P + 1) / 4; j++) {
-      sqrt_p_table[i] = (sqrt_p_table[i] * i) % FP_P;
-    }
-    // assert((sqrt_p_table[i] * sqrt_p_table[i]) % FP_P == i);
-  }
+  mirage::utils::init_sqrt_lookup_table(sqrt_p_table, FP_P);
   checkCUDA(cudaMemcpy(sqrt_p_lookup_table,
                        sqrt_p_table,
                        sizeof(FPType) * FP_P,
@@ -112,13 +88,7 @@ DeviceMemoryManager::DeviceMemoryManager(int _num_gpus, int _gpu_id)
       cudaMalloc(&sqrt_q_lookup_table, (sizeof(FPType) * FP_Q + 15) / 16 * 16));
   assert(FP_Q % 4 == 3);
   FPType sqrt_q_table[FP_Q];
-  for (uint32_t i = 0; i < FP_Q; i++) {
-    sqrt_q_table[i] = 1;
-    for (uint32_t j = 0; j < (FP_Q + 1) / 4; j++) {
-      sqrt_q_table[i] = (sqrt_q_table[i] * i) % FP_Q;
-    }
-    // assert((sqrt_q_table[i] * sqrt_q_table[i]) % FP_Q == i);
-  }
+  mirage::utils::init_sqrt_lookup_table(sqrt_q_table, FP_Q);
   checkCUDA(cudaMemcpy(sqrt_q_lookup_table,
                        sqrt_q_table,
                        sizeof(FPType) * FP_Q,
@@ -60,7 +60,7 @@ DTensor Graph::elementbinary(DTensor const &input1,
                              mirage::type::KNOperatorType type) {
   KNOperator *op = create_elementbinary_op(input1, input2, type);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   assert(op->output_tensors.size() == 1);
   DTensor output = op->output_tensors[0];
   return output;
@@ -92,7 +92,7 @@ DTensor Graph::elementunary_clamp(DTensor const &input,
                                   float const &max_val) {
   KNOperator *op = create_elementunary_clamp_op(input, min_val, max_val);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   assert(op->output_tensors.size() == 1);
   DTensor output = op->output_tensors[0];
   return output;
@@ -103,7 +103,7 @@ DTensor *Graph::elementunary_clamp(DTensor const *input,
                                    float const &max_val) {
   KNOperator *op = create_elementunary_clamp_op(*input, min_val, max_val);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   assert(op->output_tensors.size() == 1);
   return &op->output_tensors[0];
 }
@@ -124,7 +124,7 @@ DTensor Graph::elementunary(DTensor const &input,
                             mirage::type::KNOperatorType type) {
   KNOperator *op = create_elementunary_op(input, type);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   assert(op->output_tensors.size() == 1);
   DTensor output = op->output_tensors[0];
   return output;
@@ -134,7 +134,7 @@ DTensor *Graph::elementunary(DTensor const *input,
                              mirage::type::KNOperatorType type) {
   KNOperator *op = create_elementunary_op(*input, type);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   assert(op->output_tensors.size() == 1);
   return &op->output_tensors[0];
 }
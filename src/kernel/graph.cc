@@ -39,6 +39,19 @@ Graph::~Graph() {
   }
 }
 
+void Graph::add_operator(KNOperator *op) {
+  operators.push_back(op);
+  use_def.add_operator(op);
+}
+
+KNOperator *Graph::remove_last_operator() {
+  assert(!operators.empty());
+  KNOperator *op = operators.back();
+  use_def.remove_operator(op);
+  operators.pop_back();
+  return op;
+}
+
 size_t Graph::pair_hash::operator()(std::pair<int, int> const &p) const {
   size_t h1 = std::hash<int>{}(p.first);
   size_t h2 = std::hash<int>{}(p.second);
@@ -192,18 +205,13 @@ void to_json(json &j, Graph const &g) {
 }
 
 void from_json(json const &j, Graph &g) {
-  std::unordered_map<size_t, size_t>
-      guid_mapping; // from deseralized guid to json guid
+  std::unordered_map<size_t, type::GuidType>
+      guid_mapping; // from json guid to deseralized guid
 
   auto get_tensor_from_guid = [&](size_t guid) {
-    for (auto const &op : g.operators) {
-      for (DTensor const &dtensor : op->output_tensors) {
-        if (guid_mapping.at(dtensor.guid) == guid) {
-          return dtensor;
-        }
-      }
-    }
-    assert(false);
+    DTensor const *dtensor = g.use_def.get_tensor(guid_mapping.at(guid));
+    assert(dtensor != nullptr);
+    return *dtensor;
   };
 
   for (json const &jop : j) {
@@ -225,7 +233,7 @@ void from_json(json const &j, Graph &g) {
         std::vector<int> dims = to_vector(num_dim, dim);
         DTensor const &output =
             g.new_input(dims, input_strides, data_type, layout);
-        guid_mapping[output.guid] = guidO;
+        guid_mapping[guidO] = output.guid;
         break;
       }
       case type::KNOperatorType::KN_OUTPUT_OP: {
@@ -243,7 +251,7 @@ void from_json(json const &j, Graph &g) {
         jop.at("output_tensors")[0].at("guid").get_to(guidO);
         DTensor const &output =
             g.matmul(get_tensor_from_guid(guidA), get_tensor_from_guid(guidB));
-        guid_mapping[output.guid] = guidO;
+        guid_mapping[guidO] = output.guid;
         break;
       }
       case type::KNOperatorType::KN_EXP_OP:
@@ -257,7 +265,7 @@ void from_json(json const &j, Graph &g) {
         jop.at("output_tensors")[0].at("guid").get_to(guidO);
         DTensor const &output =
             g.elementunary(get_tensor_from_guid(guid), op_type);
-        guid_mapping[output.guid] = guidO;
+        guid_mapping[guidO] = output.guid;
         break;
       }
       case type::KNOperatorType::KN_CLAMP_OP: {
@@ -268,7 +276,7 @@ void from_json(json const &j, Graph &g) {
             g.elementunary_clamp(get_tensor_from_guid(guid),
                                  type::CLAMP_MIN_MAX["min_val"],
                                  type::CLAMP_MIN_MAX["max_val"]);
-        guid_mapping[output.guid] = guidO;
+        guid_mapping[guidO] = output.guid;
         break;
       }
       case type::KNOperatorType::KN_DIV_OP:
@@ -281,7 +289,7 @@ void from_json(json const &j, Graph &g) {
         jop.at("output_tensors")[0].at("guid").get_to(guidO);
         DTensor const &output = g.elementbinary(
             get_tensor_from_guid(guidA), get_tensor_from_guid(guidB), op_type);
-        guid_mapping[output.guid] = guidO;
+        guid_mapping[guidO] = output.guid;
         break;
       }
       case type::KNOperatorType::KN_REDUCTION_0_OP:
@@ -293,7 +301,7 @@ void from_json(json const &j, Graph &g) {
         DTensor const &output =
             g.reduction(get_tensor_from_guid(guid),
                         op_type - type::KNOperatorType::KN_REDUCTION_0_OP);
-        guid_mapping[output.guid] = guidO;
+        guid_mapping[guidO] = output.guid;
         break;
       }
       case type::KNOperatorType::KN_CUSTOMIZED_OP: {
@@ -315,7 +323,7 @@ void from_json(json const &j, Graph &g) {
         for (size_t i = 0; i < outputs.size(); ++i) {
           size_t guidO;
           jop.at("output_tensors")[i].at("guid").get_to(guidO);
-          guid_mapping[outputs[i].guid] = guidO;
+          guid_mapping[guidO] = outputs[i].guid;
         }
 
         break;
@@ -26,7 +26,7 @@ DTensor Graph::new_input(std::vector<int> const &dims,
                          mirage::layout::DmemLayout layout) {
   KNOperator *op = create_input_op(dims, strides, data_type, layout);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return op->output_tensors[0];
 }
 
@@ -36,7 +36,7 @@ DTensor *Graph::new_input_ptr(std::vector<int> const &dims,
                               mirage::layout::DmemLayout layout) {
   KNOperator *op = create_input_op(dims, strides, data_type, layout);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return &op->output_tensors[0];
 }
 
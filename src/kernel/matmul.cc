@@ -27,7 +27,7 @@ namespace kernel {
 DTensor Graph::matmul(DTensor const &A, DTensor const &B) {
   KNOperator *op = create_matmul_op(A, B);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   DTensor output = op->output_tensors[0];
   return output;
 }
@@ -35,7 +35,7 @@ DTensor Graph::matmul(DTensor const &A, DTensor const &B) {
 DTensor *Graph::matmul(DTensor const *A, DTensor const *B) {
   KNOperator *op = create_matmul_op(*A, *B);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return &op->output_tensors[0];
 }
 
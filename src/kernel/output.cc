@@ -41,14 +41,14 @@ void Graph::mark_output(DTensor const *A) {
 void Graph::mark_output(DTensor const &A, std::vector<size_t> const &strides) {
   KNOperator *op = create_output_op(A, strides);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   assert(op->output_tensors.size() == 0);
 }
 
 void Graph::mark_output(DTensor const *A, std::vector<size_t> const &strides) {
   KNOperator *op = create_output_op(*A, strides);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   assert(op->output_tensors.size() == 0);
 }
 
@@ -28,7 +28,7 @@ using namespace mirage::type;
 DTensor Graph::reduction(DTensor const &input, int dim, int size) {
   KNOperator *op = create_reduction_op(input, dim, size);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   assert(op->output_tensors.size() == 1);
   DTensor output = op->output_tensors[0];
   return output;
@@ -37,7 +37,7 @@ DTensor Graph::reduction(DTensor const &input, int dim, int size) {
 DTensor *Graph::reduction(DTensor const *input, int dim, int size) {
   KNOperator *op = create_reduction_op(*input, dim, size);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   assert(op->output_tensors.size() == 1);
   return &op->output_tensors[0];
 }
@@ -29,7 +29,7 @@ DTensor Graph::rms_norm(DTensor const &input,
                         std::vector<int> const &normalized_shape) {
   KNOperator *op = create_rms_norm_op(input, normalized_shape);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   assert(op->output_tensors.size() == 1);
   DTensor output = op->output_tensors[0];
   return output;
@@ -39,7 +39,7 @@ DTensor *Graph::rms_norm(DTensor const *input,
                          std::vector<int> const &normalized_shape) {
   KNOperator *op = create_rms_norm_op(*input, normalized_shape);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   assert(op->output_tensors.size() == 1);
   return &op->output_tensors[0];
 }
@@ -50,7 +50,7 @@ DTensor Graph::rms_norm(DTensor const &input,
   KNOperator *op =
       create_rms_norm_op(input, elementwise_affine, normalized_shape);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   assert(op->output_tensors.size() == 1);
   DTensor output = op->output_tensors[0];
   return output;
@@ -62,7 +62,7 @@ DTensor *Graph::rms_norm(DTensor const *input,
   KNOperator *op =
       create_rms_norm_op(*input, *elementwise_affine, normalized_shape);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   assert(op->output_tensors.size() == 1);
   return &op->output_tensors[0];
 }
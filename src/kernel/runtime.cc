@@ -14,10 +14,13 @@
  */
 
 #include "mirage/kernel/graph.h"
+#include "mirage/kernel/task_graph_verifier.h"
 #include "mirage/kernel/task_register.h"
 #include "mirage/transpiler/utils.h"
 #include "mirage/utils/json_utils.h"
+#include <numeric>
 #include <queue>
+#include <set>
 
 namespace mirage {
 namespace kernel {
@@ -46,114 +49,248 @@ struct Dim3Comparator {
   }
 };
 
-void dfs_create_events_add_tasks(
-    int depth,
-    int const my_gpu_id,
-    std::vector<int> const &event_dims,
-    int3 const input_map,
-    int3 const output_map,
-    dim3 const consumer_grid_dim,
-    dim3 const producer_grid_dim,
-    dim3 consumer_lo_bid,
-    dim3 consumer_hi_bid,
-    dim3 producer_lo_bid,
-    dim3 producer_hi_bid,
-    std::vector<EventDesc> &all_events,
-    std::vector<TaskDesc> &all_tasks,
-    std::vector<TaskDesc> const &cur_op_tasks,
-    std::map<dim3, TaskId, Dim3Comparator> const &pre_task_map,
-    std::map<dim3, TaskId, Dim3Comparator> &cur_task_map) {
+// The tasks of a customized op that access a DTensor through one of its
+// TBInputOps, indexed by the blockIdx of the op
+struct TensorAccess {
+  dim3 grid_dim;
+  int3 input_map;
+  std::map<dim3, std::vector<TaskId>, Dim3Comparator> tasks;
+};
+
+// Accesses to a DTensor since the start of the task graph
+struct TensorAccessHistory {
+  bool has_writer = false;
+  TensorAccess last_writer;
+  std::vector<TensorAccess> readers_since_last_write;
+};
+
+// Every task has an output port (its trigger_event) and an input port (its
+// dependent_event). Ports in the same set share one event: the tasks of the
+// input ports wait for all tasks of the output ports. Ranks increase along
+// dependencies, and a set may only be formed if its output ports rank below
+// its input ports, so that tasks never wait on each other in a cycle
+size_t get_out_port(TaskId task_id) {
+  return 2 * task_id;
+}
+
+size_t get_in_port(TaskId task_id) {
+  return 2 * task_id + 1;
+}
+
+struct TaskPortSets {
+  void add_task(uint64_t rank) {
+    // output port, then input port
+    parents.push_back(parents.size());
+    max_out_ranks.push_back(rank);
+    min_in_ranks.push_back(NO_INPUT_RANK);
+    parents.push_back(parents.size());
+    max_out_ranks.push_back(NO_OUTPUT_RANK);
+    min_in_ranks.push_back(rank);
+  }
+
+  size_t find(size_t port) {
+    while (parents[port] != port) {
+      parents[port] = parents[parents[port]];
+      port = parents[port];
+    }
+    return port;
+  }
+
+  bool can_merge(std::vector<size_t> const &ports) {
+    uint64_t max_out_rank = NO_OUTPUT_RANK, min_in_rank = NO_INPUT_RANK;
+    for (size_t const &port : ports) {
+      size_t root = find(port);
+      max_out_rank = std::max(max_out_rank, max_out_ranks[root]);
+      min_in_rank = std::min(min_in_rank, min_in_ranks[root]);
+    }
+    return max_out_rank < min_in_rank;
+  }
+
+  void merge(size_t a, size_t b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) {
+      return;
+    }
+    assert(can_merge({a, b}));
+    size_t root = std::min(a, b), child = std::max(a, b);
+    parents[child] = root;
+    max_out_ranks[root] = std::max(max_out_ranks[root], max_out_ranks[child]);
+    min_in_ranks[root] = std::min(min_in_ranks[root], min_in_ranks[child]);
+  }
+
+  bool has_input_ports(size_t port) {
+    return min_in_ranks[find(port)] != NO_INPUT_RANK;
+  }
+
+  static constexpr uint64_t NO_OUTPUT_RANK = 0;
+  static constexpr uint64_t NO_INPUT_RANK = UINT64_MAX;
+  std::vector<size_t> parents;
+  // Valid for the root of each set
+  std::vector<uint64_t> max_out_ranks, min_in_ranks;
+};
+
+// The producer tasks each consumer task has to wait for
+using TaskDependencies = std::map<TaskId, std::set<TaskId>>;
+
+void dfs_add_dependencies(int depth,
+                          std::vector<int> const &event_dims,
+                          TensorAccess const &producer,
+                          TensorAccess const &consumer,
+                          dim3 consumer_lo_bid,
+                          dim3 consumer_hi_bid,
+                          dim3 producer_lo_bid,
+                          dim3 producer_hi_bid,
+                          TaskDependencies &dependencies) {
   if (depth >= mirage::config::MAX_TENSOR_DIMS) {
-    EventDesc event_desc;
-    event_desc.num_triggers = 0;
-    event_desc.first_task_id = all_tasks.size();
-    // Add consumer tasks
+    // All consumer tasks in the box wait for all producer tasks in the box
+    std::vector<TaskId> producer_tasks;
     dim3 bid;
-    for (bid.x = consumer_lo_bid.x; bid.x < consumer_hi_bid.x; bid.x++) {
-      for (bid.y = consumer_lo_bid.y; bid.y < consumer_hi_bid.y; bid.y++) {
-        for (bid.z = consumer_lo_bid.z; bid.z < consumer_hi_bid.z; bid.z++) {
-          cur_task_map[bid] = all_tasks.size();
-          int offset = bid.x * consumer_grid_dim.y * consumer_grid_dim.z +
-                       bid.y * consumer_grid_dim.z + bid.z;
-          all_tasks.push_back(cur_op_tasks[offset]);
-        }
-      }
-    }
-    event_desc.last_task_id = all_tasks.size();
-    // Set producer tasks
     for (bid.x = producer_lo_bid.x; bid.x < producer_hi_bid.x; bid.x++) {
       for (bid.y = producer_lo_bid.y; bid.y < producer_hi_bid.y; bid.y++) {
         for (bid.z = producer_lo_bid.z; bid.z < producer_hi_bid.z; bid.z++) {
-          assert(pre_task_map.find(bid) != pre_task_map.end());
-          int task_id = pre_task_map.find(bid)->second;
-          // encode gpu_id
-          all_tasks[task_id].trigger_event = get_event_id(
-              my_gpu_id, all_events.size(), false /*nvshmem_event*/);
-          event_desc.num_triggers++;
+          assert(producer.tasks.find(bid) != producer.tasks.end());
+          for (TaskId const &task_id : producer.tasks.find(bid)->second) {
+            producer_tasks.push_back(task_id);
+          }
+        }
+      }
+    }
+    for (bid.x = consumer_lo_bid.x; bid.x < consumer_hi_bid.x; bid.x++) {
+      for (bid.y = consumer_lo_bid.y; bid.y < consumer_hi_bid.y; bid.y++) {
+        for (bid.z = consumer_lo_bid.z; bid.z < consumer_hi_bid.z; bid.z++) {
+          assert(consumer.tasks.find(bid) != consumer.tasks.end());
+          for (TaskId const &task_id : consumer.tasks.find(bid)->second) {
+            dependencies[task_id].insert(producer_tasks.begin(),
+                                         producer_tasks.end());
+          }
         }
       }
     }
-    event_desc.event_type =
-        event_desc.last_task_id >= event_desc.first_task_id + 8
-            ? EVENT_LAUNCH_MASSIVE_TASKS
-            : EVENT_LAUNCH_TASKS;
-    all_events.push_back(event_desc);
   } else {
+    int3 const &input_map = consumer.input_map;
+    int3 const &output_map = producer.input_map;
     for (int i = 0; i < event_dims[depth]; i++) {
       dim3 new_consumer_lo_bid = consumer_lo_bid;
       dim3 new_consumer_hi_bid = consumer_hi_bid;
       dim3 new_producer_lo_bid = producer_lo_bid;
       dim3 new_producer_hi_bid = producer_hi_bid;
       if (depth == input_map.x) {
-        int factor = consumer_grid_dim.x / event_dims[depth];
+        int factor = consumer.grid_dim.x / event_dims[depth];
         new_consumer_lo_bid.x = i * factor;
         new_consumer_hi_bid.x = (i + 1) * factor;
       }
       if (depth == input_map.y) {
-        int factor = consumer_grid_dim.y / event_dims[depth];
+        int factor = consumer.grid_dim.y / event_dims[depth];
         new_consumer_lo_bid.y = i * factor;
         new_consumer_hi_bid.y = (i + 1) * factor;
       }
       if (depth == input_map.z) {
-        int factor = consumer_grid_dim.z / event_dims[depth];
+        int factor = consumer.grid_dim.z / event_dims[depth];
         new_consumer_lo_bid.z = i * factor;
         new_consumer_hi_bid.z = (i + 1) * factor;
       }
       if (depth == output_map.x) {
-        int factor = producer_grid_dim.x / event_dims[depth];
+        int factor = producer.grid_dim.x / event_dims[depth];
         new_producer_lo_bid.x = i * factor;
         new_producer_hi_bid.x = (i + 1) * factor;
       }
       if (depth == output_map.y) {
-        int factor = producer_grid_dim.y / event_dims[depth];
+        int factor = producer.grid_dim.y / event_dims[depth];
         new_producer_lo_bid.y = i * factor;
         new_producer_hi_bid.y = (i + 1) * factor;
       }
       if (depth == output_map.z) {
-        int factor = producer_grid_dim.z / event_dims[depth];
+        int factor = producer.grid_dim.z / event_dims[depth];
         new_producer_lo_bid.z = i * factor;
         new_producer_hi_bid.z = (i + 1) * factor;
       }
-      dfs_create_events_add_tasks(depth + 1,
-                                  my_gpu_id,
-                                  event_dims,
-                                  input_map,
-                                  output_map,
-                                  consumer_grid_dim,
-                                  producer_grid_dim,
-                                  new_consumer_lo_bid,
-                                  new_consumer_hi_bid,
-                                  new_producer_lo_bid,
-                                  new_producer_hi_bid,
-                                  all_events,
-                                  all_tasks,
-                                  cur_op_tasks,
-                                  pre_task_map,
-                                  cur_task_map);
+      dfs_add_dependencies(depth + 1,
+                           event_dims,
+                           producer,
+                           consumer,
+                           new_consumer_lo_bid,
+                           new_consumer_hi_bid,
+                           new_producer_lo_bid,
+                           new_producer_hi_bid,
+                           dependencies);
     }
   }
 }
 
+// Make the consumer's tasks wait for the producer's tasks that access the
+// same part of a DTensor
+void add_dependencies(TensorAccess const &producer,
+                      TensorAccess const &consumer,
+                      TaskDependencies &dependencies) {
+  // Step 1: analyze dependencies between thread blocks of the two ops
+  std::vector<int> producer_partition(mirage::config::MAX_TENSOR_DIMS, 1);
+  std::vector<int> consumer_partition(mirage::config::MAX_TENSOR_DIMS, 1);
+  int3 const &input_map = consumer.input_map;
+  int3 const &output_map = producer.input_map;
+  for (int d = 0; d < mirage::config::MAX_TENSOR_DIMS; d++) {
+    if (d == input_map.x) {
+      consumer_partition[d] = consumer.grid_dim.x;
+    }
+    if (d == input_map.y) {
+      consumer_partition[d] = consumer.grid_dim.y;
+    }
+    if (d == input_map.z) {
+      consumer_partition[d] = consumer.grid_dim.z;
+    }
+    if (d == output_map.x) {
+      producer_partition[d] = producer.grid_dim.x;
+    }
+    if (d == output_map.y) {
+      producer_partition[d] = producer.grid_dim.y;
+    }
+    if (d == output_map.z) {
+      producer_partition[d] = producer.grid_dim.z;
+    }
+  }
+  // Step 2: connect tasks block by block
+  // number of blocks is the product of gcd of producer/consumer
+  std::vector<int> event_dims(mirage::config::MAX_TENSOR_DIMS, 1);
+  for (int d = 0; d < mirage::config::MAX_TENSOR_DIMS; d++) {
+    event_dims[d] = std::gcd(producer_partition[d], consumer_partition[d]);
+  }
+  dfs_add_dependencies(0, /*depth*/
+                       event_dims,
+                       producer,
+                       consumer,
+                       dim3(0, 0, 0),     /*consumer_lo_bid*/
+                       consumer.grid_dim, /*consumer_hi_bid*/
+                       dim3(0, 0, 0),     /*producer_lo_bid*/
+                       producer.grid_dim, /*producer_hi_bid*/
+                       dependencies);
+}
+
+TensorAccess get_tensor_access(
+    tb::TBInputOp const *tb_op,
+    dim3 const &grid_dim,
+    std::map<dim3, std::vector<TaskId>, Dim3Comparator> const &tasks) {
+  TensorAccess access;
+  access.grid_dim = grid_dim;
+  access.input_map = tb_op->input_map;
+  access.tasks = tasks;
+  return access;
+}
+
+// Task types whose implementations only access their input and output
+// tensors. The others read the decoding step or the tokens from the
+// RuntimeConfig, or communicate with other GPUs
+bool only_accesses_tensors(TaskType task_type) {
+  switch (task_type) {
+    case TASK_RMS_NORM_LINEAR:
+    case TASK_SILU_MUL_LINEAR_WITH_RESIDUAL:
+    case TASK_LINEAR_WITH_RESIDUAL:
+    case TASK_ARGMAX_PARTIAL:
+      return true;
+    default:
+      return false;
+  }
+}
+
 void register_mugraph(
     mirage::kernel::Graph const &graph,
     int num_gpus,
@@ -174,9 +311,118 @@ void register_mugraph(
     all_tasks.push_back(t);
     all_events.push_back(e);
   }
-  std::vector<tb::TBInputOp *> pre_output_ops;
-  kn::KNCustomizedOp const *pre_op = nullptr;
-  std::map<dim3, TaskId, Dim3Comparator> pre_task_map;
+  // Dependencies are derived from all earlier accesses to the DTensors of
+  // an op (read-after-write, write-after-write and write-after-read), so
+  // independent ops do not wait for each other
+  std::map<type::GuidType, TensorAccessHistory> tensor_histories;
+  TaskPortSets port_sets;
+  for (size_t t = 0; t < all_tasks.size(); t++) {
+    port_sets.add_task(0 /*rank*/);
+  }
+  // DTensors written by some op. All other DTensors (e.g., weights) keep
+  // their values across iterations, and tasks that only read them are
+  // weight-only
+  std::unordered_set<type::GuidType> written_tensors;
+  for (auto const &op : graph.operators) {
+    if (op->op_type != type::KNOperatorType::KN_CUSTOMIZED_OP) {
+      continue;
+    }
+    std::tuple<int, int, TaskType, int> task_config =
+        task_configs.find(op)->second;
+    tb::Graph const &bgraph =
+        static_cast<kn::KNCustomizedOp const *>(op)->bgraph;
+    for (size_t i = 0; i < bgraph.operators.size(); i++) {
+      // The allgather tasks of an allreduce also write its buffer
+      if (i >= (size_t)std::get<0>(task_config) ||
+          std::get<2>(task_config) == TASK_ALLREDUCE) {
+        written_tensors.insert(
+            static_cast<tb::TBInputOp *>(bgraph.operators[i])->dtensor.guid);
+      }
+    }
+  }
+  // The tasks of the i-th customized op rank as (i << 32 | sub_rank)
+  uint64_t op_rank = 0;
+  uint32_t num_relay_tasks = 0;
+  auto add_task = [&](TaskDesc const &task, uint32_t sub_rank) {
+    all_tasks.push_back(task);
+    port_sets.add_task((op_rank << 32) | sub_rank);
+    return static_cast<TaskId>(all_tasks.size() - 1);
+  };
+  // Consumer tasks with the same producer tasks wait on the same event.
+  // They join the events of their producers if ranks stay ordered, and
+  // otherwise get an event of their own; producers that already trigger
+  // an event with dependent tasks are then forwarded by relay tasks
+  auto connect_tasks = [&](TaskDependencies const &dependencies) {
+    std::map<std::set<TaskId>, std::vector<TaskId>> consumer_groups;
+    for (auto const &it : dependencies) {
+      consumer_groups[it.second].push_back(it.first);
+    }
+    for (auto const &group : consumer_groups) {
+      std::vector<size_t> ports;
+      for (TaskId const &t : group.second) {
+        ports.push_back(get_in_port(t));
+      }
+      for (TaskId const &t : group.first) {
+        ports.push_back(get_out_port(t));
+      }
+      if (port_sets.can_merge(ports)) {
+        for (size_t const &port : ports) {
+          port_sets.merge(ports[0], port);
+        }
+        continue;
+      }
+      size_t event_port = get_in_port(group.second[0]);
+      for (TaskId const &t : group.second) {
+        port_sets.merge(event_port, get_in_port(t));
+      }
+      std::set<size_t> producer_sets;
+      for (TaskId const &t : group.first) {
+        producer_sets.insert(port_sets.find(get_out_port(t)));
+      }
+      for (size_t const &producer_set : producer_sets) {
+        if (!port_sets.has_input_ports(producer_set)) {
+          port_sets.merge(event_port, producer_set);
+        } else {
+          TaskId relay = add_task(TaskDesc(TASK_RELAY_EVENT, 0 /*variant_id*/),
+                                  num_relay_tasks++);
+          port_sets.merge(producer_set, get_in_port(relay));
+          port_sets.merge(event_port, get_out_port(relay));
+        }
+      }
+    }
+  };
+  // Add the dependencies of the accesses of one op, then record them
+  auto add_accesses =
+      [&](std::vector<std::pair<type::GuidType, TensorAccess>> const &reads,
+          std::vector<std::pair<type::GuidType, TensorAccess>> const &writes) {
+        TaskDependencies dependencies;
+        for (auto const &it : reads) {
+          TensorAccessHistory const &history = tensor_histories[it.first];
+          if (history.has_writer) {
+            add_dependencies(history.last_writer, it.second, dependencies);
+          }
+        }
+        for (auto const &it : writes) {
+          TensorAccessHistory const &history = tensor_histories[it.first];
+          if (history.has_writer) {
+            add_dependencies(history.last_writer, it.second, dependencies);
+          }
+          for (auto const &reader : history.readers_since_last_write) {
+            add_dependencies(reader, it.second, dependencies);
+          }
+        }
+        connect_tasks(dependencies);
+        for (auto const &it : reads) {
+          tensor_histories[it.first].readers_since_last_write.push_back(
+              it.second);
+        }
+        for (auto const &it : writes) {
+          TensorAccessHistory &history = tensor_histories[it.first];
+          history.has_writer = true;
+          history.last_writer = it.second;
+          history.readers_since_last_write.clear();
+        }
+      };
   for (auto const &op : graph.operators) {
     if (op->op_type == type::KNOperatorType::KN_INPUT_OP) {
       continue;
@@ -184,13 +430,14 @@ void register_mugraph(
     std::tuple<int, int, TaskType, int> task_config =
         task_configs.find(op)->second;
     std::map<dim3, TaskId, Dim3Comparator> cur_task_map;
+    op_rank++;
+    num_relay_tasks = 0;
     assert(op->op_type == type::KNOperatorType::KN_CUSTOMIZED_OP);
     // Customized op
     kn::KNCustomizedOp const *cur_op =
         dynamic_cast<kn::KNCustomizedOp const *>(op);
     tb::Graph const &bgraph = cur_op->bgraph;
     dim3 bid;
-    std::vector<TaskDesc> tasks;
     std::vector<tb::TBInputOp *> input_ops;
     std::vector<tb::TBInputOp *> output_ops;
     int num_inputs = std::get<0>(task_config);
@@ -206,45 +453,24 @@ void register_mugraph(
         output_ops.push_back(static_cast<tb::TBInputOp *>(op));
       }
     }
+    bool weight_only = only_accesses_tensors(task_type);
+    for (auto const &input : input_ops) {
+      if (written_tensors.count(input->dtensor.guid) > 0) {
+        weight_only = false;
+      }
+    }
     // Specical handling for ALLREDUCE
     if (task_type == TASK_ALLREDUCE) {
       // Shouldn't have AllReduce when num_gpus == 1
       assert(num_gpus > 1);
       assert(input_ops.size() == 2);
       assert(output_ops.size() == 1);
-      // To simplify the implementation, asserting that
-      // produce/consumer must have the same partition
-      int num_shared_tensors = 0;
-      int3 input_map, output_map;
-      for (auto const &input : input_ops) {
-        for (auto const &output : pre_output_ops) {
-          if (input->dtensor.guid == output->dtensor.guid) {
-            input_map = input->input_map;
-            output_map = output->input_map;
-            num_shared_tensors++;
-          }
-        }
-      }
-      assert(num_shared_tensors == 1);
-      assert(input_map == output_map);
-      assert(bgraph.grid_dim == pre_op->bgraph.grid_dim);
       dim3 bid;
+      std::map<dim3, std::vector<TaskId>, Dim3Comparator> ag_tasks;
       std::map<dim3, std::map<int, TaskId>, Dim3Comparator> ag_pre_task_map;
       for (bid.x = 0; bid.x < bgraph.grid_dim.x; bid.x++) {
         for (bid.y = 0; bid.y < bgraph.grid_dim.y; bid.y++) {
           for (bid.z = 0; bid.z < bgraph.grid_dim.z; bid.z++) {
-            // event_desc_0 is the trigger_event of previous_task
-            // event_desc_1 is the trigger_event of allgather
-            EventDesc event_desc_0;
-            event_desc_0.event_type = EVENT_LAUNCH_TASKS;
-            event_desc_0.num_triggers = 1;
-            event_desc_0.first_task_id = all_tasks.size();
-            event_desc_0.last_task_id = all_tasks.size() + num_gpus - 1;
-            assert(pre_task_map.find(bid) != pre_task_map.end());
-            int task_id = pre_task_map.find(bid)->second;
-            all_tasks[task_id].trigger_event =
-                get_event_id(my_gpu_id, all_events.size(), false);
-            all_events.push_back(event_desc_0);
             // Step 1: create (num_gpus - 1) tasks for allgather
             std::map<int, TaskId> pre_tasks;
             for (int tgt_gpu_id = 0; tgt_gpu_id < num_gpus; tgt_gpu_id++) {
@@ -252,8 +478,6 @@ void register_mugraph(
                 continue;
               }
               TaskDesc task(TASK_NVSHMEM_COPY, 0 /*variant_id*/);
-              // task.trigger_event = get_event_id(
-              //     tgt_gpu_id, all_events.size(), true /*nvshmem_event*/);
               //  Initialize input tensors to the task
               {
                 TensorDesc desc;
@@ -286,19 +510,21 @@ void register_mugraph(
                 }
                 task.outputs[task.num_outputs++] = desc;
               }
-              all_tasks.push_back(task);
-              pre_tasks[tgt_gpu_id] = all_tasks.size() - 1;
+              pre_tasks[tgt_gpu_id] = add_task(task, UINT32_MAX - 1);
+              ag_tasks[bid].push_back(pre_tasks[tgt_gpu_id]);
             } // for tgt_gpu_id
             ag_pre_task_map[bid] = pre_tasks;
           } // for bid.z
         }   // for bid.y
       }     // for bid.x
+      std::map<dim3, std::vector<TaskId>, Dim3Comparator> reduce_tasks;
       for (bid.x = 0; bid.x < bgraph.grid_dim.x; bid.x++) {
         for (bid.y = 0; bid.y < bgraph.grid_dim.y; bid.y++) {
           for (bid.z = 0; bid.z < bgraph.grid_dim.z; bid.z++) {
-            // event_desc_1 is the trigger_event of allgather
+            // event_desc_1 is the trigger_event of allgather, which is
+            // activated by the allgather tasks of the other GPUs
             EventDesc event_desc_1;
-            event_desc_1.event_type = EVENT_LAUNCH_TASKS;
+            event_desc_1.event_type = EVENT_EMPTY;
             event_desc_1.first_task_id = all_tasks.size();
             event_desc_1.last_task_id = all_tasks.size() + 1;
             event_desc_1.num_triggers = num_gpus - 1;
@@ -308,9 +534,11 @@ void register_mugraph(
               all_tasks[t.second].trigger_event =
                   get_event_id(t.first, all_events.size(), true);
             }
-            all_events.push_back(event_desc_1);
             // Step 2: create a task for reduce
             TaskDesc task(TASK_REDUCE, 0 /*variant_id*/);
+            task.dependent_event = get_event_id(
+                my_gpu_id, all_events.size(), false /*nvshmem_event*/);
+            all_events.push_back(event_desc_1);
             for (int i = 0; i < 2; i++) {
               TensorDesc desc;
               tb::STensor stensor = input_ops[i]->output_tensors[0];
@@ -339,25 +567,35 @@ void register_mugraph(
                                            output_ops[0]->dtensor.dim[d + 1];
               }
               task.inputs[task.num_outputs++] = desc;
-              all_tasks.push_back(task);
               // Update current task map
-              cur_task_map[bid] = all_tasks.size() - 1;
+              cur_task_map[bid] = add_task(task, UINT32_MAX);
+              reduce_tasks[bid].push_back(cur_task_map[bid]);
             }
           }
         }
       }
-      pre_output_ops = output_ops;
-      pre_op = cur_op;
-      pre_task_map = cur_task_map;
+      // The allgather tasks read the local input. The reduce tasks write
+      // the output, but can only wait on their NVSHMEM events, so the
+      // allgather tasks also wait for earlier accesses to the output. The
+      // buffer is only accessed through NVSHMEM
+      add_accesses(
+          {{input_ops[0]->dtensor.guid,
+            get_tensor_access(input_ops[0], bgraph.grid_dim, ag_tasks)}},
+          {{output_ops[0]->dtensor.guid,
+            get_tensor_access(output_ops[0], bgraph.grid_dim, ag_tasks)}});
+      tensor_histories[output_ops[0]->dtensor.guid].last_writer =
+          get_tensor_access(output_ops[0], bgraph.grid_dim, reduce_tasks);
       all_task_maps.emplace(op, cur_task_map);
       continue;
     }
     // Step 1: add all tasks based on their blockIdx
     // (bid.x, bid.y, bid.z) ordering
+    std::map<dim3, std::vector<TaskId>, Dim3Comparator> tasks;
     for (bid.x = 0; bid.x < bgraph.grid_dim.x; bid.x++) {
       for (bid.y = 0; bid.y < bgraph.grid_dim.y; bid.y++) {
         for (bid.z = 0; bid.z < bgraph.grid_dim.z; bid.z++) {
           TaskDesc task(task_type, variant_id);
+          task.weight_only = weight_only;
           // Initialize input tensors to the task
           for (auto const &input : input_ops) {
             TensorDesc desc;
@@ -390,159 +628,172 @@ void register_mugraph(
             }
             task.outputs[task.num_outputs++] = desc;
           }
-          tasks.push_back(task);
+          cur_task_map[bid] = add_task(task, UINT32_MAX);
+          tasks[bid].push_back(cur_task_map[bid]);
         }
       }
     }
-    // Step 2: create events between operators
-    if (pre_op == nullptr) {
-      // Assert that the first op launches a single task
-      assert(tasks.size() == 1);
-      first_tasks.push_back(all_tasks.size());
-      cur_task_map[dim3(0, 0, 0)] = all_tasks.size();
-      all_tasks.push_back(tasks[0]);
-    } else {
-      // Step 2.1: analyze dependencies between thread blocks of the two ops
-      std::vector<int> producer_partition(mirage::config::MAX_TENSOR_DIMS, 1);
-      std::vector<int> consumer_partition(mirage::config::MAX_TENSOR_DIMS, 1);
-      int num_shared_tensors = 0;
-      int3 input_map, output_map;
-      for (auto const &input : input_ops) {
-        for (auto const &output : pre_output_ops) {
-          if (input->dtensor.guid == output->dtensor.guid) {
-            input_map = input->input_map;
-            output_map = output->input_map;
-            num_shared_tensors++;
-          }
-        }
+    // Step 2: add dependencies on the earlier ops that access the same
+    // DTensors
+    std::vector<std::pair<type::GuidType, TensorAccess>> reads, writes;
+    for (auto const &input : input_ops) {
+      reads.push_back({input->dtensor.guid,
+                       get_tensor_access(input, bgraph.grid_dim, tasks)});
+    }
+    for (auto const &output : output_ops) {
+      writes.push_back({output->dtensor.guid,
+                        get_tensor_access(output, bgraph.grid_dim, tasks)});
+    }
+    add_accesses(reads, writes);
+    all_task_maps.emplace(op, cur_task_map);
+  }
+
+  // Step 3: create an event for each set of connected ports. Tasks whose
+  // output port is unconnected trigger the end of the task graph, and
+  // tasks whose input port is unconnected have no dependent event. All
+  // tasks are prelaunched at the begining of an iteration, so the events
+  // launch no tasks themselves
+  size_t num_ports = port_sets.parents.size();
+  std::vector<int> num_in_ports(num_ports, 0);
+  std::vector<int> num_out_ports(num_ports, 0);
+  std::vector<TaskId> first_in_task(num_ports, TASK_INVALID_ID);
+  std::vector<TaskId> last_in_task(num_ports, 0);
+  std::vector<int> set_sizes(num_ports, 0);
+  for (size_t port = 0; port < num_ports; port++) {
+    set_sizes[port_sets.find(port)]++;
+  }
+  for (TaskId t = 2; t < all_tasks.size(); t++) {
+    // Ports already bound to the NVSHMEM events of an allreduce cannot
+    // take other dependencies
+    if (all_tasks[t].trigger_event != EVENT_INVALID_ID) {
+      assert(set_sizes[port_sets.find(get_out_port(t))] == 1);
+    }
+    if (all_tasks[t].dependent_event != EVENT_INVALID_ID) {
+      assert(set_sizes[port_sets.find(get_in_port(t))] == 1);
+    }
+    if (all_tasks[t].trigger_event == EVENT_INVALID_ID) {
+      num_out_ports[port_sets.find(get_out_port(t))]++;
+    }
+    if (all_tasks[t].dependent_event == EVENT_INVALID_ID) {
+      size_t root = port_sets.find(get_in_port(t));
+      num_in_ports[root]++;
+      first_in_task[root] = std::min(first_in_task[root], t);
+      last_in_task[root] = t + 1;
+    }
+  }
+  std::map<size_t, size_t> root_to_event_pos;
+  std::vector<TaskId> sink_tasks;
+  for (TaskId t = 2; t < all_tasks.size(); t++) {
+    if (all_tasks[t].trigger_event == EVENT_INVALID_ID) {
+      size_t root = port_sets.find(get_out_port(t));
+      if (num_in_ports[root] == 0) {
+        sink_tasks.push_back(t);
+        continue;
       }
-      // assert that their is at least a single tensor shared between ops
-      assert(num_shared_tensors >= 1);
-      for (int d = 0; d < mirage::config::MAX_TENSOR_DIMS; d++) {
-        if (d == input_map.x) {
-          consumer_partition[d] = bgraph.grid_dim.x;
-        }
-        if (d == input_map.y) {
-          consumer_partition[d] = bgraph.grid_dim.y;
-        }
-        if (d == input_map.z) {
-          consumer_partition[d] = bgraph.grid_dim.z;
-        }
-        if (d == output_map.x) {
-          producer_partition[d] = pre_op->bgraph.grid_dim.x;
-        }
-        if (d == output_map.y) {
-          producer_partition[d] = pre_op->bgraph.grid_dim.y;
-        }
-        if (d == output_map.z) {
-          producer_partition[d] = pre_op->bgraph.grid_dim.z;
-        }
+      if (root_to_event_pos.find(root) == root_to_event_pos.end()) {
+        // [first_task_id, last_task_id) spans all dependent tasks of the
+        // event, but may also include tasks of other events
+        root_to_event_pos[root] = all_events.size();
+        all_events.push_back(EventDesc(EVENT_EMPTY,
+                                       num_out_ports[root],
+                                       first_in_task[root],
+                                       last_in_task[root]));
       }
-      // Step 2.2: create events and add tasks
-      // number of events is the product of gcd of producer/consumer
-      std::vector<int> event_dims(mirage::config::MAX_TENSOR_DIMS, 1);
-      for (int d = 0; d < mirage::config::MAX_TENSOR_DIMS; d++) {
-        event_dims[d] = std::gcd(producer_partition[d], consumer_partition[d]);
+      all_tasks[t].trigger_event = get_event_id(
+          my_gpu_id, root_to_event_pos[root], false /*nvshmem_event*/);
+    }
+  }
+  for (TaskId t = 2; t < all_tasks.size(); t++) {
+    if (all_tasks[t].dependent_event == EVENT_INVALID_ID) {
+      size_t root = port_sets.find(get_in_port(t));
+      if (root_to_event_pos.find(root) == root_to_event_pos.end()) {
+        // A set with only input ports holds a single task
+        assert(num_in_ports[root] == 1);
+        first_tasks.push_back(t);
+      } else {
+        all_tasks[t].dependent_event = get_event_id(
+            my_gpu_id, root_to_event_pos[root], false /*nvshmem_event*/);
       }
-      dfs_create_events_add_tasks(0,                       /*depth*/
-                                  my_gpu_id,               /*my_gpu_id*/
-                                  event_dims,              /*event_dims*/
-                                  input_map,               /*input_map*/
-                                  output_map,              /*output_map*/
-                                  bgraph.grid_dim,         /*consumer_grid_dim*/
-                                  pre_op->bgraph.grid_dim, /*producer_grid_dim*/
-                                  dim3(0, 0, 0),           /*consumer_lo_bid*/
-                                  bgraph.grid_dim,         /*consumer_hi_bid*/
-                                  dim3(0, 0, 0),           /*producer_lo_bid*/
-                                  pre_op->bgraph.grid_dim, /*producer_hi_bid*/
-                                  all_events,
-                                  all_tasks,
-                                  tasks,        /*cur_op_tasks*/
-                                  pre_task_map, /*pre_task_map*/
-                                  cur_task_map /*cur_task_map)*/);
     }
-    pre_output_ops = output_ops;
-    pre_op = cur_op;
-    pre_task_map = cur_task_map;
-    all_task_maps.emplace(op, cur_task_map);
   }
-
-  // Update the trigger event for all tasks in pre_task_map
-  for (auto const &it : pre_task_map) {
-    all_tasks[it.second].trigger_event =
+  // Update the trigger event for all sink tasks
+  for (TaskId const &t : sink_tasks) {
+    all_tasks[t].trigger_event =
         get_event_id(my_gpu_id, all_events.size(), false /*nvshmem_event*/);
   }
   all_events.push_back(
-      EventDesc(EVENT_END_OF_TASK_GRAPH, pre_task_map.size(), 0, 0));
+      EventDesc(EVENT_END_OF_TASK_GRAPH, sink_tasks.size(), 0, 0));
 
   // Prelaunch all tasks at the begining of an iteration
   all_events[1].first_task_id = 2;
   all_events[1].last_task_id = all_tasks.size();
-  for (size_t e = 2; e < all_events.size(); e++) {
-    if (all_events[e].event_type == EVENT_LAUNCH_TASKS ||
-        all_events[e].event_type == EVENT_LAUNCH_MASSIVE_TASKS) {
-      all_events[e].event_type = EVENT_EMPTY;
-      for (size_t t = all_events[e].first_task_id;
-           t < all_events[e].last_task_id;
-           t++) {
-        all_tasks[t].dependent_event =
-            get_event_id(my_gpu_id, e, false /*nvshmem_event*/);
-      }
-    }
-  }
 }
 
 bool sanity_check(mirage::kernel::Graph const &graph,
                   std::vector<TaskDesc> const &all_tasks,
                   std::vector<EventDesc> const &all_events,
                   std::vector<TaskId> const &first_tasks) {
+  // Replay one iteration: the begin-task-graph task prelaunches all tasks,
+  // and each task runs once its dependent event has been activated. All
+  // GPUs run the same task graph, so an NVSHMEM event sent to another GPU
+  // is replayed as the symmetric event received from that GPU. depths[t]
+  // is the number of tasks on the longest dependency chain ending at t
   std::unordered_set<EventId> triggered_events;
   std::unordered_set<TaskId> executed_tasks;
   std::vector<int> event_counts(all_events.size(), 0);
+  std::vector<int> event_depths(all_events.size(), 0);
+  std::vector<std::vector<TaskId>> waiting_tasks(all_events.size());
+  std::vector<int> depths(all_tasks.size(), 0);
   for (size_t i = 0; i < all_events.size(); i++) {
     event_counts[i] = all_events[i].num_triggers;
   }
+  for (TaskId const &task : first_tasks) {
+    assert(all_tasks[task].dependent_event == EVENT_INVALID_ID);
+  }
   std::queue<TaskId> task_queue;
-  std::queue<EventId> event_queue;
-  assert(first_tasks.size() == 1);
-  task_queue.push(first_tasks[0]);
-  while (!(task_queue.empty() && event_queue.empty())) {
-    // Execute tasks
-    while (!task_queue.empty()) {
-      TaskId task = task_queue.front();
-      task_queue.pop();
-      assert(executed_tasks.count(task) == 0);
-      executed_tasks.insert(task);
-      TaskDesc desc = all_tasks[task];
-      if (desc.trigger_event != EVENT_INVALID_ID) {
-        EventId event_id = desc.trigger_event;
-        size_t event_pos = event_id & 0xffffffff;
-        // event_pos 0 is the end of task graph event
-        if (event_pos == 0) {
-          continue;
-        }
-        assert(event_counts[event_pos] > 0);
-        event_counts[event_pos]--;
-        if (event_counts[event_pos] == 0) {
-          event_queue.push(event_id);
+  task_queue.push(1);
+  int critical_path_length = 0;
+  while (!task_queue.empty()) {
+    TaskId task = task_queue.front();
+    task_queue.pop();
+    assert(executed_tasks.count(task) == 0);
+    executed_tasks.insert(task);
+    TaskDesc const &desc = all_tasks[task];
+    critical_path_length = std::max(critical_path_length, depths[task]);
+    if (desc.trigger_event == EVENT_INVALID_ID) {
+      continue;
+    }
+    size_t event_pos = desc.trigger_event & 0xffffffff;
+    assert(event_counts[event_pos] > 0);
+    event_depths[event_pos] = std::max(event_depths[event_pos], depths[task]);
+    event_counts[event_pos]--;
+    if (event_counts[event_pos] > 0) {
+      continue;
+    }
+    triggered_events.insert(event_pos);
+    EventDesc const &event = all_events[event_pos];
+    if (event.event_type == EVENT_LAUNCH_DEPENDENT_TASKS) {
+      for (TaskId tid = event.first_task_id; tid < event.last_task_id; tid++) {
+        if (all_tasks[tid].dependent_event == EVENT_INVALID_ID) {
+          task_queue.push(tid);
+          depths[tid] = 1;
+        } else {
+          size_t pos = all_tasks[tid].dependent_event & 0xffffffff;
+          waiting_tasks[pos].push_back(tid);
         }
       }
     }
-    while (!event_queue.empty()) {
-      EventId event_id = event_queue.front();
-      event_queue.pop();
-      assert(triggered_events.count(event_id) == 0);
-      triggered_events.insert(event_id);
-      size_t event_pos = event_id & 0xffffffff;
-      EventDesc desc = all_events[event_pos];
-      for (TaskId tid = desc.first_task_id; tid < desc.last_task_id; tid++) {
-        task_queue.push(tid);
-      }
+    for (TaskId const &tid : waiting_tasks[event_pos]) {
+      task_queue.push(tid);
+      depths[tid] = event_depths[event_pos] + 1;
     }
+    waiting_tasks[event_pos].clear();
   }
   printf("Triggered events: %zu\n", triggered_events.size());
   printf("Executed tasks: %zu\n", executed_tasks.size());
-  return true;
+  printf("Critical path: %d tasks\n", critical_path_length);
+  // Every task except the terminate task runs exactly once
+  return executed_tasks.size() + 1 == all_tasks.size();
 }
 
 TaskGraphResult print_task_graph(
@@ -557,17 +808,19 @@ TaskGraphResult print_task_graph(
     std::unordered_map<kn::KNOperator const *,
                        std::tuple<int, int, TaskType, int>> const &task_configs,
     std::map<mirage::type::GuidType, IODesc> const &io_configs,
-    bool use_json_format) {
+    bool use_task_graph_file,
+    bool use_cpu_backend,
+    bool verbose) {
   using mirage::runtime::IODesc;
   mirage::transpiler::CodeKeeper code;
-  mirage::transpiler::CodeKeeper tgbody;
-  tgbody.inc_indent();
-  code.e("#include \"persistent_kernel.cuh\"");
-  if (use_json_format) {
-    code.e("#include <nlohmann/json.hpp>");
-    code.e("#include <fstream>");
+  if (use_cpu_backend) {
+    code.e("#include \"cpu_persistent_kernel.h\"");
+  } else {
+    code.e("#include \"persistent_kernel.cuh\"");
+  }
+  if (use_task_graph_file) {
+    code.e("#include \"task_graph_file.h\"");
     code.e("#include <filesystem>");
-    code.e("using json = nlohmann::json;");
   }
   code.e("using namespace mirage::runtime;");
   code.e("size_t get_event_id(int my_gpu_id, size_t event_pos, bool "
@@ -581,137 +834,58 @@ TaskGraphResult print_task_graph(
   code.e("}");
   code.e("");
 
-  // function that loads json file and generates task graph
-  if (use_json_format) {
-    code.e("void construct_task_graph(int num_gpus,");
-    code.e("                          int my_gpu_id,");
-    code.e("                          std::vector<TaskDesc> &all_tasks,");
-    code.e("                          std::vector<EventDesc> &all_events,");
-    code.e("                          std::vector<TaskId> &first_tasks,");
-    code.e("                          std::map<std::string, void*> const "
-           "&all_tensors) {");
-    code.e("std::filesystem::path file_path(__FILE__);");
-    code.e("std::ifstream "
-           "json_file(file_path.parent_path().string()+\"/task_graph.json\");");
-    code.e("nlohmann::json json_task_graph;");
-    code.e("json_file >> json_task_graph;");
-    // load tasks
-    code.e("for (json const &task : json_task_graph[\"all_tasks\"]) {");
-    code.e("TaskDesc task_desc(static_cast<TaskType>(task.at(\"task_type\")),");
-    code.e("            task.at(\"variant_id\"));");
-    code.e("if (task.at(\"trigger_event\").is_number_integer()) {");
-    code.e("task_desc.trigger_event = task.at(\"trigger_event\").get<unsigned "
-           "long long int>();");
-    code.e("}");
-    code.e("else {");
-    code.e("assert(false);");
-    code.e("}");
-    code.e("if (task.at(\"dependent_event\").is_number_integer()) {");
-    code.e("task_desc.dependent_event = "
-           "task.at(\"dependent_event\").get<unsigned long long int>();");
-    code.e("}");
-    code.e("else {");
-    code.e("assert(false);");
-    code.e("}");
-
-    // load inputs
-    code.e("task_desc.num_inputs = 0;");
-    code.e("for (json const &tensor : task[\"inputs\"]) {");
-    code.e("TensorDesc input;");
-    code.e("std::string name = tensor.at(\"base_ptr\").get<std::string>();");
-    code.e("assert(all_tensors.find(name) != all_tensors.end());");
-    code.e("off_t offset = tensor.at(\"offset\").get<off_t>();");
-    code.e("input.base_ptr = static_cast<char*>(all_tensors.at(name))+offset;");
-    code.e(
-        "assert(tensor.at(\"dims\").size() == tensor.at(\"strides\").size());");
-    code.e("input.num_dims = tensor.at(\"dims\").size();");
-    code.e("input.data_type = tensor.at(\"data_type\").get<int>();");
-    code.e("for (int i = 0; i < input.num_dims; i++) {");
-    code.e("input.dim[i] = tensor[\"dims\"][i].get<int>();");
-    code.e("input.stride[i] = tensor[\"strides\"][i].get<int>();");
-    code.e("}");
-    code.e("task_desc.inputs[task_desc.num_inputs++] = input;");
-    code.e("}");
-    // load outputs
-    code.e("task_desc.num_outputs = 0;");
-    code.e("for (json const &tensor : task[\"outputs\"]) {");
-    code.e("TensorDesc output;");
-    code.e("std::string name = tensor.at(\"base_ptr\").get<std::string>();");
-    code.e("assert(all_tensors.find(name) != all_tensors.end());");
-    code.e("off_t offset = tensor.at(\"offset\").get<off_t>();");
-    code.e(
-        "output.base_ptr = static_cast<char*>(all_tensors.at(name))+offset;");
-    code.e(
-        "assert(tensor.at(\"dims\").size() == tensor.at(\"strides\").size());");
-    code.e("output.num_dims = tensor.at(\"dims\").size();");
-    code.e("output.data_type = tensor.at(\"data_type\").get<int>();");
-    code.e("for (int i = 0; i < output.num_dims; i++) {");
-    code.e("output.dim[i] = tensor[\"dims\"][i];");
-    code.e("output.stride[i] = tensor[\"strides\"][i];");
-    code.e("}");
-    code.e("task_desc.outputs[task_desc.num_outputs++] = output;");
-    code.e("}");
-    code.e("all_tasks.push_back(task_desc);");
-    code.e("}");
-    // load events
-    code.e("for (json const &e : json_task_graph[\"all_events\"]) {");
-    code.e("EventType event_type = "
-           "static_cast<EventType>(e.at(\"event_type\").get<int>());");
-    code.e("int num_triggers = e.at(\"num_triggers\").get<int>();");
-    code.e("int first_task_id = e.at(\"first_task_id\").get<int>();");
-    code.e("int last_task_id = e.at(\"last_task_id\").get<int>();");
-    code.e("all_events.push_back(EventDesc(event_type, num_triggers, "
-           "first_task_id, last_task_id));");
-    code.e("}");
-    // load first tasks
-    code.e("for (json const &t : json_task_graph[\"first_tasks\"]) {");
-    code.e("first_tasks.push_back(t.get<int>());");
-    code.e("}");
-    code.e("}");
-    code.e("");
-  }
-
-  code.e(
-      "static void _init_persistent_kernel(std::vector<TaskDesc> &all_tasks,");
-  code.e("                                    std::vector<EventDesc> "
+  code.e("static void _init_persistent_kernel(std::vector<CompactTaskDesc> "
+         "&all_tasks,");
+  code.e("                                  std::vector<TensorRef> "
+         "&all_tensor_refs,");
+  code.e("                                  std::vector<TensorDesc> "
+         "&all_tensor_descs,");
+  code.e("                                  std::vector<EventDesc> "
          "&all_events,");
   code.e("                                  std::vector<TaskId> &first_tasks,");
   code.e("                                  int num_gpus,");
   code.e("                                  int my_gpu_id) {");
-  code.e("assert(num_gpus = $);", num_gpus);
+  code.e(FMT_STR("assert(num_gpus = $);"), num_gpus);
 
-  if (use_json_format) {
+  if (use_task_graph_file) {
     code.e("std::map<std::string, void*> all_tensors;");
   }
   for (auto const &iter : io_configs) {
     IODesc desc = iter.second;
     switch (desc.type) {
       case IODesc::TorchTensor: {
-        code.e("char *$ = (char*)($);", desc.name, desc.torch_data_ptr);
-        if (use_json_format) {
-          code.e("all_tensors[\"$\"] = $;", desc.name, desc.name);
+        code.e(
+            FMT_STR("char *$ = (char*)($);"), desc.name, desc.torch_data_ptr);
+        if (use_task_graph_file) {
+          code.e(FMT_STR("all_tensors[\"$\"] = $;"), desc.name, desc.name);
         }
         break;
       }
       case IODesc::FusedTorchTensor: {
         for (auto const &sdesc : desc.sub_descs) {
-          code.e("char *$ = (char*)($);", sdesc.name, sdesc.torch_data_ptr);
-          if (use_json_format) {
-            code.e("all_tensors[\"$\"] = $;", sdesc.name, sdesc.name);
+          code.e(FMT_STR("char *$ = (char*)($);"),
+                 sdesc.name,
+                 sdesc.torch_data_ptr);
+          if (use_task_graph_file) {
+            code.e(FMT_STR("all_tensors[\"$\"] = $;"), sdesc.name, sdesc.name);
           }
         }
         break;
       }
       case IODesc::CUDAMallocTensor: {
-        code.e("void *$;", desc.name);
+        code.e(FMT_STR("void *$;"), desc.name);
         size_t size = mirage::type::get_datatype_size(
             static_cast<type::DataType>(desc.tensor.data_type));
         for (int i = 0; i < desc.tensor.num_dims; i++) {
           size *= desc.tensor.dim[i];
         }
-        code.e("cudaMalloc(&$, $);", desc.name, size);
-        if (use_json_format) {
-          code.e("all_tensors[\"$\"] = $;", desc.name, desc.name);
+        if (use_cpu_backend) {
+          code.e(FMT_STR("$ = std::calloc($, 1);"), desc.name, size);
+        } else {
+          code.e(FMT_STR("cudaMalloc(&$, $);"), desc.name, size);
+        }
+        if (use_task_graph_file) {
+          code.e(FMT_STR("all_tensors[\"$\"] = $;"), desc.name, desc.name);
         }
         break;
       }
@@ -721,9 +895,11 @@ TaskGraphResult print_task_graph(
         for (int i = 0; i < desc.tensor.num_dims; i++) {
           size *= desc.tensor.dim[i];
         }
-        code.e("void *$ = nvshmem_malloc($);", desc.name, size);
-        if (use_json_format) {
-          code.e("all_tensors[\"$\"] = $;", desc.name, desc.name);
+        // The CPU runtime runs on a single node
+        assert(!use_cpu_backend);
+        code.e(FMT_STR("void *$ = nvshmem_malloc($);"), desc.name, size);
+        if (use_task_graph_file) {
+          code.e(FMT_STR("all_tensors[\"$\"] = $;"), desc.name, desc.name);
         }
         break;
       }
@@ -735,18 +911,18 @@ TaskGraphResult print_task_graph(
       {"all_tasks", {}}, {"all_events", {}}, {"first_tasks", {}}};
   // generate task[0]
   {
-    tgbody.e("all_tasks.push_back(TaskDesc(TASK_TERMINATE));");
     json_task_graph["all_tasks"].push_back(
         json{{"task_type", TASK_TERMINATE},
              {"variant_id", 0},
              {"inputs", {}},
              {"outputs", {}},
              {"trigger_event", EVENT_INVALID_ID},
-             {"dependent_event", EVENT_INVALID_ID}});
+             {"dependent_event", EVENT_INVALID_ID},
+             {"weight_only", false},
+             {"pipelined", false}});
   }
   // generate task[1]
   {
-    tgbody.e("all_tasks.push_back(TaskDesc(TASK_BEGIN_TASK_GRAPH));");
     json_task_graph["all_tasks"].push_back(
         json{{"task_type", TASK_BEGIN_TASK_GRAPH},
              {"variant_id", 0},
@@ -754,7 +930,9 @@ TaskGraphResult print_task_graph(
              {"outputs", {}},
              {"trigger_event",
               get_event_id(my_gpu_id, 1 /*event_pos*/, false /*is_nvshmem*/)},
-             {"dependent_event", EVENT_INVALID_ID}});
+             {"dependent_event", EVENT_INVALID_ID},
+             {"weight_only", false},
+             {"pipelined", false}});
   }
   // generate all other tasks
   size_t task_pos = 2;
@@ -799,10 +977,6 @@ TaskGraphResult print_task_graph(
               }
               TaskDesc task_desc = all_tasks[task_pos];
               assert(task_desc.task_type == TASK_NVSHMEM_COPY);
-              tgbody.e("// task[$]", task_pos);
-              tgbody.e("{");
-              tgbody.e("TaskDesc task_desc(static_cast<TaskType>($));",
-                       task_desc.task_type);
               bool is_nvshmem_event =
                   ((task_desc.trigger_event & EVENT_NVSHMEM_TAG) > 0);
               assert(is_nvshmem_event);
@@ -814,7 +988,9 @@ TaskGraphResult print_task_graph(
                                 {"inputs", {}},
                                 {"outputs", {}},
                                 {"trigger_event", task_desc.trigger_event},
-                                {"dependent_event", task_desc.dependent_event}};
+                                {"dependent_event", task_desc.dependent_event},
+                                {"weight_only", task_desc.weight_only},
+                                {"pipelined", task_desc.pipelined}};
               off_t offset = 0;
               // Add input
               int3 input_map = input_ops[0]->input_map;
@@ -838,28 +1014,11 @@ TaskGraphResult print_task_graph(
                 offset +=
                     block_size * bid.z * io_desc.tensor.stride[input_map.z];
               }
-              tgbody.e("TensorDesc input$;", 0);
-              tgbody.e("input$.base_ptr = static_cast<char*>($) + $;",
-                       0,
-                       io_desc.name,
-                       offset *
-                           type::get_datatype_size(static_cast<type::DataType>(
-                               io_desc.tensor.data_type)));
-              tgbody.e("input$.num_dims = $;", 0, task_desc.inputs[0].num_dims);
-              tgbody.e(
-                  "input$.data_type = $;", 0, task_desc.inputs[0].data_type);
               json json_dims = json::array(), json_strides = json::array();
               for (int d = 0; d < task_desc.inputs[0].num_dims; d++) {
-                tgbody.e(
-                    "input$.dim[$] = $;", 0, d, task_desc.inputs[0].dim[d]);
-                tgbody.e("input$.stride[$] = $;",
-                         0,
-                         d,
-                         task_desc.inputs[0].stride[d]);
                 json_dims.push_back(task_desc.inputs[0].dim[d]);
                 json_strides.push_back(task_desc.inputs[0].stride[d]);
               }
-              tgbody.e("task_desc.inputs[$] = input$;", 0, 0);
               json_task["inputs"].push_back(json{
                   {"base_ptr", io_desc.name},
                   {"offset",
@@ -891,30 +1050,12 @@ TaskGraphResult print_task_graph(
                 offset +=
                     block_size * bid.z * io_desc.tensor.stride[output_map.z];
               }
-              tgbody.e("TensorDesc output$;", 0);
-              tgbody.e("output$.base_ptr = static_cast<char*>($) + $;",
-                       0,
-                       io_desc.name,
-                       offset *
-                           type::get_datatype_size(static_cast<type::DataType>(
-                               io_desc.tensor.data_type)));
-              tgbody.e(
-                  "output$.num_dims = $;", 0, task_desc.outputs[0].num_dims);
-              tgbody.e(
-                  "output$.data_type = $;", 0, task_desc.outputs[0].data_type);
               json_dims = json::array();
               json_strides = json::array();
               for (int d = 0; d < task_desc.outputs[0].num_dims; d++) {
-                tgbody.e(
-                    "output$.dim[$] = $;", 0, d, task_desc.outputs[0].dim[d]);
-                tgbody.e("output$.stride[$] = $;",
-                         0,
-                         d,
-                         task_desc.outputs[0].stride[d]);
                 json_dims.push_back(task_desc.outputs[0].dim[d]);
                 json_strides.push_back(task_desc.outputs[0].stride[d]);
               }
-              tgbody.e("task_desc.outputs[$] = output$;", 0, 0);
               json_task["outputs"].push_back(json{
                   {"base_ptr", io_desc.name},
                   {"offset",
@@ -923,9 +1064,7 @@ TaskGraphResult print_task_graph(
                   {"data_type", task_desc.outputs[0].data_type},
                   {"dims", json_dims},
                   {"strides", json_strides}});
-              tgbody.e("all_tasks.push_back(task_desc);");
               json_task_graph["all_tasks"].push_back(json_task);
-              tgbody.e("}");
               task_pos++;
             } // for tgt_gpu_id
           }   // for bid.z
@@ -941,10 +1080,6 @@ TaskGraphResult print_task_graph(
           assert(task_desc.task_type == task_type ||
                  task_type == TASK_ALLREDUCE);
           assert(task_pos == (task_id & 0xffffffff));
-          tgbody.e("// task[$]", task_pos);
-          tgbody.e("{");
-          tgbody.e("TaskDesc task_desc(static_cast<TaskType>($));",
-                   task_desc.task_type);
           size_t gpu_id = ((task_desc.trigger_event >> 32) & 0xffff);
           size_t event_pos = (task_desc.trigger_event & 0xffffffff);
           bool is_nvshmem_event =
@@ -957,7 +1092,9 @@ TaskGraphResult print_task_graph(
                        {"inputs", {}},
                        {"outputs", {}},
                        {"trigger_event", task_desc.trigger_event},
-                       {"dependent_event", task_desc.dependent_event}};
+                       {"dependent_event", task_desc.dependent_event},
+                       {"weight_only", task_desc.weight_only},
+                       {"pipelined", task_desc.pipelined}};
           for (int i = 0; i < task_desc.num_inputs; i++) {
             off_t offset = 0;
             int num_dims = input_ops[i]->dtensor.num_dims;
@@ -1036,27 +1173,12 @@ TaskGraphResult print_task_graph(
                 offset += fused_dim_off_subtensor *
                           sub_desc.tensor.stride[input_map.z];
               }
-              tgbody.e("TensorDesc input$;", i);
-              tgbody.e("input$.base_ptr = static_cast<char*>($) + $;",
-                       i,
-                       sub_desc.name,
-                       offset *
-                           type::get_datatype_size(static_cast<type::DataType>(
-                               sub_desc.tensor.data_type)));
-              tgbody.e("input$.num_dims = $;", i, task_desc.inputs[i].num_dims);
-              tgbody.e(
-                  "input$.data_type = $;", i, task_desc.inputs[i].data_type);
               json json_dims = json::array();
               json json_strides = json::array();
               for (int d = 0; d < task_desc.inputs[i].num_dims; d++) {
-                tgbody.e(
-                    "input$.dim[$] = $;", i, d, task_desc.inputs[i].dim[d]);
-                tgbody.e(
-                    "input$.stride[$] = $;", i, d, sub_desc.tensor.stride[d]);
                 json_dims.push_back(task_desc.inputs[i].dim[d]);
                 json_strides.push_back(sub_desc.tensor.stride[d]);
               }
-              tgbody.e("task_desc.inputs[$] = input$;", i, i);
               json_task["inputs"].push_back(json{
                   {"base_ptr", sub_desc.name},
                   {"offset",
@@ -1085,29 +1207,12 @@ TaskGraphResult print_task_graph(
                 offset +=
                     block_size * bid.z * io_desc.tensor.stride[input_map.z];
               }
-              tgbody.e("TensorDesc input$;", i);
-              tgbody.e("input$.base_ptr = static_cast<char*>($) + $;",
-                       i,
-                       io_desc.name,
-                       offset *
-                           type::get_datatype_size(static_cast<type::DataType>(
-                               io_desc.tensor.data_type)));
-              tgbody.e("input$.num_dims = $;", i, task_desc.inputs[i].num_dims);
-              tgbody.e(
-                  "input$.data_type = $;", i, task_desc.inputs[i].data_type);
               json json_dims = json::array();
               json json_strides = json::array();
               for (int d = 0; d < task_desc.inputs[i].num_dims; d++) {
-                tgbody.e(
-                    "input$.dim[$] = $;", i, d, task_desc.inputs[i].dim[d]);
-                tgbody.e("input$.stride[$] = $;",
-                         i,
-                         d,
-                         task_desc.inputs[i].stride[d]);
                 json_dims.push_back(task_desc.inputs[i].dim[d]);
                 json_strides.push_back(task_desc.inputs[i].stride[d]);
               }
-              tgbody.e("task_desc.inputs[$] = input$;", i, i);
               json_task["inputs"].push_back(json{
                   {"base_ptr", io_desc.name},
                   {"offset",
@@ -1143,29 +1248,12 @@ TaskGraphResult print_task_graph(
                   block_size * bid.z * io_desc.tensor.stride[output_map.z];
             }
 
-            tgbody.e("TensorDesc output$;", i);
-            tgbody.e("output$.base_ptr = static_cast<char*>($) + $;",
-                     i,
-                     io_desc.name,
-                     offset *
-                         type::get_datatype_size(static_cast<type::DataType>(
-                             io_desc.tensor.data_type)));
-            tgbody.e("output$.num_dims = $;", i, task_desc.outputs[i].num_dims);
-            tgbody.e(
-                "output$.data_type = $;", i, task_desc.outputs[i].data_type);
             json json_dims = json::array();
             json json_strides = json::array();
             for (int d = 0; d < task_desc.outputs[i].num_dims; d++) {
-              tgbody.e(
-                  "output$.dim[$] = $;", i, d, task_desc.outputs[i].dim[d]);
-              tgbody.e("output$.stride[$] = $;",
-                       i,
-                       d,
-                       task_desc.outputs[i].stride[d]);
               json_dims.push_back(task_desc.outputs[i].dim[d]);
               json_strides.push_back(task_desc.outputs[i].stride[d]);
             }
-            tgbody.e("task_desc.outputs[$] = output$;", i, i);
             json_task["outputs"].push_back(json{
                 {"base_ptr", io_desc.name},
                 {"offset",
@@ -1175,23 +1263,30 @@ TaskGraphResult print_task_graph(
                 {"dims", json_dims},
                 {"strides", json_strides}});
           }
-          tgbody.e("all_tasks.push_back(task_desc);");
-          tgbody.e("}");
           json_task_graph["all_tasks"].push_back(json_task);
           task_pos++;
         }
       }
     }
+    // Relay tasks added for the dependencies of this op
+    while (task_pos < all_tasks.size() &&
+           all_tasks[task_pos].task_type == TASK_RELAY_EVENT) {
+      TaskDesc const &task_desc = all_tasks[task_pos];
+      json_task_graph["all_tasks"].push_back(
+          json{{"task_type", TASK_RELAY_EVENT},
+               {"variant_id", 0},
+               {"inputs", {}},
+               {"outputs", {}},
+               {"trigger_event", task_desc.trigger_event},
+               {"dependent_event", task_desc.dependent_event},
+               {"weight_only", false},
+               {"pipelined", false}});
+      task_pos++;
+    }
   }
   assert(task_pos == all_tasks.size());
   // Add all events
   for (auto const &event : all_events) {
-    tgbody.e(
-        "all_events.push_back(EventDesc(static_cast<EventType>($), $, $, $));",
-        event.event_type,
-        event.num_triggers,
-        event.first_task_id,
-        event.last_task_id);
     json_task_graph["all_events"].push_back(
         json{{"event_type", event.event_type},
              {"num_triggers", event.num_triggers},
@@ -1200,48 +1295,130 @@ TaskGraphResult print_task_graph(
   }
   // Add first task
   for (auto const &task : first_tasks) {
-    tgbody.e("first_tasks.push_back($);", task);
     json_task_graph["first_tasks"].push_back(task);
   }
-  if (use_json_format) {
-    code.e("construct_task_graph(num_gpus, my_gpu_id, all_tasks, all_events, "
-           "first_tasks, all_tensors);");
+  // Move the tensor descriptors of all tasks into a shared table. The tasks
+  // of an op only differ in the offsets of their tensors, so each task keeps
+  // an (offset, table index) pair per tensor
+  {
+    std::map<std::string, size_t> tensor_desc_ids;
+    json_task_graph["tensor_descs"] = json::array();
+    for (json &task : json_task_graph["all_tasks"]) {
+      for (char const *key : {"inputs", "outputs"}) {
+        for (json &tensor : task[key]) {
+          json desc = {{"base_ptr", tensor["base_ptr"]},
+                       {"data_type", tensor["data_type"]},
+                       {"dims", tensor["dims"]},
+                       {"strides", tensor["strides"]}};
+          std::string desc_key = desc.dump();
+          if (tensor_desc_ids.find(desc_key) == tensor_desc_ids.end()) {
+            tensor_desc_ids[desc_key] = tensor_desc_ids.size();
+            json_task_graph["tensor_descs"].push_back(desc);
+          }
+          tensor = json{{"desc", tensor_desc_ids[desc_key]},
+                        {"offset", tensor["offset"]}};
+        }
+      }
+    }
+    assert(tensor_desc_ids.size() <= (size_t)MAX_TENSOR_DESCS);
+  }
+  // Consecutive tasks that only differ in their offsets are stored as a
+  // single task range
+  std::vector<CompactTaskDesc> task_ranges;
+  std::vector<TensorRef> tensor_refs;
+  get_task_ranges(json_task_graph.dump(), task_ranges, tensor_refs);
+  if (verbose) {
+    printf("Task descriptors: %zu task ranges, %zu bytes (%zu bytes "
+           "uncompressed)\n",
+           task_ranges.size(),
+           task_ranges.size() * sizeof(CompactTaskDesc) +
+               tensor_refs.size() * sizeof(TensorRef) +
+               json_task_graph["tensor_descs"].size() * sizeof(TensorDesc),
+           all_tasks.size() * sizeof(TaskDesc));
+  }
+  if (use_task_graph_file) {
+    code.e("std::filesystem::path file_path(__FILE__);");
+    code.e("load_task_graph_file((file_path.parent_path() / "
+           "\"task_graph.bin\").c_str(), all_tensors, all_tasks, "
+           "all_tensor_refs, all_tensor_descs, all_events, first_tasks);");
   } else {
-    code.e(tgbody.to_string());
+    for (json const &tensor : json_task_graph["tensor_descs"]) {
+      std::string dims, strides;
+      for (size_t i = 0; i < tensor["dims"].size(); i++) {
+        dims += (i == 0 ? "" : ", ") + tensor["dims"][i].dump();
+        strides += (i == 0 ? "" : ", ") + tensor["strides"][i].dump();
+      }
+      code.e(
+          FMT_STR("all_tensor_descs.push_back(TensorDesc{$, $, $, {$}, {$}});"),
+          tensor["dims"].size(),
+          tensor["base_ptr"].get<std::string>(),
+          tensor["data_type"].get<int>(),
+          dims,
+          strides);
+    }
+    for (CompactTaskDesc const &range : task_ranges) {
+      code.e(
+          FMT_STR(
+              "all_tasks.push_back(CompactTaskDesc{static_cast<TaskType>($), "
+              "$, $, $, (unsigned)all_tensor_refs.size(), $, $, $, $, $, "
+              "{$, $, $}});"),
+          (int)range.task_type,
+          range.variant_id,
+          range.trigger_event,
+          range.dependent_event,
+          (int)range.num_inputs,
+          (int)range.num_outputs,
+          range.weight_only,
+          range.pipelined,
+          range.first_task,
+          range.grid_dim[0],
+          range.grid_dim[1],
+          range.grid_dim[2]);
+      for (int i = 0; i < range.num_inputs + range.num_outputs; i++) {
+        TensorRef const &ref = tensor_refs[range.first_tensor_ref + i];
+        code.e(
+            FMT_STR("all_tensor_refs.push_back(TensorRef{$, $, {$, $, $}});"),
+            (unsigned long long int)ref.offset,
+            (int)ref.desc_id,
+            ref.offset_strides[0],
+            ref.offset_strides[1],
+            ref.offset_strides[2]);
+      }
+    }
+    for (json const &e : json_task_graph["all_events"]) {
+      code.e(
+          FMT_STR(
+              "all_events.push_back(EventDesc(static_cast<EventType>($), $, $, "
+              "$));"),
+          e["event_type"].get<int>(),
+          e["num_triggers"].get<int>(),
+          e["first_task_id"].get<int>(),
+          e["last_task_id"].get<int>());
+    }
+    for (json const &t : json_task_graph["first_tasks"]) {
+      code.e(FMT_STR("first_tasks.push_back($);"),
+             t.get<unsigned long long int>());
+    }
   }
   code.e("}");
   code.e("");
 
   // Generate task implementation
-  std::map<TaskType, std::string> task_type_to_name;
-  task_type_to_name[TASK_EMBEDDING] = "TASK_EMBEDDING";
-  task_type_to_name[TASK_RMS_NORM_LINEAR] = "TASK_RMS_NORM_LINEAR";
-  task_type_to_name[TASK_ATTENTION_1] = "TASK_ATTENTION_1";
-  task_type_to_name[TASK_SILU_MUL_LINEAR_WITH_RESIDUAL] =
-      "TASK_SILU_MUL_LINEAR_WITH_RESIDUAL";
-  task_type_to_name[TASK_LINEAR_WITH_RESIDUAL] = "TASK_LINEAR_WITH_RESIDUAL";
-  task_type_to_name[TASK_ARGMAX_PARTIAL] = "TASK_ARGMAX_PARTIAL";
-  task_type_to_name[TASK_ARGMAX_REDUCE] = "TASK_ARGMAX_REDUCE";
-
-  code.e("__device__ __forceinline__");
+  if (use_cpu_backend) {
+    code.e("static inline");
+  } else {
+    code.e("__device__ __forceinline__");
+  }
   code.e("void _execute_task(TaskDesc const& task_desc,");
   code.e("                   RuntimeConfig const &runtime_config) {");
   TaskRegister *task_register = TaskRegister::get_instance();
-  bool first_task = true;
-  for (auto const &task : task_register->all_task_variants) {
-    for (size_t variant_id = 0; variant_id < task.second.size(); variant_id++) {
-      std::string cond = first_task ? "if" : "else if";
-      assert(task_type_to_name.find(task.first) != task_type_to_name.end());
-      code.e("$ (task_desc.task_type == $ && task_desc.variant_id == $) {",
-             cond,
-             task_type_to_name[task.first],
-             variant_id);
-      code.e("$", task.second[variant_id]);
-      code.e("}");
-      first_task = false;
-    }
-  }
+  size_t dispatch_start = code.size();
+  task_register->generate_dispatch_code(code);
   code.e("}");
+  if (verbose) {
+    task_register->print_summary();
+    printf("Task dispatch code: %zu bytes\n", code.size() - dispatch_start);
+  }
 
   // Write json to output file
   // std::ofstream out("task_graph.json");
@@ -1250,10 +1427,14 @@ TaskGraphResult print_task_graph(
   TaskGraphResult result;
   result.cuda_code = code.to_string();
   result.json_file = json_task_graph.dump(2);
+  result.binary_file = task_graph_json_to_binary(result.json_file);
   return result;
 }
 
-TaskGraphResult Graph::generate_task_graph(int _num_gpus, int _my_gpu_id) {
+TaskGraphResult Graph::generate_task_graph(int _num_gpus,
+                                           int _my_gpu_id,
+                                           bool use_cpu_backend,
+                                           bool verbose) {
   std::vector<TaskDesc> all_tasks;
   std::vector<EventDesc> all_events;
   std::vector<TaskId> first_tasks;
@@ -1276,16 +1457,29 @@ TaskGraphResult Graph::generate_task_graph(int _num_gpus, int _my_gpu_id) {
                    all_task_maps,
                    task_config);
   assert(sanity_check(*this, all_tasks, all_events, first_tasks));
-  return print_task_graph(*this,
-                          num_gpus,
-                          my_gpu_id,
-                          all_tasks,
-                          all_events,
-                          first_tasks,
-                          all_task_maps,
-                          task_config,
-                          io_config,
-                          true /*use_json_format*/);
+  TaskGraphResult result = print_task_graph(*this,
+                                            num_gpus,
+                                            my_gpu_id,
+                                            all_tasks,
+                                            all_events,
+                                            first_tasks,
+                                            all_task_maps,
+                                            task_config,
+                                            io_config,
+                                            true /*use_task_graph_file*/,
+                                            use_cpu_backend,
+                                            verbose);
+#ifndef NDEBUG
+  // Check that the events order all overlapping tensor accesses. A single
+  // worker runs the tasks in their generated order
+  TaskGraphVerification verification =
+      verify_task_graph(result.json_file, 1 /*num_workers*/);
+  if (!verification.ok()) {
+    printf("%s", verification.to_string().c_str());
+    assert(false);
+  }
+#endif
+  return result;
 }
 
 } // namespace kernel
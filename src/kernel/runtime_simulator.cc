@@ -0,0 +1,749 @@
+/* Copyright 2025 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mirage/kernel/runtime_simulator.h"
+#include "mirage/utils/json_utils.h"
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <tuple>
+
+namespace mirage {
+namespace runtime {
+
+namespace {
+
+// Host versions of the helpers in persistent_kernel.cuh
+size_t get_event_position_index(EventId event_id) {
+  return (event_id & 0xffffffff);
+}
+
+size_t get_task_iteration_num(TaskId task_id) {
+  return (task_id >> 32);
+}
+
+size_t get_task_position_index(TaskId task_id) {
+  return (task_id & 0xffffffff);
+}
+
+TaskId compute_task_id(size_t iteration_num, size_t position_index) {
+  return ((iteration_num << 32) | position_index);
+}
+
+int get_rand_sched_id(int worker_id, int num_workers, int num_schedulers) {
+  size_t x = worker_id;
+  return x / ((num_workers + num_schedulers - 1) / num_schedulers);
+}
+
+void get_first_last_ids(unsigned long long int num_elements,
+                        unsigned long long int num_workers,
+                        unsigned long long int my_id,
+                        unsigned long long int *my_first_element,
+                        unsigned long long int *my_last_element) {
+  unsigned long long int num_elements_per_worker = num_elements / num_workers;
+  unsigned long long int reminder = num_elements % num_workers;
+  if (my_id < reminder) {
+    *my_first_element = (num_elements_per_worker + 1) * my_id;
+    *my_last_element = *my_first_element + num_elements_per_worker + 1;
+  } else {
+    *my_first_element = num_elements_per_worker * my_id + reminder;
+    *my_last_element = *my_first_element + num_elements_per_worker;
+  }
+}
+
+float get_task_latency(SimulatorConfig const &config, TaskType task_type) {
+  if (task_type == TASK_BEGIN_TASK_GRAPH || task_type == TASK_RELAY_EVENT) {
+    return 0.0f;
+  }
+  auto it = config.task_latency_us.find(task_type);
+  return it == config.task_latency_us.end() ? config.default_task_latency_us
+                                            : it->second;
+}
+
+enum SimEventKind {
+  WORKER_ENQUEUE,
+  WORKER_WAKEUP,
+  TASK_DONE,
+  SCHED_ENQUEUE,
+  SCHED_FREE,
+};
+
+struct SimEvent {
+  double time;
+  size_t seq;
+  SimEventKind kind;
+  int target; // worker or scheduler id
+  TaskId task_id;
+  size_t event_index;
+  bool bcast;
+  // The execution that caused this event, or -1
+  int cause;
+};
+
+struct SimEventCompare {
+  bool operator()(SimEvent const &a, SimEvent const &b) const {
+    return std::tie(a.time, a.seq) > std::tie(b.time, b.seq);
+  }
+};
+
+struct QueuedTask {
+  TaskId task_id;
+  double enqueue_time;
+  int cause;
+};
+
+struct QueuedEvent {
+  size_t event_index;
+  int cause;
+};
+
+struct Execution {
+  TaskId task_id;
+  int worker_id;
+  double start, end;
+  int pred;
+};
+
+struct WorkerState {
+  std::deque<QueuedTask> queue;
+  bool busy = false, blocked = false, terminated = false;
+  double free_time = 0.0, busy_us = 0.0;
+  int last_exec = -1;
+};
+
+struct SchedState {
+  // queues[0] is the scheduler's own queue and queues[1] is its cursor into
+  // the broadcast queue shared by all local schedulers
+  std::deque<QueuedEvent> queues[2];
+  int queue_idx = 0;
+  bool busy = false;
+  size_t iteration_num = 0;
+  unsigned long long int first_worker, last_worker, next_worker;
+};
+
+void record_depth(std::vector<size_t> &histogram, size_t depth) {
+  if (histogram.size() <= depth) {
+    histogram.resize(depth + 1, 0);
+  }
+  histogram[depth]++;
+}
+
+class Simulation {
+public:
+  Simulation(std::vector<TaskDesc> const &_all_tasks,
+             std::vector<EventDesc> const &_all_events,
+             std::vector<TaskId> const &_first_tasks,
+             SimulatorConfig const &_config)
+      : all_tasks(_all_tasks), all_events(_all_events),
+        first_tasks(_first_tasks), config(_config),
+        workers(_config.num_workers), scheds(_config.num_local_schedulers),
+        counters(_all_events.size(), 0), last_trigger(_all_events.size(), -1),
+        waiters(_all_events.size()) {
+    assert(config.num_workers > 0 && config.num_workers <= MAX_NUM_WORKERS);
+    assert(config.num_local_schedulers > 0);
+    for (int s = 0; s < config.num_local_schedulers; s++) {
+      get_first_last_ids(config.num_workers,
+                         config.num_local_schedulers,
+                         s,
+                         &scheds[s].first_worker,
+                         &scheds[s].last_worker);
+      scheds[s].next_worker = scheds[s].first_worker;
+    }
+  }
+
+  SimulationResult run() {
+    // init_kernel sends the begin-task-graph task to worker 0; first_tasks
+    // only lists the tasks that have no dependent event
+    size_t first_task = 1;
+    push(SimEvent{0.0,
+                  0,
+                  WORKER_ENQUEUE,
+                  0,
+                  compute_task_id(1, first_task),
+                  0,
+                  false,
+                  -1});
+    double now = 0.0;
+    while (!finished && !heap.empty()) {
+      SimEvent ev = heap.top();
+      heap.pop();
+      now = ev.time;
+      switch (ev.kind) {
+        case WORKER_ENQUEUE: {
+          WorkerState &w = workers[ev.target];
+          w.queue.push_back(QueuedTask{ev.task_id, now, ev.cause});
+          size_t depth = w.queue.size() + (w.busy ? 1 : 0);
+          record_depth(result.worker_queue_depth_histogram, depth);
+          if (depth > config.per_worker_queue_len) {
+            result.worker_queue_overflows++;
+          }
+          try_start(ev.target, now);
+          break;
+        }
+        case WORKER_WAKEUP: {
+          workers[ev.target].blocked = false;
+          try_start(ev.target, now);
+          break;
+        }
+        case TASK_DONE: {
+          finish_task(ev.target, ev.cause, now);
+          break;
+        }
+        case SCHED_ENQUEUE: {
+          SchedState &s = scheds[ev.target];
+          std::deque<QueuedEvent> &q = s.queues[ev.bcast ? 1 : 0];
+          q.push_back(QueuedEvent{ev.event_index, ev.cause});
+          record_depth(result.sched_queue_depth_histogram, q.size());
+          if (q.size() > config.per_sched_queue_len) {
+            result.sched_queue_overflows++;
+          }
+          try_process(ev.target, now);
+          break;
+        }
+        case SCHED_FREE: {
+          scheds[ev.target].busy = false;
+          try_process(ev.target, now);
+          break;
+        }
+        default:
+          assert(false);
+      }
+    }
+    result.completed = finished;
+    result.makespan_us = finished ? makespan : now;
+    result.num_executed_tasks = executions.size();
+    for (WorkerState const &w : workers) {
+      result.worker_busy_us.push_back(w.busy_us);
+      result.worker_utilization.push_back(
+          result.makespan_us > 0 ? w.busy_us / result.makespan_us : 0.0f);
+    }
+    // Walk back from the execution that activated the last end-of-graph
+    // event
+    for (int e = end_exec; e >= 0; e = executions[e].pred) {
+      Execution const &exec = executions[e];
+      TaskDesc const &desc = all_tasks[get_task_position_index(exec.task_id)];
+      result.critical_path.push_back(SimulatedTask{exec.task_id,
+                                                   desc.task_type,
+                                                   exec.worker_id,
+                                                   (float)exec.start,
+                                                   (float)exec.end});
+      result.critical_path_busy_us += exec.end - exec.start;
+    }
+    std::reverse(result.critical_path.begin(), result.critical_path.end());
+    return result;
+  }
+
+private:
+  void push(SimEvent ev) {
+    ev.seq = seq++;
+    heap.push(ev);
+  }
+
+  float get_task_latency(TaskType task_type) const {
+    return runtime::get_task_latency(config, task_type);
+  }
+
+  void try_start(int worker_id, double now) {
+    WorkerState &w = workers[worker_id];
+    if (w.busy || w.blocked || w.terminated || w.queue.empty()) {
+      return;
+    }
+    QueuedTask qt = w.queue.front();
+    size_t iteration_num = get_task_iteration_num(qt.task_id);
+    TaskDesc const &desc = all_tasks[get_task_position_index(qt.task_id)];
+    if (desc.task_type == TASK_TERMINATE) {
+      w.queue.pop_front();
+      w.terminated = true;
+      return;
+    }
+    // Whichever of dispatch, worker availability and dependent event was
+    // ready last determined the start time
+    int pred = qt.cause;
+    double pred_time = qt.enqueue_time;
+    if (w.last_exec >= 0 && w.free_time > pred_time) {
+      pred = w.last_exec;
+      pred_time = w.free_time;
+    }
+    if (desc.dependent_event != EVENT_INVALID_ID) {
+      size_t event_index = get_event_position_index(desc.dependent_event);
+      EventCounter needed_counts =
+          static_cast<EventCounter>(all_events[event_index].num_triggers) *
+          iteration_num;
+      if (counters[event_index] < needed_counts) {
+        // Block until the event has been triggered enough times
+        w.blocked = true;
+        waiters[event_index].push_back(worker_id);
+        return;
+      }
+      int trigger = last_trigger[event_index];
+      if (trigger >= 0 && executions[trigger].end > pred_time) {
+        pred = trigger;
+        pred_time = executions[trigger].end;
+      }
+    }
+    w.queue.pop_front();
+    w.busy = true;
+    double end =
+        now + config.task_fetch_latency_us + get_task_latency(desc.task_type);
+    executions.push_back(Execution{qt.task_id, worker_id, now, end, pred});
+    push(SimEvent{end,
+                  0,
+                  TASK_DONE,
+                  worker_id,
+                  qt.task_id,
+                  0,
+                  false,
+                  (int)executions.size() - 1});
+  }
+
+  void finish_task(int worker_id, int exec_idx, double now) {
+    WorkerState &w = workers[worker_id];
+    Execution const &exec = executions[exec_idx];
+    w.busy = false;
+    w.busy_us += exec.end - exec.start;
+    w.free_time = now;
+    w.last_exec = exec_idx;
+    TaskDesc const &desc = all_tasks[get_task_position_index(exec.task_id)];
+    if (desc.trigger_event != EVENT_INVALID_ID) {
+      size_t event_index = get_event_position_index(desc.trigger_event);
+      // A pipelined task is launched with the tasks of the previous
+      // iteration
+      size_t iteration_num =
+          get_task_iteration_num(exec.task_id) + (desc.pipelined ? 1 : 0);
+      EventDesc const &e = all_events[event_index];
+      counters[event_index]++;
+      last_trigger[event_index] = exec_idx;
+      if (counters[event_index] ==
+          static_cast<EventCounter>(e.num_triggers) * iteration_num) {
+        for (int waiter : waiters[event_index]) {
+          push(SimEvent{now, 0, WORKER_WAKEUP, waiter, 0, 0, false, -1});
+        }
+        waiters[event_index].clear();
+        if (e.event_type != EVENT_EMPTY) {
+          double arrival = now + config.event_latency_us;
+          if (e.event_type == EVENT_LAUNCH_MASSIVE_TASKS ||
+              e.event_type == EVENT_LAUNCH_DEPENDENT_TASKS) {
+            for (int s = 0; s < config.num_local_schedulers; s++) {
+              push(SimEvent{arrival,
+                            0,
+                            SCHED_ENQUEUE,
+                            s,
+                            0,
+                            event_index,
+                            true,
+                            exec_idx});
+            }
+          } else {
+            int s = get_rand_sched_id(
+                worker_id, config.num_workers, config.num_local_schedulers);
+            push(SimEvent{
+                arrival, 0, SCHED_ENQUEUE, s, 0, event_index, false, exec_idx});
+          }
+        }
+      }
+    }
+    try_start(worker_id, now);
+  }
+
+  void dispatch(SchedState &s, TaskId task_id, int cause, double &t) {
+    t += config.sched_dispatch_latency_us;
+    int worker_id = s.next_worker;
+    s.next_worker = (s.next_worker == s.last_worker - 1) ? s.first_worker
+                                                         : s.next_worker + 1;
+    push(SimEvent{t, 0, WORKER_ENQUEUE, worker_id, task_id, 0, false, cause});
+  }
+
+  void try_process(int sched_id, double now) {
+    SchedState &s = scheds[sched_id];
+    if (s.busy || finished) {
+      return;
+    }
+    if (s.queues[s.queue_idx].empty()) {
+      s.queue_idx = 1 - s.queue_idx;
+      if (s.queues[s.queue_idx].empty()) {
+        return;
+      }
+    }
+    QueuedEvent qe = s.queues[s.queue_idx].front();
+    s.queues[s.queue_idx].pop_front();
+    EventDesc const &e = all_events[qe.event_index];
+    s.busy = true;
+    double t = now + config.sched_event_latency_us;
+    if (e.event_type == EVENT_END_OF_TASK_GRAPH) {
+      if ((int)s.iteration_num >= config.num_iterations) {
+        finished = true;
+        makespan = t;
+        end_exec = qe.cause;
+        return;
+      }
+      // Launch task 1 (begin_task_graph) for the next iteration
+      dispatch(s, compute_task_id(s.iteration_num + 1, 1), qe.cause, t);
+    } else if (e.event_type == EVENT_LAUNCH_DEPENDENT_TASKS) {
+      s.iteration_num++;
+      size_t num_rounds =
+          (e.last_task_id - e.first_task_id + config.num_workers - 1) /
+          config.num_workers;
+      // The first iteration launches its pipelined tasks before its other
+      // tasks, and each iteration launches the pipelined tasks of the next
+      // one after its own
+      for (int pass = (s.iteration_num == 1) ? 0 : 1; pass < 3; pass++) {
+        size_t iteration_num = (pass == 0) ? 0 : s.iteration_num;
+        for (size_t i = 0; i < num_rounds; i++) {
+          for (size_t j = s.first_worker; j < s.last_worker; j++) {
+            size_t position_index =
+                e.first_task_id + i * config.num_workers + j;
+            if (position_index < e.last_task_id &&
+                all_tasks[position_index].pipelined == (pass != 1)) {
+              dispatch(s,
+                       compute_task_id(iteration_num, position_index),
+                       qe.cause,
+                       t);
+            }
+          }
+        }
+      }
+    } else {
+      unsigned long long int my_first_task = e.first_task_id,
+                             my_last_task = e.last_task_id;
+      if (e.event_type == EVENT_LAUNCH_MASSIVE_TASKS) {
+        get_first_last_ids(e.last_task_id - e.first_task_id,
+                           config.num_local_schedulers,
+                           sched_id,
+                           &my_first_task,
+                           &my_last_task);
+        my_first_task += e.first_task_id;
+        my_last_task += e.first_task_id;
+      }
+      for (size_t i = my_first_task; i < my_last_task; i++) {
+        dispatch(s, compute_task_id(s.iteration_num, i), qe.cause, t);
+      }
+    }
+    push(SimEvent{t, 0, SCHED_FREE, sched_id, 0, 0, false, -1});
+  }
+
+  std::vector<TaskDesc> const &all_tasks;
+  std::vector<EventDesc> const &all_events;
+  std::vector<TaskId> const &first_tasks;
+  SimulatorConfig const &config;
+  std::vector<WorkerState> workers;
+  std::vector<SchedState> scheds;
+  std::vector<EventCounter> counters;
+  std::vector<int> last_trigger;
+  std::vector<std::vector<int>> waiters;
+  std::vector<Execution> executions;
+  std::priority_queue<SimEvent, std::vector<SimEvent>, SimEventCompare> heap;
+  size_t seq = 0;
+  bool finished = false;
+  double makespan = 0.0;
+  int end_exec = -1;
+  SimulationResult result;
+};
+
+} // namespace
+
+TaskGraphSimulator::TaskGraphSimulator(
+    std::vector<TaskDesc> const &_all_tasks,
+    std::vector<EventDesc> const &_all_events,
+    std::vector<TaskId> const &_first_tasks)
+    : all_tasks(_all_tasks), all_events(_all_events),
+      first_tasks(_first_tasks) {}
+
+TaskGraphSimulator
+    TaskGraphSimulator::from_json(std::string const &json_task_graph) {
+  json j = json::parse(json_task_graph);
+  std::vector<TaskDesc> all_tasks;
+  std::vector<EventDesc> all_events;
+  std::vector<TaskId> first_tasks;
+  for (json const &task : j.at("all_tasks")) {
+    TaskDesc task_desc(static_cast<TaskType>(task.at("task_type").get<int>()),
+                       task.at("variant_id").get<unsigned>());
+    task_desc.trigger_event =
+        task.at("trigger_event").get<unsigned long long int>();
+    task_desc.dependent_event =
+        task.at("dependent_event").get<unsigned long long int>();
+    task_desc.weight_only = task.value("weight_only", false);
+    task_desc.pipelined = task.value("pipelined", false);
+    all_tasks.push_back(task_desc);
+  }
+  for (json const &e : j.at("all_events")) {
+    all_events.push_back(
+        EventDesc(static_cast<EventType>(e.at("event_type").get<int>()),
+                  e.at("num_triggers").get<int>(),
+                  e.at("first_task_id").get<TaskId>(),
+                  e.at("last_task_id").get<TaskId>()));
+  }
+  for (json const &t : j.at("first_tasks")) {
+    first_tasks.push_back(t.get<TaskId>());
+  }
+  return TaskGraphSimulator(all_tasks, all_events, first_tasks);
+}
+
+SimulationResult TaskGraphSimulator::run(SimulatorConfig const &config) const {
+  Simulation sim(all_tasks, all_events, first_tasks, config);
+  return sim.run();
+}
+
+SimulationResult simulate_task_graph(std::string const &json_task_graph,
+                                     SimulatorConfig const &config) {
+  return TaskGraphSimulator::from_json(json_task_graph).run(config);
+}
+
+std::string SimulationResult::to_string() const {
+  std::ostringstream oss;
+  oss << "completed: " << (completed ? "true" : "false") << "\n";
+  oss << "makespan: " << makespan_us << " us\n";
+  oss << "executed tasks: " << num_executed_tasks << "\n";
+  for (size_t i = 0; i < worker_utilization.size(); i++) {
+    oss << "worker " << i << ": busy " << worker_busy_us[i] << " us ("
+        << worker_utilization[i] * 100 << "%)\n";
+  }
+  oss << "worker queue depth histogram:";
+  for (size_t d = 0; d < worker_queue_depth_histogram.size(); d++) {
+    oss << " " << d << ":" << worker_queue_depth_histogram[d];
+  }
+  oss << "\nscheduler queue depth histogram:";
+  for (size_t d = 0; d < sched_queue_depth_histogram.size(); d++) {
+    oss << " " << d << ":" << sched_queue_depth_histogram[d];
+  }
+  oss << "\nqueue overflows: worker " << worker_queue_overflows
+      << ", scheduler " << sched_queue_overflows << "\n";
+  oss << "critical path: " << critical_path.size() << " tasks, "
+      << critical_path_busy_us << " us busy\n";
+  for (SimulatedTask const &task : critical_path) {
+    oss << "  iter " << get_task_iteration_num(task.task_id) << " task "
+        << get_task_position_index(task.task_id) << " type " << task.task_type
+        << " worker " << task.worker_id << " [" << task.start_us << ", "
+        << task.end_us << "]\n";
+  }
+  return oss.str();
+}
+
+std::map<int, float> get_task_latencies_from_profiler(uint64_t const *buffer,
+                                                      size_t num_entries) {
+  // Tags are encoded by make_event_tag_start/end in profiler.h: bits 17+
+  // hold the event number, bits 10-16 the block group and bits 2-9 the
+  // event (i.e., the TaskType)
+  std::map<std::tuple<uint32_t, uint32_t, uint32_t>, uint32_t> begin_times;
+  std::map<int, std::pair<double, size_t>> durations;
+  for (size_t i = 1; i < num_entries; i++) {
+    if (buffer[i] == 0) {
+      continue;
+    }
+    uint32_t tag = static_cast<uint32_t>(buffer[i] & 0xffffffff);
+    uint32_t timestamp = static_cast<uint32_t>(buffer[i] >> 32);
+    uint32_t event_no = tag >> 17;
+    uint32_t block_group = (tag >> 10) & 0x7f;
+    uint32_t event_idx = (tag >> 2) & 0xff;
+    uint32_t event_type = tag & 0x3;
+    auto key = std::make_tuple(block_group, event_idx, event_no);
+    if (event_type == 0x0) {
+      begin_times[key] = timestamp;
+    } else if (event_type == 0x1) {
+      auto it = begin_times.find(key);
+      if (it == begin_times.end()) {
+        continue;
+      }
+      // Timestamps are the low 32 bits of %globaltimer, in nanoseconds
+      uint32_t elapsed = timestamp - it->second;
+      begin_times.erase(it);
+      if (event_idx >= TASK_SCHD_TASKS) {
+        // Scheduler events are not task latencies
+        continue;
+      }
+      durations[event_idx].first += elapsed / 1000.0;
+      durations[event_idx].second++;
+    }
+  }
+  std::map<int, float> latencies;
+  for (auto const &it : durations) {
+    latencies[it.first] = it.second.first / it.second.second;
+  }
+  return latencies;
+}
+
+std::vector<float> get_upward_ranks(std::vector<TaskDesc> const &all_tasks,
+                                    size_t num_events,
+                                    SimulatorConfig const &config) {
+  // consumers[e] are the tasks waiting on event e in the same iteration.
+  // NVSHMEM events are matched by position, since all GPUs run the same
+  // task graph
+  std::vector<std::vector<TaskId>> consumers(num_events);
+  for (TaskId t = 0; t < all_tasks.size(); t++) {
+    if (all_tasks[t].dependent_event != EVENT_INVALID_ID &&
+        !all_tasks[t].pipelined) {
+      consumers[get_event_position_index(all_tasks[t].dependent_event)]
+          .push_back(t);
+    }
+  }
+  // Visit tasks in reverse topological order
+  std::vector<int> num_succs(all_tasks.size(), 0);
+  for (TaskId t = 0; t < all_tasks.size(); t++) {
+    if (all_tasks[t].trigger_event != EVENT_INVALID_ID) {
+      num_succs[t] =
+          consumers[get_event_position_index(all_tasks[t].trigger_event)]
+              .size();
+    }
+  }
+  std::vector<std::vector<TaskId>> producers(num_events);
+  for (TaskId t = 0; t < all_tasks.size(); t++) {
+    if (all_tasks[t].trigger_event != EVENT_INVALID_ID) {
+      producers[get_event_position_index(all_tasks[t].trigger_event)].push_back(
+          t);
+    }
+  }
+  std::vector<float> ranks(all_tasks.size(), 0.0f);
+  std::vector<TaskId> ready;
+  for (TaskId t = 0; t < all_tasks.size(); t++) {
+    if (num_succs[t] == 0) {
+      ready.push_back(t);
+    }
+  }
+  while (!ready.empty()) {
+    TaskId t = ready.back();
+    ready.pop_back();
+    ranks[t] += get_task_latency(config, all_tasks[t].task_type);
+    if (all_tasks[t].dependent_event == EVENT_INVALID_ID ||
+        all_tasks[t].pipelined) {
+      continue;
+    }
+    for (TaskId p :
+         producers[get_event_position_index(all_tasks[t].dependent_event)]) {
+      ranks[p] = std::max(ranks[p], ranks[t]);
+      if (--num_succs[p] == 0) {
+        ready.push_back(p);
+      }
+    }
+  }
+  return ranks;
+}
+
+std::string order_task_graph(std::string const &json_task_graph,
+                             SimulatorConfig const &config) {
+  json j = json::parse(json_task_graph);
+  TaskGraphSimulator graph = TaskGraphSimulator::from_json(json_task_graph);
+  std::vector<TaskDesc> const &all_tasks = graph.get_tasks();
+  std::vector<EventDesc> const &all_events = graph.get_events();
+  // Only the tasks prelaunched by the begin-task-graph task are reordered
+  if (all_events.size() < 2 ||
+      all_events[1].event_type != EVENT_LAUNCH_DEPENDENT_TASKS ||
+      all_events[1].first_task_id != 2 ||
+      all_events[1].last_task_id != all_tasks.size()) {
+    return json_task_graph;
+  }
+  std::vector<float> ranks =
+      get_upward_ranks(all_tasks, all_events.size(), config);
+  std::vector<std::vector<TaskId>> consumers(all_events.size());
+  std::vector<int> num_preds(all_tasks.size(), 0);
+  // Pipelined tasks wait on an event of the previous iteration
+  for (TaskId t = 2; t < all_tasks.size(); t++) {
+    if (all_tasks[t].dependent_event != EVENT_INVALID_ID &&
+        !all_tasks[t].pipelined) {
+      consumers[get_event_position_index(all_tasks[t].dependent_event)]
+          .push_back(t);
+    }
+  }
+  for (TaskId t = 2; t < all_tasks.size(); t++) {
+    if (all_tasks[t].trigger_event != EVENT_INVALID_ID) {
+      for (TaskId c :
+           consumers[get_event_position_index(all_tasks[t].trigger_event)]) {
+        num_preds[c]++;
+      }
+    }
+  }
+  // List scheduling on the prelaunch slots: the k-th prelaunched task goes
+  // to worker k % num_workers, which runs its tasks in slot order and spins
+  // on the dependent event of each. Each slot takes the highest-ranked task
+  // that is ready when the worker becomes free, or else the task that
+  // becomes ready first. Only tasks whose producers have all been placed
+  // are candidates, so the order stays topological and cannot deadlock
+  std::vector<double> ready_time(all_tasks.size(), 0.0);
+  std::vector<double> worker_free(config.num_workers, 0.0);
+  std::set<TaskId> candidates;
+  for (TaskId t = 2; t < all_tasks.size(); t++) {
+    if (num_preds[t] == 0) {
+      candidates.insert(t);
+    }
+  }
+  std::vector<TaskId> order = {0, 1};
+  while (!candidates.empty()) {
+    int worker_id = (order.size() - 2) % config.num_workers;
+    double free_time = worker_free[worker_id];
+    auto better = [&](TaskId a, TaskId b) {
+      bool a_ready = ready_time[a] <= free_time;
+      bool b_ready = ready_time[b] <= free_time;
+      if (a_ready != b_ready) {
+        return a_ready;
+      }
+      if (!a_ready && ready_time[a] != ready_time[b]) {
+        return ready_time[a] < ready_time[b];
+      }
+      return ranks[a] > ranks[b];
+    };
+    // Ties keep the original order, which is topological
+    TaskId best = *candidates.begin();
+    for (TaskId t : candidates) {
+      if (better(t, best)) {
+        best = t;
+      }
+    }
+    candidates.erase(best);
+    order.push_back(best);
+    double finish = std::max(free_time, ready_time[best]) +
+                    get_task_latency(config, all_tasks[best].task_type);
+    worker_free[worker_id] = finish;
+    if (all_tasks[best].trigger_event != EVENT_INVALID_ID) {
+      for (TaskId c :
+           consumers[get_event_position_index(all_tasks[best].trigger_event)]) {
+        ready_time[c] = std::max(ready_time[c], finish);
+        if (--num_preds[c] == 0) {
+          candidates.insert(c);
+        }
+      }
+    }
+  }
+  assert(order.size() == all_tasks.size());
+
+  std::vector<TaskId> new_pos(all_tasks.size());
+  json all_tasks_json = json::array();
+  for (size_t pos = 0; pos < order.size(); pos++) {
+    new_pos[order[pos]] = pos;
+    all_tasks_json.push_back(j["all_tasks"][order[pos]]);
+  }
+  j["all_tasks"] = all_tasks_json;
+  // The task range of an empty event spans its dependent tasks
+  for (size_t e = 2; e < all_events.size(); e++) {
+    if (all_events[e].event_type != EVENT_EMPTY || consumers[e].empty()) {
+      continue;
+    }
+    TaskId first = all_tasks.size(), last = 0;
+    for (TaskId c : consumers[e]) {
+      first = std::min(first, new_pos[c]);
+      last = std::max(last, new_pos[c] + 1);
+    }
+    j["all_events"][e]["first_task_id"] = first;
+    j["all_events"][e]["last_task_id"] = last;
+  }
+  for (json &t : j["first_tasks"]) {
+    t = new_pos[t.get<TaskId>()];
+  }
+  return j.dump(2);
+}
+
+} // namespace runtime
+} // namespace mirage
@@ -0,0 +1,382 @@
+/* Copyright 2025 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mirage/persistent_kernel/task_graph_file.h"
+#include "mirage/kernel/runtime.h"
+#include "mirage/utils/json_utils.h"
+
+#include <stdexcept>
+
+namespace mirage {
+namespace runtime {
+
+namespace {
+
+// Append `bytes` bytes to `out` at the next 8-byte aligned offset and
+// return that offset
+uint64_t append_section(std::string &out, void const *data, size_t bytes) {
+  out.resize((out.size() + 7) / 8 * 8, '\0');
+  uint64_t offset = out.size();
+  out.append(static_cast<char const *>(data), bytes);
+  return offset;
+}
+
+template <typename T>
+uint64_t append_section(std::string &out, std::vector<T> const &vec) {
+  return append_section(out, vec.data(), vec.size() * sizeof(T));
+}
+
+template <typename T>
+std::vector<T>
+    read_section(std::string const &data, uint64_t offset, uint32_t count) {
+  std::vector<T> vec(count);
+  memcpy(vec.data(), data.data() + offset, count * sizeof(T));
+  return vec;
+}
+
+// The byte offset of `ref` for the task at `index` in `range`
+long long get_tensor_offset(CompactTaskDesc const &range,
+                            TensorRef const &ref,
+                            uint64_t index) {
+  uint64_t bid[3] = {index / ((uint64_t)range.grid_dim[1] * range.grid_dim[2]),
+                     index / range.grid_dim[2] % range.grid_dim[1],
+                     index % range.grid_dim[2]};
+  long long offset = ref.offset;
+  for (int d = 0; d < 3; d++) {
+    offset += ref.offset_strides[d] * (long long)bid[d];
+  }
+  return offset;
+}
+
+// Whether two tasks only differ in the offsets of their tensors
+bool same_except_offsets(CompactTaskDesc const &a,
+                         CompactTaskDesc const &b,
+                         std::vector<TensorRef> const &a_refs,
+                         std::vector<TensorRef> const &b_refs) {
+  if (a.task_type != b.task_type || a.variant_id != b.variant_id ||
+      a.trigger_event != b.trigger_event ||
+      a.dependent_event != b.dependent_event || a.num_inputs != b.num_inputs ||
+      a.num_outputs != b.num_outputs || a.weight_only != b.weight_only ||
+      a.pipelined != b.pipelined) {
+    return false;
+  }
+  for (int i = 0; i < a.num_inputs + a.num_outputs; i++) {
+    if (a_refs[a.first_tensor_ref + i].desc_id !=
+        b_refs[b.first_tensor_ref + i].desc_id) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Merge runs of consecutive tasks that only differ in the offsets of their
+// tensors into task ranges. The grid dimensions of a range are grown
+// innermost first: the innermost one is a run of tasks whose offsets
+// advance by constant strides, and each outer one repeats the block of
+// tasks spanned by the inner ones, shifted by constant strides
+void merge_task_ranges(std::vector<CompactTaskDesc> const &tasks,
+                       std::vector<TensorRef> const &tensor_refs,
+                       std::vector<CompactTaskDesc> &task_ranges,
+                       std::vector<TensorRef> &range_tensor_refs) {
+  auto offset = [&](size_t t, int i) -> long long {
+    return tensor_refs[tasks[t].first_tensor_ref + i].offset;
+  };
+  // Whether the `block` tasks starting at `start` are the ones starting at
+  // `first` with their offsets shifted by `shift`
+  auto repeats = [&](size_t first,
+                     size_t start,
+                     size_t block,
+                     std::vector<long long> const &shift) {
+    for (size_t k = 0; k < block; k++) {
+      if (!same_except_offsets(
+              tasks[first + k], tasks[start + k], tensor_refs, tensor_refs)) {
+        return false;
+      }
+      for (size_t i = 0; i < shift.size(); i++) {
+        if (offset(start + k, i) != offset(first + k, i) + shift[i]) {
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+  size_t t = 0;
+  while (t < tasks.size()) {
+    CompactTaskDesc range = tasks[t];
+    int num_tensors = range.num_inputs + range.num_outputs;
+    std::vector<long long> strides[3];
+    size_t block = 1;
+    for (int d = 2; d >= 0; d--) {
+      strides[d].assign(num_tensors, 0);
+      size_t count = 1;
+      if (t + block < tasks.size()) {
+        for (int i = 0; i < num_tensors; i++) {
+          strides[d][i] = offset(t + block, i) - offset(t, i);
+        }
+      }
+      while (count < 0xffff && t + (count + 1) * block <= tasks.size()) {
+        std::vector<long long> shift(num_tensors);
+        for (int i = 0; i < num_tensors; i++) {
+          shift[i] = strides[d][i] * (long long)count;
+        }
+        if (!repeats(t, t + count * block, block, shift)) {
+          break;
+        }
+        count++;
+      }
+      if (count == 1) {
+        strides[d].assign(num_tensors, 0);
+      }
+      range.grid_dim[d] = count;
+      block *= count;
+    }
+    range.first_task = t;
+    range.first_tensor_ref = range_tensor_refs.size();
+    for (int i = 0; i < num_tensors; i++) {
+      TensorRef ref = tensor_refs[tasks[t].first_tensor_ref + i];
+      for (int d = 0; d < 3; d++) {
+        ref.offset_strides[d] = strides[d][i];
+      }
+      range_tensor_refs.push_back(ref);
+    }
+    task_ranges.push_back(range);
+    t += block;
+  }
+}
+
+// Read the tasks of a task graph and merge them into task ranges. The ranges
+// are expanded again and checked against the tasks
+void read_task_ranges(json const &j,
+                      std::vector<CompactTaskDesc> &task_ranges,
+                      std::vector<TensorRef> &range_tensor_refs) {
+  std::vector<CompactTaskDesc> tasks;
+  std::vector<TensorRef> tensor_refs;
+  for (json const &task : j.at("all_tasks")) {
+    CompactTaskDesc task_desc;
+    memset(&task_desc, 0, sizeof(task_desc));
+    task_desc.task_type =
+        static_cast<TaskType>(task.at("task_type").get<int>());
+    task_desc.variant_id = task.at("variant_id").get<unsigned>();
+    task_desc.trigger_event =
+        task.at("trigger_event").get<unsigned long long int>();
+    task_desc.dependent_event =
+        task.at("dependent_event").get<unsigned long long int>();
+    task_desc.first_tensor_ref = tensor_refs.size();
+    task_desc.num_inputs = task.at("inputs").size();
+    task_desc.num_outputs = task.at("outputs").size();
+    task_desc.weight_only = task.value("weight_only", false);
+    task_desc.pipelined = task.value("pipelined", false);
+    for (char const *key : {"inputs", "outputs"}) {
+      for (json const &tensor : task.at(key)) {
+        TensorRef ref;
+        memset(&ref, 0, sizeof(ref));
+        ref.offset = tensor.at("offset").get<unsigned long long int>();
+        ref.desc_id = tensor.at("desc").get<unsigned long long int>();
+        tensor_refs.push_back(ref);
+      }
+    }
+    tasks.push_back(task_desc);
+  }
+  if (tasks.size() > 0xffffffff) {
+    throw std::runtime_error("Too many tasks in task graph");
+  }
+  merge_task_ranges(tasks, tensor_refs, task_ranges, range_tensor_refs);
+  for (CompactTaskDesc const &range : task_ranges) {
+    uint64_t num_tasks =
+        (uint64_t)range.grid_dim[0] * range.grid_dim[1] * range.grid_dim[2];
+    for (uint64_t index = 0; index < num_tasks; index++) {
+      CompactTaskDesc const &task = tasks[range.first_task + index];
+      bool same =
+          same_except_offsets(range, task, range_tensor_refs, tensor_refs);
+      for (int i = 0; same && i < task.num_inputs + task.num_outputs; i++) {
+        same = get_tensor_offset(range,
+                                 range_tensor_refs[range.first_tensor_ref + i],
+                                 index) ==
+               (long long)tensor_refs[task.first_tensor_ref + i].offset;
+      }
+      if (!same) {
+        throw std::runtime_error("Task ranges do not match the task graph");
+      }
+    }
+  }
+}
+
+} // namespace
+
+void get_task_ranges(std::string const &json_task_graph,
+                     std::vector<CompactTaskDesc> &task_ranges,
+                     std::vector<TensorRef> &tensor_refs) {
+  read_task_ranges(json::parse(json_task_graph), task_ranges, tensor_refs);
+}
+
+std::string task_graph_json_to_binary(std::string const &json_task_graph) {
+  json j = json::parse(json_task_graph);
+  std::vector<CompactTaskDesc> tasks;
+  std::vector<TensorRef> tensor_refs;
+  std::vector<TensorDesc> tensor_descs;
+  std::vector<EventDesc> events;
+  std::vector<TaskId> first_tasks;
+  std::vector<TaskGraphRelocation> relocations;
+  std::string string_table;
+  std::map<std::string, uint32_t> name_offsets;
+
+  for (json const &tensor : j.at("tensor_descs")) {
+    TensorDesc desc;
+    // Zero the padding so that identical graphs produce identical files
+    memset(&desc, 0, sizeof(desc));
+    desc.base_ptr = nullptr;
+    desc.data_type = tensor.at("data_type").get<int>();
+    json const &dims = tensor.at("dims");
+    json const &strides = tensor.at("strides");
+    if (dims.size() != strides.size() ||
+        dims.size() > (size_t)mirage::config::MAX_TENSOR_DIMS) {
+      throw std::runtime_error("Invalid tensor desc in task graph");
+    }
+    desc.num_dims = dims.size();
+    for (int i = 0; i < desc.num_dims; i++) {
+      desc.dim[i] = dims[i].get<int>();
+      desc.stride[i] = strides[i].get<int>();
+    }
+    std::string name = tensor.at("base_ptr").get<std::string>();
+    if (name_offsets.find(name) == name_offsets.end()) {
+      name_offsets[name] = string_table.size();
+      string_table.append(name.c_str(), name.size() + 1);
+    }
+    relocations.push_back(
+        TaskGraphRelocation{(uint32_t)tensor_descs.size(), name_offsets[name]});
+    tensor_descs.push_back(desc);
+  }
+  read_task_ranges(j, tasks, tensor_refs);
+  for (json const &e : j.at("all_events")) {
+    events.push_back(
+        EventDesc(static_cast<EventType>(e.at("event_type").get<int>()),
+                  e.at("num_triggers").get<int>(),
+                  e.at("first_task_id").get<TaskId>(),
+                  e.at("last_task_id").get<TaskId>()));
+  }
+  for (json const &t : j.at("first_tasks")) {
+    first_tasks.push_back(t.get<TaskId>());
+  }
+
+  TaskGraphFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TASK_GRAPH_FILE_MAGIC, sizeof(header.magic));
+  header.version = TASK_GRAPH_FILE_VERSION;
+  header.task_size = sizeof(CompactTaskDesc);
+  header.tensor_ref_size = sizeof(TensorRef);
+  header.tensor_desc_size = sizeof(TensorDesc);
+  header.event_size = sizeof(EventDesc);
+  header.num_tasks = tasks.size();
+  header.num_tensor_refs = tensor_refs.size();
+  header.num_tensor_descs = tensor_descs.size();
+  header.num_events = events.size();
+  header.num_first_tasks = first_tasks.size();
+  header.num_relocations = relocations.size();
+  header.string_table_size = string_table.size();
+  std::string out(sizeof(header), '\0');
+  header.tasks_offset = append_section(out, tasks);
+  header.tensor_refs_offset = append_section(out, tensor_refs);
+  header.tensor_descs_offset = append_section(out, tensor_descs);
+  header.events_offset = append_section(out, events);
+  header.first_tasks_offset = append_section(out, first_tasks);
+  header.relocations_offset = append_section(out, relocations);
+  header.string_table_offset =
+      append_section(out, string_table.data(), string_table.size());
+  header.file_size = out.size();
+  memcpy(out.data(), &header, sizeof(header));
+
+  char const *error = validate_task_graph_file(out.data(), out.size());
+  if (error != nullptr) {
+    throw std::runtime_error(std::string("Invalid task graph: ") + error);
+  }
+  return out;
+}
+
+std::string task_graph_binary_to_json(std::string const &binary_task_graph) {
+  std::string const &data = binary_task_graph;
+  char const *error = validate_task_graph_file(data.data(), data.size());
+  if (error != nullptr) {
+    throw std::runtime_error(std::string("Invalid task graph file: ") + error);
+  }
+  TaskGraphFileHeader header;
+  memcpy(&header, data.data(), sizeof(header));
+  std::vector<TensorDesc> tensor_descs = read_section<TensorDesc>(
+      data, header.tensor_descs_offset, header.num_tensor_descs);
+  std::vector<TaskGraphRelocation> relocations =
+      read_section<TaskGraphRelocation>(
+          data, header.relocations_offset, header.num_relocations);
+  std::vector<std::string> names(tensor_descs.size());
+  for (auto const &r : relocations) {
+    names[r.tensor_desc_id] =
+        std::string(data.data() + header.string_table_offset + r.name_offset);
+  }
+
+  json j = {{"all_tasks", json::array()},
+            {"all_events", json::array()},
+            {"first_tasks", json::array()},
+            {"tensor_descs", json::array()}};
+  for (size_t i = 0; i < tensor_descs.size(); i++) {
+    TensorDesc const &desc = tensor_descs[i];
+    json dims = json::array(), strides = json::array();
+    for (int d = 0; d < desc.num_dims; d++) {
+      dims.push_back(desc.dim[d]);
+      strides.push_back(desc.stride[d]);
+    }
+    j["tensor_descs"].push_back(json{{"base_ptr", names[i]},
+                                     {"data_type", desc.data_type},
+                                     {"dims", dims},
+                                     {"strides", strides}});
+  }
+  std::vector<TensorRef> tensor_refs = read_section<TensorRef>(
+      data, header.tensor_refs_offset, header.num_tensor_refs);
+  // Expand each task range into its tasks
+  for (auto const &range : read_section<CompactTaskDesc>(
+           data, header.tasks_offset, header.num_tasks)) {
+    uint64_t num_tasks =
+        (uint64_t)range.grid_dim[0] * range.grid_dim[1] * range.grid_dim[2];
+    for (uint64_t index = 0; index < num_tasks; index++) {
+      json json_task = {{"task_type", range.task_type},
+                        {"variant_id", range.variant_id},
+                        {"inputs", json::array()},
+                        {"outputs", json::array()},
+                        {"trigger_event", range.trigger_event},
+                        {"dependent_event", range.dependent_event},
+                        {"weight_only", range.weight_only},
+                        {"pipelined", range.pipelined}};
+      for (int i = 0; i < range.num_inputs + range.num_outputs; i++) {
+        TensorRef const &ref = tensor_refs[range.first_tensor_ref + i];
+        json_task[i < range.num_inputs ? "inputs" : "outputs"].push_back(
+            json{{"desc", (uint64_t)ref.desc_id},
+                 {"offset", (uint64_t)get_tensor_offset(range, ref, index)}});
+      }
+      j["all_tasks"].push_back(json_task);
+    }
+  }
+  for (auto const &event :
+       read_section<EventDesc>(data, header.events_offset, header.num_events)) {
+    j["all_events"].push_back(json{{"event_type", event.event_type},
+                                   {"num_triggers", event.num_triggers},
+                                   {"first_task_id", event.first_task_id},
+                                   {"last_task_id", event.last_task_id}});
+  }
+  for (TaskId t : read_section<TaskId>(
+           data, header.first_tasks_offset, header.num_first_tasks)) {
+    j["first_tasks"].push_back(t);
+  }
+  return j.dump(2);
+}
+
+} // namespace runtime
+} // namespace mirage
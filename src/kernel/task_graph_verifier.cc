@@ -0,0 +1,496 @@
+/* Copyright 2025 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mirage/kernel/task_graph_verifier.h"
+#include "mirage/type.h"
+#include "mirage/utils/json_utils.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cassert>
+#include <deque>
+#include <map>
+#include <set>
+#include <sstream>
+
+namespace mirage {
+namespace runtime {
+
+namespace {
+
+size_t get_event_position_index(EventId event_id) {
+  return (event_id & 0xffffffff);
+}
+
+// The bytes a task accesses in a tensor. When the offset decomposes into
+// coordinates along the strides, the region is a box of `dims` elements
+// starting at `coords`, in dimensions ordered by decreasing stride.
+// Otherwise only the [begin, end) byte interval that bounds it is known
+struct Region {
+  bool is_box;
+  std::vector<long long> strides, coords, dims;
+  unsigned long long begin, end;
+};
+
+struct Access {
+  TaskId task;
+  bool write;
+  Region region;
+};
+
+// A task accessing bytes that another task writes, or writing bytes that
+// another task reads
+struct Conflict {
+  TaskId task;
+  std::string tensor;
+  bool writes, other_writes;
+};
+
+Region get_region(json const &desc, unsigned long long offset) {
+  Region r;
+  size_t elem_size = type::get_datatype_size(
+      static_cast<type::DataType>(desc.at("data_type").get<int>()));
+  std::vector<std::pair<long long, long long>> stride_dims;
+  long long span = 0;
+  for (size_t d = 0; d < desc.at("dims").size(); d++) {
+    long long dim = desc["dims"][d].get<long long>();
+    long long stride = desc["strides"][d].get<long long>();
+    stride_dims.push_back({stride, dim});
+    span += (dim - 1) * stride;
+  }
+  r.begin = offset;
+  r.end = offset + (span + 1) * elem_size;
+  std::sort(stride_dims.rbegin(), stride_dims.rend());
+  r.is_box = offset % elem_size == 0;
+  long long rem = offset / elem_size;
+  for (size_t d = 0; d < stride_dims.size() && r.is_box; d++) {
+    long long stride = stride_dims[d].first, dim = stride_dims[d].second;
+    if (stride <= 0) {
+      r.is_box = false;
+      break;
+    }
+    long long coord = rem / stride;
+    rem %= stride;
+    // Inner dimensions must not wrap into the next outer index
+    if (d > 0 && (stride_dims[d - 1].first % stride != 0 ||
+                  coord + dim > stride_dims[d - 1].first / stride)) {
+      r.is_box = false;
+    }
+    r.strides.push_back(stride);
+    r.coords.push_back(coord);
+    r.dims.push_back(dim);
+  }
+  if (rem != 0) {
+    r.is_box = false;
+  }
+  return r;
+}
+
+bool overlap(Region const &a, Region const &b) {
+  if (a.is_box && b.is_box && a.strides == b.strides) {
+    for (size_t d = 0; d < a.dims.size(); d++) {
+      if (a.coords[d] + a.dims[d] <= b.coords[d] ||
+          b.coords[d] + b.dims[d] <= a.coords[d]) {
+        return false;
+      }
+    }
+    return true;
+  }
+  return a.begin < b.end && b.begin < a.end;
+}
+
+// The event graph and tensor accesses of one iteration of a task graph.
+// Pipelined tasks wait on an event of the previous iteration, so within an
+// iteration they have no dependent event
+struct TaskGraphAnalysis {
+  TaskGraphAnalysis(json const &j) {
+    json const &tasks = j.at("all_tasks");
+    json const &events = j.at("all_events");
+    json const &tensor_descs = j.at("tensor_descs");
+    num_tasks = tasks.size();
+    num_words = (num_tasks + 63) / 64;
+    trigger.assign(num_tasks, SIZE_MAX);
+    dependent.assign(num_tasks, SIZE_MAX);
+    pipelined.assign(num_tasks, false);
+    producers.resize(events.size());
+    consumers.resize(events.size());
+    for (TaskId t = 0; t < num_tasks; t++) {
+      EventId trigger_event = tasks[t].at("trigger_event").get<EventId>();
+      EventId dependent_event = tasks[t].at("dependent_event").get<EventId>();
+      pipelined[t] = tasks[t].value("pipelined", false);
+      // NVSHMEM events are matched by position, since all GPUs run the
+      // same task graph
+      if (trigger_event != EVENT_INVALID_ID) {
+        trigger[t] = get_event_position_index(trigger_event);
+        producers[trigger[t]].push_back(t);
+      }
+      if (dependent_event != EVENT_INVALID_ID) {
+        dependent[t] = get_event_position_index(dependent_event);
+        if (!pipelined[t]) {
+          consumers[dependent[t]].push_back(t);
+        }
+      }
+    }
+    // ancestors[t] is a bitset of the tasks that happen before task t
+    ancestors.assign(num_tasks, std::vector<uint64_t>(num_words, 0));
+    std::vector<size_t> num_preds(num_tasks, 0);
+    std::vector<TaskId> ready;
+    for (TaskId t = 0; t < num_tasks; t++) {
+      if (dependent[t] != SIZE_MAX && !pipelined[t]) {
+        num_preds[t] = producers[dependent[t]].size();
+      }
+      if (num_preds[t] == 0) {
+        ready.push_back(t);
+      }
+    }
+    while (!ready.empty()) {
+      TaskId t = ready.back();
+      ready.pop_back();
+      if (trigger[t] == SIZE_MAX) {
+        continue;
+      }
+      for (TaskId c : consumers[trigger[t]]) {
+        for (size_t w = 0; w < num_words; w++) {
+          ancestors[c][w] |= ancestors[t][w];
+        }
+        ancestors[c][t / 64] |= (uint64_t)1 << (t % 64);
+        if (--num_preds[c] == 0) {
+          ready.push_back(c);
+        }
+      }
+    }
+    for (TaskId t = 0; t < num_tasks; t++) {
+      for (char const *key : {"inputs", "outputs"}) {
+        for (json const &tensor : tasks[t].at(key)) {
+          json const &desc = tensor_descs.at(tensor.at("desc").get<size_t>());
+          accesses[desc.at("base_ptr").get<std::string>()].push_back(Access{
+              t,
+              key[0] == 'o',
+              get_region(desc, tensor.at("offset").get<unsigned long long>())});
+        }
+      }
+    }
+  }
+
+  bool happens_before(TaskId a, TaskId b) const {
+    return (ancestors[b][a / 64] >> (a % 64)) & 1;
+  }
+
+  // The tasks that have run once event e has been triggered by all its
+  // producers
+  std::vector<uint64_t> get_event_closure(size_t e) const {
+    std::vector<uint64_t> closure(num_words, 0);
+    for (TaskId p : producers[e]) {
+      for (size_t w = 0; w < num_words; w++) {
+        closure[w] |= ancestors[p][w];
+      }
+      closure[p / 64] |= (uint64_t)1 << (p % 64);
+    }
+    return closure;
+  }
+
+  std::vector<Conflict> get_conflicts(TaskId t) const {
+    std::vector<Conflict> conflicts;
+    for (auto const &it : accesses) {
+      for (Access const &a : it.second) {
+        if (a.task != t) {
+          continue;
+        }
+        for (Access const &b : it.second) {
+          if (b.task != t && (a.write || b.write) &&
+              overlap(a.region, b.region)) {
+            conflicts.push_back(Conflict{b.task, it.first, a.write, b.write});
+          }
+        }
+      }
+    }
+    return conflicts;
+  }
+
+  size_t num_tasks, num_words;
+  std::vector<size_t> trigger, dependent;
+  std::vector<bool> pipelined;
+  std::vector<std::vector<TaskId>> producers;
+  // Tasks waiting on each event within an iteration
+  std::vector<std::vector<TaskId>> consumers;
+  std::vector<std::vector<uint64_t>> ancestors;
+  std::map<std::string, std::vector<Access>> accesses;
+};
+
+} // namespace
+
+TaskGraphVerification verify_task_graph(std::string const &json_task_graph,
+                                        int num_workers) {
+  assert(num_workers > 0);
+  json j = json::parse(json_task_graph);
+  json const &events = j.at("all_events");
+  TaskGraphAnalysis graph(j);
+  size_t num_tasks = graph.num_tasks;
+  TaskGraphVerification result;
+  for (size_t e = 0; e < events.size(); e++) {
+    int num_triggers = events[e].at("num_triggers").get<int>();
+    size_t num_pipelined = 0;
+    for (TaskId p : graph.producers[e]) {
+      num_pipelined += graph.pipelined[p] ? 1 : 0;
+    }
+    // The termination event is triggered by the schedulers. Pipelined tasks
+    // trigger the event of the next iteration, so they cannot share events
+    // with other tasks, nor trigger events that launch tasks
+    if ((e > 0 && (size_t)num_triggers != graph.producers[e].size()) ||
+        (num_pipelined > 0 &&
+         (num_pipelined < graph.producers[e].size() ||
+          events[e].at("event_type").get<int>() != EVENT_EMPTY))) {
+      result.miscounted_events.push_back(e);
+    }
+  }
+  for (TaskId t = 0; t < num_tasks; t++) {
+    if (graph.pipelined[t] && graph.dependent[t] != SIZE_MAX) {
+      for (TaskId p : graph.producers[graph.dependent[t]]) {
+        if (graph.pipelined[p]) {
+          result.miscounted_events.push_back(graph.dependent[t]);
+          break;
+        }
+      }
+    }
+  }
+  std::sort(result.miscounted_events.begin(), result.miscounted_events.end());
+  result.miscounted_events.erase(std::unique(result.miscounted_events.begin(),
+                                             result.miscounted_events.end()),
+                                 result.miscounted_events.end());
+
+  // Replay the first iteration: workers run their queues in order, and a
+  // task runs once all producers of its dependent event have run. The
+  // first iteration launches its pipelined tasks before its other tasks,
+  // and the pipelined tasks of the second iteration after them
+  {
+    std::vector<std::pair<TaskId, bool>> launches;
+    for (int pass = 0; pass < 3; pass++) {
+      for (TaskId t = 2; t < num_tasks; t++) {
+        if (graph.pipelined[t] == (pass != 1)) {
+          launches.push_back({t, pass == 2});
+        }
+      }
+    }
+    std::vector<std::deque<std::pair<TaskId, bool>>> queues(num_workers);
+    for (size_t k = 0; k < launches.size(); k++) {
+      queues[k % num_workers].push_back(launches[k]);
+    }
+    std::vector<size_t> event_counts(events.size(), 0);
+    bool progress = true;
+    while (progress) {
+      progress = false;
+      for (auto &queue : queues) {
+        while (!queue.empty()) {
+          TaskId t = queue.front().first;
+          bool waits = !graph.pipelined[t] || queue.front().second;
+          size_t e = graph.dependent[t];
+          if (waits && e != SIZE_MAX &&
+              event_counts[e] < graph.producers[e].size()) {
+            break;
+          }
+          // Only count the triggers of the first iteration
+          if (graph.trigger[t] != SIZE_MAX && !queue.front().second) {
+            event_counts[graph.trigger[t]]++;
+          }
+          queue.pop_front();
+          progress = true;
+        }
+      }
+    }
+    for (auto const &queue : queues) {
+      for (auto const &launch : queue) {
+        result.deadlocked_tasks.push_back(launch.first);
+      }
+    }
+    std::sort(result.deadlocked_tasks.begin(), result.deadlocked_tasks.end());
+    result.deadlocked_tasks.erase(std::unique(result.deadlocked_tasks.begin(),
+                                              result.deadlocked_tasks.end()),
+                                  result.deadlocked_tasks.end());
+  }
+
+  std::set<std::tuple<TaskId, TaskId, std::string>> reported;
+  for (auto const &it : graph.accesses) {
+    std::vector<Access> const &list = it.second;
+    for (size_t a = 0; a < list.size(); a++) {
+      if (!list[a].write) {
+        continue;
+      }
+      for (size_t b = 0; b < list.size(); b++) {
+        if (list[a].task == list[b].task || (list[b].write && b < a) ||
+            !overlap(list[a].region, list[b].region) ||
+            graph.happens_before(list[a].task, list[b].task) ||
+            graph.happens_before(list[b].task, list[a].task)) {
+          continue;
+        }
+        TaskId first = std::min(list[a].task, list[b].task);
+        TaskId second = std::max(list[a].task, list[b].task);
+        if (reported.insert({first, second, it.first}).second) {
+          bool a_first = list[a].task == first;
+          result.races.push_back(
+              TaskGraphRace{first,
+                            second,
+                            it.first,
+                            a_first ? list[a].write : list[b].write,
+                            a_first ? list[b].write : list[a].write,
+                            false /*across_iterations*/});
+        }
+      }
+    }
+  }
+  // A pipelined task of iteration i + 1 must run after all tasks of
+  // iteration i that conflict with it
+  for (TaskId t = 0; t < num_tasks; t++) {
+    if (!graph.pipelined[t]) {
+      continue;
+    }
+    std::vector<uint64_t> closure(graph.num_words, 0);
+    if (graph.dependent[t] != SIZE_MAX) {
+      closure = graph.get_event_closure(graph.dependent[t]);
+    }
+    std::set<std::pair<TaskId, std::string>> reported_conflicts;
+    for (Conflict const &c : graph.get_conflicts(t)) {
+      if (graph.pipelined[c.task] ||
+          ((closure[c.task / 64] >> (c.task % 64)) & 1) ||
+          !reported_conflicts.insert({c.task, c.tensor}).second) {
+        continue;
+      }
+      result.races.push_back(
+          TaskGraphRace{c.task, t, c.tensor, c.other_writes, c.writes, true});
+    }
+  }
+  return result;
+}
+
+std::string pipeline_task_graph(std::string const &json_task_graph) {
+  json j = json::parse(json_task_graph);
+  json &tasks = j.at("all_tasks");
+  json const &events = j.at("all_events");
+  for (json const &task : tasks) {
+    if (task.value("pipelined", false)) {
+      return json_task_graph;
+    }
+  }
+  TaskGraphAnalysis graph(j);
+  size_t num_tasks = graph.num_tasks;
+  // Candidates are weight-only tasks without dependencies in their
+  // iteration, that trigger an empty local event
+  std::vector<bool> candidate(num_tasks, false);
+  for (TaskId t = 2; t < num_tasks; t++) {
+    EventId trigger_event = tasks[t].at("trigger_event").get<EventId>();
+    candidate[t] =
+        tasks[t].value("weight_only", false) &&
+        graph.dependent[t] == SIZE_MAX && graph.trigger[t] != SIZE_MAX &&
+        (trigger_event & EVENT_NVSHMEM_TAG) == 0 &&
+        events[graph.trigger[t]].at("event_type").get<int>() == EVENT_EMPTY;
+  }
+  std::vector<std::vector<uint64_t>> closures(events.size());
+  std::vector<size_t> closure_sizes(events.size(), 0);
+  for (size_t e = 2; e < events.size(); e++) {
+    closures[e] = graph.get_event_closure(e);
+    for (uint64_t word : closures[e]) {
+      closure_sizes[e] += std::bitset<64>(word).count();
+    }
+  }
+  // The earliest event, triggered by tasks that are not pipelined, after
+  // which all tasks of an iteration that conflict with task t have run
+  auto get_hazard_event = [&](TaskId t) {
+    std::vector<uint64_t> hazards(graph.num_words, 0);
+    bool has_hazards = false;
+    for (Conflict const &c : graph.get_conflicts(t)) {
+      if (candidate[c.task]) {
+        return SIZE_MAX;
+      }
+      hazards[c.task / 64] |= (uint64_t)1 << (c.task % 64);
+      has_hazards = true;
+    }
+    size_t best = SIZE_MAX;
+    for (size_t e = 2; e < events.size() && has_hazards; e++) {
+      bool valid = !graph.producers[e].empty();
+      for (TaskId p : graph.producers[e]) {
+        valid = valid && !candidate[p];
+      }
+      for (size_t w = 0; w < graph.num_words && valid; w++) {
+        valid = (hazards[w] & ~closures[e][w]) == 0;
+      }
+      if (valid &&
+          (best == SIZE_MAX || closure_sizes[e] < closure_sizes[best])) {
+        best = e;
+      }
+    }
+    return best;
+  };
+  // All producers of an event are pipelined together, so that its counter
+  // advances by num_triggers per iteration. Dropping the producers of one
+  // event only makes more events valid hazard events, so this converges
+  std::vector<size_t> hazard_events(num_tasks, SIZE_MAX);
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t e = 2; e < events.size(); e++) {
+      std::vector<TaskId> const &producers = graph.producers[e];
+      bool pipelined = !producers.empty() && candidate[producers[0]];
+      for (TaskId p : producers) {
+        pipelined = pipelined && candidate[p];
+      }
+      for (TaskId p : producers) {
+        hazard_events[p] = pipelined ? get_hazard_event(p) : SIZE_MAX;
+        pipelined = pipelined && hazard_events[p] != SIZE_MAX;
+      }
+      for (TaskId p : producers) {
+        if (!pipelined && candidate[p]) {
+          candidate[p] = false;
+          changed = true;
+        }
+      }
+    }
+  }
+  for (TaskId t = 2; t < num_tasks; t++) {
+    if (candidate[t]) {
+      EventId trigger_event = tasks[t].at("trigger_event").get<EventId>();
+      tasks[t]["pipelined"] = true;
+      tasks[t]["dependent_event"] =
+          (trigger_event & ~(EventId)0xffffffff) | hazard_events[t];
+    }
+  }
+  return j.dump(2);
+}
+
+std::string TaskGraphVerification::to_string() const {
+  std::ostringstream oss;
+  for (TaskGraphRace const &race : races) {
+    oss << "race on " << race.tensor << ": task " << race.first_task
+        << (race.first_writes ? " writes" : " reads") << ", task "
+        << race.second_task << (race.second_writes ? " writes" : " reads")
+        << (race.across_iterations ? " in the next iteration" : "") << "\n";
+  }
+  for (size_t e : miscounted_events) {
+    oss << "event " << e
+        << ": num_triggers does not match its producers in an iteration\n";
+  }
+  if (!deadlocked_tasks.empty()) {
+    oss << "deadlock: " << deadlocked_tasks.size() << " tasks never run:";
+    for (TaskId t : deadlocked_tasks) {
+      oss << " " << t;
+    }
+    oss << "\n";
+  }
+  if (ok()) {
+    oss << "no races or deadlocks\n";
+  }
+  return oss.str();
+}
+
+} // namespace runtime
+} // namespace mirage
@@ -16,6 +16,10 @@
 #include "mirage/kernel/task_register.h"
 #include "mirage/kernel/operator.h"
 #include "mirage/transpiler/utils.h"
+#include "mirage/utils/hash_utils.h"
+
+#include <set>
+#include <sstream>
 
 namespace mirage {
 namespace runtime {
@@ -23,6 +27,43 @@ namespace runtime {
 namespace kn = mirage::kernel;
 namespace tb = mirage::threadblock;
 
+namespace {
+
+char const *get_task_type_name(TaskType task_type) {
+  switch (task_type) {
+    case TASK_EMBEDDING:
+      return "TASK_EMBEDDING";
+    case TASK_RMS_NORM_LINEAR:
+      return "TASK_RMS_NORM_LINEAR";
+    case TASK_ATTENTION_1:
+      return "TASK_ATTENTION_1";
+    case TASK_SILU_MUL_LINEAR_WITH_RESIDUAL:
+      return "TASK_SILU_MUL_LINEAR_WITH_RESIDUAL";
+    case TASK_LINEAR_WITH_RESIDUAL:
+      return "TASK_LINEAR_WITH_RESIDUAL";
+    case TASK_ARGMAX_PARTIAL:
+      return "TASK_ARGMAX_PARTIAL";
+    case TASK_ARGMAX_REDUCE:
+      return "TASK_ARGMAX_REDUCE";
+    default:
+      assert(false && "Task type has no variants");
+      return nullptr;
+  }
+}
+
+} // namespace
+
+TaskVariantKey::TaskVariantKey(TaskType _task_type,
+                               std::vector<int> const &_template_params,
+                               std::vector<int> const &_runtime_params)
+    : task_type(_task_type), template_params(_template_params),
+      runtime_params(_runtime_params) {}
+
+bool TaskVariantKey::operator==(TaskVariantKey const &b) const {
+  return task_type == b.task_type && template_params == b.template_params &&
+         runtime_params == b.runtime_params;
+}
+
 TaskRegister *TaskRegister::singleton = nullptr;
 
 TaskRegister::TaskRegister() {}
@@ -34,31 +75,80 @@ TaskRegister *TaskRegister::get_instance() {
   return singleton;
 }
 
-int TaskRegister::register_task_variant(runtime::TaskType type,
+int TaskRegister::register_task_variant(TaskVariantKey const &key,
                                         std::string const &code) {
-  std::vector<std::string> &variants = all_task_variants[type];
-  for (size_t i = 0; i < variants.size(); i++) {
-    if (variants[i] == code) {
-      return (int)(i);
+  auto it = variant_ids.find(key);
+  if (it == variant_ids.end()) {
+    // Add a new variant
+    std::vector<std::string> &variants = all_task_variants[key.task_type];
+    variants.push_back(code);
+    num_variant_uses[key.task_type].push_back(0);
+    it = variant_ids.emplace(key, (int)(variants.size() - 1)).first;
+  } else {
+    // Equal keys must generate the same code, otherwise some ops would run
+    // another op's variant
+    assert(all_task_variants[key.task_type][it->second] == code);
+  }
+  num_variant_uses[key.task_type][it->second]++;
+  return it->second;
+}
+
+void TaskRegister::generate_dispatch_code(
+    mirage::transpiler::CodeKeeper &code) const {
+  code.e("switch (task_desc.task_type) {");
+  for (auto const &task : all_task_variants) {
+    code.e(FMT_STR("case $: {"), get_task_type_name(task.first));
+    code.e("switch (task_desc.variant_id) {");
+    for (size_t variant_id = 0; variant_id < task.second.size(); variant_id++) {
+      code.e(FMT_STR("case $: {"), variant_id);
+      std::istringstream lines(task.second[variant_id]);
+      std::string line;
+      while (std::getline(lines, line)) {
+        code.e(FMT_STR("$"), line);
+      }
+      code.e("break;");
+      code.e("}");
     }
+    code.e("}");
+    code.e("break;");
+    code.e("}");
+  }
+  code.e("default: {");
+  code.e("break;");
+  code.e("}");
+  code.e("}");
+}
+
+void TaskRegister::print_summary() const {
+  std::map<TaskType, std::set<std::vector<int>>> instantiations;
+  for (auto const &it : variant_ids) {
+    instantiations[it.first.task_type].insert(it.first.template_params);
+  }
+  for (auto const &task : all_task_variants) {
+    int num_ops = 0;
+    for (int num_uses : num_variant_uses.at(task.first)) {
+      num_ops += num_uses;
+    }
+    printf("%s: %zu variants, %zu template instantiations, %d ops\n",
+           get_task_type_name(task.first),
+           task.second.size(),
+           instantiations[task.first].size(),
+           num_ops);
   }
-  // Add a new variant
-  variants.push_back(code);
-  return (int)(variants.size() - 1);
 }
 
 int TaskRegister::register_embedding_task(threadblock::Graph const &bgraph,
                                           std::vector<int> const &params) {
   assert(params.size() == 1);
   mirage::transpiler::CodeKeeper code;
-  code.inc_indent();
-  code.e("kernel::embedding_kernel<bfloat16, $>(", params[0]);
+  code.e(FMT_STR("kernel::embedding_kernel<bfloat16, $>("), params[0]);
   code.e("    task_desc.inputs[0].base_ptr,");
   code.e("    task_desc.inputs[1].base_ptr,");
   code.e("    task_desc.outputs[0].base_ptr,");
   code.e("    runtime_config.step[0],");
   code.e("    runtime_config.tokens);");
-  return register_task_variant(TASK_EMBEDDING, code.to_string());
+  return register_task_variant(TaskVariantKey(TASK_EMBEDDING, {params[0]}, {}),
+                               code.to_string());
 }
 
 int TaskRegister::register_rmsnorm_linear_task(threadblock::Graph const &bgraph,
@@ -91,8 +181,7 @@ int TaskRegister::register_rmsnorm_linear_task(threadblock::Graph const &bgraph,
   output_stride = static_cast<int>(kn_input_op->input_strides[0]);
 
   mirage::transpiler::CodeKeeper code;
-  code.inc_indent();
-  code.e("kernel::norm_linear_task_impl<bfloat16, $, $, $, $>(",
+  code.e(FMT_STR("kernel::norm_linear_task_impl<bfloat16, $, $, $, $>("),
          batch_size,
          output_size,
          reduction_size,
@@ -102,7 +191,11 @@ int TaskRegister::register_rmsnorm_linear_task(threadblock::Graph const &bgraph,
   code.e("    task_desc.inputs[2].base_ptr,");
   code.e("    1e-6f,");
   code.e("    task_desc.outputs[0].base_ptr);");
-  return register_task_variant(TASK_RMS_NORM_LINEAR, code.to_string());
+  return register_task_variant(
+      TaskVariantKey(TASK_RMS_NORM_LINEAR,
+                     {batch_size, output_size, reduction_size, output_stride},
+                     {}),
+      code.to_string());
 }
 
 int TaskRegister::register_attention_task(threadblock::Graph const &bgraph,
@@ -139,8 +232,7 @@ int TaskRegister::register_attention_task(threadblock::Graph const &bgraph,
   assert(head_dim == input_ops[2]->output_tensors[0].dim[3]);
 
   mirage::transpiler::CodeKeeper code;
-  code.inc_indent();
-  code.e("kernel::single_batch_decoding_kernel<bfloat16, $, $, $, $>(",
+  code.e(FMT_STR("kernel::single_batch_decoding_kernel<bfloat16, $, $, $, $>("),
          num_q_heads / num_kv_heads,
          1,
          head_dim,
@@ -150,15 +242,19 @@ int TaskRegister::register_attention_task(threadblock::Graph const &bgraph,
   code.e("    task_desc.inputs[2].base_ptr,");
   code.e("    task_desc.outputs[0].base_ptr,");
   code.e("    runtime_config.step[0],");
-  code.e("    $,", params[2] > 0);
-  code.e("    $,", params[3] > 0);
+  code.e(FMT_STR("    $,"), params[2] > 0);
+  code.e(FMT_STR("    $,"), params[3] > 0);
   code.e("    task_desc.inputs[3].base_ptr,");
   code.e("    task_desc.inputs[4].base_ptr,");
   code.e("    task_desc.inputs[5].base_ptr,");
   code.e("    task_desc.inputs[6].base_ptr,");
   code.e("    1e-6f,");
   code.e("    1e-6f);");
-  return register_task_variant(TASK_ATTENTION_1, code.to_string());
+  return register_task_variant(
+      TaskVariantKey(TASK_ATTENTION_1,
+                     {num_q_heads / num_kv_heads, 1, head_dim, kv_stride},
+                     {params[2] > 0, params[3] > 0}),
+      code.to_string());
 }
 
 int TaskRegister::register_silu_mul_linear_with_residual_task(
@@ -191,8 +287,7 @@ int TaskRegister::register_silu_mul_linear_with_residual_task(
   output_stride = static_cast<int>(kn_input_op->input_strides[0]);
 
   mirage::transpiler::CodeKeeper code;
-  code.inc_indent();
-  code.e("kernel::silu_mul_linear_task_impl<bfloat16, $, $, $, $>(",
+  code.e(FMT_STR("kernel::silu_mul_linear_task_impl<bfloat16, $, $, $, $>("),
          batch_size,
          output_size,
          reduction_size,
@@ -202,8 +297,11 @@ int TaskRegister::register_silu_mul_linear_with_residual_task(
   code.e("    task_desc.inputs[2].base_ptr,");
   code.e("    task_desc.outputs[0].base_ptr,");
   code.e("    runtime_config.my_gpu_id == 0);");
-  return register_task_variant(TASK_SILU_MUL_LINEAR_WITH_RESIDUAL,
-                               code.to_string());
+  return register_task_variant(
+      TaskVariantKey(TASK_SILU_MUL_LINEAR_WITH_RESIDUAL,
+                     {batch_size, output_size, reduction_size, output_stride},
+                     {}),
+      code.to_string());
 }
 
 int TaskRegister::register_linear_with_residual_task(
@@ -236,8 +334,7 @@ int TaskRegister::register_linear_with_residual_task(
   output_stride = static_cast<int>(kn_input_op->input_strides[0]);
 
   mirage::transpiler::CodeKeeper code;
-  code.inc_indent();
-  code.e("kernel::linear_kernel<bfloat16, $, $, $, $>(",
+  code.e(FMT_STR("kernel::linear_kernel<bfloat16, $, $, $, $>("),
          batch_size,
          output_size,
          reduction_size,
@@ -247,7 +344,11 @@ int TaskRegister::register_linear_with_residual_task(
   code.e("    task_desc.inputs[2].base_ptr,");
   code.e("    task_desc.outputs[0].base_ptr,");
   code.e("    runtime_config.my_gpu_id == 0);");
-  return register_task_variant(TASK_LINEAR_WITH_RESIDUAL, code.to_string());
+  return register_task_variant(
+      TaskVariantKey(TASK_LINEAR_WITH_RESIDUAL,
+                     {batch_size, output_size, reduction_size, output_stride},
+                     {}),
+      code.to_string());
 }
 
 int TaskRegister::register_argmax_partial_task(threadblock::Graph const &bgraph,
@@ -271,12 +372,13 @@ int TaskRegister::register_argmax_partial_task(threadblock::Graph const &bgraph,
   int num_elements = input_ops[0]->output_tensors[0].dim[1];
 
   mirage::transpiler::CodeKeeper code;
-  code.inc_indent();
-  code.e("kernel::argmax_partial_kernel<bfloat16, $>(", num_elements);
+  code.e(FMT_STR("kernel::argmax_partial_kernel<bfloat16, $>("), num_elements);
   code.e("    task_desc.inputs[0].base_ptr,");
   code.e("    task_desc.outputs[0].base_ptr,");
   code.e("    task_desc.outputs[1].base_ptr);");
-  return register_task_variant(TASK_ARGMAX_PARTIAL, code.to_string());
+  return register_task_variant(
+      TaskVariantKey(TASK_ARGMAX_PARTIAL, {num_elements}, {}),
+      code.to_string());
 }
 
 int TaskRegister::register_argmax_reduce_task(threadblock::Graph const &bgraph,
@@ -301,15 +403,31 @@ int TaskRegister::register_argmax_reduce_task(threadblock::Graph const &bgraph,
   int num_parts = input_ops[0]->output_tensors[0].dim[1];
 
   mirage::transpiler::CodeKeeper code;
-  code.inc_indent();
-  code.e("kernel::argmax_reduce_kernel<bfloat16, $, $>(", params[0], num_parts);
+  code.e(FMT_STR("kernel::argmax_reduce_kernel<bfloat16, $, $>("),
+         params[0],
+         num_parts);
   code.e("    task_desc.inputs[0].base_ptr,");
   code.e("    task_desc.inputs[1].base_ptr,");
   code.e("    task_desc.outputs[0].base_ptr,");
   code.e("    runtime_config.step[0],");
   code.e("    runtime_config.tokens);");
-  return register_task_variant(TASK_ARGMAX_REDUCE, code.to_string());
+  return register_task_variant(
+      TaskVariantKey(TASK_ARGMAX_REDUCE, {params[0], num_parts}, {}),
+      code.to_string());
 }
 
 } // namespace runtime
 } // namespace mirage
+
+namespace std {
+
+size_t hash<mirage::runtime::TaskVariantKey>::operator()(
+    mirage::runtime::TaskVariantKey const &key) const {
+  size_t ret = 0;
+  hash_combine(ret, (int)key.task_type);
+  hash_combine(ret, key.template_params);
+  hash_combine(ret, key.runtime_params);
+  return ret;
+}
+
+} // namespace std
@@ -326,7 +326,7 @@ std::optional<NKIErrorInfo> NKITranspiler::resolve_tensor_layout() {
   for (tb::STensor const &stensor : all_stensors) {
     int num_dims = stensor.num_dims;
     for (int i = 0; i < num_dims; i++) {
-      std::string var_name = fmt("sp_$_$", stensor.guid, i);
+      std::string var_name = fmt(FMT_STR("sp_$_$"), stensor.guid, i);
       s_is_partition[stensor.guid].push_back(ctx.bool_const(var_name.c_str()));
     }
   }
@@ -496,7 +496,8 @@ std::optional<NKIErrorInfo> NKITranspiler::resolve_tensor_layout() {
             break;
           }
           default: {
-            assert(fmt("Unsupported TB op: $", tb_op->op_type).c_str());
+            assert(
+                fmt(FMT_STR("Unsupported TB op: $"), tb_op->op_type).c_str());
           }
         }
       }
@@ -557,10 +558,11 @@ NKITranspileResult NKITranspiler::transpile_ugraph() {
     for (kn::DTensor const &dtensor : op->output_tensors) {
       std::string shape;
       for (int i = 0; i < dtensor.num_dims; i++) {
-        shape += fmt("$,", dtensor.dim[i]);
+        shape += fmt(FMT_STR("$,"), dtensor.dim[i]);
       }
-      exec.e("$ = torch.randn(($), dtype=torch.float16).to(device=device)",
-             fmt("dtensor$", dtensor.guid),
+      exec.e(FMT_STR(
+                 "$ = torch.randn(($), dtype=torch.float16).to(device=device)"),
+             fmt(FMT_STR("dtensor$"), dtensor.guid),
              shape);
     }
 #ifdef DEADCODE
@@ -568,20 +570,22 @@ NKITranspileResult NKITranspiler::transpile_ugraph() {
       std::string shape;
       kn::DTensor dtensor = op->output_tensors.at(0);
       for (int i = 0; i < dtensor.num_dims; i++) {
-        shape += fmt("$,", dtensor.dim[i]);
+        shape += fmt(FMT_STR("$,"), dtensor.dim[i]);
       }
-      exec.e("$ = torch.randn(($), dtype=torch.float16).to(device=device)",
-             fmt("dtensor$", dtensor.guid),
+      exec.e(FMT_STR(
+                 "$ = torch.randn(($), dtype=torch.float16).to(device=device)"),
+             fmt(FMT_STR("dtensor$"), dtensor.guid),
              shape);
     }
     if (op->op_type == type::KNOperatorType::KN_OUTPUT_OP) {
       std::string shape;
       kn::DTensor dtensor = op->input_tensors.at(0);
       for (int i = 0; i < dtensor.num_dims; i++) {
-        shape += fmt("$,", dtensor.dim[i]);
+        shape += fmt(FMT_STR("$,"), dtensor.dim[i]);
       }
-      exec.e("$ = torch.randn(($), dtype=torch.float16).to(device=device)",
-             fmt("dtensor$", dtensor.guid),
+      exec.e(FMT_STR(
+                 "$ = torch.randn(($), dtype=torch.float16).to(device=device)"),
+             fmt(FMT_STR("dtensor$"), dtensor.guid),
              shape);
     }
 #endif
@@ -604,14 +608,14 @@ NKITranspileResult NKITranspiler::transpile_ugraph() {
         std::vector<std::string> dtensor_names;
         for (kn::DTensor const &dtensor :
              Combine(cur_op->output_tensors, cur_op->input_tensors)) {
-          std::string dtensor_name = fmt("dtensor$", dtensor.guid);
+          std::string dtensor_name = fmt(FMT_STR("dtensor$"), dtensor.guid);
           dtensor_names.push_back(dtensor_name);
         }
         // Transpile
         NKICustomOPTranspileResult result = transpile_kn_custom_op(cur_op);
         // Launch kernels
         custom_kernels.e(result.code);
-        exec.e("$[$, $, $]($)",
+        exec.e(FMT_STR("$[$, $, $]($)"),
                result.func_name,
                bgraph.grid_dim.x,
                bgraph.grid_dim.y,
@@ -628,7 +632,7 @@ NKITranspileResult NKITranspiler::transpile_ugraph() {
         std::vector<std::string> dtensor_names;
         for (kn::DTensor const &dtensor :
              Combine(cur_op->output_tensors, cur_op->input_tensors)) {
-          std::string dtensor_name = fmt("dtensor$", dtensor.guid);
+          std::string dtensor_name = fmt(FMT_STR("dtensor$"), dtensor.guid);
           dtensor_names.push_back(dtensor_name);
         }
         // Transpile
@@ -636,7 +640,7 @@ NKITranspileResult NKITranspiler::transpile_ugraph() {
         if (result.has_value()) {
           custom_kernels.e(result.value().code);
           // launch a single SPMD kernel
-          exec.e("$($)", result.value().func_name, dtensor_names);
+          exec.e(FMT_STR("$($)"), result.value().func_name, dtensor_names);
         }
         break;
       }
@@ -649,7 +653,7 @@ NKITranspileResult NKITranspiler::transpile_ugraph() {
     }
   }
 
-  std::string code = fmt("$\n$\n$",
+  std::string code = fmt(FMT_STR("$\n$\n$"),
                          header.to_string(),
                          custom_kernels.to_string(),
                          exec.to_string());
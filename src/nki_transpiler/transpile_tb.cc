@@ -134,21 +134,22 @@ NKICustomOPTranspileResult
   tb::Graph const &g = op->bgraph;
   static int nki_custom_kernel_idx_counter = 0;
   int cur_custom_kernel_idx = nki_custom_kernel_idx_counter++;
-  string func_name = fmt("custom_kernel_$", cur_custom_kernel_idx);
+  string func_name = fmt(FMT_STR("custom_kernel_$"), cur_custom_kernel_idx);
 
   // Generate code prologue
   CodeKeeper code;
   code.e("@nki_jit");
-  code.e("def $($, $):",
-         func_name,
-         map<kn::DTensor, string>(op->output_tensors,
-                                  [](kn::DTensor const &dtensor) -> string {
-                                    return fmt("dtensor$", dtensor.guid);
-                                  }),
-         map<kn::DTensor, string>(op->input_tensors,
-                                  [](kn::DTensor const &dtensor) -> string {
-                                    return fmt("dtensor$", dtensor.guid);
-                                  }));
+  code.e(
+      FMT_STR("def $($, $):"),
+      func_name,
+      map<kn::DTensor, string>(op->output_tensors,
+                               [](kn::DTensor const &dtensor) -> string {
+                                 return fmt(FMT_STR("dtensor$"), dtensor.guid);
+                               }),
+      map<kn::DTensor, string>(op->input_tensors,
+                               [](kn::DTensor const &dtensor) -> string {
+                                 return fmt(FMT_STR("dtensor$"), dtensor.guid);
+                               }));
   code.inc_indent();
   // Initialize all accum stensors
   for (tb::TBOperator *tb_op : g.operators) {
@@ -175,29 +176,31 @@ NKICustomOPTranspileResult
       }
       if (stensor.num_dims == 1) {
         // Create a 1D tile
-        code.e("$ = nl.zeros(($), dtype=nl.float32, buffer=nl.sbuf)",
-               fmt("stensor$", stensor.guid),
+        code.e(FMT_STR("$ = nl.zeros(($), dtype=nl.float32, buffer=nl.sbuf)"),
+               fmt(FMT_STR("stensor$"), stensor.guid),
                stensor.dim[0]);
       } else {
         // Create a 2D tile
         if (meta.partition_dim == stensor.num_dims - 2) {
-          code.e("$ = nl.zeros(($, $), dtype=nl.float32, buffer=nl.sbuf)",
-                 fmt("stensor$", stensor.guid),
-                 stensor.dim[stensor.num_dims - 2],
-                 stensor.dim[stensor.num_dims - 1]);
+          code.e(
+              FMT_STR("$ = nl.zeros(($, $), dtype=nl.float32, buffer=nl.sbuf)"),
+              fmt(FMT_STR("stensor$"), stensor.guid),
+              stensor.dim[stensor.num_dims - 2],
+              stensor.dim[stensor.num_dims - 1]);
         } else {
           assert(meta.partition_dim == stensor.num_dims - 1);
           // num_dims - 1 is the partition_dim
-          code.e("$ = nl.zeros(($, $), dtype=nl.float32, buffer=nl.sbuf)",
-                 fmt("stensor$", stensor.guid),
-                 stensor.dim[stensor.num_dims - 1],
-                 stensor.dim[stensor.num_dims - 2]);
+          code.e(
+              FMT_STR("$ = nl.zeros(($, $), dtype=nl.float32, buffer=nl.sbuf)"),
+              fmt(FMT_STR("stensor$"), stensor.guid),
+              stensor.dim[stensor.num_dims - 1],
+              stensor.dim[stensor.num_dims - 2]);
         }
       }
     }
   }
   if (g.forloop_range > 1) {
-    code.e("for i in range($):", g.forloop_range);
+    code.e(FMT_STR("for i in range($):"), g.forloop_range);
     code.inc_indent();
   }
   // Generate code for operators before accum
@@ -227,8 +230,8 @@ NKICustomOPTranspileResult
         std::string nki_dtype = mirage_dtype_to_nki(stensor.data_type);
         if (meta.partition_dim == stensor.num_dims - 2) {
           // Normal case
-          code.e("$ = nl.ndarray(($, $), dtype=$, buffer=nl.sbuf)",
-                 fmt("stensor$", stensor.guid),
+          code.e(FMT_STR("$ = nl.ndarray(($, $), dtype=$, buffer=nl.sbuf)"),
+                 fmt(FMT_STR("stensor$"), stensor.guid),
                  stensor.dim[stensor.num_dims - 2],
                  stensor.dim[stensor.num_dims - 1],
                  nki_dtype);
@@ -238,8 +241,8 @@ NKICustomOPTranspileResult
           // partition dim is the innermost dimension so we need
           // to use load_transposed2d
           transposed = true;
-          code.e("$ = nl.ndarray(($, $), dtype=$, buffer=nl.sbuf)",
-                 fmt("stensor$", stensor.guid),
+          code.e(FMT_STR("$ = nl.ndarray(($, $), dtype=$, buffer=nl.sbuf)"),
+                 fmt(FMT_STR("stensor$"), stensor.guid),
                  stensor.dim[stensor.num_dims - 1],
                  stensor.dim[stensor.num_dims - 2],
                  nki_dtype);
@@ -254,38 +257,40 @@ NKICustomOPTranspileResult
             if (forloop_dim == i) {
               scale_factor *= g.forloop_range;
             }
-            index = fmt("nl.program_id(0) * $", scale_factor);
+            index = fmt(FMT_STR("nl.program_id(0) * $"), scale_factor);
           } else if (imap.y == i) {
             int scale_factor = stensor.dim[i];
             if (forloop_dim == i) {
               scale_factor *= g.forloop_range;
             }
-            index = fmt("nl.program_id(1) * $", scale_factor);
+            index = fmt(FMT_STR("nl.program_id(1) * $"), scale_factor);
           } else if (imap.z == i) {
             int scale_factor = stensor.dim[i];
             if (forloop_dim == i) {
               scale_factor *= g.forloop_range;
             }
-            index = fmt("nl.program_id(2) * $", scale_factor);
+            index = fmt(FMT_STR("nl.program_id(2) * $"), scale_factor);
           }
           if (forloop_dim == i) {
             if (index == "") {
-              index = fmt("i * $", stensor.dim[i]);
+              index = fmt(FMT_STR("i * $"), stensor.dim[i]);
             } else {
-              index = index + fmt("+ i * $", stensor.dim[i]);
+              index = index + fmt(FMT_STR("+ i * $"), stensor.dim[i]);
             }
           }
           if (i == stensor.num_dims - 2) {
             if (index == "") {
-              index = fmt("nl.arange($)[:, None]", stensor.dim[i]);
+              index = fmt(FMT_STR("nl.arange($)[:, None]"), stensor.dim[i]);
             } else {
-              index = index + fmt(" + nl.arange($)[:, None]", stensor.dim[i]);
+              index = index +
+                      fmt(FMT_STR(" + nl.arange($)[:, None]"), stensor.dim[i]);
             }
           } else if (i == stensor.num_dims - 1) {
             if (index == "") {
-              index = fmt("nl.arange($)[None, :]", stensor.dim[i]);
+              index = fmt(FMT_STR("nl.arange($)[None, :]"), stensor.dim[i]);
             } else {
-              index = index + fmt(" + nl.arange($)[None, :]", stensor.dim[i]);
+              index = index +
+                      fmt(FMT_STR(" + nl.arange($)[None, :]"), stensor.dim[i]);
             }
           }
           if (index == "") {
@@ -297,10 +302,10 @@ NKICustomOPTranspileResult
           }
         }
 
-        code.e("$ = $($[$])",
-               fmt("stensor$", stensor.guid),
+        code.e(FMT_STR("$ = $($[$])"),
+               fmt(FMT_STR("stensor$"), stensor.guid),
                transposed ? "nl.load_transpose2d" : "nl.load",
-               fmt("dtensor$", dtensor.guid),
+               fmt(FMT_STR("dtensor$"), dtensor.guid),
                range);
         break;
       }
@@ -315,8 +320,8 @@ NKICustomOPTranspileResult
         STensorMeta meta0 = stensor_metas.at(input0.guid);
         STensorMeta meta1 = stensor_metas.at(input1.guid);
         STensorMeta meta2 = stensor_metas.at(output.guid);
-        std::string operand0 = fmt("stensor$", input0.guid);
-        std::string operand1 = fmt("stensor$", input1.guid);
+        std::string operand0 = fmt(FMT_STR("stensor$"), input0.guid);
+        std::string operand1 = fmt(FMT_STR("stensor$"), input1.guid);
         int input0_par = 0, input0_contr = 1;
         int input1_par = 1, input1_contr = 0;
 
@@ -339,15 +344,15 @@ NKICustomOPTranspileResult
         auto splitMatmulAlongContractionAxis = [&]() {
           // split matmul into (128, n) & (128, m)
           std::string i0_paxis =
-              fmt("nl.arange($)[:, None]", input0.dim[input0_par]);
+              fmt(FMT_STR("nl.arange($)[:, None]"), input0.dim[input0_par]);
           std::string contr_axis =
               fmt("accidx * 128 + nl.arange(128)[None, :]");
           std::string i1_paxis =
-              fmt("nl.arange($)[:, None]", input1.dim[input1_par]);
+              fmt(FMT_STR("nl.arange($)[:, None]"), input1.dim[input1_par]);
           std::string op0 =
-              fmt("stensor$[$, $]", input0.guid, i0_paxis, contr_axis);
+              fmt(FMT_STR("stensor$[$, $]"), input0.guid, i0_paxis, contr_axis);
           std::string op1 =
-              fmt("stensor$[$, $]", input1.guid, i1_paxis, contr_axis);
+              fmt(FMT_STR("stensor$[$, $]"), input1.guid, i1_paxis, contr_axis);
 
           // emit a psum buffer for accum.
           int accum_psize = meta2.partition_dim == 0 ? input0.dim[input0_par]
@@ -355,24 +360,27 @@ NKICustomOPTranspileResult
           int accum_fsize = meta2.partition_dim == 0 ? input1.dim[input1_par]
                                                      : input0.dim[input0_par];
 
-          code.e("accum$ = nl.zeros(($, $), dtype=nl.float32, buffer=nl.psum)",
+          code.e(FMT_STR("accum$ = nl.zeros(($, $), dtype=nl.float32, "
+                         "buffer=nl.psum)"),
                  output.guid,
                  accum_psize,
                  accum_fsize);
 
-          code.e("for accidx in range(($ + $ - 1) // $):",
+          code.e(FMT_STR("for accidx in range(($ + $ - 1) // $):"),
                  input0.dim[input0_contr],
                  NeuronArch::pmax,
                  NeuronArch::pmax);
           code.inc_indent();
 
           if (meta2.partition_dim == 0) {
-            code.e("accum$ += nisa.nc_matmul(nl.transpose($), nl.transpose($))",
+            code.e(FMT_STR("accum$ += nisa.nc_matmul(nl.transpose($), "
+                           "nl.transpose($))"),
                    output.guid,
                    op0,
                    op1);
           } else {
-            code.e("accum$ += nisa.nc_matmul(nl.transpose($), nl.transpose($))",
+            code.e(FMT_STR("accum$ += nisa.nc_matmul(nl.transpose($), "
+                           "nl.transpose($))"),
                    output.guid,
                    op1,
                    op0);
@@ -380,7 +388,7 @@ NKICustomOPTranspileResult
           code.dec_indent();
           // emit to copy from psum to sbuf, type cast to fp16
           // todo: we need to check whether output tensor is of fp16 or not.
-          code.e("stensor$ = nl.copy(accum$, dtype=nl.float16)",
+          code.e(FMT_STR("stensor$ = nl.copy(accum$, dtype=nl.float16)"),
                  output.guid,
                  output.guid);
         };
@@ -393,26 +401,26 @@ NKICustomOPTranspileResult
           // Add a nl.transpose if input0's partition dim is not
           // output.num_dims - 1
           if (meta0.partition_dim != output.num_dims - 1) {
-            operand0 = fmt("nl.transpose($)", operand0);
+            operand0 = fmt(FMT_STR("nl.transpose($)"), operand0);
           }
           // Add a nl.transpose if input1's partition dim is not
           // output.num_dims - 2
           if (meta1.partition_dim != output.num_dims - 2) {
-            operand1 = fmt("nl.transpose($)", operand1);
+            operand1 = fmt(FMT_STR("nl.transpose($)"), operand1);
           }
           if (meta2.partition_dim == output.num_dims - 2) {
             // First oprand: input0
             // Second operand: input1
-            code.e("$ = nisa.nc_matmul($, $)",
-                   fmt("stensor$", output.guid),
+            code.e(FMT_STR("$ = nisa.nc_matmul($, $)"),
+                   fmt(FMT_STR("stensor$"), output.guid),
                    operand0,
                    operand1);
           } else {
             // First oprand: input1
             // Second operand: input0
             assert(meta2.partition_dim == output.num_dims - 1);
-            code.e("$ = nisa.nc_matmul($, $)",
-                   fmt("stensor$", output.guid),
+            code.e(FMT_STR("$ = nisa.nc_matmul($, $)"),
+                   fmt(FMT_STR("stensor$"), output.guid),
                    operand1,
                    operand0);
           }
@@ -431,9 +439,9 @@ NKICustomOPTranspileResult
           // to reduce transpose costs
           // Do nothing here
         }
-        code.e("$ += $",
-               fmt("stensor$", output.guid),
-               fmt("stensor$", input.guid));
+        code.e(FMT_STR("$ += $"),
+               fmt(FMT_STR("stensor$"), output.guid),
+               fmt(FMT_STR("stensor$"), input.guid));
         break;
       }
       case type::TB_EXP_OP:
@@ -450,20 +458,20 @@ NKICustomOPTranspileResult
         if (tb_op->op_type == type::TB_MUL_SCALAR_OP) {
           tb::TBElementUnaryOp *unary =
               static_cast<tb::TBElementUnaryOp *>(tb_op);
-          optional_second_operand = fmt(", $", unary->scalar);
+          optional_second_operand = fmt(FMT_STR(", $"), unary->scalar);
         }
         if (meta0.partition_dim != meta1.partition_dim) {
           // Need a transpose before elementwise
-          code.e("$ = $(nl.transpose($)$)",
-                 fmt("stensor$", output.guid),
+          code.e(FMT_STR("$ = $(nl.transpose($)$)"),
+                 fmt(FMT_STR("stensor$"), output.guid),
                  ugraph_tboperator_type_to_nki(tb_op->op_type),
-                 fmt("stensor$", input.guid),
+                 fmt(FMT_STR("stensor$"), input.guid),
                  optional_second_operand);
         } else {
-          code.e("$ = $($$)",
-                 fmt("stensor$", output.guid),
+          code.e(FMT_STR("$ = $($$)"),
+                 fmt(FMT_STR("stensor$"), output.guid),
                  ugraph_tboperator_type_to_nki(tb_op->op_type),
-                 fmt("stensor$", input.guid),
+                 fmt(FMT_STR("stensor$"), input.guid),
                  optional_second_operand);
         }
         break;
@@ -487,13 +495,13 @@ NKICustomOPTranspileResult
         if (meta1.partition_dim != meta2.partition_dim) {
           transpose1 = true;
         }
-        code.e("$ = $($, $)",
-               fmt("stensor$", output.guid),
+        code.e(FMT_STR("$ = $($, $)"),
+               fmt(FMT_STR("stensor$"), output.guid),
                ugraph_tboperator_type_to_nki(tb_op->op_type),
-               transpose0 ? fmt("nl.transpose(stensor$)", input0.guid)
-                          : fmt("stensor$", input0.guid),
-               transpose1 ? fmt("nl.transpose(stensor$)", input1.guid)
-                          : fmt("stensor$", input1.guid));
+               transpose0 ? fmt(FMT_STR("nl.transpose(stensor$)"), input0.guid)
+                          : fmt(FMT_STR("stensor$"), input0.guid),
+               transpose1 ? fmt(FMT_STR("nl.transpose(stensor$)"), input1.guid)
+                          : fmt(FMT_STR("stensor$"), input1.guid));
         break;
       }
       case type::TB_REDUCTION_0_OP:
@@ -513,13 +521,13 @@ NKICustomOPTranspileResult
         assert(input.num_dims == output.num_dims);
         assert(0 <= reduc_dim && reduc_dim < num_dims);
         if (reduc_dim == num_dims - 2) {
-          code.e("$ = nl.sum($, axis=0, keepdims=True)",
-                 fmt("stensor$", output.guid),
-                 fmt("stensor$", input.guid));
+          code.e(FMT_STR("$ = nl.sum($, axis=0, keepdims=True)"),
+                 fmt(FMT_STR("stensor$"), output.guid),
+                 fmt(FMT_STR("stensor$"), input.guid));
         } else if (reduc_dim == num_dims - 1) {
-          code.e("$ = nl.sum($, axis=0, keepdims=True)",
-                 fmt("stensor$", output.guid),
-                 fmt("stensor$", input.guid));
+          code.e(FMT_STR("$ = nl.sum($, axis=0, keepdims=True)"),
+                 fmt(FMT_STR("stensor$"), output.guid),
+                 fmt(FMT_STR("stensor$"), input.guid));
         } else {
           assert(false && "Unsupported reduc_dim");
         }
@@ -542,9 +550,9 @@ NKICustomOPTranspileResult
       STensorMeta meta0 = stensor_metas.at(input.guid);
       STensorMeta meta1 = stensor_metas.at(output.guid);
       if (meta0.partition_dim != meta1.partition_dim) {
-        code.e("$ = nl.transpose($)",
-               fmt("stensor$", output.guid),
-               fmt("stensor$", output.guid));
+        code.e(FMT_STR("$ = nl.transpose($)"),
+               fmt(FMT_STR("stensor$"), output.guid),
+               fmt(FMT_STR("stensor$"), output.guid));
       }
     }
   }
@@ -583,23 +591,25 @@ NKICustomOPTranspileResult
         for (int i = 0; i < stensor.num_dims; i++) {
           std::string index;
           if (omap.x == i) {
-            index = fmt("nl.program_id(0) * $", stensor.dim[i]);
+            index = fmt(FMT_STR("nl.program_id(0) * $"), stensor.dim[i]);
           } else if (omap.y == i) {
-            index = fmt("nl.program_id(1) * $", stensor.dim[i]);
+            index = fmt(FMT_STR("nl.program_id(1) * $"), stensor.dim[i]);
           } else if (omap.z == i) {
-            index = fmt("nl.program_id(2) * $", stensor.dim[i]);
+            index = fmt(FMT_STR("nl.program_id(2) * $"), stensor.dim[i]);
           }
           if (i == stensor.num_dims - 2) {
             if (index == "") {
-              index = fmt("nl.arange($)[:, None]", stensor.dim[i]);
+              index = fmt(FMT_STR("nl.arange($)[:, None]"), stensor.dim[i]);
             } else {
-              index = index + fmt(" + nl.arange($)[:, None]", stensor.dim[i]);
+              index = index +
+                      fmt(FMT_STR(" + nl.arange($)[:, None]"), stensor.dim[i]);
             }
           } else if (i == stensor.num_dims - 1) {
             if (index == "") {
-              index = fmt("nl.arange($)[None, :]", stensor.dim[i]);
+              index = fmt(FMT_STR("nl.arange($)[None, :]"), stensor.dim[i]);
             } else {
-              index = index + fmt(" + nl.arange($)[None, :]", stensor.dim[i]);
+              index = index +
+                      fmt(FMT_STR(" + nl.arange($)[None, :]"), stensor.dim[i]);
             }
           }
           if (index == "") {
@@ -610,11 +620,12 @@ NKICustomOPTranspileResult
             range += ", ";
           }
         }
-        code.e("nl.store($[$], $)",
-               fmt("dtensor$", dtensor.guid),
+        code.e(FMT_STR("nl.store($[$], $)"),
+               fmt(FMT_STR("dtensor$"), dtensor.guid),
                range,
-               need_transpose ? fmt("nl.transpose(stensor$)", stensor.guid)
-                              : fmt("stensor$", stensor.guid));
+               need_transpose
+                   ? fmt(FMT_STR("nl.transpose(stensor$)"), stensor.guid)
+                   : fmt(FMT_STR("stensor$"), stensor.guid));
         break;
       }
       case type::TB_EXP_OP:
@@ -633,20 +644,20 @@ NKICustomOPTranspileResult
         if (tb_op->op_type == type::TB_MUL_SCALAR_OP) {
           tb::TBElementUnaryOp *unary =
               static_cast<tb::TBElementUnaryOp *>(tb_op);
-          optional_second_operand = fmt(", $", unary->scalar);
+          optional_second_operand = fmt(FMT_STR(", $"), unary->scalar);
         }
         if (meta0.partition_dim != meta1.partition_dim) {
           // Need a transpose before elementwise
-          code.e("$ = $(nl.transpose($)$)",
-                 fmt("stensor$", output.guid),
+          code.e(FMT_STR("$ = $(nl.transpose($)$)"),
+                 fmt(FMT_STR("stensor$"), output.guid),
                  ugraph_tboperator_type_to_nki(tb_op->op_type),
-                 fmt("stensor$", input.guid),
+                 fmt(FMT_STR("stensor$"), input.guid),
                  optional_second_operand);
         } else {
-          code.e("$ = $($$)",
-                 fmt("stensor$", output.guid),
+          code.e(FMT_STR("$ = $($$)"),
+                 fmt(FMT_STR("stensor$"), output.guid),
                  ugraph_tboperator_type_to_nki(tb_op->op_type),
-                 fmt("stensor$", input.guid),
+                 fmt(FMT_STR("stensor$"), input.guid),
                  optional_second_operand);
         }
         break;
@@ -670,13 +681,13 @@ NKICustomOPTranspileResult
         if (meta1.partition_dim != meta2.partition_dim) {
           transpose1 = true;
         }
-        code.e("$ = $($, $)",
-               fmt("stensor$", output.guid),
+        code.e(FMT_STR("$ = $($, $)"),
+               fmt(FMT_STR("stensor$"), output.guid),
                ugraph_tboperator_type_to_nki(tb_op->op_type),
-               transpose0 ? fmt("nl.transpose(stensor$)", input0.guid)
-                          : fmt("stensor$", input0.guid),
-               transpose1 ? fmt("nl.transpose(stensor$)", input1.guid)
-                          : fmt("stensor$", input1.guid));
+               transpose0 ? fmt(FMT_STR("nl.transpose(stensor$)"), input0.guid)
+                          : fmt(FMT_STR("stensor$"), input0.guid),
+               transpose1 ? fmt(FMT_STR("nl.transpose(stensor$)"), input1.guid)
+                          : fmt(FMT_STR("stensor$"), input1.guid));
         break;
       }
       case type::TB_REDUCTION_0_OP:
@@ -701,9 +712,9 @@ NKICustomOPTranspileResult
         assert(reduc_dim != meta0.partition_dim);
         // reduction is perform on axis=1, since axis=0 maps to
         // the partition dim
-        code.e("$ = nl.sum($, axis=1, keepdims=True)",
-               fmt("stensor$", output.guid),
-               fmt("stensor$", input.guid));
+        code.e(FMT_STR("$ = nl.sum($, axis=1, keepdims=True)"),
+               fmt(FMT_STR("stensor$"), output.guid),
+               fmt(FMT_STR("stensor$"), input.guid));
         break;
       }
       case type::TB_REDUCTION_0_TO_DIMX_OP:
@@ -727,13 +738,14 @@ NKICustomOPTranspileResult
         assert(reduc_dim != meta0.partition_dim);
         // reduction is perform on axis=1, since axis=0 maps to
         // the partition dim
-        code.e("$ = nl.sum($, axis=1, keepdims=True)",
-               fmt("stensor$", output.guid),
-               fmt("stensor$", input.guid));
+        code.e(FMT_STR("$ = nl.sum($, axis=1, keepdims=True)"),
+               fmt(FMT_STR("stensor$"), output.guid),
+               fmt(FMT_STR("stensor$"), input.guid));
         break;
       }
       default: {
-        assert(false && fmt("Unsupported op_type:$", tb_op->op_type).c_str());
+        assert(false &&
+               fmt(FMT_STR("Unsupported op_type:$"), tb_op->op_type).c_str());
       }
     }
   }
@@ -752,7 +764,7 @@ std::optional<NKICustomOPTranspileResult>
   // Transpile add,mul,div operators
   static int nki_block_kernel_counter = 0;
   int cur_block_kernel_idx = nki_block_kernel_counter++;
-  string func_name = fmt("block_kernel_$", cur_block_kernel_idx);
+  string func_name = fmt(FMT_STR("block_kernel_$"), cur_block_kernel_idx);
 
   // partition size 0th axis - 128, 1th axis 512
   // ToDo: handle dimensions greater than 2
@@ -764,23 +776,24 @@ std::optional<NKICustomOPTranspileResult>
   // generate function signature
   CodeKeeper code;
   code.e("@nki_jit");
-  code.e("def $($, $):",
-         func_name,
-         map<kn::DTensor, string>(op->output_tensors,
-                                  [](kn::DTensor const &dtensor) -> string {
-                                    return fmt("dtensor$", dtensor.guid);
-                                  }),
-         map<kn::DTensor, string>(op->input_tensors,
-                                  [](kn::DTensor const &dtensor) -> string {
-                                    return fmt("dtensor$", dtensor.guid);
-                                  }));
+  code.e(
+      FMT_STR("def $($, $):"),
+      func_name,
+      map<kn::DTensor, string>(op->output_tensors,
+                               [](kn::DTensor const &dtensor) -> string {
+                                 return fmt(FMT_STR("dtensor$"), dtensor.guid);
+                               }),
+      map<kn::DTensor, string>(op->input_tensors,
+                               [](kn::DTensor const &dtensor) -> string {
+                                 return fmt(FMT_STR("dtensor$"), dtensor.guid);
+                               }));
   code.inc_indent();
 
   auto emit_affineloops = [&]() {
     for (int i = 0; i < num_dims; i++) {
-      code.e("for $ in nl.affine_range(($.shape[$] + $ - 1) // $):",
+      code.e(FMT_STR("for $ in nl.affine_range(($.shape[$] + $ - 1) // $):"),
              axis_span[i].first[0],
-             fmt("dtensor$", inputs[0].guid),
+             fmt(FMT_STR("dtensor$"), inputs[0].guid),
              i,
              axis_span[i].second,
              axis_span[i].second);
@@ -792,7 +805,7 @@ std::optional<NKICustomOPTranspileResult>
   // emit compute indices
   auto emit_indices = [&]() {
     for (int i = 0; i < num_dims; i++) {
-      code.e("$ = $ * $ + nl.arange($)[$, $]",
+      code.e(FMT_STR("$ = $ * $ + nl.arange($)[$, $]"),
              axis_span[i].first,
              axis_span[i].first[0],
              axis_span[i].second,
@@ -806,28 +819,28 @@ std::optional<NKICustomOPTranspileResult>
   // generate mask
   std::string mask;
   for (int i = 0; i < num_dims; i++) {
-    mask += fmt("($ < $.shape[$])",
+    mask += fmt(FMT_STR("($ < $.shape[$])"),
                 axis_span[i].first,
-                fmt("dtensor$", inputs[0].guid),
+                fmt(FMT_STR("dtensor$"), inputs[0].guid),
                 i);
     if (i != num_dims - 1) {
       mask += " & ";
     }
   }
-  code.e("mask_ = ($)", mask);
+  code.e(FMT_STR("mask_ = ($)"), mask);
 
   auto emit_load = [&](kn::DTensor const &tensor, std::string const &mk) {
     if (num_dims == 2) {
-      code.e("$_tile = nl.load($[$, $], mask = $)",
-             fmt("dtensor$", tensor.guid),
-             fmt("dtensor$", tensor.guid),
+      code.e(FMT_STR("$_tile = nl.load($[$, $], mask = $)"),
+             fmt(FMT_STR("dtensor$"), tensor.guid),
+             fmt(FMT_STR("dtensor$"), tensor.guid),
              axis_span[0].first,
              axis_span[1].first,
              mk);
     } else {
-      code.e("$_tile = nl.load($[$], mask = $)",
-             fmt("dtensor$", tensor.guid),
-             fmt("dtensor$", tensor.guid),
+      code.e(FMT_STR("$_tile = nl.load($[$], mask = $)"),
+             fmt(FMT_STR("dtensor$"), tensor.guid),
+             fmt(FMT_STR("dtensor$"), tensor.guid),
              axis_span[0].first,
              mk);
     }
@@ -836,24 +849,24 @@ std::optional<NKICustomOPTranspileResult>
   emit_load(inputs[1], "mask_");
 
   // compute
-  code.e("result_tile = $($, $)",
+  code.e(FMT_STR("result_tile = $($, $)"),
          ugraph_knoperator_type_to_nki(binary_op->op_type),
-         fmt("dtensor$_tile", inputs[0].guid),
-         fmt("dtensor$_tile", inputs[1].guid));
+         fmt(FMT_STR("dtensor$_tile"), inputs[0].guid),
+         fmt(FMT_STR("dtensor$_tile"), inputs[1].guid));
 
   auto emit_store = [&](kn::DTensor const &tensor,
                         std::string const &tile,
                         std::string const &mk) {
     if (num_dims == 2) {
-      code.e("nl.store($[$, $], value = $, mask = $)",
-             fmt("dtensor$", tensor.guid),
+      code.e(FMT_STR("nl.store($[$, $], value = $, mask = $)"),
+             fmt(FMT_STR("dtensor$"), tensor.guid),
              axis_span[0].first,
              axis_span[1].first,
              tile,
              mk);
     } else {
-      code.e("nl.store($[$], value = $, mask = $)",
-             fmt("dtensor$", tensor.guid),
+      code.e(FMT_STR("nl.store($[$], value = $, mask = $)"),
+             fmt(FMT_STR("dtensor$"), tensor.guid),
              axis_span[0].first,
              tile,
              mk);
@@ -5,23 +5,49 @@
 namespace mirage {
 namespace search {
 
-void abstract_expr_eval(
-    threadblock::Graph const &g,
-    std::unordered_map<int64_t, std::shared_ptr<AbstractExpr>> &patterns) {
-  for (size_t i = 0; i < g.operators.size(); ++i) {
+bool PatternMap::contains(int64_t guid) const {
+  return contains_key(patterns, guid);
+}
+
+std::shared_ptr<AbstractExpr> const &PatternMap::at(int64_t guid) const {
+  return patterns.at(guid);
+}
+
+void PatternMap::insert(int64_t guid,
+                        std::shared_ptr<AbstractExpr> const &pattern) {
+  if (patterns.insert({guid, pattern}).second) {
+    inserted_guids.push_back(guid);
+  }
+}
+
+size_t PatternMap::checkpoint() const {
+  return inserted_guids.size();
+}
+
+void PatternMap::rollback(size_t checkpoint) {
+  assert(checkpoint <= inserted_guids.size());
+  while (inserted_guids.size() > checkpoint) {
+    patterns.erase(inserted_guids.back());
+    inserted_guids.pop_back();
+  }
+}
+
+void abstract_expr_eval(threadblock::Graph const &g,
+                        PatternMap &patterns,
+                        size_t first_op) {
+  for (size_t i = first_op; i < g.operators.size(); ++i) {
     auto const &op = g.operators[i];
     if (op->output_tensors.size() > 0 &&
-        contains_key(patterns, op->output_tensors[0].guid)) {
+        patterns.contains(op->output_tensors[0].guid)) {
       continue;
     }
     if (op->op_type == type::TBOperatorType::TB_INPUT_OP) {
       patterns.insert(
-          {op->output_tensors[0].guid,
-           patterns.at(
-               static_cast<threadblock::TBInputOp *>(op)->dtensor.guid)});
+          op->output_tensors[0].guid,
+          patterns.at(static_cast<threadblock::TBInputOp *>(op)->dtensor.guid));
     } else if (op->op_type == type::TBOperatorType::TB_OUTPUT_OP) {
-      patterns.insert({static_cast<threadblock::TBOutputOp *>(op)->dtensor.guid,
-                       patterns.at(op->input_tensors[0].guid)});
+      patterns.insert(static_cast<threadblock::TBOutputOp *>(op)->dtensor.guid,
+                      patterns.at(op->input_tensors[0].guid));
     } else if (op->op_type == type::TBOperatorType::TB_CONCAT_1_OP) {
       assert(g.operators[i + 1]->op_type ==
              type::TBOperatorType::TB_CONCAT_0_OP);
@@ -33,38 +59,49 @@ void abstract_expr_eval(
       input_tensors.push_back(g.operators[i + 1]->input_tensors[1]);
       std::vector<std::shared_ptr<AbstractExpr>> input_patterns;
       for (auto const &input_tensor : input_tensors) {
-        assert(contains_key(patterns, input_tensor.guid));
+        assert(patterns.contains(input_tensor.guid));
         input_patterns.push_back(patterns.at(input_tensor.guid));
       }
-      patterns.insert({op->output_tensors[0].guid, nullptr});
-      patterns.insert({g.operators[i + 1]->output_tensors[0].guid, nullptr});
+      patterns.insert(op->output_tensors[0].guid, nullptr);
+      patterns.insert(g.operators[i + 1]->output_tensors[0].guid, nullptr);
       patterns.insert(
-          {g.operators[i + 2]->output_tensors[0].guid,
-           get_pattern(type::TBOperatorType::TB_CONCAT_THEN_MATMUL_OP,
-                       input_tensors,
-                       input_patterns)});
+          g.operators[i + 2]->output_tensors[0].guid,
+          get_pattern(type::TBOperatorType::TB_CONCAT_THEN_MATMUL_OP,
+                      input_tensors,
+                      input_patterns));
     } else {
       std::vector<std::shared_ptr<AbstractExpr>> input_patterns;
       for (auto const &input_tensor : op->input_tensors) {
         input_patterns.push_back(patterns.at(input_tensor.guid));
       }
       patterns.insert(
-          {op->output_tensors[0].guid,
-           get_pattern(op->op_type, op->input_tensors, input_patterns)});
+          op->output_tensors[0].guid,
+          get_pattern(op->op_type, op->input_tensors, input_patterns));
     }
   }
 }
 
-void abstract_expr_eval(
-    kernel::Graph const &g,
-    std::unordered_map<int64_t, std::shared_ptr<AbstractExpr>> &patterns) {
-  int input_id = 0;
-  for (auto const &op : g.operators) {
+void abstract_expr_eval(kernel::Graph const &g,
+                        PatternMap &patterns,
+                        size_t first_op) {
+  // Inputs are named by their position among all input operators, so only
+  // count the ones before first_op when an input is actually evaluated
+  int input_id = -1;
+  for (size_t i = first_op; i < g.operators.size(); ++i) {
+    auto const &op = g.operators[i];
     if (op->op_type == type::KNOperatorType::KN_OUTPUT_OP) {
       continue;
     } else if (op->op_type == type::KNOperatorType::KN_INPUT_OP) {
-      patterns.insert({op->output_tensors[0].guid,
-                       std::make_shared<Var>("v_" + std::to_string(input_id))});
+      if (input_id < 0) {
+        input_id = 0;
+        for (size_t k = 0; k < i; ++k) {
+          if (g.operators[k]->op_type == type::KNOperatorType::KN_INPUT_OP) {
+            input_id++;
+          }
+        }
+      }
+      patterns.insert(op->output_tensors[0].guid,
+                      std::make_shared<Var>("v_" + std::to_string(input_id)));
       input_id++;
     } else if (op->op_type == type::KNOperatorType::KN_RMS_NORM_OP) {
       std::shared_ptr<AbstractExpr> input_pattern =
@@ -74,16 +111,16 @@ void abstract_expr_eval(
           input_pattern);
       std::shared_ptr<AbstractExpr> output_pattern =
           std::make_shared<Div>(input_pattern, denominator_pattern);
-      patterns.insert({op->output_tensors[0].guid, output_pattern});
+      patterns.insert(op->output_tensors[0].guid, output_pattern);
     } else if (op->op_type != type::KNOperatorType::KN_CUSTOMIZED_OP) {
       std::vector<std::shared_ptr<AbstractExpr>> input_patterns;
       for (auto const &input_tensor : op->input_tensors) {
-        assert(contains_key(patterns, input_tensor.guid));
+        assert(patterns.contains(input_tensor.guid));
         input_patterns.push_back(patterns.at(input_tensor.guid));
       }
       patterns.insert(
-          {op->output_tensors[0].guid,
-           get_pattern(op->op_type, op->input_tensors, input_patterns)});
+          op->output_tensors[0].guid,
+          get_pattern(op->op_type, op->input_tensors, input_patterns));
     } else {
       assert(op->op_type == type::KNOperatorType::KN_CUSTOMIZED_OP);
       abstract_expr_eval(static_cast<kernel::KNCustomizedOp *>(op)->bgraph,
@@ -63,6 +63,8 @@ GeneratorConfig GeneratorConfig::get_default_config() {
       false /* enable_attention_specific_optimization */,
       false /* enable_concat_matmul_transformation */,
       false /* randomized_branches */,
+      true /* enable_sampled_fingerprint */,
+      true /* enable_tb_graph_memo */,
   };
 }
 
@@ -87,6 +89,10 @@ void GeneratorConfig::show() const {
   printf("  max num threadblock graph outputs: %zu\n",
          max_num_threadblock_graph_outputs);
   printf("  search_thread: %zu\n", search_thread);
+  printf("  sampled fingerprint: %s\n",
+         enable_sampled_fingerprint ? "enabled" : "disabled");
+  printf("  threadblock graph memo: %s\n",
+         enable_tb_graph_memo ? "enabled" : "disabled");
   printf("  imaps to explore:\n");
   for (auto const &imap : imap_to_explore) {
     printf("    (%d, %d, %d)\n", imap.x, imap.y, imap.z);
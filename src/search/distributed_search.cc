@@ -0,0 +1,328 @@
+#include "mirage/search/search.h"
+#include "mirage/utils/json_utils.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+// A search spool is a directory shared by one coordinator and any number of
+// worker processes, on one host or on hosts sharing the filesystem:
+//   job.json                  computation graph and generator config
+//   patterns.json             pattern cache merged by the coordinator
+//   pending/<unit>.json       work units not claimed by any worker
+//   running/<unit>.<w>.json   units claimed by worker w; the file's mtime
+//                             is the worker's heartbeat
+//   done/<unit>.<w>.json      muGraphs and pattern cache found by worker w
+//   finished                  written once all units have been merged
+// Workers claim units by renaming them from pending/ to running/, which is
+// atomic within a filesystem, and all other files are written to a
+// temporary name first and renamed into place.
+
+namespace mirage {
+namespace search {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Clock = fs::file_time_type::clock;
+
+std::string get_worker_id() {
+  char hostname[256];
+  if (gethostname(hostname, sizeof(hostname)) != 0) {
+    hostname[0] = '\0';
+  }
+  hostname[sizeof(hostname) - 1] = '\0';
+  return std::string(hostname) + "-" + std::to_string(getpid());
+}
+
+std::string get_unit_name(size_t unit_id) {
+  char name[32];
+  snprintf(name, sizeof(name), "unit_%06zu", unit_id);
+  return std::string(name);
+}
+
+// Unit names contain no '.', so the unit is everything before the first one
+std::string get_unit_name(fs::path const &path) {
+  std::string filename = path.filename().string();
+  return filename.substr(0, filename.find('.'));
+}
+
+std::string get_worker_id(fs::path const &path) {
+  std::string stem = path.stem().string();
+  return stem.substr(std::min(stem.size(), stem.find('.') + 1));
+}
+
+bool is_json_file(fs::directory_entry const &entry) {
+  return entry.is_regular_file() && entry.path().extension() == ".json";
+}
+
+void write_json(fs::path const &path, json const &j) {
+  fs::path tmp_path = path;
+  tmp_path += "." + get_worker_id() + ".tmp";
+  {
+    std::ofstream ofs(tmp_path);
+    ofs << j;
+  }
+  fs::rename(tmp_path, path);
+}
+
+// Returns false if the file vanished or has not been written completely,
+// both of which are expected while other processes move files around
+bool read_json(fs::path const &path, json &j) {
+  std::ifstream ifs(path);
+  if (!ifs) {
+    return false;
+  }
+  try {
+    ifs >> j;
+  } catch (json::exception const &) {
+    return false;
+  }
+  return true;
+}
+
+std::vector<fs::path> list_json_files(fs::path const &dir) {
+  std::vector<fs::path> paths;
+  std::error_code ec;
+  for (auto const &entry : fs::directory_iterator(dir, ec)) {
+    if (is_json_file(entry)) {
+      paths.push_back(entry.path());
+    }
+  }
+  return paths;
+}
+
+void merge_patterns(std::unordered_map<std::string, bool> &seen_patterns,
+                    json const &j) {
+  for (auto const &[pattern, valid] : j.items()) {
+    seen_patterns.emplace(pattern, valid.get<bool>());
+  }
+}
+
+} // namespace
+
+void KernelGraphGenerator::generate_kernel_graphs_distributed(
+    char const *spool_dir, size_t _split_depth, int heartbeat_timeout_sec) {
+  assert(_split_depth > 0);
+  start_time = std::chrono::steady_clock::now();
+  fs::path spool(spool_dir);
+  fs::create_directories(spool / "pending");
+  fs::create_directories(spool / "running");
+  fs::create_directories(spool / "done");
+  fs::remove(spool / "finished");
+
+  // Enumerate the work units serially: contexts at split_depth are
+  // collected, and shallower contexts are verified by the coordinator
+  std::vector<SerializedSearchContext> units;
+  {
+    SearchContext c = get_initial_context();
+    size_t saved_max_depth = max_depth;
+    max_depth = 0;
+    work_units = &units;
+    split_depth = _split_depth;
+    search_from(c);
+    work_units = nullptr;
+    max_depth = saved_max_depth;
+  }
+  printf("[Search] Distributing %zu work units through %s\n",
+         units.size(),
+         spool_dir);
+
+  json job = {{"graph", computation_graph_json},
+              {"config", config},
+              {"verifier_type", config.verifier_type},
+              {"randomized_branches", config.randomized_branches}};
+  write_json(spool / "patterns.json", json(seen_patterns));
+  for (size_t i = 0; i < units.size(); ++i) {
+    write_json(spool / "pending" / (get_unit_name(i) + ".json"),
+               json(units[i]));
+  }
+  // Workers wait for job.json, so write it after all units are pending
+  write_json(spool / "job.json", job);
+
+  std::unordered_set<std::string> merged_units;
+  while (merged_units.size() < units.size() && !stop_requested) {
+    bool new_patterns = false;
+    for (fs::path const &path : list_json_files(spool / "done")) {
+      json result;
+      if (!read_json(path, result)) {
+        continue;
+      }
+      std::string unit = get_unit_name(path);
+      // A re-queued unit may be reported by more than one worker
+      if (merged_units.count(unit) == 0) {
+        for (json const &graph : result.at("graphs")) {
+          generated_graphs.push_back(graph);
+          if (result_queue) {
+            result_queue->push(graph);
+          }
+        }
+        merge_patterns(seen_patterns, result.at("patterns"));
+        num_total_states += result.at("num_total_states").get<int>();
+        num_total_random_tests +=
+            result.at("num_total_random_tests").get<int>();
+        num_valid_kernel_graphs +=
+            result.at("num_valid_kernel_graphs").get<int>();
+        merged_units.insert(unit);
+        new_patterns = true;
+      }
+      // Reported metrics are cumulative over all units of the worker
+      metrics.set_remote(get_worker_id(path),
+                         result.at("metrics").get<SearchMetricsSnapshot>());
+      fs::remove(path);
+    }
+    if (new_patterns) {
+      write_json(spool / "patterns.json", json(seen_patterns));
+      save_results();
+    }
+
+    auto now = Clock::now();
+    for (fs::path const &path : list_json_files(spool / "running")) {
+      std::error_code ec;
+      auto last_heartbeat = fs::last_write_time(path, ec);
+      if (ec ||
+          now - last_heartbeat < std::chrono::seconds(heartbeat_timeout_sec)) {
+        continue;
+      }
+      std::string unit = get_unit_name(path);
+      if (merged_units.count(unit) > 0) {
+        fs::remove(path, ec);
+      } else {
+        printf("\n[Search] Re-queuing %s from %s\n",
+               unit.c_str(),
+               path.filename().c_str());
+        fs::rename(path, spool / "pending" / (unit + ".json"), ec);
+      }
+    }
+
+    printf("[Search] Work units merged: %zu/%zu, States: %d, Valid mugraphs: "
+           "%d, Time: %lf\r",
+           merged_units.size(),
+           units.size(),
+           num_total_states.load(),
+           num_valid_kernel_graphs.load(),
+           get_elapsed_time_in_sec());
+    fflush(stdout);
+    export_metrics(false /*force*/);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  }
+  // Also tells the workers to give up their units after a stop
+  std::ofstream(spool / "finished").close();
+
+  if (stop_requested) {
+    // Drop the partial results saved while merging, so that they are not
+    // loaded as the checkpoint of a complete search
+    std::error_code ec;
+    fs::remove(filename, ec);
+  } else {
+    save_results();
+  }
+  export_metrics(true /*force*/);
+
+  printf("\n");
+  printf("[Search] Distributed search finished. Time elapsed: %fsec\n",
+         get_elapsed_time_in_sec());
+  printf("[Search] Total states explored: %d\n", num_total_states.load());
+  printf("[Search] Random tests performed: %d\n",
+         num_total_random_tests.load());
+  printf("[Serach] Valid kernel graphs explored: %d\n",
+         num_valid_kernel_graphs.load());
+}
+
+size_t KernelGraphGenerator::process_work_units(char const *spool_dir) {
+  start_time = std::chrono::steady_clock::now();
+  fs::path spool(spool_dir);
+  std::string worker_id = get_worker_id();
+  size_t num_units = 0;
+
+  while (true) {
+    // Units may still be pending when the coordinator stopped early
+    if (fs::exists(spool / "finished")) {
+      break;
+    }
+    // Claim any pending unit
+    fs::path running_path;
+    std::string unit;
+    for (fs::path const &path : list_json_files(spool / "pending")) {
+      unit = get_unit_name(path);
+      fs::path claimed = spool / "running" / (unit + "." + worker_id + ".json");
+      std::error_code ec;
+      fs::rename(path, claimed, ec);
+      if (!ec) {
+        // The rename keeps the mtime of the pending file, which may already
+        // be older than the heartbeat timeout
+        fs::last_write_time(claimed, Clock::now(), ec);
+        running_path = claimed;
+        break;
+      }
+    }
+    if (running_path.empty()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+      continue;
+    }
+
+    json unit_json, patterns;
+    if (!read_json(running_path, unit_json)) {
+      // Re-queued by the coordinator in the meantime
+      continue;
+    }
+    if (read_json(spool / "patterns.json", patterns)) {
+      merge_patterns(seen_patterns, patterns);
+    }
+    generated_graphs.clear();
+    int states = num_total_states, random_tests = num_total_random_tests,
+        valid_graphs = num_valid_kernel_graphs;
+
+    std::atomic<bool> unit_done(false);
+    std::thread heartbeat([&] {
+      while (!unit_done) {
+        std::error_code ec;
+        fs::last_write_time(running_path, Clock::now(), ec);
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+      }
+    });
+    SearchContext c = SerializedSearchContext(unit_json).deserialize();
+    search_from(c);
+    unit_done = true;
+    heartbeat.join();
+
+    json result = {
+        {"graphs", generated_graphs},
+        {"patterns", seen_patterns},
+        {"num_total_states", num_total_states - states},
+        {"num_total_random_tests", num_total_random_tests - random_tests},
+        {"num_valid_kernel_graphs", num_valid_kernel_graphs - valid_graphs},
+        {"metrics", metrics.snapshot()}};
+    write_json(spool / "done" / (unit + "." + worker_id + ".json"), result);
+    std::error_code ec;
+    fs::remove(running_path, ec);
+    ++num_units;
+  }
+  return num_units;
+}
+
+size_t run_search_worker(char const *spool_dir) {
+  fs::path spool(spool_dir);
+  json job;
+  while (!read_json(spool / "job.json", job)) {
+    if (fs::exists(spool / "finished")) {
+      return 0;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  }
+  kernel::Graph computation_graph;
+  from_json(job.at("graph"), computation_graph);
+  GeneratorConfig config = GeneratorConfig::get_default_config();
+  from_json(job.at("config"), config);
+  job.at("verifier_type").get_to(config.verifier_type);
+  job.at("randomized_branches").get_to(config.randomized_branches);
+  // Results are reported through the spool instead of a checkpoint file
+  KernelGraphGenerator gen(computation_graph, config, nullptr);
+  return gen.process_work_units(spool_dir);
+}
+
+} // namespace search
+} // namespace mirage
@@ -22,8 +22,10 @@ KernelGraphGenerator::KernelGraphGenerator(
     char const *filename,
     bool verbose)
     : config(config), dim_strategy(DimStrategy(config)), filename(filename),
-      verbose(verbose), num_total_random_tests(0), num_valid_kernel_graphs(0),
-      num_total_states(0), num_tasks(0), max_depth(5) {
+      verbose(verbose), metrics_interval_sec(10), num_total_random_tests(0),
+      num_valid_kernel_graphs(0), num_total_states(0), stop_requested(false),
+      paused(false), num_verifying(0), num_tasks(0), max_depth(5),
+      work_units(nullptr), split_depth(0) {
   // setting num_thread
   unsigned int max_num_threads = std::thread::hardware_concurrency();
   if (config.search_thread > max_num_threads) {
@@ -50,11 +52,11 @@ std::vector<typename GraphType::TensorType>
   return tensors;
 }
 
-template <typename GraphType>
-std::vector<typename GraphType::TensorType>
-    get_tensors_from_idx(GraphType const &g, std::vector<int> idx) {
-  std::vector<typename GraphType::TensorType> tensors,
-      all_tensors = get_all_tensors(g);
+template <typename TensorType>
+std::vector<TensorType>
+    get_tensors_from_idx(std::vector<TensorType> const &all_tensors,
+                         std::vector<int> const &idx) {
+  std::vector<TensorType> tensors;
   for (auto i : idx) {
     tensors.push_back(all_tensors[i]);
   }
@@ -63,15 +65,10 @@ std::vector<typename GraphType::TensorType>
 
 template <typename GraphType>
 Order get_max_op_order(GraphType const &g) {
-  std::vector<typename GraphType::TensorType> all_tensors = get_all_tensors(g);
-  std::unordered_map<int, int> guid2index;
-  for (size_t i = 0; i < all_tensors.size(); ++i) {
-    guid2index[all_tensors[i].guid] = i;
-  }
-  std::vector<int> input_idx;
-  for (auto const &input : g.operators.back()->input_tensors) {
-    assert(contains_key(guid2index, input.guid));
-    input_idx.push_back(guid2index.at(input.guid));
+  std::vector<int> const &input_idx =
+      g.use_def.get_input_indices(g.operators.size() - 1);
+  for (int idx : input_idx) {
+    assert(idx >= 0);
   }
   return Order(input_idx, static_cast<int>(g.operators.back()->op_type));
 }
@@ -101,25 +98,98 @@ std::vector<typename GraphType::TensorType>
   return output_tensors;
 }
 
+// Everything a threadblock-level search started by Case K3 depends on
+std::string get_tb_graph_memo_key(threadblock::Graph const &g,
+                                  PatternMap const &patterns) {
+  json inputs = json::array();
+  for (auto const &op : g.operators) {
+    if (op->op_type == type::TBOperatorType::TB_INPUT_OP) {
+      threadblock::TBInputOp const *input_op =
+          static_cast<threadblock::TBInputOp const *>(op);
+      DTensor const &dtensor = input_op->dtensor;
+      std::shared_ptr<AbstractExpr> pattern = patterns.at(dtensor.guid);
+      inputs.push_back(
+          {std::vector<int>(dtensor.dim, dtensor.dim + dtensor.num_dims),
+           dtensor.data_type,
+           dtensor.layout,
+           pattern ? pattern->to_string() : "",
+           input_op->input_map,
+           input_op->forloop_dim});
+    }
+  }
+  return json({inputs, g.grid_dim, g.block_dim, g.forloop_range}).dump();
+}
+
+SearchContext KernelGraphGenerator::clone_context(SearchContext const &c) {
+  SearchMetrics::StageTimer timer(metrics, SearchStage::CLONE_CONTEXT);
+  SearchContext c_new = SerializedSearchContext(c).deserialize();
+  c_new.tb_graph_recorder = c.tb_graph_recorder;
+  c_new.tb_graph_ops = c.tb_graph_ops;
+  return c_new;
+}
+
+bool KernelGraphGenerator::check_kernel_ranges(kernel::Graph const &g) {
+  SearchMetrics::StageTimer timer(metrics, SearchStage::CHECK_RANGE);
+  return check_range(init_ranges, target_ranges, g);
+}
+
+template <typename GraphType>
+void KernelGraphGenerator::eval_new_patterns(GraphType const &g,
+                                             PatternMap &patterns,
+                                             size_t first_op) {
+  SearchMetrics::StageTimer timer(metrics, SearchStage::PATTERN_EVAL);
+  abstract_expr_eval(g, patterns, first_op);
+}
+
+void KernelGraphGenerator::export_metrics(bool force) {
+  if (metrics_prefix.empty()) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(metrics_export_mutex, std::try_to_lock);
+  if (!lock.owns_lock() && !force) {
+    return;
+  }
+  if (!lock.owns_lock()) {
+    lock.lock();
+  }
+  auto now = std::chrono::steady_clock::now();
+  if (!force && now - last_metrics_export <
+                    std::chrono::duration<double>(metrics_interval_sec)) {
+    return;
+  }
+  last_metrics_export = now;
+  metrics.export_to(metrics_prefix);
+}
+
 void KernelGraphGenerator::generate_next_operator(
     SearchContext &c,
     std::function<bool(SearchContext const &)> const &verify,
     std::vector<SerializedSearchContext> &verified,
     size_t depth) {
+  if (stop_requested) {
+    return;
+  }
+  if (work_units != nullptr && depth == split_depth) {
+    work_units->push_back(SerializedSearchContext(c));
+    return;
+  }
   ++num_total_states;
+  metrics.record_state(depth);
   if (num_total_states % 100 == 1) {
     show_statistics();
+    export_metrics(false /*force*/);
+  }
+  bool is_verified;
+  {
+    SearchMetrics::StageTimer timer(metrics, SearchStage::VERIFY);
+    is_verified = verify(c);
   }
-  if (verify(c)) {
+  if (is_verified) {
     verified.push_back(SerializedSearchContext(c));
     return;
   }
 
-  std::unordered_map<int64_t, std::shared_ptr<AbstractExpr>> algebraic_pattern;
-  abstract_expr_eval(*c.kn_graph, algebraic_pattern);
-  if (c.tb_graph) {
-    abstract_expr_eval(*c.tb_graph, algebraic_pattern);
-  }
+  PatternMap &algebraic_pattern = c.patterns;
   if (c.level == SearchLevel::LV_KERNEL) {
     assert(c.tb_graph == nullptr);
     // Case K1: finish and verify the current graph
@@ -137,10 +207,10 @@ void KernelGraphGenerator::generate_next_operator(
             continue;
           }
           std::vector<DTensor> input_tensors =
-              get_tensors_from_idx(*c.kn_graph, input_idx);
+              get_tensors_from_idx(all_tensors, input_idx);
           std::vector<std::shared_ptr<AbstractExpr>> input_patterns;
           for (auto const &t : input_tensors) {
-            assert(contains_key(algebraic_pattern, t.guid));
+            assert(algebraic_pattern.contains(t.guid));
             input_patterns.push_back(algebraic_pattern.at(t.guid));
           }
           std::shared_ptr<AbstractExpr> pattern =
@@ -149,22 +219,29 @@ void KernelGraphGenerator::generate_next_operator(
             continue;
           }
 
+          auto create_start = std::chrono::steady_clock::now();
           KNOperator *new_op = create_op(*c.kn_graph, op_type, input_tensors);
+          metrics.record_create_op(
+              op_type, get_elapsed_ns(create_start), new_op != nullptr);
 
           if (new_op) {
-            c.kn_graph->operators.push_back(new_op);
-            if (check_range(init_ranges, target_ranges, *c.kn_graph)) {
+            size_t checkpoint = algebraic_pattern.checkpoint();
+            c.kn_graph->add_operator(new_op);
+            eval_new_patterns(*c.kn_graph,
+                              algebraic_pattern,
+                              c.kn_graph->operators.size() - 1);
+            if (check_kernel_ranges(*c.kn_graph)) {
               if (depth < max_depth) {
                 num_tasks++;
-                SearchContext c_tmp = SerializedSearchContext(c).deserialize();
+                SearchContext c_tmp = clone_context(c);
 #pragma omp task
                 { generate_next_operator(c_tmp, verify, verified, depth + 1); }
               } else {
                 generate_next_operator(c, verify, verified, depth + 1);
               }
             }
-            delete c.kn_graph->operators.back();
-            c.kn_graph->operators.pop_back();
+            algebraic_pattern.rollback(checkpoint);
+            delete c.kn_graph->remove_last_operator();
           }
         }
       } else {
@@ -227,24 +304,54 @@ void KernelGraphGenerator::generate_next_operator(
                         input_created = false;
                         break;
                       }
-                      c.tb_graph->operators.push_back(input_op);
+                      c.tb_graph->add_operator(input_op);
                     }
                     if (input_created) {
+                      size_t checkpoint = algebraic_pattern.checkpoint();
+                      eval_new_patterns(*c.tb_graph, algebraic_pattern, 0);
                       c.level = SearchLevel::LV_THREADBLOCK;
 
-                      if (depth < max_depth) {
-                        num_tasks++;
-                        SearchContext c_tmp =
-                            SerializedSearchContext(c).deserialize();
+                      // The coordinator of a distributed search hands
+                      // threadblock-level contexts over to the workers, so
+                      // it never completes their searches
+                      bool use_memo =
+                          config.enable_tb_graph_memo && work_units == nullptr;
+                      std::string memo_key;
+                      std::shared_ptr<TBGraphMemo::Recipes const> recipes;
+                      if (use_memo) {
+                        memo_key = get_tb_graph_memo_key(*c.tb_graph,
+                                                         algebraic_pattern);
+                        recipes = tb_graph_memo.find(memo_key);
+                        metrics.record_cache(SearchCache::TB_GRAPHS,
+                                             recipes != nullptr /*hit*/);
+                      }
+                      if (recipes) {
+                        for (TBGraphRecipe const &recipe : *recipes) {
+                          replay_threadblock_graph(
+                              c, recipe, verify, verified, depth + 1);
+                        }
+                      } else {
+                        if (use_memo) {
+                          c.tb_graph_recorder =
+                              std::make_shared<TBGraphRecorder>(
+                                  tb_graph_memo, memo_key, stop_requested);
+                        }
+                        if (depth < max_depth) {
+                          num_tasks++;
+                          SearchContext c_tmp = clone_context(c);
 #pragma omp task
-                        {
+                          {
+                            generate_next_operator(
+                                c_tmp, verify, verified, depth + 1);
+                          }
+                        } else {
                           generate_next_operator(
-                              c_tmp, verify, verified, depth + 1);
+                              c, verify, verified, depth + 1);
                         }
-                      } else {
-                        generate_next_operator(c, verify, verified, depth + 1);
+                        c.tb_graph_recorder = nullptr;
                       }
                       c.level = SearchLevel::LV_KERNEL;
+                      algebraic_pattern.rollback(checkpoint);
                     }
                     c.tb_graph = nullptr;
                   }
@@ -259,75 +366,10 @@ void KernelGraphGenerator::generate_next_operator(
     // threadblock-level search
     assert(c.tb_graph != nullptr);
 
-    auto create_threadblock_outputs = [&](int3 output_map) {
-      std::vector<STensor> output_tensors;
-      for (auto const &op : c.tb_graph->operators) {
-        for (auto const &tensor : op->output_tensors) {
-          if (get_num_consumers(*c.tb_graph, tensor) == 0) {
-            if (op->op_type == type::TBOperatorType::TB_INPUT_OP) {
-              return false;
-            }
-            if (!tensor.after_accum) {
-              return false;
-            }
-            output_tensors.push_back(tensor);
-          }
-        }
-      }
-
-      if (output_tensors.size() > config.max_num_threadblock_graph_outputs) {
-        return false;
-      }
-
-      for (STensor const &stensor : output_tensors) {
-        assert(stensor.after_accum);
-        assert(contains_key(algebraic_pattern, stensor.guid));
-        TBOperator *new_op =
-            c.tb_graph->create_output_op(stensor,
-                                         output_map,
-                                         -1 /*forloop_dim*/,
-                                         mirage::type::TB_EPILOGUE_NONE);
-        if (!new_op) {
-          return false;
-        }
-        c.tb_graph->operators.push_back(new_op);
-      }
-
-      return true;
-    };
-
     // Case B1. Finish and return to kernel-level search
     for (int3 output_map :
          dim_strategy.get_output_map_cand(c.tb_graph->grid_dim)) {
-      if (create_threadblock_outputs(output_map)) {
-        KNOperator *new_op = c.kn_graph->create_customized_op(
-            get_input_tensors(*c.tb_graph), *c.tb_graph);
-        if (!new_op) {
-          continue;
-        }
-        c.kn_graph->operators.push_back(new_op);
-        c.level = SearchLevel::LV_KERNEL;
-        std::shared_ptr<threadblock::Graph> tb_graph = c.tb_graph;
-        c.tb_graph = nullptr;
-        if (check_range(init_ranges, target_ranges, *c.kn_graph)) {
-          if (depth < max_depth) {
-            num_tasks++;
-            SearchContext c_tmp = SerializedSearchContext(c).deserialize();
-#pragma omp task
-            { generate_next_operator(c_tmp, verify, verified, depth + 1); }
-          } else {
-            generate_next_operator(c, verify, verified, depth + 1);
-          }
-        }
-        c.tb_graph = tb_graph;
-        c.level = SearchLevel::LV_THREADBLOCK;
-        delete c.kn_graph->operators.back();
-        c.kn_graph->operators.pop_back();
-      }
-      while (c.tb_graph->operators.back()->op_type ==
-             type::TBOperatorType::TB_OUTPUT_OP) {
-        c.tb_graph->operators.pop_back();
-      }
+      finish_threadblock_graph(c, output_map, verify, verified, depth);
     }
 
     if (c.tb_graph->operators.size() >= config.max_num_threadblock_graph_op) {
@@ -349,10 +391,10 @@ void KernelGraphGenerator::generate_next_operator(
           continue;
         }
         std::vector<STensor> input_tensors =
-            get_tensors_from_idx(*c.tb_graph, input_idx);
+            get_tensors_from_idx(all_tensors, input_idx);
         std::vector<std::shared_ptr<AbstractExpr>> input_patterns;
         for (auto const &t : input_tensors) {
-          assert(contains_key(algebraic_pattern, t.guid));
+          assert(algebraic_pattern.contains(t.guid));
           input_patterns.push_back(algebraic_pattern.at(t.guid));
         }
         std::shared_ptr<AbstractExpr> pattern =
@@ -362,31 +404,166 @@ void KernelGraphGenerator::generate_next_operator(
         }
 
         TBOperator *last_op = c.tb_graph->operators.back();
+        size_t num_ops = c.tb_graph->operators.size();
+        auto create_start = std::chrono::steady_clock::now();
         TBOperator *new_op = create_op(*c.tb_graph, op_type, input_tensors);
+        metrics.record_create_op(
+            op_type, get_elapsed_ns(create_start), new_op != nullptr);
 
         if (!new_op) {
           continue;
         }
-        c.tb_graph->operators.push_back(new_op);
+        size_t checkpoint = algebraic_pattern.checkpoint();
+        c.tb_graph->add_operator(new_op);
+        eval_new_patterns(*c.tb_graph, algebraic_pattern, num_ops);
+        if (c.tb_graph_recorder) {
+          c.tb_graph_ops.push_back({op_type, input_idx});
+        }
         if (depth < max_depth) {
           num_tasks++;
-          SearchContext c_tmp = SerializedSearchContext(c).deserialize();
+          SearchContext c_tmp = clone_context(c);
 #pragma omp task
           { generate_next_operator(c_tmp, verify, verified, depth + 1); }
         } else {
           generate_next_operator(c, verify, verified, depth + 1);
         }
+        if (c.tb_graph_recorder) {
+          c.tb_graph_ops.pop_back();
+        }
+        algebraic_pattern.rollback(checkpoint);
         while (c.tb_graph->operators.back() != last_op) {
-          delete c.tb_graph->operators.back();
-          c.tb_graph->operators.pop_back();
+          delete c.tb_graph->remove_last_operator();
         }
       }
     }
   }
 }
 
-void KernelGraphGenerator::generate_kernel_graphs() {
-  start_time = std::chrono::steady_clock::now();
+void KernelGraphGenerator::finish_threadblock_graph(
+    SearchContext &c,
+    int3 output_map,
+    std::function<bool(SearchContext const &)> const &verify,
+    std::vector<SerializedSearchContext> &verified,
+    size_t depth) {
+  PatternMap &algebraic_pattern = c.patterns;
+
+  auto create_threadblock_outputs = [&]() {
+    std::vector<STensor> output_tensors;
+    for (auto const &op : c.tb_graph->operators) {
+      for (auto const &tensor : op->output_tensors) {
+        if (get_num_consumers(*c.tb_graph, tensor) == 0) {
+          if (op->op_type == type::TBOperatorType::TB_INPUT_OP) {
+            return false;
+          }
+          if (!tensor.after_accum) {
+            return false;
+          }
+          output_tensors.push_back(tensor);
+        }
+      }
+    }
+
+    if (output_tensors.size() > config.max_num_threadblock_graph_outputs) {
+      return false;
+    }
+
+    for (STensor const &stensor : output_tensors) {
+      assert(stensor.after_accum);
+      assert(algebraic_pattern.contains(stensor.guid));
+      TBOperator *new_op =
+          c.tb_graph->create_output_op(stensor,
+                                       output_map,
+                                       -1 /*forloop_dim*/,
+                                       mirage::type::TB_EPILOGUE_NONE);
+      if (!new_op) {
+        return false;
+      }
+      c.tb_graph->add_operator(new_op);
+    }
+
+    return true;
+  };
+
+  if (create_threadblock_outputs()) {
+    // Whether the customized operator can be created also depends on the
+    // kernel graph, so it is not part of the recipe
+    if (c.tb_graph_recorder) {
+      c.tb_graph_recorder->record({c.tb_graph_ops, output_map});
+    }
+    auto create_start = std::chrono::steady_clock::now();
+    KNOperator *new_op = c.kn_graph->create_customized_op(
+        get_input_tensors(*c.tb_graph), *c.tb_graph);
+    metrics.record_create_op(type::KNOperatorType::KN_CUSTOMIZED_OP,
+                             get_elapsed_ns(create_start),
+                             new_op != nullptr);
+    if (new_op) {
+      size_t checkpoint = algebraic_pattern.checkpoint();
+      c.kn_graph->add_operator(new_op);
+      eval_new_patterns(
+          *c.kn_graph, algebraic_pattern, c.kn_graph->operators.size() - 1);
+      c.level = SearchLevel::LV_KERNEL;
+      std::shared_ptr<threadblock::Graph> tb_graph = c.tb_graph;
+      std::shared_ptr<TBGraphRecorder> tb_graph_recorder = c.tb_graph_recorder;
+      std::vector<TBGraphRecipe::Op> tb_graph_ops;
+      c.tb_graph = nullptr;
+      c.tb_graph_recorder = nullptr;
+      std::swap(c.tb_graph_ops, tb_graph_ops);
+      if (check_kernel_ranges(*c.kn_graph)) {
+        if (depth < max_depth) {
+          num_tasks++;
+          SearchContext c_tmp = clone_context(c);
+#pragma omp task
+          { generate_next_operator(c_tmp, verify, verified, depth + 1); }
+        } else {
+          generate_next_operator(c, verify, verified, depth + 1);
+        }
+      }
+      c.tb_graph = tb_graph;
+      c.tb_graph_recorder = tb_graph_recorder;
+      std::swap(c.tb_graph_ops, tb_graph_ops);
+      c.level = SearchLevel::LV_THREADBLOCK;
+      algebraic_pattern.rollback(checkpoint);
+      delete c.kn_graph->remove_last_operator();
+    }
+  }
+  while (c.tb_graph->operators.back()->op_type ==
+         type::TBOperatorType::TB_OUTPUT_OP) {
+    c.tb_graph->remove_last_operator();
+  }
+}
+
+void KernelGraphGenerator::replay_threadblock_graph(
+    SearchContext &c,
+    TBGraphRecipe const &recipe,
+    std::function<bool(SearchContext const &)> const &verify,
+    std::vector<SerializedSearchContext> &verified,
+    size_t depth) {
+  size_t num_inputs = c.tb_graph->operators.size();
+  bool ops_created = true;
+  for (auto const &[op_type, input_idx] : recipe.ops) {
+    std::vector<STensor> input_tensors =
+        get_tensors_from_idx(get_all_tensors(*c.tb_graph), input_idx);
+    TBOperator *new_op = create_op(*c.tb_graph, op_type, input_tensors);
+    if (!new_op) {
+      ops_created = false;
+      break;
+    }
+    c.tb_graph->add_operator(new_op);
+  }
+  if (ops_created) {
+    size_t checkpoint = c.patterns.checkpoint();
+    eval_new_patterns(*c.tb_graph, c.patterns, num_inputs);
+    // The graph is finished at the depth Case B1 saw it
+    finish_threadblock_graph(
+        c, recipe.output_map, verify, verified, depth + recipe.ops.size());
+    c.patterns.rollback(checkpoint);
+  }
+  while (c.tb_graph->operators.size() > num_inputs) {
+    delete c.tb_graph->remove_last_operator();
+  }
+}
+
+SearchContext KernelGraphGenerator::get_initial_context() const {
   SearchContext c;
   c.level = SearchLevel::LV_KERNEL;
   c.kn_graph = std::make_shared<kernel::Graph>();
@@ -397,10 +574,12 @@ void KernelGraphGenerator::generate_kernel_graphs() {
     // to describe the layout
     c.kn_graph->new_input(dim, strides, data_type, layout);
   }
+  abstract_expr_eval(*c.kn_graph, c.patterns);
+  return c;
+}
 
+void KernelGraphGenerator::search_from(SearchContext &c) {
   std::vector<SerializedSearchContext> verified;
-
-  printf("num_thread = %d\n", num_thread);
 #pragma omp parallel num_threads(num_thread)
   {
 #pragma omp single
@@ -415,10 +594,22 @@ void KernelGraphGenerator::generate_kernel_graphs() {
           0);
     }
   }
+}
+
+void KernelGraphGenerator::generate_kernel_graphs() {
+  start_time = std::chrono::steady_clock::now();
+  SearchContext c = get_initial_context();
+
+  printf("num_thread = %d\n", num_thread);
+  search_from(c);
+  export_metrics(true /*force*/);
 
   printf("num_tasks = %d tasks\n", num_tasks.load());
 
-  save_results();
+  // A stopped search is incomplete and must not be loaded as a checkpoint
+  if (!stop_requested) {
+    save_results();
+  }
 
   printf("\n");
   printf("[Search] Second step finished. Time elapsed: %fsec\n",
@@ -433,6 +624,7 @@ void KernelGraphGenerator::generate_kernel_graphs() {
 }
 
 void KernelGraphGenerator::preprocess(kernel::Graph const &computation_graph) {
+  computation_graph_json = json(computation_graph);
   for (kernel::KNOperator *op : computation_graph.operators) {
     if (op->op_type == type::KNOperatorType::KN_INPUT_OP) {
       computation_graph_input_attrs.push_back(
@@ -443,8 +635,7 @@ void KernelGraphGenerator::preprocess(kernel::Graph const &computation_graph) {
     }
   }
 
-  std::unordered_map<int64_t, std::shared_ptr<AbstractExpr>>
-      computation_graph_patterns;
+  PatternMap computation_graph_patterns;
   abstract_expr_eval(computation_graph, computation_graph_patterns);
 
   init_ranges = get_init_ranges(computation_graph);
@@ -459,7 +650,8 @@ void KernelGraphGenerator::preprocess(kernel::Graph const &computation_graph) {
   }
 
   if (config.verifier_type == VerifierType::PROBABILISTIC_VERIFIER) {
-    this->verifier = std::make_shared<ProbabilisticVerifier>(computation_graph);
+    this->verifier = std::make_shared<ProbabilisticVerifier>(
+        computation_graph, config.enable_sampled_fingerprint);
   } else {
     this->verifier = std::make_shared<FormalVerifier>(computation_graph);
   }
@@ -470,10 +662,13 @@ bool KernelGraphGenerator::check_pattern(
   if (!pattern) {
     return false;
   }
+  SearchMetrics::StageTimer timer(metrics, SearchStage::CHECK_PATTERN);
 
   if (seen_patterns.find(pattern->to_string()) != seen_patterns.end()) {
+    metrics.record_cache(SearchCache::SEEN_PATTERNS, true /*hit*/);
     return seen_patterns[pattern->to_string()];
   }
+  metrics.record_cache(SearchCache::SEEN_PATTERNS, false /*hit*/);
 
   for (auto const &final_pattern : computation_graph_output_patterns) {
     if (pattern->subpattern_to(*final_pattern)) {
@@ -488,13 +683,22 @@ bool KernelGraphGenerator::check_pattern(
   return false;
 }
 
-bool KernelGraphGenerator::verify(kernel::Graph &g) {
+bool KernelGraphGenerator::verify(kernel::Graph &g, bool save) {
   std::vector<DTensor> outputs = get_output_tensors(g);
 
   if (outputs.size() != computation_graph_output_patterns.size()) {
     return false;
   }
 
+  {
+    std::unique_lock<std::mutex> lock(pause_mutex);
+    pause_cv.wait(lock, [&] { return !paused || stop_requested; });
+    if (stop_requested) {
+      return false;
+    }
+    ++num_verifying;
+  }
+
   {
     ++num_total_random_tests;
     auto mark_outputs = [&](OutputMatch const &match) {
@@ -506,22 +710,33 @@ bool KernelGraphGenerator::verify(kernel::Graph &g) {
     auto unmark_outputs = [&]() {
       while (g.operators.back()->op_type ==
              type::KNOperatorType::KN_OUTPUT_OP) {
-        delete g.operators.back();
-        g.operators.pop_back();
+        delete g.remove_last_operator();
       }
     };
 
     auto save_graph = [&]() {
 #pragma omp critical
-      { generated_graphs.push_back(json(g)); }
+      {
+        generated_graphs.push_back(json(g));
+        if (result_queue) {
+          result_queue->push(generated_graphs.back());
+        }
+      }
     };
 
     OutputMatch match = verifier->verify(g);
+    {
+      std::lock_guard<std::mutex> lock(pause_mutex);
+      --num_verifying;
+    }
+    pause_cv.notify_all();
     if (match.is_valid()) {
       ++num_valid_kernel_graphs;
-      mark_outputs(match);
-      save_graph();
-      unmark_outputs();
+      if (save) {
+        mark_outputs(match);
+        save_graph();
+        unmark_outputs();
+      }
       return true;
     }
   }
@@ -529,6 +744,28 @@ bool KernelGraphGenerator::verify(kernel::Graph &g) {
   return false;
 }
 
+void KernelGraphGenerator::request_stop() {
+  {
+    std::lock_guard<std::mutex> lock(pause_mutex);
+    stop_requested = true;
+  }
+  pause_cv.notify_all();
+}
+
+void KernelGraphGenerator::pause() {
+  std::unique_lock<std::mutex> lock(pause_mutex);
+  paused = true;
+  pause_cv.wait(lock, [&] { return num_verifying == 0; });
+}
+
+void KernelGraphGenerator::resume() {
+  {
+    std::lock_guard<std::mutex> lock(pause_mutex);
+    paused = false;
+  }
+  pause_cv.notify_all();
+}
+
 void KernelGraphGenerator::save_results() const {
   std::ofstream ofs(filename);
   ofs << json(generated_graphs);
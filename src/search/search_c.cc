@@ -8,10 +8,94 @@
 
 #include <fstream>
 #include <iostream>
+#include <thread>
 
 namespace mirage {
 namespace search_c {
 
+static std::string last_search_metrics = "{}";
+
+namespace {
+
+search::GeneratorConfig
+    get_generator_config(std::vector<MInt3> const &imap_to_explore,
+                         std::vector<MInt3> const &omap_to_explore,
+                         std::vector<MDim3> const &grid_dim_to_explore,
+                         std::vector<MDim3> const &block_dim_to_explore,
+                         std::vector<int> const &fmap_to_explore,
+                         std::vector<int> const &frange_to_explore,
+                         char const *default_config) {
+  search::GeneratorConfig config =
+      search::GeneratorConfig::get_default_config();
+  if (default_config != nullptr) {
+    if (!strcmp(default_config, "attention")) {
+      config.enable_attention_specific_optimization();
+    } else if (!strcmp(default_config, "lora")) {
+      config.enable_concat_matmul_transformation();
+    } else if (!strcmp(default_config, "mlp")) {
+    }
+  }
+  // Customized imaps
+  if (imap_to_explore.size() > 0) {
+    config.imap_to_explore.clear();
+    for (auto const &imap : imap_to_explore) {
+      config.imap_to_explore.push_back({imap.x, imap.y, imap.z});
+    }
+  }
+  // Customized omaps
+  if (omap_to_explore.size() > 0) {
+    config.omap_to_explore.clear();
+    for (auto const &omap : omap_to_explore) {
+      config.omap_to_explore.push_back({omap.x, omap.y, omap.z});
+    }
+  }
+  // Customized griddims
+  if (grid_dim_to_explore.size() > 0) {
+    config.grid_dim_to_explore.clear();
+    for (auto const &griddim : grid_dim_to_explore) {
+      config.grid_dim_to_explore.push_back({griddim.x, griddim.y, griddim.z});
+    }
+  }
+  // Customized blockdims
+  if (block_dim_to_explore.size() > 0) {
+    config.block_dim_to_explore.clear();
+    for (auto const &blockdim : block_dim_to_explore) {
+      config.block_dim_to_explore.push_back(
+          {blockdim.x, blockdim.y, blockdim.z});
+    }
+  }
+  // Customized fmap
+  if (fmap_to_explore.size() > 0) {
+    config.fmap_to_explore.clear();
+    for (auto const &fmap : fmap_to_explore) {
+      config.fmap_to_explore.push_back(fmap);
+    }
+  }
+  // Customized frange
+  if (frange_to_explore.size() > 0) {
+    config.frange_to_explore.clear();
+    for (auto const &frange : frange_to_explore) {
+      config.frange_to_explore.push_back(frange);
+    }
+  }
+  return config;
+}
+
+// Returns false if filename is not an existing checkpoint
+bool load_checkpoint(char const *filename, json &graphs) {
+  if (filename == nullptr) {
+    return false;
+  }
+  std::ifstream generated_graphs_file(filename, std::ifstream::binary);
+  if (!generated_graphs_file) {
+    return false;
+  }
+  generated_graphs_file >> graphs;
+  return true;
+}
+
+} // namespace
+
 int cython_search(mirage::kernel::Graph const *input_graph,
                   int max_num_graphs,
                   mirage::kernel::Graph **new_graphs,
@@ -23,82 +107,42 @@ int cython_search(mirage::kernel::Graph const *input_graph,
                   std::vector<int> frange_to_explore,
                   char const *filename,
                   bool verbose,
-                  char const *default_config) {
-  if (filename) {
-    std::ifstream generated_graphs_file(filename, std::ifstream::binary);
-    if (generated_graphs_file) {
-      json j;
-      generated_graphs_file >> j;
-      int num = 0;
-      for (json const &graph : j) {
-        assert(num < max_num_graphs);
-        new_graphs[num] = new kernel::Graph();
-        from_json(graph, *new_graphs[num]);
-        num++;
-      }
-      return num;
+                  char const *default_config,
+                  char const *spool_dir,
+                  char const *metrics_prefix) {
+  json j;
+  if (load_checkpoint(filename, j)) {
+    int num = 0;
+    for (json const &graph : j) {
+      assert(num < max_num_graphs);
+      new_graphs[num] = new kernel::Graph();
+      from_json(graph, *new_graphs[num]);
+      num++;
     }
+    return num;
   }
   {
-    search::GeneratorConfig config =
-        search::GeneratorConfig::get_default_config();
-    if (default_config != nullptr) {
-      if (!strcmp(default_config, "attention")) {
-        config.enable_attention_specific_optimization();
-      } else if (!strcmp(default_config, "lora")) {
-        config.enable_concat_matmul_transformation();
-      } else if (!strcmp(default_config, "mlp")) {
-      }
-    }
-    // Customized imaps
-    if (imap_to_explore.size() > 0) {
-      config.imap_to_explore.clear();
-      for (auto const &imap : imap_to_explore) {
-        config.imap_to_explore.push_back({imap.x, imap.y, imap.z});
-      }
-    }
-    // Customized omaps
-    if (omap_to_explore.size() > 0) {
-      config.omap_to_explore.clear();
-      for (auto const &omap : omap_to_explore) {
-        config.omap_to_explore.push_back({omap.x, omap.y, omap.z});
-      }
-    }
-    // Customized griddims
-    if (grid_dim_to_explore.size() > 0) {
-      config.grid_dim_to_explore.clear();
-      for (auto const &griddim : grid_dim_to_explore) {
-        config.grid_dim_to_explore.push_back({griddim.x, griddim.y, griddim.z});
-      }
-    }
-    // Customized blockdims
-    if (block_dim_to_explore.size() > 0) {
-      config.block_dim_to_explore.clear();
-      for (auto const &blockdim : block_dim_to_explore) {
-        config.block_dim_to_explore.push_back(
-            {blockdim.x, blockdim.y, blockdim.z});
-      }
-    }
-    // Customized fmap
-    if (fmap_to_explore.size() > 0) {
-      config.fmap_to_explore.clear();
-      for (auto const &fmap : fmap_to_explore) {
-        config.fmap_to_explore.push_back(fmap);
-      }
-    }
-    // Customized frange
-    if (frange_to_explore.size() > 0) {
-      config.frange_to_explore.clear();
-      for (auto const &frange : frange_to_explore) {
-        config.frange_to_explore.push_back(frange);
-      }
-    }
+    search::GeneratorConfig config = get_generator_config(imap_to_explore,
+                                                          omap_to_explore,
+                                                          grid_dim_to_explore,
+                                                          block_dim_to_explore,
+                                                          fmap_to_explore,
+                                                          frange_to_explore,
+                                                          default_config);
     char const *result_filename =
         filename ? filename : "mirage_search_checkpoint.json";
     search::KernelGraphGenerator gen(
         *input_graph, config, result_filename, verbose);
     gen.config.show();
-    gen.generate_kernel_graphs();
+    if (metrics_prefix) {
+      gen.metrics_prefix = metrics_prefix;
+    }
+    if (spool_dir) {
+      gen.generate_kernel_graphs_distributed(spool_dir);
+    } else {
+      gen.generate_kernel_graphs();
+    }
+    last_search_metrics = json(gen.metrics.snapshot()).dump();
     int num = 0;
     for (json const &j : gen.generated_graphs) {
       assert(num < max_num_graphs);
@@ -110,6 +154,147 @@ int cython_search(mirage::kernel::Graph const *input_graph,
   }
 }
 
+struct StreamingSearch {
+  std::shared_ptr<search::SearchResultQueue> queue;
+  // Null when the muGraphs come from a checkpoint
+  std::unique_ptr<search::KernelGraphGenerator> gen;
+  std::string filename;
+  std::thread thread;
+};
+
+StreamingSearch *cython_start_search(mirage::kernel::Graph const *input_graph,
+                                     std::vector<MInt3> imap_to_explore,
+                                     std::vector<MInt3> omap_to_explore,
+                                     std::vector<MDim3> grid_dim_to_explore,
+                                     std::vector<MDim3> block_dim_to_explore,
+                                     std::vector<int> fmap_to_explore,
+                                     std::vector<int> frange_to_explore,
+                                     char const *filename,
+                                     bool verbose,
+                                     char const *default_config,
+                                     char const *spool_dir,
+                                     char const *metrics_prefix) {
+  StreamingSearch *s = new StreamingSearch();
+  s->queue = std::make_shared<search::SearchResultQueue>();
+  json j;
+  if (load_checkpoint(filename, j)) {
+    for (json const &graph : j) {
+      s->queue->push(graph);
+    }
+    s->queue->close();
+    return s;
+  }
+  search::GeneratorConfig config = get_generator_config(imap_to_explore,
+                                                        omap_to_explore,
+                                                        grid_dim_to_explore,
+                                                        block_dim_to_explore,
+                                                        fmap_to_explore,
+                                                        frange_to_explore,
+                                                        default_config);
+  // The generator keeps a pointer to the file name, which must outlive the
+  // caller's buffer
+  s->filename = filename ? filename : "mirage_search_checkpoint.json";
+  s->gen = std::make_unique<search::KernelGraphGenerator>(
+      *input_graph, config, s->filename.c_str(), verbose);
+  s->gen->config.show();
+  if (metrics_prefix) {
+    s->gen->metrics_prefix = metrics_prefix;
+  }
+  s->gen->result_queue = s->queue;
+  std::string spool = spool_dir ? spool_dir : "";
+  s->thread = std::thread([s, spool]() {
+    if (!spool.empty()) {
+      s->gen->generate_kernel_graphs_distributed(spool.c_str());
+    } else {
+      s->gen->generate_kernel_graphs();
+    }
+    s->queue->close();
+  });
+  return s;
+}
+
+int cython_next_searched_graph(StreamingSearch *s,
+                               int timeout_ms,
+                               mirage::kernel::Graph **new_graph) {
+  json j;
+  switch (s->queue->pop(j, timeout_ms)) {
+    case search::SearchResultQueue::Status::GRAPH:
+      *new_graph = new kernel::Graph();
+      from_json(j, **new_graph);
+      return 1;
+    case search::SearchResultQueue::Status::TIMEOUT:
+      return 0;
+    case search::SearchResultQueue::Status::CLOSED:
+      return -1;
+  }
+  return -1;
+}
+
+void cython_stop_search(StreamingSearch *s) {
+  if (s->gen) {
+    s->gen->request_stop();
+  }
+}
+
+void cython_pause_search(StreamingSearch *s) {
+  if (s->gen) {
+    s->gen->pause();
+  }
+}
+
+void cython_resume_search(StreamingSearch *s) {
+  if (s->gen) {
+    s->gen->resume();
+  }
+}
+
+void cython_finish_search(StreamingSearch *s) {
+  if (s->thread.joinable()) {
+    s->thread.join();
+  }
+  if (s->gen) {
+    last_search_metrics = json(s->gen->metrics.snapshot()).dump();
+  }
+  delete s;
+}
+
+std::string cython_estimate_search(mirage::kernel::Graph const *input_graph,
+                                   std::vector<MInt3> imap_to_explore,
+                                   std::vector<MInt3> omap_to_explore,
+                                   std::vector<MDim3> grid_dim_to_explore,
+                                   std::vector<int> fmap_to_explore,
+                                   std::vector<int> frange_to_explore,
+                                   char const *default_config,
+                                   int num_probes,
+                                   unsigned int seed,
+                                   int search_thread) {
+  search::GeneratorConfig config = get_generator_config(imap_to_explore,
+                                                        omap_to_explore,
+                                                        grid_dim_to_explore,
+                                                        {} /*block dims*/,
+                                                        fmap_to_explore,
+                                                        frange_to_explore,
+                                                        default_config);
+  if (search_thread > 0) {
+    config.search_thread = search_thread;
+  }
+  search::KernelGraphGenerator gen(
+      *input_graph, config, "mirage_search_estimate.json");
+  search::SearchEstimate estimate = gen.estimate_search(num_probes, seed);
+  json j = estimate;
+  j["num_thread"] = gen.num_thread;
+  j["predicted_sec"] = estimate.get_predicted_sec(gen.num_thread);
+  return j.dump();
+}
+
+std::string cython_get_search_metrics() {
+  return last_search_metrics;
+}
+
+void cython_search_worker(char const *spool_dir) {
+  search::run_search_worker(spool_dir);
+}
+
 void cython_to_json(mirage::kernel::Graph const *input_graph,
                     char const *filename) {
   json j;
@@ -6,6 +6,7 @@ namespace search {
 void from_json(json const &j, SearchContext &c) {
   c.kn_graph = std::make_shared<kernel::Graph>();
   from_json(j.at("kn_graph"), *c.kn_graph);
+  abstract_expr_eval(*c.kn_graph, c.patterns);
   if (j.contains("tb_graph")) {
     auto get_index = [&](int guid) {
       for (size_t i = 0; i < j.at("kn_graph").size(); ++i) {
@@ -30,6 +31,7 @@ void from_json(json const &j, SearchContext &c) {
             c.kn_graph->operators[index.first]->output_tensors[index.second];
       }
     }
+    abstract_expr_eval(*c.tb_graph, c.patterns);
   }
   from_json(j.at("level"), c.level);
 }
@@ -46,11 +48,18 @@ SerializedSearchContext::SerializedSearchContext(SearchContext const &c) {
   to_json(data, c);
 }
 
+SerializedSearchContext::SerializedSearchContext(json const &data)
+    : data(data) {}
+
 SearchContext SerializedSearchContext::deserialize() const {
   SearchContext c;
   from_json(data, c);
   return c;
 }
 
+SerializedSearchContext::operator json() const {
+  return data;
+}
+
 } // namespace search
 } // namespace mirage
@@ -0,0 +1,116 @@
+#include "mirage/search/search_estimate.h"
+#include "mirage/search/search.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace mirage {
+namespace search {
+
+double SearchEstimate::get_predicted_sec(int num_thread) const {
+  double sec = (expansion_sec + verification_sec) / std::max(num_thread, 1);
+  if (serialized_verification) {
+    sec = std::max(sec, verification_sec);
+  }
+  return sec;
+}
+
+void to_json(json &j, SearchEstimate const &e) {
+  j = {{"num_probes", e.num_probes},
+       {"max_probe_depth", e.max_probe_depth},
+       {"num_states", e.num_states},
+       {"num_states_stderr", e.num_states_stderr},
+       {"num_verifications", e.num_verifications},
+       {"expansion_sec", e.expansion_sec},
+       {"verification_sec", e.verification_sec},
+       {"serialized_verification", e.serialized_verification}};
+}
+
+// Knuth's estimator: each probe walks from the root to a leaf through
+// uniformly random children. A state reached through children counts
+// b_1, ..., b_d stands for b_1 * ... * b_d states of its depth, so weighting
+// each state on the path by that product gives an unbiased estimate of any
+// sum over all states, e.g. their number or their cost
+SearchEstimate KernelGraphGenerator::estimate_search(size_t num_probes,
+                                                     unsigned int seed) {
+  assert(num_probes > 0);
+  start_time = std::chrono::steady_clock::now();
+  std::mt19937 rng(seed);
+
+  // Children of a state are collected the way the coordinator of a
+  // distributed search collects work units, and max_depth = 0 keeps the
+  // expansion on this thread
+  std::vector<SerializedSearchContext> children;
+  size_t saved_max_depth = max_depth;
+  max_depth = 0;
+  work_units = &children;
+
+  SearchEstimate estimate;
+  estimate.num_probes = num_probes;
+  // The GPU part of the probabilistic verifier holds a process-wide lock
+  estimate.serialized_verification =
+      config.verifier_type == VerifierType::PROBABILISTIC_VERIFIER;
+  double sum_states_sq = 0;
+  for (size_t probe = 0; probe < num_probes && !stop_requested; ++probe) {
+    SearchContext c = get_initial_context();
+    double weight = 1, states = 0;
+    size_t depth = 0;
+    while (true) {
+      int num_random_tests = num_total_random_tests;
+      int64_t verification_ns = 0;
+      auto verify = [&](SearchContext const &c) {
+        if (c.level != SearchLevel::LV_KERNEL) {
+          return false;
+        }
+        auto verify_start = std::chrono::steady_clock::now();
+        bool valid = this->verify(*c.kn_graph, false /*save*/);
+        verification_ns = get_elapsed_ns(verify_start);
+        return valid;
+      };
+      std::vector<SerializedSearchContext> verified;
+      children.clear();
+      split_depth = depth + 1;
+      auto start = std::chrono::steady_clock::now();
+      generate_next_operator(c, verify, verified, depth);
+      int64_t state_ns = get_elapsed_ns(start);
+
+      states += weight;
+      // Only states whose kernel graph reaches the verifier count as a test
+      if (num_total_random_tests > num_random_tests) {
+        estimate.num_verifications += weight;
+      }
+      estimate.verification_sec += weight * verification_ns * 1e-9;
+      estimate.expansion_sec += weight * (state_ns - verification_ns) * 1e-9;
+      if (children.empty()) {
+        break;
+      }
+      std::uniform_int_distribution<size_t> pick(0, children.size() - 1);
+      weight *= children.size();
+      c = children[pick(rng)].deserialize();
+      ++depth;
+    }
+    estimate.num_states += states;
+    sum_states_sq += states * states;
+    estimate.max_probe_depth = std::max(estimate.max_probe_depth, depth);
+  }
+
+  work_units = nullptr;
+  max_depth = saved_max_depth;
+
+  double n = static_cast<double>(num_probes);
+  estimate.num_states /= n;
+  estimate.num_verifications /= n;
+  estimate.expansion_sec /= n;
+  estimate.verification_sec /= n;
+  if (num_probes > 1) {
+    double variance =
+        (sum_states_sq - n * estimate.num_states * estimate.num_states) /
+        (n - 1);
+    estimate.num_states_stderr = std::sqrt(std::max(variance, 0.0) / n);
+  }
+  return estimate;
+}
+
+} // namespace search
+} // namespace mirage
@@ -0,0 +1,314 @@
+#include "mirage/search/search_metrics.h"
+#include "mirage/type.h"
+
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+namespace mirage {
+namespace search {
+
+namespace {
+
+char const *stage_names[] = {
+    "check_pattern",
+    "check_range",
+    "create_op",
+    "pattern_eval",
+    "clone_context",
+    "verify",
+};
+static_assert(sizeof(stage_names) / sizeof(stage_names[0]) ==
+              static_cast<size_t>(SearchStage::NUM_STAGES));
+
+char const *cache_names[] = {
+    "seen_patterns",
+    "tb_graphs",
+};
+static_assert(sizeof(cache_names) / sizeof(cache_names[0]) ==
+              static_cast<size_t>(SearchCache::NUM_CACHES));
+
+std::string get_op_type_name(int op_type) {
+  json j;
+  if (op_type < static_cast<int>(type::TB_UNKOWN)) {
+    j = static_cast<type::KNOperatorType>(op_type);
+  } else {
+    j = static_cast<type::TBOperatorType>(op_type);
+  }
+  return j.get<std::string>();
+}
+
+double get_bucket_upper_bound_sec(int bucket) {
+  return static_cast<double>(int64_t(1) << (bucket + 1)) * 1e-9;
+}
+
+void write_histogram(std::ostringstream &oss,
+                     std::string const &name,
+                     std::string const &labels,
+                     LatencyHistogram const &h) {
+  size_t cumulative = 0;
+  std::string sep = labels.empty() ? "" : ",";
+  for (int i = 0; i < LatencyHistogram::NUM_BUCKETS - 1; i++) {
+    cumulative += h.buckets[i];
+    oss << name << "_bucket{" << labels << sep << "le=\""
+        << get_bucket_upper_bound_sec(i) << "\"} " << cumulative << "\n";
+  }
+  oss << name << "_bucket{" << labels << sep << "le=\"+Inf\"} " << h.count
+      << "\n";
+  oss << name << "_sum{" << labels << "} " << h.sum_sec << "\n";
+  oss << name << "_count{" << labels << "} " << h.count << "\n";
+}
+
+std::atomic<size_t> next_metrics_id(0);
+
+} // namespace
+
+void LatencyHistogram::record(int64_t ns) {
+  int bucket = 0;
+  while (bucket < NUM_BUCKETS - 1 && (int64_t(2) << bucket) <= ns) {
+    bucket++;
+  }
+  buckets[bucket]++;
+  count++;
+  sum_sec += ns * 1e-9;
+}
+
+void LatencyHistogram::merge(LatencyHistogram const &other) {
+  for (int i = 0; i < NUM_BUCKETS; i++) {
+    buckets[i] += other.buckets[i];
+  }
+  count += other.count;
+  sum_sec += other.sum_sec;
+}
+
+void SearchMetricsSnapshot::merge(SearchMetricsSnapshot const &other) {
+  for (size_t i = 0; i < stages.size(); i++) {
+    stages[i].merge(other.stages[i]);
+  }
+  for (auto const &[op_type, h] : other.create_op) {
+    create_op[op_type].merge(h);
+  }
+  for (auto const &[op_type, n] : other.create_op_failures) {
+    create_op_failures[op_type] += n;
+  }
+  for (auto const &[depth, n] : other.states_per_depth) {
+    states_per_depth[depth] += n;
+  }
+  for (size_t i = 0; i < cache_hits_misses.size(); i++) {
+    cache_hits_misses[i].first += other.cache_hits_misses[i].first;
+    cache_hits_misses[i].second += other.cache_hits_misses[i].second;
+  }
+}
+
+std::string SearchMetricsSnapshot::to_openmetrics() const {
+  std::ostringstream oss;
+  oss << "# TYPE mirage_search_stage_seconds histogram\n";
+  for (size_t i = 0; i < stages.size(); i++) {
+    write_histogram(oss,
+                    "mirage_search_stage_seconds",
+                    std::string("stage=\"") + stage_names[i] + "\"",
+                    stages[i]);
+  }
+  oss << "# TYPE mirage_search_create_op_seconds histogram\n";
+  for (auto const &[op_type, h] : create_op) {
+    write_histogram(oss,
+                    "mirage_search_create_op_seconds",
+                    "op_type=\"" + get_op_type_name(op_type) + "\"",
+                    h);
+  }
+  oss << "# TYPE mirage_search_create_op_failures counter\n";
+  for (auto const &[op_type, n] : create_op_failures) {
+    oss << "mirage_search_create_op_failures_total{op_type=\""
+        << get_op_type_name(op_type) << "\"} " << n << "\n";
+  }
+  oss << "# TYPE mirage_search_states counter\n";
+  for (auto const &[depth, n] : states_per_depth) {
+    oss << "mirage_search_states_total{depth=\"" << depth << "\"} " << n
+        << "\n";
+  }
+  oss << "# TYPE mirage_search_cache_hits counter\n";
+  for (size_t i = 0; i < cache_hits_misses.size(); i++) {
+    oss << "mirage_search_cache_hits_total{cache=\"" << cache_names[i] << "\"} "
+        << cache_hits_misses[i].first << "\n";
+  }
+  oss << "# TYPE mirage_search_cache_misses counter\n";
+  for (size_t i = 0; i < cache_hits_misses.size(); i++) {
+    oss << "mirage_search_cache_misses_total{cache=\"" << cache_names[i]
+        << "\"} " << cache_hits_misses[i].second << "\n";
+  }
+  oss << "# EOF\n";
+  return oss.str();
+}
+
+void to_json(json &j, LatencyHistogram const &h) {
+  j = {{"count", h.count}, {"sum_sec", h.sum_sec}, {"buckets", h.buckets}};
+}
+
+void from_json(json const &j, LatencyHistogram &h) {
+  j.at("count").get_to(h.count);
+  j.at("sum_sec").get_to(h.sum_sec);
+  j.at("buckets").get_to(h.buckets);
+}
+
+void to_json(json &j, SearchMetricsSnapshot const &m) {
+  j = json::object();
+  for (size_t i = 0; i < m.stages.size(); i++) {
+    j["stages"][stage_names[i]] = m.stages[i];
+  }
+  for (auto const &[op_type, h] : m.create_op) {
+    json op = h;
+    op["op_type"] = op_type;
+    op["name"] = get_op_type_name(op_type);
+    auto it = m.create_op_failures.find(op_type);
+    op["failures"] = it == m.create_op_failures.end() ? 0 : it->second;
+    j["create_op"].push_back(op);
+  }
+  for (auto const &[depth, n] : m.states_per_depth) {
+    j["states_per_depth"][std::to_string(depth)] = n;
+  }
+  for (size_t i = 0; i < m.cache_hits_misses.size(); i++) {
+    size_t hits = m.cache_hits_misses[i].first;
+    size_t misses = m.cache_hits_misses[i].second;
+    j["caches"][cache_names[i]] = {
+        {"hits", hits},
+        {"misses", misses},
+        {"hit_rate",
+         hits + misses == 0 ? 0.0
+                            : static_cast<double>(hits) / (hits + misses)}};
+  }
+}
+
+void from_json(json const &j, SearchMetricsSnapshot &m) {
+  m = SearchMetricsSnapshot();
+  for (size_t i = 0; i < m.stages.size(); i++) {
+    if (j.contains("stages") && j["stages"].contains(stage_names[i])) {
+      j["stages"][stage_names[i]].get_to(m.stages[i]);
+    }
+  }
+  if (j.contains("create_op")) {
+    for (json const &op : j["create_op"]) {
+      int op_type = op.at("op_type").get<int>();
+      op.get_to(m.create_op[op_type]);
+      m.create_op_failures[op_type] = op.at("failures").get<size_t>();
+    }
+  }
+  if (j.contains("states_per_depth")) {
+    for (auto const &[depth, n] : j["states_per_depth"].items()) {
+      m.states_per_depth[std::stoul(depth)] = n.get<size_t>();
+    }
+  }
+  for (size_t i = 0; i < m.cache_hits_misses.size(); i++) {
+    if (j.contains("caches") && j["caches"].contains(cache_names[i])) {
+      json const &cache = j["caches"][cache_names[i]];
+      m.cache_hits_misses[i] = {cache.at("hits").get<size_t>(),
+                                cache.at("misses").get<size_t>()};
+    }
+  }
+}
+
+int64_t get_elapsed_ns(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+SearchMetrics::SearchMetrics() : id(next_metrics_id++) {}
+
+SearchMetrics::Slot &SearchMetrics::local() {
+  // Fast path for a thread recording into the same SearchMetrics as last
+  // time; ids are never reused, so stale entries are never looked up
+  thread_local size_t last_id = SIZE_MAX;
+  thread_local Slot *last_slot = nullptr;
+  thread_local std::unordered_map<size_t, Slot *> slot_of;
+  if (last_id == id) {
+    return *last_slot;
+  }
+  auto it = slot_of.find(id);
+  if (it == slot_of.end()) {
+    std::lock_guard<std::mutex> lock(mutex);
+    slots.push_back(std::make_unique<Slot>());
+    it = slot_of.emplace(id, slots.back().get()).first;
+  }
+  last_id = id;
+  last_slot = it->second;
+  return *last_slot;
+}
+
+void SearchMetrics::record_stage(SearchStage stage, int64_t ns) {
+  Slot &slot = local();
+  std::lock_guard<std::mutex> lock(slot.mutex);
+  slot.data.stages[static_cast<int>(stage)].record(ns);
+}
+
+void SearchMetrics::record_create_op(int op_type, int64_t ns, bool success) {
+  Slot &slot = local();
+  std::lock_guard<std::mutex> lock(slot.mutex);
+  slot.data.stages[static_cast<int>(SearchStage::CREATE_OP)].record(ns);
+  slot.data.create_op[op_type].record(ns);
+  if (!success) {
+    slot.data.create_op_failures[op_type]++;
+  }
+}
+
+void SearchMetrics::record_state(size_t depth) {
+  Slot &slot = local();
+  std::lock_guard<std::mutex> lock(slot.mutex);
+  slot.data.states_per_depth[depth]++;
+}
+
+void SearchMetrics::record_cache(SearchCache cache, bool hit) {
+  Slot &slot = local();
+  std::lock_guard<std::mutex> lock(slot.mutex);
+  auto &hits_misses = slot.data.cache_hits_misses[static_cast<int>(cache)];
+  if (hit) {
+    hits_misses.first++;
+  } else {
+    hits_misses.second++;
+  }
+}
+
+void SearchMetrics::set_remote(std::string const &source,
+                               SearchMetricsSnapshot const &m) {
+  std::lock_guard<std::mutex> lock(mutex);
+  remote[source] = m;
+}
+
+SearchMetricsSnapshot SearchMetrics::snapshot() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  SearchMetricsSnapshot total;
+  for (auto const &[source, m] : remote) {
+    total.merge(m);
+  }
+  for (auto const &slot : slots) {
+    std::lock_guard<std::mutex> slot_lock(slot->mutex);
+    total.merge(slot->data);
+  }
+  return total;
+}
+
+void SearchMetrics::export_to(std::string const &prefix) const {
+  SearchMetricsSnapshot m = snapshot();
+  {
+    std::ofstream ofs(prefix + ".json");
+    ofs << json(m).dump(2);
+  }
+  {
+    std::ofstream ofs(prefix + ".prom");
+    ofs << m.to_openmetrics();
+  }
+}
+
+SearchMetrics::StageTimer::StageTimer(SearchMetrics &metrics, SearchStage stage)
+    : metrics(metrics), stage(stage), start(std::chrono::steady_clock::now()) {}
+
+SearchMetrics::StageTimer::~StageTimer() {
+  metrics.record_stage(stage, elapsed_ns());
+}
+
+int64_t SearchMetrics::StageTimer::elapsed_ns() const {
+  return get_elapsed_ns(start);
+}
+
+} // namespace search
+} // namespace mirage
@@ -0,0 +1,40 @@
+#include "mirage/search/search_result_queue.h"
+
+#include <chrono>
+
+namespace mirage {
+namespace search {
+
+void SearchResultQueue::push(json const &graph) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    graphs.push_back(graph);
+  }
+  cv.notify_one();
+}
+
+SearchResultQueue::Status SearchResultQueue::pop(json &graph, int timeout_ms) {
+  std::unique_lock<std::mutex> lock(mutex);
+  if (!cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] {
+        return !graphs.empty() || closed;
+      })) {
+    return Status::TIMEOUT;
+  }
+  if (graphs.empty()) {
+    return Status::CLOSED;
+  }
+  graph = std::move(graphs.front());
+  graphs.pop_front();
+  return Status::GRAPH;
+}
+
+void SearchResultQueue::close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+  }
+  cv.notify_all();
+}
+
+} // namespace search
+} // namespace mirage
@@ -0,0 +1,36 @@
+#include "mirage/search/tb_graph_memo.h"
+
+namespace mirage {
+namespace search {
+
+std::shared_ptr<TBGraphMemo::Recipes const>
+    TBGraphMemo::find(std::string const &key) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = entries.find(key);
+  return it == entries.end() ? nullptr : it->second;
+}
+
+void TBGraphMemo::insert(std::string const &key, Recipes recipes) {
+  std::lock_guard<std::mutex> lock(mutex);
+  // Identical searches running concurrently complete with the same recipes
+  entries.emplace(key, std::make_shared<Recipes const>(std::move(recipes)));
+}
+
+TBGraphRecorder::TBGraphRecorder(TBGraphMemo &memo,
+                                 std::string key,
+                                 std::atomic<bool> const &aborted)
+    : memo(memo), key(std::move(key)), aborted(aborted) {}
+
+TBGraphRecorder::~TBGraphRecorder() {
+  if (!aborted) {
+    memo.insert(key, std::move(recipes));
+  }
+}
+
+void TBGraphRecorder::record(TBGraphRecipe const &recipe) {
+  std::lock_guard<std::mutex> lock(mutex);
+  recipes.push_back(recipe);
+}
+
+} // namespace search
+} // namespace mirage
@@ -1,15 +1,47 @@
 #include "mirage/search/verification/formal_verifier.h"
 #include "mirage/search/op_utils.h"
 
+#include <algorithm>
 #include <iostream>
+#include <map>
 
 namespace mirage {
 namespace search {
 
 std::mutex FormalVerifier::formal_verifier_mutex;
 
+namespace {
+
+std::vector<int> get_shape(kernel::DTensor const &tensor) {
+  std::vector<int> shape{static_cast<int>(tensor.data_type)};
+  for (int i = 0; i < tensor.num_dims; i++) {
+    shape.push_back(tensor.dim[i]);
+  }
+  return shape;
+}
+
+// In the order of get_concrete_exprs without output operators
+std::vector<kernel::DTensor> get_graph_outputs(kernel::Graph const &graph) {
+  std::vector<kernel::DTensor> outputs;
+  for (kernel::KNOperator *op : graph.operators) {
+    for (kernel::DTensor const &tensor : op->output_tensors) {
+      if (get_num_consumers(graph, tensor) == 0) {
+        outputs.push_back(tensor);
+      }
+    }
+  }
+  return outputs;
+}
+
+} // namespace
+
 FormalVerifier::FormalVerifier(kernel::Graph const &input_graph) {
   input_exprs = get_concrete_exprs(input_graph, _ctx, true, all_dims);
+  for (kernel::KNOperator *op : input_graph.operators) {
+    if (op->op_type == type::KNOperatorType::KN_OUTPUT_OP) {
+      input_output_shapes.push_back(get_shape(op->input_tensors[0]));
+    }
+  }
 }
 
 OutputMatch FormalVerifier::verify(kernel::Graph const &graph) {
@@ -27,25 +59,29 @@ OutputMatch FormalVerifier::verify(kernel::Graph const &graph) {
       get_concrete_exprs(graph, ctx, false, all_dims);
   assert(input_exprs.size() == graph_exprs.size());
 
-  auto verify_with_match = [&](OutputMatch const &match) {
-    for (size_t i = 0; i < match.size(); i++) {
-      if (!is_equivalent(input_exprs_in_current_ctx[i],
-                         graph_exprs[match[i]],
-                         ctx,
-                         all_dims)) {
-        return false;
-      }
-    }
-    return true;
-  };
+  // Only outputs of the same shape are compared, structurally identical
+  // expressions first since they need no solver call
+  std::vector<kernel::DTensor> graph_outputs = get_graph_outputs(graph);
+  assert(graph_outputs.size() == graph_exprs.size());
+  std::map<std::vector<int>, std::vector<int>> outputs_by_shape;
+  for (size_t j = 0; j < graph_outputs.size(); j++) {
+    outputs_by_shape[get_shape(graph_outputs[j])].push_back(j);
+  }
+  std::vector<std::vector<int>> candidates;
+  for (size_t i = 0; i < input_exprs.size(); i++) {
+    std::vector<int> shape_matches = outputs_by_shape[input_output_shapes[i]];
+    std::stable_partition(
+        shape_matches.begin(), shape_matches.end(), [&](int j) {
+          return z3::eq(input_exprs_in_current_ctx[i], graph_exprs[j]);
+        });
+    candidates.push_back(shape_matches);
+  }
 
-  OutputMatch match(input_exprs.size());
-  do {
-    if (verify_with_match(match)) {
-      return match;
-    }
-  } while (match.next());
-  return OutputMatch::invalid_match();
+  return OutputMatch::find_match(candidates, [&](int i, int j) {
+    return z3::eq(input_exprs_in_current_ctx[i], graph_exprs[j]) ||
+           is_equivalent(
+               input_exprs_in_current_ctx[i], graph_exprs[j], ctx, all_dims);
+  });
 }
 
 std::vector<z3::expr>
@@ -1,6 +1,8 @@
 #include "mirage/search/verification/output_match.h"
 
 #include <algorithm>
+#include <cassert>
+#include <cstdint>
 
 namespace mirage {
 namespace search {
@@ -18,6 +20,47 @@ OutputMatch OutputMatch::invalid_match() {
   return OutputMatch({}, false);
 }
 
+OutputMatch
+    OutputMatch::find_match(std::vector<std::vector<int>> const &candidates,
+                            std::function<bool(int, int)> const &is_match) {
+  int num_outputs = static_cast<int>(candidates.size());
+  // -1: not evaluated, 0: no match, 1: match
+  std::vector<std::vector<int8_t>> pair_matches(
+      num_outputs, std::vector<int8_t>(num_outputs, -1));
+  auto matches = [&](int i, int j) {
+    if (pair_matches[i][j] < 0) {
+      pair_matches[i][j] = is_match(i, j) ? 1 : 0;
+    }
+    return pair_matches[i][j] == 1;
+  };
+
+  // Kuhn's augmenting path algorithm
+  std::vector<int> match(num_outputs, -1), matched_by(num_outputs, -1);
+  std::vector<bool> visited;
+  std::function<bool(int)> augment = [&](int i) {
+    for (int j : candidates[i]) {
+      assert(0 <= j && j < num_outputs);
+      if (visited[j] || !matches(i, j)) {
+        continue;
+      }
+      visited[j] = true;
+      if (matched_by[j] == -1 || augment(matched_by[j])) {
+        match[i] = j;
+        matched_by[j] = i;
+        return true;
+      }
+    }
+    return false;
+  };
+  for (int i = 0; i < num_outputs; ++i) {
+    visited.assign(num_outputs, false);
+    if (!augment(i)) {
+      return invalid_match();
+    }
+  }
+  return OutputMatch(match, true);
+}
+
 bool OutputMatch::next() {
   return std::next_permutation(match.begin(), match.end());
 }
@@ -1,33 +1,108 @@
 #include "mirage/search/verification/probabilistic_verifier.h"
 #include "mirage/search/op_utils.h"
+#include "mirage/search/verification/sampled_fingerprint.h"
+
+#include <random>
+#include <unordered_map>
 
 namespace mirage {
 namespace search {
 
 std::mutex ProbabilisticVerifier::fp_mutex;
 
-ProbabilisticVerifier::ProbabilisticVerifier(kernel::Graph const &input_graph) {
+namespace {
+
+int const NUM_SAMPLED_ELEMENTS = 4;
+// Graphs needing more host work than this to sample their outputs are
+// passed on to the GPU fingerprinting
+size_t const MAX_NUM_SAMPLED_EVALUATIONS = 1 << 16;
+
+// Equal for tensors with the same shape, data type, layout and fingerprint
+size_t get_fingerprint_key(cpu::CTensor const &ctensor) {
+  size_t seed = ctensor.fingerprint_digest();
+  hash_combine(seed, static_cast<int>(ctensor.data_type));
+  hash_combine(seed, static_cast<int>(ctensor.layout));
+  for (int i = 0; i < ctensor.num_dims; i++) {
+    hash_combine(seed, ctensor.dim[i]);
+  }
+  return seed;
+}
+
+bool has_same_shape(kernel::DTensor const &tensor, cpu::CTensor const &ref) {
+  if (tensor.data_type != ref.data_type || tensor.num_dims != ref.num_dims) {
+    return false;
+  }
+  for (int i = 0; i < tensor.num_dims; i++) {
+    if (tensor.dim[i] != ref.dim[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+ProbabilisticVerifier::ProbabilisticVerifier(kernel::Graph const &input_graph,
+                                             bool enable_sampled_fingerprint)
+    : enable_sampled_fingerprint(enable_sampled_fingerprint) {
   for (auto const &op : input_graph.operators) {
     op->fingerprint();
   }
 
+  std::mt19937 gen(0);
   for (kernel::KNOperator *op : input_graph.operators) {
     if (op->op_type == type::KNOperatorType::KN_OUTPUT_OP) {
       input_graph_fingerprints.push_back(
           op->input_tensors[0].copy_fingerprint_to_ctensor());
+      cpu::CTensor const &ctensor = input_graph_fingerprints.back();
+      input_graph_fingerprint_keys.push_back(get_fingerprint_key(ctensor));
+      std::uniform_int_distribution<size_t> dist(0, ctensor.num_elements() - 1);
+      sampled_elements.emplace_back();
+      for (int i = 0; i < NUM_SAMPLED_ELEMENTS; i++) {
+        size_t idx = dist(gen);
+        sampled_elements.back().push_back({idx, ctensor.fp_ptr[0][idx]});
+      }
     }
   }
 }
 
-OutputMatch ProbabilisticVerifier::verify(kernel::Graph const &graph) {
-  std::lock_guard<std::mutex> lock(fp_mutex);
+bool ProbabilisticVerifier::may_match(
+    kernel::Graph const &graph,
+    std::vector<kernel::DTensor> const &outputs) const {
+  // Sampled fingerprints are those of gpu 0 of a single-GPU graph
+  if (!enable_sampled_fingerprint ||
+      graph.gpu_dim.x * graph.gpu_dim.y * graph.gpu_dim.z != 1) {
+    return true;
+  }
+  std::vector<std::vector<int>> candidates;
+  for (cpu::CTensor const &ref : input_graph_fingerprints) {
+    candidates.emplace_back();
+    for (size_t j = 0; j < outputs.size(); j++) {
+      if (has_same_shape(outputs[j], ref)) {
+        candidates.back().push_back(j);
+      }
+    }
+  }
+  // Elements the host cannot fingerprint never rule out a match
+  SampledFingerprinter fingerprinter(MAX_NUM_SAMPLED_EVALUATIONS);
+  return OutputMatch::find_match(
+             candidates,
+             [&](int i, int j) {
+               for (auto const &[idx, fp] : sampled_elements[i]) {
+                 std::optional<type::FPType> sampled =
+                     fingerprinter.get_fingerprint(outputs[j], idx);
+                 if (sampled && *sampled != fp) {
+                   return false;
+                 }
+               }
+               return true;
+             })
+      .is_valid();
+}
 
+OutputMatch ProbabilisticVerifier::verify(kernel::Graph const &graph) {
   std::vector<kernel::DTensor> fingerprints;
 
-  for (auto const &op : graph.operators) {
-    op->fingerprint();
-  }
-
   for (auto const &op : graph.operators) {
     for (auto const &tensor : op->output_tensors) {
       if (get_num_consumers(graph, tensor) == 0) {
@@ -38,24 +113,43 @@ OutputMatch ProbabilisticVerifier::verify(kernel::Graph const &graph) {
 
   assert(fingerprints.size() == input_graph_fingerprints.size());
 
-  auto verify_with_match = [&](OutputMatch const &match) {
-    for (size_t i = 0; i < match.size(); i++) {
-      if (!fingerprints[match[i]].has_same_fingerprint(
-              input_graph_fingerprints[i])) {
-        return false;
-      }
-    }
-    return true;
-  };
+  // Runs on the host, outside of fp_mutex
+  if (!may_match(graph, fingerprints)) {
+    return OutputMatch::invalid_match();
+  }
+
+  std::lock_guard<std::mutex> lock(fp_mutex);
+
+  for (auto const &op : graph.operators) {
+    op->fingerprint();
+  }
 
-  OutputMatch match(fingerprints.size());
-  do {
-    if (verify_with_match(match)) {
-      assert(match.is_valid());
-      return match;
+  // Copy each output's fingerprint to the host once, and only compare
+  // outputs whose shapes and fingerprint digests agree
+  std::vector<cpu::CTensor> output_fingerprints;
+  std::unordered_map<size_t, std::vector<int>> outputs_by_key;
+  for (size_t j = 0; j < fingerprints.size(); j++) {
+    output_fingerprints.push_back(
+        fingerprints[j].copy_fingerprint_to_ctensor());
+    outputs_by_key[get_fingerprint_key(output_fingerprints.back())].push_back(
+        j);
+  }
+  std::vector<std::vector<int>> candidates;
+  for (size_t key : input_graph_fingerprint_keys) {
+    candidates.push_back(outputs_by_key[key]);
+  }
+
+  OutputMatch match = OutputMatch::find_match(candidates, [&](int i, int j) {
+    return output_fingerprints[j].has_same_fingerprint(
+        input_graph_fingerprints[i]);
+  });
+
+  for (cpu::CTensor &ctensor : output_fingerprints) {
+    for (int gpu_id = 0; gpu_id < config::MAX_NUM_GPUS; gpu_id++) {
+      free(ctensor.fp_ptr[gpu_id]);
     }
-  } while (match.next());
-  return OutputMatch::invalid_match();
+  }
+  return match;
 }
 
 } // namespace search
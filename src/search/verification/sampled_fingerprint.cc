@@ -0,0 +1,697 @@
+#include "mirage/search/verification/sampled_fingerprint.h"
+#include "mirage/kernel/customized.h"
+#include "mirage/kernel/reduction.h"
+#include "mirage/kernel/rms_norm.h"
+#include "mirage/utils/fingerprint_functions.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace mirage {
+namespace search {
+
+namespace {
+
+using namespace mirage::config;
+using type::FPType;
+
+// Host copies of the lookup tables built by kernel::DeviceMemoryManager
+struct LookupTables {
+  FPType exp[FP_Q], div_p[FP_P], div_q[FP_Q], sqrt_p[FP_P], sqrt_q[FP_Q];
+
+  LookupTables() {
+    utils::init_exp_lookup_table(exp);
+    utils::init_div_lookup_table(div_p, FP_P);
+    utils::init_div_lookup_table(div_q, FP_Q);
+    utils::init_sqrt_lookup_table(sqrt_p, FP_P);
+    utils::init_sqrt_lookup_table(sqrt_q, FP_Q);
+  }
+};
+
+LookupTables const &get_lookup_tables() {
+  static LookupTables const tables;
+  return tables;
+}
+
+FPType compute_div_fp(FPType a, FPType b) {
+  LookupTables const &tables = get_lookup_tables();
+  return utils::compute_div_fingerprint(a, b, tables.div_p, tables.div_q);
+}
+
+FPType compute_sqrt_fp(FPType input) {
+  LookupTables const &tables = get_lookup_tables();
+  return utils::compute_sqrt_fingerprint(input, tables.sqrt_p, tables.sqrt_q);
+}
+
+FPType compute_unary_fp(type::KNOperatorType op_type, FPType input) {
+  LookupTables const &tables = get_lookup_tables();
+  switch (op_type) {
+    case type::KN_EXP_OP:
+      return utils::compute_exp_fingerprint(input, tables.exp);
+    case type::KN_SQUARE_OP:
+      return utils::compute_square_fingerprint(input);
+    case type::KN_SQRT_OP:
+      return compute_sqrt_fp(input);
+    case type::KN_SILU_OP:
+      return utils::compute_silu_fingerprint(input, tables.exp);
+    case type::KN_GELU_OP:
+      return utils::compute_gelu_fingerprint(input, tables.exp);
+    case type::KN_RELU_OP:
+      return utils::compute_relu_fingerprint(input);
+    case type::KN_CLAMP_OP:
+      return utils::compute_clamp_fingerprint(input);
+    default:
+      assert(false && "Unsupported element-wise unary operator");
+  }
+  return 0;
+}
+
+FPType compute_binary_fp(type::KNOperatorType op_type, FPType x, FPType y) {
+  switch (op_type) {
+    case type::KN_ADD_OP:
+      return utils::compute_add_fingerprint(x, y);
+    case type::KN_MUL_OP:
+      return utils::compute_mul_fingerprint(x, y);
+    case type::KN_DIV_OP:
+      return compute_div_fp(x, y);
+    case type::KN_POW_OP:
+      return utils::compute_pow_fingerprint(x, y);
+    default:
+      assert(false && "Unsupported element-wise binary operator");
+  }
+  return 0;
+}
+
+// Returns KN_UNKOWN for threadblock operators with no kernel-level
+// counterpart among the element-wise operators fingerprinted on the host
+type::KNOperatorType get_elementwise_op_type(type::TBOperatorType op_type) {
+  switch (op_type) {
+    case type::TB_EXP_OP:
+      return type::KN_EXP_OP;
+    case type::TB_SQUARE_OP:
+      return type::KN_SQUARE_OP;
+    case type::TB_SQRT_OP:
+      return type::KN_SQRT_OP;
+    case type::TB_SILU_OP:
+      return type::KN_SILU_OP;
+    case type::TB_GELU_OP:
+      return type::KN_GELU_OP;
+    case type::TB_RELU_OP:
+      return type::KN_RELU_OP;
+    case type::TB_CLAMP_OP:
+      return type::KN_CLAMP_OP;
+    case type::TB_ADD_OP:
+      return type::KN_ADD_OP;
+    case type::TB_MUL_OP:
+      return type::KN_MUL_OP;
+    case type::TB_DIV_OP:
+      return type::KN_DIV_OP;
+    case type::TB_POW_OP:
+      return type::KN_POW_OP;
+    default:
+      return type::KN_UNKOWN;
+  }
+}
+
+// Index of the element of a broadcast operand that the element-wise binary
+// fingerprinters read for output element idx
+size_t get_broadcast_idx(int num_dims,
+                         int const *output_dims,
+                         int const *input_dims,
+                         size_t idx) {
+  size_t input_idx = 0, input_stride = 1;
+  for (int d = num_dims - 1; d >= 0; d--) {
+    input_idx += (idx % input_dims[d]) * input_stride;
+    input_stride *= input_dims[d];
+    idx /= output_dims[d];
+  }
+  return input_idx;
+}
+
+// Root mean square of a row, given the row's k-th element
+template <typename GetElement>
+FPType compute_rms_fp(size_t norm_size, GetElement const &get_element) {
+  FPType square_sum = 0;
+  for (size_t k = 0; k < norm_size; k++) {
+    FPType x = get_element(k);
+    square_sum = utils::compute_add_fingerprint(
+        square_sum, utils::compute_mul_fingerprint(x, x));
+  }
+  return compute_sqrt_fp(compute_div_fp(square_sum, norm_size % FP_PQ));
+}
+
+// Offsets of the tile a threadblock loads or saves in a forloop iteration,
+// as serialized by threadblock::Graph::get_new_kernel_params
+struct TileStrides {
+  TileStrides(kernel::DTensor const &dtensor,
+              threadblock::STensor const &stensor,
+              int3 dim_map,
+              int forloop_dim,
+              int forloop_range) {
+    int num_dims = stensor.num_dims;
+    auto get_matrix_stride = [&](int map_dim, int d) {
+      return (map_dim == d ? stensor.dim[d] : 0) *
+             (forloop_dim == d ? forloop_range : 1);
+    };
+    row_block = {get_matrix_stride(dim_map.x, num_dims - 2),
+                 get_matrix_stride(dim_map.y, num_dims - 2),
+                 get_matrix_stride(dim_map.z, num_dims - 2)};
+    column_block = {get_matrix_stride(dim_map.x, num_dims - 1),
+                    get_matrix_stride(dim_map.y, num_dims - 1),
+                    get_matrix_stride(dim_map.z, num_dims - 1)};
+    row_forloop = forloop_dim == num_dims - 2 ? stensor.dim[num_dims - 2] : 0;
+    column_forloop =
+        forloop_dim == num_dims - 1 ? stensor.dim[num_dims - 1] : 0;
+    global_block = {0, 0, 0};
+    global_forloop = 0;
+    if (num_dims > 2) {
+      std::vector<int> strides(num_dims, 0);
+      strides[num_dims - 3] =
+          dtensor.dim[num_dims - 2] * dtensor.dim[num_dims - 1];
+      for (int j = num_dims - 4; j >= 0; j--) {
+        strides[j] = strides[j + 1] * dtensor.dim[j + 1];
+      }
+      auto get_global_stride = [&](int map_dim) {
+        return map_dim >= 0 && map_dim < num_dims - 2 ? strides[map_dim] : 0;
+      };
+      global_block = {get_global_stride(dim_map.x),
+                      get_global_stride(dim_map.y),
+                      get_global_stride(dim_map.z)};
+      if (forloop_dim >= 0 && forloop_dim < num_dims - 2) {
+        global_forloop = stensor.dim[forloop_dim] * strides[forloop_dim];
+      }
+    }
+  }
+
+  static int64_t get_offset(int3 block_stride,
+                            int forloop_stride,
+                            dim3 block,
+                            int forloop_idx) {
+    return (int64_t)block.x * block_stride.x +
+           (int64_t)block.y * block_stride.y +
+           (int64_t)block.z * block_stride.z +
+           (int64_t)forloop_idx * forloop_stride;
+  }
+
+  bool has_forloop_strides() const {
+    return row_forloop > 0 || column_forloop > 0 || global_forloop > 0;
+  }
+
+  int3 row_block, column_block, global_block;
+  int row_forloop, column_forloop, global_forloop;
+};
+
+} // namespace
+
+SampledFingerprinter::SampledFingerprinter(size_t max_num_evaluations)
+    : max_num_evaluations(max_num_evaluations), num_evaluations(0),
+      failed(false) {}
+
+std::optional<FPType>
+    SampledFingerprinter::get_fingerprint(kernel::DTensor const &tensor,
+                                          size_t idx) {
+  failed = idx >= tensor.num_elements();
+  FPType fp = get_dtensor_fp(tensor, idx);
+  if (failed) {
+    return std::nullopt;
+  }
+  return fp;
+}
+
+FPType SampledFingerprinter::fail() {
+  failed = true;
+  return 0;
+}
+
+FPType SampledFingerprinter::get_dtensor_fp(kernel::DTensor const &tensor,
+                                            size_t idx) {
+  if (failed) {
+    return 0;
+  }
+  ElementKey key{tensor.guid, -1, -1, idx};
+  auto it = memo.find(key);
+  if (it != memo.end()) {
+    return it->second;
+  }
+  if (++num_evaluations > max_num_evaluations || tensor.owner_op == nullptr) {
+    return fail();
+  }
+  kernel::KNOperator const *op = tensor.owner_op;
+  int num_dims = tensor.num_dims;
+  FPType fp = 0;
+  switch (op->op_type) {
+    case type::KN_INPUT_OP: {
+      fp = idx % FP_PQ;
+      break;
+    }
+    case type::KN_MATMUL_OP: {
+      kernel::DTensor const &A = op->input_tensors[0];
+      kernel::DTensor const &B = op->input_tensors[1];
+      size_t m = tensor.dim[num_dims - 2], n = tensor.dim[num_dims - 1],
+             k = A.dim[num_dims - 1];
+      size_t batch = idx / (m * n), row = idx % (m * n) / n, col = idx % n;
+      for (size_t i = 0; i < k && !failed; i++) {
+        FPType x = get_dtensor_fp(A, batch * m * k + row * k + i);
+        FPType y = get_dtensor_fp(B, batch * n * k + i * n + col);
+        fp = utils::compute_add_fingerprint(
+            fp, utils::compute_mul_fingerprint(x, y));
+      }
+      break;
+    }
+    case type::KN_EXP_OP:
+    case type::KN_SQUARE_OP:
+    case type::KN_SQRT_OP:
+    case type::KN_SILU_OP:
+    case type::KN_GELU_OP:
+    case type::KN_RELU_OP:
+    case type::KN_CLAMP_OP: {
+      fp = compute_unary_fp(op->op_type,
+                            get_dtensor_fp(op->input_tensors[0], idx));
+      break;
+    }
+    case type::KN_ADD_OP:
+    case type::KN_MUL_OP:
+    case type::KN_DIV_OP:
+    case type::KN_POW_OP: {
+      kernel::DTensor const &A = op->input_tensors[0];
+      kernel::DTensor const &B = op->input_tensors[1];
+      if (A.num_dims != num_dims || B.num_dims != num_dims) {
+        return fail();
+      }
+      FPType x = get_dtensor_fp(
+          A, get_broadcast_idx(num_dims, tensor.dim, A.dim, idx));
+      FPType y = get_dtensor_fp(
+          B, get_broadcast_idx(num_dims, tensor.dim, B.dim, idx));
+      fp = compute_binary_fp(op->op_type, x, y);
+      break;
+    }
+    case type::KN_REDUCTION_0_OP:
+    case type::KN_REDUCTION_1_OP:
+    case type::KN_REDUCTION_2_OP: {
+      kernel::DTensor const &input = op->input_tensors[0];
+      int dim =
+          static_cast<kernel::KNReductionOp const *>(op)->reduction_dim_idx;
+      size_t output_stride = 1, input_stride = 1;
+      for (int i = dim; i < num_dims; i++) {
+        output_stride *= tensor.dim[i];
+        input_stride *= input.dim[i];
+      }
+      int reduction_factor = input.dim[dim] / tensor.dim[dim];
+      size_t pos = idx / output_stride * input_stride + idx % output_stride;
+      for (int k = 0; k < reduction_factor && !failed; k++) {
+        fp = utils::compute_add_fingerprint(
+            fp, get_dtensor_fp(input, pos + k * output_stride));
+      }
+      break;
+    }
+    case type::KN_RMS_NORM_OP: {
+      kernel::DTensor const &input = op->input_tensors[0];
+      size_t norm_size =
+          static_cast<kernel::KNRMSNormOp const *>(op)->normalized_size;
+      size_t row_start = idx / norm_size * norm_size;
+      FPType rms = compute_rms_fp(norm_size, [&](size_t k) {
+        return get_dtensor_fp(input, row_start + k);
+      });
+      fp = compute_div_fp(get_dtensor_fp(input, idx), rms);
+      break;
+    }
+    case type::KN_CUSTOMIZED_OP: {
+      fp = get_customized_op_fp(static_cast<kernel::KNCustomizedOp const *>(op),
+                                tensor.owner_ts_idx,
+                                idx);
+      break;
+    }
+    default:
+      return fail();
+  }
+  if (!failed) {
+    memo.emplace(key, fp);
+  }
+  return fp;
+}
+
+FPType SampledFingerprinter::get_customized_op_fp(
+    kernel::KNCustomizedOp const *op, int output_idx, size_t idx) {
+  threadblock::Graph const &bgraph = op->bgraph;
+  if (!is_supported(bgraph)) {
+    return fail();
+  }
+  threadblock::TBOutputOp const *output_op = nullptr;
+  int num_outputs = 0;
+  for (threadblock::TBOperator const *tb_op : bgraph.operators) {
+    if (tb_op->op_type == type::TB_OUTPUT_OP && num_outputs++ == output_idx) {
+      output_op = static_cast<threadblock::TBOutputOp const *>(tb_op);
+    }
+  }
+  if (output_op == nullptr) {
+    return fail();
+  }
+
+  // Find the threadblock and the forloop iteration that last save the
+  // element; elements saved by no or several threadblocks are unknown
+  threadblock::STensor const &stensor = output_op->input_tensors[0];
+  kernel::DTensor const &dtensor = output_op->dtensor;
+  int num_dims = stensor.num_dims;
+  int64_t num_rows = stensor.dim[num_dims - 2];
+  int64_t num_columns = stensor.dim[num_dims - 1];
+  int64_t dtensor_num_columns = dtensor.dim[num_dims - 1];
+  int forloop_range = bgraph.forloop_range;
+  TileStrides strides(dtensor,
+                      stensor,
+                      output_op->output_map,
+                      output_op->forloop_dim,
+                      forloop_range);
+  int first_saving_iter = stensor.after_accum || !strides.has_forloop_strides()
+                              ? forloop_range - 1
+                              : 0;
+  bool found = false;
+  dim3 saving_block;
+  int saving_iter = 0;
+  size_t saving_idx = 0;
+  for (unsigned x = 0; x < bgraph.grid_dim.x; x++) {
+    for (unsigned y = 0; y < bgraph.grid_dim.y; y++) {
+      for (unsigned z = 0; z < bgraph.grid_dim.z; z++) {
+        dim3 block(x, y, z);
+        for (int i = first_saving_iter; i < forloop_range; i++) {
+          int64_t rel =
+              (int64_t)idx -
+              TileStrides::get_offset(
+                  strides.global_block, strides.global_forloop, block, i);
+          if (rel < 0) {
+            continue;
+          }
+          int64_t row = rel / dtensor_num_columns -
+                        TileStrides::get_offset(
+                            strides.row_block, strides.row_forloop, block, i);
+          int64_t column =
+              rel % dtensor_num_columns -
+              TileStrides::get_offset(
+                  strides.column_block, strides.column_forloop, block, i);
+          if (row < 0 || row >= num_rows || column < 0 ||
+              column >= num_columns) {
+            continue;
+          }
+          if (found && (saving_block.x != x || saving_block.y != y ||
+                        saving_block.z != z)) {
+            return fail();
+          }
+          found = true;
+          saving_block = block;
+          saving_iter = i;
+          saving_idx = row * num_columns + column;
+        }
+      }
+    }
+  }
+  if (!found) {
+    return fail();
+  }
+  return get_stensor_fp(bgraph, stensor, saving_block, saving_iter, saving_idx);
+}
+
+FPType SampledFingerprinter::get_stensor_fp(threadblock::Graph const &bgraph,
+                                            threadblock::STensor const &tensor,
+                                            dim3 block,
+                                            int forloop_idx,
+                                            size_t idx) {
+  if (failed) {
+    return 0;
+  }
+  // Operators after the forloop accumulators only run in the last iteration
+  if (tensor.after_accum) {
+    forloop_idx = bgraph.forloop_range - 1;
+  }
+  int block_idx =
+      (block.x * bgraph.grid_dim.y + block.y) * bgraph.grid_dim.z + block.z;
+  ElementKey key{tensor.guid, block_idx, forloop_idx, idx};
+  auto it = memo.find(key);
+  if (it != memo.end()) {
+    return it->second;
+  }
+  if (++num_evaluations > max_num_evaluations || tensor.owner_op == nullptr ||
+      idx >= tensor.num_elements()) {
+    return fail();
+  }
+  threadblock::TBOperator const *op = tensor.owner_op;
+  int num_dims = tensor.num_dims;
+  FPType fp = 0;
+  switch (op->op_type) {
+    case type::TB_INPUT_OP: {
+      fp = get_input_loader_fp(bgraph,
+                               static_cast<threadblock::TBInputOp const *>(op),
+                               block,
+                               forloop_idx,
+                               idx);
+      break;
+    }
+    case type::TB_FORLOOP_ACCUM_NO_RED_OP:
+    case type::TB_FORLOOP_ACCUM_RED_LD_SUM_OP:
+    case type::TB_FORLOOP_ACCUM_RED_LD_MEAN_OP:
+    case type::TB_FORLOOP_ACCUM_RED_LD_RMS_OP:
+    case type::TB_FORLOOP_ACCUM_REDTOX_LD_SUM_OP: {
+      fp = get_forloop_accum_fp(bgraph, op, block, idx);
+      break;
+    }
+    case type::TB_MATMUL_OP: {
+      threadblock::STensor const &A = op->input_tensors[0];
+      threadblock::STensor const &B = op->input_tensors[1];
+      size_t m = A.dim[num_dims - 2], n = B.dim[num_dims - 1],
+             k = A.dim[num_dims - 1];
+      // Batched matmuls are not supported in threadblock graphs
+      if (idx >= m * n) {
+        return fail();
+      }
+      size_t row = idx / n, col = idx % n;
+      for (size_t i = 0; i < k && !failed; i++) {
+        FPType x = get_stensor_fp(bgraph, A, block, forloop_idx, row * k + i);
+        FPType y = get_stensor_fp(bgraph, B, block, forloop_idx, i * n + col);
+        fp = utils::compute_add_fingerprint(
+            fp, utils::compute_mul_fingerprint(x, y));
+      }
+      break;
+    }
+    case type::TB_EXP_OP:
+    case type::TB_SQUARE_OP:
+    case type::TB_SQRT_OP:
+    case type::TB_SILU_OP:
+    case type::TB_GELU_OP:
+    case type::TB_RELU_OP:
+    case type::TB_CLAMP_OP: {
+      fp = compute_unary_fp(
+          get_elementwise_op_type(op->op_type),
+          get_stensor_fp(
+              bgraph, op->input_tensors[0], block, forloop_idx, idx));
+      break;
+    }
+    case type::TB_ADD_OP:
+    case type::TB_MUL_OP:
+    case type::TB_DIV_OP:
+    case type::TB_POW_OP: {
+      threadblock::STensor const &A = op->input_tensors[0];
+      threadblock::STensor const &B = op->input_tensors[1];
+      if (A.num_dims != num_dims || B.num_dims != num_dims) {
+        return fail();
+      }
+      FPType x =
+          get_stensor_fp(bgraph,
+                         A,
+                         block,
+                         forloop_idx,
+                         get_broadcast_idx(num_dims, tensor.dim, A.dim, idx));
+      FPType y =
+          get_stensor_fp(bgraph,
+                         B,
+                         block,
+                         forloop_idx,
+                         get_broadcast_idx(num_dims, tensor.dim, B.dim, idx));
+      fp = compute_binary_fp(get_elementwise_op_type(op->op_type), x, y);
+      break;
+    }
+    case type::TB_REDUCTION_0_OP:
+    case type::TB_REDUCTION_1_OP:
+    case type::TB_REDUCTION_2_OP:
+    case type::TB_REDUCTION_0_TO_DIMX_OP:
+    case type::TB_REDUCTION_1_TO_DIMX_OP:
+    case type::TB_REDUCTION_2_TO_DIMX_OP: {
+      threadblock::STensor const &input = op->input_tensors[0];
+      int reduction_dim = op->op_type >= type::TB_REDUCTION_0_TO_DIMX_OP
+                              ? op->op_type - type::TB_REDUCTION_0_TO_DIMX_OP
+                              : op->op_type - type::TB_REDUCTION_0_OP;
+      size_t reduction_degree = input.num_elements() / tensor.num_elements();
+      size_t inner_range = 1;
+      for (int i = reduction_dim; i < num_dims; i++) {
+        inner_range *= tensor.dim[i];
+      }
+      size_t pos = idx / inner_range * (inner_range * reduction_degree) +
+                   idx % inner_range;
+      for (size_t k = 0; k < reduction_degree && !failed; k++) {
+        fp = utils::compute_add_fingerprint(
+            fp,
+            get_stensor_fp(
+                bgraph, input, block, forloop_idx, pos + k * inner_range));
+      }
+      break;
+    }
+    case type::TB_RMS_NORM_OP: {
+      threadblock::STensor const &input = op->input_tensors[0];
+      size_t norm_size = tensor.dim[num_dims - 1];
+      size_t row_start = idx / norm_size * norm_size;
+      FPType rms = compute_rms_fp(norm_size, [&](size_t k) {
+        return get_stensor_fp(bgraph, input, block, forloop_idx, row_start + k);
+      });
+      fp = compute_div_fp(
+          get_stensor_fp(bgraph, input, block, forloop_idx, idx), rms);
+      break;
+    }
+    case type::TB_CONCAT_0_OP:
+    case type::TB_CONCAT_1_OP:
+    case type::TB_CONCAT_2_OP: {
+      threadblock::STensor const &A = op->input_tensors[0];
+      threadblock::STensor const &B = op->input_tensors[1];
+      int concat_dim = op->op_type - type::TB_CONCAT_0_OP;
+      size_t inner_size = 1;
+      for (int i = concat_dim + 1; i < num_dims; i++) {
+        inner_size *= tensor.dim[i];
+      }
+      size_t A_size = A.dim[concat_dim], B_size = B.dim[concat_dim];
+      size_t inner_idx = idx % inner_size;
+      size_t concat_dim_idx = idx / inner_size % (A_size + B_size);
+      size_t outer_idx = idx / inner_size / (A_size + B_size);
+      if (concat_dim_idx < A_size) {
+        fp = get_stensor_fp(bgraph,
+                            A,
+                            block,
+                            forloop_idx,
+                            inner_idx + concat_dim_idx * inner_size +
+                                outer_idx * inner_size * A_size);
+      } else {
+        fp = get_stensor_fp(bgraph,
+                            B,
+                            block,
+                            forloop_idx,
+                            inner_idx + (concat_dim_idx - A_size) * inner_size +
+                                outer_idx * inner_size * B_size);
+      }
+      break;
+    }
+    default:
+      return fail();
+  }
+  if (!failed) {
+    memo.emplace(key, fp);
+  }
+  return fp;
+}
+
+FPType
+    SampledFingerprinter::get_input_loader_fp(threadblock::Graph const &bgraph,
+                                              threadblock::TBInputOp const *op,
+                                              dim3 block,
+                                              int forloop_idx,
+                                              size_t idx) {
+  threadblock::STensor const &stensor = op->output_tensors[0];
+  kernel::DTensor const &dtensor = op->dtensor;
+  int num_dims = stensor.num_dims;
+  size_t num_columns = stensor.dim[num_dims - 1];
+  // The input loader only fills the tile formed by the last two dimensions
+  if (idx >= stensor.dim[num_dims - 2] * num_columns) {
+    return fail();
+  }
+  TileStrides strides(
+      dtensor, stensor, op->input_map, op->forloop_dim, bgraph.forloop_range);
+  int64_t row =
+      TileStrides::get_offset(
+          strides.row_block, strides.row_forloop, block, forloop_idx) +
+      idx / num_columns;
+  int64_t column =
+      TileStrides::get_offset(
+          strides.column_block, strides.column_forloop, block, forloop_idx) +
+      idx % num_columns;
+  int64_t dtensor_num_columns = dtensor.dim[num_dims - 1];
+  if (column >= dtensor_num_columns) {
+    return fail();
+  }
+  int64_t dtensor_idx =
+      TileStrides::get_offset(
+          strides.global_block, strides.global_forloop, block, forloop_idx) +
+      row * dtensor_num_columns + column;
+  if (dtensor_idx >= (int64_t)dtensor.num_elements()) {
+    return fail();
+  }
+  return get_dtensor_fp(dtensor, dtensor_idx);
+}
+
+FPType SampledFingerprinter::get_forloop_accum_fp(
+    threadblock::Graph const &bgraph,
+    threadblock::TBOperator const *op,
+    dim3 block,
+    size_t idx) {
+  threadblock::STensor const &input = op->input_tensors[0];
+  threadblock::STensor const &accum = op->output_tensors[0];
+  int forloop_range = bgraph.forloop_range;
+  FPType fp = 0;
+  if (op->op_type == type::TB_FORLOOP_ACCUM_NO_RED_OP) {
+    for (int i = 0; i < forloop_range && !failed; i++) {
+      fp = utils::compute_add_fingerprint(
+          fp, get_stensor_fp(bgraph, input, block, i, idx));
+    }
+    return fp;
+  }
+  size_t reduction_degree = input.num_elements() / accum.num_elements();
+  size_t inner_range = accum.dim[accum.num_dims - 1];
+  size_t pos =
+      idx / inner_range * (inner_range * reduction_degree) + idx % inner_range;
+  for (int i = 0; i < forloop_range && !failed; i++) {
+    for (size_t k = 0; k < reduction_degree && !failed; k++) {
+      FPType x = get_stensor_fp(bgraph, input, block, i, pos + k * inner_range);
+      if (op->op_type == type::TB_FORLOOP_ACCUM_RED_LD_RMS_OP) {
+        x = utils::compute_mul_fingerprint(x, x);
+      }
+      fp = utils::compute_add_fingerprint(fp, x);
+    }
+  }
+  if (op->op_type == type::TB_FORLOOP_ACCUM_RED_LD_MEAN_OP ||
+      op->op_type == type::TB_FORLOOP_ACCUM_RED_LD_RMS_OP) {
+    fp = compute_div_fp(fp, (forloop_range * reduction_degree) % FP_PQ);
+  }
+  if (op->op_type == type::TB_FORLOOP_ACCUM_RED_LD_RMS_OP) {
+    fp = compute_sqrt_fp(fp);
+  }
+  return fp;
+}
+
+bool SampledFingerprinter::is_supported(threadblock::Graph const &bgraph) {
+  auto it = supported_bgraphs.find(&bgraph);
+  if (it != supported_bgraphs.end()) {
+    return it->second;
+  }
+  bool supported = true;
+  std::unordered_map<type::GuidType, int> num_consumers;
+  for (threadblock::TBOperator const *op : bgraph.operators) {
+    for (threadblock::STensor const &tensor : op->input_tensors) {
+      num_consumers[tensor.guid]++;
+    }
+  }
+  for (threadblock::TBOperator const *op : bgraph.operators) {
+    if (op->op_type == type::TB_INPUT_OP &&
+        op->output_tensors[0].num_dims < 2) {
+      supported = false;
+    }
+    if (op->op_type == type::TB_OUTPUT_OP &&
+        op->input_tensors[0].num_dims < 2) {
+      supported = false;
+    }
+    // Element-wise unary operators run in place, so other consumers of
+    // their inputs may read either value depending on the operator order
+    if (get_elementwise_op_type(op->op_type) != type::KN_UNKOWN &&
+        op->input_tensors.size() == 1 &&
+        num_consumers[op->input_tensors[0].guid] > 1) {
+      supported = false;
+    }
+  }
+  supported_bgraphs.emplace(&bgraph, supported);
+  return supported;
+}
+
+} // namespace search
+} // namespace mirage
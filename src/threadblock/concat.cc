@@ -23,14 +23,14 @@ namespace threadblock {
 STensor Graph::concat(STensor const &A, STensor const &B, int concat_dim) {
   TBOperator *op = create_concat_op(A, B, concat_dim);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return op->output_tensors[0];
 }
 
 STensor *Graph::concat(STensor const *A, STensor const *B, int concat_dim) {
   TBOperator *op = create_concat_op(*A, *B, concat_dim);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return &op->output_tensors[0];
 }
 
@@ -65,7 +65,7 @@ STensor Graph::elementbinary(STensor const &input1,
                              mirage::type::TBOperatorType type) {
   TBOperator *op = create_elementbinary_op(input1, input2, type);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return op->output_tensors[0];
 }
 
@@ -74,7 +74,7 @@ STensor *Graph::elementbinary(STensor const *input1,
                               mirage::type::TBOperatorType type) {
   TBOperator *op = create_elementbinary_op(*input1, *input2, type);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return &op->output_tensors[0];
 }
 
@@ -89,7 +89,7 @@ STensor Graph::elementunary_clamp(STensor const &input,
                                   float const &max_val) {
   TBOperator *op = create_elementunary_clamp_op(input, min_val, max_val);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return op->output_tensors[0];
 }
 
@@ -98,7 +98,7 @@ STensor *Graph::elementunary_clamp(STensor const *input,
                                    float const &max_val) {
   TBOperator *op = create_elementunary_clamp_op(*input, min_val, max_val);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return &op->output_tensors[0];
 }
 
@@ -122,7 +122,7 @@ STensor Graph::elementunary(STensor const &input,
                             float const &scalar) {
   TBOperator *op = create_elementunary_op(input, type, scalar);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return op->output_tensors[0];
 }
 
@@ -131,7 +131,7 @@ STensor *Graph::elementunary(STensor const *input,
                              float const &scalar) {
   TBOperator *op = create_elementunary_op(*input, type);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return &op->output_tensors[0];
 }
 
@@ -24,7 +24,7 @@ STensor Graph::forloop_accum(STensor const &input,
                              mirage::type::TBOperatorType type) {
   TBOperator *op = create_forloop_accum_op(input, type);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return op->output_tensors[0];
 }
 
@@ -32,7 +32,7 @@ STensor *Graph::forloop_accum(STensor const *input,
                               mirage::type::TBOperatorType type) {
   TBOperator *op = create_forloop_accum_op(*input, type);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return &op->output_tensors[0];
 }
 
@@ -59,7 +59,7 @@ STensor Graph::forloop_accum_rescale(STensor const &input,
                                      mirage::type::TBOperatorType type) {
   TBOperator *op = create_forloop_accum_rescale_op(input, rescale, type);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return op->output_tensors[0];
 }
 
@@ -68,7 +68,7 @@ STensor *Graph::forloop_accum_rescale(STensor const *input,
                                       mirage::type::TBOperatorType type) {
   TBOperator *op = create_forloop_accum_rescale_op(*input, *rescale, type);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return &op->output_tensors[0];
 }
 
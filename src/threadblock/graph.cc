@@ -53,6 +53,19 @@ Graph::~Graph() {
   }
 }
 
+void Graph::add_operator(TBOperator *op) {
+  operators.push_back(op);
+  use_def.add_operator(op);
+}
+
+TBOperator *Graph::remove_last_operator() {
+  assert(!operators.empty());
+  TBOperator *op = operators.back();
+  use_def.remove_operator(op);
+  operators.pop_back();
+  return op;
+}
+
 size_t Graph::pair_hash::operator()(std::pair<int, int> const &p) const {
   size_t h1 = std::hash<int>{}(p.first);
   size_t h2 = std::hash<int>{}(p.second);
@@ -90,7 +103,7 @@ void Graph::free_fingerprint(std::vector<STensor> const &tensors) {
 size_t Graph::calculate_shared_memory_usage(TBOperator *new_op) {
   size_t usage = 0;
   if (new_op != nullptr) {
-    operators.push_back(new_op);
+    add_operator(new_op);
   }
 
   // currently use a simple heuristic to calculate shmem usage
@@ -209,7 +222,7 @@ size_t Graph::calculate_shared_memory_usage(TBOperator *new_op) {
   }
 
   if (new_op != nullptr) {
-    operators.pop_back();
+    remove_last_operator();
   }
   return usage;
 }
@@ -760,19 +773,17 @@ void from_json(json const &j, Graph &graph) {
   graph.block_dim = j.at("block_dim").get<dim3>();
   graph.forloop_range = j.at("forloop_range").get<int>();
   graph.reduction_dimx = j.at("reduction_dimx").get<int>();
-  graph.operators.clear();
+  while (!graph.operators.empty()) {
+    graph.remove_last_operator();
+  }
   graph.smem_offset = 0;
 
-  std::unordered_map<int, int> guid_mapping;
+  // from json guid to deserialized guid
+  std::unordered_map<int, type::GuidType> guid_mapping;
   auto get_tensor_from_guid = [&](int guid) {
-    for (auto const &op : graph.operators) {
-      for (auto const &tensor : op->output_tensors) {
-        if (guid_mapping.at(tensor.guid) == guid) {
-          return tensor;
-        }
-      }
-    }
-    assert(false);
+    STensor const *tensor = graph.use_def.get_tensor(guid_mapping.at(guid));
+    assert(tensor != nullptr);
+    return *tensor;
   };
 
   for (json const &op : j["operators"]) {
@@ -784,8 +795,8 @@ void from_json(json const &j, Graph &graph) {
                             op.at("input_map").get<int3>(),
                             op.at("forloop_dim").get<int>(),
                             layout::SmemRowMajor);
-        guid_mapping[output.guid] =
-            op.at("output_tensors")[0].at("guid").get<int>();
+        guid_mapping[op.at("output_tensors")[0].at("guid").get<int>()] =
+            output.guid;
         break;
       }
       case type::TBOperatorType::TB_OUTPUT_OP: {
@@ -802,8 +813,8 @@ void from_json(json const &j, Graph &graph) {
                              op.at("input_tensors")[0].at("guid").get<int>()),
                          get_tensor_from_guid(
                              op.at("input_tensors")[1].at("guid").get<int>()));
-        guid_mapping[output.guid] =
-            op.at("output_tensors")[0].at("guid").get<int>();
+        guid_mapping[op.at("output_tensors")[0].at("guid").get<int>()] =
+            output.guid;
         break;
       }
       case type::TBOperatorType::TB_EXP_OP:
@@ -818,15 +829,15 @@ void from_json(json const &j, Graph &graph) {
             get_tensor_from_guid(
                 op.at("input_tensors")[0].at("guid").get<int>()),
             op_type);
-        guid_mapping[output.guid] =
-            op.at("output_tensors")[0].at("guid").get<int>();
+        guid_mapping[op.at("output_tensors")[0].at("guid").get<int>()] =
+            output.guid;
         break;
       }
       case type::TBOperatorType::TB_RMS_NORM_OP: {
         STensor const &output = graph.rms_norm(get_tensor_from_guid(
             op.at("input_tensors")[0].at("guid").get<int>()));
-        guid_mapping[output.guid] =
-            op.at("output_tensors")[0].at("guid").get<int>();
+        guid_mapping[op.at("output_tensors")[0].at("guid").get<int>()] =
+            output.guid;
         break;
       }
       case type::TBOperatorType::TB_ADD_OP:
@@ -839,8 +850,8 @@ void from_json(json const &j, Graph &graph) {
             get_tensor_from_guid(
                 op.at("input_tensors")[1].at("guid").get<int>()),
             op_type);
-        guid_mapping[output.guid] =
-            op.at("output_tensors")[0].at("guid").get<int>();
+        guid_mapping[op.at("output_tensors")[0].at("guid").get<int>()] =
+            output.guid;
         break;
       }
       case type::TBOperatorType::TB_REDUCTION_0_OP:
@@ -851,8 +862,8 @@ void from_json(json const &j, Graph &graph) {
             get_tensor_from_guid(
                 op.at("input_tensors")[0].at("guid").get<int>()),
             dim);
-        guid_mapping[output.guid] =
-            op.at("output_tensors")[0].at("guid").get<int>();
+        guid_mapping[op.at("output_tensors")[0].at("guid").get<int>()] =
+            output.guid;
         break;
       }
       case type::TBOperatorType::TB_REDUCTION_0_TO_DIMX_OP:
@@ -863,8 +874,8 @@ void from_json(json const &j, Graph &graph) {
             get_tensor_from_guid(
                 op.at("input_tensors")[0].at("guid").get<int>()),
             dim);
-        guid_mapping[output.guid] =
-            op.at("output_tensors")[0].at("guid").get<int>();
+        guid_mapping[op.at("output_tensors")[0].at("guid").get<int>()] =
+            output.guid;
         break;
       }
       case type::TBOperatorType::TB_CONCAT_0_OP:
@@ -877,8 +888,8 @@ void from_json(json const &j, Graph &graph) {
                          get_tensor_from_guid(
                              op.at("input_tensors")[1].at("guid").get<int>()),
                          dim);
-        guid_mapping[output.guid] =
-            op.at("output_tensors")[0].at("guid").get<int>();
+        guid_mapping[op.at("output_tensors")[0].at("guid").get<int>()] =
+            output.guid;
         break;
       }
       case type::TBOperatorType::TB_FORLOOP_ACCUM_NO_RED_OP:
@@ -890,8 +901,8 @@ void from_json(json const &j, Graph &graph) {
             get_tensor_from_guid(
                 op.at("input_tensors")[0].at("guid").get<int>()),
             op_type);
-        guid_mapping[output.guid] =
-            op.at("output_tensors")[0].at("guid").get<int>();
+        guid_mapping[op.at("output_tensors")[0].at("guid").get<int>()] =
+            output.guid;
         break;
       }
       default:
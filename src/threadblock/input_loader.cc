@@ -27,7 +27,7 @@ STensor Graph::new_input(mirage::kernel::DTensor const &dtensor,
   TBOperator *op =
       create_input_op(dtensor, input_map, forloop_dim, layout, store_in_dmem);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return op->output_tensors[0];
 }
 
@@ -39,7 +39,7 @@ STensor *Graph::new_input(mirage::kernel::DTensor const *dtensor,
   TBOperator *op =
       create_input_op(*dtensor, input_map, forloop_dim, layout, store_in_dmem);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return &op->output_tensors[0];
 }
 
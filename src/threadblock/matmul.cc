@@ -23,14 +23,14 @@ namespace threadblock {
 STensor Graph::matmul(STensor const &A, STensor const &B) {
   TBOperator *op = create_matmul_op(A, B);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return op->output_tensors[0];
 }
 
 STensor *Graph::matmul(STensor const *A, STensor const *B) {
   TBOperator *op = create_matmul_op(*A, *B);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return &op->output_tensors[0];
 }
 
@@ -27,7 +27,7 @@ mirage::kernel::DTensor
   TBOperator *op =
       create_output_op(stensor, output_map, output_forloop_dim, epilogue);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return static_cast<TBOutputOp *>(op)->dtensor;
 }
 
@@ -39,7 +39,7 @@ mirage::kernel::DTensor *
   TBOperator *op =
       create_output_op(*stensor, output_map, output_forloop_dim, epilogue);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return &(static_cast<TBOutputOp *>(op)->dtensor);
 }
 
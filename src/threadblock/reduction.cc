@@ -23,14 +23,14 @@ namespace threadblock {
 STensor Graph::reduction(STensor const &input, int dim) {
   TBOperator *op = create_reduction_op(input, dim);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return op->output_tensors[0];
 }
 
 STensor *Graph::reduction(STensor const *input, int dim) {
   TBOperator *op = create_reduction_op(*input, dim);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return &op->output_tensors[0];
 }
 
@@ -49,7 +49,7 @@ TBOperator *Graph::create_reduction_op(STensor const &input, int dim) {
 STensor Graph::reduction_to_dimx(STensor const &input, int dim) {
   TBOperator *op = create_reduction_to_dimx_op(input, dim);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return op->output_tensors[0];
 }
 
@@ -77,14 +77,14 @@ TBOperator *Graph::create_reduction_to_dimx_op(STensor const &input, int dim) {
 std::vector<STensor> Graph::reduction_max(STensor const &input, int dim) {
   TBOperator *op = create_reduction_max_op(input, dim);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return op->output_tensors;
 }
 
 std::vector<STensor> *Graph::reduction_max(STensor const *input, int dim) {
   TBOperator *op = create_reduction_max_op(*input, dim);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return &op->output_tensors;
 }
 
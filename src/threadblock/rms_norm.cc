@@ -23,14 +23,14 @@ namespace threadblock {
 STensor Graph::rms_norm(STensor const &input) {
   TBOperator *op = create_rms_norm_op(input);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return op->output_tensors[0];
 }
 
 STensor *Graph::rms_norm(STensor const *input) {
   TBOperator *op = create_rms_norm_op(*input);
   assert(op != nullptr);
-  operators.push_back(op);
+  add_operator(op);
   return &op->output_tensors[0];
 }
 
@@ -0,0 +1,330 @@
+/* Copyright 2023-2024 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mirage/transpiler/autotune.h"
+#include "mirage/config.h"
+#include "mirage/kernel/customized.h"
+#include "mirage/transpiler/sched_tb_graph.h"
+#include "mirage/transpiler/transpile.h"
+#include "mirage/transpiler/utils.h"
+#include "mirage/utils/json_utils.h"
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <iostream>
+
+namespace mirage {
+namespace transpiler {
+
+using namespace mirage::type;
+
+// The cost of launching a kernel, in bytes of device memory traffic
+static constexpr float KERNEL_LAUNCH_COST = 64 * 1024;
+// The cost of a byte of shared memory traffic, relative to a byte of device
+// memory traffic
+static constexpr float SMEM_TRAFFIC_COST = 0.1f;
+static constexpr int MAX_PIPELINE_STAGES = 4;
+static constexpr int MAX_BLOCKS_PER_SM = 32;
+
+size_t get_shared_memory_capacity(int target_cc) {
+  switch (target_cc) {
+    case 80:
+      // A100 GPUs
+      return 163 * 1024;
+    case 86:
+    case 89:
+      // A5000 and A6000 GPUs
+      return 99 * 1024;
+    case 90:
+      // H100 GPUs
+      return 223 * 1024;
+    default:
+      return 48 * 1024;
+  }
+}
+
+// The Hopper transpiler maps every warp group but one to consumers, so a
+// block graph with a forloop must be launched with exactly
+// (num_consumer_wgs + num_producer_wgs) warp groups
+static bool is_valid_hopper_config(kernel::Graph const *g,
+                                   int num_consumer_wgs,
+                                   int num_producer_wgs) {
+  int num_wgs = num_consumer_wgs + num_producer_wgs;
+  if (num_wgs > config::MAX_NUM_WARP_GROUPS) {
+    return false;
+  }
+  for (kernel::KNOperator const *op : g->operators) {
+    if (op->op_type != KN_CUSTOMIZED_OP) {
+      continue;
+    }
+    tb::Graph const &bgraph =
+        static_cast<kernel::KNCustomizedOp const *>(op)->bgraph;
+    int num_threads =
+        bgraph.block_dim.x * bgraph.block_dim.y * bgraph.block_dim.z;
+    if (bgraph.forloop_range > 1 &&
+        num_threads != num_wgs * config::NUM_THREADS_PER_GROUP) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<TranspilerConfig>
+    Autotuner::enumerate_configs(kernel::Graph const *g,
+                                 TranspilerConfig const &base_config) {
+  std::vector<bool> online_softmax_options = {false};
+  kernel::Graph const *rewritten_graph = rewrite_graph_for_online_softmax(g);
+  if (rewritten_graph != g) {
+    online_softmax_options.push_back(true);
+    delete rewritten_graph;
+  }
+
+  std::vector<TranspilerConfig> configs;
+  for (bool enable_online_softmax : online_softmax_options) {
+    TranspilerConfig config = base_config;
+    config.enable_online_softmax = enable_online_softmax;
+    if (base_config.target_cc != GPU_CC::H100) {
+      // Warp group specialization and multi-stage pipelines are only used
+      // on Hopper
+      configs.push_back(config);
+      continue;
+    }
+    int num_producer_wgs = 1;
+    for (int num_consumer_wgs = 1;
+         num_consumer_wgs + num_producer_wgs <= config::MAX_NUM_WARP_GROUPS;
+         num_consumer_wgs++) {
+      if (!is_valid_hopper_config(g, num_consumer_wgs, num_producer_wgs)) {
+        continue;
+      }
+      for (int stages = 1; stages <= MAX_PIPELINE_STAGES; stages++) {
+        config.num_consumer_wgs = num_consumer_wgs;
+        config.num_producer_wgs = num_producer_wgs;
+        config.pipeline_stages = stages;
+        configs.push_back(config);
+      }
+    }
+  }
+  return configs;
+}
+
+std::vector<AutotuneCandidate> Autotuner::get_candidates(
+    kernel::Graph const *g,
+    TranspilerConfig const &base_config,
+    std::vector<std::vector<size_t>> const &input_strides) {
+  size_t smem_capacity = get_shared_memory_capacity(base_config.target_cc);
+  std::vector<AutotuneCandidate> candidates;
+  for (TranspilerConfig const &config : enumerate_configs(g, base_config)) {
+    TranspileResult result = transpile(g, config, input_strides);
+    if (result.error_type != CUDA_T_SUCCESS ||
+        result.max_smem_size > smem_capacity) {
+      continue;
+    }
+    float cost = estimate_cost(g, config, result);
+    candidates.push_back(AutotuneCandidate{config, result, cost, -1.0f});
+  }
+  std::stable_sort(candidates.begin(),
+                   candidates.end(),
+                   [](AutotuneCandidate const &a, AutotuneCandidate const &b) {
+                     return a.predicted_cost < b.predicted_cost;
+                   });
+  return candidates;
+}
+
+// A roofline-style estimate in bytes of device memory traffic. Each block
+// loads its forloop tiles once per iteration; exposed load latency shrinks
+// with deeper pipelines, and the number of resident blocks per SM is bounded
+// by the shared memory each block needs. Accumulators that the schedule
+// places in shared memory are read and written once per iteration
+float Autotuner::estimate_cost(kernel::Graph const *g,
+                               TranspilerConfig const &config,
+                               TranspileResult const &result) {
+  kernel::Graph const *graph =
+      config.enable_online_softmax ? rewrite_graph_for_online_softmax(g) : g;
+  size_t smem_capacity = get_shared_memory_capacity(config.target_cc);
+  float blocks_per_sm =
+      std::min((float)MAX_BLOCKS_PER_SM,
+               std::max(1.0f,
+                        (float)(smem_capacity /
+                                std::max(result.max_smem_size, (size_t)1))));
+  float latency_factor = config.target_cc == GPU_CC::H100
+                             ? 1.0f + 1.0f / config.pipeline_stages
+                             : 1.5f; // double buffering
+  float cost = 0.0f;
+  for (kernel::KNOperator const *op : graph->operators) {
+    if (op->op_type == KN_INPUT_OP || op->op_type == KN_OUTPUT_OP) {
+      continue;
+    }
+    cost += KERNEL_LAUNCH_COST;
+    if (op->op_type != KN_CUSTOMIZED_OP) {
+      for (kernel::DTensor const &t : op->input_tensors) {
+        cost += t.data_size();
+      }
+      for (kernel::DTensor const &t : op->output_tensors) {
+        cost += t.data_size();
+      }
+      continue;
+    }
+    tb::Graph const &bgraph =
+        static_cast<kernel::KNCustomizedOp const *>(op)->bgraph;
+    float per_iter = 0.0f, per_block = 0.0f;
+    for (auto const &[bop, in_reg] : get_accum_in_reg(bgraph)) {
+      if (!in_reg) {
+        per_block += bgraph.forloop_range * 2 * bop->output_tensors[0].size() *
+                     SMEM_TRAFFIC_COST;
+      }
+    }
+    for (tb::TBOperator const *bop : bgraph.operators) {
+      if (bop->op_type == TB_INPUT_OP) {
+        tb::TBInputOp const *input_op = static_cast<tb::TBInputOp const *>(bop);
+        if (input_op->forloop_dim >= 0) {
+          per_iter += bop->output_tensors[0].size();
+        } else {
+          per_block += bop->output_tensors[0].size();
+        }
+      } else if (bop->op_type == TB_OUTPUT_OP) {
+        per_block += bop->input_tensors[0].size();
+      }
+    }
+    per_block += bgraph.forloop_range * per_iter * latency_factor;
+    float num_blocks =
+        bgraph.grid_dim.x * bgraph.grid_dim.y * bgraph.grid_dim.z;
+    cost += num_blocks * per_block / blocks_per_sm;
+  }
+  if (graph != g) {
+    delete graph;
+  }
+  return cost;
+}
+
+Autotuner::Autotuner(std::string const &_table_path) : table_path(_table_path) {
+  load();
+}
+
+TranspilerConfig
+    Autotuner::tune(kernel::Graph const *g,
+                    TranspilerConfig const &base_config,
+                    std::vector<std::vector<size_t>> const &input_strides,
+                    AutotuneExecutor *executor,
+                    int num_profiled) {
+  AutotuneKey key(
+      g->get_owner_independent_hash(), base_config.target_cc, input_strides);
+  TranspilerConfig config = base_config;
+  AutotuneRecord record;
+  if (lookup(key, record)) {
+    config.num_consumer_wgs = record.num_consumer_wgs;
+    config.num_producer_wgs = record.num_producer_wgs;
+    config.pipeline_stages = record.pipeline_stages;
+    config.enable_online_softmax = record.enable_online_softmax;
+    return config;
+  }
+
+  std::vector<AutotuneCandidate> candidates =
+      get_candidates(g, base_config, input_strides);
+  if (candidates.empty()) {
+    return base_config;
+  }
+  AutotuneCandidate const *best = &candidates[0];
+  float best_ms = -1.0f;
+  if (executor != nullptr) {
+    int num_candidates = std::min((int)candidates.size(), num_profiled);
+    for (int i = 0; i < num_candidates; i++) {
+      candidates[i].measured_ms = executor->profile(candidates[i]);
+      if (candidates[i].measured_ms >= 0 &&
+          (best_ms < 0 || candidates[i].measured_ms < best_ms)) {
+        best_ms = candidates[i].measured_ms;
+        best = &candidates[i];
+      }
+    }
+  }
+  config = best->config;
+  update(key,
+         AutotuneRecord{config.num_consumer_wgs,
+                        config.num_producer_wgs,
+                        config.pipeline_stages,
+                        config.enable_online_softmax,
+                        best->predicted_cost,
+                        best_ms});
+  return config;
+}
+
+bool Autotuner::lookup(AutotuneKey const &key, AutotuneRecord &record) const {
+  auto it = table.find(key);
+  if (it == table.end()) {
+    return false;
+  }
+  record = it->second;
+  return true;
+}
+
+void Autotuner::update(AutotuneKey const &key, AutotuneRecord const &record) {
+  table[key] = record;
+  save();
+}
+
+void Autotuner::load() {
+  if (table_path.empty()) {
+    return;
+  }
+  std::ifstream ifs(table_path);
+  if (!ifs.good()) {
+    // The table is created on the first update
+    return;
+  }
+  json j;
+  ifs >> j;
+  for (json const &entry : j) {
+    AutotuneRecord record;
+    entry.at("num_consumer_wgs").get_to(record.num_consumer_wgs);
+    entry.at("num_producer_wgs").get_to(record.num_producer_wgs);
+    entry.at("pipeline_stages").get_to(record.pipeline_stages);
+    entry.at("enable_online_softmax").get_to(record.enable_online_softmax);
+    entry.at("predicted_cost").get_to(record.predicted_cost);
+    entry.at("measured_ms").get_to(record.measured_ms);
+    table[AutotuneKey(
+        entry.at("graph_hash").get<size_t>(),
+        entry.at("target_cc").get<int>(),
+        entry.at("input_strides").get<std::vector<std::vector<size_t>>>())] =
+        record;
+  }
+}
+
+void Autotuner::save() const {
+  if (table_path.empty()) {
+    return;
+  }
+  json j = json::array();
+  for (auto const &[key, record] : table) {
+    j.push_back({{"graph_hash", std::get<0>(key)},
+                 {"target_cc", std::get<1>(key)},
+                 {"input_strides", std::get<2>(key)},
+                 {"num_consumer_wgs", record.num_consumer_wgs},
+                 {"num_producer_wgs", record.num_producer_wgs},
+                 {"pipeline_stages", record.pipeline_stages},
+                 {"enable_online_softmax", record.enable_online_softmax},
+                 {"predicted_cost", record.predicted_cost},
+                 {"measured_ms", record.measured_ms}});
+  }
+  std::ofstream ofs(table_path);
+  if (!ofs.good()) {
+    std::cerr << "Failed to write the autotuning table to " << table_path
+              << std::endl;
+    return;
+  }
+  ofs << j.dump(2);
+}
+
+} // namespace transpiler
+} // namespace mirage
@@ -0,0 +1,674 @@
+/* Copyright 2023-2024 CMU
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mirage/transpiler/kn_fusion.h"
+#include "mirage/config.h"
+#include "mirage/kernel/customized.h"
+#include "mirage/kernel/element_unary.h"
+#include "mirage/kernel/operator.h"
+#include "mirage/threadblock/concat.h"
+#include "mirage/threadblock/element_unary.h"
+#include "mirage/threadblock/operator.h"
+#include "mirage/transpiler/autotune.h"
+#include "mirage/transpiler/transpile.h"
+#include "mirage/transpiler/utils.h"
+#include <cassert>
+#include <limits>
+#include <unordered_map>
+
+namespace mirage {
+namespace transpiler {
+
+using namespace mirage::type;
+
+size_t KNFusionReport::total_dmem_bytes_saved() const {
+  size_t total = 0;
+  for (KNFusionRecord const &record : records) {
+    total += record.dmem_bytes_saved;
+  }
+  return total;
+}
+
+std::string KNFusionReport::to_string() const {
+  CodeKeeper res;
+  for (KNFusionRecord const &record : records) {
+    res.e(FMT_STR("op $ -> op $ ($): $ bytes saved"),
+          record.producer_idx,
+          record.consumer_idx,
+          record.is_epilogue ? "epilogue" : "prologue",
+          record.dmem_bytes_saved);
+  }
+  res.e(FMT_STR("total: $ fused pairs, $ bytes saved"),
+        records.size(),
+        total_dmem_bytes_saved());
+  return res.to_string();
+}
+
+namespace {
+
+bool is_tb_op_replayable(tb::TBOperator const *bop) {
+  switch (bop->op_type) {
+    case TB_INPUT_OP:
+    case TB_OUTPUT_OP:
+    case TB_MATMUL_OP:
+    case TB_EXP_OP:
+    case TB_SQUARE_OP:
+    case TB_SQRT_OP:
+    case TB_MUL_SCALAR_OP:
+    case TB_SILU_OP:
+    case TB_SIGMOID_OP:
+    case TB_GELU_OP:
+    case TB_RELU_OP:
+    case TB_CLAMP_OP:
+    case TB_LOG_OP:
+    case TB_ADD_OP:
+    case TB_MUL_OP:
+    case TB_DIV_OP:
+    case TB_SUB_OP:
+    case TB_POW_OP:
+    case TB_REDUCTION_0_OP:
+    case TB_REDUCTION_1_OP:
+    case TB_REDUCTION_2_OP:
+    case TB_REDUCTION_0_TO_DIMX_OP:
+    case TB_REDUCTION_1_TO_DIMX_OP:
+    case TB_REDUCTION_2_TO_DIMX_OP:
+    case TB_REDUCTION_0_MAX_OP:
+    case TB_REDUCTION_1_MAX_OP:
+    case TB_REDUCTION_2_MAX_OP:
+    case TB_RMS_NORM_OP:
+    case TB_CONCAT_0_OP:
+    case TB_CONCAT_1_OP:
+    case TB_CONCAT_2_OP:
+    case TB_FORLOOP_ACCUM_NO_RED_OP:
+    case TB_FORLOOP_ACCUM_RED_LD_SUM_OP:
+    case TB_FORLOOP_ACCUM_RED_LD_MEAN_OP:
+    case TB_FORLOOP_ACCUM_RED_LD_RMS_OP:
+    case TB_FORLOOP_ACCUM_REDTOX_LD_SUM_OP:
+    case TB_FORLOOP_ACCUM_NO_RED_RESCALE_OP:
+    case TB_FORLOOP_ACCUM_RED_LD_SUM_RESCALE_OP:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Replay a threadblock operator (other than input and output) into tbg
+std::vector<tb::STensor> replay_tb_op(tb::Graph &tbg,
+                                      tb::TBOperator const *bop,
+                                      std::vector<tb::STensor> const &inputs) {
+  switch (bop->op_type) {
+    case TB_MATMUL_OP:
+      return {tbg.matmul(inputs[0], inputs[1])};
+    case TB_CLAMP_OP: {
+      tb::TBClampUnaryOp const *clamp =
+          static_cast<tb::TBClampUnaryOp const *>(bop);
+      return {
+          tbg.elementunary_clamp(inputs[0], clamp->min_val, clamp->max_val)};
+    }
+    case TB_EXP_OP:
+    case TB_SQUARE_OP:
+    case TB_SQRT_OP:
+    case TB_MUL_SCALAR_OP:
+    case TB_SILU_OP:
+    case TB_SIGMOID_OP:
+    case TB_GELU_OP:
+    case TB_RELU_OP:
+    case TB_LOG_OP: {
+      tb::TBElementUnaryOp const *unary =
+          static_cast<tb::TBElementUnaryOp const *>(bop);
+      return {tbg.elementunary(inputs[0], bop->op_type, unary->scalar)};
+    }
+    case TB_ADD_OP:
+    case TB_MUL_OP:
+    case TB_DIV_OP:
+    case TB_SUB_OP:
+    case TB_POW_OP:
+      return {tbg.elementbinary(inputs[0], inputs[1], bop->op_type)};
+    case TB_REDUCTION_0_OP:
+    case TB_REDUCTION_1_OP:
+    case TB_REDUCTION_2_OP:
+      return {tbg.reduction(inputs[0], bop->op_type - TB_REDUCTION_0_OP)};
+    case TB_REDUCTION_0_TO_DIMX_OP:
+    case TB_REDUCTION_1_TO_DIMX_OP:
+    case TB_REDUCTION_2_TO_DIMX_OP:
+      return {tbg.reduction_to_dimx(inputs[0],
+                                    bop->op_type - TB_REDUCTION_0_TO_DIMX_OP)};
+    case TB_REDUCTION_0_MAX_OP:
+    case TB_REDUCTION_1_MAX_OP:
+    case TB_REDUCTION_2_MAX_OP:
+      return tbg.reduction_max(inputs[0], bop->op_type - TB_REDUCTION_0_MAX_OP);
+    case TB_RMS_NORM_OP:
+      return {tbg.rms_norm(inputs[0])};
+    case TB_CONCAT_0_OP:
+    case TB_CONCAT_1_OP:
+    case TB_CONCAT_2_OP: {
+      tb::TBConcatOp const *concat = static_cast<tb::TBConcatOp const *>(bop);
+      return {tbg.concat(inputs[0], inputs[1], concat->concat_dim)};
+    }
+    case TB_FORLOOP_ACCUM_NO_RED_OP:
+    case TB_FORLOOP_ACCUM_RED_LD_SUM_OP:
+    case TB_FORLOOP_ACCUM_RED_LD_MEAN_OP:
+    case TB_FORLOOP_ACCUM_RED_LD_RMS_OP:
+    case TB_FORLOOP_ACCUM_REDTOX_LD_SUM_OP:
+      return {tbg.forloop_accum(inputs[0], bop->op_type)};
+    case TB_FORLOOP_ACCUM_NO_RED_RESCALE_OP:
+    case TB_FORLOOP_ACCUM_RED_LD_SUM_RESCALE_OP:
+      return {tbg.forloop_accum_rescale(inputs[0], inputs[1], bop->op_type)};
+    default:
+      assert(false && "Unsupported tb operator");
+  }
+  return {};
+}
+
+// With forloop_range == 1 a forloop accumulator reduces over a single
+// iteration, so it can be replaced by the equivalent non-accumulating ops
+// (the same decomposition the Transpiler applies). Returns false for
+// accumulators that carry state across iterations
+bool lower_single_iteration_accum(tb::Graph &tbg,
+                                  tb::TBOperator const *bop,
+                                  tb::STensor const &input,
+                                  tb::STensor &output) {
+  int last_dim = input.num_dims - 1;
+  switch (bop->op_type) {
+    case TB_FORLOOP_ACCUM_NO_RED_OP: {
+      output = input;
+      return true;
+    }
+    case TB_FORLOOP_ACCUM_RED_LD_SUM_OP: {
+      output = tbg.reduction(input, last_dim);
+      return true;
+    }
+    case TB_FORLOOP_ACCUM_REDTOX_LD_SUM_OP: {
+      output = tbg.reduction_to_dimx(input, last_dim);
+      return true;
+    }
+    case TB_FORLOOP_ACCUM_RED_LD_MEAN_OP: {
+      tb::STensor st = tbg.reduction(input, last_dim);
+      output = tbg.mul_scalar(st, 1.0f / input.dim[last_dim]);
+      return true;
+    }
+    case TB_FORLOOP_ACCUM_RED_LD_RMS_OP: {
+      tb::STensor st = tbg.square(input);
+      st = tbg.reduction(st, last_dim);
+      st = tbg.mul_scalar(st, 1.0f / input.dim[last_dim]);
+      output = tbg.sqrt(st);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+bool is_forloop_accum(tb::TBOperator const *bop) {
+  return bop->op_type >= TB_FORLOOP_ACCUM_FIRST_OP &&
+         bop->op_type < TB_FORLOOP_ACCUM_LAST_OP;
+}
+
+// Grid dims of size 1 do not partition a tensor, so their map entries are
+// irrelevant when comparing maps
+int3 normalize_map(int3 map, dim3 grid_dim) {
+  return {grid_dim.x > 1 ? map.x : -1,
+          grid_dim.y > 1 ? map.y : -1,
+          grid_dim.z > 1 ? map.z : -1};
+}
+
+bool same_dim3(dim3 a, dim3 b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+struct FusionCandidate {
+  kn::KNCustomizedOp *producer, *consumer;
+  int producer_idx, consumer_idx;
+  kn::DTensor intermediate;
+  bool is_epilogue;
+  size_t dmem_bytes_saved;
+};
+
+// Check whether producer -> consumer through `intermediate` can be fused
+bool check_fusion(kn::KNCustomizedOp *producer,
+                  kn::KNCustomizedOp *consumer,
+                  kn::DTensor const &intermediate,
+                  int num_consumers,
+                  FusionCandidate &candidate) {
+  tb::Graph &pg = producer->bgraph;
+  tb::Graph &cg = consumer->bgraph;
+  if (num_consumers != 1 || producer->output_tensors.size() != 1 ||
+      !same_dim3(pg.grid_dim, cg.grid_dim) ||
+      !same_dim3(pg.block_dim, cg.block_dim) ||
+      pg.reduction_dimx != cg.reduction_dimx) {
+    return false;
+  }
+  bool is_epilogue = pg.forloop_range > 1;
+  if (is_epilogue &&
+      (cg.forloop_range != 1 || consumer->input_tensors.size() != 1)) {
+    return false;
+  }
+  tb::TBOutputOp const *output_op = nullptr;
+  for (tb::TBOperator const *bop : pg.operators) {
+    if (!is_tb_op_replayable(bop)) {
+      return false;
+    }
+    if (bop->op_type == TB_OUTPUT_OP) {
+      output_op = static_cast<tb::TBOutputOp const *>(bop);
+    }
+    // A prologue's accumulators are lowered to non-accumulating ops
+    if (!is_epilogue &&
+        (bop->op_type == TB_FORLOOP_ACCUM_NO_RED_RESCALE_OP ||
+         bop->op_type == TB_FORLOOP_ACCUM_RED_LD_SUM_RESCALE_OP)) {
+      return false;
+    }
+  }
+  assert(output_op != nullptr);
+  if (output_op->forloop_dim != -1 || output_op->epilogue != TB_EPILOGUE_NONE) {
+    return false;
+  }
+  tb::TBInputOp const *input_op = nullptr;
+  size_t input_idx = 0;
+  for (tb::TBOperator const *bop : cg.operators) {
+    if (!is_tb_op_replayable(bop)) {
+      return false;
+    }
+    if (bop->op_type == TB_INPUT_OP) {
+      if (consumer->input_tensors[input_idx].guid == intermediate.guid) {
+        input_op = static_cast<tb::TBInputOp const *>(bop);
+      }
+      input_idx++;
+    }
+    if (is_epilogue &&
+        (bop->op_type == TB_FORLOOP_ACCUM_NO_RED_RESCALE_OP ||
+         bop->op_type == TB_FORLOOP_ACCUM_RED_LD_SUM_RESCALE_OP)) {
+      return false;
+    }
+  }
+  assert(input_op != nullptr);
+  // The consumer must read exactly the tile each block produced
+  int3 omap = normalize_map(output_op->output_map, pg.grid_dim);
+  int3 imap = normalize_map(input_op->input_map, cg.grid_dim);
+  if (omap.x != imap.x || omap.y != imap.y || omap.z != imap.z) {
+    return false;
+  }
+  if (cg.forloop_range > 1 && input_op->forloop_dim != -1) {
+    return false;
+  }
+  tb::STensor const &produced = output_op->input_tensors[0];
+  tb::STensor const &consumed = input_op->output_tensors[0];
+  if (produced.num_dims != consumed.num_dims) {
+    return false;
+  }
+  for (int i = 0; i < produced.num_dims; i++) {
+    if (produced.dim[i] != consumed.dim[i]) {
+      return false;
+    }
+  }
+  // The threadblock graph builder rejects operators past its own shared
+  // memory heuristic, which is additive over operators, so the sum over both
+  // graphs guarantees that the fused graph can be built. Whether it fits the
+  // target is checked on the transpiler's memory plan (get_fused_smem_size)
+  if (pg.calculate_shared_memory_usage(nullptr) +
+          cg.calculate_shared_memory_usage(nullptr) >
+      mirage::config::MAX_SMEM_SIZE) {
+    return false;
+  }
+  // A prologue is recomputed in every iteration of the consumer's forloop
+  size_t saved = 2 * intermediate.data_size();
+  size_t extra = 0;
+  if (!is_epilogue && cg.forloop_range > 1) {
+    size_t num_blocks = (size_t)pg.grid_dim.x * pg.grid_dim.y * pg.grid_dim.z;
+    for (tb::TBOperator const *bop : pg.operators) {
+      if (bop->op_type == TB_INPUT_OP) {
+        extra +=
+            (cg.forloop_range - 1) * num_blocks * bop->output_tensors[0].size();
+      }
+    }
+  }
+  if (saved <= extra) {
+    return false;
+  }
+  candidate.is_epilogue = is_epilogue;
+  candidate.dmem_bytes_saved = saved - extra;
+  return true;
+}
+
+// Replay all operators of `src` into `tbg`. `producer_output` is the STensor
+// standing for the intermediate DTensor: it is filled in when replaying the
+// producer and consumed when replaying the consumer
+void replay_tb_graph(tb::Graph &tbg,
+                     tb::Graph const &src,
+                     std::vector<kn::DTensor> const &src_inputs,
+                     std::unordered_map<dguid_t, kn::DTensor> &dtensor_mapping,
+                     std::vector<kn::DTensor> &merged_inputs,
+                     bool lower_accums,
+                     bool is_producer,
+                     dguid_t intermediate_guid,
+                     tb::STensor &producer_output) {
+  std::unordered_map<sguid_t, tb::STensor> stensor_mapping;
+  size_t input_idx = 0;
+  for (tb::TBOperator const *bop : src.operators) {
+    std::vector<tb::STensor> inputs;
+    for (tb::STensor const &t : bop->input_tensors) {
+      assert(stensor_mapping.find(t.guid) != stensor_mapping.end());
+      inputs.push_back(stensor_mapping.at(t.guid));
+    }
+    if (bop->op_type == TB_INPUT_OP) {
+      tb::TBInputOp const *input_op = static_cast<tb::TBInputOp const *>(bop);
+      kn::DTensor const &dtensor = src_inputs[input_idx++];
+      if (!is_producer && dtensor.guid == intermediate_guid) {
+        stensor_mapping[bop->output_tensors[0].guid] = producer_output;
+        continue;
+      }
+      kn::DTensor const &new_dtensor = dtensor_mapping.at(dtensor.guid);
+      merged_inputs.push_back(new_dtensor);
+      stensor_mapping[bop->output_tensors[0].guid] =
+          tbg.new_input(new_dtensor,
+                        input_op->input_map,
+                        lower_accums ? -1 : input_op->forloop_dim,
+                        input_op->output_tensors[0].layout,
+                        input_op->output_tensors[0].store_in_dmem);
+    } else if (bop->op_type == TB_OUTPUT_OP) {
+      if (is_producer) {
+        producer_output = inputs[0];
+        continue;
+      }
+      tb::TBOutputOp const *output_op =
+          static_cast<tb::TBOutputOp const *>(bop);
+      tbg.mark_output(inputs[0],
+                      output_op->output_map,
+                      output_op->forloop_dim,
+                      output_op->epilogue);
+    } else if (lower_accums && is_forloop_accum(bop)) {
+      tb::STensor st;
+      bool lowered = lower_single_iteration_accum(tbg, bop, inputs[0], st);
+      assert(lowered);
+      stensor_mapping[bop->output_tensors[0].guid] = st;
+    } else {
+      std::vector<tb::STensor> outputs = replay_tb_op(tbg, bop, inputs);
+      assert(outputs.size() == bop->output_tensors.size());
+      for (size_t i = 0; i < outputs.size(); i++) {
+        stensor_mapping[bop->output_tensors[i].guid] = outputs[i];
+      }
+    }
+  }
+}
+
+// Replay the producer and the consumer of `c` into one threadblock graph,
+// whose inputs are mapped through `dtensor_mapping` into `merged_inputs`
+std::shared_ptr<tb::Graph> build_fused_tb_graph(
+    FusionCandidate const &c,
+    std::unordered_map<dguid_t, kn::DTensor> &dtensor_mapping,
+    std::vector<kn::DTensor> &merged_inputs) {
+  tb::Graph const &pg = c.producer->bgraph;
+  tb::Graph const &cg = c.consumer->bgraph;
+  std::shared_ptr<tb::Graph> tbg = std::make_shared<tb::Graph>(
+      pg.grid_dim,
+      pg.block_dim,
+      c.is_epilogue ? pg.forloop_range : cg.forloop_range,
+      pg.reduction_dimx);
+  tb::STensor producer_output;
+  replay_tb_graph(*tbg,
+                  pg,
+                  c.producer->input_tensors,
+                  dtensor_mapping,
+                  merged_inputs,
+                  !c.is_epilogue /*lower_accums*/,
+                  true /*is_producer*/,
+                  c.intermediate.guid,
+                  producer_output);
+  replay_tb_graph(*tbg,
+                  cg,
+                  c.consumer->input_tensors,
+                  dtensor_mapping,
+                  merged_inputs,
+                  c.is_epilogue /*lower_accums*/,
+                  false /*is_producer*/,
+                  c.intermediate.guid,
+                  producer_output);
+  return tbg;
+}
+
+std::vector<size_t> get_row_major_strides(kn::DTensor const &t) {
+  std::vector<size_t> strides(t.num_dims);
+  size_t stride = 1;
+  for (int i = t.num_dims - 1; i >= 0; i--) {
+    strides[i] = stride;
+    stride *= t.dim[i];
+  }
+  return strides;
+}
+
+// Shared memory of the fused threadblock graph, as planned by the
+// transpiler for a kernel graph with the fused operator alone. Returns
+// SIZE_MAX if the fused operator cannot be transpiled
+size_t get_fused_smem_size(FusionCandidate const &c,
+                           kernel::Graph const *g,
+                           TranspilerConfig const &config) {
+  kernel::Graph trial(g->gpu_dim);
+  std::unordered_map<dguid_t, kn::DTensor> dtensor_mapping;
+  std::vector<std::vector<size_t>> input_strides;
+  for (kn::KNCustomizedOp const *op : {c.producer, c.consumer}) {
+    for (kn::DTensor const &t : op->input_tensors) {
+      if (t.guid == c.intermediate.guid ||
+          dtensor_mapping.find(t.guid) != dtensor_mapping.end()) {
+        continue;
+      }
+      // Graph inputs keep their strides; intermediates are contiguous
+      std::vector<size_t> strides =
+          t.owner_op->op_type == KN_INPUT_OP
+              ? static_cast<kn::KNInputOp const *>(t.owner_op)->input_strides
+              : get_row_major_strides(t);
+      std::vector<int> dims(t.dim, t.dim + t.num_dims);
+      dtensor_mapping[t.guid] =
+          trial.new_input(dims, strides, t.data_type, t.layout);
+      input_strides.push_back(strides);
+    }
+  }
+  std::vector<kn::DTensor> merged_inputs;
+  std::shared_ptr<tb::Graph> tbg =
+      build_fused_tb_graph(c, dtensor_mapping, merged_inputs);
+  for (kn::DTensor const &t : trial.customized(merged_inputs, *tbg)) {
+    trial.mark_output(t, get_row_major_strides(t));
+  }
+  // Earlier rewrites have already been applied to `g`
+  TranspilerConfig trial_config = config;
+  trial_config.profiling = false;
+  trial_config.enable_online_softmax = false;
+  trial_config.enable_cuda_graph = false;
+  trial_config.enable_kn_fusion = false;
+  TranspileResult result = transpile(&trial, trial_config, input_strides);
+  if (result.error_type != CUDA_T_SUCCESS) {
+    return std::numeric_limits<size_t>::max();
+  }
+  return result.max_smem_size;
+}
+
+} // namespace
+
+kernel::Graph const *rewrite_graph_for_kn_fusion(kernel::Graph const *g,
+                                                 TranspilerConfig const &config,
+                                                 KNFusionReport &report) {
+  size_t smem_capacity = get_shared_memory_capacity(config.target_cc);
+  // Count the consumers of every DTensor, including graph outputs
+  std::unordered_map<dguid_t, int> num_consumers;
+  for (kn::KNOperator const *op : g->operators) {
+    for (kn::DTensor const &t : op->input_tensors) {
+      num_consumers[t.guid]++;
+    }
+  }
+  std::unordered_map<kn::KNOperator const *, int> op_idx;
+  for (size_t i = 0; i < g->operators.size(); i++) {
+    op_idx[g->operators[i]] = (int)i;
+  }
+
+  // Greedily pick producer/consumer pairs. Each operator takes part in at
+  // most one fusion per pass
+  std::unordered_map<kn::KNOperator const *, FusionCandidate> by_consumer;
+  std::unordered_map<kn::KNOperator const *, bool> is_fused;
+  for (kn::KNOperator *op : g->operators) {
+    switch (op->op_type) {
+      case KN_INPUT_OP:
+      case KN_OUTPUT_OP:
+      case KN_MATMUL_OP:
+      case KN_EXP_OP:
+      case KN_SQUARE_OP:
+      case KN_SQRT_OP:
+      case KN_SILU_OP:
+      case KN_GELU_OP:
+      case KN_RELU_OP:
+      case KN_CLAMP_OP:
+      case KN_ADD_OP:
+      case KN_MUL_OP:
+      case KN_DIV_OP:
+      case KN_POW_OP:
+      case KN_CUSTOMIZED_OP:
+        break;
+      default:
+        // The graph cannot be rebuilt
+        return g;
+    }
+    if (op->op_type != KN_CUSTOMIZED_OP || is_fused[op]) {
+      continue;
+    }
+    kn::KNCustomizedOp *consumer = static_cast<kn::KNCustomizedOp *>(op);
+    for (kn::DTensor const &t : consumer->input_tensors) {
+      kn::KNOperator *owner = t.owner_op;
+      if (owner->op_type != KN_CUSTOMIZED_OP || is_fused[owner]) {
+        continue;
+      }
+      FusionCandidate candidate;
+      if (check_fusion(static_cast<kn::KNCustomizedOp *>(owner),
+                       consumer,
+                       t,
+                       num_consumers[t.guid],
+                       candidate)) {
+        candidate.producer = static_cast<kn::KNCustomizedOp *>(owner);
+        candidate.consumer = consumer;
+        candidate.producer_idx = op_idx.at(owner);
+        candidate.consumer_idx = op_idx.at(consumer);
+        candidate.intermediate = t;
+        if (get_fused_smem_size(candidate, g, config) > smem_capacity) {
+          continue;
+        }
+        by_consumer[consumer] = candidate;
+        is_fused[owner] = true;
+        is_fused[consumer] = true;
+        break;
+      }
+    }
+  }
+  if (by_consumer.empty()) {
+    return g;
+  }
+
+  kernel::Graph *new_g = new kernel::Graph(g->gpu_dim);
+  std::unordered_map<dguid_t, kn::DTensor> dtensor_mapping;
+  for (kn::KNOperator *op : g->operators) {
+    std::vector<kn::DTensor> inputs;
+    for (kn::DTensor const &t : op->input_tensors) {
+      if (dtensor_mapping.find(t.guid) != dtensor_mapping.end()) {
+        inputs.push_back(dtensor_mapping.at(t.guid));
+      }
+    }
+    switch (op->op_type) {
+      case KN_INPUT_OP: {
+        kn::KNInputOp *input_op = static_cast<kn::KNInputOp *>(op);
+        kn::DTensor const &dtensor = op->output_tensors[0];
+        std::vector<int> dims(dtensor.dim, dtensor.dim + dtensor.num_dims);
+        dtensor_mapping[dtensor.guid] = new_g->new_input(
+            dims, input_op->input_strides, dtensor.data_type, dtensor.layout);
+        break;
+      }
+      case KN_OUTPUT_OP: {
+        kn::KNOutputOp *output_op = static_cast<kn::KNOutputOp *>(op);
+        new_g->mark_output(inputs[0], output_op->output_strides);
+        break;
+      }
+      case KN_MATMUL_OP: {
+        dtensor_mapping[op->output_tensors[0].guid] =
+            new_g->matmul(inputs[0], inputs[1]);
+        break;
+      }
+      case KN_CLAMP_OP: {
+        kn::KNClampUnaryOp *clamp = static_cast<kn::KNClampUnaryOp *>(op);
+        dtensor_mapping[op->output_tensors[0].guid] = new_g->elementunary_clamp(
+            inputs[0], clamp->min_val, clamp->max_val);
+        break;
+      }
+      case KN_EXP_OP:
+      case KN_SQUARE_OP:
+      case KN_SQRT_OP:
+      case KN_SILU_OP:
+      case KN_GELU_OP:
+      case KN_RELU_OP: {
+        dtensor_mapping[op->output_tensors[0].guid] =
+            new_g->elementunary(inputs[0], op->op_type);
+        break;
+      }
+      case KN_ADD_OP:
+      case KN_MUL_OP:
+      case KN_DIV_OP:
+      case KN_POW_OP: {
+        dtensor_mapping[op->output_tensors[0].guid] =
+            new_g->elementbinary(inputs[0], inputs[1], op->op_type);
+        break;
+      }
+      case KN_CUSTOMIZED_OP: {
+        kn::KNCustomizedOp *custom_op = static_cast<kn::KNCustomizedOp *>(op);
+        if (is_fused[op] && by_consumer.find(op) == by_consumer.end()) {
+          // A producer, emitted together with its consumer
+          break;
+        }
+        std::vector<kn::DTensor> merged_inputs;
+        tb::STensor producer_output;
+        std::shared_ptr<tb::Graph> tbg;
+        if (by_consumer.find(op) == by_consumer.end()) {
+          tb::Graph const &bgraph = custom_op->bgraph;
+          tbg = std::make_shared<tb::Graph>(bgraph.grid_dim,
+                                            bgraph.block_dim,
+                                            bgraph.forloop_range,
+                                            bgraph.reduction_dimx);
+          replay_tb_graph(*tbg,
+                          bgraph,
+                          custom_op->input_tensors,
+                          dtensor_mapping,
+                          merged_inputs,
+                          false /*lower_accums*/,
+                          false /*is_producer*/,
+                          0,
+                          producer_output);
+        } else {
+          FusionCandidate const &c = by_consumer.at(op);
+          tbg = build_fused_tb_graph(c, dtensor_mapping, merged_inputs);
+          report.records.push_back(KNFusionRecord{c.producer_idx,
+                                                  c.consumer_idx,
+                                                  c.is_epilogue,
+                                                  c.dmem_bytes_saved});
+        }
+        std::vector<kn::DTensor> outputs =
+            new_g->customized(merged_inputs, *tbg);
+        assert(outputs.size() == op->output_tensors.size());
+        for (size_t i = 0; i < outputs.size(); i++) {
+          dtensor_mapping[op->output_tensors[i].guid] = outputs[i];
+        }
+        break;
+      }
+      default: {
+        assert(false && "Unsupported operator");
+      }
+    }
+  }
+  return new_g;
+}
+
+} // namespace transpiler
+} // namespace mirage
@@ -157,18 +157,18 @@ void Transpiler::resolve_tensor_layout() {
   for (kn::DTensor const &dtensor : all_dtensors) {
     int num_dims = dtensor.num_dims;
     for (int i = 0; i < num_dims; ++i) {
-      std::string var_name = fmt("di_$_$", dtensor.guid, i);
+      std::string var_name = fmt(FMT_STR("di_$_$"), dtensor.guid, i);
       d_is_innermost[dtensor.guid].push_back(ctx.bool_const(var_name.c_str()));
     }
   }
   for (tb::STensor const &stensor : all_stensors) {
     int num_dims = stensor.num_dims;
     for (int i = 0; i < num_dims; ++i) {
-      std::string var_name = fmt("si_$_$", stensor.guid, i);
+      std::string var_name = fmt(FMT_STR("si_$_$"), stensor.guid, i);
       s_is_innermost[stensor.guid].push_back(ctx.bool_const(var_name.c_str()));
     }
     for (int i = 0; i < num_dims; ++i) {
-      std::string var_name = fmt("sw_$_$", stensor.guid, i);
+      std::string var_name = fmt(FMT_STR("sw_$_$"), stensor.guid, i);
       s_is_swizzled[stensor.guid].push_back(ctx.bool_const(var_name.c_str()));
     }
   }
@@ -224,17 +224,19 @@ void Transpiler::resolve_tensor_layout() {
         vector<size_t> const &cur_stride = this->input_strides[cur_input_idx];
         kn::DTensor const &tensor = op->output_tensors.at(0);
         if (tensor.num_dims != (int)cur_stride.size()) {
-          throw std::runtime_error(
-              fmt("The number of dimensions of the stride of the $th tensor "
-                  "($) does not match the tensor's num_dims ($)",
-                  cur_input_idx,
-                  cur_stride.size(),
-                  tensor.num_dims));
+          throw std::runtime_error(fmt(
+              FMT_STR(
+                  "The number of dimensions of the stride of the $th tensor "
+                  "($) does not match the tensor's num_dims ($)"),
+              cur_input_idx,
+              cur_stride.size(),
+              tensor.num_dims));
         }
         int innermost_dim = find_innermost_dim(cur_stride);
         if (innermost_dim == -1) {
           throw std::runtime_error(
-              fmt("No innermost dim found for input tensor $", cur_input_idx));
+              fmt(FMT_STR("No innermost dim found for input tensor $"),
+                  cur_input_idx));
         }
         opt.add(d_is_innermost[tensor.guid][innermost_dim]);
         cur_input_idx += 1;
@@ -247,17 +249,19 @@ void Transpiler::resolve_tensor_layout() {
               this->output_strides[cur_output_idx];
           kn::DTensor const &tensor = op->input_tensors.at(0);
           if (tensor.num_dims != (int)cur_stride.size()) {
-            throw std::runtime_error(
-                fmt("The number of dimensions of the stride of the $th tensor "
-                    "($) does not match the tensor's num_dims ($)",
-                    cur_output_idx,
-                    cur_stride.size(),
-                    tensor.num_dims));
+            throw std::runtime_error(fmt(
+                FMT_STR(
+                    "The number of dimensions of the stride of the $th tensor "
+                    "($) does not match the tensor's num_dims ($)"),
+                cur_output_idx,
+                cur_stride.size(),
+                tensor.num_dims));
           }
           int innermost_dim = find_innermost_dim(cur_stride);
           if (innermost_dim == -1) {
-            throw std::runtime_error(fmt(
-                "No innermost dim found for input tensor $", cur_output_idx));
+            throw std::runtime_error(
+                fmt(FMT_STR("No innermost dim found for input tensor $"),
+                    cur_output_idx));
           }
           opt.add(d_is_innermost[tensor.guid][innermost_dim]);
         }
@@ -499,7 +503,8 @@ void Transpiler::resolve_tensor_layout() {
             // along the i-th dim
             z3::expr_vector is_op_iter_dim(ctx);
             for (int i = 0; i < num_dims; ++i) {
-              std::string var_name = fmt("op_iter_dim_$_$", output.guid, i);
+              std::string var_name =
+                  fmt(FMT_STR("op_iter_dim_$_$"), output.guid, i);
               is_op_iter_dim.push_back(ctx.bool_const(var_name.c_str()));
             }
             opt.add(z3::atmost(is_op_iter_dim, 1));
@@ -532,7 +537,8 @@ void Transpiler::resolve_tensor_layout() {
             // i-th dim
             z3::expr_vector is_op_iter_dim(ctx);
             for (int i = 0; i < num_dims; ++i) {
-              std::string var_name = fmt("op_iter_dim_$_$", output.guid, i);
+              std::string var_name =
+                  fmt(FMT_STR("op_iter_dim_$_$"), output.guid, i);
               is_op_iter_dim.push_back(ctx.bool_const(var_name.c_str()));
             }
             opt.add(z3::atmost(is_op_iter_dim, 1));
@@ -559,7 +565,8 @@ void Transpiler::resolve_tensor_layout() {
             int num_dims = input.num_dims;
             z3::expr_vector is_op_iter_dim(ctx);
             for (int i = 0; i < input.num_dims; ++i) {
-              std::string var_name = fmt("op_iter_dim_$_$", output.guid, i);
+              std::string var_name =
+                  fmt(FMT_STR("op_iter_dim_$_$"), output.guid, i);
               is_op_iter_dim.push_back(ctx.bool_const(var_name.c_str()));
             }
             opt.add(z3::atmost(is_op_iter_dim, 1));
@@ -583,7 +590,8 @@ void Transpiler::resolve_tensor_layout() {
             int num_dims = input.num_dims;
             z3::expr_vector is_op_iter_dim(ctx);
             for (int i = 0; i < input.num_dims; ++i) {
-              std::string var_name = fmt("op_iter_dim_$_$", output.guid, i);
+              std::string var_name =
+                  fmt(FMT_STR("op_iter_dim_$_$"), output.guid, i);
               is_op_iter_dim.push_back(ctx.bool_const(var_name.c_str()));
             }
             opt.add(z3::atmost(is_op_iter_dim, 1));
@@ -619,7 +627,8 @@ void Transpiler::resolve_tensor_layout() {
             // Enumerate the iteration dim
             z3::expr_vector is_op_iter_dim(ctx);
             for (int i = 0; i < num_dims; ++i) {
-              std::string var_name = fmt("op_iter_dim_$_$", output.guid, i);
+              std::string var_name =
+                  fmt(FMT_STR("op_iter_dim_$_$"), output.guid, i);
               is_op_iter_dim.push_back(ctx.bool_const(var_name.c_str()));
             }
             opt.add(z3::atmost(is_op_iter_dim, 1));
@@ -651,7 +660,8 @@ void Transpiler::resolve_tensor_layout() {
             // Enumerate the iteration dim
             z3::expr_vector is_op_iter_dim(ctx);
             for (int i = 0; i < num_dims; ++i) {
-              std::string var_name = fmt("op_iter_dim_$_$", output.guid, i);
+              std::string var_name =
+                  fmt(FMT_STR("op_iter_dim_$_$"), output.guid, i);
               is_op_iter_dim.push_back(ctx.bool_const(var_name.c_str()));
             }
             opt.add(z3::atmost(is_op_iter_dim, 1));
@@ -683,7 +693,7 @@ void Transpiler::resolve_tensor_layout() {
             break;
           }
           default:
-            assert(fmt("Unknown TB op: $", tb_op->op_type).c_str());
+            assert(fmt(FMT_STR("Unknown TB op: $"), tb_op->op_type).c_str());
         }
       }
     }
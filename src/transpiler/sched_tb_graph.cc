@@ -139,6 +139,30 @@ static vector<TBSchedNode>
   return res;
 }
 
+std::unordered_map<tb::TBOperator const *, bool>
+    get_accum_in_reg(tb::Graph const &tb_graph) {
+  std::unordered_map<tb::TBOperator const *, bool> accum_in_reg;
+  size_t num_thrs =
+      tb_graph.block_dim.x * tb_graph.block_dim.y * tb_graph.block_dim.z;
+  size_t per_thread_accum_numel_tot = 0;
+  for (tb::TBOperator const *op : tb_graph.operators) {
+    if (op->op_type == type::TB_FORLOOP_ACCUM_NO_RED_OP) {
+      size_t accum_numel = op->output_tensors.at(0).num_elements();
+      size_t per_thr_accum_numel = accum_numel / num_thrs;
+      if (per_thread_accum_numel_tot + per_thr_accum_numel <=
+          MAX_PER_THREAD_ACCUM_NUMEL) {
+        accum_in_reg[op] = true;
+        per_thread_accum_numel_tot += per_thr_accum_numel;
+      } else {
+        accum_in_reg[op] = false;
+      }
+    } else if (op->op_type == type::TB_FORLOOP_ACCUM_NO_RED_RESCALE_OP) {
+      accum_in_reg[op] = false;
+    }
+  }
+  return accum_in_reg;
+}
+
 // Get the schedule of a custom threadblock graph
 // See docs/transpiler/transpiler.md for more details
 TBSched Transpiler::get_threadblock_schedule(tb::Graph const &tb_graph) {
@@ -148,7 +172,8 @@ TBSched Transpiler::get_threadblock_schedule(tb::Graph const &tb_graph) {
   // In this stage, we do not consider the interference on different
   std::unordered_map<tb::TBOperator const *, TBSchedOpMeta> op2op_meta;
   {
-    size_t per_thread_accum_numel_tot = 0;
+    std::unordered_map<tb::TBOperator const *, bool> accum_in_reg =
+        get_accum_in_reg(tb_graph);
     for (tb::TBOperator *const op : tb_graph.operators) {
       TBSchedOpMeta op_meta;
       if (op->op_type == type::TB_INPUT_OP) {
@@ -233,26 +258,9 @@ TBSched Transpiler::get_threadblock_schedule(tb::Graph const &tb_graph) {
             can_perform_chunked_copy(
                 stensor, stensor_meta, dtensor, dtensor_meta);
         op_meta.is_chunked_output &= is_dtensor_offset_divisible;
-      } else if (op->op_type == type::TB_FORLOOP_ACCUM_NO_RED_OP) {
-        // Decide whether or not to put the forloop accumulator in register
-        // files
-        size_t accum_numel = op->output_tensors.at(0).num_elements();
-        size_t num_thrs =
-            tb_graph.block_dim.x * tb_graph.block_dim.y * tb_graph.block_dim.z;
-        size_t per_thr_accum_numel = accum_numel / num_thrs;
-        // Use a simple heuristic to decide whether or not to put the forloop
-        // accumulator in register files
-        // Every thread can have at most 255 32-bit registers (according to
-        // https://docs.nvidia.com/cuda/cuda-c-programming-guide/index.html#features-and-technical-specifications)
-        // So we allow accumulators to take up to 192 registers
-        if (per_thread_accum_numel_tot + per_thr_accum_numel <= 192) {
-          op_meta.is_accum_in_reg = true;
-          per_thread_accum_numel_tot += per_thr_accum_numel;
-        } else {
-          op_meta.is_accum_in_reg = false;
-        }
-      } else if (op->op_type == type::TB_FORLOOP_ACCUM_NO_RED_RESCALE_OP) {
-        op_meta.is_accum_in_reg = false;
+      } else if (op->op_type == type::TB_FORLOOP_ACCUM_NO_RED_OP ||
+                 op->op_type == type::TB_FORLOOP_ACCUM_NO_RED_RESCALE_OP) {
+        op_meta.is_accum_in_reg = accum_in_reg.at(op);
       }
       op2op_meta[op] = op_meta;
     }
@@ -455,6 +455,15 @@ Transpiler::Transpiler(kernel::Graph const *_graph,
   kernel::Graph const *rewritten_graph =
       config.enable_online_softmax ? rewrite_graph_for_online_softmax(_graph)
                                    : _graph;
+  // Merge adjacent customized operators
+  if (config.enable_kn_fusion) {
+    kernel::Graph const *fused_graph =
+        rewrite_graph_for_kn_fusion(rewritten_graph, config, kn_fusion_report);
+    if (fused_graph != rewritten_graph && rewritten_graph != _graph) {
+      delete rewritten_graph;
+    }
+    rewritten_graph = fused_graph;
+  }
   // We need to construct a new kernel graph by decomposing forloop accumulators
   // into the non-reduction accumulator type to enable transpiler optimizations
   g = std::make_shared<kernel::Graph>();
@@ -40,7 +40,7 @@ static string get_cute_layout(vector<int> dims, vector<size_t> strides) {
   assert(dims.size() == strides.size());
   std::reverse(dims.begin(), dims.end());
   std::reverse(strides.begin(), strides.end());
-  return fmt("Layout<Shape<$>, Stride<$>>",
+  return fmt(FMT_STR("Layout<Shape<$>, Stride<$>>"),
              map_to_cute_int(dims),
              map_to_cute_int(strides));
 }
@@ -92,22 +92,22 @@ std::pair<string, string>
     Transpiler::get_dtensor_ptr(kn::DTensor const &dtensor) {
   auto guid = dtensor.guid;
   DTensorMeta const &meta = dtensor_metas.at(guid);
-  string pointer_var_name = fmt("dtensor$", guid);
+  string pointer_var_name = fmt(FMT_STR("dtensor$"), guid);
   string code = "";
   if (meta.is_input) {
-    code = fmt("$ *$ = ($*)input_tensors.at($);",
+    code = fmt(FMT_STR("$ *$ = ($*)input_tensors.at($);"),
                get_datatype_str(dtensor.data_type),
                pointer_var_name,
                get_datatype_str(dtensor.data_type),
                meta.input_idx);
   } else if (meta.is_output) {
-    code = fmt("$ *$ = ($*)output_tensors.at($);",
+    code = fmt(FMT_STR("$ *$ = ($*)output_tensors.at($);"),
                get_datatype_str(dtensor.data_type),
                pointer_var_name,
                get_datatype_str(dtensor.data_type),
                meta.output_idx);
   } else {
-    code = fmt("$ *$ = ($*)((char*)buf + $);",
+    code = fmt(FMT_STR("$ *$ = ($*)((char*)buf + $);"),
                get_datatype_str(dtensor.data_type),
                pointer_var_name,
                get_datatype_str(dtensor.data_type),
@@ -118,9 +118,10 @@ std::pair<string, string>
 
 std::pair<string, string>
     Transpiler::get_profiling_ptr(int const customized_idx) {
-  string pointer_var_name = fmt("profiler_buffer_$", customized_idx);
+  string pointer_var_name = fmt(FMT_STR("profiler_buffer_$"), customized_idx);
   string code = "";
-  code = fmt("uint64_t *$ = (uint64_t*)profiler_buffer;", pointer_var_name);
+  code = fmt(FMT_STR("uint64_t *$ = (uint64_t*)profiler_buffer;"),
+             pointer_var_name);
   return {pointer_var_name, code};
 }
 
@@ -154,8 +155,8 @@ TranspileResult Transpiler::transpile_ugraph() {
   // Generate header
 
   CodeKeeper header;
-  header.e("#define NUM_GPUS $", num_gpus);
-  header.e("#define USE_NVSHMEM $", use_nvshmem);
+  header.e(FMT_STR("#define NUM_GPUS $"), num_gpus);
+  header.e(FMT_STR("#define USE_NVSHMEM $"), use_nvshmem);
   if (config.target_cc == GPU_CC::H100) {
     header.e("#define MIRAGE_GRACE_HOPPER");
   }
@@ -170,16 +171,29 @@ TranspileResult Transpiler::transpile_ugraph() {
 
   CodeKeeper hopper_tma;
 
+  // Capturing into a CUDA graph requires every launch to be issued on
+  // `stream`. Kernel-level library ops (cuBLAS, elementwise, reduction) run
+  // on the default stream and NVSHMEM kernels cannot be captured, so we fall
+  // back to direct launches for those graphs
+  bool use_cuda_graph = config.enable_cuda_graph && !use_nvshmem;
+  for (kn::KNOperator *const op : g->operators) {
+    if (op->op_type != type::KNOperatorType::KN_INPUT_OP &&
+        op->op_type != type::KNOperatorType::KN_OUTPUT_OP &&
+        op->op_type != type::KNOperatorType::KN_CUSTOMIZED_OP) {
+      use_cuda_graph = false;
+    }
+  }
+
   init.e("static void _init() {");
-  exec.e(
-      "static void _execute_mugraph(std::vector<void const *> input_tensors, "
-      "std::vector<void*> output_tensors, "
-      "void* buf, cudaStream_t stream, void * profiler_buffer){");
+  exec.e(FMT_STR("static void $(std::vector<void const *> input_tensors, "
+                 "std::vector<void*> output_tensors, "
+                 "void* buf, cudaStream_t stream, void * profiler_buffer){"),
+         use_cuda_graph ? "_launch_mugraph" : "_execute_mugraph");
   for (kn::KNOperator *const op : g->operators) {
     std::string op_type_str;
     to_json(op_type_str, op->op_type);
     exec.e("{");
-    exec.e("// OP type: $", op_type_str);
+    exec.e(FMT_STR("// OP type: $"), op_type_str);
     switch (op->op_type) {
       case type::KNOperatorType::KN_INPUT_OP:
       case type::KNOperatorType::KN_OUTPUT_OP: {
@@ -230,8 +244,8 @@ TranspileResult Transpiler::transpile_ugraph() {
         string compute_type =
             (in0.data_type == type::DT_FLOAT16 ? "CUBLAS_COMPUTE_16F"
                                                : "CUBLAS_COMPUTE_32F");
-        exec.e("kn::gemm<$>($,$,$, $,$,$, $,$, $,$, $,$, $, "
-               "$,$,$);",
+        exec.e(FMT_STR("kn::gemm<$>($,$,$, $,$,$, $,$, $,$, $,$, $, "
+                       "$,$,$);"),
                compute_type,
                out0_ptr_name,
                in0_ptr_name,
@@ -291,14 +305,14 @@ TranspileResult Transpiler::transpile_ugraph() {
         exec.e(in0_ptr_code);
         exec.e(out0_ptr_code);
         // Create kernel instance
-        exec.e("using kernel = kn::ElementUnaryKernel<$, "
-               "kn::ElementUnaryOpType::$, $, $>;",
+        exec.e(FMT_STR("using kernel = kn::ElementUnaryKernel<$, "
+                       "kn::ElementUnaryOpType::$, $, $>;"),
                get_datatype_str(in0.data_type),
                get_kn_op_str(op->op_type),
                in0_layout,
                out0_layout);
         // Launch kernel
-        exec.e("kernel::run($, $);", out0_ptr_name, in0_ptr_name);
+        exec.e(FMT_STR("kernel::run($, $);"), out0_ptr_name, in0_ptr_name);
         break;
       }
       case type::KNOperatorType::KN_ADD_OP:
@@ -355,16 +369,18 @@ TranspileResult Transpiler::transpile_ugraph() {
                                                               : "";
         assert(op_type_str != "");
         // Create kernel instance
-        exec.e("using kernel = kn::ElementBinaryKernel<$, "
-               "kn::ElementBinaryOpType::$, $, $, $>;",
+        exec.e(FMT_STR("using kernel = kn::ElementBinaryKernel<$, "
+                       "kn::ElementBinaryOpType::$, $, $, $>;"),
                get_datatype_str(in0.data_type),
                op_type_str,
                in0_layout,
                in1_layout,
                out0_layout);
         // Launch kernel
-        exec.e(
-            "kernel::run($, $, $);", out0_ptr_name, in0_ptr_name, in1_ptr_name);
+        exec.e(FMT_STR("kernel::run($, $, $);"),
+               out0_ptr_name,
+               in0_ptr_name,
+               in1_ptr_name);
         break;
       }
       case type::KNOperatorType::KN_REDUCTION_0_OP:
@@ -411,10 +427,10 @@ TranspileResult Transpiler::transpile_ugraph() {
         int new_reduction_dim =
             (reduction_dim + in0.num_dims - meta_in0.innermost_dim) %
             in0.num_dims;
-        string layout_in0 = fmt("Layout<Shape<$>, Stride<$>>",
+        string layout_in0 = fmt(FMT_STR("Layout<Shape<$>, Stride<$>>"),
                                 map_to_cute_int(new_shape_in0),
                                 map_to_cute_int(new_strides_in0));
-        string layout_out0 = fmt("Layout<Shape<$>, Stride<$>>",
+        string layout_out0 = fmt(FMT_STR("Layout<Shape<$>, Stride<$>>"),
                                  map_to_cute_int(new_shape_out0),
                                  map_to_cute_int(new_strides_out0));
         // Get tensor ptrs
@@ -423,13 +439,13 @@ TranspileResult Transpiler::transpile_ugraph() {
         exec.e(in0_ptr_code);
         exec.e(out0_ptr_code);
         // Create kernel instance
-        exec.e("using kernel = kn::ReductionKernel<$, $, $, $>;",
+        exec.e(FMT_STR("using kernel = kn::ReductionKernel<$, $, $, $>;"),
                get_datatype_str(in0.data_type),
                layout_in0,
                layout_out0,
                new_reduction_dim);
         // Launch kernel
-        exec.e("kernel::run($, $);", out0_ptr_name, in0_ptr_name);
+        exec.e(FMT_STR("kernel::run($, $);"), out0_ptr_name, in0_ptr_name);
         break;
       }
       case type::KNOperatorType::KN_CUSTOMIZED_OP: {
@@ -499,15 +515,15 @@ TranspileResult Transpiler::transpile_ugraph() {
           assert(0);
         }
         // Launch kernel
-        exec.e("dim3 grid_dim($, $, $);",
+        exec.e(FMT_STR("dim3 grid_dim($, $, $);"),
                bgraph.grid_dim.x,
                bgraph.grid_dim.y,
                bgraph.grid_dim.z);
-        exec.e("dim3 block_dim($, $, $);",
+        exec.e(FMT_STR("dim3 block_dim($, $, $);"),
                bgraph.block_dim.x,
                bgraph.block_dim.y,
                bgraph.block_dim.z);
-        exec.e("size_t smem_size = $;", result.smem_size);
+        exec.e(FMT_STR("size_t smem_size = $;"), result.smem_size);
         // init
 
         exec.e("");
@@ -529,8 +545,8 @@ TranspileResult Transpiler::transpile_ugraph() {
             auto const &tmaParams = result.tmaParamsList.at(i);
             m_inputs.append(tmaParams.m_input ? "true" : "false");
 
-            tmas.append(fmt("tma_$, ", tmaParams.guid));
-            tma_tmps.append(fmt("decltype(tma_$)", tmaParams.guid));
+            fmt_to(tmas, FMT_STR("tma_$, "), tmaParams.guid);
+            fmt_to(tma_tmps, FMT_STR("decltype(tma_$)"), tmaParams.guid);
 
             if (i != result.tmaParamsList.size() - 1) {
               tma_tmps.append(", ");
@@ -538,87 +554,94 @@ TranspileResult Transpiler::transpile_ugraph() {
             }
           }
 
-          exec.e(fmt("std::vector<bool> minputs = {$};", m_inputs));
+          exec.e(FMT_STR("std::vector<bool> minputs = {$};"), m_inputs);
           for (int i = 0; i < result.tmaParamsList.size(); i++) {
             auto const &tmaParams = result.tmaParamsList.at(i);
 
             if (tmaParams.m_input) {
-              exec.e(fmt("static constexpr cute::GMMA::Major GmmaMajor_$ = "
-                         "GMMA::Major::K;",
-                         tmaParams.guid));
+              exec.e(FMT_STR("static constexpr cute::GMMA::Major GmmaMajor_$ = "
+                             "GMMA::Major::K;"),
+                     tmaParams.guid);
             } else {
-              exec.e(fmt("static constexpr cute::GMMA::Major GmmaMajor_$ = "
-                         "GMMA::Major::MN;",
-                         tmaParams.guid));
+              exec.e(FMT_STR("static constexpr cute::GMMA::Major GmmaMajor_$ = "
+                             "GMMA::Major::MN;"),
+                     tmaParams.guid);
             }
-            exec.e(fmt("using DstMNKLayout_$ = $;",
-                       tmaParams.guid,
-                       tmaParams.dstLayout));
-
-            exec.e(fmt("using SrcMNKLayout_$ = $;",
-                       tmaParams.guid,
-                       tmaParams.srcLayout));
-
-            exec.e(fmt(
-                "using SmemLayoutAtom_$ = "
-                "decltype(cutlass::gemm::collective::detail::ss_smem_selector<"
-                "GmmaMajor_$, $, decltype(get<0>(DstMNKLayout_${})), "
-                "decltype(get<1>(DstMNKLayout_${}))>());",
+            exec.e(FMT_STR("using DstMNKLayout_$ = $;"),
+                   tmaParams.guid,
+                   tmaParams.dstLayout);
+
+            exec.e(FMT_STR("using SrcMNKLayout_$ = $;"),
+                   tmaParams.guid,
+                   tmaParams.srcLayout);
+
+            exec.e(
+                FMT_STR("using SmemLayoutAtom_$ = "
+                        "decltype(cutlass::gemm::collective::detail::ss_smem_"
+                        "selector<"
+                        "GmmaMajor_$, $, decltype(get<0>(DstMNKLayout_${})), "
+                        "decltype(get<1>(DstMNKLayout_${}))>());"),
                 tmaParams.guid,
                 tmaParams.guid,
                 get_datatype_str(cur_op->input_tensors[0].data_type),
                 tmaParams.guid,
-                tmaParams.guid));
-            exec.e(fmt("using DstPipeLayout_$ = "
-                       "decltype(tile_to_shape(SmemLayoutAtom_${}, "
-                       "make_shape(shape<0>(DstMNKLayout_${}), "
-                       "shape<1>(DstMNKLayout_${}), Int<$>{}), "
-                       "Step<_1, _2, _3>{}));",
-                       tmaParams.guid,
-                       tmaParams.guid,
-                       tmaParams.guid,
-                       tmaParams.guid,
-                       config.pipeline_stages));
-            exec.e(fmt("auto g_tensor_$ = "
-                       "make_tensor(make_gmem_ptr<$>(dtensor$), "
-                       "SrcMNKLayout_${});",
-                       tmaParams.guid,
-                       get_datatype_str(cur_op->input_tensors[0].data_type),
-                       tmaParams.guid,
-                       tmaParams.guid));
+                tmaParams.guid);
+            exec.e(FMT_STR("using DstPipeLayout_$ = "
+                           "decltype(tile_to_shape(SmemLayoutAtom_${}, "
+                           "make_shape(shape<0>(DstMNKLayout_${}), "
+                           "shape<1>(DstMNKLayout_${}), Int<$>{}), "
+                           "Step<_1, _2, _3>{}));"),
+                   tmaParams.guid,
+                   tmaParams.guid,
+                   tmaParams.guid,
+                   tmaParams.guid,
+                   config.pipeline_stages);
+            exec.e(FMT_STR("auto g_tensor_$ = "
+                           "make_tensor(make_gmem_ptr<$>(dtensor$), "
+                           "SrcMNKLayout_${});"),
+                   tmaParams.guid,
+                   get_datatype_str(cur_op->input_tensors[0].data_type),
+                   tmaParams.guid,
+                   tmaParams.guid);
             exec.e(
-                fmt("auto tma_$ = make_tma_copy(SM90_TMA_LOAD{}, g_tensor_$, "
-                    "DstPipeLayout_${}(_, _, Int<0>{}));",
-                    tmaParams.guid,
-                    tmaParams.guid,
-                    tmaParams.guid));
+                FMT_STR(
+                    "auto tma_$ = make_tma_copy(SM90_TMA_LOAD{}, g_tensor_$, "
+                    "DstPipeLayout_${}(_, _, Int<0>{}));"),
+                tmaParams.guid,
+                tmaParams.guid,
+                tmaParams.guid);
 
             exec.e("");
           }
 
           if (result.tmaParamsList.size() > 0) {
-            exec.e("cudaFuncSetAttribute($<$>, "
-                   "cudaFuncAttributeMaxDynamicSharedMemorySize, $);",
+            // The kernel is instantiated with the types of the TMA
+            // descriptors created above, so the attribute cannot be set in
+            // `_init`. Use a function-local static so it is set only once
+            exec.e(FMT_STR("static cudaError_t smem_attr_status = "
+                           "cudaFuncSetAttribute($<$>, "
+                           "cudaFuncAttributeMaxDynamicSharedMemorySize, $);"),
                    result.func_name,
                    tma_tmps,
                    result.smem_size);
+            exec.e("CHECK_CUDA(smem_attr_status);");
           } else {
-            exec.e("cudaFuncSetAttribute($, "
-                   "cudaFuncAttributeMaxDynamicSharedMemorySize, $);",
+            init.e(FMT_STR("cudaFuncSetAttribute($, "
+                           "cudaFuncAttributeMaxDynamicSharedMemorySize, $);"),
                    result.func_name,
                    result.smem_size);
           }
 
-          exec.e("$<<<grid_dim, block_dim, smem_size, stream>>>($ $);",
+          exec.e(FMT_STR("$<<<grid_dim, block_dim, smem_size, stream>>>($ $);"),
                  result.func_name,
                  tmas,
                  ptr_names);
         } else {
-          exec.e("cudaFuncSetAttribute($, "
-                 "cudaFuncAttributeMaxDynamicSharedMemorySize, $);",
+          init.e(FMT_STR("cudaFuncSetAttribute($, "
+                         "cudaFuncAttributeMaxDynamicSharedMemorySize, $);"),
                  result.func_name,
                  result.smem_size);
-          exec.e("$<<<grid_dim, block_dim, smem_size, stream>>>( $);",
+          exec.e(FMT_STR("$<<<grid_dim, block_dim, smem_size, stream>>>( $);"),
                  result.func_name,
                  ptr_names);
         }
@@ -637,12 +660,38 @@ TranspileResult Transpiler::transpile_ugraph() {
   init.e("}");
   exec.e("}");
 
-  string code = fmt("$\n$\n$\n$\n$\n",
-                    header.to_string(),
-                    custom_kernels.to_string(),
-                    init.to_string(),
-                    hopper_tma.to_string(),
-                    exec.to_string());
+  if (use_cuda_graph) {
+    // Capture all launches of `_launch_mugraph` into a CUDA graph on the
+    // first call with a given set of tensor pointers, and replay it later.
+    // See runtime/cuda_graph.h for the capture stream and eviction policy
+    exec.e("static void _execute_mugraph(std::vector<void const *> "
+           "input_tensors, std::vector<void*> output_tensors, "
+           "void* buf, cudaStream_t stream, void * profiler_buffer){");
+    exec.e(FMT_STR("static runtime::CudaGraphCache graph_cache($);"),
+           config.cuda_graph_cache_size);
+    exec.e("std::vector<void const *> key = input_tensors;");
+    exec.e("key.insert(key.end(), output_tensors.begin(), "
+           "output_tensors.end());");
+    exec.e("key.push_back(buf);");
+    exec.e("key.push_back(profiler_buffer);");
+    exec.e("graph_cache.launch(key, stream, [&](cudaStream_t "
+           "capture_stream) {");
+    exec.e("_launch_mugraph(input_tensors, output_tensors, buf, "
+           "capture_stream, profiler_buffer);");
+    exec.dec_indent();
+    exec.e("});");
+    exec.e("}");
+  }
+
+  // Concatenate all parts into a single buffer, separated by empty lines
+  string code;
+  code.reserve(header.size() + custom_kernels.size() + init.size() +
+               hopper_tma.size() + exec.size() + 5);
+  for (CodeKeeper const *part :
+       {&header, &custom_kernels, &init, &hopper_tma, &exec}) {
+    part->append_to(code);
+    code.push_back('\n');
+  }
   vector<OutputTensorDirective> output_directives;
   for (kn::DTensor const &dtensor : this->mugraph_output_tensors) {
     assert(dtensor_metas.find(dtensor.guid) != dtensor_metas.end());
@@ -659,7 +708,9 @@ TranspileResult Transpiler::transpile_ugraph() {
                          this->d_buf_size,
                          max_smem_size,
                          profiler_buf_size,
-                         output_directives};
+                         output_directives,
+                         config.enable_kn_fusion ? kn_fusion_report.to_string()
+                                                 : ""};
 }
 
 } // namespace transpiler
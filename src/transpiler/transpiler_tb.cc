@@ -51,7 +51,7 @@ static string get_cute_layout(vector<int> dims, vector<size_t> strides) {
   assert(dims.size() == strides.size());
   std::reverse(dims.begin(), dims.end());
   std::reverse(strides.begin(), strides.end());
-  return fmt("Layout<Shape<$>, Stride<$>>",
+  return fmt(FMT_STR("Layout<Shape<$>, Stride<$>>"),
              map_to_cute_int(dims),
              map_to_cute_int(strides));
 }
@@ -87,7 +87,7 @@ static string get_stensor_layout(tb::STensor const &stensor,
     return get_layout_detail::get_cute_layout(stensor, meta, start_dim);
   } else {
     // XOR-based swizzling
-    return fmt("decltype(composition(Swizzle<$, $, $>{}, ${}))",
+    return fmt(FMT_STR("decltype(composition(Swizzle<$, $, $>{}, ${}))"),
                meta.xor_swizzle_b,
                meta.xor_swizzle_m,
                meta.xor_swizzle_s,
@@ -208,7 +208,7 @@ static string append_epilogue_scalars(
     } else if (is_threadblock_element_unary(chain.at(i).first->op_type)) {
       tb::TBElementUnaryOp const *tb_unary_op =
           dynamic_cast<tb::TBElementUnaryOp const *>(chain.at(i).first);
-      res.append(fmt("$f, ", tb_unary_op->scalar));
+      fmt_to(res, FMT_STR("$f, "), tb_unary_op->scalar);
     } else {
       res.append("0.0f, ");
     }
@@ -273,43 +273,43 @@ CustomOPTranspileResult
   // Allocate a kernel name
   static int custom_kernel_idx_counter = 0;
   int cur_custom_kernel_idx = custom_kernel_idx_counter++;
-  string func_name = fmt("custom_kernel_$", cur_custom_kernel_idx);
+  string func_name = fmt(FMT_STR("custom_kernel_$"), cur_custom_kernel_idx);
 
   // Generate code prologue
   CodeKeeper code;
   if (profiling) {
     code.e_front(
-        "__global__ void  __launch_bounds__($) "
-        "$($, $, uint64_t *profiler_buffer) {",
+        FMT_STR("__global__ void  __launch_bounds__($) "
+                "$($, $, uint64_t *profiler_buffer) {"),
         num_threads,
         func_name,
         map<kn::DTensor, string>(op->output_tensors,
                                  [](kn::DTensor const &dtensor) -> string {
                                    return fmt(
-                                       "$* __restrict__ dtensor$_ptr",
+                                       FMT_STR("$* __restrict__ dtensor$_ptr"),
                                        get_datatype_str(dtensor.data_type),
                                        dtensor.guid);
                                  }),
         map<kn::DTensor, string>(
             op->input_tensors, [](kn::DTensor const &dtensor) -> string {
-              return fmt("$ const* __restrict__ dtensor$_ptr",
+              return fmt(FMT_STR("$ const* __restrict__ dtensor$_ptr"),
                          get_datatype_str(dtensor.data_type),
                          dtensor.guid);
             }));
   } else {
-    code.e("__global__ void __launch_bounds__($) $($, $) {",
+    code.e(FMT_STR("__global__ void __launch_bounds__($) $($, $) {"),
            num_threads,
            func_name,
-           map<kn::DTensor, string>(op->output_tensors,
-                                    [](kn::DTensor const &dtensor) -> string {
-                                      return fmt(
-                                          "$* __restrict__ dtensor$_ptr",
-                                          get_datatype_str(dtensor.data_type),
-                                          dtensor.guid);
-                                    }),
+           map<kn::DTensor, string>(
+               op->output_tensors,
+               [](kn::DTensor const &dtensor) -> string {
+                 return fmt(FMT_STR("$* __restrict__ dtensor$_ptr"),
+                            get_datatype_str(dtensor.data_type),
+                            dtensor.guid);
+               }),
            map<kn::DTensor, string>(
                op->input_tensors, [](kn::DTensor const &dtensor) -> string {
-                 return fmt("$ const* __restrict__ dtensor$_ptr",
+                 return fmt(FMT_STR("$ const* __restrict__ dtensor$_ptr"),
                             get_datatype_str(dtensor.data_type),
                             dtensor.guid);
                }));
@@ -318,20 +318,20 @@ CustomOPTranspileResult
   // Define thread idx
   string thread_idx;
   if (g.block_dim.y > 1 || g.block_dim.z > 1) {
-    thread_idx = fmt("threadIdx.x + threadIdx.y * $ + threadIdx.z * $",
+    thread_idx = fmt(FMT_STR("threadIdx.x + threadIdx.y * $ + threadIdx.z * $"),
                      g.block_dim.x,
                      g.block_dim.x * g.block_dim.y);
   } else {
     thread_idx = "threadIdx.x";
   }
-  code.e("int thread_idx = $;", thread_idx);
-  code.e("static constexpr int NUM_THREADS = $;", num_threads);
+  code.e(FMT_STR("int thread_idx = $;"), thread_idx);
+  code.e(FMT_STR("static constexpr int NUM_THREADS = $;"), num_threads);
 
   // Define STensor as cute::Tensor
   code.e("// STensors");
   code.e("extern __shared__ char buf[];");
   for (auto [guid, addr] : mem_plan.addrs) {
-    code.e("$ *stensor$_ptr = ($*)(buf + $);",
+    code.e(FMT_STR("$ *stensor$_ptr = ($*)(buf + $);"),
            get_datatype_str(op->input_tensors[0].data_type),
            guid,
            get_datatype_str(op->input_tensors[0].data_type),
@@ -361,7 +361,7 @@ CustomOPTranspileResult
       assert(dtensor.num_dims == stensor.num_dims);
       assert(dtensor.data_type == stensor.data_type);
 
-      code.e("// Copy for G->S: dtensor $ -> stensor $",
+      code.e(FMT_STR("// Copy for G->S: dtensor $ -> stensor $"),
              dtensor.guid,
              stensor.guid);
 
@@ -378,14 +378,15 @@ CustomOPTranspileResult
           int num_tbs = dim == 0   ? g.grid_dim.x
                         : dim == 1 ? g.grid_dim.y
                                    : g.grid_dim.z;
-          offset += fmt(" + blockIdx.$*$*$",
-                        (char)"xyz"[dim],
-                        dtensor.dim[div_dim] / num_tbs,
-                        dtensor_meta.strides[div_dim]);
+          fmt_to(offset,
+                 FMT_STR(" + blockIdx.$*$*$"),
+                 (char)"xyz"[dim],
+                 dtensor.dim[div_dim] / num_tbs,
+                 dtensor_meta.strides[div_dim]);
         }
       }
 
-      code.e("const $ *dtensor$_tile_ptr = dtensor$_ptr $;",
+      code.e(FMT_STR("const $ *dtensor$_tile_ptr = dtensor$_ptr $;"),
              get_datatype_str(dtensor.data_type),
              dtensor.guid,
              dtensor.guid,
@@ -402,12 +403,13 @@ CustomOPTranspileResult
         assert(!use_async_copy);
         string dtensor_tile_layout = get_dtensor_tile_layout(
             dtensor, dtensor_meta, stensor, stensor_meta, d_innermost_dim);
-        code.e(
-            "using DTensor$TileLayout = $;", dtensor.guid, dtensor_tile_layout);
+        code.e(FMT_STR("using DTensor$TileLayout = $;"),
+               dtensor.guid,
+               dtensor_tile_layout);
         // Non-chunked, synchronous copy
         code.e(
-            "using STensor$InputAtom = tb::InputNonChunkedSyncCopy<$, "
-            "$, DTensor$TileLayout, NUM_THREADS>;",
+            FMT_STR("using STensor$InputAtom = tb::InputNonChunkedSyncCopy<$, "
+                    "$, DTensor$TileLayout, NUM_THREADS>;"),
             stensor.guid,
             get_datatype_str(stensor.data_type),
             mov_last_get_stensor_layout(stensor, stensor_meta, d_innermost_dim),
@@ -415,28 +417,31 @@ CustomOPTranspileResult
       } else {
         string dtensor_tile_layout = get_dtensor_tile_layout(
             dtensor, dtensor_meta, stensor, stensor_meta, real_innermost_dim);
-        code.e(
-            "using DTensor$TileLayout = $;", dtensor.guid, dtensor_tile_layout);
+        code.e(FMT_STR("using DTensor$TileLayout = $;"),
+               dtensor.guid,
+               dtensor_tile_layout);
         if (!use_async_copy) {
           // Chunked, synchronous copy
-          code.e("using STensor$InputAtom = tb::InputChunkedSyncCopy<$, "
-                 "$, DTensor$TileLayout, NUM_THREADS>;",
-                 stensor.guid,
-                 get_datatype_str(stensor.data_type),
-                 mov_last_get_stensor_layout(
-                     stensor, stensor_meta, real_innermost_dim),
-                 dtensor.guid);
+          code.e(
+              FMT_STR("using STensor$InputAtom = tb::InputChunkedSyncCopy<$, "
+                      "$, DTensor$TileLayout, NUM_THREADS>;"),
+              stensor.guid,
+              get_datatype_str(stensor.data_type),
+              mov_last_get_stensor_layout(
+                  stensor, stensor_meta, real_innermost_dim),
+              dtensor.guid);
         } else {
           // Chunked, asynchronous copy
           pipelined_input_ops.insert(cur_op);
-          code.e("using STensor$InputAtom = tb::InputChunkedAsyncCopy<$, "
-                 "$, DTensor$TileLayout, NUM_THREADS>;",
-                 stensor.guid,
-                 get_datatype_str(stensor.data_type),
-                 mov_last_get_stensor_layout(
-                     stensor, stensor_meta, real_innermost_dim),
-                 dtensor.guid);
-          code.e("$ *stensor$_async_copy_buf = stensor$_ptr;",
+          code.e(
+              FMT_STR("using STensor$InputAtom = tb::InputChunkedAsyncCopy<$, "
+                      "$, DTensor$TileLayout, NUM_THREADS>;"),
+              stensor.guid,
+              get_datatype_str(stensor.data_type),
+              mov_last_get_stensor_layout(
+                  stensor, stensor_meta, real_innermost_dim),
+              dtensor.guid);
+          code.e(FMT_STR("$ *stensor$_async_copy_buf = stensor$_ptr;"),
                  get_datatype_str(stensor.data_type),
                  stensor.guid,
                  stensor.guid + mem_plan.pipelined_input_buf_guid_offset);
@@ -462,9 +467,9 @@ CustomOPTranspileResult
         cur_op)); // An input op in pre_loop_nodes should not be software
                   // pipelined since they do not have forloop_dim
     num_pre_loop_copies += 1;
-    code.e("STensor$InputAtom::run(stensor$_ptr, "
-           "dtensor$_tile_ptr, "
-           "thread_idx);",
+    code.e(FMT_STR("STensor$InputAtom::run(stensor$_ptr, "
+                   "dtensor$_tile_ptr, "
+                   "thread_idx);"),
            stensor.guid,
            stensor.guid,
            cur_op->dtensor.guid);
@@ -487,7 +492,7 @@ CustomOPTranspileResult
       assert(dtensor.num_dims == stensor.num_dims);
       assert(dtensor.data_type == stensor.data_type);
 
-      code.e("// Copy for S->G: stensor $ -> dtensor $",
+      code.e(FMT_STR("// Copy for S->G: stensor $ -> dtensor $"),
              stensor.guid,
              dtensor.guid);
 
@@ -506,13 +511,14 @@ CustomOPTranspileResult
           // The output tensor MUST be divided along this dimension, as stated
           // in the paper
           assert(div_dim >= 0);
-          offset += fmt(" + blockIdx.$*$*$",
-                        (char)"xyz"[dim],
-                        dtensor.dim[div_dim] / num_tbs,
-                        dtensor_meta.strides[div_dim]);
+          fmt_to(offset,
+                 FMT_STR(" + blockIdx.$*$*$"),
+                 (char)"xyz"[dim],
+                 dtensor.dim[div_dim] / num_tbs,
+                 dtensor_meta.strides[div_dim]);
         }
       }
-      code.e("$ *dtensor$_tile_ptr = dtensor$_ptr $;",
+      code.e(FMT_STR("$ *dtensor$_tile_ptr = dtensor$_ptr $;"),
              get_datatype_str(dtensor.data_type),
              dtensor.guid,
              dtensor.guid,
@@ -525,10 +531,12 @@ CustomOPTranspileResult
         int d_innermost_dim = dtensor_meta.innermost_dim;
         string dtensor_tile_layout = get_dtensor_tile_layout(
             dtensor, dtensor_meta, stensor, stensor_meta, d_innermost_dim);
-        code.e(
-            "using DTensor$TileLayout = $;", dtensor.guid, dtensor_tile_layout);
-        code.e("using STensor$OutputAtom = tb::OutputNonChunkedSyncCopy<$, "
-               "DTensor$TileLayout, $, NUM_THREADS>;",
+        code.e(FMT_STR("using DTensor$TileLayout = $;"),
+               dtensor.guid,
+               dtensor_tile_layout);
+        code.e(FMT_STR(
+                   "using STensor$OutputAtom = tb::OutputNonChunkedSyncCopy<$, "
+                   "DTensor$TileLayout, $, NUM_THREADS>;"),
                stensor.guid,
                get_datatype_str(stensor.data_type),
                dtensor.guid,
@@ -537,15 +545,17 @@ CustomOPTranspileResult
       } else {
         string dtensor_tile_layout = get_dtensor_tile_layout(
             dtensor, dtensor_meta, stensor, stensor_meta, real_innermost_dim);
-        code.e(
-            "using DTensor$TileLayout = $;", dtensor.guid, dtensor_tile_layout);
-        code.e("using STensor$OutputAtom = tb::OutputChunkedSyncCopy<$, "
-               "DTensor$TileLayout, $, NUM_THREADS>;",
-               stensor.guid,
-               get_datatype_str(stensor.data_type),
+        code.e(FMT_STR("using DTensor$TileLayout = $;"),
                dtensor.guid,
-               mov_last_get_stensor_layout(
-                   stensor, stensor_meta, real_innermost_dim));
+               dtensor_tile_layout);
+        code.e(
+            FMT_STR("using STensor$OutputAtom = tb::OutputChunkedSyncCopy<$, "
+                    "DTensor$TileLayout, $, NUM_THREADS>;"),
+            stensor.guid,
+            get_datatype_str(stensor.data_type),
+            dtensor.guid,
+            mov_last_get_stensor_layout(
+                stensor, stensor_meta, real_innermost_dim));
       }
       // TODO(intlsy) Support TMA
     }
@@ -570,8 +580,8 @@ CustomOPTranspileResult
       for (int i = 0; i < accum.num_dims; ++i) {
         num_elems = std::max(num_elems, accum.dim[i] * accum_meta.strides[i]);
       }
-      code.e("tb::ClearAccumlatorKernel<$, $, "
-             "NUM_THREADS>::run(stensor$_ptr, thread_idx);",
+      code.e(FMT_STR("tb::ClearAccumlatorKernel<$, $, "
+                     "NUM_THREADS>::run(stensor$_ptr, thread_idx);"),
              get_datatype_str(accum.data_type),
              num_elems,
              accum.guid);
@@ -599,8 +609,8 @@ CustomOPTranspileResult
         num_elems = std::max(num_elems,
                              updated_max.dim[i] * updated_max_meta.strides[i]);
       }
-      code.e("tb::InitReductionMaxKernel<$, $, "
-             "NUM_THREADS>::run(stensor$_ptr, thread_idx);",
+      code.e(FMT_STR("tb::InitReductionMaxKernel<$, $, "
+                     "NUM_THREADS>::run(stensor$_ptr, thread_idx);"),
              get_datatype_str(updated_max.data_type),
              num_elems,
              updated_max.guid);
@@ -736,17 +746,17 @@ CustomOPTranspileResult
       // For threadblock matmul, cute requires 2-d matrices as inputs / outputs,
       // we assert that all other leading dimensions are of size 1, and only use
       // the last two dimensions when generating layouts
-      code.e("using Matmul$LayoutA = $;",
+      code.e(FMT_STR("using Matmul$LayoutA = $;"),
              output.guid,
              get_stensor_layout(input0, meta0, num_dims - 2 /*start_dim*/));
-      code.e("using Matmul$LayoutB = $;",
+      code.e(FMT_STR("using Matmul$LayoutB = $;"),
              output.guid,
              get_stensor_layout(input1, meta1, num_dims - 2 /*start_dim*/));
-      code.e("using Matmul$LayoutC = $;",
+      code.e(FMT_STR("using Matmul$LayoutC = $;"),
              output.guid,
              get_stensor_layout(output, meta2, num_dims - 2 /*start_dim*/));
 
-      code.e("using Matmul$LayoutAAligned = $;",
+      code.e(FMT_STR("using Matmul$LayoutAAligned = $;"),
              output.guid,
              get_mma_stensor_aligned_layout(input0,
                                             meta0,
@@ -755,7 +765,7 @@ CustomOPTranspileResult
                                             false,
                                             num_dims - 2 /*start_dim*/));
 
-      code.e("using Matmul$LayoutBAligned = $;",
+      code.e(FMT_STR("using Matmul$LayoutBAligned = $;"),
              output.guid,
              get_mma_stensor_aligned_layout(input1,
                                             meta1,
@@ -764,11 +774,12 @@ CustomOPTranspileResult
                                             false,
                                             num_dims - 2 /*start_dim*/));
 
-      code.e("using Matmul$Kernel = tb::Matmul<$, $, Layout<Shape<Int<$>, "
-             "Int<$>, _1>>, $, $, Matmul$LayoutA, Matmul$LayoutB, "
-             "Matmul$LayoutC, Matmul$LayoutAAligned, Matmul$LayoutBAligned,"
-             "NUM_THREADS, "
-             "$, $>;",
+      code.e(FMT_STR(
+                 "using Matmul$Kernel = tb::Matmul<$, $, Layout<Shape<Int<$>, "
+                 "Int<$>, _1>>, $, $, Matmul$LayoutA, Matmul$LayoutB, "
+                 "Matmul$LayoutC, Matmul$LayoutAAligned, Matmul$LayoutBAligned,"
+                 "NUM_THREADS, "
+                 "$, $>;"),
              output.guid,
              get_datatype_str(input0.data_type),
              mma_atom_str,
@@ -785,9 +796,11 @@ CustomOPTranspileResult
              is_accum_in_reg ? false : is_store_accum);
       // Allocate accumulators in register files (if needed)
       if (is_accum_in_reg) {
-        code.e("auto matmul_$_accum = Matmul$Kernel::get_mma_rC(thread_idx);",
-               output.guid,
-               output.guid);
+        code.e(
+            FMT_STR(
+                "auto matmul_$_accum = Matmul$Kernel::get_mma_rC(thread_idx);"),
+            output.guid,
+            output.guid);
       }
       code.e("");
     }
@@ -801,8 +814,8 @@ CustomOPTranspileResult
 
   if (profiling) {
     code.e("PROFILER_CLOSURE_PARAMS_DECL");
-    code.e("PROFILER_INIT(profiler_buffer, 0, $, (threadIdx.x % "
-           "128 == 0));",
+    code.e(FMT_STR("PROFILER_INIT(profiler_buffer, 0, $, (threadIdx.x % "
+                   "128 == 0));"),
            config.num_consumer_wgs + config.num_producer_wgs);
   }
 
@@ -814,11 +827,11 @@ CustomOPTranspileResult
       tb::STensor const &output = input_op->output_tensors.at(0);
       assert(input_op->forloop_dim >= 0);
       if (profiling) {
-        code.e("PROFILER_EVENT_START($, static_cast<uint32_t>(0));",
+        code.e(FMT_STR("PROFILER_EVENT_START($, static_cast<uint32_t>(0));"),
                (input_op->op_type - type::TB_UNKOWN));
       }
-      code.e("STensor$InputAtom::run(stensor$_async_copy_buf, "
-             "dtensor$_tile_ptr, thread_idx);",
+      code.e(FMT_STR("STensor$InputAtom::run(stensor$_async_copy_buf, "
+                     "dtensor$_tile_ptr, thread_idx);"),
              output.guid,
              output.guid,
              dtensor.guid);
@@ -838,32 +851,32 @@ CustomOPTranspileResult
     size_t chain_size = chain.size();
     if (chain_size == 1) {
       // Not fused with anything
-      return fmt("tb::EpilogueStore<$>", dtype);
+      return fmt(FMT_STR("tb::EpilogueStore<$>"), dtype);
     }
     // Deal with the last operator
-    string res = fmt("tb::EpilogueStore<$>", dtype);
+    string res = fmt(FMT_STR("tb::EpilogueStore<$>"), dtype);
     for (size_t i = chain_size - 1; i >= 1; --i) {
       tb::TBOperator const *cur_op = chain[i].first;
       if (cur_op->op_type == type::TB_FORLOOP_ACCUM_NO_RED_OP) {
         // Can only occur as the last operator in the chain
         assert(i == chain_size - 1);
-        res = fmt("tb::EpilogueStoreAccum<$>", dtype);
+        res = fmt(FMT_STR("tb::EpilogueStoreAccum<$>"), dtype);
       } else if (cur_op->op_type == type::TB_EXP_OP) {
-        res = fmt("tb::EpilogueExp<$, $>", dtype, res);
+        res = fmt(FMT_STR("tb::EpilogueExp<$, $>"), dtype, res);
       } else if (cur_op->op_type == type::TB_SILU_OP) {
-        res = fmt("tb::EpilogueSILU<$, $>", dtype, res);
+        res = fmt(FMT_STR("tb::EpilogueSILU<$, $>"), dtype, res);
       } else if (cur_op->op_type == type::TB_GELU_OP) {
-        res = fmt("tb::EpilogueGELU<$, $>", dtype, res);
+        res = fmt(FMT_STR("tb::EpilogueGELU<$, $>"), dtype, res);
       } else if (cur_op->op_type == type::TB_RELU_OP) {
-        res = fmt("tb::EpilogueRELU<$, $>", dtype, res);
+        res = fmt(FMT_STR("tb::EpilogueRELU<$, $>"), dtype, res);
       } else if (cur_op->op_type == type::TB_CLAMP_OP) {
-        res = fmt("tb::EpilogueClamp<$, $>", dtype, res);
+        res = fmt(FMT_STR("tb::EpilogueClamp<$, $>"), dtype, res);
       } else if (cur_op->op_type == type::TB_SQUARE_OP) {
-        res = fmt("tb::EpilogueSquare<$, $>", dtype, res);
+        res = fmt(FMT_STR("tb::EpilogueSquare<$, $>"), dtype, res);
       } else if (cur_op->op_type == type::TB_SQRT_OP) {
-        res = fmt("tb::EpilogueSqrt<$, $>", dtype, res);
+        res = fmt(FMT_STR("tb::EpilogueSqrt<$, $>"), dtype, res);
       } else if (cur_op->op_type == type::TB_MUL_SCALAR_OP) {
-        res = fmt("tb::EpilogueMulScalar<$, $>", dtype, res);
+        res = fmt(FMT_STR("tb::EpilogueMulScalar<$, $>"), dtype, res);
       } else {
         assert(0 && "Unknown operator type");
       }
@@ -884,10 +897,10 @@ CustomOPTranspileResult
       std::string op_type_str;
       to_json(op_type_str, op->op_type);
       code.e("{");
-      code.e("// OP type: $", op_type_str);
+      code.e(FMT_STR("// OP type: $"), op_type_str);
 
       if (profiling) {
-        code.e("PROFILER_EVENT_START($, $);",
+        code.e(FMT_STR("PROFILER_EVENT_START($, $);"),
                (op->op_type - type::TB_UNKOWN),
                is_in_loop ? "static_cast<uint32_t>(for_idx)"
                           : "static_cast<uint32_t>(0)");
@@ -908,8 +921,9 @@ CustomOPTranspileResult
               dtensor_metas.at(dtensor.guid).strides[cur_op->forloop_dim];
           bool is_async_copy = pipelined_input_ops.count(cur_op);
           assert(!is_async_copy); // Async copies should be proceeded separately
-          code.e("STensor$InputAtom::run(stensor$_ptr, dtensor$_tile_ptr + "
-                 "$*for_idx, thread_idx);",
+          code.e(FMT_STR(
+                     "STensor$InputAtom::run(stensor$_ptr, dtensor$_tile_ptr + "
+                     "$*for_idx, thread_idx);"),
                  output.guid,
                  output.guid,
                  dtensor.guid,
@@ -932,21 +946,25 @@ CustomOPTranspileResult
             int tile_side_len = stensor.dim[cur_op->forloop_dim];
             size_t forloop_dim_stride =
                 dtensor_metas.at(dtensor.guid).strides[cur_op->forloop_dim];
-            code.e("STensor$OutputAtom::run(stensor$_ptr, dtensor$_tile_ptr + "
-                   "$*for_idx, thread_idx);",
-                   stensor.guid,
-                   stensor.guid,
-                   dtensor.guid,
-                   tile_side_len * forloop_dim_stride);
+            code.e(
+                FMT_STR(
+                    "STensor$OutputAtom::run(stensor$_ptr, dtensor$_tile_ptr + "
+                    "$*for_idx, thread_idx);"),
+                stensor.guid,
+                stensor.guid,
+                dtensor.guid,
+                tile_side_len * forloop_dim_stride);
 #endif
           } else {
             tb::STensor const &stensor = cur_op->input_tensors.at(0);
             kn::DTensor const &dtensor = cur_op->dtensor;
-            code.e("STensor$OutputAtom::run(dtensor$_tile_ptr, stensor$_ptr, "
-                   "thread_idx);",
-                   stensor.guid,
-                   dtensor.guid,
-                   stensor.guid);
+            code.e(
+                FMT_STR(
+                    "STensor$OutputAtom::run(dtensor$_tile_ptr, stensor$_ptr, "
+                    "thread_idx);"),
+                stensor.guid,
+                dtensor.guid,
+                stensor.guid);
           }
           break;
         }
@@ -957,22 +975,25 @@ CustomOPTranspileResult
           sguid_t output_guid = output.guid;
           if (output_op_meta.is_accum_in_reg) {
             // Accumulator is in register
-            code.e("Matmul$Kernel::run(matmul_$_accum, stensor$_ptr, "
-                   "stensor$_ptr, (char*)(buf+0), thread_idx);",
+            code.e(FMT_STR("Matmul$Kernel::run(matmul_$_accum, stensor$_ptr, "
+                           "stensor$_ptr, (char*)(buf+0), thread_idx);"),
                    output_guid,
                    output_guid,
                    input0.guid,
                    input1.guid);
           } else {
-            code.e("auto mma_rC = Matmul$Kernel::get_mma_rC(thread_idx);",
-                   output_guid);
-            code.e("Matmul$Kernel::run(mma_rC, stensor$_ptr, stensor$_ptr, "
-                   "(char*)(buf+0), thread_idx);",
+            code.e(
+                FMT_STR("auto mma_rC = Matmul$Kernel::get_mma_rC(thread_idx);"),
+                output_guid);
+            code.e(FMT_STR(
+                       "Matmul$Kernel::run(mma_rC, stensor$_ptr, stensor$_ptr, "
+                       "(char*)(buf+0), thread_idx);"),
                    output_guid,
                    input0.guid,
                    input1.guid);
-            code.e("Matmul$Kernel::write_back_mma_rC(stensor$_ptr, mma_rC, "
-                   "thread_idx);",
+            code.e(FMT_STR(
+                       "Matmul$Kernel::write_back_mma_rC(stensor$_ptr, mma_rC, "
+                       "thread_idx);"),
                    output_guid,
                    output_guid);
           }
@@ -1027,26 +1048,27 @@ CustomOPTranspileResult
               input, stensor_metas.at(input.guid), iter_dim);
           string final_out_layout = mov_last_get_stensor_layout(
               output, stensor_metas.at(output.guid), iter_dim);
-          code.e("using InLayout = $;", in_layout);
-          code.e("using OutLayout = $;", final_out_layout);
+          code.e(FMT_STR("using InLayout = $;"), in_layout);
+          code.e(FMT_STR("using OutLayout = $;"), final_out_layout);
           // Get the epilogue
           string epilogue = transpile_fusion_epilogue(
               sched_node.ops, get_datatype_str(input.data_type));
           // Define and run the kernel
-          code.e("using Kernel = tb::ElementUnaryKernel<$, "
-                 "tb::ElementUnaryOpType::$, OutLayout, InLayout, "
-                 "NUM_THREADS, $>;",
+          code.e(FMT_STR("using Kernel = tb::ElementUnaryKernel<$, "
+                         "tb::ElementUnaryOpType::$, OutLayout, InLayout, "
+                         "NUM_THREADS, $>;"),
                  get_datatype_str(input.data_type),
                  get_tb_op_str(cur_op->op_type),
                  epilogue);
           // add scalar chains for epilogue
           // code.e("const float scalars[] = {A, B, C}");
           code.e(append_epilogue_scalars(sched_node.ops));
-          code.e("Kernel::run(stensor$_ptr, stensor$_ptr, thread_idx, $, "
-                 "scalars);",
-                 output.guid,
-                 input.guid,
-                 cur_op->scalar);
+          code.e(
+              FMT_STR("Kernel::run(stensor$_ptr, stensor$_ptr, thread_idx, $, "
+                      "scalars);"),
+              output.guid,
+              input.guid,
+              cur_op->scalar);
           break;
         }
         case type::TB_ADD_OP:
@@ -1092,25 +1114,27 @@ CustomOPTranspileResult
               input1, stensor_metas.at(input1.guid), iter_dim);
           string final_out_layout = mov_last_get_stensor_layout(
               output, stensor_metas.at(output.guid), iter_dim);
-          code.e("using In0Layout = $;", in0_layout);
-          code.e("using In1Layout = $;", in1_layout);
-          code.e("using OutLayout = $;", final_out_layout);
+          code.e(FMT_STR("using In0Layout = $;"), in0_layout);
+          code.e(FMT_STR("using In1Layout = $;"), in1_layout);
+          code.e(FMT_STR("using OutLayout = $;"), final_out_layout);
           // Get the epilogue
           string epilogue = transpile_fusion_epilogue(
               sched_node.ops, get_datatype_str(input0.data_type));
           // Define and run the kernel
-          code.e("using Kernel = tb::ElementBinaryKernel<$, "
-                 "tb::ElementBinaryOpType::$, OutLayout, In0Layout, In1Layout, "
-                 "NUM_THREADS, $>;",
+          code.e(FMT_STR("using Kernel = tb::ElementBinaryKernel<$, "
+                         "tb::ElementBinaryOpType::$, OutLayout, In0Layout, "
+                         "In1Layout, "
+                         "NUM_THREADS, $>;"),
                  get_datatype_str(input0.data_type),
                  op_type_str,
                  epilogue);
           code.e(append_epilogue_scalars(sched_node.ops));
-          code.e("Kernel::run(stensor$_ptr, stensor$_ptr, stensor$_ptr, "
-                 "thread_idx, scalars);",
-                 output.guid,
-                 input0.guid,
-                 input1.guid);
+          code.e(
+              FMT_STR("Kernel::run(stensor$_ptr, stensor$_ptr, stensor$_ptr, "
+                      "thread_idx, scalars);"),
+              output.guid,
+              input0.guid,
+              input1.guid);
           break;
         }
         case type::TB_REDUCTION_0_OP:
@@ -1157,22 +1181,22 @@ CustomOPTranspileResult
               mov_last_get_stensor_layout(output, final_output_meta, iter_dim);
           int cute_reduc_dim = reduc_dim < iter_dim ? num_dims - 1 - reduc_dim
                                                     : num_dims - reduc_dim;
-          code.e("using InLayout = $;", in_layout);
-          code.e("using OutLayout = $;", final_out_layout);
+          code.e(FMT_STR("using InLayout = $;"), in_layout);
+          code.e(FMT_STR("using OutLayout = $;"), final_out_layout);
           // Get the epilogue
           string epilogue = transpile_fusion_epilogue(
               sched_node.ops, get_datatype_str(input.data_type));
           // Define and run the kernel
-          code.e("using Kernel = tb::ReductionKernel<$, "
-                 "OutLayout, InLayout, $, NUM_THREADS, $>;",
+          code.e(FMT_STR("using Kernel = tb::ReductionKernel<$, "
+                         "OutLayout, InLayout, $, NUM_THREADS, $>;"),
                  get_datatype_str(input.data_type),
                  cute_reduc_dim,
                  epilogue);
           code.e(append_epilogue_scalars(sched_node.ops));
-          code.e(
-              "Kernel::run(stensor$_ptr, stensor$_ptr, thread_idx, scalars);",
-              output.guid,
-              input.guid);
+          code.e(FMT_STR("Kernel::run(stensor$_ptr, stensor$_ptr, thread_idx, "
+                         "scalars);"),
+                 output.guid,
+                 input.guid);
           break;
         }
         case type::TB_REDUCTION_0_MAX_OP:
@@ -1220,20 +1244,23 @@ CustomOPTranspileResult
               mov_last_get_stensor_layout(diff, diff_meta, iter_dim);
           int cute_reduc_dim = reduc_dim < iter_dim ? num_dims - 1 - reduc_dim
                                                     : num_dims - reduc_dim;
-          code.e("using InLayout = $;", in_layout);
-          code.e("using UpdatedMaxLayout = $;", updated_max_layout);
-          code.e("using DiffLayout = $;", diff_layout);
+          code.e(FMT_STR("using InLayout = $;"), in_layout);
+          code.e(FMT_STR("using UpdatedMaxLayout = $;"), updated_max_layout);
+          code.e(FMT_STR("using DiffLayout = $;"), diff_layout);
           // Should not have epilogue
           // Define and run the kernel
-          code.e("using Kernel = tb::ReductionMaxKernel<$, "
-                 "UpdatedMaxLayout, DiffLayout, InLayout, $, NUM_THREADS>;",
-                 get_datatype_str(input.data_type),
-                 cute_reduc_dim);
-          code.e("Kernel::run(stensor$_ptr, stensor$_ptr, stensor$_ptr, "
-                 "thread_idx);",
-                 updated_max.guid,
-                 diff.guid,
-                 input.guid);
+          code.e(
+              FMT_STR(
+                  "using Kernel = tb::ReductionMaxKernel<$, "
+                  "UpdatedMaxLayout, DiffLayout, InLayout, $, NUM_THREADS>;"),
+              get_datatype_str(input.data_type),
+              cute_reduc_dim);
+          code.e(
+              FMT_STR("Kernel::run(stensor$_ptr, stensor$_ptr, stensor$_ptr, "
+                      "thread_idx);"),
+              updated_max.guid,
+              diff.guid,
+              input.guid);
           break;
         }
         case type::TB_FORLOOP_ACCUM_NO_RED_OP: {
@@ -1264,14 +1291,15 @@ CustomOPTranspileResult
               input, stensor_metas.at(input.guid), iter_dim);
           string accum_layout = mov_last_get_stensor_layout(
               accum, stensor_metas.at(accum.guid), iter_dim);
-          code.e("using Kernel = tb::ForloopAccumKernel<$, $, $, "
-                 "NUM_THREADS>;",
+          code.e(FMT_STR("using Kernel = tb::ForloopAccumKernel<$, $, $, "
+                         "NUM_THREADS>;"),
                  get_datatype_str(input.data_type),
                  accum_layout,
                  in_layout);
-          code.e("Kernel::run(stensor$_ptr, stensor$_ptr, thread_idx);",
-                 accum.guid,
-                 input.guid);
+          code.e(
+              FMT_STR("Kernel::run(stensor$_ptr, stensor$_ptr, thread_idx);"),
+              accum.guid,
+              input.guid);
           break;
         }
         case type::TB_FORLOOP_ACCUM_NO_RED_RESCALE_OP: {
@@ -1305,17 +1333,19 @@ CustomOPTranspileResult
               rescale, stensor_metas.at(rescale.guid), iter_dim);
           string accum_layout = mov_last_get_stensor_layout(
               accum, stensor_metas.at(accum.guid), iter_dim);
-          code.e("using Kernel = tb::ForloopAccumRescaleKernel<$, $, $, $, "
-                 "NUM_THREADS>;",
+          code.e(FMT_STR(
+                     "using Kernel = tb::ForloopAccumRescaleKernel<$, $, $, $, "
+                     "NUM_THREADS>;"),
                  get_datatype_str(input.data_type),
                  accum_layout,
                  in_layout,
                  rescale_layout);
-          code.e("Kernel::run(stensor$_ptr, stensor$_ptr, stensor$_ptr, "
-                 "thread_idx);",
-                 accum.guid,
-                 input.guid,
-                 rescale.guid);
+          code.e(
+              FMT_STR("Kernel::run(stensor$_ptr, stensor$_ptr, stensor$_ptr, "
+                      "thread_idx);"),
+              accum.guid,
+              input.guid,
+              rescale.guid);
           break;
         }
         case type::TB_CONCAT_0_OP:
@@ -1333,12 +1363,12 @@ CustomOPTranspileResult
           break;
         }
         default: {
-          assert(fmt("Unknown TB op: $", op->op_type).c_str());
+          assert(fmt(FMT_STR("Unknown TB op: $"), op->op_type).c_str());
         }
       }
       // Profiler
       if (profiling) {
-        code.e("PROFILER_EVENT_END($, $);",
+        code.e(FMT_STR("PROFILER_EVENT_END($, $);"),
                (op->op_type - type::TB_UNKOWN),
                is_in_loop ? "static_cast<uint32_t>(for_idx)"
                           : "static_cast<uint32_t>(0)");
@@ -1353,12 +1383,13 @@ CustomOPTranspileResult
   // TODO(intlsy) Loop unrolling
   assert(g.forloop_range >= 1);
   code.e("// The main loop");
-  code.e("for (int for_idx = 0; for_idx < $; for_idx++) {", g.forloop_range);
+  code.e(FMT_STR("for (int for_idx = 0; for_idx < $; for_idx++) {"),
+         g.forloop_range);
 
   if (!pipelined_input_ops.empty()) {
     code.e("{");
     code.e("// Issue async copies for the next round");
-    code.e("if (for_idx+1 != $) {", g.forloop_range);
+    code.e(FMT_STR("if (for_idx+1 != $) {"), g.forloop_range);
     for (tb::TBInputOp const *input_op : pipelined_input_ops) {
       assert(input_op->forloop_dim >= 0);
       kn::DTensor const &dtensor = input_op->dtensor;
@@ -1366,8 +1397,8 @@ CustomOPTranspileResult
       int tile_side_len = output.dim[input_op->forloop_dim];
       size_t forloop_dim_stride =
           dtensor_metas.at(dtensor.guid).strides[input_op->forloop_dim];
-      code.e("STensor$InputAtom::run(stensor$_ptr, dtensor$_tile_ptr + "
-             "$*(for_idx+1), thread_idx);",
+      code.e(FMT_STR("STensor$InputAtom::run(stensor$_ptr, dtensor$_tile_ptr + "
+                     "$*(for_idx+1), thread_idx);"),
              output.guid,
              output.guid,
              dtensor.guid,
@@ -1382,14 +1413,17 @@ CustomOPTranspileResult
     // Event end of async cp
     if (profiling && !pipelined_input_ops.empty()) {
       for (tb::TBInputOp const *input_op : pipelined_input_ops) {
-        code.e("PROFILER_EVENT_END($, static_cast<uint32_t>(for_idx));",
-               (input_op->op_type - type::TB_UNKOWN));
+        code.e(
+            FMT_STR("PROFILER_EVENT_END($, static_cast<uint32_t>(for_idx));"),
+            (input_op->op_type - type::TB_UNKOWN));
       }
       // start the next round of async cp profiling
-      code.e("if (for_idx+1 != $){", g.forloop_range);
+      code.e(FMT_STR("if (for_idx+1 != $){"), g.forloop_range);
       for (tb::TBInputOp const *input_op : pipelined_input_ops) {
-        code.e("PROFILER_EVENT_START($, static_cast<uint32_t>(for_idx)+1);",
-               (input_op->op_type - type::TB_UNKOWN));
+        code.e(
+            FMT_STR(
+                "PROFILER_EVENT_START($, static_cast<uint32_t>(for_idx)+1);"),
+            (input_op->op_type - type::TB_UNKOWN));
       }
       code.e("}");
     }
@@ -1398,7 +1432,8 @@ CustomOPTranspileResult
     for (tb::TBInputOp const *input_op : pipelined_input_ops) {
       tb::STensor const &output = input_op->output_tensors.at(0);
       sguid_t guid = output.guid;
-      code.e("SWAP(stensor$_ptr, stensor$_async_copy_buf);", guid, guid);
+      code.e(
+          FMT_STR("SWAP(stensor$_ptr, stensor$_async_copy_buf);"), guid, guid);
     }
 
     code.e("}");
@@ -1436,11 +1471,12 @@ CustomOPTranspileResult
       tb::TBForloopAccumOp const *accum_op =
           dynamic_cast<tb::TBForloopAccumOp const *>(last_op);
       tb::STensor const &accum = accum_op->output_tensors.at(0);
-      in_reg_writeback.e("Matmul$Kernel::write_back_mma_rC(stensor$_ptr, "
-                         "matmul_$_accum, thread_idx);",
-                         accum.guid,
-                         accum.guid,
-                         accum.guid);
+      in_reg_writeback.e(
+          FMT_STR("Matmul$Kernel::write_back_mma_rC(stensor$_ptr, "
+                  "matmul_$_accum, thread_idx);"),
+          accum.guid,
+          accum.guid,
+          accum.guid);
       num_in_reg_accums += 1;
     }
   }
@@ -52,7 +52,7 @@ static string get_cute_layout(vector<int> dims, vector<size_t> strides) {
   assert(dims.size() == strides.size());
   std::reverse(dims.begin(), dims.end());
   std::reverse(strides.begin(), strides.end());
-  return fmt("Layout<Shape<$>, Stride<$>>",
+  return fmt(FMT_STR("Layout<Shape<$>, Stride<$>>"),
              map_to_cute_int(dims),
              map_to_cute_int(strides));
 }
@@ -74,7 +74,7 @@ static auto get_cute_layout_array(vector<int> dims,
 static string get_reversed_cute_layout(vector<int> dims,
                                        vector<size_t> strides) {
   assert(dims.size() == strides.size());
-  return fmt("Layout<Shape<$>, Stride<$>>",
+  return fmt(FMT_STR("Layout<Shape<$>, Stride<$>>"),
              map_to_cute_int(dims),
              map_to_cute_int(strides));
 }
@@ -123,7 +123,7 @@ static string get_stensor_layout(tb::STensor const &stensor,
     } else {
       // XOR-based swizzling
       return fmt(
-          "decltype(composition(Swizzle<$, $, $>{}, ${}))",
+          FMT_STR("decltype(composition(Swizzle<$, $, $>{}, ${}))"),
           meta.xor_swizzle_b,
           meta.xor_swizzle_m,
           meta.xor_swizzle_s,
@@ -137,7 +137,7 @@ static string get_stensor_layout(tb::STensor const &stensor,
     // that)
     return get_layout_detail::get_cute_layout(stensor, meta, start_dim);
   } else {
-    return fmt("decltype(composition(Swizzle<$, $, $>{}, ${}))",
+    return fmt(FMT_STR("decltype(composition(Swizzle<$, $, $>{}, ${}))"),
                meta.xor_swizzle_b,
                meta.xor_swizzle_m,
                meta.xor_swizzle_s,
@@ -233,7 +233,7 @@ static string append_epilogue_scalars(
     } else if (is_threadblock_element_unary(chain.at(i).first->op_type)) {
       tb::TBElementUnaryOp const *tb_unary_op =
           dynamic_cast<tb::TBElementUnaryOp const *>(chain.at(i).first);
-      res.append(fmt("$f, ", tb_unary_op->scalar));
+      fmt_to(res, FMT_STR("$f, "), tb_unary_op->scalar);
     } else {
       res.append("0.0f, ");
     }
@@ -282,9 +282,10 @@ static std::pair<bool, std::vector<int64_t>>
   for (int i = 0; i < op->input_tensors.size(); i++) {
     int64_t input_id = op->input_tensors.at(i).guid;
     if (pipeline_inputs.find(input_id) != pipeline_inputs.end()) {
-      code.e("int read_idx_$ = hopper_async_pipeline_$.consumer_wait();",
-             input_id,
-             input_id);
+      code.e(
+          FMT_STR("int read_idx_$ = hopper_async_pipeline_$.consumer_wait();"),
+          input_id,
+          input_id);
       // only wait once
       pipeline_inputs.erase(input_id);
       input_ids_waited.push_back(input_id);
@@ -317,7 +318,7 @@ CustomOPTranspileResult
   // Allocate a kernel name
   static int custom_kernel_idx_counter = 0;
   int cur_custom_kernel_idx = custom_kernel_idx_counter++;
-  string func_name = fmt("custom_kernel_$", cur_custom_kernel_idx);
+  string func_name = fmt(FMT_STR("custom_kernel_$"), cur_custom_kernel_idx);
 
   if (GPU_CC::H100 != config.target_cc ||
       (config::MAX_NUM_WARP_GROUPS <
@@ -349,16 +350,16 @@ CustomOPTranspileResult
   CodeKeeper code;
   string thread_idx;
   if (g.block_dim.y > 1 || g.block_dim.z > 1) {
-    thread_idx = fmt("threadIdx.x + threadIdx.y * $ + threadIdx.z * $",
+    thread_idx = fmt(FMT_STR("threadIdx.x + threadIdx.y * $ + threadIdx.z * $"),
                      g.block_dim.x,
                      g.block_dim.x * g.block_dim.y);
   } else {
     thread_idx = "threadIdx.x";
   }
-  code.e("int thread_idx = $;", thread_idx);
-  code.e("static constexpr int NUM_THREADS = $;", 128);
+  code.e(FMT_STR("int thread_idx = $;"), thread_idx);
+  code.e(FMT_STR("static constexpr int NUM_THREADS = $;"), 128);
 
-  code.e("static constexpr int CONSUMER_NUM_THREADS = $;",
+  code.e(FMT_STR("static constexpr int CONSUMER_NUM_THREADS = $;"),
          config::NUM_THREADS_PER_GROUP * config.num_consumer_wgs);
 
   // Define STensor as cute::Tensor
@@ -366,7 +367,7 @@ CustomOPTranspileResult
   code.e("extern __shared__ char buf[];");
   size_t barrier_addr = mem_plan.smem_size;
   for (auto [guid, addr] : mem_plan.addrs) {
-    code.e("$ *stensor$_ptr = ($*)(buf + $);",
+    code.e(FMT_STR("$ *stensor$_ptr = ($*)(buf + $);"),
            get_datatype_str(op->input_tensors[0].data_type),
            guid,
            get_datatype_str(op->input_tensors[0].data_type),
@@ -399,7 +400,7 @@ CustomOPTranspileResult
       assert(dtensor.num_dims == stensor.num_dims);
       assert(dtensor.data_type == stensor.data_type);
 
-      code.e("// Copy for G->S: dtensor $ -> stensor $",
+      code.e(FMT_STR("// Copy for G->S: dtensor $ -> stensor $"),
              dtensor.guid,
              stensor.guid);
 
@@ -416,10 +417,11 @@ CustomOPTranspileResult
           int num_tbs = dim == 0   ? g.grid_dim.x
                         : dim == 1 ? g.grid_dim.y
                                    : g.grid_dim.z;
-          offset += fmt(" + blockIdx.$*$*$",
-                        (char)"xyz"[dim],
-                        dtensor.dim[div_dim] / num_tbs,
-                        dtensor_meta.strides[div_dim]);
+          fmt_to(offset,
+                 FMT_STR(" + blockIdx.$*$*$"),
+                 (char)"xyz"[dim],
+                 dtensor.dim[div_dim] / num_tbs,
+                 dtensor_meta.strides[div_dim]);
         }
       }
 
@@ -428,7 +430,7 @@ CustomOPTranspileResult
       bool use_async_copy = op_meta.is_pipelined_input;
 
       if (!(use_chunked_copy) || (!use_async_copy)) {
-        code.e("const $ *dtensor$_tile_ptr = dtensor$_ptr $;",
+        code.e(FMT_STR("const $ *dtensor$_tile_ptr = dtensor$_ptr $;"),
                get_datatype_str(dtensor.data_type),
                dtensor.guid,
                dtensor.guid,
@@ -444,12 +446,13 @@ CustomOPTranspileResult
         assert(!use_async_copy);
         string dtensor_tile_layout = get_dtensor_tile_layout(
             dtensor, dtensor_meta, stensor, stensor_meta, d_innermost_dim);
-        code.e(
-            "using DTensor$TileLayout = $;", dtensor.guid, dtensor_tile_layout);
+        code.e(FMT_STR("using DTensor$TileLayout = $;"),
+               dtensor.guid,
+               dtensor_tile_layout);
         // Non-chunked, synchronous copy
         code.e(
-            "using STensor$InputAtom = tb::InputNonChunkedSyncCopy<$, "
-            "$, DTensor$TileLayout, NUM_THREADS>;",
+            FMT_STR("using STensor$InputAtom = tb::InputNonChunkedSyncCopy<$, "
+                    "$, DTensor$TileLayout, NUM_THREADS>;"),
             stensor.guid,
             get_datatype_str(stensor.data_type),
             mov_last_get_stensor_layout(stensor, stensor_meta, d_innermost_dim),
@@ -457,17 +460,19 @@ CustomOPTranspileResult
       } else {
         string dtensor_tile_layout = get_dtensor_tile_layout(
             dtensor, dtensor_meta, stensor, stensor_meta, real_innermost_dim);
-        code.e(
-            "using DTensor$TileLayout = $;", dtensor.guid, dtensor_tile_layout);
+        code.e(FMT_STR("using DTensor$TileLayout = $;"),
+               dtensor.guid,
+               dtensor_tile_layout);
         if (!use_async_copy) {
           // Chunked, synchronous copy
-          code.e("using STensor$InputAtom = tb::InputChunkedSyncCopy<$, "
-                 "$, DTensor$TileLayout, NUM_THREADS>;",
-                 stensor.guid,
-                 get_datatype_str(stensor.data_type),
-                 mov_last_get_stensor_layout(
-                     stensor, stensor_meta, real_innermost_dim),
-                 dtensor.guid);
+          code.e(
+              FMT_STR("using STensor$InputAtom = tb::InputChunkedSyncCopy<$, "
+                      "$, DTensor$TileLayout, NUM_THREADS>;"),
+              stensor.guid,
+              get_datatype_str(stensor.data_type),
+              mov_last_get_stensor_layout(
+                  stensor, stensor_meta, real_innermost_dim),
+              dtensor.guid);
         } else {
           pipelined_input_ops.insert(cur_op);
           assert(cur_op->output_tensors.size() == 1);
@@ -503,23 +508,25 @@ CustomOPTranspileResult
               partition_logic,
               g.forloop_range,
               m_input ? forloop_dim : (dtensor.num_dims - 1 - forloop_dim));
-          code.e(
-              "tb::HopperAsyncPipeline<$> "
-              "hopper_async_pipeline_$((void *) (buf + $), (tb::warpgroup_id() "
-              "== $ && tb::warp_id() % mirage::config::NUM_WARPS_PER_GROUP == "
-              "0), tb::warpgroup_id() < $, $, $);",
-              config.pipeline_stages,
-              stensor.guid,
-              barrier_addr,
-              config.num_consumer_wgs,
-              config.num_consumer_wgs,
-              stensor_meta.num_phy_elems *
-                  type::get_datatype_size(stensor.data_type),
-              config.num_consumer_wgs);
+          code.e(FMT_STR("tb::HopperAsyncPipeline<$> "
+                         "hopper_async_pipeline_$((void *) (buf + $), "
+                         "(tb::warpgroup_id() "
+                         "== $ && tb::warp_id() % "
+                         "mirage::config::NUM_WARPS_PER_GROUP == "
+                         "0), tb::warpgroup_id() < $, $, $);"),
+                 config.pipeline_stages,
+                 stensor.guid,
+                 barrier_addr,
+                 config.num_consumer_wgs,
+                 config.num_consumer_wgs,
+                 stensor_meta.num_phy_elems *
+                     type::get_datatype_size(stensor.data_type),
+                 config.num_consumer_wgs);
 
           code.e(
-              "using STensor$InputAtom = tb::InputTMAAsyncCopy<$, $, "
-              "$, decltype(tma_$), decltype(hopper_async_pipeline_$), $, $>;",
+              FMT_STR("using STensor$InputAtom = tb::InputTMAAsyncCopy<$, $, "
+                      "$, decltype(tma_$), decltype(hopper_async_pipeline_$), "
+                      "$, $>;"),
               stensor.guid,
               get_datatype_str(stensor.data_type),
               smem_layout,
@@ -540,7 +547,7 @@ CustomOPTranspileResult
               SrcMNKLayout,
               smem_layout,
               stensor_meta.m_input,
-              fmt("shape(${})", smem_layout),
+              fmt(FMT_STR("shape(${})"), smem_layout),
               {1, 1, 1},
               dims,
               strides,
@@ -579,41 +586,41 @@ CustomOPTranspileResult
 
     if (profiling) {
       code.e_front(
-          "__global__ void  __launch_bounds__($) "
-          "$($ $, $, uint64_t *profiler_buffer) {",
+          FMT_STR("__global__ void  __launch_bounds__($) "
+                  "$($ $, $, uint64_t *profiler_buffer) {"),
           num_threads,
           func_name,
           tma,
           map<kn::DTensor, string>(op->output_tensors,
                                    [](kn::DTensor const &dtensor) -> string {
                                      return fmt(
-                                         "$* dtensor$_ptr",
+                                         FMT_STR("$* dtensor$_ptr"),
                                          get_datatype_str(dtensor.data_type),
                                          dtensor.guid);
                                    }),
           map<kn::DTensor, string>(
               op->input_tensors, [](kn::DTensor const &dtensor) -> string {
-                return fmt("$ const* dtensor$_ptr",
+                return fmt(FMT_STR("$ const* dtensor$_ptr"),
                            get_datatype_str(dtensor.data_type),
                            dtensor.guid);
               }));
     } else {
       code.e_front(
-          "__global__ void  __launch_bounds__($) "
-          "$($ $, $) {",
+          FMT_STR("__global__ void  __launch_bounds__($) "
+                  "$($ $, $) {"),
           num_threads,
           func_name,
           tma,
           map<kn::DTensor, string>(op->output_tensors,
                                    [](kn::DTensor const &dtensor) -> string {
                                      return fmt(
-                                         "$* dtensor$_ptr",
+                                         FMT_STR("$* dtensor$_ptr"),
                                          get_datatype_str(dtensor.data_type),
                                          dtensor.guid);
                                    }),
           map<kn::DTensor, string>(
               op->input_tensors, [](kn::DTensor const &dtensor) -> string {
-                return fmt("$ const* dtensor$_ptr",
+                return fmt(FMT_STR("$ const* dtensor$_ptr"),
                            get_datatype_str(dtensor.data_type),
                            dtensor.guid);
               }));
@@ -648,9 +655,9 @@ CustomOPTranspileResult
         cur_op)); // An input op in pre_loop_nodes should not be software
                   // pipelined since they do not have forloop_dim
     num_pre_loop_copies += 1;
-    code.e("STensor$InputAtom::run(stensor$_ptr, "
-           "dtensor$_tile_ptr, "
-           "thread_idx);",
+    code.e(FMT_STR("STensor$InputAtom::run(stensor$_ptr, "
+                   "dtensor$_tile_ptr, "
+                   "thread_idx);"),
            stensor.guid,
            stensor.guid,
            cur_op->dtensor.guid);
@@ -673,7 +680,7 @@ CustomOPTranspileResult
       assert(dtensor.num_dims == stensor.num_dims);
       assert(dtensor.data_type == stensor.data_type);
 
-      code.e("// Copy for S->G: stensor $ -> dtensor $",
+      code.e(FMT_STR("// Copy for S->G: stensor $ -> dtensor $"),
              stensor.guid,
              dtensor.guid);
 
@@ -692,13 +699,14 @@ CustomOPTranspileResult
           // The output tensor MUST be divided along this dimension, as stated
           // in the paper
           assert(div_dim >= 0);
-          offset += fmt(" + blockIdx.$*$*$",
-                        (char)"xyz"[dim],
-                        dtensor.dim[div_dim] / num_tbs,
-                        dtensor_meta.strides[div_dim]);
+          fmt_to(offset,
+                 FMT_STR(" + blockIdx.$*$*$"),
+                 (char)"xyz"[dim],
+                 dtensor.dim[div_dim] / num_tbs,
+                 dtensor_meta.strides[div_dim]);
         }
       }
-      code.e("$ *dtensor$_tile_ptr = dtensor$_ptr $;",
+      code.e(FMT_STR("$ *dtensor$_tile_ptr = dtensor$_ptr $;"),
              get_datatype_str(dtensor.data_type),
              dtensor.guid,
              dtensor.guid,
@@ -711,10 +719,12 @@ CustomOPTranspileResult
         int d_innermost_dim = dtensor_meta.innermost_dim;
         string dtensor_tile_layout = get_dtensor_tile_layout(
             dtensor, dtensor_meta, stensor, stensor_meta, d_innermost_dim);
-        code.e(
-            "using DTensor$TileLayout = $;", dtensor.guid, dtensor_tile_layout);
-        code.e("using STensor$OutputAtom = tb::OutputNonChunkedSyncCopy<$, "
-               "DTensor$TileLayout, $, NUM_THREADS>;",
+        code.e(FMT_STR("using DTensor$TileLayout = $;"),
+               dtensor.guid,
+               dtensor_tile_layout);
+        code.e(FMT_STR(
+                   "using STensor$OutputAtom = tb::OutputNonChunkedSyncCopy<$, "
+                   "DTensor$TileLayout, $, NUM_THREADS>;"),
                stensor.guid,
                get_datatype_str(dtensor.data_type),
                dtensor.guid,
@@ -723,15 +733,17 @@ CustomOPTranspileResult
       } else {
         string dtensor_tile_layout = get_dtensor_tile_layout(
             dtensor, dtensor_meta, stensor, stensor_meta, real_innermost_dim);
-        code.e(
-            "using DTensor$TileLayout = $;", dtensor.guid, dtensor_tile_layout);
-        code.e("using STensor$OutputAtom = tb::OutputChunkedSyncCopy<$, "
-               "DTensor$TileLayout, $, NUM_THREADS>;",
-               stensor.guid,
-               get_datatype_str(dtensor.data_type),
+        code.e(FMT_STR("using DTensor$TileLayout = $;"),
                dtensor.guid,
-               mov_last_get_stensor_layout(
-                   stensor, stensor_meta, real_innermost_dim));
+               dtensor_tile_layout);
+        code.e(
+            FMT_STR("using STensor$OutputAtom = tb::OutputChunkedSyncCopy<$, "
+                    "DTensor$TileLayout, $, NUM_THREADS>;"),
+            stensor.guid,
+            get_datatype_str(dtensor.data_type),
+            dtensor.guid,
+            mov_last_get_stensor_layout(
+                stensor, stensor_meta, real_innermost_dim));
       }
       // TODO(intlsy) Support TMA
     }
@@ -757,8 +769,8 @@ CustomOPTranspileResult
       for (int i = 0; i < accum.num_dims; ++i) {
         num_elems = std::max(num_elems, accum.dim[i] * accum_meta.strides[i]);
       }
-      code.e("tb::ClearAccumlatorKernel<$, $, "
-             "NUM_THREADS>::run(stensor$_ptr, thread_idx);",
+      code.e(FMT_STR("tb::ClearAccumlatorKernel<$, $, "
+                     "NUM_THREADS>::run(stensor$_ptr, thread_idx);"),
              get_datatype_str(accum.data_type),
              num_elems,
              accum.guid);
@@ -816,20 +828,20 @@ CustomOPTranspileResult
       // For threadblock matmul, cute requires 2-d matrices as inputs / outputs,
       // we assert that all other leading dimensions are of size 1, and only use
       // the last two dimensions when generating layouts
-      code.e("using Matmul$LayoutA = $;",
+      code.e(FMT_STR("using Matmul$LayoutA = $;"),
              output.guid,
              get_stensor_layout(input0, meta0, num_dims - 2 /*start_dim*/));
-      code.e("using Matmul$LayoutB = $;",
+      code.e(FMT_STR("using Matmul$LayoutB = $;"),
              output.guid,
              get_stensor_layout(input1, meta1, num_dims - 2 /*start_dim*/));
-      code.e("using Matmul$LayoutC = $;",
+      code.e(FMT_STR("using Matmul$LayoutC = $;"),
              output.guid,
              get_stensor_layout(output, meta2, num_dims - 2 /*start_dim*/));
 
-      code.e("using Matmul$Kernel = tb::Hopper_Matmul<$, "
-             "$, $, Matmul$LayoutA, Matmul$LayoutB, "
-             "Matmul$LayoutC, NUM_THREADS, "
-             "$, $, $, $, $, $>;",
+      code.e(FMT_STR("using Matmul$Kernel = tb::Hopper_Matmul<$, "
+                     "$, $, Matmul$LayoutA, Matmul$LayoutB, "
+                     "Matmul$LayoutC, NUM_THREADS, "
+                     "$, $, $, $, $, $>;"),
              output.guid,
              get_datatype_str(input0.data_type),
              is_ldmatrix_avail,
@@ -844,9 +856,11 @@ CustomOPTranspileResult
              meta1.is_pipelined_input,
              config.pipeline_stages);
       if (is_accum_in_reg) {
-        code.e("auto matmul_$_accum = Matmul$Kernel::get_mma_rC(thread_idx);",
-               output.guid,
-               output.guid);
+        code.e(
+            FMT_STR(
+                "auto matmul_$_accum = Matmul$Kernel::get_mma_rC(thread_idx);"),
+            output.guid,
+            output.guid);
       }
       code.e("");
     }
@@ -865,37 +879,39 @@ CustomOPTranspileResult
     code.e("int warpgroup_id = tb::warpgroup_id();");
     if (profiling) {
       code.e("PROFILER_CLOSURE_PARAMS_DECL");
-      code.e("PROFILER_INIT(profiler_buffer, warpgroup_id, $, (threadIdx.x % "
-             "128 == 0));",
-             config.num_consumer_wgs + config.num_producer_wgs);
+      code.e(
+          FMT_STR(
+              "PROFILER_INIT(profiler_buffer, warpgroup_id, $, (threadIdx.x % "
+              "128 == 0));"),
+          config.num_consumer_wgs + config.num_producer_wgs);
     }
     // run producers
-    code.e("if (warpgroup_id == $) {", config.num_consumer_wgs);
+    code.e(FMT_STR("if (warpgroup_id == $) {"), config.num_consumer_wgs);
     // allocate tma register files
     uint32_t tma_reg = config.num_consumer_wgs == 1 ? 56 : 32;
 
     // code.e("tb::wg_decrease_regs<$>();", tma_reg);
     code.e("if (tb::warp_id_in_wg() == 0) {");
 
-    code.e("for (uint32_t for_idx = 0; for_idx < $; for_idx++) {",
+    code.e(FMT_STR("for (uint32_t for_idx = 0; for_idx < $; for_idx++) {"),
            g.forloop_range);
     for (auto const &[stensor_id, op] : pipeline_inputs) {
       if (profiling) {
-        code.e("PROFILER_EVENT_START($, $);",
+        code.e(FMT_STR("PROFILER_EVENT_START($, $);"),
                (op->op_type - type::TB_UNKOWN),
                "static_cast<uint32_t>(for_idx)");
       }
-      code.e(fmt("STensor$InputAtom::run(tma_$, stensor$_ptr, "
-                 " $, $, $, for_idx, hopper_async_pipeline_$);",
-                 stensor_id,
-                 op->dtensor.guid,
-                 stensor_id,
-                 op->input_map.x,
-                 op->input_map.y,
-                 op->input_map.z,
-                 stensor_id));
+      code.e(FMT_STR("STensor$InputAtom::run(tma_$, stensor$_ptr, "
+                     " $, $, $, for_idx, hopper_async_pipeline_$);"),
+             stensor_id,
+             op->dtensor.guid,
+             stensor_id,
+             op->input_map.x,
+             op->input_map.y,
+             op->input_map.z,
+             stensor_id);
       if (profiling) {
-        code.e("PROFILER_EVENT_END($, $);",
+        code.e(FMT_STR("PROFILER_EVENT_END($, $);"),
                (op->op_type - type::TB_UNKOWN),
                "static_cast<uint32_t>(for_idx)");
       }
@@ -918,32 +934,32 @@ CustomOPTranspileResult
     size_t chain_size = chain.size();
     if (chain_size == 1) {
       // Not fused with anything
-      return fmt("tb::EpilogueStore<$>", dtype);
+      return fmt(FMT_STR("tb::EpilogueStore<$>"), dtype);
     }
     // Deal with the last operator
-    string res = fmt("tb::EpilogueStore<$>", dtype);
+    string res = fmt(FMT_STR("tb::EpilogueStore<$>"), dtype);
     for (size_t i = chain_size - 1; i >= 1; --i) {
       tb::TBOperator const *cur_op = chain[i].first;
       if (cur_op->op_type == type::TB_FORLOOP_ACCUM_NO_RED_OP) {
         // Can only occur as the last operator in the chain
         assert(i == chain_size - 1);
-        res = fmt("tb::EpilogueStoreAccum<$>", dtype);
+        res = fmt(FMT_STR("tb::EpilogueStoreAccum<$>"), dtype);
       } else if (cur_op->op_type == type::TB_EXP_OP) {
-        res = fmt("tb::EpilogueExp<$, $>", dtype, res);
+        res = fmt(FMT_STR("tb::EpilogueExp<$, $>"), dtype, res);
       } else if (cur_op->op_type == type::TB_SILU_OP) {
-        res = fmt("tb::EpilogueSILU<$, $>", dtype, res);
+        res = fmt(FMT_STR("tb::EpilogueSILU<$, $>"), dtype, res);
       } else if (cur_op->op_type == type::TB_GELU_OP) {
-        res = fmt("tb::EpilogueGELU<$, $>", dtype, res);
+        res = fmt(FMT_STR("tb::EpilogueGELU<$, $>"), dtype, res);
       } else if (cur_op->op_type == type::TB_RELU_OP) {
-        res = fmt("tb::EpilogueRELU<$, $>", dtype, res);
+        res = fmt(FMT_STR("tb::EpilogueRELU<$, $>"), dtype, res);
       } else if (cur_op->op_type == type::TB_CLAMP_OP) {
-        res = fmt("tb::EpilogueClamp<$, $>", dtype, res);
+        res = fmt(FMT_STR("tb::EpilogueClamp<$, $>"), dtype, res);
       } else if (cur_op->op_type == type::TB_SQUARE_OP) {
-        res = fmt("tb::EpilogueSquare<$, $>", dtype, res);
+        res = fmt(FMT_STR("tb::EpilogueSquare<$, $>"), dtype, res);
       } else if (cur_op->op_type == type::TB_SQRT_OP) {
-        res = fmt("tb::EpilogueSqrt<$, $>", dtype, res);
+        res = fmt(FMT_STR("tb::EpilogueSqrt<$, $>"), dtype, res);
       } else if (cur_op->op_type == type::TB_MUL_SCALAR_OP) {
-        res = fmt("tb::EpilogueMulScalar<$, $>", dtype, res);
+        res = fmt(FMT_STR("tb::EpilogueMulScalar<$, $>"), dtype, res);
       } else {
         assert(0 && "Unknown operator type");
       }
@@ -968,7 +984,7 @@ CustomOPTranspileResult
       std::string op_type_str;
       to_json(op_type_str, op->op_type);
       code.e("{");
-      code.e("// OP type: $", op_type_str);
+      code.e(FMT_STR("// OP type: $"), op_type_str);
 
       auto [need_advance_pipeline, pipe_ids] =
           add_loop_node_consumer_wait_if_need(
@@ -977,7 +993,7 @@ CustomOPTranspileResult
       // define
       if (pipe_tma && profiling) {
         // 2000 - 2999
-        code.e("PROFILER_EVENT_START($, $);",
+        code.e(FMT_STR("PROFILER_EVENT_START($, $);"),
                (op->op_type - type::TB_UNKOWN),
                is_in_loop ? "static_cast<uint32_t>(for_idx)"
                           : "static_cast<uint32_t>(0)");
@@ -996,11 +1012,13 @@ CustomOPTranspileResult
           } else {
             tb::STensor const &stensor = cur_op->input_tensors.at(0);
             kn::DTensor const &dtensor = cur_op->dtensor;
-            code.e("STensor$OutputAtom::run(dtensor$_tile_ptr, stensor$_ptr, "
-                   "thread_idx);",
-                   stensor.guid,
-                   dtensor.guid,
-                   stensor.guid);
+            code.e(
+                FMT_STR(
+                    "STensor$OutputAtom::run(dtensor$_tile_ptr, stensor$_ptr, "
+                    "thread_idx);"),
+                stensor.guid,
+                dtensor.guid,
+                stensor.guid);
           }
           break;
         }
@@ -1013,50 +1031,64 @@ CustomOPTranspileResult
           // always pipeline for MMA
           if (need_advance_pipeline) {
             smem_read_output_guids.push_back(output_guid);
-            // code.e(fmt("PipelineState smem_pipe_read_$;", output_guid));
+            // code.e("PipelineState smem_pipe_read_$;", output_guid);
             if (output_op_meta.is_accum_in_reg) {
               // Accumulator is in register
-              code.e("Matmul$Kernel::run(matmul_$_accum, stensor$_ptr, "
-                     "stensor$_ptr, (char*)(buf+0), thread_idx, read_idx_$);",
-                     output_guid,
-                     output_guid,
-                     input0.guid,
-                     input1.guid,
-                     pipe_ids.at(0));
+              code.e(
+                  FMT_STR(
+                      "Matmul$Kernel::run(matmul_$_accum, stensor$_ptr, "
+                      "stensor$_ptr, (char*)(buf+0), thread_idx, read_idx_$);"),
+                  output_guid,
+                  output_guid,
+                  input0.guid,
+                  input1.guid,
+                  pipe_ids.at(0));
             } else {
-              code.e("auto mma_rC = Matmul$Kernel::get_mma_rC(thread_idx);",
-                     output_guid);
-              code.e("Matmul$Kernel::run(mma_rC, stensor$_ptr, stensor$_ptr, "
-                     "(char*)(buf+0), thread_idx, read_idx_$);",
-                     output_guid,
-                     input0.guid,
-                     input1.guid,
-                     pipe_ids.at(0));
-              code.e("Matmul$Kernel::write_back_mma_rC(stensor$_ptr, mma_rC, "
-                     "thread_idx);",
-                     output_guid,
-                     output_guid);
+              code.e(
+                  FMT_STR(
+                      "auto mma_rC = Matmul$Kernel::get_mma_rC(thread_idx);"),
+                  output_guid);
+              code.e(
+                  FMT_STR(
+                      "Matmul$Kernel::run(mma_rC, stensor$_ptr, stensor$_ptr, "
+                      "(char*)(buf+0), thread_idx, read_idx_$);"),
+                  output_guid,
+                  input0.guid,
+                  input1.guid,
+                  pipe_ids.at(0));
+              code.e(
+                  FMT_STR(
+                      "Matmul$Kernel::write_back_mma_rC(stensor$_ptr, mma_rC, "
+                      "thread_idx);"),
+                  output_guid,
+                  output_guid);
             }
           } else {
             if (output_op_meta.is_accum_in_reg) {
-              code.e("Matmul$Kernel::run(matmul_$_accum, stensor$_ptr, "
-                     "stensor$_ptr, (char*)(buf+0), thread_idx);",
+              code.e(FMT_STR("Matmul$Kernel::run(matmul_$_accum, stensor$_ptr, "
+                             "stensor$_ptr, (char*)(buf+0), thread_idx);"),
                      output_guid,
                      output_guid,
                      input0.guid,
                      input1.guid);
             } else {
-              code.e("auto mma_rC = Matmul$Kernel::get_mma_rC(thread_idx);",
-                     output_guid);
-              code.e("Matmul$Kernel::run(mma_rC, stensor$_ptr, stensor$_ptr, "
-                     "(char*)(buf+0), thread_idx);",
-                     output_guid,
-                     input0.guid,
-                     input1.guid);
-              code.e("Matmul$Kernel::write_back_mma_rC(stensor$_ptr, mma_rC, "
-                     "thread_idx);",
-                     output_guid,
-                     output_guid);
+              code.e(
+                  FMT_STR(
+                      "auto mma_rC = Matmul$Kernel::get_mma_rC(thread_idx);"),
+                  output_guid);
+              code.e(
+                  FMT_STR(
+                      "Matmul$Kernel::run(mma_rC, stensor$_ptr, stensor$_ptr, "
+                      "(char*)(buf+0), thread_idx);"),
+                  output_guid,
+                  input0.guid,
+                  input1.guid);
+              code.e(
+                  FMT_STR(
+                      "Matmul$Kernel::write_back_mma_rC(stensor$_ptr, mma_rC, "
+                      "thread_idx);"),
+                  output_guid,
+                  output_guid);
             }
           }
 
@@ -1102,24 +1134,25 @@ CustomOPTranspileResult
               input, stensor_metas.at(input.guid), iter_dim);
           string final_out_layout = mov_last_get_stensor_layout(
               output, stensor_metas.at(output.guid), iter_dim);
-          code.e("using InLayout = $;", in_layout);
-          code.e("using OutLayout = $;", final_out_layout);
+          code.e(FMT_STR("using InLayout = $;"), in_layout);
+          code.e(FMT_STR("using OutLayout = $;"), final_out_layout);
           // Get the epilogue
           string epilogue = transpile_fusion_epilogue(
               sched_node.ops, get_datatype_str(input.data_type));
           // Define and run the kernel
-          code.e("using Kernel = tb::ElementUnaryKernel<$, "
-                 "tb::ElementUnaryOpType::$, OutLayout, InLayout, "
-                 "CONSUMER_NUM_THREADS, $>;",
+          code.e(FMT_STR("using Kernel = tb::ElementUnaryKernel<$, "
+                         "tb::ElementUnaryOpType::$, OutLayout, InLayout, "
+                         "CONSUMER_NUM_THREADS, $>;"),
                  get_datatype_str(input.data_type),
                  get_tb_op_str(cur_op->op_type),
                  epilogue);
           code.e(append_epilogue_scalars(sched_node.ops));
-          code.e("Kernel::run(stensor$_ptr, stensor$_ptr, thread_idx, $, "
-                 "scalars);",
-                 output.guid,
-                 input.guid,
-                 cur_op->scalar);
+          code.e(
+              FMT_STR("Kernel::run(stensor$_ptr, stensor$_ptr, thread_idx, $, "
+                      "scalars);"),
+              output.guid,
+              input.guid,
+              cur_op->scalar);
           break;
         }
         case type::TB_ADD_OP:
@@ -1163,25 +1196,27 @@ CustomOPTranspileResult
               input1, stensor_metas.at(input1.guid), iter_dim);
           string final_out_layout = mov_last_get_stensor_layout(
               output, stensor_metas.at(output.guid), iter_dim);
-          code.e("using In0Layout = $;", in0_layout);
-          code.e("using In1Layout = $;", in1_layout);
-          code.e("using OutLayout = $;", final_out_layout);
+          code.e(FMT_STR("using In0Layout = $;"), in0_layout);
+          code.e(FMT_STR("using In1Layout = $;"), in1_layout);
+          code.e(FMT_STR("using OutLayout = $;"), final_out_layout);
           // Get the epilogue
           string epilogue = transpile_fusion_epilogue(
               sched_node.ops, get_datatype_str(input0.data_type));
           // Define and run the kernel
-          code.e("using Kernel = tb::ElementBinaryKernel<$, "
-                 "tb::ElementBinaryOpType::$, OutLayout, In0Layout, In1Layout, "
-                 "CONSUMER_NUM_THREADS, $>;",
+          code.e(FMT_STR("using Kernel = tb::ElementBinaryKernel<$, "
+                         "tb::ElementBinaryOpType::$, OutLayout, In0Layout, "
+                         "In1Layout, "
+                         "CONSUMER_NUM_THREADS, $>;"),
                  get_datatype_str(input0.data_type),
                  op_type_str,
                  epilogue);
           code.e(append_epilogue_scalars(sched_node.ops));
-          code.e("Kernel::run(stensor$_ptr, stensor$_ptr, stensor$_ptr, "
-                 "thread_idx, scalars);",
-                 output.guid,
-                 input0.guid,
-                 input1.guid);
+          code.e(
+              FMT_STR("Kernel::run(stensor$_ptr, stensor$_ptr, stensor$_ptr, "
+                      "thread_idx, scalars);"),
+              output.guid,
+              input0.guid,
+              input1.guid);
           break;
         }
         case type::TB_REDUCTION_0_OP:
@@ -1228,22 +1263,22 @@ CustomOPTranspileResult
               mov_last_get_stensor_layout(output, final_output_meta, iter_dim);
           int cute_reduc_dim = reduc_dim < iter_dim ? num_dims - 1 - reduc_dim
                                                     : num_dims - reduc_dim;
-          code.e("using InLayout = $;", in_layout);
-          code.e("using OutLayout = $;", final_out_layout);
+          code.e(FMT_STR("using InLayout = $;"), in_layout);
+          code.e(FMT_STR("using OutLayout = $;"), final_out_layout);
           // Get the epilogue
           string epilogue = transpile_fusion_epilogue(
               sched_node.ops, get_datatype_str(input.data_type));
           // Define and run the kernel
-          code.e("using Kernel = tb::ReductionKernel<$, "
-                 "OutLayout, InLayout, $, CONSUMER_NUM_THREADS, $>;",
+          code.e(FMT_STR("using Kernel = tb::ReductionKernel<$, "
+                         "OutLayout, InLayout, $, CONSUMER_NUM_THREADS, $>;"),
                  get_datatype_str(input.data_type),
                  cute_reduc_dim,
                  epilogue);
           code.e(append_epilogue_scalars(sched_node.ops));
-          code.e(
-              "Kernel::run(stensor$_ptr, stensor$_ptr, thread_idx, scalars);",
-              output.guid,
-              input.guid);
+          code.e(FMT_STR("Kernel::run(stensor$_ptr, stensor$_ptr, thread_idx, "
+                         "scalars);"),
+                 output.guid,
+                 input.guid);
           break;
         }
         case type::TB_FORLOOP_ACCUM_NO_RED_OP: {
@@ -1274,14 +1309,15 @@ CustomOPTranspileResult
               input, stensor_metas.at(input.guid), iter_dim);
           string accum_layout = mov_last_get_stensor_layout(
               accum, stensor_metas.at(accum.guid), iter_dim);
-          code.e("using Kernel = tb::ForloopAccumKernel<$, $, $, "
-                 "NUM_THREADS>;",
+          code.e(FMT_STR("using Kernel = tb::ForloopAccumKernel<$, $, $, "
+                         "NUM_THREADS>;"),
                  get_datatype_str(input.data_type),
                  accum_layout,
                  in_layout);
-          code.e("Kernel::run(stensor$_ptr, stensor$_ptr, thread_idx);",
-                 accum.guid,
-                 input.guid);
+          code.e(
+              FMT_STR("Kernel::run(stensor$_ptr, stensor$_ptr, thread_idx);"),
+              accum.guid,
+              input.guid);
           break;
         }
         case type::TB_CONCAT_0_OP:
@@ -1299,11 +1335,11 @@ CustomOPTranspileResult
           break;
         }
         default: {
-          assert(fmt("Unknown TB op: $", op->op_type).c_str());
+          assert(fmt(FMT_STR("Unknown TB op: $"), op->op_type).c_str());
         }
       }
       if (pipe_tma && profiling) {
-        code.e("PROFILER_EVENT_END($, $);",
+        code.e(FMT_STR("PROFILER_EVENT_END($, $);"),
                (op->op_type - type::TB_UNKOWN),
                is_in_loop ? "static_cast<uint32_t>(for_idx)"
                           : "static_cast<uint32_t>(0)");
@@ -1331,7 +1367,7 @@ CustomOPTranspileResult
   std::map<int64_t, tb::TBInputOp const *> copy_of_inputs = pipeline_inputs;
   assert(g.forloop_range >= 1);
 
-  code.e("for (uint32_t for_idx = 0; for_idx < $; for_idx++) {",
+  code.e(FMT_STR("for (uint32_t for_idx = 0; for_idx < $; for_idx++) {"),
          g.forloop_range);
 
   // warpgroup_id
@@ -1355,7 +1391,7 @@ CustomOPTranspileResult
 
   if (!copy_of_inputs.empty()) {
     for (auto const &[pipe_id, op] : copy_of_inputs) {
-      code.e("hopper_async_pipeline_$.consumer_release();", pipe_id);
+      code.e(FMT_STR("hopper_async_pipeline_$.consumer_release();"), pipe_id);
     }
   }
 
@@ -1374,11 +1410,12 @@ CustomOPTranspileResult
       tb::TBForloopAccumOp const *accum_op =
           dynamic_cast<tb::TBForloopAccumOp const *>(last_op);
       tb::STensor const &accum = accum_op->output_tensors.at(0);
-      in_reg_writeback.e("Matmul$Kernel::write_back_mma_rC(stensor$_ptr, "
-                         "matmul_$_accum, thread_idx);",
-                         accum.guid,
-                         accum.guid,
-                         accum.guid);
+      in_reg_writeback.e(
+          FMT_STR("Matmul$Kernel::write_back_mma_rC(stensor$_ptr, "
+                  "matmul_$_accum, thread_idx);"),
+          accum.guid,
+          accum.guid,
+          accum.guid);
 
       num_in_reg_accums += 1;
     }
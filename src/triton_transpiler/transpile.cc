@@ -316,26 +316,29 @@ TritonTranspileResult TritonTranspiler::transpile_ugraph() {
       std::string shape;
       kn::DTensor dtensor = op->output_tensors.at(0);
       for (int i = 0; i < dtensor.num_dims; i++) {
-        shape += fmt("$,", dtensor.dim[i]);
+        shape += fmt(FMT_STR("$,"), dtensor.dim[i]);
       }
-      exec.e("$ = torch.randn(($), dtype=torch.float16).to(device=device)",
-             fmt("dtensor$", dtensor.guid),
+      exec.e(FMT_STR(
+                 "$ = torch.randn(($), dtype=torch.float16).to(device=device)"),
+             fmt(FMT_STR("dtensor$"), dtensor.guid),
              shape);
-      input_tensor_names.push_back(fmt("dtensor$", dtensor.guid));
+      input_tensor_names.push_back(fmt(FMT_STR("dtensor$"), dtensor.guid));
     } else if (op->op_type == KN_OUTPUT_OP) {
       kn::DTensor dtensor = op->input_tensors.at(0);
-      output_tensor_names.push_back(fmt("dtensor$", dtensor.guid));
+      output_tensor_names.push_back(fmt(FMT_STR("dtensor$"), dtensor.guid));
     } else if (op->op_type != KN_OUTPUT_OP) {
       for (int i = 0; i < (int)(op->output_tensors.size()); i++) {
         kn::DTensor dtensor = op->output_tensors.at(i);
         std::string shape;
         for (int j = 0; j < dtensor.num_dims; j++) {
-          shape += fmt("$,", dtensor.dim[j]);
+          shape += fmt(FMT_STR("$,"), dtensor.dim[j]);
         }
-        exec.e("$ = torch.zeros(($), dtype=torch.float16).to(device=device)",
-               fmt("dtensor$", dtensor.guid),
-               shape);
-        middle_tensor_names.push_back(fmt("dtensor$", dtensor.guid));
+        exec.e(
+            FMT_STR(
+                "$ = torch.zeros(($), dtype=torch.float16).to(device=device)"),
+            fmt(FMT_STR("dtensor$"), dtensor.guid),
+            shape);
+        middle_tensor_names.push_back(fmt(FMT_STR("dtensor$"), dtensor.guid));
         middle_tensor_shapes.push_back(shape);
       }
     }
@@ -364,13 +367,14 @@ TritonTranspileResult TritonTranspiler::transpile_ugraph() {
       output_tensor_str += ", ";
     }
   }
-  entrance_func.e(
-      "def execute_mugraph($, $):", input_tensor_str, output_tensor_str);
+  entrance_func.e(FMT_STR("def execute_mugraph($, $):"),
+                  input_tensor_str,
+                  output_tensor_str);
   entrance_func.inc_indent();
   entrance_func.e("device = torch.device('cuda')");
   for (size_t i = 0; i < middle_tensor_names.size(); i++) {
     entrance_func.e(
-        "$ = torch.zeros(($), dtype=torch.float16).to(device=device)",
+        FMT_STR("$ = torch.zeros(($), dtype=torch.float16).to(device=device)"),
         middle_tensor_names[i],
         middle_tensor_shapes[i]);
   }
@@ -392,7 +396,7 @@ TritonTranspileResult TritonTranspiler::transpile_ugraph() {
         std::vector<std::string> tensor_names;
         for (kn::DTensor const &dtensor :
              Combine(cur_op->output_tensors, cur_op->input_tensors)) {
-          std::string tensor_name = fmt("dtensor$", dtensor.guid);
+          std::string tensor_name = fmt(FMT_STR("dtensor$"), dtensor.guid);
           tensor_names.push_back(tensor_name);
         }
 
@@ -401,7 +405,7 @@ TritonTranspileResult TritonTranspiler::transpile_ugraph() {
 
         // Add kernel definition and launch
         custom_kernels.e(result.code);
-        std::string new_line = fmt("$[($, $, $)]($)",
+        std::string new_line = fmt(FMT_STR("$[($, $, $)]($)"),
                                    result.func_name,
                                    bgraph.grid_dim.x,
                                    bgraph.grid_dim.y,
@@ -416,22 +420,22 @@ TritonTranspileResult TritonTranspiler::transpile_ugraph() {
         kn::DTensor &input0 = op->input_tensors[0];
         kn::DTensor &input1 = op->input_tensors[1];
         kn::DTensor &output = op->output_tensors[0];
-        std::string new_line = fmt("$ = ops.matmul($, $)",
-                                   fmt("dtensor$", output.guid),
-                                   fmt("dtensor$", input0.guid),
-                                   fmt("dtensor$", input1.guid));
+        std::string new_line = fmt(FMT_STR("$ = ops.matmul($, $)"),
+                                   fmt(FMT_STR("dtensor$"), output.guid),
+                                   fmt(FMT_STR("dtensor$"), input0.guid),
+                                   fmt(FMT_STR("dtensor$"), input1.guid));
         exec.e(new_line);
         // if output of this op is in output_tensor_names
         // we should use .copy_() to copy the result back
         if (std::find(output_tensor_names.begin(),
                       output_tensor_names.end(),
-                      fmt("dtensor$", output.guid)) !=
+                      fmt(FMT_STR("dtensor$"), output.guid)) !=
             output_tensor_names.end()) {
-          entrance_func.e(fmt("$.copy_($)",
-                              fmt("dtensor$", output.guid),
-                              fmt("ops.matmul($, $)",
-                                  fmt("dtensor$", input0.guid),
-                                  fmt("dtensor$", input1.guid))));
+          entrance_func.e(fmt(FMT_STR("$.copy_($)"),
+                              fmt(FMT_STR("dtensor$"), output.guid),
+                              fmt(FMT_STR("ops.matmul($, $)"),
+                                  fmt(FMT_STR("dtensor$"), input0.guid),
+                                  fmt(FMT_STR("dtensor$"), input1.guid))));
         } else {
           entrance_func.e(new_line);
         }
@@ -449,13 +453,13 @@ TritonTranspileResult TritonTranspiler::transpile_ugraph() {
         int N = CEIL_DIV(input0.dim[1], BLOCK_SIZE_X);
 
         std::string grid =
-            fmt("($, $)", M, N); // TODO: Currently only support 2D
+            fmt(FMT_STR("($, $)"), M, N); // TODO: Currently only support 2D
         std::string new_line =
-            fmt("elementwise_binary_kernel[$]($, $, $, $, $, $)",
+            fmt(FMT_STR("elementwise_binary_kernel[$]($, $, $, $, $, $)"),
                 grid,
-                fmt("dtensor$", input0.guid),
-                fmt("dtensor$", input1.guid),
-                fmt("dtensor$", output.guid),
+                fmt(FMT_STR("dtensor$"), input0.guid),
+                fmt(FMT_STR("dtensor$"), input1.guid),
+                fmt(FMT_STR("dtensor$"), output.guid),
                 M,
                 N,
                 op->op_type);
@@ -473,14 +477,15 @@ TritonTranspileResult TritonTranspiler::transpile_ugraph() {
         int N = CEIL_DIV(input.dim[1], BLOCK_SIZE_X);
 
         std::string grid =
-            fmt("($, $)", M, N); // TODO: Currently only support 2D
-        std::string new_line = fmt("elementwise_unary_kernel[$]($, $, $, $, $)",
-                                   grid,
-                                   fmt("dtensor$", input.guid),
-                                   fmt("dtensor$", output.guid),
-                                   M,
-                                   N,
-                                   op->op_type);
+            fmt(FMT_STR("($, $)"), M, N); // TODO: Currently only support 2D
+        std::string new_line =
+            fmt(FMT_STR("elementwise_unary_kernel[$]($, $, $, $, $)"),
+                grid,
+                fmt(FMT_STR("dtensor$"), input.guid),
+                fmt(FMT_STR("dtensor$"), output.guid),
+                M,
+                N,
+                op->op_type);
         exec.e(new_line);
         entrance_func.e(new_line);
         break;
@@ -504,14 +509,15 @@ TritonTranspileResult TritonTranspiler::transpile_ugraph() {
         int M = CEIL_DIV(input.dim[0], BLOCK_SIZE_Y);
         int N = CEIL_DIV(input.dim[1], BLOCK_SIZE_X);
         std::string grid =
-            fmt("($, $)", M, N); // TODO: Currently only support 2D
-        std::string new_line = fmt("reduce_sum_kernel[$]($, $, $, $, $)",
-                                   grid,
-                                   fmt("dtensor$", input.guid),
-                                   fmt("dtensor$", output.guid),
-                                   M,
-                                   N,
-                                   dim);
+            fmt(FMT_STR("($, $)"), M, N); // TODO: Currently only support 2D
+        std::string new_line =
+            fmt(FMT_STR("reduce_sum_kernel[$]($, $, $, $, $)"),
+                grid,
+                fmt(FMT_STR("dtensor$"), input.guid),
+                fmt(FMT_STR("dtensor$"), output.guid),
+                M,
+                N,
+                dim);
         exec.e(new_line);
         entrance_func.e(new_line);
         break;
@@ -540,7 +546,7 @@ TritonTranspileResult TritonTranspiler::transpile_ugraph() {
   }
 
   // Combine all sections
-  std::string code = fmt("$\n$\n$\n$",
+  std::string code = fmt(FMT_STR("$\n$\n$\n$"),
                          header.to_string(),
                          custom_kernels.to_string(),
                          entrance_func.to_string(),
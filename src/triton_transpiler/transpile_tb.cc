@@ -53,7 +53,7 @@ using std::string;
 inline std::string get_tensor_shape(tb::STensor const &stensor) {
   std::string shape = "";
   for (int i = 0; i < stensor.num_dims; i++) {
-    shape += fmt("$,", stensor.dim[i]);
+    shape += fmt(FMT_STR("$,"), stensor.dim[i]);
   }
   return shape;
 }
@@ -108,11 +108,11 @@ std::string generate_mask_expr(tb::STensor const &stensor,
         base_expr = "tl.arange(0, $)[:, None]";
       }
 
-      std::string condition =
-          fmt("$ < $", fmt(base_expr, adjusted_dims[i]), stensor.dim[i]);
+      std::string condition = fmt(
+          FMT_STR("$ < $"), fmt(base_expr, adjusted_dims[i]), stensor.dim[i]);
 
-      condition =
-          fmt("($) < $", fmt(base_expr, adjusted_dims[i]), stensor.dim[i]);
+      condition = fmt(
+          FMT_STR("($) < $"), fmt(base_expr, adjusted_dims[i]), stensor.dim[i]);
 
       mask_conditions.push_back(condition);
     }
@@ -151,17 +151,17 @@ std::string get_input_dim_expr(int dim_idx,
   std::vector<std::string> offset_terms;
 
   if (imap.x == dim_idx) {
-    offset_terms.push_back(fmt("tl.program_id(0) * $", block_size));
+    offset_terms.push_back(fmt(FMT_STR("tl.program_id(0) * $"), block_size));
   }
   if (imap.y == dim_idx) {
-    offset_terms.push_back(fmt("tl.program_id(1) * $", block_size));
+    offset_terms.push_back(fmt(FMT_STR("tl.program_id(1) * $"), block_size));
   }
   if (imap.z == dim_idx) {
-    offset_terms.push_back(fmt("tl.program_id(2) * $", block_size));
+    offset_terms.push_back(fmt(FMT_STR("tl.program_id(2) * $"), block_size));
   }
 
   if (forloop_dim == dim_idx) {
-    offset_terms.push_back(fmt("i * $", block_size));
+    offset_terms.push_back(fmt(FMT_STR("i * $"), block_size));
   }
 
   std::string result = fmt(base_expr, round_up_to_power_of_2(block_size));
@@ -170,7 +170,7 @@ std::string get_input_dim_expr(int dim_idx,
     for (size_t i = 1; i < offset_terms.size(); i++) {
       offset += " + " + offset_terms[i];
     }
-    result = fmt("$ + $", offset, result);
+    result = fmt(FMT_STR("$ + $"), offset, result);
   }
 
   return result;
@@ -182,13 +182,13 @@ std::string get_output_dim_expr(int dim_idx, int3 const &omap, int block_size) {
 
   // 处理program_id映射
   if (omap.x == dim_idx) {
-    offset_terms.push_back(fmt("tl.program_id(0) * $", block_size));
+    offset_terms.push_back(fmt(FMT_STR("tl.program_id(0) * $"), block_size));
   }
   if (omap.y == dim_idx) {
-    offset_terms.push_back(fmt("tl.program_id(1) * $", block_size));
+    offset_terms.push_back(fmt(FMT_STR("tl.program_id(1) * $"), block_size));
   }
   if (omap.z == dim_idx) {
-    offset_terms.push_back(fmt("tl.program_id(2) * $", block_size));
+    offset_terms.push_back(fmt(FMT_STR("tl.program_id(2) * $"), block_size));
   }
 
   // 组合表达式
@@ -198,7 +198,7 @@ std::string get_output_dim_expr(int dim_idx, int3 const &omap, int block_size) {
     for (size_t i = 1; i < offset_terms.size(); i++) {
       offset += " + " + offset_terms[i];
     }
-    result = fmt("$ + $", offset, result);
+    result = fmt(FMT_STR("$ + $"), offset, result);
   }
 
   return result;
@@ -208,21 +208,21 @@ TritonCustomOPTranspileResult
     TritonTranspiler::transpile_kn_custom_op(kn::KNCustomizedOp const *op) {
   tb::Graph const &g = op->bgraph;
   int cur_kernel_idx = kernel_idx_counter++;
-  string func_name = fmt("custom_kernel_$", cur_kernel_idx);
+  string func_name = fmt(FMT_STR("custom_kernel_$"), cur_kernel_idx);
 
   // Generate kernel function
   CodeKeeper code;
   code.e("@triton.jit");
-  code.e("def $($, $):",
+  code.e(FMT_STR("def $($, $):"),
          func_name,
          map<kn::DTensor, string>(op->output_tensors,
                                   [](kn::DTensor const &dtensor) -> string {
-                                    return fmt("dtensor$: tl.tensor",
+                                    return fmt(FMT_STR("dtensor$: tl.tensor"),
                                                dtensor.guid);
                                   }),
          map<kn::DTensor, string>(
              op->input_tensors, [](kn::DTensor const &dtensor) -> string {
-               return fmt("dtensor$: tl.tensor", dtensor.guid);
+               return fmt(FMT_STR("dtensor$: tl.tensor"), dtensor.guid);
              }));
   code.inc_indent();
 
@@ -237,17 +237,17 @@ TritonCustomOPTranspileResult
       std::string shape = "";
       for (int i = 0; i < stensor.num_dims; i++) {
         // shape += fmt("$,", stensor.dim[i]);
-        shape += fmt("$,", adjusted_dims[i]);
+        shape += fmt(FMT_STR("$,"), adjusted_dims[i]);
       }
-      code.e("$ = tl.zeros(($), dtype=tl.float32)",
-             fmt("stensor$", stensor.guid),
+      code.e(FMT_STR("$ = tl.zeros(($), dtype=tl.float32)"),
+             fmt(FMT_STR("stensor$"), stensor.guid),
              shape);
-      code.e("# Original shape: ($)", get_tensor_shape(stensor));
+      code.e(FMT_STR("# Original shape: ($)"), get_tensor_shape(stensor));
     }
   }
   // Generate forloop if needed
   if (g.forloop_range > 1) {
-    code.e("for i in range($):", g.forloop_range);
+    code.e(FMT_STR("for i in range($):"), g.forloop_range);
     code.inc_indent();
   }
 
@@ -285,7 +285,7 @@ TritonCustomOPTranspileResult
         }
         std::string ptr_expr = dim_exprs[0];
         if (stensor.num_dims > 1) {
-          ptr_expr = fmt("($)[:, None] * $ + ($)[None, :] * $",
+          ptr_expr = fmt(FMT_STR("($)[:, None] * $ + ($)[None, :] * $"),
                          dim_exprs[0],
                          stride[0],
                          dim_exprs[1],
@@ -296,9 +296,9 @@ TritonCustomOPTranspileResult
             stensor, adjusted_dims, input_op->input_map, input_op->forloop_dim);
 
         // Generate load instruction
-        code.e("$ = tl.load($ + $, mask=$)",
-               fmt("stensor$", stensor.guid),
-               fmt("dtensor$", dtensor.guid),
+        code.e(FMT_STR("$ = tl.load($ + $, mask=$)"),
+               fmt(FMT_STR("stensor$"), stensor.guid),
+               fmt(FMT_STR("dtensor$"), dtensor.guid),
                ptr_expr,
                mask_expr.empty() ? "None" : mask_expr);
         break;
@@ -321,19 +321,19 @@ TritonCustomOPTranspileResult
         std::string mask1 =
             generate_mask_expr(input1, adjusted_dims1, {-1, -1, -1});
 
-        code.e("$ = tl.dot($, $)",
-               fmt("stensor$", output.guid),
-               fmt("stensor$.to(tl.float32)", input0.guid),
-               fmt("stensor$.to(tl.float32)", input1.guid));
+        code.e(FMT_STR("$ = tl.dot($, $)"),
+               fmt(FMT_STR("stensor$"), output.guid),
+               fmt(FMT_STR("stensor$.to(tl.float32)"), input0.guid),
+               fmt(FMT_STR("stensor$.to(tl.float32)"), input1.guid));
         break;
       }
 
       case type::TB_FORLOOP_ACCUM_NO_RED_OP: {
         tb::STensor const &input = tb_op->input_tensors.at(0);
         tb::STensor const &output = tb_op->output_tensors.at(0);
-        code.e("$ += $",
-               fmt("stensor$", output.guid),
-               fmt("stensor$", input.guid));
+        code.e(FMT_STR("$ += $"),
+               fmt(FMT_STR("stensor$"), output.guid),
+               fmt(FMT_STR("stensor$"), input.guid));
         break;
       }
 
@@ -346,19 +346,19 @@ TritonCustomOPTranspileResult
 
         string op_str = operator_type_to_triton(tb_op->op_type);
 
-        code.e("$ = $($)",
-               fmt("stensor$", output.guid),
+        code.e(FMT_STR("$ = $($)"),
+               fmt(FMT_STR("stensor$"), output.guid),
                op_str,
-               fmt("stensor$", input.guid));
+               fmt(FMT_STR("stensor$"), input.guid));
         break;
       }
       case type::TB_SQUARE_OP: {
         tb::STensor const &input = tb_op->input_tensors.at(0);
         tb::STensor const &output = tb_op->output_tensors.at(0);
-        code.e("$ = $ * $",
-               fmt("stensor$", output.guid),
-               fmt("stensor$", input.guid),
-               fmt("stensor$", input.guid));
+        code.e(FMT_STR("$ = $ * $"),
+               fmt(FMT_STR("stensor$"), output.guid),
+               fmt(FMT_STR("stensor$"), input.guid),
+               fmt(FMT_STR("stensor$"), input.guid));
         break;
       }
       case type::TB_MUL_SCALAR_OP: {
@@ -366,9 +366,9 @@ TritonCustomOPTranspileResult
         tb::STensor const &output = tb_op->output_tensors.at(0);
         tb::TBElementUnaryOp *unary =
             static_cast<tb::TBElementUnaryOp *>(tb_op);
-        code.e("$ = $ * $",
-               fmt("stensor$", output.guid),
-               fmt("stensor$", input.guid),
+        code.e(FMT_STR("$ = $ * $"),
+               fmt(FMT_STR("stensor$"), output.guid),
+               fmt(FMT_STR("stensor$"), input.guid),
                unary->scalar);
         break;
       }
@@ -380,11 +380,11 @@ TritonCustomOPTranspileResult
         assert(input0.num_dims == input1.num_dims);
         assert(input1.num_dims == output.num_dims);
         string op_str = operator_type_to_triton(tb_op->op_type);
-        code.e("$ = $ $ $",
-               fmt("stensor$", output.guid),
-               fmt("stensor$", input0.guid),
+        code.e(FMT_STR("$ = $ $ $"),
+               fmt(FMT_STR("stensor$"), output.guid),
+               fmt(FMT_STR("stensor$"), input0.guid),
                op_str,
-               fmt("stensor$", input1.guid));
+               fmt(FMT_STR("stensor$"), input1.guid));
       }
       case type::TB_DIV_OP: {
         tb::STensor const &input0 = tb_op->input_tensors.at(0);
@@ -392,10 +392,10 @@ TritonCustomOPTranspileResult
         tb::STensor const &output = tb_op->output_tensors.at(0);
         assert(input0.num_dims == input1.num_dims);
         assert(input1.num_dims == output.num_dims);
-        code.e("$ = tl.fdiv($, $)",
-               fmt("stensor$", output.guid),
-               fmt("stensor$", input0.guid),
-               fmt("stensor$", input1.guid));
+        code.e(FMT_STR("$ = tl.fdiv($, $)"),
+               fmt(FMT_STR("stensor$"), output.guid),
+               fmt(FMT_STR("stensor$"), input0.guid),
+               fmt(FMT_STR("stensor$"), input1.guid));
         break;
       }
       case type::TB_POW_OP: {
@@ -404,10 +404,10 @@ TritonCustomOPTranspileResult
         tb::STensor const &output = tb_op->output_tensors.at(0);
         assert(input0.num_dims == input1.num_dims);
         assert(input1.num_dims == output.num_dims);
-        code.e("$ = tl.power($, $)",
-               fmt("stensor$", output.guid),
-               fmt("stensor$", input0.guid),
-               fmt("stensor$", input1.guid));
+        code.e(FMT_STR("$ = tl.power($, $)"),
+               fmt(FMT_STR("stensor$"), output.guid),
+               fmt(FMT_STR("stensor$"), input0.guid),
+               fmt(FMT_STR("stensor$"), input1.guid));
         break;
       }
 
@@ -423,15 +423,15 @@ TritonCustomOPTranspileResult
         int reduc_dim = tb_op->op_type - type::TB_REDUCTION_0_OP;
 
         if (!mask_expr.empty()) {
-          code.e("$ = tl.sum($ * $, axis=$, keep_dims=True)",
-                 fmt("stensor$", output.guid),
+          code.e(FMT_STR("$ = tl.sum($ * $, axis=$, keep_dims=True)"),
+                 fmt(FMT_STR("stensor$"), output.guid),
                  mask_expr,
-                 fmt("stensor$", input.guid),
+                 fmt(FMT_STR("stensor$"), input.guid),
                  reduc_dim);
         } else {
-          code.e("$ = tl.sum($, axis=$, keep_dims=True)",
-                 fmt("stensor$", output.guid),
-                 fmt("stensor$", input.guid),
+          code.e(FMT_STR("$ = tl.sum($, axis=$, keep_dims=True)"),
+                 fmt(FMT_STR("stensor$"), output.guid),
+                 fmt(FMT_STR("stensor$"), input.guid),
                  reduc_dim);
         }
         break;
@@ -486,7 +486,7 @@ TritonCustomOPTranspileResult
 
         ptr_expr = dim_exprs[0];
         if (stensor.num_dims > 1) {
-          ptr_expr = fmt("($)[:, None] * $ + ($)[None, :]",
+          ptr_expr = fmt(FMT_STR("($)[:, None] * $ + ($)[None, :]"),
                          dim_exprs[0],
                          stride[0],
                          dim_exprs[1]);
@@ -495,16 +495,16 @@ TritonCustomOPTranspileResult
             generate_mask_expr(stensor, adjusted_dims, output_op->output_map);
 
         if (!mask_expr.empty()) {
-          code.e("tl.store($ + $, $, mask=$)",
-                 fmt("dtensor$", output_op->dtensor.guid),
+          code.e(FMT_STR("tl.store($ + $, $, mask=$)"),
+                 fmt(FMT_STR("dtensor$"), output_op->dtensor.guid),
                  ptr_expr,
-                 fmt("stensor$", stensor.guid),
+                 fmt(FMT_STR("stensor$"), stensor.guid),
                  mask_expr == "" ? "None" : mask_expr);
         } else {
-          code.e("tl.store($ + $, $)",
-                 fmt("dtensor$", output_op->dtensor.guid),
+          code.e(FMT_STR("tl.store($ + $, $)"),
+                 fmt(FMT_STR("dtensor$"), output_op->dtensor.guid),
                  ptr_expr,
-                 fmt("stensor$", stensor.guid));
+                 fmt(FMT_STR("stensor$"), stensor.guid));
         }
 
         break;
@@ -517,19 +517,19 @@ TritonCustomOPTranspileResult
         tb::STensor const &output = tb_op->output_tensors.at(0);
 
         string op_str = operator_type_to_triton(tb_op->op_type);
-        code.e("$ = $($)",
-               fmt("stensor$", output.guid),
+        code.e(FMT_STR("$ = $($)"),
+               fmt(FMT_STR("stensor$"), output.guid),
                op_str,
-               fmt("stensor$", input.guid));
+               fmt(FMT_STR("stensor$"), input.guid));
         break;
       }
       case type::TB_SQUARE_OP: {
         tb::STensor const &input = tb_op->input_tensors.at(0);
         tb::STensor const &output = tb_op->output_tensors.at(0);
-        code.e("$ = $ * $",
-               fmt("stensor$", output.guid),
-               fmt("stensor$", input.guid),
-               fmt("stensor$", input.guid));
+        code.e(FMT_STR("$ = $ * $"),
+               fmt(FMT_STR("stensor$"), output.guid),
+               fmt(FMT_STR("stensor$"), input.guid),
+               fmt(FMT_STR("stensor$"), input.guid));
         break;
       }
       case type::TB_ADD_OP:
@@ -550,23 +550,23 @@ TritonCustomOPTranspileResult
             assert(false);
         }
 
-        code.e("$ = $ $ $",
-               fmt("stensor$", output.guid),
-               fmt("stensor$", input0.guid),
+        code.e(FMT_STR("$ = $ $ $"),
+               fmt(FMT_STR("stensor$"), output.guid),
+               fmt(FMT_STR("stensor$"), input0.guid),
                op_symbol,
-               fmt("stensor$", input1.guid));
+               fmt(FMT_STR("stensor$"), input1.guid));
         break;
       }
       case type::TB_DIV_OP: {
         tb::STensor const &input0 = tb_op->input_tensors.at(0);
         tb::STensor const &input1 = tb_op->input_tensors.at(1);
         tb::STensor const &output = tb_op->output_tensors.at(0);
-        code.e(
-            "$ = tl.fdiv($, $)", // TODO: AttributeError: module
-                                 // 'triton.language' has no attribute 'div_rn'
-            fmt("stensor$", output.guid),
-            fmt("stensor$", input0.guid),
-            fmt("stensor$", input1.guid));
+        code.e(FMT_STR("$ = tl.fdiv($, $)"), // TODO: AttributeError: module
+                                             // 'triton.language' has no
+                                             // attribute 'div_rn'
+               fmt(FMT_STR("stensor$"), output.guid),
+               fmt(FMT_STR("stensor$"), input0.guid),
+               fmt(FMT_STR("stensor$"), input1.guid));
         break;
       }
       case type::TB_POW_OP: {
@@ -575,10 +575,10 @@ TritonCustomOPTranspileResult
         tb::STensor const &output = tb_op->output_tensors.at(0);
         assert(input0.num_dims == input1.num_dims);
         assert(input1.num_dims == output.num_dims);
-        code.e("$ = tl.power($, $)",
-               fmt("stensor$", output.guid),
-               fmt("stensor$", input0.guid),
-               fmt("stensor$", input1.guid));
+        code.e(FMT_STR("$ = tl.power($, $)"),
+               fmt(FMT_STR("stensor$"), output.guid),
+               fmt(FMT_STR("stensor$"), input0.guid),
+               fmt(FMT_STR("stensor$"), input1.guid));
         break;
       }
 
@@ -594,15 +594,15 @@ TritonCustomOPTranspileResult
         int reduc_dim = tb_op->op_type - type::TB_REDUCTION_0_OP;
 
         if (!mask_expr.empty()) {
-          code.e("$ = tl.sum($ * $, axis=$, keep_dims=True)",
-                 fmt("stensor$", output.guid),
+          code.e(FMT_STR("$ = tl.sum($ * $, axis=$, keep_dims=True)"),
+                 fmt(FMT_STR("stensor$"), output.guid),
                  mask_expr == "" ? "1.0" : mask_expr,
-                 fmt("stensor$", input.guid),
+                 fmt(FMT_STR("stensor$"), input.guid),
                  reduc_dim);
         } else {
-          code.e("$ = tl.sum($, axis=$, keep_dims=True)",
-                 fmt("stensor$", output.guid),
-                 fmt("stensor$", input.guid),
+          code.e(FMT_STR("$ = tl.sum($, axis=$, keep_dims=True)"),
+                 fmt(FMT_STR("stensor$"), output.guid),
+                 fmt(FMT_STR("stensor$"), input.guid),
                  reduc_dim);
         }
         break;
@@ -619,15 +619,16 @@ TritonCustomOPTranspileResult
         std::string mask1 =
             generate_mask_expr(input1, adjusted_dims1, {-1, -1, -1});
 
-        code.e("$ = tl.dot($, $)",
-               fmt("stensor$", output.guid),
-               fmt("stensor$.to(tl.float32)", input0.guid),
-               fmt("stensor$.to(tl.float32)", input1.guid));
+        code.e(FMT_STR("$ = tl.dot($, $)"),
+               fmt(FMT_STR("stensor$"), output.guid),
+               fmt(FMT_STR("stensor$.to(tl.float32)"), input0.guid),
+               fmt(FMT_STR("stensor$.to(tl.float32)"), input1.guid));
         break;
       }
       default: {
         std::cout << "Unsupported op_type: " << tb_op->op_type << std::endl;
-        throw std::runtime_error(fmt("Unsupported op_type: $", tb_op->op_type));
+        throw std::runtime_error(
+            fmt(FMT_STR("Unsupported op_type: $"), tb_op->op_type));
       }
     }
   }
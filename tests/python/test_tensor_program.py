@@ -1,3 +1,6 @@
+import json
+import os
+import struct
 import mirage as mi
 import numpy as np
 import torch
@@ -334,3 +337,835 @@ def test_rms_norm(test_config):
     Res = torch.matmul(RMS, input_tensors[1])
 
     assert is_closed(Res, outputs[0])
+
+
+def test_cuda_graph_launcher():
+    graph = mi.new_kernel_graph()
+    X = graph.new_input(dims=(8, 4096), dtype=mi.float16)
+    W = graph.new_input(dims=(4096, 4096), dtype=mi.float16)
+    tb_graph = mi.new_threadblock_graph((64, 1, 1), (128, 1, 1), 64, 64)
+    tX = tb_graph.new_input(dtensor=X, input_map=(-1, -1, -1), forloop_dim=1)
+    tW = tb_graph.new_input(dtensor=W, input_map=(1, -1, -1), forloop_dim=0)
+    tA = tb_graph.forloop_accum(tb_graph.matmul(tX, tW))
+    tb_graph.new_output(stensor=tA, output_map=(1, -1, -1))
+    O = graph.customized([X, W], tb_graph)
+    graph.mark_output(O[0], (4096, 1))
+
+    input_strides = [(4096, 1), (4096, 1)]
+    for enable_cuda_graph in [False, True]:
+        p = mi.generate_cuda_program(
+            graph.cygraph,
+            target_cc=80,
+            input_strides=input_strides,
+            enable_cuda_graph=enable_cuda_graph,
+        )
+        code = p["code"]
+        # Shared memory attributes are set once in `_init`
+        init = code[code.index("static void _init()") :]
+        init = init[: init.index("}")]
+        assert "cudaFuncSetAttribute" in init
+        assert code.count("cudaFuncSetAttribute") == 1
+        assert ("CudaGraphCache" in code) == enable_cuda_graph
+        assert ("_launch_mugraph" in code) == enable_cuda_graph
+
+
+def test_cuda_graph_replay():
+    graph = mi.new_kernel_graph()
+    X = graph.new_input(dims=(8, 1024), dtype=mi.float16)
+    W = graph.new_input(dims=(1024, 1024), dtype=mi.float16)
+    tb_graph = mi.new_threadblock_graph((16, 1, 1), (128, 1, 1), 16, 64)
+    tX = tb_graph.new_input(dtensor=X, input_map=(-1, -1, -1), forloop_dim=1)
+    tW = tb_graph.new_input(dtensor=W, input_map=(1, -1, -1), forloop_dim=0)
+    tA = tb_graph.forloop_accum(tb_graph.matmul(tX, tW))
+    tb_graph.new_output(stensor=tA, output_map=(1, -1, -1))
+    O = graph.customized([X, W], tb_graph)
+    graph.mark_output(O[0], (1024, 1))
+
+    x = torch.rand((8, 1024), dtype=torch.float16, device="cuda:0") * 0.1
+    w = torch.rand((1024, 1024), dtype=torch.float16, device="cuda:0") * 0.1
+    ref = torch.matmul(x, w)
+    # The first call captures the graph and the second replays it; both on
+    # the legacy default stream, which cannot be captured directly
+    outputs = [
+        graph(inputs=[x, w], enable_cuda_graph=True)[0].clone() for _ in range(2)
+    ]
+    # Replay on a side stream with freshly allocated inputs
+    side_stream = torch.cuda.Stream()
+    with torch.cuda.stream(side_stream):
+        x2, w2 = x.clone(), w.clone()
+        outputs.append(
+            graph(inputs=[x2, w2], enable_cuda_graph=True, stream=side_stream)[0]
+        )
+    torch.cuda.synchronize()
+    for output in outputs:
+        assert torch.allclose(output, ref, rtol=1e-2, atol=1e-2)
+    assert torch.equal(outputs[0], outputs[1])
+    assert torch.equal(outputs[0], outputs[2])
+
+
+def test_kn_fusion_epilogue():
+    graph = mi.new_kernel_graph()
+    X = graph.new_input(dims=(8, 4096), dtype=mi.float16)
+    W = graph.new_input(dims=(4096, 4096), dtype=mi.float16)
+    tb_graph = mi.new_threadblock_graph((64, 1, 1), (128, 1, 1), 64, 64)
+    tX = tb_graph.new_input(dtensor=X, input_map=(-1, -1, -1), forloop_dim=1)
+    tW = tb_graph.new_input(dtensor=W, input_map=(1, -1, -1), forloop_dim=0)
+    tA = tb_graph.forloop_accum(tb_graph.matmul(tX, tW))
+    tb_graph.new_output(stensor=tA, output_map=(1, -1, -1))
+    O = graph.customized([X, W], tb_graph)
+    # An elementwise consumer reading exactly the tiles produced above
+    tb_graph = mi.new_threadblock_graph((64, 1, 1), (128, 1, 1), 1, 64)
+    tO = tb_graph.new_input(dtensor=O[0], input_map=(1, -1, -1), forloop_dim=-1)
+    tE = tb_graph.forloop_accum(tb_graph.exp(tO))
+    tb_graph.new_output(stensor=tE, output_map=(1, -1, -1))
+    E = graph.customized([O[0]], tb_graph)
+    graph.mark_output(E[0], (4096, 1))
+
+    input_strides = [(4096, 1), (4096, 1)]
+    p = mi.generate_cuda_program(
+        graph.cygraph,
+        target_cc=80,
+        input_strides=input_strides,
+        enable_kn_fusion=True,
+    )
+    assert "op 2 -> op 3 (epilogue)" in p["kn_fusion_report"]
+    assert "total: 1 fused pairs, 131072 bytes saved" in p["kn_fusion_report"]
+
+
+def test_autotune_table(tmp_path):
+    graph = mi.new_kernel_graph()
+    X = graph.new_input(dims=(8, 4096), dtype=mi.float16)
+    W = graph.new_input(dims=(4096, 4096), dtype=mi.float16)
+    tb_graph = mi.new_threadblock_graph((64, 1, 1), (128, 1, 1), 64, 64)
+    tX = tb_graph.new_input(dtensor=X, input_map=(-1, -1, -1), forloop_dim=1)
+    tW = tb_graph.new_input(dtensor=W, input_map=(1, -1, -1), forloop_dim=0)
+    tA = tb_graph.forloop_accum(tb_graph.matmul(tX, tW))
+    tb_graph.new_output(stensor=tA, output_map=(1, -1, -1))
+    O = graph.customized([X, W], tb_graph)
+    graph.mark_output(O[0], (4096, 1))
+
+    table = tmp_path / "autotune.json"
+    input_strides = [(4096, 1), (4096, 1)]
+    best = mi.autotune_cuda_program(
+        graph.cygraph,
+        target_cc=80,
+        input_strides=input_strides,
+        table_path=str(table),
+    )
+    assert not best["enable_online_softmax"]
+    records = json.loads(table.read_text())
+    assert len(records) == 1 and records[0]["target_cc"] == 80
+    # A second call is served from the table
+    assert (
+        mi.autotune_cuda_program(
+            graph.cygraph,
+            target_cc=80,
+            input_strides=input_strides,
+            table_path=str(table),
+        )
+        == best
+    )
+    # Records are keyed by input strides as well
+    assert records[0]["input_strides"] == [list(s) for s in input_strides]
+    assert "predicted_cost" in records[0] and records[0]["measured_ms"] < 0
+
+
+def test_shared_memory_capacity():
+    assert mi.get_shared_memory_capacity(80) == 163 * 1024
+    # An unknown architecture is an error rather than a silent fallback
+    with pytest.raises(AssertionError, match="Unsupported compute capacity"):
+        mi.get_shared_memory_capacity(75)
+
+
+def test_simulate_task_graph():
+    invalid = 0x7FFFFFFFFFFFFFFE
+
+    def task(task_type, trigger, dependent=invalid):
+        return {
+            "task_type": task_type,
+            "variant_id": 0,
+            "inputs": [],
+            "outputs": [],
+            "trigger_event": trigger,
+            "dependent_event": dependent,
+        }
+
+    def event(event_type, num_triggers, first, last):
+        return {
+            "event_type": event_type,
+            "num_triggers": num_triggers,
+            "first_task_id": first,
+            "last_task_id": last,
+        }
+
+    # terminate, begin_task_graph, two independent tasks and one task that
+    # depends on both of them
+    task_graph = {
+        "all_tasks": [
+            task(0, invalid),
+            task(10, 1),
+            task(101, 2),
+            task(101, 2),
+            task(102, 3, dependent=2),
+        ],
+        "all_events": [
+            event(911, 0, 0, 0),
+            event(903, 1, 2, 5),
+            event(900, 2, 0, 0),
+            event(910, 1, 0, 0),
+        ],
+        "first_tasks": [1],
+    }
+    result = mi.simulate_task_graph(
+        json.dumps(task_graph),
+        num_workers=3,
+        num_local_schedulers=1,
+        num_iterations=2,
+        task_latency_us={101: 10.0, 102: 20.0},
+    )
+    assert result["completed"]
+    assert result["num_executed_tasks"] == 8
+    assert result["worker_queue_overflows"] == 0
+    # Each iteration serializes one 101 task and the 102 task
+    assert result["critical_path_busy_us"] >= 2 * (10.0 + 20.0)
+    assert result["makespan_us"] >= result["critical_path_busy_us"]
+
+    # A task waiting on an event that is never activated deadlocks
+    task_graph["all_events"][2]["num_triggers"] = 3
+    result = mi.simulate_task_graph(
+        json.dumps(task_graph), num_workers=3, num_local_schedulers=1
+    )
+    assert not result["completed"]
+
+
+def test_order_task_graph():
+    invalid = 0x7FFFFFFFFFFFFFFE
+
+    def task(trigger, dependent=invalid, task_type=101):
+        return {
+            "task_type": task_type,
+            "variant_id": 0,
+            "inputs": [],
+            "outputs": [],
+            "trigger_event": trigger,
+            "dependent_event": dependent,
+        }
+
+    def event(event_type, num_triggers, first, last):
+        return {
+            "event_type": event_type,
+            "num_triggers": num_triggers,
+            "first_task_id": first,
+            "last_task_id": last,
+        }
+
+    # A chain of three tasks followed, in operator order, by eight
+    # independent tasks. Prelaunched in this order, the chain stalls two
+    # workers that hold independent tasks behind it
+    task_graph = {
+        "all_tasks": [task(invalid, task_type=0), task(1, task_type=10)]
+        + [task(2), task(3, dependent=2), task(4, dependent=3)]
+        + [task(4) for _ in range(8)],
+        "all_events": [
+            event(911, 1, 0, 0),
+            event(903, 1, 2, 13),
+            event(900, 1, 3, 4),
+            event(900, 1, 4, 5),
+            event(910, 9, 0, 0),
+        ],
+        "first_tasks": [2] + list(range(5, 13)),
+        "tensor_descs": [],
+    }
+    ordered = mi.order_task_graph(json.dumps(task_graph), num_workers=4)
+    before = mi.simulate_task_graph(
+        json.dumps(task_graph), num_workers=4, num_local_schedulers=1
+    )
+    after = mi.simulate_task_graph(ordered, num_workers=4, num_local_schedulers=1)
+    assert before["completed"] and after["completed"]
+    # The chain runs back to back on one worker while the other three run
+    # the independent tasks
+    assert after["makespan_us"] < 0.75 * before["makespan_us"]
+
+
+def test_verify_task_graph():
+    invalid = 0x7FFFFFFFFFFFFFFE
+
+    def task(trigger, dependent, inputs, outputs):
+        return {
+            "task_type": 101,
+            "variant_id": 0,
+            "inputs": inputs,
+            "outputs": outputs,
+            "trigger_event": trigger,
+            "dependent_event": dependent,
+        }
+
+    def event(event_type, num_triggers, first, last):
+        return {
+            "event_type": event_type,
+            "num_triggers": num_triggers,
+            "first_task_id": first,
+            "last_task_id": last,
+        }
+
+    def tensor(dims):
+        return {"base_ptr": "y", "data_type": 941, "dims": dims, "strides": [64, 1]}
+
+    # Tasks 2 and 3 write the two column halves of a (4, 64) bfloat16 tensor,
+    # and task 4 reads all of it after event 2. Task 3 does not trigger
+    # event 2
+    task_graph = {
+        "all_tasks": [
+            task(invalid, invalid, [], []),
+            task(1, invalid, [], []),
+            task(2, invalid, [], [{"desc": 0, "offset": 0}]),
+            task(3, invalid, [], [{"desc": 0, "offset": 64}]),
+            task(3, 2, [{"desc": 1, "offset": 0}], []),
+        ],
+        "all_events": [
+            event(911, 1, 0, 0),
+            event(903, 1, 2, 5),
+            event(900, 1, 4, 5),
+            event(910, 2, 0, 0),
+        ],
+        "first_tasks": [2, 3],
+        "tensor_descs": [tensor([4, 32]), tensor([4, 64])],
+    }
+    result = mi.verify_task_graph(json.dumps(task_graph), num_workers=2)
+    assert [(r["first_task"], r["second_task"]) for r in result["races"]] == [(3, 4)]
+    assert result["races"][0]["first_writes"]
+    assert not result["deadlocked_tasks"]
+
+    task_graph["all_tasks"][3]["trigger_event"] = 2
+    task_graph["all_events"][2]["num_triggers"] = 2
+    task_graph["all_events"][3]["num_triggers"] = 1
+    assert mi.verify_task_graph(json.dumps(task_graph), num_workers=2)["ok"]
+
+
+def test_pipeline_task_graph():
+    invalid = 0x7FFFFFFFFFFFFFFE
+
+    def task(task_type, trigger, dependent, inputs, outputs, weight_only=False):
+        return {
+            "task_type": task_type,
+            "variant_id": 0,
+            "inputs": [{"desc": d, "offset": o} for d, o in inputs],
+            "outputs": [{"desc": d, "offset": o} for d, o in outputs],
+            "trigger_event": trigger,
+            "dependent_event": dependent,
+            "weight_only": weight_only,
+            "pipelined": False,
+        }
+
+    def event(event_type, num_triggers, first, last):
+        return {
+            "event_type": event_type,
+            "num_triggers": num_triggers,
+            "first_task_id": first,
+            "last_task_id": last,
+        }
+
+    def tensor(name, cols):
+        return {"base_ptr": name, "data_type": 941, "dims": [1, cols], "strides": [cols, 1]}
+
+    # Tasks 2 and 3 only read the weight x and write the two halves of y,
+    # tasks 4 and 5 read y and write z, and task 6 reads z
+    task_graph = {
+        "all_tasks": [
+            task(0, invalid, invalid, [], []),
+            task(10, 1, invalid, [], []),
+            task(102, 2, invalid, [(0, 0)], [(1, 0)], weight_only=True),
+            task(102, 2, invalid, [(0, 0)], [(1, 64)], weight_only=True),
+            task(108, 3, 2, [(2, 0)], [(3, 0)]),
+            task(108, 3, 2, [(2, 0)], [(3, 64)]),
+            task(111, 4, 3, [(4, 0)], [(5, 0)]),
+        ],
+        "all_events": [
+            event(911, 1, 0, 0),
+            event(903, 1, 2, 7),
+            event(900, 2, 4, 6),
+            event(900, 2, 6, 7),
+            event(910, 1, 0, 0),
+        ],
+        "first_tasks": [2, 3],
+        "tensor_descs": [
+            tensor("x", 64),
+            tensor("y", 32),
+            tensor("y", 64),
+            tensor("z", 32),
+            tensor("z", 64),
+            tensor("out", 64),
+        ],
+    }
+    pipelined = mi.pipeline_task_graph(json.dumps(task_graph))
+    tasks = json.loads(pipelined)["all_tasks"]
+    assert [t["pipelined"] for t in tasks] == [False] * 2 + [True] * 2 + [False] * 3
+    # The next iteration of tasks 2 and 3 waits for the readers of y
+    assert tasks[2]["dependent_event"] == 3
+    assert mi.verify_task_graph(pipelined, num_workers=4)["ok"]
+
+    kwargs = dict(
+        num_workers=4,
+        num_local_schedulers=1,
+        num_iterations=4,
+        task_latency_us={102: 10.0, 108: 10.0, 111: 30.0},
+    )
+    before = mi.simulate_task_graph(json.dumps(task_graph), **kwargs)
+    after = mi.simulate_task_graph(pipelined, **kwargs)
+    assert before["completed"] and after["completed"]
+    # Tasks 2 and 3 overlap with task 6 of the previous iteration
+    assert after["makespan_us"] < before["makespan_us"] - 20.0
+
+    # Waiting on their own event does not order tasks 2 and 3 after the
+    # readers of y in the previous iteration
+    task_graph = json.loads(pipelined)
+    for t in task_graph["all_tasks"][2:4]:
+        t["dependent_event"] = 2
+    races = mi.verify_task_graph(json.dumps(task_graph), num_workers=4)["races"]
+    assert races and all(r["across_iterations"] for r in races)
+
+
+@pytest.mark.skipif("MIRAGE_HOME" not in os.environ, reason="MIRAGE_HOME unset")
+def test_persistent_kernel_cpu_backend():
+    hidden_size, output_size = 256, 128
+    step = torch.tensor([0], dtype=torch.int32)
+    tokens = torch.zeros(4, dtype=torch.long)
+    mpk = mi.PersistentKernel(
+        world_size=1,
+        mpi_rank=0,
+        num_workers=4,
+        num_local_schedulers=2,
+        num_remote_schedulers=0,
+        max_seq_length=4,
+        eos_token_id=-1,
+        meta_tensors=[step, tokens],
+        profiler_tensor=None,
+        backend="cpu",
+    )
+    x = torch.randn(1, hidden_size, dtype=torch.bfloat16)
+    w = torch.randn(output_size, hidden_size, dtype=torch.bfloat16) * 0.05
+    r = torch.randn(1, output_size, dtype=torch.bfloat16)
+    y = torch.zeros(1, output_size, dtype=torch.bfloat16)
+    mpk.linear_with_residual_layer(
+        input=mpk.attach_input(torch_tensor=x, name="x"),
+        weight=mpk.attach_input(torch_tensor=w, name="w"),
+        residual=mpk.attach_input(torch_tensor=r, name="r"),
+        output=mpk.attach_input(torch_tensor=y, name="y"),
+        grid_dim=(output_size // 64, 1, 1),
+        block_dim=(128, 1, 1),
+    )
+    mpk.compile()
+    mpk()
+    expected = torch.matmul(x.float(), w.float().t()) + r.float()
+    assert is_closed(y.float(), expected)
+
+
+def new_cpu_persistent_kernel(step, tokens):
+    # Runs a single iteration starting at step[0]
+    return mi.PersistentKernel(
+        world_size=1,
+        mpi_rank=0,
+        num_workers=4,
+        num_local_schedulers=2,
+        num_remote_schedulers=0,
+        max_seq_length=int(step[0]) + 2,
+        eos_token_id=-1,
+        meta_tensors=[step, tokens],
+        profiler_tensor=None,
+        backend="cpu",
+    )
+
+
+@pytest.mark.skipif("MIRAGE_HOME" not in os.environ, reason="MIRAGE_HOME unset")
+def test_cpu_backend_embedding():
+    vocab_size, hidden_size = 64, 128
+    step = torch.tensor([1], dtype=torch.int32)
+    tokens = torch.tensor([0, 7, 0, 0], dtype=torch.long)
+    mpk = new_cpu_persistent_kernel(step, tokens)
+    x = torch.zeros(1, 1, dtype=torch.long)
+    w = torch.randn(vocab_size, hidden_size, dtype=torch.bfloat16)
+    y = torch.zeros(1, hidden_size, dtype=torch.bfloat16)
+    mpk.embed_layer(
+        input=mpk.attach_input(torch_tensor=x, name="x"),
+        weight=mpk.attach_input(torch_tensor=w, name="w"),
+        output=mpk.attach_input(torch_tensor=y, name="y"),
+        grid_dim=(1, 1, 1),
+        block_dim=(128, 1, 1),
+    )
+    mpk.compile()
+    mpk()
+    # The token at the current step is looked up
+    assert torch.equal(y[0], w[7])
+
+
+@pytest.mark.skipif("MIRAGE_HOME" not in os.environ, reason="MIRAGE_HOME unset")
+def test_cpu_backend_rmsnorm_linear():
+    hidden_size, output_size = 256, 128
+    step = torch.tensor([0], dtype=torch.int32)
+    tokens = torch.zeros(4, dtype=torch.long)
+    mpk = new_cpu_persistent_kernel(step, tokens)
+    x = torch.randn(1, hidden_size, dtype=torch.bfloat16)
+    w_norm = torch.rand(hidden_size, dtype=torch.bfloat16) + 0.5
+    w = torch.randn(output_size, hidden_size, dtype=torch.bfloat16) * 0.05
+    y = torch.zeros(1, output_size, dtype=torch.bfloat16)
+    mpk.rmsnorm_linear_layer(
+        input=mpk.attach_input(torch_tensor=x, name="x"),
+        weight_norm=mpk.attach_input(torch_tensor=w_norm, name="w_norm"),
+        weight_linear=mpk.attach_input(torch_tensor=w, name="w"),
+        output=mpk.attach_input(torch_tensor=y, name="y"),
+        grid_dim=(2, 1, 1),
+        block_dim=(128, 1, 1),
+    )
+    mpk.compile()
+    mpk()
+    xf = x.float()
+    normed = xf * torch.rsqrt(xf.pow(2).mean(dim=-1, keepdim=True) + 1e-6)
+    expected = torch.matmul(normed * w_norm.float(), w.float().t())
+    assert torch.allclose(y.float(), expected, rtol=2e-2, atol=2e-2)
+
+
+@pytest.mark.skipif("MIRAGE_HOME" not in os.environ, reason="MIRAGE_HOME unset")
+def test_cpu_backend_attention():
+    num_q_heads, num_kv_heads, head_dim, max_len = 4, 2, 64, 8
+    group_size = num_q_heads // num_kv_heads
+    # The new token is appended at row seq_len - 1 of the KV cache
+    seq_len = 3
+    step = torch.tensor([seq_len], dtype=torch.int32)
+    tokens = torch.zeros(max_len, dtype=torch.long)
+    mpk = new_cpu_persistent_kernel(step, tokens)
+    # Each KV head owns a [q heads of its group | k | v] chunk of qkv
+    qkv = torch.randn(1, (num_q_heads + 2 * num_kv_heads) * head_dim).bfloat16()
+    k_cache = torch.randn(1, max_len, num_kv_heads, head_dim).bfloat16()
+    v_cache = torch.randn(1, max_len, num_kv_heads, head_dim).bfloat16()
+    q_norm = (torch.rand(head_dim) + 0.5).bfloat16()
+    k_norm = (torch.rand(head_dim) + 0.5).bfloat16()
+    cos = torch.randn(max_len, head_dim).bfloat16()
+    sin = torch.randn(max_len, head_dim).bfloat16()
+    y = torch.zeros(1, num_q_heads * head_dim, dtype=torch.bfloat16)
+    k_ref, v_ref = k_cache.float().clone(), v_cache.float().clone()
+    mpk.attention_layer(
+        input=mpk.attach_input(torch_tensor=qkv, name="qkv"),
+        k_cache=mpk.attach_input(torch_tensor=k_cache, name="k_cache"),
+        v_cache=mpk.attach_input(torch_tensor=v_cache, name="v_cache"),
+        q_norm=mpk.attach_input(torch_tensor=q_norm, name="q_norm"),
+        k_norm=mpk.attach_input(torch_tensor=k_norm, name="k_norm"),
+        cos_pos_embed=mpk.attach_input(torch_tensor=cos, name="cos"),
+        sin_pos_embed=mpk.attach_input(torch_tensor=sin, name="sin"),
+        output=mpk.attach_input(torch_tensor=y, name="y"),
+        grid_dim=(1, num_kv_heads, 1),
+        block_dim=(128, 1, 1),
+    )
+    mpk.compile()
+    mpk()
+
+    def norm_rope(h, weight):
+        h = h * torch.rsqrt(h.pow(2).mean(dim=-1, keepdim=True) + 1e-6)
+        h = h * weight.float()
+        # As in the GPU kernel, the rotary embedding uses row seq_len
+        c, s = cos[seq_len].float(), sin[seq_len].float()
+        h1, h2 = h[..., : head_dim // 2], h[..., head_dim // 2 :]
+        return h * c + torch.cat((-h2, h1), dim=-1) * s
+
+    chunks = qkv.float().view(num_kv_heads, group_size + 2, head_dim)
+    expected = []
+    for g in range(num_kv_heads):
+        q = norm_rope(chunks[g, :group_size], q_norm)
+        k_ref[0, seq_len - 1, g] = norm_rope(chunks[g, group_size], k_norm)
+        v_ref[0, seq_len - 1, g] = chunks[g, group_size + 1]
+        k = k_ref[0, :seq_len, g].bfloat16().float()
+        v = v_ref[0, :seq_len, g].bfloat16().float()
+        p = torch.softmax(q @ k.t() / head_dim**0.5, dim=-1)
+        expected.append((p @ v).reshape(-1))
+    expected = torch.cat(expected).unsqueeze(0)
+    assert torch.allclose(y.float(), expected, rtol=2e-2, atol=2e-2)
+    # The new key and value are written back to the cache
+    assert torch.allclose(
+        k_cache[0, seq_len - 1].float(), k_ref[0, seq_len - 1], rtol=2e-2, atol=2e-2
+    )
+    assert torch.equal(v_cache[0, seq_len - 1].float(), v_ref[0, seq_len - 1])
+
+
+@pytest.mark.skipif("MIRAGE_HOME" not in os.environ, reason="MIRAGE_HOME unset")
+def test_cpu_backend_silu_mul_linear():
+    intermediate_size, hidden_size = 128, 64
+    step = torch.tensor([0], dtype=torch.int32)
+    tokens = torch.zeros(4, dtype=torch.long)
+    mpk = new_cpu_persistent_kernel(step, tokens)
+    # Each input row holds [gate | up]
+    x = torch.randn(1, 2 * intermediate_size, dtype=torch.bfloat16)
+    w = torch.randn(hidden_size, intermediate_size, dtype=torch.bfloat16) * 0.05
+    r = torch.randn(1, hidden_size, dtype=torch.bfloat16)
+    y = torch.zeros(1, hidden_size, dtype=torch.bfloat16)
+    mpk.silu_mul_linear_with_residual_layer(
+        input=mpk.attach_input(torch_tensor=x, name="x"),
+        weight=mpk.attach_input(torch_tensor=w, name="w"),
+        residual=mpk.attach_input(torch_tensor=r, name="r"),
+        output=mpk.attach_input(torch_tensor=y, name="y"),
+        grid_dim=(1, 1, 1),
+        block_dim=(128, 1, 1),
+    )
+    mpk.compile()
+    mpk()
+    gate, up = x.float().chunk(2, dim=-1)
+    expected = torch.matmul(nn.functional.silu(gate) * up, w.float().t()) + r.float()
+    assert torch.allclose(y.float(), expected, rtol=2e-2, atol=2e-2)
+
+
+@pytest.mark.skipif("MIRAGE_HOME" not in os.environ, reason="MIRAGE_HOME unset")
+def test_cpu_backend_argmax():
+    vocab_size, num_parts = 1024, 8
+    step = torch.tensor([0], dtype=torch.int32)
+    tokens = torch.zeros(4, dtype=torch.long)
+    mpk = new_cpu_persistent_kernel(step, tokens)
+    x = torch.randn(1, vocab_size, dtype=torch.bfloat16)
+    x[0, 777] = 100.0
+    part_value = torch.zeros(1, num_parts, dtype=torch.bfloat16)
+    part_index = torch.zeros(1, num_parts, dtype=torch.long)
+    y = torch.zeros(1, 1, dtype=torch.long)
+    part_value_t = mpk.attach_input(torch_tensor=part_value, name="part_value")
+    part_index_t = mpk.attach_input(torch_tensor=part_index, name="part_index")
+    mpk.argmax_partial_layer(
+        input=mpk.attach_input(torch_tensor=x, name="x"),
+        output=(part_value_t, part_index_t),
+        grid_dim=(num_parts, 1, 1),
+        block_dim=(128, 1, 1),
+    )
+    mpk.argmax_reduce_layer(
+        input=(part_value_t, part_index_t),
+        output=mpk.attach_input(torch_tensor=y, name="y"),
+        grid_dim=(1, 1, 1),
+        block_dim=(128, 1, 1),
+    )
+    mpk.compile()
+    mpk()
+    chunks = x.float().view(num_parts, -1)
+    assert torch.equal(part_value[0].float(), chunks.max(dim=-1).values)
+    # Ties within a chunk may resolve to either index
+    assert torch.equal(
+        chunks.gather(1, part_index[0].unsqueeze(1)).squeeze(1),
+        chunks.max(dim=-1).values,
+    )
+    assert y.item() == torch.argmax(x.float()).item() == 777
+    # The next token is written to tokens[step + 1]
+    assert tokens[1].item() == 777
+
+
+def test_task_graph_verbose(capfd):
+    mpk = mi.PersistentKernel(
+        world_size=1,
+        mpi_rank=0,
+        num_workers=4,
+        num_local_schedulers=2,
+        num_remote_schedulers=0,
+        max_seq_length=4,
+        eos_token_id=-1,
+        meta_tensors=[],
+        profiler_tensor=None,
+    )
+    x = mpk.attach_input(torch_tensor=torch.zeros(1, 256).bfloat16(), name="x")
+    w = mpk.attach_input(torch_tensor=torch.zeros(128, 256).bfloat16(), name="w")
+    r = mpk.attach_input(torch_tensor=torch.zeros(1, 128).bfloat16(), name="r")
+    y = mpk.attach_input(torch_tensor=torch.zeros(1, 128).bfloat16(), name="y")
+    mpk.linear_with_residual_layer(
+        input=x,
+        weight=w,
+        residual=r,
+        output=y,
+        grid_dim=(2, 1, 1),
+        block_dim=(128, 1, 1),
+    )
+    capfd.readouterr()
+    mpk.kn_graph.generate_task_graph(num_gpus=1, my_gpu_id=0)
+    assert "Task dispatch code" not in capfd.readouterr().out
+    mpk.kn_graph.generate_task_graph(num_gpus=1, my_gpu_id=0, verbose=True)
+    out = capfd.readouterr().out
+    assert "Task dispatch code" in out and "TASK_LINEAR_WITH_RESIDUAL" in out
+
+
+def test_task_graph_independent_ops():
+    mpk = mi.PersistentKernel(
+        world_size=1,
+        mpi_rank=0,
+        num_workers=8,
+        num_local_schedulers=2,
+        num_remote_schedulers=0,
+        max_seq_length=4,
+        eos_token_id=-1,
+        meta_tensors=[],
+        profiler_tensor=None,
+    )
+
+    def tensor(shape, name):
+        return mpk.attach_input(
+            torch_tensor=torch.zeros(shape, dtype=torch.bfloat16), name=name
+        )
+
+    x = tensor((1, 256), "x")
+    r = tensor((1, 128), "r")
+    y1 = tensor((1, 128), "y1")
+    y2 = tensor((1, 128), "y2")
+    z = tensor((1, 128), "z")
+    # y1 and y2 only read x and r, and z depends on both of them
+    for w, y in [(tensor((128, 256), "w1"), y1), (tensor((128, 256), "w2"), y2)]:
+        mpk.linear_with_residual_layer(
+            input=x,
+            weight=w,
+            residual=r,
+            output=y,
+            grid_dim=(2, 1, 1),
+            block_dim=(128, 1, 1),
+        )
+    mpk.linear_with_residual_layer(
+        input=y1,
+        weight=tensor((128, 128), "w3"),
+        residual=y2,
+        output=z,
+        grid_dim=(2, 1, 1),
+        block_dim=(128, 1, 1),
+    )
+    results = mpk.kn_graph.generate_task_graph(num_gpus=1, my_gpu_id=0)
+    task_graph = json.loads(results["json_file"])
+    # Both producers start at the begining of the task graph
+    assert len(task_graph["first_tasks"]) == 4
+    # The two tasks of an op share tensor descriptors and only differ in
+    # their offsets
+    tasks = task_graph["all_tasks"]
+    assert [t["desc"] for t in tasks[2]["inputs"]] == [
+        t["desc"] for t in tasks[3]["inputs"]
+    ]
+    assert tasks[2]["inputs"][1]["offset"] != tasks[3]["inputs"][1]["offset"]
+    # The producers only read attached tensors that no op writes
+    assert [t["weight_only"] for t in tasks[2:]] == [True] * 4 + [False] * 2
+    assert mi.verify_task_graph(results["json_file"], num_workers=8)["ok"]
+    # The binary task graph round-trips to the same JSON
+    assert json.loads(mi.task_graph_binary_to_json(results["binary_file"])) == task_graph
+    assert mi.task_graph_json_to_binary(results["json_file"]) == results["binary_file"]
+    # The binary task graph stores the two tasks of each producer as a
+    # single task range (num_tasks of the header counts task ranges)
+    (num_task_ranges,) = struct.unpack_from("<I", results["binary_file"], 28)
+    assert num_task_ranges < len(tasks) - 2
+    result = mi.simulate_task_graph(
+        results["json_file"],
+        num_workers=8,
+        num_local_schedulers=2,
+        default_task_latency_us=10.0,
+    )
+    assert result["completed"]
+    assert result["num_executed_tasks"] == 7
+    # One of the producers and the consumer
+    assert result["critical_path_busy_us"] <= 2 * 10.0 + 1e-3
+
+
+def new_host_kernel_graph():
+    # Host-only graphs do not compute fingerprints on the GPU
+    return mi.KNGraph(mi.CyKNGraph(disable_fingerprint=True))
+
+
+def test_interpreter_customized_op():
+    graph = new_host_kernel_graph()
+    X = graph.new_input(dims=(16, 64), dtype=mi.float16)
+    W = graph.new_input(dims=(64, 32), dtype=mi.float16)
+    tb_graph = mi.new_threadblock_graph((2, 1, 1), (128, 1, 1), 4, 16)
+    tX = tb_graph.new_input(dtensor=X, input_map=(-1, -1, -1), forloop_dim=1)
+    tW = tb_graph.new_input(dtensor=W, input_map=(1, -1, -1), forloop_dim=0)
+    tA = tb_graph.forloop_accum(tb_graph.matmul(tX, tW))
+    tR = tb_graph.reduction(tA, 1)
+    tb_graph.new_output(stensor=tA, output_map=(1, -1, -1))
+    tb_graph.new_output(stensor=tR, output_map=(1, -1, -1))
+    O = graph.customized([X, W], tb_graph)
+    S = graph.reduction(O[0], 1)
+    graph.mark_output(O[0])
+    graph.mark_output(O[1])
+    graph.mark_output(S)
+
+    x = torch.rand((16, 64), dtype=torch.float16) * 0.5
+    w = torch.rand((64, 32), dtype=torch.float16) * 0.5
+    o, r, s = graph.interpret([x, w])
+    ref = x.float() @ w.float()
+    assert o.dtype == torch.float16 and o.shape == (16, 32)
+    assert torch.allclose(o.float(), ref, rtol=2e-2, atol=1e-1)
+    # The threadblock reduction sums the 16 columns of each block's tile
+    assert r.shape == (16, 2)
+    assert torch.allclose(
+        r.float(), ref.reshape(16, 2, 16).sum(dim=2), rtol=2e-2, atol=5e-1
+    )
+    assert s.shape == (16, 1)
+    assert torch.allclose(
+        s.float(), ref.sum(dim=1, keepdim=True), rtol=2e-2, atol=5e-1
+    )
+
+
+@pytest.mark.parametrize("dtype", [torch.float16, torch.bfloat16])
+def test_interpreter_rounding(dtype):
+    graph = new_host_kernel_graph()
+    A = graph.new_input(dims=(8, 64), dtype=mi.convert_torch_type_to_dtype(dtype))
+    B = graph.new_input(dims=(8, 64), dtype=mi.convert_torch_type_to_dtype(dtype))
+    graph.mark_output(graph.mul(graph.exp(A), B))
+
+    a = torch.randn((8, 64), dtype=dtype)
+    b = torch.randn((8, 64), dtype=dtype)
+    (out,) = graph.interpret([a, b])
+    # Every operator rounds its result to the tensor's data type
+    ref = (torch.exp(a.float()).to(dtype).float() * b.float()).to(dtype)
+    assert out.dtype == dtype
+    # At most one unit in the last place apart
+    eps = torch.finfo(dtype).eps
+    assert torch.allclose(out.float(), ref.float(), rtol=eps, atol=0)
+
+
+def test_search_stream_checkpoint(tmp_path):
+    # The muGraphs of an existing checkpoint are streamed without searching
+    saved = os.path.join(
+        os.path.dirname(__file__), "../../benchmark/saved_mugraphs/lora.json"
+    )
+    with open(saved) as f:
+        num_saved = len(json.load(f))
+    checkpoint = tmp_path / "checkpoint.json"
+    checkpoint.write_text(open(saved).read())
+    graph = mi.new_kernel_graph()
+    X = graph.new_input(dims=(16, 256), dtype=mi.float16)
+    graph.mark_output(graph.exp(X))
+
+    stream = mi.core.search(
+        graph.cygraph,
+        previous_checkpoint=str(checkpoint),
+        verbose=False,
+        stream=True,
+    )
+    assert iter(stream) is stream
+    first = next(stream)
+    assert isinstance(first, mi.core.CyKNGraph)
+    # Stopping keeps the muGraphs that were already found
+    stream.stop()
+    assert len(list(stream)) == num_saved - 1
+    # An exhausted stream stays empty, and stopping, pausing or closing it
+    # again does nothing
+    stream.stop()
+    stream.pause()
+    stream.resume()
+    stream.close()
+    assert list(stream) == []
+    assert len(json.loads(checkpoint.read_text())) == num_saved
+
+
+def test_search_stream_close(tmp_path):
+    saved = os.path.join(
+        os.path.dirname(__file__), "../../benchmark/saved_mugraphs/lora.json"
+    )
+    checkpoint = tmp_path / "checkpoint.json"
+    checkpoint.write_text(open(saved).read())
+    graph = mi.new_kernel_graph()
+    X = graph.new_input(dims=(16, 256), dtype=mi.float16)
+    graph.mark_output(graph.exp(X))
+
+    stream = mi.core.search(
+        graph.cygraph,
+        previous_checkpoint=str(checkpoint),
+        verbose=False,
+        stream=True,
+    )
+    next(stream)
+    # Closing drops the muGraphs that were not retrieved
+    stream.close()
+    with pytest.raises(StopIteration):
+        next(stream)
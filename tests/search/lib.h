@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mirage/kernel/graph.h"
+#include "mirage/search/search.h"
+
+#include "../check.h"
+
+using namespace mirage;
+namespace kn = mirage::kernel;
+
+// O = X @ W
+inline void build_matmul_graph(kn::Graph &graph) {
+  kn::DTensor X =
+      graph.new_input({8, 64}, {64, 1}, type::DT_FLOAT16, layout::DmemRowMajor);
+  kn::DTensor W = graph.new_input(
+      {64, 64}, {64, 1}, type::DT_FLOAT16, layout::DmemRowMajor);
+  graph.mark_output(graph.matmul(X, W));
+}
+
+// A search space small enough to finish in seconds
+inline search::GeneratorConfig get_small_config() {
+  search::GeneratorConfig config =
+      search::GeneratorConfig::get_default_config();
+  config.max_num_kernel_graph_op = 3;
+  config.search_thread = 2;
+  config.knop_to_explore = {type::KN_MATMUL_OP, type::KN_CUSTOMIZED_OP};
+  config.tbop_to_explore = {type::TB_MATMUL_OP,
+                            type::TB_FORLOOP_ACCUM_NO_RED_OP};
+  config.grid_dim_to_explore = {{1, 1, 1}, {2, 1, 1}, {4, 1, 1}};
+  config.block_dim_to_explore = {{128, 1, 1}};
+  config.frange_to_explore = {1, 4};
+  return config;
+}
+
+// Tensor guids come from a per-process counter, so they differ between
+// searches finding the same muGraph; renumber them in order of appearance
+inline void renumber_guids(json &j, std::unordered_map<size_t, size_t> &guids) {
+  if (j.is_object()) {
+    for (auto &item : j.items()) {
+      if (item.key() == "guid") {
+        item.value() = guids.emplace(item.value().get<size_t>(), guids.size())
+                           .first->second;
+      } else {
+        renumber_guids(item.value(), guids);
+      }
+    }
+  } else if (j.is_array()) {
+    for (json &element : j) {
+      renumber_guids(element, guids);
+    }
+  }
+}
+
+// muGraphs are found in an order that depends on thread scheduling, so
+// they are compared as a sorted list of dumps
+inline std::vector<std::string>
+    get_canonical_dumps(std::vector<json> const &graphs) {
+  std::vector<std::string> dumps;
+  for (json graph : graphs) {
+    std::unordered_map<size_t, size_t> guids;
+    renumber_guids(graph, guids);
+    dumps.push_back(graph.dump());
+  }
+  std::sort(dumps.begin(), dumps.end());
+  return dumps;
+}
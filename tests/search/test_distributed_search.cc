@@ -0,0 +1,183 @@
+// Tests for the distributed search: a search through a spool with two worker
+// processes finds the same muGraphs as a single-process search, a unit of a
+// killed worker is re-queued after the heartbeat timeout, and a unit that
+// waited in pending/ for longer than the timeout is searched only once
+
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "lib.h"
+
+namespace fs = std::filesystem;
+
+int const heartbeat_timeout_sec = 2;
+
+// CUDA must not be initialized before forking, so every process builds its
+// own graph and generator
+void run_coordinator(fs::path const &spool, fs::path const &checkpoint) {
+  kn::Graph graph;
+  build_matmul_graph(graph);
+  search::KernelGraphGenerator gen(
+      graph, get_small_config(), checkpoint.c_str());
+  gen.generate_kernel_graphs_distributed(
+      spool.c_str(), 1 /*split_depth*/, heartbeat_timeout_sec);
+}
+
+template <typename Func>
+pid_t spawn(Func const &func) {
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  CHECK(pid >= 0);
+  if (pid == 0) {
+    func();
+    exit(0);
+  }
+  return pid;
+}
+
+bool exited_cleanly(pid_t pid) {
+  int status;
+  CHECK(waitpid(pid, &status, 0) == pid);
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+std::vector<std::string> load_canonical_dumps(fs::path const &checkpoint) {
+  std::ifstream ifs(checkpoint);
+  CHECK(ifs);
+  json graphs;
+  ifs >> graphs;
+  return get_canonical_dumps(graphs.get<std::vector<json>>());
+}
+
+// Returns the unit claimed by pid in spool/running, or "" if there is none
+std::string find_running_unit(fs::path const &spool, pid_t pid) {
+  std::string suffix = "-" + std::to_string(pid) + ".json";
+  std::error_code ec;
+  for (auto const &entry : fs::directory_iterator(spool / "running", ec)) {
+    std::string filename = entry.path().filename().string();
+    if (filename.size() > suffix.size() &&
+        filename.compare(
+            filename.size() - suffix.size(), suffix.size(), suffix) == 0) {
+      return filename.substr(0, filename.find('.'));
+    }
+  }
+  return "";
+}
+
+int main() {
+  fs::path root =
+      fs::temp_directory_path() /
+      ("mirage_test_distributed_search_" + std::to_string(getpid()));
+  fs::remove_all(root);
+  fs::create_directories(root);
+
+  // Two workers
+  std::vector<std::string> distributed;
+  {
+    fs::path spool = root / "spool";
+    fs::path checkpoint = root / "distributed.json";
+    pid_t coordinator = spawn([&] { run_coordinator(spool, checkpoint); });
+    pid_t worker1 = spawn([&] { search::run_search_worker(spool.c_str()); });
+    pid_t worker2 = spawn([&] { search::run_search_worker(spool.c_str()); });
+    CHECK(exited_cleanly(coordinator));
+    CHECK(exited_cleanly(worker1));
+    CHECK(exited_cleanly(worker2));
+    distributed = load_canonical_dumps(checkpoint);
+  }
+
+  // One worker is killed mid-unit before a second one joins, so that only
+  // a re-queue lets the search finish
+  std::vector<std::string> requeued;
+  {
+    fs::path spool = root / "spool_killed";
+    fs::path checkpoint = root / "killed.json";
+    pid_t coordinator = spawn([&] { run_coordinator(spool, checkpoint); });
+    pid_t worker1 = spawn([&] { search::run_search_worker(spool.c_str()); });
+    std::string unit;
+    while ((unit = find_running_unit(spool, worker1)).empty()) {
+      // The worker must not get through the whole search unnoticed
+      CHECK(!fs::exists(spool / "finished"));
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // The claim is checked again once the worker is stopped, since it may
+    // have finished the unit in the meantime
+    CHECK(kill(worker1, SIGSTOP) == 0);
+    unit = find_running_unit(spool, worker1);
+    CHECK(!unit.empty());
+    auto killed_at = std::chrono::steady_clock::now();
+    CHECK(kill(worker1, SIGKILL) == 0);
+    CHECK(!exited_cleanly(worker1));
+
+    fs::path pending = spool / "pending" / (unit + ".json");
+    while (!fs::exists(pending)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    // The last heartbeat may be up to a second older than the kill
+    double waited_sec = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - killed_at)
+                            .count();
+    CHECK(waited_sec >= heartbeat_timeout_sec - 1);
+
+    pid_t worker2 = spawn([&] { search::run_search_worker(spool.c_str()); });
+    CHECK(exited_cleanly(coordinator));
+    CHECK(exited_cleanly(worker2));
+    requeued = load_canonical_dumps(checkpoint);
+  }
+
+  // Units wait in pending/ for longer than the heartbeat timeout before a
+  // worker joins, and none of them is re-queued after being claimed
+  std::vector<std::string> delayed;
+  {
+    fs::path spool = root / "spool_delayed";
+    fs::path checkpoint = root / "delayed.json";
+    fs::path num_units_path = root / "delayed_num_units";
+    pid_t coordinator = spawn([&] { run_coordinator(spool, checkpoint); });
+    // Units are pending before job.json is written
+    while (!fs::exists(spool / "job.json")) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    size_t num_units = std::distance(fs::directory_iterator(spool / "pending"),
+                                     fs::directory_iterator());
+    CHECK(num_units > 0);
+    std::this_thread::sleep_for(
+        std::chrono::seconds(heartbeat_timeout_sec + 1));
+    pid_t worker = spawn([&] {
+      std::ofstream(num_units_path) << search::run_search_worker(spool.c_str());
+    });
+    CHECK(exited_cleanly(coordinator));
+    CHECK(exited_cleanly(worker));
+    size_t num_searched = 0;
+    std::ifstream(num_units_path) >> num_searched;
+    CHECK(num_searched == num_units);
+    delayed = load_canonical_dumps(checkpoint);
+  }
+
+  // Single process, after all children are gone
+  std::vector<std::string> single;
+  {
+    kn::Graph graph;
+    build_matmul_graph(graph);
+    fs::path checkpoint = root / "single.json";
+    search::KernelGraphGenerator gen(
+        graph, get_small_config(), checkpoint.c_str());
+    gen.generate_kernel_graphs();
+    single = get_canonical_dumps(gen.generated_graphs);
+  }
+
+  CHECK(!single.empty());
+  CHECK(distributed == single);
+  CHECK(requeued == single);
+  CHECK(delayed == single);
+  fs::remove_all(root);
+
+  printf("All distributed search tests passed\n");
+  return 0;
+}
@@ -0,0 +1,92 @@
+// Tests for matching the outputs of a muGraph to the reference outputs
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "lib.h"
+#include "mirage/search/verification/output_match.h"
+
+using search::OutputMatch;
+
+// Accepts the pairs in `accepted` and counts the evaluations of every pair
+class PairOracle {
+public:
+  PairOracle(std::vector<std::pair<int, int>> const &accepted) {
+    for (auto const &pair : accepted) {
+      matches[pair] = true;
+    }
+  }
+
+  bool operator()(int i, int j) {
+    std::pair<int, int> pair(i, j);
+    CHECK(++num_calls[pair] == 1);
+    return matches.count(pair) > 0;
+  }
+
+  int total_calls() const {
+    int total = 0;
+    for (auto const &entry : num_calls) {
+      total += entry.second;
+    }
+    return total;
+  }
+
+private:
+  std::map<std::pair<int, int>, bool> matches;
+  std::map<std::pair<int, int>, int> num_calls;
+};
+
+OutputMatch find_match(std::vector<std::vector<int>> const &candidates,
+                       PairOracle &oracle) {
+  return OutputMatch::find_match(candidates,
+                                 [&](int i, int j) { return oracle(i, j); });
+}
+
+int main() {
+  {
+    // Greedily assigning graph output 0 to reference output 0 leaves
+    // nothing for reference output 1; the augmenting path moves it to 1
+    PairOracle oracle({{0, 0}, {0, 1}, {1, 0}});
+    OutputMatch match = find_match({{0, 1}, {0}}, oracle);
+    CHECK(match.is_valid());
+    CHECK(match.size() == 2);
+    CHECK(match[0] == 1);
+    CHECK(match[1] == 0);
+  }
+  {
+    // A chain of three reassignments, where every candidate pair is tried
+    // again by the augmenting paths but evaluated only once
+    PairOracle oracle({{0, 0}, {0, 1}, {1, 0}, {1, 2}, {2, 0}});
+    OutputMatch match = find_match({{0, 1}, {0, 2}, {0}}, oracle);
+    CHECK(match.is_valid());
+    CHECK(match[0] == 1);
+    CHECK(match[1] == 2);
+    CHECK(match[2] == 0);
+    CHECK(oracle.total_calls() == 5);
+  }
+  {
+    // Pairs that fail is_match are not used even if they are candidates
+    PairOracle oracle({{0, 0}, {1, 0}});
+    OutputMatch match = find_match({{0, 1}, {0, 1}}, oracle);
+    CHECK(!match.is_valid());
+    CHECK(oracle.total_calls() <= 4);
+  }
+  {
+    // Two reference outputs competing for one graph output
+    PairOracle oracle({{0, 0}, {1, 0}, {2, 1}, {2, 2}});
+    OutputMatch match = find_match({{0}, {0}, {1, 2}}, oracle);
+    CHECK(!match.is_valid());
+  }
+  {
+    // A single output and the empty graph
+    PairOracle oracle({{0, 0}});
+    CHECK(find_match({{0}}, oracle)[0] == 0);
+    PairOracle empty_oracle(std::vector<std::pair<int, int>>{});
+    CHECK(find_match({}, empty_oracle).is_valid());
+    CHECK(empty_oracle.total_calls() == 0);
+  }
+
+  printf("All output match tests passed\n");
+  return 0;
+}
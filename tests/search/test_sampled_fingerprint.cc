@@ -0,0 +1,85 @@
+// Regression test for the host-side sampled fingerprints: the muGraphs saved
+// for each benchmark are equivalent, so the sampled fingerprints of their
+// outputs must agree with those of the first muGraph, as
+// ProbabilisticVerifier::may_match expects. Runs without a GPU
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "lib.h"
+#include "mirage/search/verification/sampled_fingerprint.h"
+
+namespace fs = std::filesystem;
+
+// Same budget as ProbabilisticVerifier
+size_t const MAX_NUM_SAMPLED_EVALUATIONS = 1 << 16;
+int const NUM_SAMPLED_ELEMENTS = 16;
+
+kn::DTensor get_output(kn::Graph const &graph) {
+  for (kn::KNOperator const *op : graph.operators) {
+    if (op->op_type == type::KN_OUTPUT_OP) {
+      return op->input_tensors[0];
+    }
+  }
+  CHECK(false);
+  return kn::DTensor();
+}
+
+int main() {
+  int num_compared = 0;
+  for (auto const &entry : fs::directory_iterator(MIRAGE_SAVED_MUGRAPHS_DIR)) {
+    std::ifstream ifs(entry.path());
+    json j;
+    ifs >> j;
+    std::vector<std::unique_ptr<kn::Graph>> graphs;
+    for (json const &jgraph : j) {
+      graphs.push_back(std::make_unique<kn::Graph>(
+          dim3{1, 1, 1}, true /*disable_fingerprint*/));
+      from_json(jgraph, *graphs.back());
+    }
+    CHECK(!graphs.empty());
+
+    kn::DTensor ref = get_output(*graphs[0]);
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<size_t> dist(0, ref.num_elements() - 1);
+    std::vector<size_t> sampled_idx;
+    std::vector<std::optional<type::FPType>> ref_fps;
+    search::SampledFingerprinter ref_fingerprinter(MAX_NUM_SAMPLED_EVALUATIONS);
+    for (int i = 0; i < NUM_SAMPLED_ELEMENTS; i++) {
+      sampled_idx.push_back(dist(gen));
+      ref_fps.push_back(
+          ref_fingerprinter.get_fingerprint(ref, sampled_idx.back()));
+    }
+
+    for (size_t k = 1; k < graphs.size(); k++) {
+      kn::DTensor output = get_output(*graphs[k]);
+      CHECK(output.num_elements() == ref.num_elements());
+      search::SampledFingerprinter fingerprinter(MAX_NUM_SAMPLED_EVALUATIONS);
+      for (int i = 0; i < NUM_SAMPLED_ELEMENTS; i++) {
+        std::optional<type::FPType> fp =
+            fingerprinter.get_fingerprint(output, sampled_idx[i]);
+        if (fp && ref_fps[i]) {
+          if (*fp != *ref_fps[i]) {
+            fprintf(stderr,
+                    "%s: muGraph %zu differs from muGraph 0 at element %zu\n",
+                    entry.path().filename().c_str(),
+                    k,
+                    sampled_idx[i]);
+          }
+          CHECK(*fp == *ref_fps[i]);
+          num_compared++;
+        }
+      }
+    }
+  }
+  // The saved muGraphs must exercise the host fingerprinting at all
+  CHECK(num_compared > 0);
+
+  printf("All sampled fingerprint tests passed (%d elements compared)\n",
+         num_compared);
+  return 0;
+}
@@ -0,0 +1,63 @@
+// Knuth's estimate of the size of the search tree against the number of
+// states a complete search visits
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+#include "lib.h"
+
+// The memo replays threadblock graphs without visiting their states, while
+// the estimate visits all of them
+search::GeneratorConfig get_config() {
+  search::GeneratorConfig config = get_small_config();
+  config.enable_tb_graph_memo = false;
+  return config;
+}
+
+int main() {
+  kn::Graph graph;
+  build_matmul_graph(graph);
+  std::filesystem::path checkpoint =
+      std::filesystem::temp_directory_path() / "mirage_test_estimate.json";
+
+  size_t num_states = 0;
+  {
+    search::KernelGraphGenerator gen(graph, get_config(), checkpoint.c_str());
+    gen.generate_kernel_graphs();
+    for (auto const &[depth, n] : gen.metrics.snapshot().states_per_depth) {
+      num_states += n;
+    }
+  }
+  std::filesystem::remove(checkpoint);
+  CHECK(num_states > 1);
+
+  search::SearchEstimate estimate;
+  {
+    search::KernelGraphGenerator gen(graph, get_config(), checkpoint.c_str());
+    estimate = gen.estimate_search(512 /*num_probes*/, 0 /*seed*/);
+    // A dry run saves nothing
+    CHECK(gen.generated_graphs.empty());
+  }
+  CHECK(!std::filesystem::exists(checkpoint));
+  CHECK(estimate.num_probes == 512);
+  CHECK(estimate.max_probe_depth > 0);
+  CHECK(estimate.num_verifications > 0);
+  CHECK(estimate.num_verifications <= estimate.num_states);
+  printf("Estimated %.1f +- %.1f states, searched %zu\n",
+         estimate.num_states,
+         estimate.num_states_stderr,
+         num_states);
+  // The estimate is unbiased; with a fixed seed it is also deterministic
+  double error = std::fabs(estimate.num_states - num_states);
+  CHECK(error <= std::max(4 * estimate.num_states_stderr, 0.1 * num_states));
+
+  {
+    search::KernelGraphGenerator gen(graph, get_config(), checkpoint.c_str());
+    search::SearchEstimate again = gen.estimate_search(512, 0);
+    CHECK(again.num_states == estimate.num_states);
+  }
+
+  printf("All search estimate tests passed\n");
+  return 0;
+}
@@ -0,0 +1,123 @@
+// Tests for streaming the muGraphs of a running search: the stream returns
+// the muGraphs of the checkpoint, a paused search verifies nothing, and a
+// stopped search writes no checkpoint
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <thread>
+
+#include <unistd.h>
+
+#include "lib.h"
+
+namespace fs = std::filesystem;
+using search::SearchResultQueue;
+
+// Runs gen's search on a background thread that closes the queue when done,
+// as cython_start_search does
+class StreamingSearch {
+public:
+  StreamingSearch(search::KernelGraphGenerator &gen)
+      : queue(std::make_shared<SearchResultQueue>()) {
+    gen.result_queue = queue;
+    thread = std::thread([&gen, queue = queue]() {
+      gen.generate_kernel_graphs();
+      queue->close();
+    });
+  }
+
+  // Pops until the queue is closed
+  std::vector<json> drain() {
+    std::vector<json> graphs;
+    json graph;
+    SearchResultQueue::Status status;
+    while ((status = queue->pop(graph, 100)) !=
+           SearchResultQueue::Status::CLOSED) {
+      if (status == SearchResultQueue::Status::GRAPH) {
+        graphs.push_back(graph);
+      }
+    }
+    thread.join();
+    return graphs;
+  }
+
+  std::shared_ptr<SearchResultQueue> queue;
+  std::thread thread;
+};
+
+int main() {
+  fs::path root = fs::temp_directory_path() /
+                  ("mirage_test_streaming_search_" + std::to_string(getpid()));
+  fs::remove_all(root);
+  fs::create_directories(root);
+  kn::Graph graph;
+  build_matmul_graph(graph);
+
+  // Streamed muGraphs are those saved to the checkpoint
+  std::vector<std::string> complete;
+  {
+    fs::path checkpoint = root / "complete.json";
+    search::KernelGraphGenerator gen(
+        graph, get_small_config(), checkpoint.c_str());
+    StreamingSearch s(gen);
+    complete = get_canonical_dumps(s.drain());
+    CHECK(!complete.empty());
+    CHECK(complete == get_canonical_dumps(gen.generated_graphs));
+    std::ifstream ifs(checkpoint);
+    CHECK(ifs);
+    json saved;
+    ifs >> saved;
+    CHECK(complete == get_canonical_dumps(saved.get<std::vector<json>>()));
+  }
+
+  // Nothing is verified while the search is paused, and resuming it
+  // finds the same muGraphs
+  {
+    fs::path checkpoint = root / "paused.json";
+    search::KernelGraphGenerator gen(
+        graph, get_small_config(), checkpoint.c_str());
+    gen.pause();
+    StreamingSearch s(gen);
+    json first;
+    CHECK(s.queue->pop(first, 1000) == SearchResultQueue::Status::TIMEOUT);
+    CHECK(gen.generated_graphs.empty());
+    gen.resume();
+    CHECK(get_canonical_dumps(s.drain()) == complete);
+    CHECK(fs::exists(checkpoint));
+  }
+
+  // A stopped search writes no checkpoint, so that its partial results are
+  // never loaded as those of a complete search. Pausing first makes sure
+  // that the search cannot finish before it is stopped
+  {
+    fs::path checkpoint = root / "stopped.json";
+    search::KernelGraphGenerator gen(
+        graph, get_small_config(), checkpoint.c_str());
+    gen.pause();
+    StreamingSearch s(gen);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    gen.request_stop();
+    CHECK(s.drain().empty());
+    CHECK(!fs::exists(checkpoint));
+  }
+
+  // muGraphs found before a stop are still streamed
+  {
+    fs::path checkpoint = root / "partial.json";
+    search::KernelGraphGenerator gen(
+        graph, get_small_config(), checkpoint.c_str());
+    StreamingSearch s(gen);
+    json first;
+    CHECK(s.queue->pop(first, 60 * 1000) == SearchResultQueue::Status::GRAPH);
+    gen.request_stop();
+    std::vector<json> rest = s.drain();
+    CHECK(rest.size() + 1 == gen.generated_graphs.size());
+    CHECK(rest.size() + 1 <= complete.size());
+  }
+
+  fs::remove_all(root);
+  printf("All streaming search tests passed\n");
+  return 0;
+}
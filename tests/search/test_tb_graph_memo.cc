@@ -0,0 +1,58 @@
+// The threadblock graph memo must not change the muGraphs a search finds
+
+#include <filesystem>
+
+#include "lib.h"
+
+// O = exp(X @ W), where the same threadblock-level search over X and W is
+// started both before and after a kernel-level operator, so that the memo
+// is hit
+void build_graph(kn::Graph &graph) {
+  kn::DTensor X =
+      graph.new_input({8, 64}, {64, 1}, type::DT_FLOAT16, layout::DmemRowMajor);
+  kn::DTensor W = graph.new_input(
+      {64, 64}, {64, 1}, type::DT_FLOAT16, layout::DmemRowMajor);
+  graph.mark_output(graph.exp(graph.matmul(X, W)));
+}
+
+search::GeneratorConfig get_config(bool enable_tb_graph_memo) {
+  search::GeneratorConfig config = get_small_config();
+  config.max_num_kernel_graph_op = 4;
+  config.knop_to_explore = {
+      type::KN_MATMUL_OP, type::KN_EXP_OP, type::KN_CUSTOMIZED_OP};
+  config.tbop_to_explore = {
+      type::TB_MATMUL_OP, type::TB_EXP_OP, type::TB_FORLOOP_ACCUM_NO_RED_OP};
+  config.enable_tb_graph_memo = enable_tb_graph_memo;
+  return config;
+}
+
+int main() {
+  kn::Graph graph;
+  build_graph(graph);
+  std::vector<std::string> results[2];
+  for (bool enable_tb_graph_memo : {false, true}) {
+    std::filesystem::path checkpoint =
+        std::filesystem::temp_directory_path() /
+        ("mirage_test_tb_graph_memo_" + std::to_string(enable_tb_graph_memo) +
+         ".json");
+    search::KernelGraphGenerator gen(
+        graph, get_config(enable_tb_graph_memo), checkpoint.c_str());
+    gen.generate_kernel_graphs();
+    std::filesystem::remove(checkpoint);
+    results[enable_tb_graph_memo] = get_canonical_dumps(gen.generated_graphs);
+
+    std::pair<size_t, size_t> hits_misses =
+        gen.metrics.snapshot().cache_hits_misses[static_cast<int>(
+            search::SearchCache::TB_GRAPHS)];
+    if (enable_tb_graph_memo) {
+      CHECK(hits_misses.first > 0);
+    } else {
+      CHECK(hits_misses.first == 0 && hits_misses.second == 0);
+    }
+  }
+  CHECK(!results[false].empty());
+  CHECK(results[true] == results[false]);
+
+  printf("All threadblock graph memo tests passed\n");
+  return 0;
+}
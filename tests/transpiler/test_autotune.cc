@@ -0,0 +1,143 @@
+// Tests for the autotuner with a stub executor, so that no CUDA code is
+// compiled or run
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "mirage/kernel/graph.h"
+#include "mirage/threadblock/graph.h"
+#include "mirage/transpiler/autotune.h"
+
+#include "../check.h"
+
+using namespace mirage;
+namespace kn = mirage::kernel;
+namespace tb = mirage::threadblock;
+namespace trans = mirage::transpiler;
+
+// Returns a runtime chosen by `get_ms` and counts the calls
+class StubExecutor : public trans::AutotuneExecutor {
+public:
+  StubExecutor(std::function<float(trans::TranspilerConfig const &)> get_ms)
+      : get_ms(get_ms) {}
+
+  float profile(trans::AutotuneCandidate const &candidate) override {
+    num_calls++;
+    return get_ms(candidate.config);
+  }
+
+  int num_calls = 0;
+
+private:
+  std::function<float(trans::TranspilerConfig const &)> get_ms;
+};
+
+// O = X @ W on Hopper, launched with 3 warp groups so that every pipeline
+// depth gives a separate candidate
+void build_graph(kn::Graph &graph) {
+  kn::DTensor X = graph.new_input(
+      {64, 1024}, {1024, 1}, type::DT_FLOAT16, layout::DmemRowMajor);
+  kn::DTensor W = graph.new_input(
+      {1024, 1024}, {1024, 1}, type::DT_FLOAT16, layout::DmemRowMajor);
+  tb::Graph bgraph({16, 1, 1}, {384, 1, 1}, 16, 64);
+  tb::STensor bX = bgraph.new_input(X, {-1, -1, -1}, 1, layout::SmemRowMajor);
+  tb::STensor bW = bgraph.new_input(W, {1, -1, -1}, 0, layout::SmemRowMajor);
+  tb::STensor bO = bgraph.forloop_accum(bgraph.matmul(bX, bW),
+                                        type::TB_FORLOOP_ACCUM_NO_RED_OP);
+  bgraph.mark_output(bO, {1, -1, -1}, -1, type::TB_EPILOGUE_NONE);
+  std::vector<kn::DTensor> outputs = graph.customized({X, W}, bgraph);
+  graph.mark_output(outputs[0], {1024, 1});
+}
+
+bool same_knobs(trans::TranspilerConfig const &a,
+                trans::TranspilerConfig const &b) {
+  return a.num_consumer_wgs == b.num_consumer_wgs &&
+         a.num_producer_wgs == b.num_producer_wgs &&
+         a.pipeline_stages == b.pipeline_stages &&
+         a.enable_online_softmax == b.enable_online_softmax;
+}
+
+int main() {
+  kn::Graph graph({1, 1, 1}, true /*disable_fingerprint*/);
+  build_graph(graph);
+  std::vector<std::vector<size_t>> strides = {{1024, 1}, {1024, 1}};
+  trans::TranspilerConfig base_config{};
+  base_config.target_cc = 90;
+  base_config.num_consumer_wgs = 1;
+  base_config.num_producer_wgs = 1;
+  base_config.pipeline_stages = 2;
+
+  std::vector<trans::AutotuneCandidate> candidates =
+      trans::Autotuner::get_candidates(&graph, base_config, strides);
+  CHECK(candidates.size() >= 2);
+  int num_candidates = candidates.size();
+  // The executor prefers the candidate the cost model ranks last
+  trans::TranspilerConfig slowest_predicted = candidates.back().config;
+  auto prefer_slowest_predicted = [&](trans::TranspilerConfig const &config) {
+    return same_knobs(config, slowest_predicted) ? 1.0f : 2.0f;
+  };
+
+  std::filesystem::path table_path =
+      std::filesystem::temp_directory_path() / "mirage_test_autotune.json";
+  std::filesystem::remove(table_path);
+  {
+    trans::Autotuner tuner(table_path.string());
+    StubExecutor executor(prefer_slowest_predicted);
+    trans::TranspilerConfig best =
+        tuner.tune(&graph, base_config, strides, &executor, num_candidates);
+    CHECK(executor.num_calls == num_candidates);
+    CHECK(same_knobs(best, slowest_predicted));
+
+    // The predicted cost and the measured runtime are recorded separately
+    trans::AutotuneRecord record;
+    CHECK(tuner.lookup(trans::AutotuneKey(graph.get_owner_independent_hash(),
+                                          base_config.target_cc,
+                                          strides),
+                       record));
+    CHECK(record.measured_ms == 1.0f);
+    CHECK(record.predicted_cost == candidates.back().predicted_cost);
+
+    // A cached record is returned without profiling
+    tuner.tune(&graph, base_config, strides, &executor, num_candidates);
+    CHECK(executor.num_calls == num_candidates);
+
+    // Different input strides are tuned separately
+    std::vector<std::vector<size_t>> other_strides = {{1024, 1}, {1, 1024}};
+    tuner.tune(&graph, base_config, other_strides, &executor, 1);
+    CHECK(executor.num_calls == num_candidates + 1);
+  }
+  {
+    // The table is reloaded from disk
+    trans::Autotuner tuner(table_path.string());
+    StubExecutor executor(prefer_slowest_predicted);
+    trans::TranspilerConfig best =
+        tuner.tune(&graph, base_config, strides, &executor, num_candidates);
+    CHECK(executor.num_calls == 0);
+    CHECK(same_knobs(best, slowest_predicted));
+  }
+  std::filesystem::remove(table_path);
+  {
+    // When every candidate fails to run, the cost model's pick is kept
+    trans::Autotuner tuner;
+    StubExecutor executor(
+        [](trans::TranspilerConfig const &) { return -1.0f; });
+    trans::TranspilerConfig best =
+        tuner.tune(&graph, base_config, strides, &executor, num_candidates);
+    CHECK(same_knobs(best, candidates.front().config));
+    trans::AutotuneRecord record;
+    CHECK(tuner.lookup(trans::AutotuneKey(graph.get_owner_independent_hash(),
+                                          base_config.target_cc,
+                                          strides),
+                       record));
+    CHECK(record.measured_ms < 0);
+    CHECK(record.predicted_cost == candidates.front().predicted_cost);
+  }
+
+  // Unknown architectures fall back instead of aborting
+  CHECK(trans::get_shared_memory_capacity(75) == 48 * 1024);
+
+  printf("All autotune tests passed\n");
+  return 0;
+}
@@ -0,0 +1,125 @@
+// Tests for kernel-level fusion: fused graphs compute the same outputs as
+// the original ones on the host interpreter
+
+#include <random>
+#include <vector>
+
+#include "mirage/cpu/interpreter.h"
+#include "mirage/kernel/graph.h"
+#include "mirage/threadblock/graph.h"
+#include "mirage/transpiler/kn_fusion.h"
+
+#include "../check.h"
+
+using namespace mirage;
+namespace kn = mirage::kernel;
+namespace tb = mirage::threadblock;
+namespace trans = mirage::transpiler;
+
+// E = exp(X @ W), where the exp reads exactly the tiles of X @ W, so that
+// it is fused as an epilogue of the matmul's forloop
+void build_epilogue_graph(kn::Graph &graph) {
+  kn::DTensor X = graph.new_input(
+      {8, 1024}, {1024, 1}, type::DT_FLOAT16, layout::DmemRowMajor);
+  kn::DTensor W = graph.new_input(
+      {1024, 1024}, {1024, 1}, type::DT_FLOAT16, layout::DmemRowMajor);
+  tb::Graph pg({16, 1, 1}, {128, 1, 1}, 16, 64);
+  tb::STensor bX = pg.new_input(X, {-1, -1, -1}, 1, layout::SmemRowMajor);
+  tb::STensor bW = pg.new_input(W, {1, -1, -1}, 0, layout::SmemRowMajor);
+  tb::STensor bA =
+      pg.forloop_accum(pg.matmul(bX, bW), type::TB_FORLOOP_ACCUM_NO_RED_OP);
+  pg.mark_output(bA, {1, -1, -1}, -1, type::TB_EPILOGUE_NONE);
+  kn::DTensor A = graph.customized({X, W}, pg)[0];
+  tb::Graph cg({16, 1, 1}, {128, 1, 1}, 1, 64);
+  tb::STensor bO = cg.new_input(A, {1, -1, -1}, -1, layout::SmemRowMajor);
+  tb::STensor bE =
+      cg.forloop_accum(cg.exp(bO), type::TB_FORLOOP_ACCUM_NO_RED_OP);
+  cg.mark_output(bE, {1, -1, -1}, -1, type::TB_EPILOGUE_NONE);
+  graph.mark_output(graph.customized({A}, cg)[0], {1024, 1});
+}
+
+// O = exp(X) + V, where the exp is fused as a prologue of the add
+void build_prologue_graph(kn::Graph &graph) {
+  kn::DTensor X = graph.new_input(
+      {8, 1024}, {1024, 1}, type::DT_FLOAT16, layout::DmemRowMajor);
+  kn::DTensor V = graph.new_input(
+      {8, 1024}, {1024, 1}, type::DT_FLOAT16, layout::DmemRowMajor);
+  tb::Graph pg({16, 1, 1}, {128, 1, 1}, 1, 64);
+  tb::STensor bX = pg.new_input(X, {1, -1, -1}, -1, layout::SmemRowMajor);
+  tb::STensor bY =
+      pg.forloop_accum(pg.exp(bX), type::TB_FORLOOP_ACCUM_NO_RED_OP);
+  pg.mark_output(bY, {1, -1, -1}, -1, type::TB_EPILOGUE_NONE);
+  kn::DTensor Y = graph.customized({X}, pg)[0];
+  tb::Graph cg({16, 1, 1}, {128, 1, 1}, 1, 64);
+  tb::STensor bY2 = cg.new_input(Y, {1, -1, -1}, -1, layout::SmemRowMajor);
+  tb::STensor bV = cg.new_input(V, {1, -1, -1}, -1, layout::SmemRowMajor);
+  tb::STensor bO =
+      cg.forloop_accum(cg.add(bY2, bV), type::TB_FORLOOP_ACCUM_NO_RED_OP);
+  cg.mark_output(bO, {1, -1, -1}, -1, type::TB_EPILOGUE_NONE);
+  graph.mark_output(graph.customized({Y, V}, cg)[0], {1024, 1});
+}
+
+std::vector<cpu::HostTensor> get_random_inputs(kn::Graph const &graph) {
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(0.0f, 0.1f);
+  std::vector<cpu::HostTensor> inputs;
+  for (kn::KNOperator const *op : graph.operators) {
+    if (op->op_type != type::KN_INPUT_OP) {
+      continue;
+    }
+    kn::DTensor const &t = op->output_tensors[0];
+    cpu::HostTensor input(std::vector<int>(t.dim, t.dim + t.num_dims),
+                          t.data_type);
+    for (float &x : input.data) {
+      x = dist(gen);
+    }
+    input.round_to_data_type();
+    inputs.push_back(input);
+  }
+  return inputs;
+}
+
+// Fuses `graph` and checks the fused graph against the original one
+void check_fused_outputs(kn::Graph const &graph,
+                         trans::TranspilerConfig const &config,
+                         char const *expected_report) {
+  trans::KNFusionReport report;
+  kn::Graph const *fused =
+      trans::rewrite_graph_for_kn_fusion(&graph, config, report);
+  CHECK(fused != &graph);
+  CHECK(report.to_string().find(expected_report) != std::string::npos);
+  CHECK(fused->operators.size() + 1 == graph.operators.size());
+
+  std::vector<cpu::HostTensor> inputs = get_random_inputs(graph);
+  cpu::Interpreter interpreter;
+  std::vector<cpu::HostTensor> expected = interpreter.run(graph, inputs);
+  std::vector<cpu::HostTensor> outputs = interpreter.run(*fused, inputs);
+  CHECK(outputs.size() == expected.size());
+  for (size_t i = 0; i < outputs.size(); i++) {
+    CHECK(outputs[i].dims == expected[i].dims);
+    CHECK(cpu::allclose(outputs[i], expected[i]));
+  }
+  delete fused;
+}
+
+int main() {
+  trans::TranspilerConfig config{};
+  config.target_cc = 80;
+  config.num_consumer_wgs = 1;
+  config.num_producer_wgs = 1;
+  config.pipeline_stages = 2;
+
+  {
+    kn::Graph graph({1, 1, 1}, true /*disable_fingerprint*/);
+    build_epilogue_graph(graph);
+    check_fused_outputs(graph, config, "op 2 -> op 3 (epilogue)");
+  }
+  {
+    kn::Graph graph({1, 1, 1}, true /*disable_fingerprint*/);
+    build_prologue_graph(graph);
+    check_fused_outputs(graph, config, "op 2 -> op 3 (prologue)");
+  }
+
+  printf("All kernel-level fusion tests passed\n");
+  return 0;
+}